@@ -12,9 +12,15 @@ bool ThermostatApp::configure(const JsonObject& config, PlcEngine& plcEngine) {
     _setpoint = config["setpoint"] | 20.0f;
     _hysteresis = config["hysteresis"] | 0.5f;
 
-    // Declare PLC variables needed by this app
-    plcEngine.getMemory().declareVariable(_tempSensorVar, PlcValueType::REAL, false);
-    plcEngine.getMemory().declareVariable(_heaterOutputVar, PlcValueType::BOOL, true); // Heater output should be retentive
+    // Check the PLC variables this app uses: once the program is loaded
+    // they must be declared by it (see PlcMemory::declareVariable())
+    PlcMemory& memory = plcEngine.getMemory();
+    if (!memory.declareVariable(_tempSensorVar, PlcValueType::REAL, false) ||
+        !memory.declareVariable(_heaterOutputVar, PlcValueType::BOOL, true)) { // Heater output should be retentive
+        EspHubLog->printf("ERROR: ThermostatApp: The PLC program must declare '%s' (real) and '%s' (bool)\n",
+                          _tempSensorVar.c_str(), _heaterOutputVar.c_str());
+        return false;
+    }
 
     // Here, we would dynamically generate PLC logic blocks for the thermostat
     // For example, using GT and LT blocks to compare temperature with setpoint and hysteresis
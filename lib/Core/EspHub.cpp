@@ -1,6 +1,7 @@
 #include "EspHub.h"
 #include "../Protocols/Mesh/mesh_protocol.h" // New mesh protocol header
 #include <WiFi.h>
+#include <LittleFS.h>
 
 StreamLogger* EspHubLog = nullptr;
 EspHub* EspHub::instance = nullptr;
@@ -193,9 +194,12 @@ void EspHub::loadPlcConfiguration(const char* jsonConfig) {
     // In a real scenario, the program name would come from the web UI or MQTT command.
     String defaultProgramName = "main_program";
     if (plcEngine.loadProgram(defaultProgramName, jsonConfig)) {
-        // If PLC config is valid, load the high-level applications
-        StaticJsonDocument<4096> doc; // Use StaticJsonDocument for consistency
-        DeserializationError error = deserializeJson(doc, jsonConfig);
+        // If PLC config is valid, load the high-level applications. Only the
+        // "applications" key is kept, so large programs do not fill the document
+        JsonDocument filter;
+        filter["applications"] = true;
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, jsonConfig, DeserializationOption::Filter(filter));
         if (!error) {
             appManager.loadApplications(doc.as<JsonObject>());
         } else {
@@ -204,6 +208,63 @@ void EspHub::loadPlcConfiguration(const char* jsonConfig) {
     }
 }
 
+bool EspHub::loadPlcProgramFile(const String& programName, const char* path) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        EspHubLog->printf("ERROR: Failed to open PLC program '%s'\n", path);
+        return false;
+    }
+
+    // Read in chunks, the file is never held in RAM as a whole
+    bool loaded = plcEngine.loadProgramStream(programName, [&file](uint8_t* buffer, size_t size) {
+        return file.read(buffer, size);
+    });
+    file.close();
+    return loaded;
+}
+
+bool EspHub::changePlcProgramFile(const String& programName, const char* path) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        EspHubLog->printf("ERROR: Failed to open PLC program '%s'\n", path);
+        return false;
+    }
+
+    // The running version keeps scanning while the new one is read
+    bool queued = plcEngine.onlineChangeStream(programName, [&file](uint8_t* buffer, size_t size) {
+        return file.read(buffer, size);
+    });
+    file.close();
+    return queued;
+}
+
+bool EspHub::loadPlcImageFile(const String& programName, const char* path) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        EspHubLog->printf("ERROR: Failed to open PLC program image '%s'\n", path);
+        return false;
+    }
+
+    // One read into a buffer that is freed once the program is loaded
+    std::vector<uint8_t> image(file.size());
+    size_t read = file.read(image.data(), image.size());
+    file.close();
+    if (read != image.size()) {
+        EspHubLog->printf("ERROR: Failed to read PLC program image '%s'\n", path);
+        return false;
+    }
+    return plcEngine.loadProgramImage(programName, image.data(), image.size());
+}
+
+bool EspHub::loadPlcImagePartition(const String& programName, const char* label) {
+    // The image is read in place from flash and unmapped again after loading
+    PlcImagePartition partition;
+    if (!partition.map(label)) {
+        return false;
+    }
+    return plcEngine.loadProgramImage(programName, partition.getData(), partition.getSize());
+}
+
 void EspHub::runPlc(const String& programName) {
     plcEngine.runProgram(programName);
 }
@@ -280,7 +341,9 @@ void EspHub::loop() {
     mesh.update();
     appManager.updateAll();
     meshDeviceManager.checkOfflineDevices(60000); // Check for offline devices every minute (60 seconds)
-    plcEngine.evaluateAllPrograms(); // Evaluate all running PLC programs
+    // PLC programs are scanned by the PLC engine task on their own cycle time
+    plcEngine.commitRetentive(); // Retentive values packed by the PLC task -> NVS
+    webManager.loop(); // Periodic WebSocket frames (PLC profile)
     meshExportManager.loop(); // Process mesh variable exports (all nodes)
     ioEventManager.loop(); // Check I/O and scheduled events
 
@@ -329,12 +392,17 @@ void EspHub::receivedCallback(uint32_t from, String &msg) {
                 // Assuming "main_program" is the default program for now
                 PlcProgram* mainProgram = instance->plcEngine.getProgram("main_program");
                 if (mainProgram) {
+                    // Posted to the input image, the PLC task applies it at its next cycle
+                    bool posted = false;
                     if (doc["value"].is<bool>()) {
-                        mainProgram->getMemory().setValue<bool>(var_name, doc["value"].as<bool>());
+                        posted = mainProgram->getMemory().postValue<bool>(var_name, doc["value"].as<bool>());
                     } else if (doc["value"].is<float>()) {
-                        mainProgram->getMemory().setValue<float>(var_name, doc["value"].as<float>());
+                        posted = mainProgram->getMemory().postValue<float>(var_name, doc["value"].as<float>());
                     } else if (doc["value"].is<int>()) {
-                        mainProgram->getMemory().setValue<int16_t>(var_name, doc["value"].as<int>());
+                        posted = mainProgram->getMemory().postValue<int16_t>(var_name, doc["value"].as<int>());
+                    }
+                    if (!posted) {
+                        EspHubLog->printf("WARNING: Sensor variable '%s' is not declared in the main program.\n", var_name);
                     }
                     instance->meshDeviceManager.updateDeviceLastSeen(from);
                     EspHubLog->printf("Mesh Sensor Data from %u: %s = %s\n", from, var_name, msg.c_str());
@@ -75,6 +75,10 @@ public:
     void mqttCallback(char* topic, byte* payload, unsigned int length); // New method for MQTT callback
     void setupTime(const char* tz_info);
     void loadPlcConfiguration(const char* jsonConfig);
+    bool loadPlcProgramFile(const String& programName, const char* path);       // Program JSON streamed from LittleFS
+    bool changePlcProgramFile(const String& programName, const char* path);     // Online change of a loaded program from LittleFS
+    bool loadPlcImageFile(const String& programName, const char* path);         // Program image (.plci) from LittleFS
+    bool loadPlcImagePartition(const String& programName, const char* label);   // Program image mapped from a data partition
     void runPlc(const String& programName);
     void pausePlc(const String& programName);
     void stopPlc(const String& programName);
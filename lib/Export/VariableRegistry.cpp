@@ -481,7 +481,7 @@ bool VariableRegistry::readFromPlc(const VariableMetadata& meta, PlcValue& value
         return false;
     }
 
-    // Get value from PLC memory
+    // Read the output image of the last completed PLC cycle
     PlcMemory& memory = program->getMemory();
 
     // Convert Arduino String to std::string for PlcMemory
@@ -489,16 +489,16 @@ bool VariableRegistry::readFromPlc(const VariableMetadata& meta, PlcValue& value
 
     switch (meta.type) {
         case PlcValueType::BOOL:
-            value.value.bVal = memory.getValue<bool>(varName);
+            value.value.bVal = memory.getImageValue<bool>(varName);
             return true;
         case PlcValueType::INT:
-            value.value.i16Val = memory.getValue<int16_t>(varName);
+            value.value.i16Val = memory.getImageValue<int16_t>(varName);
             return true;
         case PlcValueType::REAL:
-            value.value.fVal = memory.getValue<float>(varName);
+            value.value.fVal = memory.getImageValue<float>(varName);
             return true;
         case PlcValueType::STRING_TYPE: {
-            std::string str = memory.getValue<std::string>(varName);
+            std::string str = memory.getImageValue<std::string>(varName);
             strncpy(value.value.sVal, str.c_str(), sizeof(value.value.sVal) - 1);
             value.value.sVal[sizeof(value.value.sVal) - 1] = '\0';
             return true;
@@ -520,7 +520,7 @@ bool VariableRegistry::writeToPlc(const VariableMetadata& meta, const PlcValue&
         return false;
     }
 
-    // Write value to PLC memory
+    // Post to the input image, applied at the start of the next PLC cycle
     PlcMemory& memory = program->getMemory();
 
     // Convert Arduino String to std::string for PlcMemory
@@ -528,18 +528,14 @@ bool VariableRegistry::writeToPlc(const VariableMetadata& meta, const PlcValue&
 
     switch (meta.type) {
         case PlcValueType::BOOL:
-            memory.setValue<bool>(varName, value.value.bVal);
-            return true;
+            return memory.postValue<bool>(varName, value.value.bVal);
         case PlcValueType::INT:
-            memory.setValue<int16_t>(varName, value.value.i16Val);
-            return true;
+            return memory.postValue<int16_t>(varName, value.value.i16Val);
         case PlcValueType::REAL:
-            memory.setValue<float>(varName, value.value.fVal);
-            return true;
+            return memory.postValue<float>(varName, value.value.fVal);
         case PlcValueType::STRING_TYPE: {
             std::string str = value.value.sVal;
-            memory.setValue<std::string>(varName, str);
-            return true;
+            return memory.postValue<std::string>(varName, str);
         }
         default:
             return false;
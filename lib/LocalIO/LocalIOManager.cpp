@@ -506,48 +506,52 @@ void LocalIOManager::setSafeState() {
 // PLC Integration
 // ============================================================================
 
+static PlcValueType mappingType(const String& type) {
+    if (type == "real") {
+        return PlcValueType::REAL;
+    } else if (type == "int") {
+        return PlcValueType::INT;
+    }
+    return PlcValueType::BOOL;
+}
+
 void LocalIOManager::setPlcMemory(PlcMemory* memory) {
     plcMemory = memory;
+    for (auto& mapping : inputMappings) {
+        mapping.posted = false; // The new memory gets every input once
+        mapping.linked = false;
+    }
+    for (auto& mapping : outputMappings) {
+        mapping.linked = false;
+    }
 
     if (plcMemory == nullptr) {
         EspHubLog->println("LocalIOManager: PLC memory cleared");
         return;
     }
-
-    // Declare all PLC variables based on mappings
-    int declaredCount = 0;
-
-    // Declare input variables
-    for (const auto& mapping : inputMappings) {
-        PlcValueType varType = PlcValueType::BOOL;
-        if (mapping.type == "real") {
-            varType = PlcValueType::REAL;
-        } else if (mapping.type == "int") {
-            varType = PlcValueType::INT;
-        }
-
-        std::string varName = mapping.plcVarName.c_str();
-        if (plcMemory->declareVariable(varName, varType, false)) {
-            declaredCount++;
-        }
+    if (!plcMemory->hasProcessImage()) {
+        // Loading a program clears its memory, so there is nothing to link to yet
+        EspHubLog->println("ERROR: LocalIOManager: No PLC program loaded, IO mappings disabled");
+        return;
     }
 
-    // Declare output variables
-    for (const auto& mapping : outputMappings) {
-        PlcValueType varType = PlcValueType::BOOL;
-        if (mapping.type == "real") {
-            varType = PlcValueType::REAL;
-        } else if (mapping.type == "int") {
-            varType = PlcValueType::INT;
-        }
-
-        std::string varName = mapping.plcVarName.c_str();
-        if (plcMemory->declareVariable(varName, varType, false)) {
-            declaredCount++;
+    // The program declares the variables; a mapping is linked if it has one
+    // of the mapping's type, and only linked mappings are synchronised
+    int linkedCount = 0;
+    for (std::vector<PLCMapping>* mappings : {&inputMappings, &outputMappings}) {
+        for (auto& mapping : *mappings) {
+            mapping.linked = plcMemory->declareVariable(mapping.plcVarName.c_str(), mappingType(mapping.type), false);
+            if (mapping.linked) {
+                linkedCount++;
+            } else {
+                EspHubLog->printf("ERROR: LocalIOManager: Pin '%s' not linked, the PLC program has no %s variable '%s'\n",
+                                  mapping.ioPinName.c_str(), mapping.type.c_str(), mapping.plcVarName.c_str());
+            }
         }
     }
 
-    EspHubLog->printf("LocalIOManager: Declared %d PLC variables\n", declaredCount);
+    EspHubLog->printf("LocalIOManager: Linked %d of %u mapped PLC variables\n", linkedCount,
+                      (unsigned)(inputMappings.size() + outputMappings.size()));
 
     // Enable auto-sync
     autoSyncEnabled = true;
@@ -556,34 +560,56 @@ void LocalIOManager::setPlcMemory(PlcMemory* memory) {
 void LocalIOManager::syncWithPLC() {
     if (plcMemory == nullptr) return;
 
-    // Sync inputs: IO -> PLC
-    for (const auto& mapping : inputMappings) {
+    // Sync inputs: IO -> PLC (applied at the start of the next PLC cycle).
+    // Only changed values are posted, each post wakes a tickless PLC task.
+    for (auto& mapping : inputMappings) {
+        if (!mapping.linked) continue;
         IOPinBase* pin = getPin(mapping.ioPinName);
         if (!pin) continue;
 
         IOPinState state = pin->getState();
         if (!state.isValid) continue;
 
-        std::string varName = mapping.plcVarName.c_str();
+        uint32_t bits = 0;
+        if (mapping.type == "bool") {
+            bits = state.boolValue ? 1 : 0;
+        } else if (mapping.type == "real") {
+            memcpy(&bits, &state.floatValue, sizeof(bits));
+        } else if (mapping.type == "int") {
+            bits = static_cast<uint32_t>(state.intValue);
+        }
+        if (mapping.posted && bits == mapping.postedBits) continue;
 
+        std::string varName = mapping.plcVarName.c_str();
+        bool accepted = false;
         if (mapping.type == "bool") {
-            plcMemory->setValue(varName, state.boolValue);
+            accepted = plcMemory->postValue(varName, state.boolValue);
         } else if (mapping.type == "real") {
-            plcMemory->setValue(varName, state.floatValue);
+            accepted = plcMemory->postValue(varName, state.floatValue);
         } else if (mapping.type == "int") {
-            plcMemory->setValue(varName, state.intValue);
+            accepted = plcMemory->postValue(varName, state.intValue);
+        }
+        if (!accepted) {
+            // Linked variables are in the process image; the program was reloaded
+            EspHubLog->printf("ERROR: LocalIOManager: '%s' is no longer in the PLC program, pin '%s' unlinked\n",
+                              mapping.plcVarName.c_str(), mapping.ioPinName.c_str());
+            mapping.linked = false;
+            continue;
         }
+        mapping.posted = true;
+        mapping.postedBits = bits;
     }
 
-    // Sync outputs: PLC -> IO
+    // Sync outputs: PLC -> IO (values of the last completed PLC cycle)
     for (const auto& mapping : outputMappings) {
+        if (!mapping.linked) continue; // Not driven from a default value
         std::string varName = mapping.plcVarName.c_str();
 
         if (mapping.type == "bool") {
-            bool value = plcMemory->getValue<bool>(varName, false);
+            bool value = plcMemory->getImageValue<bool>(varName, false);
             writeDigital(mapping.ioPinName, value);
         } else if (mapping.type == "real") {
-            float value = plcMemory->getValue<float>(varName, 0.0f);
+            float value = plcMemory->getImageValue<float>(varName, 0.0f);
 
             // Try PWM output first
             PWMOutputPin* pwmPin = dynamic_cast<PWMOutputPin*>(getPin(mapping.ioPinName));
@@ -70,7 +70,11 @@ public:
     // ============================================================================
 
     /**
-     * @brief Set PLC memory for automatic variable mapping
+     * @brief Link the PLC mappings to the memory of a loaded program
+     *
+     * The program must declare each mapped variable with the mapping's
+     * type; mappings without one are logged and not synchronised. Call it
+     * again after the program is reloaded.
      * @param plcMemory Pointer to PLC memory
      */
     void setPlcMemory(PlcMemory* plcMemory);
@@ -243,6 +247,9 @@ private:
         String ioPinName;
         String plcVarName;
         String type; // "bool" or "real"
+        uint32_t postedBits = 0; // Inputs: raw value last posted to the PLC
+        bool posted = false;
+        bool linked = false;     // The PLC program declares the variable with this type
     };
 
     std::map<String, IOPinBase*> ioPins;
@@ -2,14 +2,215 @@
 #define PLC_BLOCK_H
 
 #include "../Engine/PlcMemory.h"
+#include "../Engine/PlcBytecode.h"
+#include "../Engine/PlcTimerWheel.h"
+#include "../Engine/PlcCycleContext.h"
+#include "../Engine/PlcWordLogic.h"
 #include <ArduinoJson.h>
+#include <vector>
+
+// Input or output of a block type, as listed in the block catalog
+struct PlcPinInfo {
+    const char* name;
+    const char* type;
+};
+
+// Static description of a block type. Each block class defines one as
+// DESCRIPTOR next to its TYPE name; the pin lists end with an empty entry.
+struct PlcBlockDescriptor {
+    const char* category;
+    const char* description;
+    const PlcPinInfo* inputs;
+    const PlcPinInfo* outputs;
+};
 
 class PlcBlock {
 public:
+    PlcBlock() : arena(nullptr), timers(nullptr), cycle(nullptr) {}
     virtual ~PlcBlock() {}
+
+    // Allocate the block's handle and slot lists from arena; called by the
+    // registry right after construction, before configure()
+    void setArena(PlcArena* blockArena) {
+        arena = blockArena;
+        SlotList(PlcArenaAllocator<uint16_t>(arena)).swap(input_slots);
+        SlotList(PlcArenaAllocator<uint16_t>(arena)).swap(output_slots);
+    }
+
+    // Timer service of the program, set by the registry along with the arena
+    void setTimers(PlcTimerWheel* wheel) { timers = wheel; }
+    // Scan the block runs in (time, local time, cycle count), same
+    void setCycleContext(const PlcCycleContext* context) { cycle = context; }
+
     virtual bool configure(const JsonObject& config, PlcMemory& memory) = 0;
     virtual void evaluate(PlcMemory& memory) = 0;
-    virtual JsonDocument getBlockSchema() = 0; // Returns a JSON schema for validation
+
+    // Emit bytecode equivalent to evaluate(). Blocks that return false are
+    // executed through their evaluate() method by the VM.
+    virtual bool lower(PlcBytecode& code) { return false; }
+
+    // Blocks whose outputs can change while their inputs stay the same
+    // (timers, clock, device status) return true. They are evaluated on
+    // every scan in incremental execution mode.
+    virtual bool isAlwaysLive() const { return false; }
+
+    // Tickless mode parks a program once a scan changed no variable and no
+    // always-live block needs the next scan. Blocks that expect neither an
+    // input change nor a timer expiry before their next step (a timer
+    // counting ET, a sequencer that entered a step) return true.
+    virtual bool needsScan() const { return isAlwaysLive(); }
+
+    // Online change: take over the state of the block this one replaces in
+    // the previous program version, which has the same type. Variable values
+    // are carried by PlcProgram, so only state kept in the block itself
+    // (edge memory, timer start, sequencer step) is copied here.
+    virtual void migrateState(const PlcBlock& previous) {}
+
+    // Timer the block arms in the timer service, if any. Its expiry wakes
+    // the block in incremental execution mode.
+    virtual PlcTimer* getTimer() { return nullptr; }
+
+    // Load-time optimizer (PlcProgram::optimizeBlocks()). Blocks that keep
+    // state of their own between scans (what migrateState() copies) return
+    // true from hasState(), so they are not folded into constants.
+    virtual bool hasState() const { return false; }
+
+    // A conversion whose output is its input converted the way PlcMemory
+    // converts between the two slot types, so a chain ending in it can
+    // skip the intermediate variable
+    virtual bool isPassThrough() const { return false; }
+
+    // Write the variable `to` instead of the output slot `from`, where that
+    // gives the same value as writing `from` and converting it to the type
+    // of `to`. Blocks that cannot return false.
+    virtual bool redirectOutput(uint16_t from, VarHandle to) { return false; }
+
+    // A two-input AND, OR, XOR, NAND, NOR or a NOT of BOOL variables
+    // describes itself, so the optimizer can pack such blocks into word
+    // operations (PlcProgram::packBitLogic()). Other blocks return false.
+    virtual bool describeBitOp(PlcBitOp& op) const { return false; }
+
+    // Slots read and written by the block, recorded by the bind helpers.
+    // PlcProgram builds the data-flow graph from them.
+    typedef PlcArenaVector<uint16_t> SlotList;
+    const SlotList& getInputSlots() const { return input_slots; }
+    const SlotList& getOutputSlots() const { return output_slots; }
+
+protected:
+    // Resolve a variable name from the block configuration to a slot handle.
+    // A missing or empty name yields an invalid handle; undeclared variables
+    // are declared with the given type.
+    VarHandle bindInput(PlcMemory& memory, JsonVariantConst name, PlcValueType type) {
+        return bindInputName(memory, name.as<const char*>(), type);
+    }
+
+    // Same for a name found elsewhere than in a JSON value (e.g. in an expression)
+    VarHandle bindInputName(PlcMemory& memory, const char* name, PlcValueType type) {
+        VarHandle handle = memory.resolve(name, type);
+        recordSlot(input_slots, handle);
+        return handle;
+    }
+
+    VarHandle bindOutput(PlcMemory& memory, JsonVariantConst name, PlcValueType type) {
+        return bindOutputName(memory, name.as<const char*>(), type);
+    }
+
+    VarHandle bindOutputName(PlcMemory& memory, const char* name, PlcValueType type) {
+        VarHandle handle = memory.resolve(name, type);
+        recordSlot(output_slots, handle);
+        return handle;
+    }
+
+    // Variable that is both read and written by the block (e.g. INC/DEC)
+    VarHandle bindInOut(PlcMemory& memory, JsonVariantConst name, PlcValueType type) {
+        VarHandle handle = bindInput(memory, name, type);
+        recordSlot(output_slots, handle);
+        return handle;
+    }
+
+    // Bind a list of inputs given either as an array of names or as an
+    // object of named inputs ({"in1": "a", "in2": "b"}).
+    void bindInputs(PlcMemory& memory, JsonVariantConst inputs, PlcValueType type, PlcHandleList& handles) {
+        PlcHandleList(PlcArenaAllocator<VarHandle>(arena)).swap(handles);
+        handles.reserve(inputs.size());
+        input_slots.reserve(input_slots.size() + inputs.size());
+        if (inputs.is<JsonArrayConst>()) {
+            for (JsonVariantConst v : inputs.as<JsonArrayConst>()) {
+                handles.push_back(bindInput(memory, v, type));
+            }
+        } else if (inputs.is<JsonObjectConst>()) {
+            for (JsonPairConst kv : inputs.as<JsonObjectConst>()) {
+                handles.push_back(bindInput(memory, kv.value(), type));
+            }
+        }
+    }
+
+    // Resolve the name of an ARRAY variable (PlcMemory::declareArray()) and
+    // record all its elements. Arrays are never declared by a block, so an
+    // unknown name yields an invalid reference.
+    PlcArrayRef bindArrayInput(PlcMemory& memory, JsonVariantConst name) {
+        PlcArrayRef array = memory.findArray(name.as<const char*>());
+        recordArray(input_slots, array);
+        return array;
+    }
+
+    PlcArrayRef bindArrayOutput(PlcMemory& memory, JsonVariantConst name) {
+        PlcArrayRef array = memory.findArray(name.as<const char*>());
+        recordArray(output_slots, array);
+        return array;
+    }
+
+    // Take over the slots of a block this one evaluates as part of itself
+    // (function block instances of an ST program)
+    void adoptSlots(const PlcBlock& child) {
+        for (uint16_t index : child.input_slots) {
+            recordIndex(input_slots, index);
+        }
+        for (uint16_t index : child.output_slots) {
+            recordIndex(output_slots, index);
+        }
+    }
+
+    // For redirectOutput(): the block now writes slot to instead of from
+    void replaceOutputSlot(uint16_t from, uint16_t to) {
+        for (size_t i = 0; i < output_slots.size(); i++) {
+            if (output_slots[i] == from) {
+                output_slots.erase(output_slots.begin() + i);
+                break;
+            }
+        }
+        recordIndex(output_slots, to);
+    }
+
+    PlcArena* arena;
+    PlcTimerWheel* timers;
+    const PlcCycleContext* cycle;
+
+private:
+    SlotList input_slots;
+    SlotList output_slots;
+
+    static void recordSlot(SlotList& slots, VarHandle handle) {
+        if (handle.isValid()) {
+            recordIndex(slots, handle.index);
+        }
+    }
+
+    static void recordArray(SlotList& slots, const PlcArrayRef& array) {
+        slots.reserve(slots.size() + array.length);
+        for (uint16_t i = 0; i < array.length; i++) {
+            recordIndex(slots, static_cast<uint16_t>(array.firstSlot + i));
+        }
+    }
+
+    static void recordIndex(SlotList& slots, uint16_t index) {
+        for (uint16_t slot : slots) {
+            if (slot == index) {
+                return;
+            }
+        }
+        slots.push_back(index);
+    }
 };
 
 #endif // PLC_BLOCK_H
\ No newline at end of file
@@ -0,0 +1,5 @@
+#include "BlockArrayAdd.h"
+
+const PlcPinInfo BlockArrayAdd::INPUTS[] = {{"in1", "array"}, {"in2", "array"}, {}};
+const PlcPinInfo BlockArrayAdd::OUTPUTS[] = {{"out", "array"}, {}};
+const PlcBlockDescriptor BlockArrayAdd::DESCRIPTOR = {"array", "Element-wise sum of two arrays", INPUTS, OUTPUTS};
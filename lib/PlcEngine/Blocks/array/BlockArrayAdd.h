@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_ADD_H
+#define PLC_BLOCK_ARRAY_ADD_H
+
+#include "PlcArrayMapBlock.h"
+
+class BlockArrayAdd : public PlcArrayMapBlock<PlcArrayOps::Add> {
+public:
+    static constexpr const char* TYPE = "ARRAY_ADD";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_ADD_H
@@ -0,0 +1,5 @@
+#include "BlockArrayAnd.h"
+
+const PlcPinInfo BlockArrayAnd::INPUTS[] = {{"in1", "array"}, {"in2", "array"}, {}};
+const PlcPinInfo BlockArrayAnd::OUTPUTS[] = {{"out", "array"}, {}};
+const PlcBlockDescriptor BlockArrayAnd::DESCRIPTOR = {"array", "Element-wise AND of two bool arrays, 32 elements per word", INPUTS, OUTPUTS};
@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_AND_H
+#define PLC_BLOCK_ARRAY_AND_H
+
+#include "PlcArrayWordBlock.h"
+
+class BlockArrayAnd : public PlcArrayWordBlock<PlcArrayOps::And> {
+public:
+    static constexpr const char* TYPE = "ARRAY_AND";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_AND_H
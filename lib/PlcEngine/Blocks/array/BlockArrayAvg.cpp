@@ -0,0 +1,28 @@
+#include "BlockArrayAvg.h"
+
+bool BlockArrayAvg::configure(const JsonObject& config, PlcMemory& memory) {
+    if (!bindArray(memory, TYPE, config["inputs"]["in"], false, input)) {
+        return false;
+    }
+    output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::REAL);
+    if (!PlcTypeCheck::checkOutput(memory, TYPE, output_var, PlcValueType::REAL)) {
+        return false;
+    }
+    switch (output_var.isValid() ? input.type : PlcValueType::BOOL) {
+        case PlcValueType::INT: kernel = &averageKernel<int16_t>; break;
+        case PlcValueType::DINT: kernel = &averageKernel<int32_t>; break;
+        case PlcValueType::REAL: kernel = &averageKernel<float>; break;
+        default: kernel = nullptr; break;
+    }
+    return true;
+}
+
+template<typename T>
+void BlockArrayAvg::averageKernel(PlcMemory& memory, const PlcArrayRef& input, VarHandle output) {
+    float total = static_cast<float>(PlcArrayOps::sum(memory.arrayData<T>(input), input.length));
+    memory.setValue<float>(output, total / input.length);
+}
+
+const PlcPinInfo BlockArrayAvg::INPUTS[] = {{"in", "array"}, {}};
+const PlcPinInfo BlockArrayAvg::OUTPUTS[] = {{"out", "float"}, {}};
+const PlcBlockDescriptor BlockArrayAvg::DESCRIPTOR = {"array", "Mean of the array elements", INPUTS, OUTPUTS};
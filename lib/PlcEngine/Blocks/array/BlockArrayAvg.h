@@ -0,0 +1,35 @@
+#ifndef PLC_BLOCK_ARRAY_AVG_H
+#define PLC_BLOCK_ARRAY_AVG_H
+
+#include "PlcArrayBlock.h"
+
+// Mean of the elements of an array, REAL for every element type
+class BlockArrayAvg : public PlcArrayBlock {
+public:
+    static constexpr const char* TYPE = "ARRAY_AVG";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    BlockArrayAvg() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override;
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input, output_var);
+        }
+    }
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    typedef void (*Kernel)(PlcMemory& memory, const PlcArrayRef& input, VarHandle output);
+    Kernel kernel; // nullptr while not configured
+
+    template<typename T>
+    static void averageKernel(PlcMemory& memory, const PlcArrayRef& input, VarHandle output);
+
+    PlcArrayRef input;
+    VarHandle output_var;
+};
+
+#endif // PLC_BLOCK_ARRAY_AVG_H
@@ -0,0 +1,23 @@
+#include "BlockArrayCountGt.h"
+
+bool BlockArrayCountGt::configure(const JsonObject& config, PlcMemory& memory) {
+    if (!bindArray(memory, TYPE, config["inputs"]["in"], false, input)) {
+        return false;
+    }
+    threshold_var = bindInput(memory, config["inputs"]["threshold"], PlcValueType::REAL);
+    output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::INT);
+    if (!PlcTypeCheck::checkOutput(memory, TYPE, output_var, PlcValueType::INT)) {
+        return false;
+    }
+    switch (output_var.isValid() ? input.type : PlcValueType::BOOL) {
+        case PlcValueType::INT: kernel = &countKernel<int16_t>; break;
+        case PlcValueType::DINT: kernel = &countKernel<int32_t>; break;
+        case PlcValueType::REAL: kernel = &countKernel<float>; break;
+        default: kernel = nullptr; break;
+    }
+    return true;
+}
+
+const PlcPinInfo BlockArrayCountGt::INPUTS[] = {{"in", "array"}, {"threshold", "float"}, {}};
+const PlcPinInfo BlockArrayCountGt::OUTPUTS[] = {{"out", "int"}, {}};
+const PlcBlockDescriptor BlockArrayCountGt::DESCRIPTOR = {"array", "Count of array elements above a threshold", INPUTS, OUTPUTS};
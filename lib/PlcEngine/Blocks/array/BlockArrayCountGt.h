@@ -0,0 +1,39 @@
+#ifndef PLC_BLOCK_ARRAY_COUNT_GT_H
+#define PLC_BLOCK_ARRAY_COUNT_GT_H
+
+#include "PlcArrayBlock.h"
+
+// Number of array elements greater than a threshold, as an INT
+// (e.g. how many zones are above their alarm temperature)
+class BlockArrayCountGt : public PlcArrayBlock {
+public:
+    static constexpr const char* TYPE = "ARRAY_COUNT_GT";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    BlockArrayCountGt() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override;
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            memory.setValue<int16_t>(output_var, kernel(memory, input, memory.getValue<float>(threshold_var, 0.0f)));
+        }
+    }
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    typedef int16_t (*Kernel)(const PlcMemory& memory, const PlcArrayRef& input, float threshold);
+    Kernel kernel; // nullptr while not configured
+
+    template<typename T>
+    static int16_t countKernel(const PlcMemory& memory, const PlcArrayRef& input, float threshold) {
+        return static_cast<int16_t>(PlcArrayOps::countAbove(memory.arrayData<T>(input), input.length, threshold));
+    }
+
+    PlcArrayRef input;
+    VarHandle threshold_var;
+    VarHandle output_var;
+};
+
+#endif // PLC_BLOCK_ARRAY_COUNT_GT_H
@@ -0,0 +1,28 @@
+#include "BlockArrayDot.h"
+
+bool BlockArrayDot::configure(const JsonObject& config, PlcMemory& memory) {
+    if (!bindArray(memory, TYPE, config["inputs"]["in1"], false, input1) ||
+        !bindArray(memory, TYPE, config["inputs"]["in2"], false, input2) || !sameShape(TYPE, input1, input2)) {
+        return false;
+    }
+    output_var = bindOutput(memory, config["outputs"]["out"], PlcTypeCheck::declarationType(memory, input1.type));
+    if (!PlcTypeCheck::checkOutput(memory, TYPE, output_var, input1.type)) {
+        return false;
+    }
+    switch (output_var.isValid() ? input1.type : PlcValueType::BOOL) {
+        case PlcValueType::INT: kernel = &dotKernel<int16_t>; break;
+        case PlcValueType::DINT: kernel = &dotKernel<int32_t>; break;
+        case PlcValueType::REAL: kernel = &dotKernel<float>; break;
+        default: kernel = nullptr; break;
+    }
+    return true;
+}
+
+template<typename T>
+void BlockArrayDot::dotKernel(PlcMemory& memory, const PlcArrayRef& in1, const PlcArrayRef& in2, VarHandle output) {
+    memory.setValue(output, PlcArrayOps::dot(memory.arrayData<T>(in1), memory.arrayData<T>(in2), in1.length));
+}
+
+const PlcPinInfo BlockArrayDot::INPUTS[] = {{"in1", "array"}, {"in2", "array"}, {}};
+const PlcPinInfo BlockArrayDot::OUTPUTS[] = {{"out", "float"}, {}};
+const PlcBlockDescriptor BlockArrayDot::DESCRIPTOR = {"array", "Dot product of two arrays", INPUTS, OUTPUTS};
@@ -0,0 +1,37 @@
+#ifndef PLC_BLOCK_ARRAY_DOT_H
+#define PLC_BLOCK_ARRAY_DOT_H
+
+#include "PlcArrayBlock.h"
+
+// Dot product of two arrays of the same length and element type
+// (weighted sums, energy from power samples and tariffs)
+class BlockArrayDot : public PlcArrayBlock {
+public:
+    static constexpr const char* TYPE = "ARRAY_DOT";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    BlockArrayDot() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override;
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input1, input2, output_var);
+        }
+    }
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    typedef void (*Kernel)(PlcMemory& memory, const PlcArrayRef& in1, const PlcArrayRef& in2, VarHandle output);
+    Kernel kernel; // nullptr while not configured
+
+    template<typename T>
+    static void dotKernel(PlcMemory& memory, const PlcArrayRef& in1, const PlcArrayRef& in2, VarHandle output);
+
+    PlcArrayRef input1;
+    PlcArrayRef input2;
+    VarHandle output_var;
+};
+
+#endif // PLC_BLOCK_ARRAY_DOT_H
@@ -0,0 +1,5 @@
+#include "BlockArrayFTrig.h"
+
+const PlcPinInfo BlockArrayFTrig::INPUTS[] = {{"in", "array"}, {}};
+const PlcPinInfo BlockArrayFTrig::OUTPUTS[] = {{"q", "array"}, {}};
+const PlcBlockDescriptor BlockArrayFTrig::DESCRIPTOR = {"array", "Falling edge of every element of a bool array", INPUTS, OUTPUTS};
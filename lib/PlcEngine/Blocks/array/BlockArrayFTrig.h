@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_F_TRIG_H
+#define PLC_BLOCK_ARRAY_F_TRIG_H
+
+#include "PlcArrayWordBlock.h"
+
+class BlockArrayFTrig : public PlcArrayEdgeBlock<PlcArrayOps::Falling> {
+public:
+    static constexpr const char* TYPE = "ARRAY_F_TRIG";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_F_TRIG_H
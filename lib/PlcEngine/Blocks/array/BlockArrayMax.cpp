@@ -0,0 +1,5 @@
+#include "BlockArrayMax.h"
+
+const PlcPinInfo BlockArrayMax::INPUTS[] = {{"in", "array"}, {}};
+const PlcPinInfo BlockArrayMax::OUTPUTS[] = {{"out", "float"}, {"index", "int"}, {}};
+const PlcBlockDescriptor BlockArrayMax::DESCRIPTOR = {"array", "Largest array element and its index", INPUTS, OUTPUTS};
@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_MAX_H
+#define PLC_BLOCK_ARRAY_MAX_H
+
+#include "PlcArrayExtremeBlock.h"
+
+class BlockArrayMax : public PlcArrayExtremeBlock<PlcArrayOps::Max> {
+public:
+    static constexpr const char* TYPE = "ARRAY_MAX";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_MAX_H
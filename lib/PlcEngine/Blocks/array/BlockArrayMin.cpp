@@ -0,0 +1,5 @@
+#include "BlockArrayMin.h"
+
+const PlcPinInfo BlockArrayMin::INPUTS[] = {{"in", "array"}, {}};
+const PlcPinInfo BlockArrayMin::OUTPUTS[] = {{"out", "float"}, {"index", "int"}, {}};
+const PlcBlockDescriptor BlockArrayMin::DESCRIPTOR = {"array", "Smallest array element and its index", INPUTS, OUTPUTS};
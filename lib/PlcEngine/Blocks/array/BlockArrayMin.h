@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_MIN_H
+#define PLC_BLOCK_ARRAY_MIN_H
+
+#include "PlcArrayExtremeBlock.h"
+
+class BlockArrayMin : public PlcArrayExtremeBlock<PlcArrayOps::Min> {
+public:
+    static constexpr const char* TYPE = "ARRAY_MIN";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_MIN_H
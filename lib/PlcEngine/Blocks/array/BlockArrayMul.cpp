@@ -0,0 +1,5 @@
+#include "BlockArrayMul.h"
+
+const PlcPinInfo BlockArrayMul::INPUTS[] = {{"in1", "array"}, {"in2", "array"}, {}};
+const PlcPinInfo BlockArrayMul::OUTPUTS[] = {{"out", "array"}, {}};
+const PlcBlockDescriptor BlockArrayMul::DESCRIPTOR = {"array", "Element-wise product of two arrays", INPUTS, OUTPUTS};
@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_MUL_H
+#define PLC_BLOCK_ARRAY_MUL_H
+
+#include "PlcArrayMapBlock.h"
+
+class BlockArrayMul : public PlcArrayMapBlock<PlcArrayOps::Mul> {
+public:
+    static constexpr const char* TYPE = "ARRAY_MUL";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_MUL_H
@@ -0,0 +1,5 @@
+#include "BlockArrayNot.h"
+
+const PlcPinInfo BlockArrayNot::INPUTS[] = {{"in", "array"}, {}};
+const PlcPinInfo BlockArrayNot::OUTPUTS[] = {{"out", "array"}, {}};
+const PlcBlockDescriptor BlockArrayNot::DESCRIPTOR = {"array", "Element-wise NOT of a bool array, 32 elements per word", INPUTS, OUTPUTS};
@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_NOT_H
+#define PLC_BLOCK_ARRAY_NOT_H
+
+#include "PlcArrayWordBlock.h"
+
+class BlockArrayNot : public PlcArrayWordBlock<PlcArrayOps::Not> {
+public:
+    static constexpr const char* TYPE = "ARRAY_NOT";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_NOT_H
@@ -0,0 +1,5 @@
+#include "BlockArrayOr.h"
+
+const PlcPinInfo BlockArrayOr::INPUTS[] = {{"in1", "array"}, {"in2", "array"}, {}};
+const PlcPinInfo BlockArrayOr::OUTPUTS[] = {{"out", "array"}, {}};
+const PlcBlockDescriptor BlockArrayOr::DESCRIPTOR = {"array", "Element-wise OR of two bool arrays, 32 elements per word", INPUTS, OUTPUTS};
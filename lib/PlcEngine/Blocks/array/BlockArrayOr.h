@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_OR_H
+#define PLC_BLOCK_ARRAY_OR_H
+
+#include "PlcArrayWordBlock.h"
+
+class BlockArrayOr : public PlcArrayWordBlock<PlcArrayOps::Or> {
+public:
+    static constexpr const char* TYPE = "ARRAY_OR";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_OR_H
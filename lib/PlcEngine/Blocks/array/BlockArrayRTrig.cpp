@@ -0,0 +1,5 @@
+#include "BlockArrayRTrig.h"
+
+const PlcPinInfo BlockArrayRTrig::INPUTS[] = {{"in", "array"}, {}};
+const PlcPinInfo BlockArrayRTrig::OUTPUTS[] = {{"q", "array"}, {}};
+const PlcBlockDescriptor BlockArrayRTrig::DESCRIPTOR = {"array", "Rising edge of every element of a bool array", INPUTS, OUTPUTS};
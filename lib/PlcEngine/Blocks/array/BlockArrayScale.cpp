@@ -0,0 +1,29 @@
+#include "BlockArrayScale.h"
+
+bool BlockArrayScale::configure(const JsonObject& config, PlcMemory& memory) {
+    if (!bindArray(memory, TYPE, config["inputs"]["in"], false, input) ||
+        !bindArray(memory, TYPE, config["outputs"]["out"], true, output) || !sameShape(TYPE, input, output)) {
+        return false;
+    }
+    factor_var = bindInput(memory, config["inputs"]["factor"], PlcValueType::REAL);
+    offset_var = bindInput(memory, config["inputs"]["offset"], PlcValueType::REAL);
+    switch (input.type) {
+        case PlcValueType::INT: kernel = &scaleKernel<int16_t>; break;
+        case PlcValueType::DINT: kernel = &scaleKernel<int32_t>; break;
+        case PlcValueType::REAL: kernel = &scaleKernel<float>; break;
+        default: kernel = nullptr; break;
+    }
+    return true;
+}
+
+template<typename T>
+void BlockArrayScale::scaleKernel(PlcMemory& memory, const PlcArrayRef& input, float factor, float offset, const PlcArrayRef& output) {
+    const T* in = memory.arrayData<T>(input);
+    writeElements<T>(memory, output, [in, factor, offset](uint16_t i) {
+        return static_cast<T>(static_cast<float>(in[i]) * factor + offset);
+    });
+}
+
+const PlcPinInfo BlockArrayScale::INPUTS[] = {{"in", "array"}, {"factor", "float"}, {"offset", "float"}, {}};
+const PlcPinInfo BlockArrayScale::OUTPUTS[] = {{"out", "array"}, {}};
+const PlcBlockDescriptor BlockArrayScale::DESCRIPTOR = {"array", "Scale and offset every array element", INPUTS, OUTPUTS};
@@ -0,0 +1,38 @@
+#ifndef PLC_BLOCK_ARRAY_SCALE_H
+#define PLC_BLOCK_ARRAY_SCALE_H
+
+#include "PlcArrayBlock.h"
+
+// out[i] = in[i] * factor + offset, with REAL factor and offset (0 if not
+// given); results are stored like a REAL written to the element type
+class BlockArrayScale : public PlcArrayBlock {
+public:
+    static constexpr const char* TYPE = "ARRAY_SCALE";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    BlockArrayScale() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override;
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input, memory.getValue<float>(factor_var, 1.0f), memory.getValue<float>(offset_var, 0.0f), output);
+        }
+    }
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    typedef void (*Kernel)(PlcMemory& memory, const PlcArrayRef& input, float factor, float offset, const PlcArrayRef& output);
+    Kernel kernel; // nullptr while not configured
+
+    template<typename T>
+    static void scaleKernel(PlcMemory& memory, const PlcArrayRef& input, float factor, float offset, const PlcArrayRef& output);
+
+    PlcArrayRef input;
+    VarHandle factor_var;
+    VarHandle offset_var;
+    PlcArrayRef output;
+};
+
+#endif // PLC_BLOCK_ARRAY_SCALE_H
@@ -0,0 +1,27 @@
+#include "BlockArraySum.h"
+
+bool BlockArraySum::configure(const JsonObject& config, PlcMemory& memory) {
+    if (!bindArray(memory, TYPE, config["inputs"]["in"], false, input)) {
+        return false;
+    }
+    output_var = bindOutput(memory, config["outputs"]["out"], PlcTypeCheck::declarationType(memory, input.type));
+    if (!PlcTypeCheck::checkOutput(memory, TYPE, output_var, input.type)) {
+        return false;
+    }
+    switch (output_var.isValid() ? input.type : PlcValueType::BOOL) {
+        case PlcValueType::INT: kernel = &sumKernel<int16_t>; break;
+        case PlcValueType::DINT: kernel = &sumKernel<int32_t>; break;
+        case PlcValueType::REAL: kernel = &sumKernel<float>; break;
+        default: kernel = nullptr; break;
+    }
+    return true;
+}
+
+template<typename T>
+void BlockArraySum::sumKernel(PlcMemory& memory, const PlcArrayRef& input, VarHandle output) {
+    memory.setValue(output, PlcArrayOps::sum(memory.arrayData<T>(input), input.length));
+}
+
+const PlcPinInfo BlockArraySum::INPUTS[] = {{"in", "array"}, {}};
+const PlcPinInfo BlockArraySum::OUTPUTS[] = {{"out", "float"}, {}};
+const PlcBlockDescriptor BlockArraySum::DESCRIPTOR = {"array", "Sum of the array elements", INPUTS, OUTPUTS};
@@ -0,0 +1,35 @@
+#ifndef PLC_BLOCK_ARRAY_SUM_H
+#define PLC_BLOCK_ARRAY_SUM_H
+
+#include "PlcArrayBlock.h"
+
+// Sum of the elements of an array, in place of a chain of ADD blocks
+class BlockArraySum : public PlcArrayBlock {
+public:
+    static constexpr const char* TYPE = "ARRAY_SUM";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    BlockArraySum() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override;
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input, output_var);
+        }
+    }
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    typedef void (*Kernel)(PlcMemory& memory, const PlcArrayRef& input, VarHandle output);
+    Kernel kernel; // nullptr while not configured
+
+    template<typename T>
+    static void sumKernel(PlcMemory& memory, const PlcArrayRef& input, VarHandle output);
+
+    PlcArrayRef input;
+    VarHandle output_var;
+};
+
+#endif // PLC_BLOCK_ARRAY_SUM_H
@@ -0,0 +1,5 @@
+#include "BlockArrayXor.h"
+
+const PlcPinInfo BlockArrayXor::INPUTS[] = {{"in1", "array"}, {"in2", "array"}, {}};
+const PlcPinInfo BlockArrayXor::OUTPUTS[] = {{"out", "array"}, {}};
+const PlcBlockDescriptor BlockArrayXor::DESCRIPTOR = {"array", "Element-wise XOR of two bool arrays, 32 elements per word", INPUTS, OUTPUTS};
@@ -0,0 +1,16 @@
+#ifndef PLC_BLOCK_ARRAY_XOR_H
+#define PLC_BLOCK_ARRAY_XOR_H
+
+#include "PlcArrayWordBlock.h"
+
+class BlockArrayXor : public PlcArrayWordBlock<PlcArrayOps::Xor> {
+public:
+    static constexpr const char* TYPE = "ARRAY_XOR";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+};
+
+#endif // PLC_BLOCK_ARRAY_XOR_H
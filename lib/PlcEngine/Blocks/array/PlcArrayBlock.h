@@ -0,0 +1,250 @@
+#ifndef PLC_ARRAY_BLOCK_H
+#define PLC_ARRAY_BLOCK_H
+
+#include "../PlcBlock.h"
+#include "../../Engine/PlcTypeCheck.h"
+#include "../../Engine/PlcProgramImage.h"
+#include <StreamLogger.h>
+#include <cmath>
+#include <limits>
+
+extern StreamLogger* EspHubLog;
+
+/**
+ * PlcArrayOps - loops of the vector blocks over the values of an array.
+ *
+ * They run over the plain pointers of PlcMemory::arrayData(), with no call
+ * and no branch on the slot type inside the loop, so the compiler can
+ * vectorize them where the target has SIMD instructions. Float sums keep
+ * four partial sums, as the compiler may not reorder a single running sum;
+ * results can differ from an ADD chain in the last bit.
+ */
+namespace PlcArrayOps {
+
+// Sums and dot products of integers are exact: INT sums fit 32 bits
+// (PLC_MAX_ARRAY_LENGTH elements of 16 bits), the rest is summed in 64 bits
+
+template<typename T>
+inline int64_t sum(const T* values, uint16_t count) {
+    int64_t total = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+template<>
+inline int64_t sum<int16_t>(const int16_t* values, uint16_t count) {
+    int32_t total = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+inline float sum(const float* values, uint16_t count) {
+    float lane0 = 0.0f, lane1 = 0.0f, lane2 = 0.0f, lane3 = 0.0f;
+    uint16_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        lane0 += values[i];
+        lane1 += values[i + 1];
+        lane2 += values[i + 2];
+        lane3 += values[i + 3];
+    }
+    float total = (lane0 + lane1) + (lane2 + lane3);
+    for (; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+template<typename T>
+inline int64_t dot(const T* a, const T* b, uint16_t count) {
+    int64_t total = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        total += static_cast<int64_t>(a[i]) * b[i];
+    }
+    return total;
+}
+
+inline float dot(const float* a, const float* b, uint16_t count) {
+    float lane0 = 0.0f, lane1 = 0.0f, lane2 = 0.0f, lane3 = 0.0f;
+    uint16_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        lane0 += a[i] * b[i];
+        lane1 += a[i + 1] * b[i + 1];
+        lane2 += a[i + 2] * b[i + 2];
+        lane3 += a[i + 3] * b[i + 3];
+    }
+    float total = (lane0 + lane1) + (lane2 + lane3);
+    for (; i < count; i++) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+// Element-wise operations. Integers wrap like the typed ADD and MUL kernels,
+// computed as uint32_t, which has no overflow to worry about.
+struct Add {
+    static constexpr const char* NAME = "ARRAY_ADD";
+    template<typename T>
+    static inline T apply(T a, T b) { return static_cast<T>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); }
+    static inline float apply(float a, float b) { return a + b; }
+};
+
+struct Mul {
+    static constexpr const char* NAME = "ARRAY_MUL";
+    template<typename T>
+    static inline T apply(T a, T b) { return static_cast<T>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)); }
+    static inline float apply(float a, float b) { return a * b; }
+};
+
+// Smallest or largest value and the first index holding it. The value is
+// searched first, in a loop the compiler can vectorize, then its index.
+struct Min {
+    static constexpr const char* NAME = "ARRAY_MIN";
+    template<typename T>
+    static inline T pick(T a, T b) { return b < a ? b : a; }
+};
+
+struct Max {
+    static constexpr const char* NAME = "ARRAY_MAX";
+    template<typename T>
+    static inline T pick(T a, T b) { return b > a ? b : a; }
+};
+
+template<class Op, typename T>
+inline uint16_t extreme(const T* values, uint16_t count, T& value) {
+    T best = values[0];
+    for (uint16_t i = 1; i < count; i++) {
+        best = Op::pick(best, values[i]);
+    }
+    value = best;
+    for (uint16_t i = 0; i < count; i++) {
+        if (values[i] == best) {
+            return i;
+        }
+    }
+    return 0; // NaN
+}
+
+// Elements greater than threshold. An integer element is greater than a
+// REAL threshold exactly when it is greater than its floor, so integer
+// arrays are compared in their own type.
+template<typename T>
+inline uint16_t countAbove(const T* values, uint16_t count, float threshold) {
+    if (std::isnan(threshold) || threshold >= static_cast<float>(std::numeric_limits<T>::max())) {
+        return 0;
+    }
+    if (threshold < static_cast<float>(std::numeric_limits<T>::min())) {
+        return count;
+    }
+    T limit = static_cast<T>(std::floor(threshold));
+    uint16_t above = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        above += values[i] > limit ? 1 : 0;
+    }
+    return above;
+}
+
+template<>
+inline uint16_t countAbove<float>(const float* values, uint16_t count, float threshold) {
+    uint16_t above = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        above += values[i] > threshold ? 1 : 0;
+    }
+    return above;
+}
+
+} // namespace PlcArrayOps
+
+/**
+ * PlcArrayBlock - base of the blocks working on ARRAY variables.
+ *
+ * Array operands are bound with bindArrayInput()/bindArrayOutput(), which
+ * record every element as read or written. INT, DINT and REAL arrays are
+ * accepted; evaluate() of the subclasses calls a kernel picked in
+ * configure() for the element type, like the arithmetic blocks.
+ */
+class PlcArrayBlock : public PlcBlock {
+protected:
+    // A numeric array for the given pin. Logs an error for a missing name,
+    // an unknown array and a BOOL array.
+    bool bindArray(PlcMemory& memory, const char* blockType, JsonVariantConst name, bool output, PlcArrayRef& array) {
+        const char* arrayName = name.as<const char*>();
+        if (arrayName == nullptr || arrayName[0] == '\0') {
+            EspHubLog->printf("ERROR: %s: an array variable is required\n", blockType);
+            return false;
+        }
+        array = output ? bindArrayOutput(memory, name) : bindArrayInput(memory, name);
+        if (!array.isValid()) {
+            EspHubLog->printf("ERROR: %s: '%s' is not an array variable\n", blockType, arrayName);
+            return false;
+        }
+        if (!PlcTypeCheck::hasTypedKernel(array.type)) {
+            EspHubLog->printf("ERROR: %s: '%s' is an array of %s, expected int, dint or real\n",
+                              blockType, arrayName, PlcProgramImage::typeName(array.type));
+            return false;
+        }
+        return true;
+    }
+
+    // A BOOL array for the given pin (ARRAY_AND, ...), with the same errors
+    bool bindBoolArray(PlcMemory& memory, const char* blockType, JsonVariantConst name, bool output, PlcArrayRef& array) {
+        const char* arrayName = name.as<const char*>();
+        if (arrayName == nullptr || arrayName[0] == '\0') {
+            EspHubLog->printf("ERROR: %s: an array variable is required\n", blockType);
+            return false;
+        }
+        array = output ? bindArrayOutput(memory, name) : bindArrayInput(memory, name);
+        if (!array.isValid()) {
+            EspHubLog->printf("ERROR: %s: '%s' is not an array variable\n", blockType, arrayName);
+            return false;
+        }
+        if (array.type != PlcValueType::BOOL) {
+            EspHubLog->printf("ERROR: %s: '%s' is an array of %s, expected bool\n",
+                              blockType, arrayName, PlcProgramImage::typeName(array.type));
+            return false;
+        }
+        return true;
+    }
+
+    // BOOL arrays start at a marker word (PlcMemory::declareArray()), so
+    // element i is bit i % 32 of word i / 32 of the array. Bits of the last
+    // word past the end of the array are masked out.
+    static uint16_t wordCount(const PlcArrayRef& array) { return static_cast<uint16_t>((array.length + 31) >> 5); }
+
+    static uint32_t wordMask(const PlcArrayRef& array, uint16_t word) {
+        uint16_t bits = array.length - (word << 5);
+        return bits >= 32 ? ~0u : (1u << bits) - 1;
+    }
+
+    // Both arrays have the same length and element type
+    static bool sameShape(const char* blockType, const PlcArrayRef& a, const PlcArrayRef& b) {
+        if (a.length == b.length && a.type == b.type) {
+            return true;
+        }
+        EspHubLog->printf("ERROR: %s: arrays differ (%u x %s and %u x %s)\n", blockType,
+                          (unsigned)a.length, PlcProgramImage::typeName(a.type),
+                          (unsigned)b.length, PlcProgramImage::typeName(b.type));
+        return false;
+    }
+
+    // Write the result values of an element-wise block: through the pointer,
+    // or per element while changes are tracked (incremental execution)
+    template<typename T, typename F>
+    static void writeElements(PlcMemory& memory, const PlcArrayRef& output, F value) {
+        if (memory.isChangeTrackingEnabled()) {
+            for (uint16_t i = 0; i < output.length; i++) {
+                memory.setTyped<T>(output.element(i), value(i));
+            }
+            return;
+        }
+        T* out = memory.arrayData<T>(output);
+        for (uint16_t i = 0; i < output.length; i++) {
+            out[i] = value(i);
+        }
+    }
+};
+
+#endif // PLC_ARRAY_BLOCK_H
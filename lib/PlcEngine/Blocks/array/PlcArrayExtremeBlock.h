@@ -0,0 +1,59 @@
+#ifndef PLC_ARRAY_EXTREME_BLOCK_H
+#define PLC_ARRAY_EXTREME_BLOCK_H
+
+#include "PlcArrayBlock.h"
+
+/**
+ * PlcArrayExtremeBlock - smallest or largest element of an array
+ * (ARRAY_MIN, ARRAY_MAX): its value on "out", of the element type, and
+ * the first index holding it on "index", an INT.
+ */
+template<class Op>
+class PlcArrayExtremeBlock : public PlcArrayBlock {
+public:
+    PlcArrayExtremeBlock() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override {
+        if (!bindArray(memory, Op::NAME, config["inputs"]["in"], false, input)) {
+            return false;
+        }
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcTypeCheck::declarationType(memory, input.type));
+        index_var = bindOutput(memory, config["outputs"]["index"], PlcValueType::INT);
+        if (!PlcTypeCheck::checkOutput(memory, Op::NAME, output_var, input.type) ||
+            !PlcTypeCheck::checkOutput(memory, Op::NAME, index_var, PlcValueType::INT)) {
+            return false;
+        }
+        switch (input.type) {
+            case PlcValueType::INT: kernel = &extremeKernel<int16_t>; break;
+            case PlcValueType::DINT: kernel = &extremeKernel<int32_t>; break;
+            case PlcValueType::REAL: kernel = &extremeKernel<float>; break;
+            default: kernel = nullptr; break;
+        }
+        return true;
+    }
+
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input, output_var, index_var);
+        }
+    }
+
+protected:
+    PlcArrayRef input;
+    VarHandle output_var;
+    VarHandle index_var;
+
+private:
+    typedef void (*Kernel)(PlcMemory& memory, const PlcArrayRef& input, VarHandle output, VarHandle index);
+    Kernel kernel; // nullptr while not configured
+
+    template<typename T>
+    static void extremeKernel(PlcMemory& memory, const PlcArrayRef& input, VarHandle output, VarHandle index) {
+        T value;
+        uint16_t position = PlcArrayOps::extreme<Op>(memory.arrayData<T>(input), input.length, value);
+        memory.setValue<T>(output, value);
+        memory.setValue<int16_t>(index, static_cast<int16_t>(position));
+    }
+};
+
+#endif // PLC_ARRAY_EXTREME_BLOCK_H
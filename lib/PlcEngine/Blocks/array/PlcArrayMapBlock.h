@@ -0,0 +1,55 @@
+#ifndef PLC_ARRAY_MAP_BLOCK_H
+#define PLC_ARRAY_MAP_BLOCK_H
+
+#include "PlcArrayBlock.h"
+
+/**
+ * PlcArrayMapBlock - element-wise operation on two arrays (ARRAY_ADD,
+ * ARRAY_MUL): out[i] = in1[i] op in2[i]. All three arrays have the same
+ * length and element type; "out" may be one of the inputs.
+ */
+template<class Op>
+class PlcArrayMapBlock : public PlcArrayBlock {
+public:
+    PlcArrayMapBlock() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override {
+        if (!bindArray(memory, Op::NAME, config["inputs"]["in1"], false, input1) ||
+            !bindArray(memory, Op::NAME, config["inputs"]["in2"], false, input2) ||
+            !bindArray(memory, Op::NAME, config["outputs"]["out"], true, output) ||
+            !sameShape(Op::NAME, input1, input2) || !sameShape(Op::NAME, input1, output)) {
+            return false;
+        }
+        switch (input1.type) {
+            case PlcValueType::INT: kernel = &mapKernel<int16_t>; break;
+            case PlcValueType::DINT: kernel = &mapKernel<int32_t>; break;
+            case PlcValueType::REAL: kernel = &mapKernel<float>; break;
+            default: kernel = nullptr; break;
+        }
+        return true;
+    }
+
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input1, input2, output);
+        }
+    }
+
+protected:
+    PlcArrayRef input1;
+    PlcArrayRef input2;
+    PlcArrayRef output;
+
+private:
+    typedef void (*Kernel)(PlcMemory& memory, const PlcArrayRef& in1, const PlcArrayRef& in2, const PlcArrayRef& out);
+    Kernel kernel; // nullptr while not configured
+
+    template<typename T>
+    static void mapKernel(PlcMemory& memory, const PlcArrayRef& in1, const PlcArrayRef& in2, const PlcArrayRef& out) {
+        const T* a = memory.arrayData<T>(in1);
+        const T* b = memory.arrayData<T>(in2);
+        writeElements<T>(memory, out, [a, b](uint16_t i) { return Op::apply(a[i], b[i]); });
+    }
+};
+
+#endif // PLC_ARRAY_MAP_BLOCK_H
@@ -0,0 +1,142 @@
+#ifndef PLC_ARRAY_WORD_BLOCK_H
+#define PLC_ARRAY_WORD_BLOCK_H
+
+#include "PlcArrayBlock.h"
+
+namespace PlcArrayOps {
+
+// Operations of the BOOL array blocks, on 32 elements at a time
+
+struct And {
+    static constexpr const char* NAME = "ARRAY_AND";
+    static constexpr PlcWordOp OP = PlcWordOp::AND;
+};
+
+struct Or {
+    static constexpr const char* NAME = "ARRAY_OR";
+    static constexpr PlcWordOp OP = PlcWordOp::OR;
+};
+
+struct Xor {
+    static constexpr const char* NAME = "ARRAY_XOR";
+    static constexpr PlcWordOp OP = PlcWordOp::XOR;
+};
+
+struct Not {
+    static constexpr const char* NAME = "ARRAY_NOT";
+    static constexpr PlcWordOp OP = PlcWordOp::NOT;
+};
+
+struct Rising {
+    static constexpr const char* NAME = "ARRAY_R_TRIG";
+    static inline uint32_t edges(uint32_t before, uint32_t now) { return now & ~before; }
+};
+
+struct Falling {
+    static constexpr const char* NAME = "ARRAY_F_TRIG";
+    static inline uint32_t edges(uint32_t before, uint32_t now) { return before & ~now; }
+};
+
+} // namespace PlcArrayOps
+
+/**
+ * PlcArrayWordBlock - logic operation on BOOL arrays (ARRAY_AND, ARRAY_OR,
+ * ARRAY_XOR, ARRAY_NOT), 32 elements per marker word: out[i] = in1[i] op
+ * in2[i], or NOT in[i]. All arrays have the same length; "out" may be one
+ * of the inputs.
+ */
+template<class Op>
+class PlcArrayWordBlock : public PlcArrayBlock {
+public:
+    PlcArrayWordBlock() : word1(0), word2(0), wordOut(0) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override {
+        bool unary = Op::OP == PlcWordOp::NOT;
+        if (!bindBoolArray(memory, Op::NAME, config["inputs"][unary ? "in" : "in1"], false, input1) ||
+            (!unary && !bindBoolArray(memory, Op::NAME, config["inputs"]["in2"], false, input2)) ||
+            !bindBoolArray(memory, Op::NAME, config["outputs"]["out"], true, output) ||
+            (!unary && !sameShape(Op::NAME, input1, input2)) || !sameShape(Op::NAME, input1, output)) {
+            return false;
+        }
+        if (unary) {
+            input2 = input1;
+        }
+        word1 = memory.getArrayWord(input1);
+        word2 = memory.getArrayWord(input2);
+        wordOut = memory.getArrayWord(output);
+        return true;
+    }
+
+    void evaluate(PlcMemory& memory) override {
+        uint16_t words = wordCount(output);
+        for (uint16_t w = 0; w < words; w++) {
+            uint32_t value = applyWordOp(Op::OP, memory.loadWord(word1 + w), memory.loadWord(word2 + w));
+            memory.storeWord(wordOut + w, value, wordMask(output, w));
+        }
+    }
+
+private:
+    PlcArrayRef input1;
+    PlcArrayRef input2;
+    PlcArrayRef output;
+    uint16_t word1;
+    uint16_t word2;
+    uint16_t wordOut;
+};
+
+// Edge detection on every element of a BOOL array (ARRAY_R_TRIG,
+// ARRAY_F_TRIG): q[i] is TRUE for one scan after in[i] rose (fell). The
+// previous input words are the state of the block.
+template<class Op>
+class PlcArrayEdgeBlock : public PlcArrayBlock {
+public:
+    PlcArrayEdgeBlock() : wordIn(0), wordOut(0), pulse(false) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override {
+        if (!bindBoolArray(memory, Op::NAME, config["inputs"]["in"], false, input) ||
+            !bindBoolArray(memory, Op::NAME, config["outputs"]["q"], true, output) ||
+            !sameShape(Op::NAME, input, output)) {
+            return false;
+        }
+        wordIn = memory.getArrayWord(input);
+        wordOut = memory.getArrayWord(output);
+        PlcArenaVector<uint32_t>(wordCount(input), 0, PlcArenaAllocator<uint32_t>(arena)).swap(previous);
+        return true;
+    }
+
+    void evaluate(PlcMemory& memory) override {
+        uint32_t any = 0;
+        for (uint16_t w = 0; w < previous.size(); w++) {
+            uint32_t now = memory.loadWord(wordIn + w);
+            uint32_t edges = Op::edges(previous[w], now) & wordMask(input, w);
+            previous[w] = now;
+            memory.storeWord(wordOut + w, edges, wordMask(output, w));
+            any |= edges;
+        }
+        pulse = any != 0;
+    }
+
+    // The pulse ends on the next scan whether or not an input changes
+    bool isAlwaysLive() const override { return true; }
+    bool needsScan() const override { return pulse; }
+    bool hasState() const override { return true; } // Previous input words
+
+    void migrateState(const PlcBlock& previousBlock) override {
+        const PlcArrayEdgeBlock& old = static_cast<const PlcArrayEdgeBlock&>(previousBlock);
+        if (old.previous.size() == previous.size()) {
+            for (size_t w = 0; w < previous.size(); w++) {
+                previous[w] = old.previous[w];
+            }
+        }
+    }
+
+private:
+    PlcArrayRef input;
+    PlcArrayRef output;
+    uint16_t wordIn;
+    uint16_t wordOut;
+    PlcArenaVector<uint32_t> previous;
+    bool pulse;
+};
+
+#endif // PLC_ARRAY_WORD_BLOCK_H
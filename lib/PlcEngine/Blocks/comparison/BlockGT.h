@@ -1,19 +1,16 @@
 #ifndef PLC_BLOCK_GT_H
 #define PLC_BLOCK_GT_H
 
-#include "../PlcBlock.h"
-#include <string>
+#include "PlcCompareBlock.h"
 
-class BlockGT : public PlcBlock {
+class BlockGT : public PlcCompareBlock<PlcOpGt> {
 public:
-    bool configure(const JsonObject& config, PlcMemory& memory) override;
-    void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    static constexpr const char* TYPE = "GT";
+    static const PlcBlockDescriptor DESCRIPTOR;
 
 private:
-    std::string input1_var;
-    std::string input2_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
 };
 
 #endif // PLC_BLOCK_GT_H
\ No newline at end of file
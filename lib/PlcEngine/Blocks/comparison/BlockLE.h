@@ -1,19 +1,16 @@
 #ifndef PLC_BLOCK_LE_H
 #define PLC_BLOCK_LE_H
 
-#include "../PlcBlock.h"
-#include <string>
+#include "PlcCompareBlock.h"
 
-class BlockLE : public PlcBlock {
+class BlockLE : public PlcCompareBlock<PlcOpLe> {
 public:
-    bool configure(const JsonObject& config, PlcMemory& memory) override;
-    void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    static constexpr const char* TYPE = "LE";
+    static const PlcBlockDescriptor DESCRIPTOR;
 
 private:
-    std::string input1_var;
-    std::string input2_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
 };
 
 #endif // PLC_BLOCK_LE_H
\ No newline at end of file
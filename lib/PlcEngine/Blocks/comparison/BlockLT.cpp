@@ -1,33 +1,5 @@
 #include "BlockLT.h"
 
-bool BlockLT::configure(const JsonObject& config, PlcMemory& memory) {
-    if (config.containsKey("inputs")) {
-        input1_var = config["inputs"]["in1"].as<std::string>();
-        input2_var = config["inputs"]["in2"].as<std::string>();
-    }
-    if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
-    }
-    return true; // Basic validation for now
-}
-
-void BlockLT::evaluate(PlcMemory& memory) {
-    if (input1_var.empty() || input2_var.empty() || output_var.empty()) {
-        return; // Not configured
-    }
-
-    // Assuming float comparison for now, can be extended with type checking
-    float in1_val = memory.getValue<float>(input1_var, 0.0f);
-    float in2_val = memory.getValue<float>(input2_var, 0.0f);
-
-    memory.setValue<bool>(output_var, in1_val < in2_val);
-}
-
-JsonDocument BlockLT::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Less Than comparison block";
-    schema["inputs"]["in1"]["type"] = "float";
-    schema["inputs"]["in2"]["type"] = "float";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockLT::INPUTS[] = {{"in1", "float"}, {"in2", "float"}, {}};
+const PlcPinInfo BlockLT::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockLT::DESCRIPTOR = {"comparison", "Less Than comparison block", INPUTS, OUTPUTS};
@@ -1,19 +1,16 @@
 #ifndef PLC_BLOCK_LT_H
 #define PLC_BLOCK_LT_H
 
-#include "../PlcBlock.h"
-#include <string>
+#include "PlcCompareBlock.h"
 
-class BlockLT : public PlcBlock {
+class BlockLT : public PlcCompareBlock<PlcOpLt> {
 public:
-    bool configure(const JsonObject& config, PlcMemory& memory) override;
-    void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    static constexpr const char* TYPE = "LT";
+    static const PlcBlockDescriptor DESCRIPTOR;
 
 private:
-    std::string input1_var;
-    std::string input2_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
 };
 
 #endif // PLC_BLOCK_LT_H
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef PLC_COMPARE_BLOCK_H
+#define PLC_COMPARE_BLOCK_H
+
+#include "../PlcBlock.h"
+#include "../../Engine/PlcTypeCheck.h"
+#include "../../Engine/PlcTypedOps.h"
+
+/**
+ * PlcCompareBlock - comparison of two numbers (GT, GE, LT, LE, EQ, NE).
+ *
+ * Like PlcArithBlock, the kernel is chosen in configure(): both inputs
+ * declared INT, DINT or REAL and a BOOL output compare in that type,
+ * anything else compares the values converted to REAL.
+ */
+template<class Op>
+class PlcCompareBlock : public PlcBlock {
+public:
+    PlcCompareBlock() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override {
+        if (config.containsKey("inputs")) {
+            PlcValueType type;
+            if (!PlcTypeCheck::resolveInputs(memory, Op::NAME, config["inputs"], type)) {
+                return false;
+            }
+            PlcValueType declareAs = PlcTypeCheck::declarationType(memory, type);
+            input1_var = bindInput(memory, config["inputs"]["in1"], declareAs);
+            input2_var = bindInput(memory, config["inputs"]["in2"], declareAs);
+        }
+        if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
+            output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
+            if (!PlcTypeCheck::checkOutput(memory, Op::NAME, output_var, PlcValueType::BOOL)) {
+                return false;
+            }
+        }
+        kernel = selectKernel();
+        return true;
+    }
+
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input1_var, input2_var, output_var);
+        }
+    }
+
+    bool lower(PlcBytecode& code) override {
+        return code.emitBinary(Op::OPCODE, output_var, input1_var, input2_var);
+    }
+
+protected:
+    VarHandle input1_var;
+    VarHandle input2_var;
+    VarHandle output_var;
+
+private:
+    typedef void (*Kernel)(PlcMemory& memory, VarHandle in1, VarHandle in2, VarHandle output);
+    Kernel kernel; // nullptr while not configured
+
+    Kernel selectKernel() const {
+        if (!input1_var.isValid() || !input2_var.isValid() || !output_var.isValid()) {
+            return nullptr;
+        }
+        if (output_var.type == PlcValueType::BOOL && PlcTypeCheck::isUniform(input1_var, input2_var, input1_var.type)) {
+            switch (input1_var.type) {
+                case PlcValueType::INT: return &typedKernel<int16_t>;
+                case PlcValueType::DINT: return &typedKernel<int32_t>;
+                case PlcValueType::REAL: return &typedKernel<float>;
+                default: break;
+            }
+        }
+        return &convertingKernel;
+    }
+
+    template<typename T>
+    static void typedKernel(PlcMemory& memory, VarHandle in1, VarHandle in2, VarHandle output) {
+        memory.setTyped<bool>(output, Op::test(memory.getTyped<T>(in1), memory.getTyped<T>(in2)));
+    }
+
+    static void convertingKernel(PlcMemory& memory, VarHandle in1, VarHandle in2, VarHandle output) {
+        memory.setValue<bool>(output, Op::test(memory.getValue<float>(in1, 0.0f), memory.getValue<float>(in2, 0.0f)));
+    }
+};
+
+#endif // PLC_COMPARE_BLOCK_H
@@ -1,23 +1,79 @@
 #include "BlockBoolArrayToInt8.h"
 
+BlockBoolArrayToInt8::BlockBoolArrayToInt8() : run_word(0), run_bit(0), run_length(0) {
+}
+
 bool BlockBoolArrayToInt8::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        JsonArray inputs = config["inputs"].as<JsonArray>();
-        for (JsonVariant v : inputs) {
-            input_vars.push_back(v.as<std::string>());
+        // "in" may name a BOOL array, whose first 8 elements are the bits
+        const char* arrayName = config["inputs"]["in"].as<const char*>();
+        if (arrayName != nullptr && memory.findArray(arrayName).isValid()) {
+            if (!bindArrayElements(memory, arrayName)) {
+                return false;
+            }
+        } else {
+            bindInputs(memory, config["inputs"], PlcValueType::BOOL, input_vars);
         }
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BYTE);
     }
+    findBitRun(memory);
     return true; // Basic validation for now
 }
 
+bool BlockBoolArrayToInt8::bindArrayElements(PlcMemory& memory, const char* name) {
+    PlcArrayRef array = memory.findArray(name);
+    if (array.type != PlcValueType::BOOL) {
+        EspHubLog->printf("ERROR: %s: '%s' is not an array of bool\n", TYPE, name);
+        return false;
+    }
+    uint16_t count = array.length < 8 ? array.length : 8;
+    PlcHandleList(PlcArenaAllocator<VarHandle>(arena)).swap(input_vars);
+    input_vars.reserve(count);
+    std::string element;
+    for (uint16_t i = 0; i < count; i++) {
+        element = std::string(name) + "[" + std::to_string(i) + "]";
+        input_vars.push_back(bindInputName(memory, element.c_str(), PlcValueType::BOOL));
+    }
+    return true;
+}
+
+void BlockBoolArrayToInt8::findBitRun(const PlcMemory& memory) {
+    run_length = 0;
+    if (input_vars.empty() || input_vars.size() > 8) {
+        return;
+    }
+    PlcBitRef first = memory.getBitRef(input_vars[0]);
+    if (!first.isValid()) {
+        return;
+    }
+    uint32_t start = (static_cast<uint32_t>(first.word) << 5) + first.bit();
+    for (size_t i = 1; i < input_vars.size(); i++) {
+        PlcBitRef ref = memory.getBitRef(input_vars[i]);
+        if (!ref.isValid() || (static_cast<uint32_t>(ref.word) << 5) + ref.bit() != start + i) {
+            return;
+        }
+    }
+    run_word = first.word;
+    run_bit = first.bit();
+    run_length = static_cast<uint8_t>(input_vars.size());
+}
+
 void BlockBoolArrayToInt8::evaluate(PlcMemory& memory) {
-    if (output_var.empty() || input_vars.empty()) {
+    if (!output_var.isValid() || input_vars.empty()) {
         return; // Not configured
     }
 
+    if (run_length > 0) {
+        uint64_t bits = memory.loadWord(run_word);
+        if (run_bit + run_length > 32) {
+            bits |= static_cast<uint64_t>(memory.loadWord(run_word + 1)) << 32;
+        }
+        memory.setValue<int8_t>(output_var, static_cast<int8_t>((bits >> run_bit) & ((1u << run_length) - 1)));
+        return;
+    }
+
     int8_t result = 0;
     for (size_t i = 0; i < input_vars.size() && i < 8; ++i) {
         if (memory.getValue<bool>(input_vars[i], false)) {
@@ -27,11 +83,10 @@ void BlockBoolArrayToInt8::evaluate(PlcMemory& memory) {
     memory.setValue<int8_t>(output_var, result);
 }
 
-JsonDocument BlockBoolArrayToInt8::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Converts an array of up to 8 booleans to an int8_t";
-    schema["inputs"]["in"]["type"] = "array";
-    schema["inputs"]["in"]["items"]["type"] = "bool";
-    schema["outputs"]["out"]["type"] = "int8";
-    return schema;
-}
\ No newline at end of file
+bool BlockBoolArrayToInt8::lower(PlcBytecode& code) {
+    return code.emitNary(PlcOpcode::PACK_B8, output_var, input_vars);
+}
+
+const PlcPinInfo BlockBoolArrayToInt8::INPUTS[] = {{"in", "bool[]"}, {}};
+const PlcPinInfo BlockBoolArrayToInt8::OUTPUTS[] = {{"out", "int8"}, {}};
+const PlcBlockDescriptor BlockBoolArrayToInt8::DESCRIPTOR = {"conversion", "Converts an array of up to 8 booleans to an int8_t", INPUTS, OUTPUTS};
@@ -2,18 +2,37 @@
 #define PLC_BLOCK_BOOL_ARRAY_TO_INT8_H
 
 #include "../PlcBlock.h"
+#include <StreamLogger.h>
 #include <string>
 #include <vector>
 
+extern StreamLogger* EspHubLog;
+
 class BlockBoolArrayToInt8 : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "BOOL_ARRAY_TO_INT8";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    BlockBoolArrayToInt8();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
 
 private:
-    std::vector<std::string> input_vars; // Array of boolean variable names
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    PlcHandleList input_vars; // Array of boolean variable names
+    VarHandle output_var;
+
+    // Inputs that are consecutive bits of the marker words (elements of a
+    // BOOL array, BOOLs declared one after the other) are read as one run
+    uint16_t run_word;
+    uint8_t run_bit;
+    uint8_t run_length; // 0: read input by input
+
+    bool bindArrayElements(PlcMemory& memory, const char* name);
+    void findBitRun(const PlcMemory& memory);
 };
 
 #endif // PLC_BLOCK_BOOL_ARRAY_TO_INT8_H
\ No newline at end of file
@@ -2,16 +2,16 @@
 
 bool BlockInt16ToFloat::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::INT);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::REAL);
     }
     return true; // Basic validation for now
 }
 
 void BlockInt16ToFloat::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -19,10 +19,20 @@ void BlockInt16ToFloat::evaluate(PlcMemory& memory) {
     memory.setValue<float>(output_var, static_cast<float>(in_val));
 }
 
-JsonDocument BlockInt16ToFloat::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Converts int16_t to float";
-    schema["inputs"]["in"]["type"] = "int16";
-    schema["outputs"]["out"]["type"] = "float";
-    return schema;
-}
\ No newline at end of file
+bool BlockInt16ToFloat::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::I16_TO_R, output_var, input_var);
+}
+
+bool BlockInt16ToFloat::redirectOutput(uint16_t from, VarHandle to) {
+    // The float is stored exactly
+    if (from != output_var.index || output_var.type != PlcValueType::REAL) {
+        return false;
+    }
+    output_var = to;
+    replaceOutputSlot(from, to.index);
+    return true;
+}
+
+const PlcPinInfo BlockInt16ToFloat::INPUTS[] = {{"in", "int16"}, {}};
+const PlcPinInfo BlockInt16ToFloat::OUTPUTS[] = {{"out", "float"}, {}};
+const PlcBlockDescriptor BlockInt16ToFloat::DESCRIPTOR = {"conversion", "Converts int16_t to float", INPUTS, OUTPUTS};
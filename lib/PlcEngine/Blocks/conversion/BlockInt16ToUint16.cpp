@@ -2,16 +2,16 @@
 
 bool BlockInt16ToUint16::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::INT);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
 
 void BlockInt16ToUint16::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -19,10 +19,20 @@ void BlockInt16ToUint16::evaluate(PlcMemory& memory) {
     memory.setValue<uint16_t>(output_var, static_cast<uint16_t>(in_val));
 }
 
-JsonDocument BlockInt16ToUint16::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Converts int16_t to uint16_t";
-    schema["inputs"]["in"]["type"] = "int16";
-    schema["outputs"]["out"]["type"] = "uint16";
-    return schema;
-}
\ No newline at end of file
+bool BlockInt16ToUint16::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::I16_TO_U16, output_var, input_var);
+}
+
+bool BlockInt16ToUint16::redirectOutput(uint16_t from, VarHandle to) {
+    // The uint16 is stored as the int16 with the same bits, so only an INT target converts the same way
+    if (from != output_var.index || output_var.type != PlcValueType::INT || to.type != PlcValueType::INT) {
+        return false;
+    }
+    output_var = to;
+    replaceOutputSlot(from, to.index);
+    return true;
+}
+
+const PlcPinInfo BlockInt16ToUint16::INPUTS[] = {{"in", "int16"}, {}};
+const PlcPinInfo BlockInt16ToUint16::OUTPUTS[] = {{"out", "uint16"}, {}};
+const PlcBlockDescriptor BlockInt16ToUint16::DESCRIPTOR = {"conversion", "Converts int16_t to uint16_t", INPUTS, OUTPUTS};
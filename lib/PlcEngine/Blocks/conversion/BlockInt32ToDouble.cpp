@@ -2,16 +2,16 @@
 
 bool BlockInt32ToDouble::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::DINT);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::REAL);
     }
     return true; // Basic validation for now
 }
 
 void BlockInt32ToDouble::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -19,10 +19,20 @@ void BlockInt32ToDouble::evaluate(PlcMemory& memory) {
     memory.setValue<double>(output_var, static_cast<double>(in_val));
 }
 
-JsonDocument BlockInt32ToDouble::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Converts int32_t to double";
-    schema["inputs"]["in"]["type"] = "int32";
-    schema["outputs"]["out"]["type"] = "double";
-    return schema;
-}
\ No newline at end of file
+bool BlockInt32ToDouble::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::I32_TO_R, output_var, input_var);
+}
+
+bool BlockInt32ToDouble::redirectOutput(uint16_t from, VarHandle to) {
+    // The double is rounded to float when stored, so only a REAL target converts the same way
+    if (from != output_var.index || output_var.type != PlcValueType::REAL || to.type != PlcValueType::REAL) {
+        return false;
+    }
+    output_var = to;
+    replaceOutputSlot(from, to.index);
+    return true;
+}
+
+const PlcPinInfo BlockInt32ToDouble::INPUTS[] = {{"in", "int32"}, {}};
+const PlcPinInfo BlockInt32ToDouble::OUTPUTS[] = {{"out", "double"}, {}};
+const PlcBlockDescriptor BlockInt32ToDouble::DESCRIPTOR = {"conversion", "Converts int32_t to double", INPUTS, OUTPUTS};
@@ -6,13 +6,21 @@
 
 class BlockInt32ToDouble : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "INT32_TO_DOUBLE";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
+    bool isPassThrough() const override { return input_var.type == PlcValueType::DINT && output_var.type == PlcValueType::REAL; }
+    bool redirectOutput(uint16_t from, VarHandle to) override;
 
 private:
-    std::string input_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_var;
+    VarHandle output_var;
 };
 
 #endif // PLC_BLOCK_INT32_TO_DOUBLE_H
\ No newline at end of file
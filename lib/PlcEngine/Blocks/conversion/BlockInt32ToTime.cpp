@@ -2,18 +2,18 @@
 
 bool BlockInt32ToTime::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::DINT);
     }
     if (config.containsKey("outputs")) {
-        output_var_hour = config["outputs"]["hour"].as<std::string>();
-        output_var_minute = config["outputs"]["minute"].as<std::string>();
-        output_var_second = config["outputs"]["second"].as<std::string>();
+        output_var_hour = bindOutput(memory, config["outputs"]["hour"], PlcValueType::INT);
+        output_var_minute = bindOutput(memory, config["outputs"]["minute"], PlcValueType::INT);
+        output_var_second = bindOutput(memory, config["outputs"]["second"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
 
 void BlockInt32ToTime::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var_hour.empty() || output_var_minute.empty() || output_var_second.empty()) {
+    if (!input_var.isValid() || !output_var_hour.isValid() || !output_var_minute.isValid() || !output_var_second.isValid()) {
         return; // Not configured
     }
 
@@ -26,12 +26,6 @@ void BlockInt32ToTime::evaluate(PlcMemory& memory) {
     memory.setValue<int16_t>(output_var_second, timeinfo.tm_sec);
 }
 
-JsonDocument BlockInt32ToTime::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Converts Unix timestamp (int32_t) to hour, minute, second";
-    schema["inputs"]["in"]["type"] = "int32";
-    schema["outputs"]["hour"]["type"] = "int16";
-    schema["outputs"]["minute"]["type"] = "int16";
-    schema["outputs"]["second"]["type"] = "int16";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockInt32ToTime::INPUTS[] = {{"in", "int32"}, {}};
+const PlcPinInfo BlockInt32ToTime::OUTPUTS[] = {{"hour", "int16"}, {"minute", "int16"}, {"second", "int16"}, {}};
+const PlcBlockDescriptor BlockInt32ToTime::DESCRIPTOR = {"conversion", "Converts Unix timestamp (int32_t) to hour, minute, second", INPUTS, OUTPUTS};
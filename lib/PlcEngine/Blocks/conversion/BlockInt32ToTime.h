@@ -6,15 +6,20 @@
 
 class BlockInt32ToTime : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "INT32_TO_TIME";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
 
 private:
-    std::string input_var;
-    std::string output_var_hour;
-    std::string output_var_minute;
-    std::string output_var_second;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_var;
+    VarHandle output_var_hour;
+    VarHandle output_var_minute;
+    VarHandle output_var_second;
 };
 
 #endif // PLC_BLOCK_INT32_TO_TIME_H
\ No newline at end of file
@@ -2,16 +2,16 @@
 
 bool BlockInt8ToInt16::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::BYTE);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
 
 void BlockInt8ToInt16::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -19,10 +19,20 @@ void BlockInt8ToInt16::evaluate(PlcMemory& memory) {
     memory.setValue<int16_t>(output_var, static_cast<int16_t>(in_val));
 }
 
-JsonDocument BlockInt8ToInt16::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Converts int8_t to int16_t";
-    schema["inputs"]["in"]["type"] = "int8";
-    schema["outputs"]["out"]["type"] = "int16";
-    return schema;
-}
\ No newline at end of file
+bool BlockInt8ToInt16::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::I8_TO_I16, output_var, input_var);
+}
+
+bool BlockInt8ToInt16::redirectOutput(uint16_t from, VarHandle to) {
+    // The int16 is stored exactly
+    if (from != output_var.index || output_var.type != PlcValueType::INT) {
+        return false;
+    }
+    output_var = to;
+    replaceOutputSlot(from, to.index);
+    return true;
+}
+
+const PlcPinInfo BlockInt8ToInt16::INPUTS[] = {{"in", "int8"}, {}};
+const PlcPinInfo BlockInt8ToInt16::OUTPUTS[] = {{"out", "int16"}, {}};
+const PlcBlockDescriptor BlockInt8ToInt16::DESCRIPTOR = {"conversion", "Converts int8_t to int16_t", INPUTS, OUTPUTS};
@@ -6,13 +6,20 @@
 
 class BlockInt8ToInt16 : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "INT8_TO_INT16";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
+    bool redirectOutput(uint16_t from, VarHandle to) override;
 
 private:
-    std::string input_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_var;
+    VarHandle output_var;
 };
 
 #endif // PLC_BLOCK_INT8_TO_INT16_H
\ No newline at end of file
@@ -2,16 +2,16 @@
 
 bool BlockInt8ToUint8::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::BYTE);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BYTE);
     }
     return true; // Basic validation for now
 }
 
 void BlockInt8ToUint8::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -19,10 +19,20 @@ void BlockInt8ToUint8::evaluate(PlcMemory& memory) {
     memory.setValue<uint8_t>(output_var, static_cast<uint8_t>(in_val));
 }
 
-JsonDocument BlockInt8ToUint8::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Converts int8_t to uint8_t";
-    schema["inputs"]["in"]["type"] = "int8";
-    schema["outputs"]["out"]["type"] = "uint8";
-    return schema;
-}
\ No newline at end of file
+bool BlockInt8ToUint8::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::I8_TO_U8, output_var, input_var);
+}
+
+bool BlockInt8ToUint8::redirectOutput(uint16_t from, VarHandle to) {
+    // The uint8 is stored exactly
+    if (from != output_var.index || output_var.type != PlcValueType::BYTE) {
+        return false;
+    }
+    output_var = to;
+    replaceOutputSlot(from, to.index);
+    return true;
+}
+
+const PlcPinInfo BlockInt8ToUint8::INPUTS[] = {{"in", "int8"}, {}};
+const PlcPinInfo BlockInt8ToUint8::OUTPUTS[] = {{"out", "uint8"}, {}};
+const PlcBlockDescriptor BlockInt8ToUint8::DESCRIPTOR = {"conversion", "Converts int8_t to uint8_t", INPUTS, OUTPUTS};
@@ -6,13 +6,21 @@
 
 class BlockInt8ToUint8 : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "INT8_TO_UINT8";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
+    bool isPassThrough() const override { return input_var.type == PlcValueType::BYTE && output_var.type == PlcValueType::BYTE; }
+    bool redirectOutput(uint16_t from, VarHandle to) override;
 
 private:
-    std::string input_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_var;
+    VarHandle output_var;
 };
 
 #endif // PLC_BLOCK_INT8_TO_UINT8_H
\ No newline at end of file
@@ -5,13 +5,13 @@ BlockCTD::BlockCTD() : last_cd_state(false) {
 
 bool BlockCTD::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        cd_var = config["inputs"]["cd"].as<std::string>();
-        load_var = config["inputs"]["load"].as<std::string>();
-        pv_var = config["inputs"]["pv"].as<std::string>();
+        cd_var = bindInput(memory, config["inputs"]["cd"], PlcValueType::BOOL);
+        load_var = bindInput(memory, config["inputs"]["load"], PlcValueType::BOOL);
+        pv_var = bindInput(memory, config["inputs"]["pv"], PlcValueType::INT);
     }
     if (config.containsKey("outputs")) {
-        q_var = config["outputs"]["q"].as<std::string>();
-        cv_var = config["outputs"]["cv"].as<std::string>();
+        q_var = bindOutput(memory, config["outputs"]["q"], PlcValueType::BOOL);
+        cv_var = bindOutput(memory, config["outputs"]["cv"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
@@ -36,13 +36,11 @@ void BlockCTD::evaluate(PlcMemory& memory) {
     last_cd_state = cd;
 }
 
-JsonDocument BlockCTD::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Count Down block";
-    schema["inputs"]["cd"]["type"] = "bool";
-    schema["inputs"]["load"]["type"] = "bool";
-    schema["inputs"]["pv"]["type"] = "int";
-    schema["outputs"]["q"]["type"] = "bool";
-    schema["outputs"]["cv"]["type"] = "int";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockCTD::INPUTS[] = {{"cd", "bool"}, {"load", "bool"}, {"pv", "int"}, {}};
+const PlcPinInfo BlockCTD::OUTPUTS[] = {{"q", "bool"}, {"cv", "int"}, {}};
+const PlcBlockDescriptor BlockCTD::DESCRIPTOR = {"counters", "Count Down block", INPUTS, OUTPUTS};
+
+void BlockCTD::migrateState(const PlcBlock& previous) {
+    const BlockCTD& old = static_cast<const BlockCTD&>(previous);
+    last_cd_state = old.last_cd_state;
+}
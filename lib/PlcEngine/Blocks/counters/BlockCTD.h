@@ -6,17 +6,24 @@
 
 class BlockCTD : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "CTD";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockCTD();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    bool hasState() const override { return true; } // Edge memory
 
 private:
-    std::string cd_var;      // Count Down input
-    std::string load_var;    // Load input
-    std::string pv_var;      // Preset Value input
-    std::string q_var;       // Output
-    std::string cv_var;      // Current Value output
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle cd_var;      // Count Down input
+    VarHandle load_var;    // Load input
+    VarHandle pv_var;      // Preset Value input
+    VarHandle q_var;       // Output
+    VarHandle cv_var;      // Current Value output
 
     bool last_cd_state;
 };
@@ -5,13 +5,13 @@ BlockCTU::BlockCTU() : last_cu_state(false) {
 
 bool BlockCTU::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        cu_var = config["inputs"]["cu"].as<std::string>();
-        reset_var = config["inputs"]["reset"].as<std::string>();
-        pv_var = config["inputs"]["pv"].as<std::string>();
+        cu_var = bindInput(memory, config["inputs"]["cu"], PlcValueType::BOOL);
+        reset_var = bindInput(memory, config["inputs"]["reset"], PlcValueType::BOOL);
+        pv_var = bindInput(memory, config["inputs"]["pv"], PlcValueType::INT);
     }
     if (config.containsKey("outputs")) {
-        q_var = config["outputs"]["q"].as<std::string>();
-        cv_var = config["outputs"]["cv"].as<std::string>();
+        q_var = bindOutput(memory, config["outputs"]["q"], PlcValueType::BOOL);
+        cv_var = bindOutput(memory, config["outputs"]["cv"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
@@ -36,13 +36,11 @@ void BlockCTU::evaluate(PlcMemory& memory) {
     last_cu_state = cu;
 }
 
-JsonDocument BlockCTU::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Count Up block";
-    schema["inputs"]["cu"]["type"] = "bool";
-    schema["inputs"]["reset"]["type"] = "bool";
-    schema["inputs"]["pv"]["type"] = "int";
-    schema["outputs"]["q"]["type"] = "bool";
-    schema["outputs"]["cv"]["type"] = "int";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockCTU::INPUTS[] = {{"cu", "bool"}, {"reset", "bool"}, {"pv", "int"}, {}};
+const PlcPinInfo BlockCTU::OUTPUTS[] = {{"q", "bool"}, {"cv", "int"}, {}};
+const PlcBlockDescriptor BlockCTU::DESCRIPTOR = {"counters", "Count Up block", INPUTS, OUTPUTS};
+
+void BlockCTU::migrateState(const PlcBlock& previous) {
+    const BlockCTU& old = static_cast<const BlockCTU&>(previous);
+    last_cu_state = old.last_cu_state;
+}
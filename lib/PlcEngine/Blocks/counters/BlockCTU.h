@@ -6,17 +6,24 @@
 
 class BlockCTU : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "CTU";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockCTU();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    bool hasState() const override { return true; } // Edge memory
 
 private:
-    std::string cu_var;      // Count Up input
-    std::string reset_var;   // Reset input
-    std::string pv_var;      // Preset Value input
-    std::string q_var;       // Output
-    std::string cv_var;      // Current Value output
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle cu_var;      // Count Up input
+    VarHandle reset_var;   // Reset input
+    VarHandle pv_var;      // Preset Value input
+    VarHandle q_var;       // Output
+    VarHandle cv_var;      // Current Value output
 
     bool last_cu_state;
 };
@@ -5,16 +5,16 @@ BlockCTUD::BlockCTUD() : last_cu_state(false), last_cd_state(false) {
 
 bool BlockCTUD::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        cu_var = config["inputs"]["cu"].as<std::string>();
-        cd_var = config["inputs"]["cd"].as<std::string>();
-        reset_var = config["inputs"]["reset"].as<std::string>();
-        load_var = config["inputs"]["load"].as<std::string>();
-        pv_var = config["inputs"]["pv"].as<std::string>();
+        cu_var = bindInput(memory, config["inputs"]["cu"], PlcValueType::BOOL);
+        cd_var = bindInput(memory, config["inputs"]["cd"], PlcValueType::BOOL);
+        reset_var = bindInput(memory, config["inputs"]["reset"], PlcValueType::BOOL);
+        load_var = bindInput(memory, config["inputs"]["load"], PlcValueType::BOOL);
+        pv_var = bindInput(memory, config["inputs"]["pv"], PlcValueType::INT);
     }
     if (config.containsKey("outputs")) {
-        qu_var = config["outputs"]["qu"].as<std::string>();
-        qd_var = config["outputs"]["qd"].as<std::string>();
-        cv_var = config["outputs"]["cv"].as<std::string>();
+        qu_var = bindOutput(memory, config["outputs"]["qu"], PlcValueType::BOOL);
+        qd_var = bindOutput(memory, config["outputs"]["qd"], PlcValueType::BOOL);
+        cv_var = bindOutput(memory, config["outputs"]["cv"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
@@ -52,16 +52,12 @@ void BlockCTUD::evaluate(PlcMemory& memory) {
     last_cd_state = cd;
 }
 
-JsonDocument BlockCTUD::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Count Up/Down block";
-    schema["inputs"]["cu"]["type"] = "bool";
-    schema["inputs"]["cd"]["type"] = "bool";
-    schema["inputs"]["reset"]["type"] = "bool";
-    schema["inputs"]["load"]["type"] = "bool";
-    schema["inputs"]["pv"]["type"] = "int";
-    schema["outputs"]["qu"]["type"] = "bool";
-    schema["outputs"]["qd"]["type"] = "bool";
-    schema["outputs"]["cv"]["type"] = "int";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockCTUD::INPUTS[] = {{"cu", "bool"}, {"cd", "bool"}, {"reset", "bool"}, {"load", "bool"}, {"pv", "int"}, {}};
+const PlcPinInfo BlockCTUD::OUTPUTS[] = {{"qu", "bool"}, {"qd", "bool"}, {"cv", "int"}, {}};
+const PlcBlockDescriptor BlockCTUD::DESCRIPTOR = {"counters", "Count Up/Down block", INPUTS, OUTPUTS};
+
+void BlockCTUD::migrateState(const PlcBlock& previous) {
+    const BlockCTUD& old = static_cast<const BlockCTUD&>(previous);
+    last_cu_state = old.last_cu_state;
+    last_cd_state = old.last_cd_state;
+}
@@ -6,20 +6,27 @@
 
 class BlockCTUD : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "CTUD";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockCTUD();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    bool hasState() const override { return true; } // Edge memory
 
 private:
-    std::string cu_var;      // Count Up input
-    std::string cd_var;      // Count Down input
-    std::string reset_var;   // Reset input
-    std::string load_var;    // Load input
-    std::string pv_var;      // Preset Value input
-    std::string qu_var;      // Count Up Output
-    std::string qd_var;      // Count Down Output
-    std::string cv_var;      // Current Value output
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle cu_var;      // Count Up input
+    VarHandle cd_var;      // Count Down input
+    VarHandle reset_var;   // Reset input
+    VarHandle load_var;    // Load input
+    VarHandle pv_var;      // Preset Value input
+    VarHandle qu_var;      // Count Up Output
+    VarHandle qd_var;      // Count Down Output
+    VarHandle cv_var;      // Current Value output
 
     bool last_cu_state;
     bool last_cd_state;
@@ -18,7 +18,7 @@ void BlockStatusHandler::setDeviceRegistry(DeviceRegistry* registry) {
 bool BlockStatusHandler::configure(const JsonObject& config, PlcMemory& memory) {
     // Parse inputs
     if (config["inputs"].is<JsonObject>() && config["inputs"]["endpoint_name"].is<const char*>()) {
-        endpoint_name_var = config["inputs"]["endpoint_name"].as<std::string>();
+        endpoint_name_var = bindInput(memory, config["inputs"]["endpoint_name"], PlcValueType::STRING_TYPE);
     } else {
         EspHubLog->println("ERROR: StatusHandler requires 'endpoint_name' input");
         return false;
@@ -28,39 +28,40 @@ bool BlockStatusHandler::configure(const JsonObject& config, PlcMemory& memory)
     if (config["outputs"].is<JsonObject>()) {
         JsonObject outputs = config["outputs"];
         if (outputs["is_online"].is<const char*>()) {
-            is_online_var = outputs["is_online"].as<std::string>();
+            is_online_var = bindOutput(memory, outputs["is_online"], PlcValueType::BOOL);
         }
         if (outputs["on_online"].is<const char*>()) {
-            on_online_var = outputs["on_online"].as<std::string>();
+            on_online_var = bindOutput(memory, outputs["on_online"], PlcValueType::BOOL);
         }
         if (outputs["on_offline"].is<const char*>()) {
-            on_offline_var = outputs["on_offline"].as<std::string>();
+            on_offline_var = bindOutput(memory, outputs["on_offline"], PlcValueType::BOOL);
         }
     }
 
     // Validate that we have at least one output
-    if (is_online_var.empty() && on_online_var.empty() && on_offline_var.empty()) {
+    if (!is_online_var.isValid() && !on_online_var.isValid() && !on_offline_var.isValid()) {
         EspHubLog->println("ERROR: StatusHandler requires at least one output");
         return false;
     }
 
-    EspHubLog->printf("StatusHandler configured: monitoring %s\n", endpoint_name_var.c_str());
+    EspHubLog->printf("StatusHandler configured: monitoring %s\n", config["inputs"]["endpoint_name"].as<const char*>());
     return true;
 }
 
 void BlockStatusHandler::evaluate(PlcMemory& memory) {
-    if (endpoint_name_var.empty() || !deviceRegistry) {
+    if (!endpoint_name_var.isValid() || !deviceRegistry) {
         return;
     }
 
     // Get the endpoint name from PLC memory
-    String currentEndpoint = memory.getValue<String>(endpoint_name_var, String(""));
-    if (currentEndpoint.isEmpty()) {
+    char buffer[PLC_STRING_SIZE];
+    const char* currentEndpoint = memory.getText(endpoint_name_var, buffer, sizeof(buffer));
+    if (currentEndpoint[0] == '\0') {
         return;
     }
 
     // Check if we're monitoring a different endpoint now
-    if (currentEndpoint != monitoredEndpoint) {
+    if (monitoredEndpoint != currentEndpoint) {
         monitoredEndpoint = currentEndpoint;
         initialized = false;
         EspHubLog->printf("StatusHandler: Now monitoring %s\n", monitoredEndpoint.c_str());
@@ -82,7 +83,7 @@ void BlockStatusHandler::updateStatus(PlcMemory& memory) {
         initialized = true;
 
         // Set current status output
-        if (!is_online_var.empty()) {
+        if (is_online_var.isValid()) {
             memory.setValue<bool>(is_online_var, currentStatus);
         }
 
@@ -99,53 +100,43 @@ void BlockStatusHandler::updateStatus(PlcMemory& memory) {
         lastKnownStatus = currentStatus;
 
         // Update status output
-        if (!is_online_var.empty()) {
+        if (is_online_var.isValid()) {
             memory.setValue<bool>(is_online_var, currentStatus);
         }
 
         // Trigger appropriate event
-        if (currentStatus && !on_online_var.empty()) {
+        if (currentStatus && on_online_var.isValid()) {
             // Device went ONLINE
             memory.setValue<bool>(on_online_var, true);
             EspHubLog->printf("StatusHandler: Triggered ON_ONLINE for %s\n", monitoredEndpoint.c_str());
-        } else if (!currentStatus && !on_offline_var.empty()) {
+        } else if (!currentStatus && on_offline_var.isValid()) {
             // Device went OFFLINE
             memory.setValue<bool>(on_offline_var, true);
             EspHubLog->printf("StatusHandler: Triggered ON_OFFLINE for %s\n", monitoredEndpoint.c_str());
         }
     } else {
         // No change - reset triggers to false
-        if (!on_online_var.empty()) {
+        if (on_online_var.isValid()) {
             memory.setValue<bool>(on_online_var, false);
         }
-        if (!on_offline_var.empty()) {
+        if (on_offline_var.isValid()) {
             memory.setValue<bool>(on_offline_var, false);
         }
 
         // Keep is_online updated
-        if (!is_online_var.empty()) {
+        if (is_online_var.isValid()) {
             memory.setValue<bool>(is_online_var, currentStatus);
         }
     }
 }
 
-JsonDocument BlockStatusHandler::getBlockSchema() {
-    JsonDocument schema;
-    schema["type"] = "StatusHandler";
-    schema["description"] = "Monitors endpoint online/offline status and triggers PLC events";
-    schema["category"] = "events";
-
-    JsonObject inputs = schema["inputs"].to<JsonObject>();
-    inputs["endpoint_name"]["type"] = "string";
-    inputs["endpoint_name"]["description"] = "Full endpoint name to monitor (e.g., 'kitchen.zigbee.relay.switch1.bool')";
-
-    JsonObject outputs = schema["outputs"].to<JsonObject>();
-    outputs["is_online"]["type"] = "bool";
-    outputs["is_online"]["description"] = "Current online status of the endpoint";
-    outputs["on_online"]["type"] = "bool";
-    outputs["on_online"]["description"] = "Trigger (one-shot) when device goes online";
-    outputs["on_offline"]["type"] = "bool";
-    outputs["on_offline"]["description"] = "Trigger (one-shot) when device goes offline";
-
-    return schema;
+const PlcPinInfo BlockStatusHandler::INPUTS[] = {{"endpoint_name", "string"}, {}};
+const PlcPinInfo BlockStatusHandler::OUTPUTS[] = {{"is_online", "bool"}, {"on_online", "bool"}, {"on_offline", "bool"}, {}};
+const PlcBlockDescriptor BlockStatusHandler::DESCRIPTOR = {"events", "Monitors endpoint online/offline status and triggers PLC events", INPUTS, OUTPUTS};
+
+void BlockStatusHandler::migrateState(const PlcBlock& previous) {
+    const BlockStatusHandler& old = static_cast<const BlockStatusHandler&>(previous);
+    monitoredEndpoint = old.monitoredEndpoint;
+    lastKnownStatus = old.lastKnownStatus;
+    initialized = old.initialized;
 }
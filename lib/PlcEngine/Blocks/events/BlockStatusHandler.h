@@ -36,21 +36,29 @@ class DeviceRegistry;
  */
 class BlockStatusHandler : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "StatusHandler";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockStatusHandler();
     ~BlockStatusHandler();
 
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    bool isAlwaysLive() const override { return true; }
+    bool needsScan() const override { return false; } // Status changes wake the engine (DeviceRegistry)
 
     // Set DeviceRegistry for status monitoring
     void setDeviceRegistry(DeviceRegistry* registry);
 
 private:
-    std::string endpoint_name_var;  // PLC variable containing endpoint name
-    std::string is_online_var;      // Output: current online status
-    std::string on_online_var;      // Output: online trigger
-    std::string on_offline_var;     // Output: offline trigger
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle endpoint_name_var;  // PLC variable containing endpoint name
+    VarHandle is_online_var;      // Output: current online status
+    VarHandle on_online_var;      // Output: online trigger
+    VarHandle on_offline_var;     // Output: offline trigger
 
     DeviceRegistry* deviceRegistry;
     String monitoredEndpoint;       // Currently monitored endpoint
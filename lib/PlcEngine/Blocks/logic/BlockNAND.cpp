@@ -2,19 +2,16 @@
 
 bool BlockNAND::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        JsonObject inputs = config["inputs"];
-        for (JsonPair kv : inputs) {
-            input_vars.push_back(kv.value().as<std::string>());
-        }
+        bindInputs(memory, config["inputs"], PlcValueType::BOOL, input_vars);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
     }
     return true; // Basic validation for now
 }
 
 void BlockNAND::evaluate(PlcMemory& memory) {
-    if (output_var.empty() || input_vars.empty()) {
+    if (!output_var.isValid() || input_vars.empty()) {
         return; // Not configured
     }
 
@@ -28,11 +25,18 @@ void BlockNAND::evaluate(PlcMemory& memory) {
     memory.setValue<bool>(output_var, !result);
 }
 
-JsonDocument BlockNAND::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Logical NAND block";
-    schema["inputs"]["in1"]["type"] = "bool";
-    schema["inputs"]["in2"]["type"] = "bool";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+bool BlockNAND::lower(PlcBytecode& code) {
+    return code.emitNary(PlcOpcode::NAND_B, output_var, input_vars);
+}
+
+bool BlockNAND::describeBitOp(PlcBitOp& op) const {
+    if (input_vars.size() != 2 || !output_var.isValid()) {
+        return false;
+    }
+    op = {PlcWordOp::NAND, input_vars[0], input_vars[1], output_var};
+    return true;
+}
+
+const PlcPinInfo BlockNAND::INPUTS[] = {{"in1", "bool"}, {"in2", "bool"}, {}};
+const PlcPinInfo BlockNAND::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockNAND::DESCRIPTOR = {"logic", "Logical NAND block", INPUTS, OUTPUTS};
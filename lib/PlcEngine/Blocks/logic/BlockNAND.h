@@ -7,13 +7,20 @@
 
 class BlockNAND : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "NAND";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
+    bool describeBitOp(PlcBitOp& op) const override;
 
 private:
-    std::vector<std::string> input_vars;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    PlcHandleList input_vars;
+    VarHandle output_var;
 };
 
 #endif // PLC_BLOCK_NAND_H
\ No newline at end of file
@@ -2,19 +2,16 @@
 
 bool BlockNOR::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        JsonObject inputs = config["inputs"];
-        for (JsonPair kv : inputs) {
-            input_vars.push_back(kv.value().as<std::string>());
-        }
+        bindInputs(memory, config["inputs"], PlcValueType::BOOL, input_vars);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
     }
     return true; // Basic validation for now
 }
 
 void BlockNOR::evaluate(PlcMemory& memory) {
-    if (output_var.empty() || input_vars.empty()) {
+    if (!output_var.isValid() || input_vars.empty()) {
         return; // Not configured
     }
 
@@ -28,11 +25,18 @@ void BlockNOR::evaluate(PlcMemory& memory) {
     memory.setValue<bool>(output_var, !result);
 }
 
-JsonDocument BlockNOR::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Logical NOR block";
-    schema["inputs"]["in1"]["type"] = "bool";
-    schema["inputs"]["in2"]["type"] = "bool";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+bool BlockNOR::lower(PlcBytecode& code) {
+    return code.emitNary(PlcOpcode::NOR_B, output_var, input_vars);
+}
+
+bool BlockNOR::describeBitOp(PlcBitOp& op) const {
+    if (input_vars.size() != 2 || !output_var.isValid()) {
+        return false;
+    }
+    op = {PlcWordOp::NOR, input_vars[0], input_vars[1], output_var};
+    return true;
+}
+
+const PlcPinInfo BlockNOR::INPUTS[] = {{"in1", "bool"}, {"in2", "bool"}, {}};
+const PlcPinInfo BlockNOR::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockNOR::DESCRIPTOR = {"logic", "Logical NOR block", INPUTS, OUTPUTS};
@@ -2,16 +2,16 @@
 
 bool BlockNOT::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::BOOL);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
     }
     return true; // Basic validation for now
 }
 
 void BlockNOT::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -19,10 +19,18 @@ void BlockNOT::evaluate(PlcMemory& memory) {
     memory.setValue<bool>(output_var, !in_val);
 }
 
-JsonDocument BlockNOT::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Logical NOT block";
-    schema["inputs"]["in"]["type"] = "bool";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+bool BlockNOT::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::NOT_B, output_var, input_var);
+}
+
+bool BlockNOT::describeBitOp(PlcBitOp& op) const {
+    if (!input_var.isValid() || !output_var.isValid()) {
+        return false;
+    }
+    op = {PlcWordOp::NOT, input_var, VarHandle(), output_var};
+    return true;
+}
+
+const PlcPinInfo BlockNOT::INPUTS[] = {{"in", "bool"}, {}};
+const PlcPinInfo BlockNOT::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockNOT::DESCRIPTOR = {"logic", "Logical NOT block", INPUTS, OUTPUTS};
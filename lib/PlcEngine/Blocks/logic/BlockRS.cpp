@@ -5,17 +5,17 @@ BlockRS::BlockRS() {
 
 bool BlockRS::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        set_var = config["inputs"]["set"].as<std::string>();
-        reset_var = config["inputs"]["reset"].as<std::string>();
+        set_var = bindInput(memory, config["inputs"]["set"], PlcValueType::BOOL);
+        reset_var = bindInput(memory, config["inputs"]["reset"], PlcValueType::BOOL);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
     }
     return true; // Basic validation for now
 }
 
 void BlockRS::evaluate(PlcMemory& memory) {
-    if (set_var.empty() || reset_var.empty() || output_var.empty()) {
+    if (!set_var.isValid() || !reset_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -34,11 +34,10 @@ void BlockRS::evaluate(PlcMemory& memory) {
     memory.setValue<bool>(output_var, current_output);
 }
 
-JsonDocument BlockRS::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Reset-Set Latch (Set dominant)";
-    schema["inputs"]["set"]["type"] = "bool";
-    schema["inputs"]["reset"]["type"] = "bool";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+bool BlockRS::lower(PlcBytecode& code) {
+    return code.emitBinary(PlcOpcode::RS_B, output_var, set_var, reset_var);
+}
+
+const PlcPinInfo BlockRS::INPUTS[] = {{"set", "bool"}, {"reset", "bool"}, {}};
+const PlcPinInfo BlockRS::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockRS::DESCRIPTOR = {"logic", "Reset-Set Latch (Set dominant)", INPUTS, OUTPUTS};
@@ -5,17 +5,17 @@ BlockSR::BlockSR() {
 
 bool BlockSR::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        set_var = config["inputs"]["set"].as<std::string>();
-        reset_var = config["inputs"]["reset"].as<std::string>();
+        set_var = bindInput(memory, config["inputs"]["set"], PlcValueType::BOOL);
+        reset_var = bindInput(memory, config["inputs"]["reset"], PlcValueType::BOOL);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
     }
     return true; // Basic validation for now
 }
 
 void BlockSR::evaluate(PlcMemory& memory) {
-    if (set_var.empty() || reset_var.empty() || output_var.empty()) {
+    if (!set_var.isValid() || !reset_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -34,11 +34,10 @@ void BlockSR::evaluate(PlcMemory& memory) {
     memory.setValue<bool>(output_var, current_output);
 }
 
-JsonDocument BlockSR::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Set-Reset Latch (Reset dominant)";
-    schema["inputs"]["set"]["type"] = "bool";
-    schema["inputs"]["reset"]["type"] = "bool";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+bool BlockSR::lower(PlcBytecode& code) {
+    return code.emitBinary(PlcOpcode::SR_B, output_var, set_var, reset_var);
+}
+
+const PlcPinInfo BlockSR::INPUTS[] = {{"set", "bool"}, {"reset", "bool"}, {}};
+const PlcPinInfo BlockSR::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockSR::DESCRIPTOR = {"logic", "Set-Reset Latch (Reset dominant)", INPUTS, OUTPUTS};
@@ -6,15 +6,21 @@
 
 class BlockSR : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "SR";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockSR();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
 
 private:
-    std::string set_var;
-    std::string reset_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle set_var;
+    VarHandle reset_var;
+    VarHandle output_var;
 };
 
 #endif // PLC_BLOCK_SR_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "BlockST.h"
+#include <StreamLogger.h>
+
+extern StreamLogger* EspHubLog;
+
+VarHandle BlockST::bindRead(void* context, const char* name, PlcValueType type) {
+    BindContext* bind = static_cast<BindContext*>(context);
+    return bind->block->bindInputName(*bind->memory, name, type);
+}
+
+VarHandle BlockST::bindWrite(void* context, const char* name, PlcValueType type) {
+    BindContext* bind = static_cast<BindContext*>(context);
+    return bind->block->bindOutputName(*bind->memory, name, type);
+}
+
+bool BlockST::configure(const JsonObject& config, PlcMemory& memory) {
+    BindContext context = {this, &memory};
+    PlcBlockContext blockContext = {nullptr, nullptr, timers, cycle};
+    uint32_t maxIterations = config["max_iterations"] | PlcStructuredText::DEFAULT_MAX_ITERATIONS;
+    if (!program.compile(config["source"].as<const char*>(), memory, bindRead, bindWrite, &context,
+                         blockContext, arena, maxIterations)) {
+        EspHubLog->printf("ERROR: ST: %s at line %u\n", program.getError(), program.getErrorLine());
+        return false;
+    }
+    for (size_t i = 0; i < program.getInstanceCount(); i++) {
+        adoptSlots(*program.getInstance(i));
+    }
+    return true;
+}
+
+void BlockST::evaluate(PlcMemory& memory) {
+    program.execute(memory);
+}
+
+bool BlockST::isAlwaysLive() const {
+    for (size_t i = 0; i < program.getInstanceCount(); i++) {
+        PlcBlock* instance = program.getInstance(i);
+        if (instance->isAlwaysLive() || instance->getTimer() != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BlockST::needsScan() const {
+    for (size_t i = 0; i < program.getInstanceCount(); i++) {
+        if (program.getInstance(i)->needsScan()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BlockST::migrateState(const PlcBlock& previous) {
+    program.migrateState(static_cast<const BlockST&>(previous).program);
+}
+
+const PlcPinInfo BlockST::INPUTS[] = {{"source", "string"}, {"max_iterations", "uint32"}, {}};
+const PlcPinInfo BlockST::OUTPUTS[] = {{}};
+const PlcBlockDescriptor BlockST::DESCRIPTOR = {"logic", "Structured Text program", INPUTS, OUTPUTS};
@@ -0,0 +1,45 @@
+#ifndef PLC_BLOCK_ST_H
+#define PLC_BLOCK_ST_H
+
+#include "../PlcBlock.h"
+#include "../../Engine/PlcStructuredText.h"
+
+/**
+ * ST - a Structured Text program, e.g.
+ *   {"block_type": "ST", "source": "IF level > high THEN pump := TRUE; END_IF;"}
+ * A program loaded with "language": "st" is a single ST block. The source
+ * is compiled once in configure(); see PlcStructuredText for the syntax.
+ * The function block instances it declares run inside this block, so their
+ * variables and timers count as the block's own.
+ */
+class BlockST : public PlcBlock {
+public:
+    static constexpr const char* TYPE = "ST";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override;
+    void evaluate(PlcMemory& memory) override;
+    // Timers of the instances are not tracked one by one: a program with
+    // any runs on every scan in incremental execution
+    bool isAlwaysLive() const override;
+    bool needsScan() const override;
+    void migrateState(const PlcBlock& previous) override;
+    bool hasState() const override { return program.getInstanceCount() > 0; }
+
+    const PlcStructuredText& getProgram() const { return program; }
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    struct BindContext {
+        BlockST* block;
+        PlcMemory* memory;
+    };
+    static VarHandle bindRead(void* context, const char* name, PlcValueType type);
+    static VarHandle bindWrite(void* context, const char* name, PlcValueType type);
+
+    PlcStructuredText program;
+};
+
+#endif // PLC_BLOCK_ST_H
@@ -3,26 +3,26 @@
 
 extern StreamLogger* EspHubLog;
 
-BlockSequencer::BlockSequencer() : current_step(0) {
+BlockSequencer::BlockSequencer() : current_step(0), step_entered(false) {
 }
 
 bool BlockSequencer::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("outputs")) {
-        output_done_var = config["outputs"]["done"].as<std::string>();
-        output_active_var = config["outputs"]["active"].as<std::string>();
+        output_done_var = bindOutput(memory, config["outputs"]["done"], PlcValueType::BOOL);
+        output_active_var = bindOutput(memory, config["outputs"]["active"], PlcValueType::BOOL);
     }
 
     if (config.containsKey("steps")) {
         JsonArray steps_cfg = config["steps"].as<JsonArray>();
         for (JsonObject step_cfg : steps_cfg) {
             SequencerStep step;
-            step.actions = step_cfg["actions"].as<JsonArray>();
-            step.transition_condition_var = step_cfg["transition_condition"].as<std::string>();
+            parseActions(step_cfg["actions"].as<JsonArray>(), step, memory);
+            step.transition_condition_var = bindInput(memory, step_cfg["transition_condition"], PlcValueType::BOOL);
             step.timeout_ms = step_cfg["timeout_ms"] | 0;
             steps.push_back(step);
         }
     }
-    return true; // Basic validation for now
+    return timers != nullptr;
 }
 
 void BlockSequencer::evaluate(PlcMemory& memory) {
@@ -39,16 +39,17 @@ void BlockSequencer::evaluate(PlcMemory& memory) {
 
     // Execute actions for the current step
     executeActions(current_s.actions, memory);
+    step_entered = true;
 
     // Check for transition condition
     bool transition_met = memory.getValue<bool>(current_s.transition_condition_var, false);
     bool timeout_occurred = false;
 
     if (current_s.timeout_ms > 0) {
-        if (current_s.start_time == 0) { // First entry into this step
-            current_s.start_time = millis();
+        if (step_timer.isIdle()) { // First entry into this step
+            timers->arm(step_timer, current_s.timeout_ms);
         }
-        if (millis() - current_s.start_time >= current_s.timeout_ms) {
+        if (step_timer.hasExpired()) {
             timeout_occurred = true;
             EspHubLog->printf("Sequencer timeout in step %d\n", current_step);
         }
@@ -61,37 +62,62 @@ void BlockSequencer::evaluate(PlcMemory& memory) {
             memory.setValue<bool>(output_done_var, true);
             memory.setValue<bool>(output_active_var, false);
         }
-        current_s.start_time = 0; // Reset timer for next step
+        timers->disarm(step_timer); // Reset timer for next step
+        step_entered = false;
     }
 }
 
-void BlockSequencer::executeActions(const JsonArray& actions, PlcMemory& memory) {
-    for (JsonObject action : actions) {
+void BlockSequencer::parseActions(const JsonArray& actions_cfg, SequencerStep& step, PlcMemory& memory) {
+    for (JsonObject action : actions_cfg) {
         const char* action_type = action["action"];
-        if (strcmp(action_type, "set_value") == 0) {
-            const char* var_name = action["variable"];
+        if (action_type && strcmp(action_type, "set_value") == 0) {
+            SequencerAction parsed;
             if (action["value"].is<bool>()) {
-                memory.setValue<bool>(var_name, action["value"].as<bool>());
+                parsed.valueType = PlcValueType::BOOL;
+                parsed.value = action["value"].as<bool>() ? 1.0f : 0.0f;
             } else if (action["value"].is<float>()) {
-                memory.setValue<float>(var_name, action["value"].as<float>());
+                parsed.valueType = PlcValueType::REAL;
+                parsed.value = action["value"].as<float>();
             } else if (action["value"].is<int>()) {
-                memory.setValue<int16_t>(var_name, action["value"].as<int>());
+                parsed.valueType = PlcValueType::INT;
+                parsed.value = action["value"].as<int>();
+            } else {
+                continue; // Add other types as needed
             }
-            // Add other types as needed
+            parsed.variable = bindOutput(memory, action["variable"], parsed.valueType);
+            if (parsed.variable.isValid()) {
+                step.actions.push_back(parsed);
+            }
+        }
+    }
+}
+
+void BlockSequencer::executeActions(const std::vector<SequencerAction>& actions, PlcMemory& memory) {
+    for (const SequencerAction& action : actions) {
+        switch (action.valueType) {
+            case PlcValueType::BOOL:
+                memory.setValue<bool>(action.variable, action.value != 0.0f);
+                break;
+            case PlcValueType::INT:
+                memory.setValue<int16_t>(action.variable, static_cast<int16_t>(action.value));
+                break;
+            default:
+                memory.setValue<float>(action.variable, action.value);
+                break;
         }
     }
 }
 
-JsonDocument BlockSequencer::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Sequencer block for step-by-step control";
-    schema["inputs"]["start"]["type"] = "bool"; // Example input to start sequence
-    schema["outputs"]["done"]["type"] = "bool";
-    schema["outputs"]["active"]["type"] = "bool";
-    schema["steps"]["type"] = "array";
-    schema["steps"]["items"]["type"] = "object";
-    schema["steps"]["items"]["properties"]["actions"]["type"] = "array";
-    schema["steps"]["items"]["properties"]["transition_condition"]["type"] = "string";
-    schema["steps"]["items"]["properties"]["timeout_ms"]["type"] = "uint32";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockSequencer::INPUTS[] = {{"start", "bool"}, {}};
+const PlcPinInfo BlockSequencer::OUTPUTS[] = {{"done", "bool"}, {"active", "bool"}, {}};
+const PlcBlockDescriptor BlockSequencer::DESCRIPTOR = {"logic", "Sequencer block for step-by-step control, configured by a list of steps", INPUTS, OUTPUTS};
+
+void BlockSequencer::migrateState(const PlcBlock& previous) {
+    // Continue in the same step if the new sequence still has it
+    const BlockSequencer& old = static_cast<const BlockSequencer&>(previous);
+    if (old.current_step < static_cast<int>(steps.size())) {
+        current_step = old.current_step;
+        timers->migrate(step_timer, old.step_timer);
+        step_entered = old.step_entered;
+    }
+}
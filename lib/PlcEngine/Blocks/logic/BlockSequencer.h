@@ -5,27 +5,45 @@
 #include <string>
 #include <vector>
 
+// set_value action, resolved at configure time
+struct SequencerAction {
+    VarHandle variable;
+    PlcValueType valueType;
+    float value;
+};
+
 struct SequencerStep {
-    JsonArray actions; // Actions to perform in this step
-    std::string transition_condition_var; // Variable to check for transition
+    std::vector<SequencerAction> actions; // Actions to perform in this step
+    VarHandle transition_condition_var; // Variable to check for transition
     unsigned long timeout_ms; // Timeout for this step
-    unsigned long start_time; // Internal: when this step started
 };
 
 class BlockSequencer : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "SEQUENCER";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockSequencer();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    bool isAlwaysLive() const override { return true; } // Step actions run on every scan
+    bool needsScan() const override { return !step_entered; } // Actions of a new step still to run
+    PlcTimer* getTimer() override { return &step_timer; }
 
 private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
     std::vector<SequencerStep> steps;
     int current_step;
-    std::string output_done_var; // Output when sequence is complete
-    std::string output_active_var; // Output when sequence is active
+    PlcTimer step_timer; // Timeout of the current step
+    bool step_entered; // Actions of the current step have run
+    VarHandle output_done_var; // Output when sequence is complete
+    VarHandle output_active_var; // Output when sequence is active
 
-    void executeActions(const JsonArray& actions, PlcMemory& memory);
+    void parseActions(const JsonArray& actions_cfg, SequencerStep& step, PlcMemory& memory);
+    void executeActions(const std::vector<SequencerAction>& actions, PlcMemory& memory);
 };
 
 #endif // PLC_BLOCK_SEQUENCER_H
\ No newline at end of file
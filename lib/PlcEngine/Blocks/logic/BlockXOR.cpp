@@ -2,19 +2,16 @@
 
 bool BlockXOR::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        JsonObject inputs = config["inputs"];
-        for (JsonPair kv : inputs) {
-            input_vars.push_back(kv.value().as<std::string>());
-        }
+        bindInputs(memory, config["inputs"], PlcValueType::BOOL, input_vars);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
     }
     return true; // Basic validation for now
 }
 
 void BlockXOR::evaluate(PlcMemory& memory) {
-    if (output_var.empty() || input_vars.empty()) {
+    if (!output_var.isValid() || input_vars.empty()) {
         return; // Not configured
     }
 
@@ -28,11 +25,18 @@ void BlockXOR::evaluate(PlcMemory& memory) {
     memory.setValue<bool>(output_var, result);
 }
 
-JsonDocument BlockXOR::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Logical XOR block";
-    schema["inputs"]["in1"]["type"] = "bool";
-    schema["inputs"]["in2"]["type"] = "bool";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+bool BlockXOR::lower(PlcBytecode& code) {
+    return code.emitNary(PlcOpcode::XOR_B, output_var, input_vars);
+}
+
+bool BlockXOR::describeBitOp(PlcBitOp& op) const {
+    if (input_vars.size() != 2 || !output_var.isValid()) {
+        return false;
+    }
+    op = {PlcWordOp::XOR, input_vars[0], input_vars[1], output_var};
+    return true;
+}
+
+const PlcPinInfo BlockXOR::INPUTS[] = {{"in1", "bool"}, {"in2", "bool"}, {}};
+const PlcPinInfo BlockXOR::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockXOR::DESCRIPTOR = {"logic", "Logical XOR block", INPUTS, OUTPUTS};
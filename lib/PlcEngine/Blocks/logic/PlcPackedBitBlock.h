@@ -0,0 +1,52 @@
+#ifndef PLC_PACKED_BIT_BLOCK_H
+#define PLC_PACKED_BIT_BLOCK_H
+
+#include "../PlcBlock.h"
+
+/**
+ * PlcPackedBitBlock - scalar logic blocks evaluated as one word operation.
+ *
+ * Built by the optimizer (PlcProgram::packBitLogic()), never configured from
+ * JSON. Every block it replaces computes the same PlcWordOp on bits of the
+ * same marker words: input 1 at bit n of wordA, input 2 at n + shiftB of
+ * wordB and the output at n + shiftOut of wordOut. Bit n of `mask` is set
+ * for each of them, so a single evaluate() computes all of them.
+ */
+class PlcPackedBitBlock : public PlcBlock {
+public:
+    PlcPackedBitBlock(PlcWordOp wordOp, uint16_t a, uint16_t b, uint16_t out, int8_t bShift, int8_t outShift)
+        : op(wordOp), wordA(a), wordB(b), wordOut(out), shiftB(bShift), shiftOut(outShift), mask(0), outMask(0) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override { return false; }
+
+    void evaluate(PlcMemory& memory) override {
+        uint32_t a = memory.loadWord(wordA);
+        uint32_t b = op == PlcWordOp::NOT ? 0 : shift(memory.loadWord(wordB), static_cast<int8_t>(-shiftB));
+        memory.storeWord(wordOut, shift(applyWordOp(op, a, b) & mask, shiftOut), outMask);
+    }
+
+    // Take over a block whose input 1 is bit `bit` of wordA
+    void add(const PlcBlock& block, uint8_t bit) {
+        mask |= 1u << bit;
+        outMask = shift(mask, shiftOut);
+        adoptSlots(block);
+    }
+
+    uint8_t getBitCount() const { return static_cast<uint8_t>(__builtin_popcount(mask)); }
+
+private:
+    PlcWordOp op;
+    uint16_t wordA;
+    uint16_t wordB;
+    uint16_t wordOut;
+    int8_t shiftB;
+    int8_t shiftOut;
+    uint32_t mask;
+    uint32_t outMask;
+
+    static uint32_t shift(uint32_t value, int8_t distance) {
+        return distance >= 0 ? value << distance : value >> -distance;
+    }
+};
+
+#endif // PLC_PACKED_BIT_BLOCK_H
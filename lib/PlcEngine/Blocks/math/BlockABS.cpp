@@ -2,16 +2,16 @@
 
 bool BlockABS::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::REAL);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::REAL);
     }
     return true; // Basic validation for now
 }
 
 void BlockABS::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -20,10 +20,10 @@ void BlockABS::evaluate(PlcMemory& memory) {
     memory.setValue<float>(output_var, fabsf(in_val));
 }
 
-JsonDocument BlockABS::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Absolute value block";
-    schema["inputs"]["in"]["type"] = "float";
-    schema["outputs"]["out"]["type"] = "float";
-    return schema;
-}
\ No newline at end of file
+bool BlockABS::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::ABS_R, output_var, input_var);
+}
+
+const PlcPinInfo BlockABS::INPUTS[] = {{"in", "float"}, {}};
+const PlcPinInfo BlockABS::OUTPUTS[] = {{"out", "float"}, {}};
+const PlcBlockDescriptor BlockABS::DESCRIPTOR = {"math", "Absolute value block", INPUTS, OUTPUTS};
@@ -1,19 +1,16 @@
 #ifndef PLC_BLOCK_ADD_H
 #define PLC_BLOCK_ADD_H
 
-#include "../PlcBlock.h"
-#include <string>
-#include <vector>
+#include "PlcArithBlock.h"
 
-class BlockADD : public PlcBlock {
+class BlockADD : public PlcArithBlock<PlcOpAdd> {
 public:
-    bool configure(const JsonObject& config, PlcMemory& memory) override;
-    void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    static constexpr const char* TYPE = "ADD";
+    static const PlcBlockDescriptor DESCRIPTOR;
 
 private:
-    std::vector<std::string> input_vars;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
 };
 
 #endif // PLC_BLOCK_ADD_H
\ No newline at end of file
@@ -6,12 +6,18 @@
 
 class BlockDEC : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "DEC";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
 
 private:
-    std::string input_output_var; // Variable to decrement
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_output_var; // Variable to decrement
 };
 
 #endif // PLC_BLOCK_DEC_H
\ No newline at end of file
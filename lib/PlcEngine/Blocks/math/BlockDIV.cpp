@@ -1,43 +1,5 @@
 #include "BlockDIV.h"
 
-bool BlockDIV::configure(const JsonObject& config, PlcMemory& memory) {
-    if (config.containsKey("inputs")) {
-        JsonArray inputs = config["inputs"].as<JsonArray>();
-        for (JsonVariant v : inputs) {
-            input_vars.push_back(v.as<std::string>());
-        }
-    }
-    if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
-    }
-    return true; // Basic validation for now
-}
-
-void BlockDIV::evaluate(PlcMemory& memory) {
-    if (output_var.empty() || input_vars.empty()) {
-        return; // Not configured
-    }
-
-    // Assuming all inputs are of type float for simplicity
-    float result = memory.getValue<float>(input_vars[0], 0.0f);
-    for (size_t i = 1; i < input_vars.size(); ++i) {
-        float divisor = memory.getValue<float>(input_vars[i], 0.0f);
-        if (divisor != 0.0f) {
-            result /= divisor;
-        } else {
-            // Handle division by zero, e.g., set output to 0 or a specific error value
-            result = 0.0f; 
-            break;
-        }
-    }
-    memory.setValue<float>(output_var, result);
-}
-
-JsonDocument BlockDIV::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Division block";
-    schema["inputs"]["in1"]["type"] = "float";
-    schema["inputs"]["in2"]["type"] = "float";
-    schema["outputs"]["out"]["type"] = "float";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockDIV::INPUTS[] = {{"in1", "float"}, {"in2", "float"}, {}};
+const PlcPinInfo BlockDIV::OUTPUTS[] = {{"out", "float"}, {}};
+const PlcBlockDescriptor BlockDIV::DESCRIPTOR = {"math", "Division block", INPUTS, OUTPUTS};
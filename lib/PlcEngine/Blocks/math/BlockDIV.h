@@ -1,19 +1,16 @@
 #ifndef PLC_BLOCK_DIV_H
 #define PLC_BLOCK_DIV_H
 
-#include "../PlcBlock.h"
-#include <string>
-#include <vector>
+#include "PlcArithBlock.h"
 
-class BlockDIV : public PlcBlock {
+class BlockDIV : public PlcArithBlock<PlcOpDiv> {
 public:
-    bool configure(const JsonObject& config, PlcMemory& memory) override;
-    void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    static constexpr const char* TYPE = "DIV";
+    static const PlcBlockDescriptor DESCRIPTOR;
 
 private:
-    std::vector<std::string> input_vars; // First input is divided by subsequent inputs
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
 };
 
 #endif // PLC_BLOCK_DIV_H
\ No newline at end of file
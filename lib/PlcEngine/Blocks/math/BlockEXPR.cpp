@@ -0,0 +1,44 @@
+#include "BlockEXPR.h"
+#include <StreamLogger.h>
+
+extern StreamLogger* EspHubLog;
+
+VarHandle BlockEXPR::bindVariable(void* context, const char* name, PlcValueType type) {
+    BindContext* bind = static_cast<BindContext*>(context);
+    return bind->block->bindInputName(*bind->memory, name, type);
+}
+
+bool BlockEXPR::configure(const JsonObject& config, PlcMemory& memory) {
+    const char* source = config["expression"].as<const char*>();
+    BindContext context = {this, &memory};
+    if (!expression.compile(source, bindVariable, &context, arena)) {
+        EspHubLog->printf("ERROR: EXPR: %s at position %u of '%s'\n", expression.getError(),
+                          static_cast<unsigned>(expression.getErrorPosition()), source ? source : "");
+        return false;
+    }
+    if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcExpression::slotType(expression.getType()));
+    }
+    return true;
+}
+
+void BlockEXPR::evaluate(PlcMemory& memory) {
+    if (!output_var.isValid()) {
+        return; // Not configured
+    }
+
+    PlcExprValue result = expression.evaluate(memory);
+    switch (expression.getType()) {
+        case PlcExpression::Type::BOOL: memory.setValue<bool>(output_var, result.i != 0); break;
+        case PlcExpression::Type::INT: memory.setValue<int32_t>(output_var, result.i); break;
+        case PlcExpression::Type::REAL: memory.setValue<float>(output_var, result.f); break;
+    }
+}
+
+bool BlockEXPR::lower(PlcBytecode& code) {
+    return code.emitExpression(output_var, expression);
+}
+
+const PlcPinInfo BlockEXPR::INPUTS[] = {{"expression", "string"}, {}};
+const PlcPinInfo BlockEXPR::OUTPUTS[] = {{"out", "any"}, {}};
+const PlcBlockDescriptor BlockEXPR::DESCRIPTOR = {"math", "Infix expression block", INPUTS, OUTPUTS};
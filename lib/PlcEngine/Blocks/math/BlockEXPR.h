@@ -0,0 +1,41 @@
+#ifndef PLC_BLOCK_EXPR_H
+#define PLC_BLOCK_EXPR_H
+
+#include "../PlcBlock.h"
+#include "../../Engine/PlcExpression.h"
+
+/**
+ * EXPR - output computed by an infix formula, e.g.
+ *   {"block_type": "EXPR", "expression": "(a * 1.8 + 32) > sp && enable",
+ *    "outputs": {"out": "alarm"}}
+ * replaces a chain of MUL/ADD/GT/AND blocks and their intermediate
+ * variables. The formula is compiled once in configure(); see
+ * PlcExpression for the syntax. An undeclared output is declared with the
+ * type of the result.
+ */
+class BlockEXPR : public PlcBlock {
+public:
+    static constexpr const char* TYPE = "EXPR";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override;
+    void evaluate(PlcMemory& memory) override;
+    bool lower(PlcBytecode& code) override;
+
+    const PlcExpression& getExpression() const { return expression; }
+
+private:
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    struct BindContext {
+        BlockEXPR* block;
+        PlcMemory* memory;
+    };
+    static VarHandle bindVariable(void* context, const char* name, PlcValueType type);
+
+    PlcExpression expression;
+    VarHandle output_var;
+};
+
+#endif // PLC_BLOCK_EXPR_H
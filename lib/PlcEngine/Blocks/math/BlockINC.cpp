@@ -2,13 +2,13 @@
 
 bool BlockINC::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in_out")) {
-        input_output_var = config["inputs"]["in_out"].as<std::string>();
+        input_output_var = bindInOut(memory, config["inputs"]["in_out"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
 
 void BlockINC::evaluate(PlcMemory& memory) {
-    if (input_output_var.empty()) {
+    if (!input_output_var.isValid()) {
         return; // Not configured
     }
 
@@ -17,9 +17,10 @@ void BlockINC::evaluate(PlcMemory& memory) {
     memory.setValue<int16_t>(input_output_var, val + 1);
 }
 
-JsonDocument BlockINC::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Increment block";
-    schema["inputs"]["in_out"]["type"] = "int";
-    return schema;
-}
\ No newline at end of file
+bool BlockINC::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::INC_I, input_output_var, input_output_var);
+}
+
+const PlcPinInfo BlockINC::INPUTS[] = {{"in_out", "int"}, {}};
+const PlcPinInfo BlockINC::OUTPUTS[] = {{}};
+const PlcBlockDescriptor BlockINC::DESCRIPTOR = {"math", "Increment block", INPUTS, OUTPUTS};
@@ -2,17 +2,17 @@
 
 bool BlockMOD::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        input1_var = config["inputs"]["in1"].as<std::string>();
-        input2_var = config["inputs"]["in2"].as<std::string>();
+        input1_var = bindInput(memory, config["inputs"]["in1"], PlcValueType::INT);
+        input2_var = bindInput(memory, config["inputs"]["in2"], PlcValueType::INT);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
 
 void BlockMOD::evaluate(PlcMemory& memory) {
-    if (input1_var.empty() || input2_var.empty() || output_var.empty()) {
+    if (!input1_var.isValid() || !input2_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -28,11 +28,10 @@ void BlockMOD::evaluate(PlcMemory& memory) {
     }
 }
 
-JsonDocument BlockMOD::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Modulo block";
-    schema["inputs"]["in1"]["type"] = "int";
-    schema["inputs"]["in2"]["type"] = "int";
-    schema["outputs"]["out"]["type"] = "int";
-    return schema;
-}
\ No newline at end of file
+bool BlockMOD::lower(PlcBytecode& code) {
+    return code.emitBinary(PlcOpcode::MOD_I, output_var, input1_var, input2_var);
+}
+
+const PlcPinInfo BlockMOD::INPUTS[] = {{"in1", "int"}, {"in2", "int"}, {}};
+const PlcPinInfo BlockMOD::OUTPUTS[] = {{"out", "int"}, {}};
+const PlcBlockDescriptor BlockMOD::DESCRIPTOR = {"math", "Modulo block", INPUTS, OUTPUTS};
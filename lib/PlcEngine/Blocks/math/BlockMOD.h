@@ -6,14 +6,20 @@
 
 class BlockMOD : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "MOD";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    bool lower(PlcBytecode& code) override;
 
 private:
-    std::string input1_var;
-    std::string input2_var;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input1_var;
+    VarHandle input2_var;
+    VarHandle output_var;
 };
 
 #endif // PLC_BLOCK_MOD_H
\ No newline at end of file
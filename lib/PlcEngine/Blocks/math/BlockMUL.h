@@ -1,19 +1,16 @@
 #ifndef PLC_BLOCK_MUL_H
 #define PLC_BLOCK_MUL_H
 
-#include "../PlcBlock.h"
-#include <string>
-#include <vector>
+#include "PlcArithBlock.h"
 
-class BlockMUL : public PlcBlock {
+class BlockMUL : public PlcArithBlock<PlcOpMul> {
 public:
-    bool configure(const JsonObject& config, PlcMemory& memory) override;
-    void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    static constexpr const char* TYPE = "MUL";
+    static const PlcBlockDescriptor DESCRIPTOR;
 
 private:
-    std::vector<std::string> input_vars;
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
 };
 
 #endif // PLC_BLOCK_MUL_H
\ No newline at end of file
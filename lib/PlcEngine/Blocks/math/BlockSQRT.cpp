@@ -3,16 +3,16 @@
 
 bool BlockSQRT::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs") && config["inputs"].containsKey("in")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::REAL);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::REAL);
     }
     return true; // Basic validation for now
 }
 
 void BlockSQRT::evaluate(PlcMemory& memory) {
-    if (input_var.empty() || output_var.empty()) {
+    if (!input_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
@@ -25,10 +25,10 @@ void BlockSQRT::evaluate(PlcMemory& memory) {
     }
 }
 
-JsonDocument BlockSQRT::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Square Root block";
-    schema["inputs"]["in"]["type"] = "float";
-    schema["outputs"]["out"]["type"] = "float";
-    return schema;
-}
\ No newline at end of file
+bool BlockSQRT::lower(PlcBytecode& code) {
+    return code.emitUnary(PlcOpcode::SQRT_R, output_var, input_var);
+}
+
+const PlcPinInfo BlockSQRT::INPUTS[] = {{"in", "float"}, {}};
+const PlcPinInfo BlockSQRT::OUTPUTS[] = {{"out", "float"}, {}};
+const PlcBlockDescriptor BlockSQRT::DESCRIPTOR = {"math", "Square Root block", INPUTS, OUTPUTS};
@@ -1,19 +1,16 @@
 #ifndef PLC_BLOCK_SUB_H
 #define PLC_BLOCK_SUB_H
 
-#include "../PlcBlock.h"
-#include <string>
-#include <vector>
+#include "PlcArithBlock.h"
 
-class BlockSUB : public PlcBlock {
+class BlockSUB : public PlcArithBlock<PlcOpSub> {
 public:
-    bool configure(const JsonObject& config, PlcMemory& memory) override;
-    void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    static constexpr const char* TYPE = "SUB";
+    static const PlcBlockDescriptor DESCRIPTOR;
 
 private:
-    std::vector<std::string> input_vars; // First input is subtracted by subsequent inputs
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
 };
 
 #endif // PLC_BLOCK_SUB_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef PLC_ARITH_BLOCK_H
+#define PLC_ARITH_BLOCK_H
+
+#include "../PlcBlock.h"
+#include "../../Engine/PlcTypeCheck.h"
+#include "../../Engine/PlcTypedOps.h"
+
+/**
+ * PlcArithBlock - n-ary arithmetic block (ADD, SUB, MUL, DIV).
+ *
+ * The operand types are resolved in configure() (PlcTypeCheck) and the
+ * block keeps the kernel for them: typedKernel<int16_t>, <int32_t> or
+ * <float> when the output and all inputs are declared with that type,
+ * convertingKernel (values converted through REAL) otherwise. evaluate()
+ * then calls it without looking at a slot type again.
+ */
+template<class Op>
+class PlcArithBlock : public PlcBlock {
+public:
+    PlcArithBlock() : kernel(nullptr) {}
+
+    bool configure(const JsonObject& config, PlcMemory& memory) override {
+        PlcValueType type = PlcValueType::REAL;
+        if (config.containsKey("inputs")) {
+            if (!PlcTypeCheck::resolveInputs(memory, Op::NAME, config["inputs"], type)) {
+                return false;
+            }
+            bindInputs(memory, config["inputs"], PlcTypeCheck::declarationType(memory, type), input_vars);
+        }
+        if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
+            output_var = bindOutput(memory, config["outputs"]["out"], PlcTypeCheck::declarationType(memory, type));
+            if (!PlcTypeCheck::checkOutput(memory, Op::NAME, output_var, type)) {
+                return false;
+            }
+        }
+        kernel = selectKernel();
+        return true;
+    }
+
+    void evaluate(PlcMemory& memory) override {
+        if (kernel) {
+            kernel(memory, input_vars, output_var);
+        }
+    }
+
+    bool lower(PlcBytecode& code) override {
+        return code.emitNary(Op::OPCODE, output_var, input_vars);
+    }
+
+protected:
+    PlcHandleList input_vars;
+    VarHandle output_var;
+
+private:
+    typedef void (*Kernel)(PlcMemory& memory, const PlcHandleList& inputs, VarHandle output);
+    Kernel kernel; // nullptr while not configured
+
+    Kernel selectKernel() const {
+        if (!output_var.isValid() || input_vars.empty()) {
+            return nullptr;
+        }
+        if (PlcTypeCheck::isUniform(input_vars, output_var.type)) {
+            switch (output_var.type) {
+                case PlcValueType::INT: return &typedKernel<int16_t>;
+                case PlcValueType::DINT: return &typedKernel<int32_t>;
+                case PlcValueType::REAL: return &typedKernel<float>;
+                default: break;
+            }
+        }
+        return &convertingKernel;
+    }
+
+    template<typename T>
+    static void typedKernel(PlcMemory& memory, const PlcHandleList& inputs, VarHandle output) {
+        T result = memory.getTyped<T>(inputs[0]);
+        for (size_t i = 1; i < inputs.size() && Op::step(result, memory.getTyped<T>(inputs[i])); ++i) {
+        }
+        memory.setTyped<T>(output, result);
+    }
+
+    // Mixed or BYTE operands: the REAL arithmetic of the bytecode's _R opcodes
+    static void convertingKernel(PlcMemory& memory, const PlcHandleList& inputs, VarHandle output) {
+        float result = memory.getValue<float>(inputs[0], 0.0f);
+        for (size_t i = 1; i < inputs.size() && Op::step(result, memory.getValue<float>(inputs[i], 0.0f)); ++i) {
+        }
+        memory.setValue<float>(output, result);
+    }
+};
+
+#endif // PLC_ARITH_BLOCK_H
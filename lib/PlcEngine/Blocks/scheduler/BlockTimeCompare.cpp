@@ -1,41 +1,50 @@
 #include "BlockTimeCompare.h"
+#include <algorithm>
 
-BlockTimeCompare::BlockTimeCompare(TimeManager* timeManager) {
-    _timeManager = timeManager;
+BlockTimeCompare::BlockTimeCompare() : hour(0), minute(0), second(0) {
 }
 
 bool BlockTimeCompare::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::BOOL);
     }
     if (config.containsKey("time")) {
         hour = config["time"]["hour"] | 0;
         minute = config["time"]["minute"] | 0;
         second = config["time"]["second"] | 0;
     }
-    return true; // Basic validation for now
+    return timers != nullptr && cycle != nullptr; // Basic validation for now
 }
 
 void BlockTimeCompare::evaluate(PlcMemory& memory) {
-    if (output_var.empty() || !_timeManager || !_timeManager->isTimeSet()) {
-        memory.setValue<bool>(output_var, false);
+    if (!output_var.isValid()) {
         return;
     }
-
     struct tm timeinfo;
-    getLocalTime(&timeinfo);
+    if (!cycle->getLocalTime(timeinfo)) {
+        memory.setValue<bool>(output_var, false);
+        timers->arm(timer, 1000); // Until the time is synchronised
+        return;
+    }
 
     bool result = (timeinfo.tm_hour == hour && timeinfo.tm_min == minute && timeinfo.tm_sec == second);
     memory.setValue<bool>(output_var, result);
+
+    // Check again in the next second to clear the output, or in the
+    // matching one. The clock's seconds are not aligned with the time of
+    // day and a scan may come later than the expiry, so a long wait ends
+    // half a second early and the last second before the one that matters
+    // is polled until it is seen.
+    int32_t now = timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec;
+    int32_t target = hour * 3600 + minute * 60 + second;
+    uint32_t wait = result ? 1 : static_cast<uint32_t>((target - now + 86400) % 86400);
+    timers->arm(timer, wait > 1 ? std::min(wait, MAX_WAIT_S) * 1000 - EARLY_MS : POLL_MS);
 }
 
-JsonDocument BlockTimeCompare::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Time comparison block";
-    schema["inputs"]["time"]["type"] = "object";
-    schema["inputs"]["time"]["properties"]["hour"]["type"] = "int";
-    schema["inputs"]["time"]["properties"]["minute"]["type"] = "int";
-    schema["inputs"]["time"]["properties"]["second"]["type"] = "int";
-    schema["outputs"]["out"]["type"] = "bool";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockTimeCompare::INPUTS[] = {{"time", "time"}, {}};
+const PlcPinInfo BlockTimeCompare::OUTPUTS[] = {{"out", "bool"}, {}};
+const PlcBlockDescriptor BlockTimeCompare::DESCRIPTOR = {"scheduler", "Time comparison block", INPUTS, OUTPUTS};
+
+void BlockTimeCompare::migrateState(const PlcBlock& previous) {
+    timers->migrate(timer, static_cast<const BlockTimeCompare&>(previous).timer);
+}
@@ -6,16 +6,30 @@
 
 class BlockTimeCompare : public PlcSchedulerBlock {
 public:
-    BlockTimeCompare(TimeManager* timeManager);
+    static constexpr const char* TYPE = "TIME_COMPARE";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
+    BlockTimeCompare();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    PlcTimer* getTimer() override { return &timer; } // Wakes the block for the next second that matters
 
 private:
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle output_var;
     int hour;
     int minute;
     int second;
+    PlcTimer timer;
+
+    // Longest wait between two checks, so clock adjustments (NTP, DST) are
+    // picked up within a minute
+    static constexpr uint32_t MAX_WAIT_S = 60;
+    static constexpr uint32_t EARLY_MS = 500;  // A wait of seconds ends this much early
+    static constexpr uint32_t POLL_MS = 100;   // Then the time is checked this often
 };
 
 #endif // PLC_BLOCK_TIME_COMPARE_H
\ No newline at end of file
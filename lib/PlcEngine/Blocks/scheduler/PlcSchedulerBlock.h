@@ -2,14 +2,13 @@
 #define PLC_SCHEDULER_BLOCK_H
 
 #include "../PlcBlock.h"
-#include <TimeManager.h> // Assuming TimeManager is accessible
 
+// Scheduler blocks read the time of day of the scan from the cycle
+// context (PlcCycleContext::getLocalTime()), not from the system clock
 class PlcSchedulerBlock : public PlcBlock {
 public:
     virtual ~PlcSchedulerBlock() {}
     // Common methods for scheduler blocks can go here
-protected:
-    TimeManager* _timeManager; // Pointer to the global TimeManager instance
 };
 
 #endif // PLC_SCHEDULER_BLOCK_H
\ No newline at end of file
@@ -2,34 +2,28 @@
 
 bool BlockStringConcat::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        JsonArray inputs = config["inputs"].as<JsonArray>();
-        for (JsonVariant v : inputs) {
-            input_vars.push_back(v.as<std::string>());
-        }
+        bindInputs(memory, config["inputs"], PlcValueType::STRING_TYPE, input_vars);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::STRING_TYPE);
     }
     return true; // Basic validation for now
 }
 
 void BlockStringConcat::evaluate(PlcMemory& memory) {
-    if (output_var.empty() || input_vars.empty()) {
+    if (!output_var.isValid() || input_vars.empty()) {
         return; // Not configured
     }
 
-    String result = "";
+    // Built on the stack: the output may be one of the inputs
+    char result[PLC_STRING_SIZE];
+    size_t length = 0;
     for (const auto& var_name : input_vars) {
-        result += memory.getValue<String>(var_name, "");
+        length += memory.printValue(var_name, result + length, sizeof(result) - length);
     }
-    memory.setValue<String>(output_var, result);
+    memory.setString(output_var, result, length);
 }
 
-JsonDocument BlockStringConcat::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "String concatenation block";
-    schema["inputs"]["in1"]["type"] = "string";
-    schema["inputs"]["in2"]["type"] = "string";
-    schema["outputs"]["out"]["type"] = "string";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockStringConcat::INPUTS[] = {{"in1", "string"}, {"in2", "string"}, {}};
+const PlcPinInfo BlockStringConcat::OUTPUTS[] = {{"out", "string"}, {}};
+const PlcBlockDescriptor BlockStringConcat::DESCRIPTOR = {"string", "String concatenation block", INPUTS, OUTPUTS};
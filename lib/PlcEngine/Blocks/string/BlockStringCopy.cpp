@@ -1,39 +1,38 @@
 #include "BlockStringCopy.h"
+#include <cstring>
 
 bool BlockStringCopy::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        source_var = config["inputs"]["source"].as<std::string>();
+        source_var = bindInput(memory, config["inputs"]["source"], PlcValueType::STRING_TYPE);
         start_index = config["inputs"]["start_index"] | 0;
         length = config["inputs"]["length"] | -1; // -1 means copy to end
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("destination")) {
-        destination_var = config["outputs"]["destination"].as<std::string>();
+        destination_var = bindOutput(memory, config["outputs"]["destination"], PlcValueType::STRING_TYPE);
     }
     return true; // Basic validation for now
 }
 
 void BlockStringCopy::evaluate(PlcMemory& memory) {
-    if (source_var.empty() || destination_var.empty()) {
+    if (!source_var.isValid() || !destination_var.isValid()) {
         return; // Not configured
     }
 
-    String source_str = memory.getValue<String>(source_var, "");
-    String result_str;
+    char buffer[PLC_STRING_SIZE];
+    const char* source_str = memory.getText(source_var, buffer, sizeof(buffer));
+    int source_length = static_cast<int>(strlen(source_str));
 
-    if (length == -1) {
-        result_str = source_str.substring(start_index);
-    } else {
-        result_str = source_str.substring(start_index, start_index + length);
+    // Copied in place: setString() handles source and destination overlapping
+    int count = 0;
+    if (start_index >= 0 && start_index < source_length) {
+        count = source_length - start_index;
+        if (length >= 0 && length < count) {
+            count = length;
+        }
     }
-    memory.setValue<String>(destination_var, result_str);
+    memory.setString(destination_var, source_str + (count > 0 ? start_index : 0), static_cast<size_t>(count));
 }
 
-JsonDocument BlockStringCopy::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Copies a substring from a source string";
-    schema["inputs"]["source"]["type"] = "string";
-    schema["inputs"]["start_index"]["type"] = "int";
-    schema["inputs"]["length"]["type"] = "int";
-    schema["outputs"]["destination"]["type"] = "string";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockStringCopy::INPUTS[] = {{"source", "string"}, {"start_index", "int"}, {"length", "int"}, {}};
+const PlcPinInfo BlockStringCopy::OUTPUTS[] = {{"destination", "string"}, {}};
+const PlcBlockDescriptor BlockStringCopy::DESCRIPTOR = {"string", "Copies a substring from a source string", INPUTS, OUTPUTS};
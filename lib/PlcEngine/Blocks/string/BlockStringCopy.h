@@ -6,13 +6,18 @@
 
 class BlockStringCopy : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "STRING_COPY";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
 
 private:
-    std::string source_var;
-    std::string destination_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle source_var;
+    VarHandle destination_var;
     int start_index;
     int length;
 };
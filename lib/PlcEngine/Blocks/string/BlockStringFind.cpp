@@ -1,33 +1,31 @@
 #include "BlockStringFind.h"
+#include <cstring>
 
 bool BlockStringFind::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        input_string_var = config["inputs"]["string"].as<std::string>();
-        substring_var = config["inputs"]["substring"].as<std::string>();
+        input_string_var = bindInput(memory, config["inputs"]["string"], PlcValueType::STRING_TYPE);
+        substring_var = bindInput(memory, config["inputs"]["substring"], PlcValueType::STRING_TYPE);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("index")) {
-        output_index_var = config["outputs"]["index"].as<std::string>();
+        output_index_var = bindOutput(memory, config["outputs"]["index"], PlcValueType::INT);
     }
     return true; // Basic validation for now
 }
 
 void BlockStringFind::evaluate(PlcMemory& memory) {
-    if (input_string_var.empty() || substring_var.empty() || output_index_var.empty()) {
+    if (!input_string_var.isValid() || !substring_var.isValid() || !output_index_var.isValid()) {
         return; // Not configured
     }
 
-    String input_str = memory.getValue<String>(input_string_var, "");
-    String substring_str = memory.getValue<String>(substring_var, "");
+    char input_buffer[PLC_STRING_SIZE];
+    char substring_buffer[PLC_STRING_SIZE];
+    const char* input_str = memory.getText(input_string_var, input_buffer, sizeof(input_buffer));
+    const char* found = strstr(input_str, memory.getText(substring_var, substring_buffer, sizeof(substring_buffer)));
 
-    int index = input_str.indexOf(substring_str);
+    int index = found ? static_cast<int>(found - input_str) : -1;
     memory.setValue<int16_t>(output_index_var, index);
 }
 
-JsonDocument BlockStringFind::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Finds a substring within a string";
-    schema["inputs"]["string"]["type"] = "string";
-    schema["inputs"]["substring"]["type"] = "string";
-    schema["outputs"]["index"]["type"] = "int";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockStringFind::INPUTS[] = {{"string", "string"}, {"substring", "string"}, {}};
+const PlcPinInfo BlockStringFind::OUTPUTS[] = {{"index", "int"}, {}};
+const PlcBlockDescriptor BlockStringFind::DESCRIPTOR = {"string", "Finds a substring within a string", INPUTS, OUTPUTS};
@@ -6,14 +6,19 @@
 
 class BlockStringFind : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "STRING_FIND";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
 
 private:
-    std::string input_string_var;
-    std::string substring_var;
-    std::string output_index_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_string_var;
+    VarHandle substring_var;
+    VarHandle output_index_var;
 };
 
 #endif // PLC_BLOCK_STRING_FIND_H
\ No newline at end of file
@@ -1,41 +1,95 @@
 #include "BlockStringFormat.h"
+#include <cstring>
 
 bool BlockStringFormat::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        format_string_var = config["inputs"]["format_string"].as<std::string>();
-        JsonArray vars_to_format = config["inputs"]["vars"].as<JsonArray>();
-        for (JsonVariant v : vars_to_format) {
-            input_vars.push_back(v.as<std::string>());
-        }
+        format_string_var = bindInput(memory, config["inputs"]["format_string"], PlcValueType::STRING_TYPE);
+        bindInputs(memory, config["inputs"]["vars"], PlcValueType::STRING_TYPE, input_vars);
     }
     if (config.containsKey("outputs") && config["outputs"].containsKey("out")) {
-        output_var = config["outputs"]["out"].as<std::string>();
+        output_var = bindOutput(memory, config["outputs"]["out"], PlcValueType::STRING_TYPE);
     }
     return true; // Basic validation for now
 }
 
 void BlockStringFormat::evaluate(PlcMemory& memory) {
-    if (format_string_var.empty() || output_var.empty()) {
+    if (!format_string_var.isValid() || !output_var.isValid()) {
         return; // Not configured
     }
 
-    String format_str = memory.getValue<String>(format_string_var, "");
-    // This is a simplified implementation. A full implementation would need to
-    // parse the format string and replace placeholders with actual variable values.
-    // For now, we'll just concatenate the format string with the first input variable.
-    String result_str = format_str;
-    if (!input_vars.empty()) {
-        result_str += memory.getValue<String>(input_vars[0], "");
+    char format_buffer[PLC_STRING_SIZE];
+    const char* format = memory.getText(format_string_var, format_buffer, sizeof(format_buffer));
+    char result[PLC_STRING_SIZE];
+    size_t length = 0;
+    size_t next_var = 0;
+    while (*format != '\0' && length < sizeof(result) - 1) {
+        if (format[0] != '%' || format[1] == '%') {
+            result[length++] = *format;
+            format += format[0] == '%' ? 2 : 1;
+            continue;
+        }
+        // %[flags][width][.precision][length]conversion; length modifiers
+        // are dropped, the value is converted to what the conversion takes
+        char spec[16];
+        size_t spec_length = 0;
+        spec[spec_length++] = *format++;
+        while (*format != '\0' && strchr("-+ #0123456789.", *format) && spec_length < sizeof(spec) - 2) {
+            spec[spec_length++] = *format++;
+        }
+        while (*format == 'l' || *format == 'h') {
+            format++;
+        }
+        if (*format == '\0') {
+            break;
+        }
+        spec[spec_length++] = *format++;
+        spec[spec_length] = '\0';
+        VarHandle value = next_var < input_vars.size() ? input_vars[next_var++] : VarHandle();
+        length += formatValue(memory, spec, value, result + length, sizeof(result) - length);
+    }
+    memory.setString(output_var, result, length);
+}
+
+size_t BlockStringFormat::formatValue(const PlcMemory& memory, const char* spec, VarHandle value, char* out, size_t size) {
+    int written;
+    switch (spec[strlen(spec) - 1]) {
+        case 'd':
+        case 'i':
+            written = snprintf(out, size, spec, static_cast<int>(memory.getValue<int32_t>(value, 0)));
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            written = snprintf(out, size, spec, static_cast<unsigned int>(memory.getValue<int32_t>(value, 0)));
+            break;
+        case 'c':
+            written = snprintf(out, size, spec, static_cast<int>(memory.getValue<int32_t>(value, 0)));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            written = snprintf(out, size, spec, static_cast<double>(memory.getValue<float>(value, 0.0f)));
+            break;
+        case 's': {
+            char text[PLC_STRING_SIZE];
+            written = snprintf(out, size, spec, memory.getText(value, text, sizeof(text)));
+            break;
+        }
+        default: // Not a conversion: copied as written
+            written = snprintf(out, size, "%s", spec);
+            break;
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
     }
-    memory.setValue<String>(output_var, result_str);
+    return static_cast<size_t>(written) < size ? static_cast<size_t>(written) : size - 1;
 }
 
-JsonDocument BlockStringFormat::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Formats a string with variables";
-    schema["inputs"]["format_string"]["type"] = "string";
-    schema["inputs"]["vars"]["type"] = "array";
-    schema["inputs"]["vars"]["items"]["type"] = "string";
-    schema["outputs"]["out"]["type"] = "string";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockStringFormat::INPUTS[] = {{"format_string", "string"}, {"vars", "any[]"}, {}};
+const PlcPinInfo BlockStringFormat::OUTPUTS[] = {{"out", "string"}, {}};
+const PlcBlockDescriptor BlockStringFormat::DESCRIPTOR = {"string", "Formats variables printf-style (%d %u %x %f %e %g %s %c)", INPUTS, OUTPUTS};
@@ -7,14 +7,23 @@
 
 class BlockStringFormat : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "STRING_FORMAT";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
 
 private:
-    std::string format_string_var;
-    std::vector<std::string> input_vars; // Variables to insert into format string
-    std::string output_var;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle format_string_var;
+    PlcHandleList input_vars; // Variables to insert into format string
+    VarHandle output_var;
+
+    // One conversion of the format for the value of a variable of any type,
+    // into out (truncated to size - 1). Returns the length written.
+    static size_t formatValue(const PlcMemory& memory, const char* spec, VarHandle value, char* out, size_t size);
 };
 
 #endif // PLC_BLOCK_STRING_FORMAT_H
\ No newline at end of file
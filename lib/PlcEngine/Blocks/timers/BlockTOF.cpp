@@ -1,59 +1,48 @@
 #include "BlockTOF.h"
 
-BlockTOF::BlockTOF() : preset_time(0), start_time(0), timing(false), last_input_state(false) {
+BlockTOF::BlockTOF() : preset_time(0), last_input_state(false) {
 }
 
 bool BlockTOF::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::BOOL);
         preset_time = config["inputs"]["pt"];
     }
     if (config.containsKey("outputs")) {
-        output_var_q = config["outputs"]["q"].as<std::string>();
+        output_var_q = bindOutput(memory, config["outputs"]["q"], PlcValueType::BOOL);
         if (config["outputs"].containsKey("et")) {
-            output_var_et = config["outputs"]["et"].as<std::string>();
+            output_var_et = bindOutput(memory, config["outputs"]["et"], PlcValueType::DINT);
         }
     }
-    return true; // Basic validation for now
+    return timers != nullptr;
 }
 
 void BlockTOF::evaluate(PlcMemory& memory) {
     bool in = memory.getValue<bool>(input_var, false);
-    unsigned long current_time = millis();
-    unsigned long elapsed_time = 0;
 
     if (!in && last_input_state) { // Falling edge
-        timing = true;
-        start_time = current_time;
+        timers->arm(timer, preset_time);
     }
 
-    if (timing) {
-        elapsed_time = current_time - start_time;
-        if (elapsed_time >= preset_time) {
-            timing = false;
-            memory.setValue<bool>(output_var_q, false);
-            elapsed_time = preset_time;
-        } else {
-            memory.setValue<bool>(output_var_q, true);
-        }
-    } else {
-        memory.setValue<bool>(output_var_q, in);
-        elapsed_time = 0;
+    uint32_t elapsed_time = timers->elapsed(timer);
+    if (timer.hasExpired()) {
+        timers->disarm(timer); // ET shows the preset time for this one scan
     }
+    memory.setValue<bool>(output_var_q, in || timer.isRunning());
 
-    if (!output_var_et.empty()) {
+    if (output_var_et.isValid()) {
         memory.setValue<uint32_t>(output_var_et, elapsed_time);
     }
 
     last_input_state = in;
 }
 
-JsonDocument BlockTOF::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Timer OFF Delay block";
-    schema["inputs"]["in"]["type"] = "bool";
-    schema["inputs"]["pt"]["type"] = "uint32";
-    schema["outputs"]["q"]["type"] = "bool";
-    schema["outputs"]["et"]["type"] = "uint32";
-    return schema;
-}
\ No newline at end of file
+const PlcPinInfo BlockTOF::INPUTS[] = {{"in", "bool"}, {"pt", "uint32"}, {}};
+const PlcPinInfo BlockTOF::OUTPUTS[] = {{"q", "bool"}, {"et", "uint32"}, {}};
+const PlcBlockDescriptor BlockTOF::DESCRIPTOR = {"timers", "Timer OFF Delay block", INPUTS, OUTPUTS};
+
+void BlockTOF::migrateState(const PlcBlock& previous) {
+    const BlockTOF& old = static_cast<const BlockTOF&>(previous);
+    timers->migrate(timer, old.timer);
+    last_input_state = old.last_input_state;
+}
@@ -6,18 +6,27 @@
 
 class BlockTOF : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "TOF";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockTOF();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    // Only ET needs every scan; Q changes with the input or the falling-edge delay expiring
+    bool isAlwaysLive() const override { return output_var_et.isValid(); }
+    bool needsScan() const override { return output_var_et.isValid() && timer.isRunning(); }
+    PlcTimer* getTimer() override { return &timer; }
 
 private:
-    std::string input_var;
-    std::string output_var_q;
-    std::string output_var_et;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_var;
+    VarHandle output_var_q;
+    VarHandle output_var_et;
     unsigned long preset_time;
-    unsigned long start_time;
-    bool timing;
+    PlcTimer timer;
     bool last_input_state;
 };
 
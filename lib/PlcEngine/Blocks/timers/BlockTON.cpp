@@ -1,58 +1,47 @@
 #include "BlockTON.h"
 
-BlockTON::BlockTON() : preset_time(0), start_time(0), timing(false) {
+BlockTON::BlockTON() : preset_time(0) {
 }
 
 bool BlockTON::configure(const JsonObject& config, PlcMemory& memory) {
     if (config.containsKey("inputs")) {
-        input_var = config["inputs"]["in"].as<std::string>();
+        input_var = bindInput(memory, config["inputs"]["in"], PlcValueType::BOOL);
         preset_time = config["inputs"]["pt"];
     }
     if (config.containsKey("outputs")) {
-        output_var_q = config["outputs"]["q"].as<std::string>();
+        output_var_q = bindOutput(memory, config["outputs"]["q"], PlcValueType::BOOL);
         if (config["outputs"].containsKey("et")) {
-            output_var_et = config["outputs"]["et"].as<std::string>();
+            output_var_et = bindOutput(memory, config["outputs"]["et"], PlcValueType::DINT);
         }
     }
-    return true;
+    return timers != nullptr;
 }
 
-JsonDocument BlockTON::getBlockSchema() {
-    JsonDocument schema;
-    schema["description"] = "Timer ON Delay block";
-    schema["inputs"]["in"]["type"] = "bool";
-    schema["inputs"]["pt"]["type"] = "uint32";
-    schema["outputs"]["q"]["type"] = "bool";
-    schema["outputs"]["et"]["type"] = "uint32";
-    return schema;
-}
+const PlcPinInfo BlockTON::INPUTS[] = {{"in", "bool"}, {"pt", "uint32"}, {}};
+const PlcPinInfo BlockTON::OUTPUTS[] = {{"q", "bool"}, {"et", "uint32"}, {}};
+const PlcBlockDescriptor BlockTON::DESCRIPTOR = {"timers", "Timer ON Delay block", INPUTS, OUTPUTS};
 
 void BlockTON::evaluate(PlcMemory& memory) {
     bool in = memory.getValue<bool>(input_var, false);
-    unsigned long current_time = millis();
-    unsigned long elapsed_time = 0;
-
-    if (in && !timing) {
-        // Rising edge
-        timing = true;
-        start_time = current_time;
-    }
 
-    if (timing) {
-        elapsed_time = current_time - start_time;
-        if (elapsed_time >= preset_time) {
+    if (!in) {
+        timers->disarm(timer);
+        memory.setValue<bool>(output_var_q, false);
+    } else {
+        if (timer.isIdle()) {
+            timers->arm(timer, preset_time); // Rising edge
+        }
+        if (timer.hasExpired()) {
             memory.setValue<bool>(output_var_q, true);
-            elapsed_time = preset_time;
         }
     }
 
-    if (!in) {
-        timing = false;
-        memory.setValue<bool>(output_var_q, false);
-        elapsed_time = 0;
+    if (output_var_et.isValid()) {
+        memory.setValue<uint32_t>(output_var_et, timers->elapsed(timer));
     }
+}
 
-    if (!output_var_et.empty()) {
-        memory.setValue<uint32_t>(output_var_et, elapsed_time);
-    }
-}
\ No newline at end of file
+void BlockTON::migrateState(const PlcBlock& previous) {
+    const BlockTON& old = static_cast<const BlockTON&>(previous);
+    timers->migrate(timer, old.timer);
+}
@@ -6,18 +6,27 @@
 
 class BlockTON : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "TON";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockTON();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    // Woken by input changes and the expiry, unless ET has to count on every scan
+    bool isAlwaysLive() const override { return output_var_et.isValid(); }
+    bool needsScan() const override { return output_var_et.isValid() && timer.isRunning(); } // ET counting
+    PlcTimer* getTimer() override { return &timer; }
 
 private:
-    std::string input_var;
-    std::string output_var_q;
-    std::string output_var_et;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_var;
+    VarHandle output_var_q;
+    VarHandle output_var_et;
     unsigned long preset_time;
-    unsigned long start_time;
-    bool timing;
+    PlcTimer timer;
 };
 
 #endif // PLC_BLOCK_TON_H
\ No newline at end of file
@@ -6,18 +6,27 @@
 
 class BlockTP : public PlcBlock {
 public:
+    static constexpr const char* TYPE = "TP";
+    static const PlcBlockDescriptor DESCRIPTOR;
+
     BlockTP();
     bool configure(const JsonObject& config, PlcMemory& memory) override;
     void evaluate(PlcMemory& memory) override;
-    JsonDocument getBlockSchema() override;
+    void migrateState(const PlcBlock& previous) override;
+    // ET counts on every scan; without it the block waits for an edge or the pulse end
+    bool isAlwaysLive() const override { return output_var_et.isValid(); }
+    bool needsScan() const override { return output_var_et.isValid() && timer.isRunning(); } // During the pulse
+    PlcTimer* getTimer() override { return &timer; }
 
 private:
-    std::string input_var;
-    std::string output_var_q;
-    std::string output_var_et;
+    static const PlcPinInfo INPUTS[];
+    static const PlcPinInfo OUTPUTS[];
+
+    VarHandle input_var;
+    VarHandle output_var_q;
+    VarHandle output_var_et;
     unsigned long pulse_time;
-    unsigned long start_time;
-    bool timing;
+    PlcTimer timer;
     bool last_input_state;
 };
 
@@ -0,0 +1,63 @@
+#include "../PlcEngine/Engine/PlcArena.h"
+#ifndef UNIT_TEST
+#include <esp_heap_caps.h>
+#endif
+
+PlcArena::PlcArena()
+    : chunks(nullptr), cursor(nullptr), end(nullptr), capacity(0), used(0), overflow(0), chunkCount(0) {
+}
+
+bool PlcArena::reserve(size_t size) {
+    release();
+    Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size, std::nothrow));
+    if (chunk == nullptr) {
+        return false;
+    }
+    addChunk(chunk, size);
+    return true;
+}
+
+void PlcArena::release() {
+    while (chunks) {
+        Chunk* next = chunks->next;
+        ::operator delete(chunks);
+        chunks = next;
+    }
+    cursor = end = nullptr;
+    capacity = used = overflow = chunkCount = 0;
+}
+
+void PlcArena::addChunk(Chunk* chunk, size_t size) {
+    chunk->next = chunks;
+    chunk->size = size;
+    if (chunks) {
+        overflow += size;
+    }
+    chunks = chunk;
+    cursor = reinterpret_cast<uint8_t*>(chunk + 1);
+    end = cursor + size;
+    capacity += size;
+    chunkCount++;
+}
+
+void* PlcArena::allocate(size_t size, size_t alignment) {
+    uintptr_t at = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (cursor == nullptr || at + size > reinterpret_cast<uintptr_t>(end)) {
+        // The rest of the current chunk is abandoned. Out of memory fails
+        // the same way as new.
+        size_t chunkSize = size + alignment > CHUNK_SIZE ? size + alignment : CHUNK_SIZE;
+        addChunk(static_cast<Chunk*>(::operator new(sizeof(Chunk) + chunkSize)), chunkSize);
+        at = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    used += at + size - reinterpret_cast<uintptr_t>(cursor);
+    cursor = reinterpret_cast<uint8_t*>(at + size);
+    return reinterpret_cast<void*>(at);
+}
+
+size_t PlcArena::largestFreeBlock() {
+#ifndef UNIT_TEST
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#else
+    return 0;
+#endif
+}
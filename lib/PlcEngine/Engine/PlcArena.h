@@ -0,0 +1,109 @@
+#ifndef PLC_ARENA_H
+#define PLC_ARENA_H
+
+#include <Arduino.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * PlcArena - bump allocator for everything a loaded program keeps.
+ *
+ * PlcProgram sizes the arena from the program before creating its blocks,
+ * so blocks, their handle lists and the program tables share one heap
+ * allocation instead of hundreds of small ones, and unloading a program
+ * returns it in one piece. Individual frees are no-ops. If the estimate
+ * is too small, further chunks of at least CHUNK_SIZE bytes are added;
+ * they are released together with the first one.
+ */
+class PlcArena {
+public:
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    PlcArena();
+    ~PlcArena() { release(); }
+    PlcArena(const PlcArena&) = delete;
+    PlcArena& operator=(const PlcArena&) = delete;
+
+    // Allocate the first chunk; previous chunks must have been released
+    bool reserve(size_t capacity);
+    void release();
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    size_t getCapacity() const { return capacity; }   // All chunks
+    size_t getUsed() const { return used; }           // Bytes handed out, including padding
+    size_t getOverflow() const { return overflow; }   // Bytes in chunks added after reserve()
+    size_t getChunkCount() const { return chunkCount; }
+
+    // Largest allocatable heap block, to watch fragmentation (0 on the native build)
+    static size_t largestFreeBlock();
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    Chunk* chunks;      // Newest first
+    uint8_t* cursor;
+    uint8_t* end;
+    size_t capacity;
+    size_t used;
+    size_t overflow;
+    size_t chunkCount;
+
+    void addChunk(Chunk* chunk, size_t size);
+};
+
+/**
+ * STL allocator over a PlcArena. Without an arena it uses the heap, so
+ * containers and blocks work the same outside of a program.
+ */
+template <typename T>
+class PlcArenaAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    PlcArenaAllocator(PlcArena* arena = nullptr) : _arena(arena) {}
+    template <typename U>
+    PlcArenaAllocator(const PlcArenaAllocator<U>& other) : _arena(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (_arena) {
+            return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+        if (!_arena) {
+            ::operator delete(p);
+        }
+    }
+
+    PlcArena* arena() const { return _arena; }
+
+    template <typename U>
+    bool operator==(const PlcArenaAllocator<U>& other) const { return _arena == other.arena(); }
+    template <typename U>
+    bool operator!=(const PlcArenaAllocator<U>& other) const { return _arena != other.arena(); }
+
+private:
+    PlcArena* _arena;
+};
+
+template <typename T>
+using PlcArenaVector = std::vector<T, PlcArenaAllocator<T>>;
+
+#endif // PLC_ARENA_H
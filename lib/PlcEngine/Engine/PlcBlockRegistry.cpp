@@ -0,0 +1,231 @@
+#include "../PlcEngine/Engine/PlcBlockRegistry.h"
+
+#include "../Blocks/logic/BlockAND.h"
+#include "../Blocks/logic/BlockOR.h"
+#include "../Blocks/logic/BlockNOT.h"
+#include "../Blocks/logic/BlockXOR.h"
+#include "../Blocks/logic/BlockNAND.h"
+#include "../Blocks/logic/BlockNOR.h"
+#include "../Blocks/logic/BlockSR.h"
+#include "../Blocks/logic/BlockST.h"
+#include "../Blocks/logic/BlockRS.h"
+#include "../Blocks/logic/BlockSequencer.h"
+#include "../Blocks/timers/BlockTON.h"
+#include "../Blocks/timers/BlockTOF.h"
+#include "../Blocks/timers/BlockTP.h"
+#include "../Blocks/counters/BlockCTU.h"
+#include "../Blocks/counters/BlockCTD.h"
+#include "../Blocks/counters/BlockCTUD.h"
+#include "../Blocks/math/BlockADD.h"
+#include "../Blocks/math/BlockSUB.h"
+#include "../Blocks/math/BlockMUL.h"
+#include "../Blocks/math/BlockDIV.h"
+#include "../Blocks/math/BlockMOD.h"
+#include "../Blocks/math/BlockABS.h"
+#include "../Blocks/math/BlockSQRT.h"
+#include "../Blocks/math/BlockINC.h"
+#include "../Blocks/math/BlockDEC.h"
+#include "../Blocks/math/BlockEXPR.h"
+#include "../Blocks/comparison/BlockGT.h"
+#include "../Blocks/comparison/BlockEQ.h"
+#include "../Blocks/comparison/BlockNE.h"
+#include "../Blocks/comparison/BlockLT.h"
+#include "../Blocks/comparison/BlockGE.h"
+#include "../Blocks/comparison/BlockLE.h"
+#include "../Blocks/scheduler/BlockTimeCompare.h"
+#include "../Blocks/conversion/BlockBoolArrayToInt8.h"
+#include "../Blocks/conversion/BlockInt8ToInt16.h"
+#include "../Blocks/conversion/BlockInt8ToUint8.h"
+#include "../Blocks/conversion/BlockInt16ToUint16.h"
+#include "../Blocks/conversion/BlockInt32ToTime.h"
+#include "../Blocks/conversion/BlockInt16ToFloat.h"
+#include "../Blocks/conversion/BlockInt32ToDouble.h"
+#include "../Blocks/string/BlockStringConcat.h"
+#include "../Blocks/string/BlockStringFind.h"
+#include "../Blocks/string/BlockStringCopy.h"
+#include "../Blocks/string/BlockStringFormat.h"
+#include "../Blocks/events/BlockStatusHandler.h"
+#include "../Blocks/array/BlockArraySum.h"
+#include "../Blocks/array/BlockArrayAvg.h"
+#include "../Blocks/array/BlockArrayMin.h"
+#include "../Blocks/array/BlockArrayMax.h"
+#include "../Blocks/array/BlockArrayAdd.h"
+#include "../Blocks/array/BlockArrayMul.h"
+#include "../Blocks/array/BlockArrayScale.h"
+#include "../Blocks/array/BlockArrayDot.h"
+#include "../Blocks/array/BlockArrayCountGt.h"
+#include "../Blocks/array/BlockArrayAnd.h"
+#include "../Blocks/array/BlockArrayOr.h"
+#include "../Blocks/array/BlockArrayXor.h"
+#include "../Blocks/array/BlockArrayNot.h"
+#include "../Blocks/array/BlockArrayRTrig.h"
+#include "../Blocks/array/BlockArrayFTrig.h"
+
+namespace {
+
+template <typename T, typename... Args>
+PlcBlock* place(PlcArena* arena, const PlcBlockContext& context, Args&&... args) {
+    PlcBlock* block = arena ? static_cast<PlcBlock*>(arena->create<T>(std::forward<Args>(args)...))
+                            : new T(std::forward<Args>(args)...);
+    block->setArena(arena);
+    block->setTimers(context.timers);
+    block->setCycleContext(context.cycle);
+    return block;
+}
+
+template <typename T>
+PlcBlock* construct(PlcArena* arena, const PlcBlockContext& context) {
+    return place<T>(arena, context);
+}
+
+#define PLC_BLOCK(Class) {Class::TYPE, &construct<Class>, &Class::DESCRIPTOR, sizeof(Class)}
+
+// Sorted by type name (strcmp order)
+constexpr PlcBlockRegistry::Entry ENTRIES[] = {
+    PLC_BLOCK(BlockABS),
+    PLC_BLOCK(BlockADD),
+    PLC_BLOCK(BlockAND),
+    PLC_BLOCK(BlockArrayAdd),
+    PLC_BLOCK(BlockArrayAnd),
+    PLC_BLOCK(BlockArrayAvg),
+    PLC_BLOCK(BlockArrayCountGt),
+    PLC_BLOCK(BlockArrayDot),
+    PLC_BLOCK(BlockArrayFTrig),
+    PLC_BLOCK(BlockArrayMax),
+    PLC_BLOCK(BlockArrayMin),
+    PLC_BLOCK(BlockArrayMul),
+    PLC_BLOCK(BlockArrayNot),
+    PLC_BLOCK(BlockArrayOr),
+    PLC_BLOCK(BlockArrayRTrig),
+    PLC_BLOCK(BlockArrayScale),
+    PLC_BLOCK(BlockArraySum),
+    PLC_BLOCK(BlockArrayXor),
+    PLC_BLOCK(BlockBoolArrayToInt8),
+    PLC_BLOCK(BlockCTD),
+    PLC_BLOCK(BlockCTU),
+    PLC_BLOCK(BlockCTUD),
+    PLC_BLOCK(BlockDEC),
+    PLC_BLOCK(BlockDIV),
+    PLC_BLOCK(BlockEQ),
+    PLC_BLOCK(BlockEXPR),
+    PLC_BLOCK(BlockGE),
+    PLC_BLOCK(BlockGT),
+    PLC_BLOCK(BlockINC),
+    PLC_BLOCK(BlockInt16ToFloat),
+    PLC_BLOCK(BlockInt16ToUint16),
+    PLC_BLOCK(BlockInt32ToDouble),
+    PLC_BLOCK(BlockInt32ToTime),
+    PLC_BLOCK(BlockInt8ToInt16),
+    PLC_BLOCK(BlockInt8ToUint8),
+    PLC_BLOCK(BlockLE),
+    PLC_BLOCK(BlockLT),
+    PLC_BLOCK(BlockMOD),
+    PLC_BLOCK(BlockMUL),
+    PLC_BLOCK(BlockNAND),
+    PLC_BLOCK(BlockNE),
+    PLC_BLOCK(BlockNOR),
+    PLC_BLOCK(BlockNOT),
+    PLC_BLOCK(BlockOR),
+    PLC_BLOCK(BlockRS),
+    PLC_BLOCK(BlockSequencer),
+    PLC_BLOCK(BlockSQRT),
+    PLC_BLOCK(BlockSR),
+    PLC_BLOCK(BlockST),
+    PLC_BLOCK(BlockStringConcat),
+    PLC_BLOCK(BlockStringCopy),
+    PLC_BLOCK(BlockStringFind),
+    PLC_BLOCK(BlockStringFormat),
+    PLC_BLOCK(BlockSUB),
+    PLC_BLOCK(BlockStatusHandler),
+    PLC_BLOCK(BlockTimeCompare),
+    PLC_BLOCK(BlockTOF),
+    PLC_BLOCK(BlockTON),
+    PLC_BLOCK(BlockTP),
+    PLC_BLOCK(BlockXOR),
+};
+
+#undef PLC_BLOCK
+
+constexpr size_t ENTRY_COUNT = sizeof(ENTRIES) / sizeof(ENTRIES[0]);
+
+constexpr int compareNames(const char* a, const char* b) {
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
+}
+
+constexpr bool isSorted() {
+    for (size_t i = 1; i < ENTRY_COUNT; i++) {
+        if (compareNames(ENTRIES[i - 1].type, ENTRIES[i].type) >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isSorted(), "PlcBlockRegistry entries must be sorted by type name and unique");
+
+} // namespace
+
+const PlcBlockRegistry::Entry* PlcBlockRegistry::find(const char* type) {
+    if (type == nullptr) {
+        return nullptr;
+    }
+    size_t low = 0;
+    size_t high = ENTRY_COUNT;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        int cmp = strcmp(ENTRIES[mid].type, type);
+        if (cmp == 0) {
+            return &ENTRIES[mid];
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<PlcBlock> PlcBlockRegistry::create(const char* type, const PlcBlockContext& context) {
+    const Entry* entry = find(type);
+    return std::unique_ptr<PlcBlock>(entry ? entry->create(nullptr, context) : nullptr);
+}
+
+size_t PlcBlockRegistry::size() {
+    return ENTRY_COUNT;
+}
+
+const PlcBlockRegistry::Entry& PlcBlockRegistry::at(size_t index) {
+    return ENTRIES[index];
+}
+
+void PlcBlockRegistry::getSchema(const Entry& entry, JsonObject schema) {
+    schema["type"] = entry.type;
+    schema["category"] = entry.descriptor->category;
+    schema["description"] = entry.descriptor->description;
+    JsonObject inputs = schema["inputs"].to<JsonObject>();
+    for (const PlcPinInfo* pin = entry.descriptor->inputs; pin->name != nullptr; pin++) {
+        inputs[pin->name] = pin->type;
+    }
+    JsonObject outputs = schema["outputs"].to<JsonObject>();
+    for (const PlcPinInfo* pin = entry.descriptor->outputs; pin->name != nullptr; pin++) {
+        outputs[pin->name] = pin->type;
+    }
+}
+
+const String& PlcBlockRegistry::getCatalogJson() {
+    static String catalog;
+    if (catalog.length() == 0) {
+        JsonDocument doc;
+        JsonArray blocks = doc.to<JsonArray>();
+        for (size_t i = 0; i < ENTRY_COUNT; i++) {
+            getSchema(ENTRIES[i], blocks.add<JsonObject>());
+        }
+        serializeJson(doc, catalog);
+    }
+    return catalog;
+}
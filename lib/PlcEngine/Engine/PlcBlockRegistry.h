@@ -0,0 +1,54 @@
+#ifndef PLC_BLOCK_REGISTRY_H
+#define PLC_BLOCK_REGISTRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <memory>
+#include "../Blocks/PlcBlock.h"
+#include "../PlcEngine/Engine/PlcArena.h"
+
+class TimeManager;
+class MeshDeviceManager;
+
+// Services a block may need at construction
+struct PlcBlockContext {
+    TimeManager* timeManager;
+    MeshDeviceManager* meshDeviceManager;
+    PlcTimerWheel* timers;  // Timer service of the program
+    const PlcCycleContext* cycle; // Scan time of the program
+};
+
+/**
+ * PlcBlockRegistry - the block types a program can use.
+ *
+ * A static table sorted by type name (checked at compile time) with each
+ * type's factory and descriptor. Lookup is a binary search. Adding a block
+ * type means giving the class a TYPE and DESCRIPTOR and adding it to the
+ * table in PlcBlockRegistry.cpp.
+ */
+class PlcBlockRegistry {
+public:
+    // Constructs the block in arena, or on the heap if arena is nullptr
+    typedef PlcBlock* (*Factory)(PlcArena* arena, const PlcBlockContext& context);
+
+    struct Entry {
+        const char* type;
+        Factory create;
+        const PlcBlockDescriptor* descriptor;
+        size_t size;    // sizeof the block class
+    };
+
+    static const Entry* find(const char* type);  // nullptr if unknown
+    // Heap-allocated block, nullptr if the type is unknown
+    static std::unique_ptr<PlcBlock> create(const char* type, const PlcBlockContext& context);
+
+    static size_t size();
+    static const Entry& at(size_t index);
+
+    // {"type", "category", "description", "inputs": {"name": "type"}, "outputs": {...}}
+    static void getSchema(const Entry& entry, JsonObject schema);
+    // Array of all schemas, serialized once on the first call
+    static const String& getCatalogJson();
+};
+
+#endif // PLC_BLOCK_REGISTRY_H
@@ -0,0 +1,620 @@
+#include "../PlcEngine/Engine/PlcBytecode.h"
+#include "../PlcEngine/Engine/PlcExpression.h"
+#include "../PlcEngine/Engine/PlcTypedOps.h"
+#include "../Blocks/PlcBlock.h"
+#include <cmath>
+
+PlcBytecode::PlcBytecode() : loweredCount(0) {
+}
+
+void PlcBytecode::clear() {
+    code.clear();
+    operands.clear();
+    fallbacks.clear();
+    expressions.clear();
+    loweredCount = 0;
+}
+
+void PlcBytecode::emit(PlcOpcode op, uint8_t count, uint16_t dst, uint16_t a, uint16_t b) {
+    PlcInstruction instr;
+    instr.op = static_cast<uint8_t>(op);
+    instr.count = count;
+    instr.dst = dst;
+    instr.a = a;
+    instr.b = b;
+    code.push_back(instr);
+}
+
+PlcOpcode PlcBytecode::slotTypedVariant(PlcOpcode op, bool uniform, PlcValueType type) {
+    if (!uniform) {
+        return op;
+    }
+    switch (type) {
+        case PlcValueType::BOOL:
+            switch (op) {
+                case PlcOpcode::AND_B: return PlcOpcode::AND_BB;
+                case PlcOpcode::OR_B: return PlcOpcode::OR_BB;
+                case PlcOpcode::NOT_B: return PlcOpcode::NOT_BB;
+                default: break;
+            }
+            break;
+        case PlcValueType::REAL:
+            switch (op) {
+                case PlcOpcode::ADD_R: return PlcOpcode::ADD_RR;
+                case PlcOpcode::SUB_R: return PlcOpcode::SUB_RR;
+                case PlcOpcode::MUL_R: return PlcOpcode::MUL_RR;
+                case PlcOpcode::DIV_R: return PlcOpcode::DIV_RR;
+                case PlcOpcode::GT_R: return PlcOpcode::GT_RR;
+                case PlcOpcode::GE_R: return PlcOpcode::GE_RR;
+                case PlcOpcode::LT_R: return PlcOpcode::LT_RR;
+                case PlcOpcode::LE_R: return PlcOpcode::LE_RR;
+                case PlcOpcode::EQ_R: return PlcOpcode::EQ_RR;
+                case PlcOpcode::NE_R: return PlcOpcode::NE_RR;
+                default: break;
+            }
+            break;
+        case PlcValueType::INT:
+            switch (op) {
+                case PlcOpcode::ADD_R: return PlcOpcode::ADD_II;
+                case PlcOpcode::SUB_R: return PlcOpcode::SUB_II;
+                case PlcOpcode::MUL_R: return PlcOpcode::MUL_II;
+                case PlcOpcode::DIV_R: return PlcOpcode::DIV_II;
+                case PlcOpcode::GT_R: return PlcOpcode::GT_II;
+                case PlcOpcode::GE_R: return PlcOpcode::GE_II;
+                case PlcOpcode::LT_R: return PlcOpcode::LT_II;
+                case PlcOpcode::LE_R: return PlcOpcode::LE_II;
+                case PlcOpcode::EQ_R: return PlcOpcode::EQ_II;
+                case PlcOpcode::NE_R: return PlcOpcode::NE_II;
+                default: break;
+            }
+            break;
+        case PlcValueType::DINT:
+            switch (op) {
+                case PlcOpcode::ADD_R: return PlcOpcode::ADD_DD;
+                case PlcOpcode::SUB_R: return PlcOpcode::SUB_DD;
+                case PlcOpcode::MUL_R: return PlcOpcode::MUL_DD;
+                case PlcOpcode::DIV_R: return PlcOpcode::DIV_DD;
+                case PlcOpcode::GT_R: return PlcOpcode::GT_DD;
+                case PlcOpcode::GE_R: return PlcOpcode::GE_DD;
+                case PlcOpcode::LT_R: return PlcOpcode::LT_DD;
+                case PlcOpcode::LE_R: return PlcOpcode::LE_DD;
+                case PlcOpcode::EQ_R: return PlcOpcode::EQ_DD;
+                case PlcOpcode::NE_R: return PlcOpcode::NE_DD;
+                default: break;
+            }
+            break;
+        default:
+            break;
+    }
+    return op;
+}
+
+bool PlcBytecode::emitNary(PlcOpcode op, VarHandle dst, const PlcHandleList& inputs) {
+    if (!dst.isValid() || inputs.empty() || inputs.size() > 255) {
+        return false;
+    }
+    for (const VarHandle& in : inputs) {
+        if (!in.isValid()) {
+            return false;
+        }
+    }
+
+    bool uniform = true;
+    uint16_t offset = static_cast<uint16_t>(operands.size());
+    for (const VarHandle& in : inputs) {
+        operands.push_back(in.index);
+        uniform = uniform && in.type == dst.type;
+    }
+    emit(slotTypedVariant(op, uniform, dst.type), static_cast<uint8_t>(inputs.size()), dst.index, offset, 0);
+    loweredCount++;
+    return true;
+}
+
+bool PlcBytecode::emitUnary(PlcOpcode op, VarHandle dst, VarHandle in) {
+    if (!dst.isValid() || !in.isValid()) {
+        return false;
+    }
+    emit(slotTypedVariant(op, dst.type == in.type, dst.type), 1, dst.index, in.index, 0);
+    loweredCount++;
+    return true;
+}
+
+bool PlcBytecode::emitBinary(PlcOpcode op, VarHandle dst, VarHandle in1, VarHandle in2) {
+    if (!dst.isValid() || !in1.isValid() || !in2.isValid()) {
+        return false;
+    }
+    // Comparisons write a bool, so only the inputs decide the variant
+    bool uniform = in1.type == in2.type && dst.type == PlcValueType::BOOL;
+    emit(slotTypedVariant(op, uniform, in1.type), 2, dst.index, in1.index, in2.index);
+    loweredCount++;
+    return true;
+}
+
+bool PlcBytecode::emitExpression(VarHandle dst, const PlcExpression& expression) {
+    if (!dst.isValid() || expression.isEmpty()) {
+        return false;
+    }
+    emit(PlcOpcode::EXPR, static_cast<uint8_t>(expression.getType()), dst.index,
+         static_cast<uint16_t>(expressions.size()), 0);
+    expressions.push_back(&expression);
+    loweredCount++;
+    return true;
+}
+
+void PlcBytecode::emitCall(PlcBlock* block) {
+    emit(PlcOpcode::CALL_BLOCK, 0, 0, static_cast<uint16_t>(fallbacks.size()), 0);
+    fallbacks.push_back(block);
+}
+
+void PlcBytecode::finish() {
+    emit(PlcOpcode::END, 0, 0, 0, 0);
+}
+
+size_t PlcBytecode::getMemoryUsage() const {
+    return code.capacity() * sizeof(PlcInstruction)
+         + operands.capacity() * sizeof(uint16_t)
+         + fallbacks.capacity() * sizeof(PlcBlock*)
+         + expressions.capacity() * sizeof(const PlcExpression*);
+}
+
+#ifdef PLC_PROFILING
+void PlcBytecode::execute(PlcMemory& memory, PlcProfiler* profiler, size_t entry) const {
+#else
+void PlcBytecode::execute(PlcMemory& memory, size_t entry) const {
+#endif
+    if (code.empty()) {
+        return;
+    }
+
+    const PlcVariable* slots = memory.slots.data();
+    uint32_t* bits = memory.boolBits.data();
+    float* reals = memory.realValues.data();
+    int16_t* ints = memory.intValues.data();
+    int32_t* dints = memory.dintValues.data();
+    const uint16_t* pool = operands.data();
+    const PlcInstruction* ip = code.data() + entry;
+
+#ifdef PLC_PROFILING
+    // Instruction i is logic block i, less the END of every segment before
+    // it, see PlcProgram::compileBytecode()
+    size_t ends = 0;
+    for (size_t i = 0; i < entry; i++) {
+        ends += code[i].op == static_cast<uint8_t>(PlcOpcode::END);
+    }
+    uint32_t mark = PlcProfiler::readCounter();
+#define VM_PROFILE() \
+    do { \
+        if (profiler) { \
+            uint32_t now = PlcProfiler::readCounter(); \
+            profiler->recordBlock(ip - code.data() - ends, now - mark); \
+            mark = now; \
+        } \
+    } while (0)
+#else
+#define VM_PROFILE()
+#endif
+
+// Typed slot access, same conversions as PlcMemory::getValue/setValue
+#define RD(T, idx) memory.readSlot<T>(slots[(idx)])
+#define WR(T, idx, v) memory.writeSlot<T>(slots[(idx)], (v))
+// Slots declared with the working type: the bit or float in its segment
+#define B(idx) ((bits[slots[(idx)].offset >> 5] >> (slots[(idx)].offset & 31)) & 1)
+#define SET_B(idx, v) \
+    do { \
+        uint16_t bit_ = slots[(idx)].offset; \
+        uint32_t mask_ = 1u << (bit_ & 31); \
+        bits[bit_ >> 5] = (v) ? (bits[bit_ >> 5] | mask_) : (bits[bit_ >> 5] & ~mask_); \
+    } while (0)
+#define F(idx) reals[slots[(idx)].offset]
+#define I16(idx) ints[slots[(idx)].offset]
+#define I32(idx) dints[slots[(idx)].offset]
+// N-ary arithmetic and comparisons with the block kernels' operations.
+// SLOT reads and writes a slot of the working type T.
+#define VM_FOLD(T, SLOT, Op) \
+    do { \
+        T acc_ = SLOT(pool[ip->a]); \
+        for (uint8_t i_ = 1; i_ < ip->count && Op::step(acc_, SLOT(pool[ip->a + i_])); ++i_) { \
+        } \
+        SLOT(ip->dst) = acc_; \
+    } while (0)
+#define VM_COMPARE(SLOT, Op) SET_B(ip->dst, Op::test(SLOT(ip->a), SLOT(ip->b)))
+
+#if PLC_VM_COMPUTED_GOTO
+    static const void* const dispatch[] = {
+        &&op_END, &&op_CALL_BLOCK, &&op_EXPR,
+        &&op_AND_B, &&op_OR_B, &&op_XOR_B, &&op_NAND_B, &&op_NOR_B,
+        &&op_ADD_R, &&op_SUB_R, &&op_MUL_R, &&op_DIV_R, &&op_PACK_B8,
+        &&op_NOT_B, &&op_ABS_R, &&op_SQRT_R, &&op_INC_I, &&op_DEC_I,
+        &&op_I8_TO_I16, &&op_I8_TO_U8, &&op_I16_TO_U16, &&op_I16_TO_R, &&op_I32_TO_R,
+        &&op_SR_B, &&op_RS_B, &&op_MOD_I,
+        &&op_GT_R, &&op_GE_R, &&op_LT_R, &&op_LE_R, &&op_EQ_R, &&op_NE_R,
+        &&op_AND_BB, &&op_OR_BB, &&op_NOT_BB,
+        &&op_ADD_RR, &&op_SUB_RR, &&op_MUL_RR,
+        &&op_GT_RR, &&op_GE_RR, &&op_LT_RR, &&op_LE_RR, &&op_EQ_RR, &&op_NE_RR,
+        &&op_DIV_RR,
+        &&op_ADD_II, &&op_SUB_II, &&op_MUL_II, &&op_DIV_II,
+        &&op_GT_II, &&op_GE_II, &&op_LT_II, &&op_LE_II, &&op_EQ_II, &&op_NE_II,
+        &&op_ADD_DD, &&op_SUB_DD, &&op_MUL_DD, &&op_DIV_DD,
+        &&op_GT_DD, &&op_GE_DD, &&op_LT_DD, &&op_LE_DD, &&op_EQ_DD, &&op_NE_DD
+    };
+    static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == static_cast<size_t>(PlcOpcode::OPCODE_COUNT),
+                  "PLC VM dispatch table out of sync with PlcOpcode");
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *dispatch[ip->op]
+#define VM_NEXT() do { VM_PROFILE(); ++ip; VM_DISPATCH(); } while (0)
+    VM_DISPATCH();
+#else
+#define VM_CASE(name) case PlcOpcode::name:
+#define VM_NEXT() { VM_PROFILE(); ++ip; continue; }
+    for (;;) {
+    switch (static_cast<PlcOpcode>(ip->op)) {
+#endif
+
+    VM_CASE(END)
+        return;
+
+    VM_CASE(CALL_BLOCK)
+        fallbacks[ip->a]->evaluate(memory);
+        // Blocks may declare new variables
+        slots = memory.slots.data();
+        bits = memory.boolBits.data();
+        reals = memory.realValues.data();
+        ints = memory.intValues.data();
+        dints = memory.dintValues.data();
+        VM_NEXT();
+
+    VM_CASE(EXPR) {
+        PlcExprValue value = expressions[ip->a]->evaluate(memory);
+        switch (static_cast<PlcExpression::Type>(ip->count)) {
+            case PlcExpression::Type::BOOL: WR(bool, ip->dst, value.i != 0); break;
+            case PlcExpression::Type::INT: WR(int32_t, ip->dst, value.i); break;
+            case PlcExpression::Type::REAL: WR(float, ip->dst, value.f); break;
+        }
+        VM_NEXT();
+    }
+
+    VM_CASE(AND_B) {
+        bool result = true;
+        for (uint8_t i = 0; i < ip->count; ++i) {
+            if (!RD(bool, pool[ip->a + i])) { result = false; break; }
+        }
+        WR(bool, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(OR_B) {
+        bool result = false;
+        for (uint8_t i = 0; i < ip->count; ++i) {
+            if (RD(bool, pool[ip->a + i])) { result = true; break; }
+        }
+        WR(bool, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(XOR_B) {
+        bool result = RD(bool, pool[ip->a]);
+        for (uint8_t i = 1; i < ip->count; ++i) {
+            result = result ^ RD(bool, pool[ip->a + i]);
+        }
+        WR(bool, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(NAND_B) {
+        bool result = true;
+        for (uint8_t i = 0; i < ip->count; ++i) {
+            if (!RD(bool, pool[ip->a + i])) { result = false; break; }
+        }
+        WR(bool, ip->dst, !result);
+        VM_NEXT();
+    }
+
+    VM_CASE(NOR_B) {
+        bool result = false;
+        for (uint8_t i = 0; i < ip->count; ++i) {
+            if (RD(bool, pool[ip->a + i])) { result = true; break; }
+        }
+        WR(bool, ip->dst, !result);
+        VM_NEXT();
+    }
+
+    VM_CASE(ADD_R) {
+        float result = RD(float, pool[ip->a]);
+        for (uint8_t i = 1; i < ip->count && PlcOpAdd::step(result, RD(float, pool[ip->a + i])); ++i) {
+        }
+        WR(float, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(SUB_R) {
+        float result = RD(float, pool[ip->a]);
+        for (uint8_t i = 1; i < ip->count && PlcOpSub::step(result, RD(float, pool[ip->a + i])); ++i) {
+        }
+        WR(float, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(MUL_R) {
+        float result = RD(float, pool[ip->a]);
+        for (uint8_t i = 1; i < ip->count && PlcOpMul::step(result, RD(float, pool[ip->a + i])); ++i) {
+        }
+        WR(float, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(DIV_R) {
+        float result = RD(float, pool[ip->a]);
+        for (uint8_t i = 1; i < ip->count && PlcOpDiv::step(result, RD(float, pool[ip->a + i])); ++i) {
+        }
+        WR(float, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(PACK_B8) {
+        int8_t result = 0;
+        for (uint8_t i = 0; i < ip->count && i < 8; ++i) {
+            if (RD(bool, pool[ip->a + i])) {
+                result |= (1 << i);
+            }
+        }
+        WR(int8_t, ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(NOT_B)
+        WR(bool, ip->dst, !RD(bool, ip->a));
+        VM_NEXT();
+
+    VM_CASE(ABS_R)
+        WR(float, ip->dst, fabsf(RD(float, ip->a)));
+        VM_NEXT();
+
+    VM_CASE(SQRT_R) {
+        float in = RD(float, ip->a);
+        WR(float, ip->dst, in >= 0 ? sqrtf(in) : 0.0f);
+        VM_NEXT();
+    }
+
+    VM_CASE(INC_I)
+        WR(int16_t, ip->dst, static_cast<int16_t>(RD(int16_t, ip->a) + 1));
+        VM_NEXT();
+
+    VM_CASE(DEC_I)
+        WR(int16_t, ip->dst, static_cast<int16_t>(RD(int16_t, ip->a) - 1));
+        VM_NEXT();
+
+    VM_CASE(I8_TO_I16)
+        WR(int16_t, ip->dst, static_cast<int16_t>(RD(int8_t, ip->a)));
+        VM_NEXT();
+
+    VM_CASE(I8_TO_U8)
+        WR(uint8_t, ip->dst, static_cast<uint8_t>(RD(int8_t, ip->a)));
+        VM_NEXT();
+
+    VM_CASE(I16_TO_U16)
+        WR(uint16_t, ip->dst, static_cast<uint16_t>(RD(int16_t, ip->a)));
+        VM_NEXT();
+
+    VM_CASE(I16_TO_R)
+        WR(float, ip->dst, static_cast<float>(RD(int16_t, ip->a)));
+        VM_NEXT();
+
+    VM_CASE(I32_TO_R)
+        WR(double, ip->dst, static_cast<double>(RD(int32_t, ip->a)));
+        VM_NEXT();
+
+    VM_CASE(SR_B) {
+        bool out = RD(bool, ip->dst);
+        if (RD(bool, ip->b)) {
+            out = false;
+        } else if (RD(bool, ip->a)) {
+            out = true;
+        }
+        WR(bool, ip->dst, out);
+        VM_NEXT();
+    }
+
+    VM_CASE(RS_B) {
+        bool out = RD(bool, ip->dst);
+        if (RD(bool, ip->a)) {
+            out = true;
+        } else if (RD(bool, ip->b)) {
+            out = false;
+        }
+        WR(bool, ip->dst, out);
+        VM_NEXT();
+    }
+
+    VM_CASE(MOD_I) {
+        int16_t divisor = RD(int16_t, ip->b);
+        WR(int16_t, ip->dst, divisor != 0 ? static_cast<int16_t>(RD(int16_t, ip->a) % divisor) : static_cast<int16_t>(0));
+        VM_NEXT();
+    }
+
+    VM_CASE(GT_R)
+        WR(bool, ip->dst, RD(float, ip->a) > RD(float, ip->b));
+        VM_NEXT();
+
+    VM_CASE(GE_R)
+        WR(bool, ip->dst, RD(float, ip->a) >= RD(float, ip->b));
+        VM_NEXT();
+
+    VM_CASE(LT_R)
+        WR(bool, ip->dst, RD(float, ip->a) < RD(float, ip->b));
+        VM_NEXT();
+
+    VM_CASE(LE_R)
+        WR(bool, ip->dst, RD(float, ip->a) <= RD(float, ip->b));
+        VM_NEXT();
+
+    VM_CASE(EQ_R)
+        WR(bool, ip->dst, RD(float, ip->a) == RD(float, ip->b));
+        VM_NEXT();
+
+    VM_CASE(NE_R)
+        WR(bool, ip->dst, RD(float, ip->a) != RD(float, ip->b));
+        VM_NEXT();
+
+    VM_CASE(AND_BB) {
+        bool result = true;
+        for (uint8_t i = 0; i < ip->count; ++i) {
+            if (!B(pool[ip->a + i])) { result = false; break; }
+        }
+        SET_B(ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(OR_BB) {
+        bool result = false;
+        for (uint8_t i = 0; i < ip->count; ++i) {
+            if (B(pool[ip->a + i])) { result = true; break; }
+        }
+        SET_B(ip->dst, result);
+        VM_NEXT();
+    }
+
+    VM_CASE(NOT_BB)
+        SET_B(ip->dst, !B(ip->a));
+        VM_NEXT();
+
+    VM_CASE(ADD_RR)
+        VM_FOLD(float, F, PlcOpAdd);
+        VM_NEXT();
+
+    VM_CASE(SUB_RR)
+        VM_FOLD(float, F, PlcOpSub);
+        VM_NEXT();
+
+    VM_CASE(MUL_RR)
+        VM_FOLD(float, F, PlcOpMul);
+        VM_NEXT();
+
+    VM_CASE(GT_RR)
+        VM_COMPARE(F, PlcOpGt);
+        VM_NEXT();
+
+    VM_CASE(GE_RR)
+        VM_COMPARE(F, PlcOpGe);
+        VM_NEXT();
+
+    VM_CASE(LT_RR)
+        VM_COMPARE(F, PlcOpLt);
+        VM_NEXT();
+
+    VM_CASE(LE_RR)
+        VM_COMPARE(F, PlcOpLe);
+        VM_NEXT();
+
+    VM_CASE(EQ_RR)
+        VM_COMPARE(F, PlcOpEq);
+        VM_NEXT();
+
+    VM_CASE(NE_RR)
+        VM_COMPARE(F, PlcOpNe);
+        VM_NEXT();
+
+    VM_CASE(DIV_RR)
+        VM_FOLD(float, F, PlcOpDiv);
+        VM_NEXT();
+
+    VM_CASE(ADD_II)
+        VM_FOLD(int16_t, I16, PlcOpAdd);
+        VM_NEXT();
+
+    VM_CASE(SUB_II)
+        VM_FOLD(int16_t, I16, PlcOpSub);
+        VM_NEXT();
+
+    VM_CASE(MUL_II)
+        VM_FOLD(int16_t, I16, PlcOpMul);
+        VM_NEXT();
+
+    VM_CASE(DIV_II)
+        VM_FOLD(int16_t, I16, PlcOpDiv);
+        VM_NEXT();
+
+    VM_CASE(GT_II)
+        VM_COMPARE(I16, PlcOpGt);
+        VM_NEXT();
+
+    VM_CASE(GE_II)
+        VM_COMPARE(I16, PlcOpGe);
+        VM_NEXT();
+
+    VM_CASE(LT_II)
+        VM_COMPARE(I16, PlcOpLt);
+        VM_NEXT();
+
+    VM_CASE(LE_II)
+        VM_COMPARE(I16, PlcOpLe);
+        VM_NEXT();
+
+    VM_CASE(EQ_II)
+        VM_COMPARE(I16, PlcOpEq);
+        VM_NEXT();
+
+    VM_CASE(NE_II)
+        VM_COMPARE(I16, PlcOpNe);
+        VM_NEXT();
+
+    VM_CASE(ADD_DD)
+        VM_FOLD(int32_t, I32, PlcOpAdd);
+        VM_NEXT();
+
+    VM_CASE(SUB_DD)
+        VM_FOLD(int32_t, I32, PlcOpSub);
+        VM_NEXT();
+
+    VM_CASE(MUL_DD)
+        VM_FOLD(int32_t, I32, PlcOpMul);
+        VM_NEXT();
+
+    VM_CASE(DIV_DD)
+        VM_FOLD(int32_t, I32, PlcOpDiv);
+        VM_NEXT();
+
+    VM_CASE(GT_DD)
+        VM_COMPARE(I32, PlcOpGt);
+        VM_NEXT();
+
+    VM_CASE(GE_DD)
+        VM_COMPARE(I32, PlcOpGe);
+        VM_NEXT();
+
+    VM_CASE(LT_DD)
+        VM_COMPARE(I32, PlcOpLt);
+        VM_NEXT();
+
+    VM_CASE(LE_DD)
+        VM_COMPARE(I32, PlcOpLe);
+        VM_NEXT();
+
+    VM_CASE(EQ_DD)
+        VM_COMPARE(I32, PlcOpEq);
+        VM_NEXT();
+
+    VM_CASE(NE_DD)
+        VM_COMPARE(I32, PlcOpNe);
+        VM_NEXT();
+
+#if !PLC_VM_COMPUTED_GOTO
+    default:
+        return;
+    }
+    }
+#endif
+
+#undef VM_CASE
+#undef VM_PROFILE
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef RD
+#undef WR
+#undef B
+#undef SET_B
+#undef F
+#undef I16
+#undef I32
+#undef VM_FOLD
+#undef VM_COMPARE
+}
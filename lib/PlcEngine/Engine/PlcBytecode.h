@@ -0,0 +1,173 @@
+#ifndef PLC_BYTECODE_H
+#define PLC_BYTECODE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "../PlcEngine/Engine/PlcMemory.h"
+#include "../PlcEngine/Engine/PlcProfiler.h"
+
+class PlcBlock;
+class PlcExpression;
+
+// Use computed-goto dispatch where the compiler supports it (GCC/Clang)
+#if defined(__GNUC__) && !defined(PLC_VM_NO_COMPUTED_GOTO)
+#define PLC_VM_COMPUTED_GOTO 1
+#else
+#define PLC_VM_COMPUTED_GOTO 0
+#endif
+
+/**
+ * Opcodes of the PLC bytecode.
+ *
+ * The suffix names the working type of the operation: _B bool, _R real,
+ * _I int16. Operands are slot indices in PlcMemory; values are converted
+ * from the slot type exactly as the equivalent block does. A doubled
+ * suffix (_BB, _RR, _II, and _DD for int32) marks the variant for operands
+ * whose slots are declared with the working type; it computes like the
+ * typed block kernels (PlcTypedOps).
+ *
+ * Keep in sync with the dispatch table in PlcBytecode::execute().
+ */
+enum class PlcOpcode : uint8_t {
+    END = 0,
+    CALL_BLOCK,     // a = fallback block index
+    EXPR,           // a = expression index, count = PlcExpression::Type of the result
+
+    // N-ary (a = operand pool offset, count = operand count)
+    AND_B,
+    OR_B,
+    XOR_B,
+    NAND_B,
+    NOR_B,
+    ADD_R,
+    SUB_R,
+    MUL_R,
+    DIV_R,
+    PACK_B8,        // Up to 8 bools -> int8
+
+    // Unary (dst = f(a))
+    NOT_B,
+    ABS_R,
+    SQRT_R,
+    INC_I,
+    DEC_I,
+    I8_TO_I16,
+    I8_TO_U8,
+    I16_TO_U16,
+    I16_TO_R,
+    I32_TO_R,
+
+    // Binary (dst = f(a, b))
+    SR_B,           // a = set, b = reset (reset dominant)
+    RS_B,           // a = set, b = reset (set dominant)
+    MOD_I,
+    GT_R,
+    GE_R,
+    LT_R,
+    LE_R,
+    EQ_R,
+    NE_R,
+
+    // Slot-typed variants, emitted when every operand slot already has the
+    // working type, so values are accessed without conversion
+    AND_BB,
+    OR_BB,
+    NOT_BB,
+    ADD_RR,
+    SUB_RR,
+    MUL_RR,
+    GT_RR,
+    GE_RR,
+    LT_RR,
+    LE_RR,
+    EQ_RR,
+    NE_RR,
+    DIV_RR,
+    ADD_II,
+    SUB_II,
+    MUL_II,
+    DIV_II,
+    GT_II,
+    GE_II,
+    LT_II,
+    LE_II,
+    EQ_II,
+    NE_II,
+    ADD_DD,
+    SUB_DD,
+    MUL_DD,
+    DIV_DD,
+    GT_DD,
+    GE_DD,
+    LT_DD,
+    LE_DD,
+    EQ_DD,
+    NE_DD,
+
+    OPCODE_COUNT
+};
+
+struct PlcInstruction {
+    uint8_t op;      // PlcOpcode
+    uint8_t count;   // Operand count for n-ary opcodes
+    uint16_t dst;    // Destination slot
+    uint16_t a;      // First operand slot / operand pool offset / block index
+    uint16_t b;      // Second operand slot
+};
+
+/**
+ * PlcBytecode - linear program compiled from the logic blocks.
+ *
+ * Operands are PlcMemory slot indices, so the slot table acts as the
+ * register file of the VM and no values are copied between instructions.
+ *
+ * Blocks that implement PlcBlock::lower() are emitted as typed opcodes that
+ * address PlcMemory slots directly. All other blocks are called through
+ * CALL_BLOCK, so every program can be compiled.
+ */
+class PlcBytecode {
+public:
+    PlcBytecode();
+
+    void clear();
+
+    // Emit helpers used by PlcBlock::lower(). They return false (and emit
+    // nothing) when an operand is not bound, so the caller falls back to
+    // the block's own evaluate().
+    bool emitNary(PlcOpcode op, VarHandle dst, const PlcHandleList& inputs);
+    bool emitUnary(PlcOpcode op, VarHandle dst, VarHandle in);
+    bool emitBinary(PlcOpcode op, VarHandle dst, VarHandle in1, VarHandle in2);
+    // Run a compiled expression (EXPR block) and store its result in dst
+    bool emitExpression(VarHandle dst, const PlcExpression& expression);
+    void emitCall(PlcBlock* block);
+
+    // Append END. Must be called before execute(). Code emitted after it
+    // forms another segment, which execute() runs when given its first
+    // instruction as entry (the task classes of a PlcProgram).
+    void finish();
+
+#ifdef PLC_PROFILING
+    void execute(PlcMemory& memory, PlcProfiler* profiler = nullptr, size_t entry = 0) const;
+#else
+    void execute(PlcMemory& memory, size_t entry = 0) const;
+#endif
+
+    bool isEmpty() const { return code.empty(); }
+    size_t getInstructionCount() const { return code.size(); }
+    size_t getLoweredCount() const { return loweredCount; }
+    size_t getFallbackCount() const { return fallbacks.size(); }
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<PlcInstruction> code;
+    std::vector<uint16_t> operands;     // Operand pool for n-ary opcodes
+    std::vector<PlcBlock*> fallbacks;   // Not owned
+    std::vector<const PlcExpression*> expressions; // Not owned
+    size_t loweredCount;
+
+    void emit(PlcOpcode op, uint8_t count, uint16_t dst, uint16_t a, uint16_t b);
+    // Variant of op for operands all declared with `type` (uniform), or op itself
+    static PlcOpcode slotTypedVariant(PlcOpcode op, bool uniform, PlcValueType type);
+};
+
+#endif // PLC_BYTECODE_H
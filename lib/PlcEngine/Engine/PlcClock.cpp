@@ -0,0 +1,86 @@
+#include "../PlcEngine/Engine/PlcClock.h"
+
+#ifdef UNIT_TEST
+#include <chrono>
+#include <thread>
+#endif
+
+SystemPlcClock::SystemPlcClock() {
+#ifdef UNIT_TEST
+    wakePending = false;
+#else
+    wakeSemaphore = xSemaphoreCreateBinary();
+#endif
+}
+
+SystemPlcClock::~SystemPlcClock() {
+#ifndef UNIT_TEST
+    if (wakeSemaphore) {
+        vSemaphoreDelete(wakeSemaphore);
+    }
+#endif
+}
+
+uint32_t SystemPlcClock::nowMicros() {
+#ifdef UNIT_TEST
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+#else
+    return static_cast<uint32_t>(micros());
+#endif
+}
+
+void SystemPlcClock::sleepUntil(uint32_t deadlineUs) {
+    int32_t remaining = static_cast<int32_t>(deadlineUs - nowMicros());
+    if (remaining <= 0) {
+        return;
+    }
+#ifdef UNIT_TEST
+    std::this_thread::sleep_for(std::chrono::microseconds(remaining));
+#else
+    // Round up to whole ticks so the task never wakes before the deadline
+    const uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+    vTaskDelay((static_cast<uint32_t>(remaining) + tickUs - 1) / tickUs);
+#endif
+}
+
+bool SystemPlcClock::waitUntil(uint32_t deadlineUs) {
+    int32_t remaining = static_cast<int32_t>(deadlineUs - nowMicros());
+#ifdef UNIT_TEST
+    std::unique_lock<std::mutex> lock(mutex);
+    if (remaining > 0) {
+        woken.wait_for(lock, std::chrono::microseconds(remaining), [this] { return wakePending; });
+    }
+    bool early = wakePending;
+    wakePending = false;
+    return early;
+#else
+    if (!wakeSemaphore) {
+        sleepUntil(deadlineUs);
+        return false;
+    }
+    const uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+    TickType_t ticks = remaining > 0 ? (static_cast<uint32_t>(remaining) + tickUs - 1) / tickUs : 0;
+    return xSemaphoreTake(wakeSemaphore, ticks) == pdTRUE;
+#endif
+}
+
+void SystemPlcClock::wake() {
+#ifdef UNIT_TEST
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wakePending = true;
+    }
+    woken.notify_one();
+#else
+    if (wakeSemaphore) {
+        xSemaphoreGive(wakeSemaphore);
+    }
+#endif
+}
+
+bool SystemPlcClock::localTime(struct tm& out) {
+    // No timeout: getLocalTime() would otherwise wait up to 5 s for a time
+    // that is not set
+    return getLocalTime(&out, 0);
+}
@@ -0,0 +1,65 @@
+#ifndef PLC_CLOCK_H
+#define PLC_CLOCK_H
+
+#include <Arduino.h>
+#include <time.h>
+#ifdef UNIT_TEST
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+ * PlcClock - time source of the PLC scheduler.
+ *
+ * Times are in microseconds and wrap around after ~71 minutes; compare
+ * them with signed differences, never with < directly.
+ */
+class PlcClock {
+public:
+    virtual ~PlcClock() {}
+    virtual uint32_t nowMicros() = 0;
+
+    // Block the calling task until the deadline. Returns immediately if
+    // the deadline has already passed.
+    virtual void sleepUntil(uint32_t deadlineUs) = 0;
+
+    // Same, but wake() from another task ends the wait early. Returns true
+    // if it did; a wake() while nobody waits ends the next wait right away.
+    virtual bool waitUntil(uint32_t deadlineUs) { sleepUntil(deadlineUs); return false; }
+    virtual void wake() {}
+
+    // Local time of day, false while it is not known (e.g. before NTP
+    // synchronisation). Read at most once per scan, see PlcCycleContext.
+    virtual bool localTime(struct tm& out) { return false; }
+
+    static bool reached(uint32_t now, uint32_t deadline) {
+        return static_cast<int32_t>(now - deadline) >= 0;
+    }
+};
+
+/**
+ * SystemPlcClock - micros() and FreeRTOS delays on the target, std::chrono
+ * in native builds. waitUntil() blocks on a binary semaphore rather than
+ * the task notification, which PlcWorkerPool uses for its barrier.
+ */
+class SystemPlcClock : public PlcClock {
+public:
+    SystemPlcClock();
+    ~SystemPlcClock();
+    uint32_t nowMicros() override;
+    void sleepUntil(uint32_t deadlineUs) override;
+    bool waitUntil(uint32_t deadlineUs) override;
+    void wake() override;
+    bool localTime(struct tm& out) override;
+
+private:
+#ifdef UNIT_TEST
+    std::mutex mutex;
+    std::condition_variable woken;
+    bool wakePending;
+#else
+    SemaphoreHandle_t wakeSemaphore;
+#endif
+};
+
+#endif // PLC_CLOCK_H
@@ -0,0 +1,24 @@
+#include "../PlcEngine/Engine/PlcCycleContext.h"
+#include "../PlcEngine/Engine/PlcClock.h"
+
+PlcCycleContext::PlcCycleContext() : clock(nullptr), nowUs(0), deltaUs(0), cycle(0), localState(LOCAL_UNSET), localTime() {
+}
+
+void PlcCycleContext::begin(PlcClock& source, uint32_t now) {
+    deltaUs = cycle > 0 ? now - nowUs : 0;
+    nowUs = now;
+    cycle++;
+    clock = &source;
+    localState = LOCAL_UNREAD;
+}
+
+bool PlcCycleContext::getLocalTime(struct tm& out) const {
+    if (localState == LOCAL_UNREAD) {
+        localState = clock->localTime(localTime) ? LOCAL_VALID : LOCAL_UNSET;
+    }
+    if (localState != LOCAL_VALID) {
+        return false;
+    }
+    out = localTime;
+    return true;
+}
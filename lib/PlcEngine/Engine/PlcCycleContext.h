@@ -0,0 +1,46 @@
+#ifndef PLC_CYCLE_CONTEXT_H
+#define PLC_CYCLE_CONTEXT_H
+
+#include <Arduino.h>
+#include <time.h>
+
+class PlcClock;
+
+/**
+ * PlcCycleContext - the scan a block is evaluated in.
+ *
+ * PlcEngine starts it once per scan from the clock reading it also
+ * advances the timer wheel with, so all blocks of a scan see the same
+ * time and none of them reads a clock itself. The local time of day is
+ * read from the PlcClock the first time a block asks for it in a scan and
+ * kept for the rest of the scan. Tests control both through the clock
+ * (ManualPlcClock).
+ */
+class PlcCycleContext {
+public:
+    PlcCycleContext();
+
+    // Start a scan at the clock reading nowUs
+    void begin(PlcClock& source, uint32_t nowUs);
+
+    uint32_t getNowUs() const { return nowUs; }
+    uint32_t getNowMs() const { return nowUs / 1000; }
+    uint32_t getDeltaUs() const { return deltaUs; }  // Since the previous scan, 0 on the first
+    uint32_t getCycle() const { return cycle; }      // Scans so far, this one included
+
+    // Local time of day of the scan; false while the clock has none (not
+    // synchronised yet, or no scan started)
+    bool getLocalTime(struct tm& out) const;
+
+private:
+    PlcClock* clock;
+    uint32_t nowUs;
+    uint32_t deltaUs;
+    uint32_t cycle;
+
+    enum : uint8_t { LOCAL_UNREAD, LOCAL_VALID, LOCAL_UNSET };
+    mutable uint8_t localState;
+    mutable struct tm localTime;
+};
+
+#endif // PLC_CYCLE_CONTEXT_H
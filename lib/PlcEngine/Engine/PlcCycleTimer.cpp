@@ -0,0 +1,119 @@
+#include "../PlcEngine/Engine/PlcCycleTimer.h"
+#include "../PlcEngine/Engine/PlcClock.h"
+
+const uint32_t PlcCycleStats::JITTER_BUCKET_LIMITS_US[PlcCycleStats::JITTER_BUCKETS - 1] = {
+    100, 250, 500, 1000, 2000, 5000, 10000
+};
+
+void PlcCycleStats::reset() {
+    cycles = 0;
+    overruns = 0;
+    skippedCycles = 0;
+    minExecUs = 0;
+    maxExecUs = 0;
+    totalExecUs = 0;
+    maxJitterUs = 0;
+    for (uint8_t i = 0; i < JITTER_BUCKETS; i++) {
+        jitterHistogram[i] = 0;
+    }
+}
+
+void PlcCycleStats::toJson(JsonObject obj) const {
+    obj["cycles"] = cycles;
+    obj["overruns"] = overruns;
+    obj["skipped"] = skippedCycles;
+    obj["min_us"] = minExecUs;
+    obj["max_us"] = maxExecUs;
+    obj["avg_us"] = getAvgExecUs();
+    obj["max_jitter_us"] = maxJitterUs;
+
+    JsonArray histogram = obj["jitter_histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < JITTER_BUCKETS; i++) {
+        JsonObject bucket = histogram.add<JsonObject>();
+        if (i < JITTER_BUCKETS - 1) {
+            bucket["le_us"] = JITTER_BUCKET_LIMITS_US[i];
+        } else {
+            bucket["le_us"] = nullptr; // Overflow bucket
+        }
+        bucket["count"] = jitterHistogram[i];
+    }
+}
+
+PlcCycleTimer::PlcCycleTimer()
+    : periodUs(DEFAULT_CYCLE_TIME_MS * 1000), policy(PlcOverrunPolicy::SKIP),
+      nextDeadline(0), cycleStart(0), catchUpCount(0) {
+}
+
+void PlcCycleTimer::configure(uint32_t cycleTimeMs, PlcOverrunPolicy overrunPolicy) {
+    periodUs = (cycleTimeMs > 0 ? cycleTimeMs : DEFAULT_CYCLE_TIME_MS) * 1000;
+    policy = overrunPolicy;
+}
+
+void PlcCycleTimer::start(uint32_t nowUs) {
+    nextDeadline = nowUs;
+    catchUpCount = 0;
+    stats.reset();
+}
+
+void PlcCycleTimer::continueFrom(const PlcCycleTimer& previous) {
+    nextDeadline = previous.nextDeadline;
+    catchUpCount = 0;
+}
+
+void PlcCycleTimer::resume(uint32_t nowUs) {
+    if (PlcClock::reached(nowUs, nextDeadline)) {
+        nextDeadline = nowUs;
+        catchUpCount = 0;
+    }
+}
+
+bool PlcCycleTimer::isDue(uint32_t nowUs) const {
+    return PlcClock::reached(nowUs, nextDeadline);
+}
+
+void PlcCycleTimer::beginCycle(uint32_t nowUs) {
+    cycleStart = nowUs;
+
+    uint32_t jitter = PlcClock::reached(nowUs, nextDeadline) ? nowUs - nextDeadline : 0;
+    if (jitter > stats.maxJitterUs) {
+        stats.maxJitterUs = jitter;
+    }
+    uint8_t bucket = 0;
+    while (bucket < PlcCycleStats::JITTER_BUCKETS - 1 && jitter > PlcCycleStats::JITTER_BUCKET_LIMITS_US[bucket]) {
+        bucket++;
+    }
+    stats.jitterHistogram[bucket]++;
+}
+
+void PlcCycleTimer::endCycle(uint32_t nowUs) {
+    uint32_t execUs = nowUs - cycleStart;
+    if (stats.cycles == 0 || execUs < stats.minExecUs) {
+        stats.minExecUs = execUs;
+    }
+    if (execUs > stats.maxExecUs) {
+        stats.maxExecUs = execUs;
+    }
+    stats.totalExecUs += execUs;
+    stats.cycles++;
+
+    uint32_t next = nextDeadline + periodUs;
+    if (!PlcClock::reached(nowUs, next)) {
+        catchUpCount = 0;
+        nextDeadline = next;
+        return;
+    }
+
+    // Overrun: the next deadline has already passed
+    stats.overruns++;
+    if (policy == PlcOverrunPolicy::CATCH_UP && catchUpCount < MAX_CATCH_UP_CYCLES) {
+        catchUpCount++;
+        nextDeadline = next;
+        return;
+    }
+
+    // Resynchronise on the first deadline after now
+    uint32_t missed = (nowUs - nextDeadline) / periodUs;
+    stats.skippedCycles += missed;
+    nextDeadline += (missed + 1) * periodUs;
+    catchUpCount = 0;
+}
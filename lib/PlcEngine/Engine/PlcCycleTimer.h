@@ -0,0 +1,78 @@
+#ifndef PLC_CYCLE_TIMER_H
+#define PLC_CYCLE_TIMER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+enum class PlcOverrunPolicy {
+    SKIP,       // Drop the missed cycles and continue on the next future deadline
+    CATCH_UP    // Run the missed cycles back to back (bounded by MAX_CATCH_UP_CYCLES)
+};
+
+/**
+ * Cycle statistics of one program.
+ *
+ * Execution time is measured from the start of the READ phase to the end
+ * of the WRITE phase. Jitter is how late a cycle started after its
+ * deadline.
+ */
+struct PlcCycleStats {
+    static constexpr uint8_t JITTER_BUCKETS = 8;
+    static const uint32_t JITTER_BUCKET_LIMITS_US[JITTER_BUCKETS - 1]; // Upper bound of each bucket but the last
+
+    uint32_t cycles;
+    uint32_t overruns;          // Cycles that ended after the next deadline
+    uint32_t skippedCycles;     // Deadlines dropped by the overrun policy
+    uint32_t minExecUs;
+    uint32_t maxExecUs;
+    uint64_t totalExecUs;
+    uint32_t maxJitterUs;
+    uint32_t jitterHistogram[JITTER_BUCKETS];
+
+    PlcCycleStats() { reset(); }
+    void reset();
+    uint32_t getAvgExecUs() const { return cycles ? static_cast<uint32_t>(totalExecUs / cycles) : 0; }
+    void toJson(JsonObject obj) const;
+};
+
+/**
+ * PlcCycleTimer - absolute-deadline timing of one cyclic program.
+ *
+ * Deadlines advance by exactly one period per cycle (like vTaskDelayUntil),
+ * so the execution time does not accumulate into the period. The scheduler
+ * calls beginCycle()/endCycle() around each scan.
+ */
+class PlcCycleTimer {
+public:
+    static constexpr uint32_t DEFAULT_CYCLE_TIME_MS = 10;
+    static constexpr uint8_t MAX_CATCH_UP_CYCLES = 8;
+
+    PlcCycleTimer();
+
+    void configure(uint32_t cycleTimeMs, PlcOverrunPolicy policy);
+    void start(uint32_t nowUs); // First cycle is due immediately
+    void continueFrom(const PlcCycleTimer& previous); // Keep the deadline of the program version it replaces
+    // Tickless mode: a parked program whose deadline has passed is due now;
+    // the time it was parked counts neither as jitter nor as skipped cycles
+    void resume(uint32_t nowUs);
+
+    bool isDue(uint32_t nowUs) const;
+    uint32_t getNextDeadline() const { return nextDeadline; }
+    void beginCycle(uint32_t nowUs);
+    void endCycle(uint32_t nowUs);
+
+    uint32_t getCycleTimeMs() const { return periodUs / 1000; }
+    PlcOverrunPolicy getOverrunPolicy() const { return policy; }
+    const PlcCycleStats& getStats() const { return stats; }
+    void resetStats() { stats.reset(); }
+
+private:
+    uint32_t periodUs;
+    PlcOverrunPolicy policy;
+    uint32_t nextDeadline;
+    uint32_t cycleStart;
+    uint8_t catchUpCount;
+    PlcCycleStats stats;
+};
+
+#endif // PLC_CYCLE_TIMER_H
@@ -1,58 +1,34 @@
 #include "../PlcEngine/Engine/PlcEngine.h"
 #include <StreamLogger.h>
 #include "../Devices/DeviceRegistry.h" // For IODirection enum
+#include <algorithm>
 
 extern StreamLogger* EspHubLog;
 
-#include "../Blocks/logic/BlockAND.h"
-#include "../Blocks/logic/BlockOR.h"
-#include "../Blocks/logic/BlockNOT.h"
-#include "../Blocks/logic/BlockXOR.h"
-#include "../Blocks/logic/BlockNAND.h"
-#include "../Blocks/logic/BlockNOR.h"
-#include "../Blocks/logic/BlockSR.h"
-#include "../Blocks/logic/BlockRS.h"
-#include "../Blocks/timers/BlockTON.h"
-#include "../Blocks/timers/BlockTOF.h"
-#include "../Blocks/timers/BlockTP.h"
-#include "../Blocks/counters/BlockCTU.h"
-#include "../Blocks/counters/BlockCTD.h"
-#include "../Blocks/counters/BlockCTUD.h"
-#include "../Blocks/math/BlockADD.h"
-#include "../Blocks/math/BlockSUB.h"
-#include "../Blocks/math/BlockMUL.h"
-#include "../Blocks/math/BlockDIV.h"
-#include "../Blocks/math/BlockMOD.h"
-#include "../Blocks/math/BlockABS.h"
-#include "../Blocks/math/BlockSQRT.h"
-#include "../Blocks/math/BlockINC.h"
-#include "../Blocks/math/BlockDEC.h"
-#include "../Blocks/comparison/BlockGT.h"
-#include "../Blocks/comparison/BlockEQ.h"
-#include "../Blocks/comparison/BlockNE.h"
-#include "../Blocks/comparison/BlockLT.h"
-#include "../Blocks/comparison/BlockGE.h"
-#include "../Blocks/comparison/BlockLE.h"
-#include "../Blocks/scheduler/BlockTimeCompare.h"
-#include "../Blocks/conversion/BlockBoolArrayToInt8.h"
-#include "../Blocks/conversion/BlockInt8ToInt16.h"
-#include "../Blocks/conversion/BlockInt8ToUint8.h"
-#include "../Blocks/conversion/BlockInt16ToUint16.h"
-#include "../Blocks/conversion/BlockInt32ToTime.h"
-#include "../Blocks/conversion/BlockInt16ToFloat.h"
-#include "../Blocks/conversion/BlockInt32ToDouble.h"
-#include "../Blocks/logic/BlockSequencer.h"
-#include "../Blocks/string/BlockStringConcat.h"
-#include "../Blocks/string/BlockStringFind.h"
-#include "../Blocks/string/BlockStringCopy.h"
-#include "../Blocks/string/BlockStringFormat.h"
-
 PlcEngine::PlcEngine(TimeManager* timeManager, MeshDeviceManager* meshDeviceManager)
-    : currentEngineState(PlcEngineState::STOPPED), plcEngineTaskHandle(NULL), _timeManager(timeManager), _meshDeviceManager(meshDeviceManager) {
+    : currentEngineState(PlcEngineState::STOPPED), plcEngineTaskHandle(NULL), _timeManager(timeManager), _meshDeviceManager(meshDeviceManager), _clock(&systemClock), onlineChangeState(CHANGE_IDLE), changeTarget(nullptr),
+      workerCount(PLC_WORKER_COUNT), placementChanged(true), captureRequested(false), parallelCycles(false), highPriority(false), cycleNowUs(0),
+      tickless(PLC_TICKLESS), wakePending(false), lastWakeUs(0), hasWaited(false) {
+    memset(workerStats, 0, sizeof(workerStats));
+    memset(&powerStats, 0, sizeof(powerStats));
 }
 
 void PlcEngine::begin() {
     // No global memory.begin() needed anymore, each program has its own.
+    // Endpoint values and status are read in the next scan
+    DeviceRegistry& registry = DeviceRegistry::getInstance();
+    registry.onValueChange([this](const String&, const PlcValue&) { wake(); });
+    registry.onStatusChange([this](const String&, bool) { wake(); });
+}
+
+std::unique_ptr<PlcProgram> PlcEngine::createProgram(const String& programName) {
+    auto program = std::make_unique<PlcProgram>(programName, _timeManager, _meshDeviceManager);
+    program->getMemory().setPostListener(onInputPosted, this);
+    return program;
+}
+
+void PlcEngine::onInputPosted(void* context) {
+    static_cast<PlcEngine*>(context)->wake();
 }
 
 bool PlcEngine::loadProgram(const String& programName, const char* jsonConfig) {
@@ -61,29 +37,144 @@ bool PlcEngine::loadProgram(const String& programName, const char* jsonConfig) {
         return false;
     }
 
-    auto newProgram = std::make_unique<PlcProgram>(programName, _timeManager, _meshDeviceManager);
+    size_t largestBefore = PlcArena::largestFreeBlock();
+    auto newProgram = createProgram(programName);
     if (!newProgram->loadConfiguration(jsonConfig)) {
         EspHubLog->printf("ERROR: Failed to load configuration for program '%s'.\n", programName.c_str());
         return false;
     }
     programs[programName] = std::move(newProgram);
+    placementChanged.store(true, std::memory_order_release);
+    logFragmentation(programName, "load", largestBefore);
     EspHubLog->printf("Program '%s' loaded successfully.\n", programName.c_str());
     return true;
 }
 
+bool PlcEngine::loadProgramStream(const String& programName, PlcProgramLoader::ReadFunction read) {
+    if (programs.count(programName)) {
+        EspHubLog->printf("ERROR: Program '%s' already exists. Delete it first.\n", programName.c_str());
+        return false;
+    }
+
+    size_t largestBefore = PlcArena::largestFreeBlock();
+    auto newProgram = createProgram(programName);
+    if (!newProgram->loadConfigurationStream(read)) {
+        EspHubLog->printf("ERROR: Failed to load configuration for program '%s'.\n", programName.c_str());
+        return false;
+    }
+    programs[programName] = std::move(newProgram);
+    placementChanged.store(true, std::memory_order_release);
+    logFragmentation(programName, "load", largestBefore);
+    EspHubLog->printf("Program '%s' loaded successfully (bytes_peak %u).\n", programName.c_str(), (unsigned)programs[programName]->getLoadBytesPeak());
+    return true;
+}
+
+bool PlcEngine::loadProgramImage(const String& programName, const uint8_t* data, size_t size) {
+    if (programs.count(programName)) {
+        EspHubLog->printf("ERROR: Program '%s' already exists. Delete it first.\n", programName.c_str());
+        return false;
+    }
+
+    size_t largestBefore = PlcArena::largestFreeBlock();
+    auto newProgram = createProgram(programName);
+    if (!newProgram->loadImage(data, size)) {
+        EspHubLog->printf("ERROR: Failed to load program image for program '%s'.\n", programName.c_str());
+        return false;
+    }
+    programs[programName] = std::move(newProgram);
+    placementChanged.store(true, std::memory_order_release);
+    logFragmentation(programName, "load", largestBefore);
+    EspHubLog->printf("Program '%s' loaded successfully from image (%u bytes).\n", programName.c_str(), (unsigned)size);
+    return true;
+}
+
+bool PlcEngine::onlineChange(const String& programName, const char* jsonConfig) {
+    return onlineChangeStream(programName, PlcProgramLoader::readBuffer(jsonConfig, strlen(jsonConfig)));
+}
+
+bool PlcEngine::onlineChangeStream(const String& programName, PlcProgramLoader::ReadFunction read) {
+    auto it = programs.find(programName);
+    if (it == programs.end()) {
+        EspHubLog->printf("ERROR: Program '%s' not found.\n", programName.c_str());
+        return false;
+    }
+    uint8_t idle = CHANGE_IDLE;
+    if (!onlineChangeState.compare_exchange_strong(idle, CHANGE_PREPARING)) {
+        EspHubLog->printf("ERROR: Program '%s': Another online change is in progress.\n", programName.c_str());
+        return false;
+    }
+
+    // The current version keeps scanning while the new one is loaded
+    auto newProgram = createProgram(programName);
+    if (!newProgram->loadConfigurationStream(read)) {
+        EspHubLog->printf("ERROR: Failed to load configuration for program '%s', it keeps running unchanged.\n", programName.c_str());
+        onlineChangeState.store(CHANGE_IDLE, std::memory_order_release);
+        return false;
+    }
+    newProgram->prepareTakeOver(*it->second);
+    changedProgram = std::move(newProgram);
+    changeTarget = it->second.get();
+    onlineChangeState.store(CHANGE_PENDING, std::memory_order_release);
+
+    // Without the engine task nothing scans, so the swap can happen here
+    if (currentEngineState != PlcEngineState::RUNNING && swapChangedProgram()) {
+        finishOnlineChange();
+    }
+    return true;
+}
+
+bool PlcEngine::swapChangedProgram() {
+    uint8_t pending = CHANGE_PENDING;
+    if (!onlineChangeState.compare_exchange_strong(pending, CHANGE_APPLYING, std::memory_order_acquire)) {
+        return false;
+    }
+    uint32_t start = _clock->nowMicros();
+    lastOnlineChange = PlcOnlineChange();
+    for (auto& pair : programs) {
+        if (pair.second.get() == changeTarget) {
+            changedProgram->takeOver(*pair.second);
+            pair.second.swap(changedProgram); // changedProgram now holds the previous version
+            lastOnlineChange = pair.second->getOnlineChange();
+            break;
+        }
+    }
+    lastOnlineChange.swapLatencyUs = _clock->nowMicros() - start;
+    return true;
+}
+
+void PlcEngine::finishOnlineChange() {
+    EspHubLog->printf("Program '%s': Online change swapped in %u us (%u variables and %u blocks carried over, %u new blocks, %u dropped)\n",
+                      changedProgram->getName().c_str(), (unsigned)lastOnlineChange.swapLatencyUs, lastOnlineChange.carriedVariables,
+                      lastOnlineChange.migratedBlocks, lastOnlineChange.newBlocks, lastOnlineChange.droppedBlocks);
+    changedProgram.reset();
+    changeTarget = nullptr;
+    onlineChangeState.store(CHANGE_IDLE, std::memory_order_release);
+}
+
 void PlcEngine::runProgram(const String& programName) {
     if (programs.count(programName)) {
-        programs[programName]->run();
+        PlcProgram& program = *programs[programName];
+        bool wasRunning = program.getState() == PlcProgramState::RUNNING;
+        program.run();
+        if (!wasRunning) {
+            program.startCycles(_clock->nowMicros());
+        }
+        placementChanged.store(true, std::memory_order_release);
+        wake(); // Scanned right away, also when triggered again while running
         // Start the global PLC engine task if not already running
         if (currentEngineState == PlcEngineState::STOPPED) {
             currentEngineState = PlcEngineState::RUNNING;
-            EspHubLog->println("Starting global PLC engine task on Core 0...");
+            if (!workers.start(workerCount, runWorker, this)) {
+                EspHubLog->println("ERROR: Cannot start the PLC workers, scanning all programs on Core 0");
+            }
+            placementChanged.store(true, std::memory_order_release);
+            EspHubLog->printf("Starting global PLC engine task on Core 0 with %u worker(s)...\n", (unsigned)workers.getWorkerCount());
             xTaskCreatePinnedToCore(
                 plcEngineTask,          // Task function
                 "plcEngineTask",        // Name of the task
                 10000,                  // Stack size in words
                 this,                   // Task input parameter
-                1,                      // Priority of the task
+                PLC_TASK_PRIORITY,      // Priority of the task, raised for high-priority task classes
                 &plcEngineTaskHandle,   // Task handle to keep track of the task
                 0);                     // Pin to core 0
         }
@@ -95,6 +186,7 @@ void PlcEngine::runProgram(const String& programName) {
 void PlcEngine::pauseProgram(const String& programName) {
     if (programs.count(programName)) {
         programs[programName]->pause();
+        placementChanged.store(true, std::memory_order_release);
     } else {
         EspHubLog->printf("ERROR: Program '%s' not found.\n", programName.c_str());
     }
@@ -103,6 +195,10 @@ void PlcEngine::pauseProgram(const String& programName) {
 void PlcEngine::stopProgram(const String& programName) {
     if (programs.count(programName)) {
         programs[programName]->stop();
+        // The values changed since the last pack are packed by the PLC task
+        // at the next cycle boundary and written by commitRetentive()
+        captureRequested.store(true, std::memory_order_release);
+        placementChanged.store(true, std::memory_order_release);
         // Check if all programs are stopped, then stop the global PLC engine task
         bool allStopped = true;
         for (auto const& [name, program] : programs) {
@@ -112,12 +208,19 @@ void PlcEngine::stopProgram(const String& programName) {
             }
         }
         if (allStopped && currentEngineState == PlcEngineState::RUNNING) {
+            workers.stop(); // Before the engine task, which may be waiting for them
             if (plcEngineTaskHandle != NULL) {
                 vTaskDelete(plcEngineTaskHandle);
                 plcEngineTaskHandle = NULL;
             }
             currentEngineState = PlcEngineState::STOPPED;
             EspHubLog->println("Global PLC engine task stopped.");
+            if (swapChangedProgram()) {
+                finishOnlineChange(); // Queued for a scan that will not come
+            }
+        }
+        if (currentEngineState != PlcEngineState::RUNNING) {
+            captureStoppedPrograms(); // No engine task scans the programs, nor reaches a cycle boundary
         }
     } else {
         EspHubLog->printf("ERROR: Program '%s' not found.\n", programName.c_str());
@@ -130,14 +233,35 @@ void PlcEngine::deleteProgram(const String& programName) {
             EspHubLog->printf("ERROR: Cannot delete program '%s' while it is running or paused. Stop it first.\n", programName.c_str());
             return;
         }
+        size_t largestBefore = PlcArena::largestFreeBlock();
         programs.erase(programName);
+        placementChanged.store(true, std::memory_order_release);
         EspHubLog->printf("Program '%s' deleted.\n", programName.c_str());
+        logFragmentation(programName, "delete", largestBefore);
         // Also delete the file from LittleFS
     } else {
         EspHubLog->printf("ERROR: Program '%s' not found.\n", programName.c_str());
     }
 }
 
+void PlcEngine::commitRetentive() {
+    // Program objects are only swapped by a pending online change
+    if (isOnlineChangePending()) {
+        return;
+    }
+    for (auto& pair : programs) {
+        PlcRetentiveStore& retentive = pair.second->getMemory().getRetentive();
+        if (retentive.hasPendingCommit()) {
+            retentive.commit();
+        }
+    }
+}
+
+void PlcEngine::logFragmentation(const String& programName, const char* action, size_t largestBefore) {
+    EspHubLog->printf("Program '%s': Largest free heap block %u before %s, %u after\n",
+                      programName.c_str(), (unsigned)largestBefore, action, (unsigned)PlcArena::largestFreeBlock());
+}
+
 PlcProgram* PlcEngine::getProgram(const String& programName) {
     if (programs.count(programName)) {
         return programs[programName].get();
@@ -155,11 +279,15 @@ std::vector<String> PlcEngine::getProgramNames() const {
 
 void PlcEngine::evaluateAllPrograms() {
     // PHASE 1: READ - Sync all INPUTS from devices to PLC memory
-    // This reads the current state of all input devices into PLC variables
+    // This applies the writes posted to the input image and reads the
+    // current state of all input devices into PLC variables
     IODirection inputDirection = IODirection::IO_INPUT;
+    uint32_t now = _clock->nowMicros();
     for (auto& pair : programs) {
         if (pair.second->getState() == PlcProgramState::RUNNING) {
             PlcMemory& memory = pair.second->getMemory();
+            pair.second->advanceTimers(now);
+            memory.applyInputImage();
             memory.syncIOPoints(&inputDirection);
         }
     }
@@ -173,14 +301,340 @@ void PlcEngine::evaluateAllPrograms() {
     }
 
     // PHASE 3: WRITE - Sync all OUTPUTS from PLC memory to devices
-    // This writes the calculated output values to physical devices
+    // This writes the calculated output values to physical devices and
+    // publishes them in the output image for other tasks
     IODirection outputDirection = IODirection::IO_OUTPUT;
     for (auto& pair : programs) {
         if (pair.second->getState() == PlcProgramState::RUNNING) {
             PlcMemory& memory = pair.second->getMemory();
             memory.syncIOPoints(&outputDirection);
+            memory.publishOutputImage();
+        }
+    }
+}
+
+void PlcEngine::scanProgram(PlcProgram& program) {
+    PlcCycleTimer& timer = program.getCycleTimer();
+    PlcMemory& memory = program.getMemory();
+    IODirection inputDirection = IODirection::IO_INPUT;
+    IODirection outputDirection = IODirection::IO_OUTPUT;
+
+    uint32_t now = _clock->nowMicros();     // The time the program sees for the whole cycle
+    timer.beginCycle(now);
+    program.getCycleContext().begin(*_clock, now);
+    program.advanceTimers(now);             // Timer expiries
+    memory.applyInputImage();               // READ
+    memory.syncIOPoints(&inputDirection);
+    if (program.getTaskCount() == 0) {      // EXECUTE
+        program.evaluate();
+    } else {
+        evaluateDueTasks(program, now);
+    }
+    memory.syncIOPoints(&outputDirection);  // WRITE
+    bool changed = memory.publishOutputImage();
+    memory.getRetentive().track(memory, _clock->nowMicros());
+    timer.endCycle(_clock->nowMicros());
+    if (tickless && !changed && !program.needsScan()) {
+        program.setParked(true); // Nothing left to do until an input or a timer
+    }
+}
+
+void PlcEngine::evaluateDueTasks(PlcProgram& program, uint32_t nowUs) {
+    // The program is scanned on the common base of the class periods, so
+    // each class is due on one of these scans. Faster classes come first.
+    for (size_t i = 0; i < program.getTaskCount(); i++) {
+        PlcCycleTimer& timer = program.getTask(i).timer;
+        if (timer.isDue(nowUs)) {
+            timer.beginCycle(nowUs);
+            program.evaluateTask(i);
+            timer.endCycle(_clock->nowMicros());
+        }
+    }
+}
+
+uint32_t PlcEngine::runDueCycles() {
+    // A pending online change is swapped in at the cycle boundary
+    bool swapped = onlineChangeState.load(std::memory_order_acquire) == CHANGE_PENDING && swapChangedProgram();
+    if (swapped || placementChanged.exchange(false, std::memory_order_acq_rel)) {
+        assignWorkers(); // No worker is scanning between two cycles
+    }
+    captureStoppedPrograms();
+
+    cycleNowUs = _clock->nowMicros();
+    unparkPrograms(cycleNowUs);
+    if (parallelCycles) {
+        workers.runCycle(); // Returns once every worker has scanned its due programs
+    } else {
+        scanDuePrograms(0);
+    }
+    if (swapped) {
+        finishOnlineChange(); // The previous version is freed after the scans
+    }
+
+    // Sleep until the earliest deadline; a parked program has none until
+    // its next timer expiry
+    uint32_t now = _clock->nowMicros();
+    uint32_t next = now + (tickless ? TICKLESS_MAX_SLEEP_US : IDLE_POLL_US);
+    for (auto& pair : programs) {
+        PlcProgram& program = *pair.second;
+        if (program.getState() != PlcProgramState::RUNNING) {
+            continue;
+        }
+        uint32_t deadline = program.getCycleTimer().getNextDeadline();
+        if (program.isParked()) {
+            uint32_t expiry;
+            if (!program.getTimers().nextExpiryMicros(expiry)) {
+                continue;
+            }
+            if (static_cast<int32_t>(expiry - deadline) > 0) {
+                deadline = expiry;
+            }
+        }
+        if (static_cast<int32_t>(deadline - next) < 0) {
+            next = deadline;
+        }
+    }
+    return next;
+}
+
+void PlcEngine::captureStoppedPrograms() {
+    if (!captureRequested.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    for (auto& pair : programs) {
+        if (pair.second->getState() == PlcProgramState::STOPPED) {
+            PlcMemory& memory = pair.second->getMemory();
+            memory.getRetentive().capture(memory);
+        }
+    }
+}
+
+void PlcEngine::runWorker(void* context, uint8_t worker) {
+    static_cast<PlcEngine*>(context)->scanDuePrograms(worker);
+}
+
+void PlcEngine::scanDuePrograms(uint8_t worker) {
+    // Each worker only touches its own programs and its own statistics
+    uint32_t start = _clock->nowMicros();
+    bool scanned = false;
+    for (auto& pair : programs) {
+        PlcProgram& program = *pair.second;
+        if (program.getWorker() == worker && program.getState() == PlcProgramState::RUNNING &&
+            !program.isParked() && program.getCycleTimer().isDue(cycleNowUs)) {
+            scanProgram(program);
+            scanned = true;
+        }
+    }
+    if (scanned) {
+        WorkerStats& stats = workerStats[worker];
+        stats.lastBusyUs = _clock->nowMicros() - start;
+        stats.busyUs += stats.lastBusyUs;
+        stats.cycles++;
+    }
+}
+
+void PlcEngine::unparkPrograms(uint32_t nowUs) {
+    // Parked programs resume on a wake-up or one of their timers expiring
+    bool woken = wakePending.exchange(false, std::memory_order_acq_rel) || !tickless;
+    for (auto& pair : programs) {
+        PlcProgram& program = *pair.second;
+        if (program.getState() != PlcProgramState::RUNNING || !program.isParked()) {
+            continue;
+        }
+        program.resumeCycles(nowUs);
+        if (program.advanceTimers(nowUs) || woken) {
+            program.setParked(false);
+        }
+    }
+}
+
+uint32_t PlcEngine::scanLoad(PlcProgram& program) {
+    if (program.getState() != PlcProgramState::RUNNING) {
+        return 0;
+    }
+    // Measured scan time once the program has run, about a microsecond per block before
+    const PlcCycleStats& stats = program.getCycleTimer().getStats();
+    uint32_t scanUs = stats.cycles ? stats.getAvgExecUs() : static_cast<uint32_t>(program.getBlockCount());
+    return (scanUs + 1) * 1000 / program.getCycleTimer().getCycleTimeMs();
+}
+
+void PlcEngine::assignWorkers() {
+    uint8_t count = workers.getWorkerCount();
+    std::vector<PlcProgram*> list;
+    for (auto& pair : programs) {
+        list.push_back(pair.second.get());
+    }
+
+    // Group the programs that share variables or a partition (labels are
+    // merged pairwise, there are only a few programs)
+    size_t n = list.size();
+    std::vector<uint16_t> group(n);
+    for (size_t i = 0; i < n; i++) {
+        group[i] = static_cast<uint16_t>(i);
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+            bool samePartition = list[i]->getPartition() != 0 && list[i]->getPartition() == list[j]->getPartition();
+            if (group[i] != group[j] && (samePartition || list[i]->getMemory().sharesMeshLink(list[j]->getMemory()))) {
+                uint16_t from = group[j];
+                for (uint16_t& label : group) {
+                    if (label == from) {
+                        label = group[i];
+                    }
+                }
+            }
         }
     }
+
+    // Per group: load and core (the first pinned program decides)
+    std::vector<uint32_t> groupLoad(n, 0);
+    std::vector<uint8_t> groupCore(n, PlcProgramImage::CORE_ANY);
+    for (size_t i = 0; i < n; i++) {
+        groupLoad[group[i]] += scanLoad(*list[i]);
+        uint8_t core = list[i]->getCore();
+        if (core == PlcProgramImage::CORE_ANY) {
+            continue;
+        }
+        if (groupCore[group[i]] == PlcProgramImage::CORE_ANY) {
+            groupCore[group[i]] = core;
+        } else if (groupCore[group[i]] != core) {
+            EspHubLog->printf("WARNING: Program '%s' shares variables with a program on core %u, not scanned on core %u\n",
+                              list[i]->getName().c_str(), (unsigned)groupCore[group[i]], (unsigned)core);
+        }
+    }
+
+    // Pinned groups first, then the largest remaining group to the least loaded worker
+    std::vector<uint8_t> groupWorker(n, 0);
+    std::vector<uint16_t> unpinned;
+    uint32_t loads[PlcWorkerPool::MAX_WORKERS] = {0};
+    for (size_t g = 0; g < n; g++) {
+        if (group[g] != g) {
+            continue; // Not a group label
+        }
+        if (groupCore[g] == PlcProgramImage::CORE_ANY) {
+            unpinned.push_back(static_cast<uint16_t>(g));
+            continue;
+        }
+        uint8_t worker = 0;
+        while (worker < count && PlcWorkerPool::coreOf(worker) != groupCore[g]) {
+            worker++;
+        }
+        if (worker == count) {
+            EspHubLog->printf("WARNING: Program '%s': Core %u has no PLC worker, scanned on core 0\n",
+                              list[g]->getName().c_str(), (unsigned)groupCore[g]);
+            worker = 0;
+        }
+        groupWorker[g] = worker;
+        loads[worker] += groupLoad[g];
+    }
+    std::stable_sort(unpinned.begin(), unpinned.end(), [&groupLoad](uint16_t a, uint16_t b) { return groupLoad[a] > groupLoad[b]; });
+    for (uint16_t g : unpinned) {
+        uint8_t worker = 0;
+        for (uint8_t w = 1; w < count; w++) {
+            if (loads[w] < loads[worker]) {
+                worker = w;
+            }
+        }
+        groupWorker[g] = worker;
+        loads[worker] += groupLoad[g];
+    }
+
+    parallelCycles = false;
+    bool high = false;
+    for (size_t i = 0; i < n; i++) {
+        list[i]->setWorker(groupWorker[group[i]]);
+        parallelCycles |= list[i]->getWorker() != 0 && list[i]->getState() == PlcProgramState::RUNNING;
+        high |= list[i]->hasHighPriorityTask() && list[i]->getState() == PlcProgramState::RUNNING;
+    }
+    setHighPriority(high);
+    for (uint8_t w = 0; w < PlcWorkerPool::MAX_WORKERS; w++) {
+        workerStats[w].loadUsPerS = w < count ? loads[w] : 0;
+    }
+}
+
+void PlcEngine::setHighPriority(bool high) {
+    if (high == highPriority) {
+        return;
+    }
+    highPriority = high;
+    uint8_t priority = high ? PLC_HIGH_TASK_PRIORITY : PLC_TASK_PRIORITY;
+    workers.setPriority(priority);
+#ifndef UNIT_TEST
+    if (plcEngineTaskHandle != NULL) {
+        vTaskPrioritySet(plcEngineTaskHandle, priority);
+    }
+#endif
+    EspHubLog->printf("PLC task priority %u%s\n", (unsigned)priority, high ? " for high-priority task classes" : "");
+}
+
+void PlcEngine::setWorkerCount(uint8_t count) {
+    workerCount = std::max<uint8_t>(1, std::min<uint8_t>(count, PlcWorkerPool::MAX_WORKERS));
+}
+
+void PlcEngine::getWorkersJson(JsonObject out) const {
+    uint8_t count = workers.getWorkerCount();
+    out["workers"] = count;
+    out["parallel"] = parallelCycles;
+    out["high_priority"] = highPriority;
+    JsonArray list = out["worker"].to<JsonArray>();
+    for (uint8_t w = 0; w < count; w++) {
+        const WorkerStats& stats = workerStats[w];
+        JsonObject entry = list.add<JsonObject>();
+        entry["core"] = PlcWorkerPool::coreOf(w);
+        entry["load_us_per_s"] = stats.loadUsPerS;
+        entry["cycles"] = stats.cycles;
+        entry["busy_us"] = stats.busyUs;
+        entry["last_busy_us"] = stats.lastBusyUs;
+        JsonArray names = entry["programs"].to<JsonArray>();
+        for (auto const& [name, program] : programs) {
+            if (program->getWorker() == w) {
+                names.add(name);
+            }
+        }
+    }
+}
+
+void PlcEngine::setTickless(bool enabled) {
+    tickless = enabled;
+    memset(&powerStats, 0, sizeof(powerStats));
+    hasWaited = false;
+    wake(); // Parked programs resume when it is turned off
+}
+
+void PlcEngine::wake() {
+    wakePending.store(true, std::memory_order_release);
+    if (tickless) {
+        _clock->wake();
+    }
+}
+
+void PlcEngine::waitUntil(uint32_t deadlineUs) {
+    uint32_t start = _clock->nowMicros();
+    if (hasWaited) {
+        powerStats.activeUs += start - lastWakeUs;
+    }
+    bool early = _clock->waitUntil(deadlineUs);
+    lastWakeUs = _clock->nowMicros();
+    hasWaited = true;
+    powerStats.idleUs += lastWakeUs - start;
+    powerStats.wakeups++;
+    if (early) {
+        powerStats.eventWakeups++;
+    }
+}
+
+void PlcEngine::getPowerJson(JsonObject out) const {
+    uint64_t totalUs = powerStats.idleUs + powerStats.activeUs;
+    out["tickless"] = tickless;
+    out["wakeups"] = powerStats.wakeups;
+    out["event_wakeups"] = powerStats.eventWakeups;
+    out["wakeups_per_s"] = totalUs ? powerStats.wakeups * 1e6 / totalUs : 0.0;
+    out["idle_share"] = totalUs ? static_cast<double>(powerStats.idleUs) / totalUs : 0.0;
+    uint16_t parked = 0;
+    for (auto const& [name, program] : programs) {
+        parked += program->getState() == PlcProgramState::RUNNING && program->isParked();
+    }
+    out["parked_programs"] = parked;
 }
 
 void PlcEngine::plcEngineTask(void* parameter) {
@@ -194,7 +648,7 @@ void PlcEngine::plcEngineTask(void* parameter) {
 
     for (;;) {
         // esp_task_wdt_reset(); // Feed the dog
-        self->evaluateAllPrograms();
-        vTaskDelay(10 / portTICK_PERIOD_MS); // 10ms cycle
+        uint32_t nextDeadline = self->runDueCycles();
+        self->waitUntil(nextDeadline); // Absolute deadline, the scan time does not add to the period
     }
 }
\ No newline at end of file
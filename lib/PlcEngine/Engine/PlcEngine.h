@@ -8,6 +8,7 @@
 #include <esp_task_wdt.h>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 // Polyfill for std::make_unique if not available in C++11
 #if __cplusplus < 201402L
@@ -22,6 +23,24 @@ namespace std {
 #include "../../Core/TimeManager.h" // For scheduler blocks
 class MeshDeviceManager; // Forward declaration
 #include "../PlcEngine/Engine/PlcProgram.h" // New PlcProgram class
+#include "../PlcEngine/Engine/PlcClock.h"
+#include "../PlcEngine/Engine/PlcWorkerPool.h"
+
+// The PLC task sleeps until the next event instead of polling, see
+// PlcEngine::setTickless()
+#ifndef PLC_TICKLESS
+#define PLC_TICKLESS 0
+#endif
+
+// FreeRTOS priority of the PLC task and its workers. They run at
+// PLC_HIGH_TASK_PRIORITY while a running program has a task class with
+// "priority": "high", so its scans preempt the rest of the hub.
+#ifndef PLC_TASK_PRIORITY
+#define PLC_TASK_PRIORITY 1
+#endif
+#ifndef PLC_HIGH_TASK_PRIORITY
+#define PLC_HIGH_TASK_PRIORITY 10
+#endif
 
 enum class PlcEngineState {
     STOPPED,
@@ -33,26 +52,143 @@ public:
     PlcEngine(TimeManager* timeManager, MeshDeviceManager* meshDeviceManager);
     void begin();
     bool loadProgram(const String& programName, const char* jsonConfig);
+    bool loadProgramStream(const String& programName, PlcProgramLoader::ReadFunction read); // JSON read in chunks
+    bool loadProgramImage(const String& programName, const uint8_t* data, size_t size); // Precompiled, see PlcProgramImage
     void runProgram(const String& programName);
     void pauseProgram(const String& programName);
     void stopProgram(const String& programName);
     void deleteProgram(const String& programName);
+
+    // Online change: load a new version of an existing program while the
+    // current one keeps scanning, then swap them between two scans of the
+    // PLC task. Variable values and block state carry over (see
+    // PlcProgram::prepareTakeOver()). Returns once the new version is
+    // queued; it is swapped in before the next scan, or right away if the
+    // engine task is not running. One change at a time.
+    bool onlineChange(const String& programName, const char* jsonConfig);
+    bool onlineChangeStream(const String& programName, PlcProgramLoader::ReadFunction read);
+    bool isOnlineChangePending() const { return onlineChangeState.load(std::memory_order_acquire) != CHANGE_IDLE; }
+    const PlcOnlineChange& getLastOnlineChange() const { return lastOnlineChange; } // Valid when no change is pending
     PlcEngineState getEngineState() const { return currentEngineState; }
+
+    // Write the retentive values the PLC task has packed to NVS (see
+    // PlcRetentiveStore). Called from the main loop, never from the PLC task.
+    void commitRetentive();
+
     PlcProgram* getProgram(const String& programName);
     std::vector<String> getProgramNames() const;
     PlcMemory& getMemory() { return programs.at("main_program")->getMemory(); } // Expose PlcMemory for external access
 
-    // Called by the FreeRTOS task
+    // Scan every running program once, ignoring cycle times
     void evaluateAllPrograms();
 
+    // Scan the running programs whose deadline has been reached and return
+    // the time of the next deadline. Called by the FreeRTOS task.
+    uint32_t runDueCycles();
+
+    // Programs are scanned by up to PLC_WORKER_COUNT workers, one per core.
+    // Programs linked to the same mesh variable or given the same
+    // "partition" are scanned by one worker, in order; the others are
+    // spread over the workers by their scan load, or pinned with "core".
+    // All workers finish a cycle before the next one starts. The count
+    // takes effect when the engine task is started.
+    void setWorkerCount(uint8_t count);
+    uint8_t getWorkerCount() const { return workers.getWorkerCount(); }
+    void getWorkersJson(JsonObject out) const; // Assignment and busy time per worker
+    bool isHighPriority() const { return highPriority; } // Running at PLC_HIGH_TASK_PRIORITY
+
+    // Tickless mode, for hubs on batteries or solar power: a program whose
+    // scan changed no variable and whose blocks have no work left (see
+    // PlcBlock::needsScan()) is parked, and the PLC task sleeps until the
+    // earliest timer expiry of the parked programs or the next cycle of
+    // the others. Writes posted to a process image (LocalIOManager, web,
+    // mesh), DeviceRegistry value and status changes and runProgram()
+    // (IOEventManager triggers) wake it and the parked programs early.
+    // The cycle time stays the shortest period between two scans.
+    void setTickless(bool enabled);
+    bool isTickless() const { return tickless; }
+    void wake(); // From any task
+    // Block the PLC task until the deadline or a wake(), counting the
+    // wake-ups and the time spent idle
+    void waitUntil(uint32_t deadlineUs);
+    void getPowerJson(JsonObject out) const; // Wake-ups per second, idle share, parked programs
+
+    // Replace the time source (tests). The clock must outlive the engine.
+    void setClock(PlcClock* clock) { _clock = clock ? clock : &systemClock; }
+    PlcClock& getClock() { return *_clock; }
+
 private:
+    static constexpr uint32_t IDLE_POLL_US = 10000; // Wake-up period when no program is running
+    // Longest sleep in tickless mode. The timer wheels of parked programs
+    // follow the clock on every wake-up, well before its 32-bit wrap.
+    static constexpr uint32_t TICKLESS_MAX_SLEEP_US = 10000000;
+
     std::map<String, std::unique_ptr<PlcProgram>> programs;
     PlcEngineState currentEngineState;
     TaskHandle_t plcEngineTaskHandle;
     TimeManager* _timeManager;
     MeshDeviceManager* _meshDeviceManager;
+    SystemPlcClock systemClock;
+    PlcClock* _clock;
+
+    // Online change hand-over between the caller and the PLC task
+    enum : uint8_t { CHANGE_IDLE, CHANGE_PREPARING, CHANGE_PENDING, CHANGE_APPLYING };
+    std::atomic<uint8_t> onlineChangeState;
+    std::unique_ptr<PlcProgram> changedProgram;  // New version while pending, previous version once swapped
+    PlcProgram* changeTarget;
+    PlcOnlineChange lastOnlineChange;
+
+    bool swapChangedProgram();    // Between two scans
+    void finishOnlineChange();    // After the scans: free the previous version
+
+    // Worker assignment, recomputed by the PLC task when programs change
+    struct WorkerStats {
+        uint32_t loadUsPerS;    // Estimated scan time per second of the assigned programs
+        uint32_t cycles;        // Cycles in which the worker scanned a program
+        uint64_t busyUs;
+        uint32_t lastBusyUs;
+    };
+    uint8_t workerCount;
+    std::atomic<bool> placementChanged;
+    std::atomic<bool> captureRequested; // A program stopped: pack its retentive values at the cycle boundary
+    bool parallelCycles;        // Some running program is assigned to a worker other than 0
+    bool highPriority;          // Some running program has a high-priority task class
+    uint32_t cycleNowUs;        // Start of the cycle the workers run
+    WorkerStats workerStats[PlcWorkerPool::MAX_WORKERS];
+
+    // Tickless mode
+    struct PowerStats {
+        uint32_t wakeups;       // Returns from waitUntil()
+        uint32_t eventWakeups;  // Of them, ended early by wake()
+        uint64_t idleUs;        // Time in waitUntil()
+        uint64_t activeUs;      // Time between two waits
+    };
+    bool tickless;
+    std::atomic<bool> wakePending;
+    PowerStats powerStats;
+    uint32_t lastWakeUs;
+    bool hasWaited;
+
+    std::unique_ptr<PlcProgram> createProgram(const String& programName);
+    static void onInputPosted(void* context);
+    void unparkPrograms(uint32_t nowUs);
+    void captureStoppedPrograms(); // While no task scans them
+
+    void assignWorkers();
+    static uint32_t scanLoad(PlcProgram& program);
+    static void runWorker(void* context, uint8_t worker);
+    void scanDuePrograms(uint8_t worker);
+
+    void setHighPriority(bool high);
+
+    void scanProgram(PlcProgram& program);
+    void evaluateDueTasks(PlcProgram& program, uint32_t nowUs);
+    // Largest free heap block before and after loading or deleting a program
+    static void logFragmentation(const String& programName, const char* action, size_t largestBefore);
 
     static void plcEngineTask(void* parameter);
+
+    PlcWorkerPool workers; // Last, so the workers are stopped before anything they scan is destroyed
 };
 
 #endif // PLC_ENGINE_H
\ No newline at end of file
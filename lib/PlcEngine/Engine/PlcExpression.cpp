@@ -0,0 +1,1119 @@
+#include "../PlcEngine/Engine/PlcExpression.h"
+#include "../PlcEngine/Engine/PlcBytecode.h" // PLC_VM_COMPUTED_GOTO
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+enum Token : uint8_t {
+    TOK_END, TOK_NUMBER, TOK_NAME, TOK_TRUE, TOK_FALSE,
+    TOK_LPAREN, TOK_RPAREN, TOK_COMMA, TOK_QUESTION, TOK_COLON,
+    TOK_OROR, TOK_ANDAND, TOK_OR, TOK_XOR, TOK_AND,
+    TOK_EQ, TOK_NE, TOK_LT, TOK_LE, TOK_GT, TOK_GE, TOK_SHL, TOK_SHR,
+    TOK_PLUS, TOK_MINUS, TOK_STAR, TOK_SLASH, TOK_PERCENT,
+    TOK_NOT, TOK_TILDE
+};
+
+// Binding strength of the binary operators, 0 for other tokens
+uint8_t precedence(uint8_t token) {
+    switch (token) {
+        case TOK_OROR: return 1;
+        case TOK_ANDAND: return 2;
+        case TOK_OR: return 3;
+        case TOK_XOR: return 4;
+        case TOK_AND: return 5;
+        case TOK_EQ: case TOK_NE: return 6;
+        case TOK_LT: case TOK_LE: case TOK_GT: case TOK_GE: return 7;
+        case TOK_SHL: case TOK_SHR: return 8;
+        case TOK_PLUS: case TOK_MINUS: return 9;
+        case TOK_STAR: case TOK_SLASH: case TOK_PERCENT: return 10;
+        default: return 0;
+    }
+}
+
+enum Function : uint8_t { FN_MIN, FN_MAX, FN_ABS, FN_SQRT, FN_LIMIT };
+
+struct FunctionInfo {
+    const char* name;
+    uint8_t minArgs;
+    uint8_t maxArgs;
+};
+
+const uint8_t VARIADIC = 0xFF;
+
+const FunctionInfo FUNCTIONS[] = {
+    {"min", 2, VARIADIC}, {"max", 2, VARIADIC}, {"abs", 1, 1}, {"sqrt", 1, 1}, {"limit", 3, 3}
+};
+const uint8_t FUNCTION_COUNT = sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]);
+
+// Word operators, matched regardless of case
+struct Keyword {
+    const char* word;
+    uint8_t token;
+};
+
+const Keyword KEYWORDS[] = {
+    {"and", TOK_ANDAND}, {"or", TOK_OROR}, {"not", TOK_NOT}, {"xor", TOK_XOR},
+    {"mod", TOK_PERCENT}, {"true", TOK_TRUE}, {"false", TOK_FALSE}
+};
+
+bool equalsIgnoreCase(const char* text, size_t length, const char* word) {
+    for (size_t i = 0; i < length; i++) {
+        if (word[i] == '\0' || tolower(static_cast<unsigned char>(text[i])) != word[i]) {
+            return false;
+        }
+    }
+    return word[length] == '\0';
+}
+
+bool isNameStart(char c) {
+    return isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isNameChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+// Type of the operands of a binary operator or the branches of a choice
+PlcExpression::Type common(PlcExpression::Type a, PlcExpression::Type b) {
+    typedef PlcExpression::Type Type;
+    if (a == Type::REAL || b == Type::REAL) {
+        return Type::REAL;
+    }
+    return a == Type::BOOL && b == Type::BOOL ? Type::BOOL : Type::INT;
+}
+
+} // namespace
+
+/**
+ * Recursive descent parser building a syntax tree, then a type checking
+ * pass that binds the variables, then code generation with folding.
+ */
+class PlcExpression::Compiler {
+public:
+    Compiler(const char* source, Binder binder, void* context, PlcExprScope* scope)
+        : error(nullptr), errorPosition(0), source(source), cursor(source), binder(binder),
+          context(context), scope(scope), token(TOK_END), tokenStart(source), tokenLength(0), nesting(0), depth(0) {
+        number.i = 0;
+        numberType = Type::INT;
+    }
+
+    const char* error;
+    size_t errorPosition;
+
+    bool compile(PlcArenaVector<PlcExprInstruction>& out, Type& resultType, Type hint) {
+        if (strlen(source) > MAX_SOURCE) {
+            return fail("expression too long");
+        }
+        next();
+        if (token == TOK_END) {
+            return fail("empty expression");
+        }
+        int root = parseChoice();
+        if (!error && token != TOK_END) {
+            fail("unexpected text after the expression");
+        }
+        Hint top = hint == Type::BOOL ? Hint::CONDITION : hint == Type::INT ? Hint::INTEGER : Hint::VALUE;
+        if (error || !check(root, top)) {
+            return false;
+        }
+        resultType = nodes[root].type;
+        emitAs(root, resultType);
+        if (error) {
+            return false;
+        }
+        out.assign(code.begin(), code.end());
+        return true;
+    }
+
+private:
+    enum class Kind : uint8_t { LITERAL, VARIABLE, UNARY, BINARY, CALL, CHOICE };
+    enum class Hint : uint8_t { VALUE, CONDITION, INTEGER };
+
+    struct Node {
+        Kind kind;
+        uint8_t op;         // Token or Function
+        Type type;
+        bool constant;      // Made of literals only
+        uint16_t position;
+        int16_t args[3];
+        uint16_t nameLength;
+        const char* name;
+        VarHandle var;
+        PlcExprValue value;
+    };
+
+    static constexpr int MAX_NESTING = 32;
+    static constexpr size_t MAX_SOURCE = 4096; // Node indices and positions fit 16 bits
+
+    const char* source;
+    const char* cursor;
+    Binder binder;
+    void* context;
+    PlcExprScope* scope;
+
+    uint8_t token;
+    const char* tokenStart;
+    size_t tokenLength;
+    PlcExprValue number;
+    Type numberType;
+    int nesting;
+
+    std::vector<Node> nodes;
+    std::vector<PlcExprInstruction> code;
+    size_t depth;
+    std::vector<std::string> keys;  // Canonical form of each node, built on demand
+
+    bool fail(const char* message, const char* at = nullptr) {
+        if (!error) {
+            error = message;
+            errorPosition = (at ? at : tokenStart) - source;
+        }
+        return false;
+    }
+
+    // ========== Lexer ==========
+
+    void next() {
+        while (isspace(static_cast<unsigned char>(*cursor))) {
+            cursor++;
+        }
+        tokenStart = cursor;
+        char c = *cursor;
+        if (c == '\0') {
+            token = TOK_END;
+        } else if (isdigit(static_cast<unsigned char>(c)) || (c == '.' && isdigit(static_cast<unsigned char>(cursor[1])))) {
+            lexNumber();
+        } else if (isNameStart(c)) {
+            while (isNameChar(*cursor)) {
+                cursor++;
+            }
+            token = TOK_NAME;
+            for (const Keyword& keyword : KEYWORDS) {
+                if (equalsIgnoreCase(tokenStart, cursor - tokenStart, keyword.word)) {
+                    token = keyword.token;
+                    break;
+                }
+            }
+        } else {
+            lexOperator(c);
+        }
+        tokenLength = cursor - tokenStart;
+    }
+
+    void lexNumber() {
+        token = TOK_NUMBER;
+        char* end;
+        if (cursor[0] == '0' && (cursor[1] == 'x' || cursor[1] == 'X')) {
+            unsigned long value = strtoul(cursor + 2, &end, 16);
+            if (end == cursor + 2 || value > 0xFFFFFFFFul) {
+                fail("invalid number", cursor);
+            }
+            number.i = static_cast<int32_t>(static_cast<uint32_t>(value));
+            numberType = Type::INT;
+        } else {
+            double value = strtod(cursor, &end);
+            bool integral = true;
+            for (const char* p = cursor; p < end; p++) {
+                if (*p == '.' || *p == 'e' || *p == 'E') {
+                    integral = false;
+                }
+            }
+            if (integral && value <= INT32_MAX) {
+                number.i = static_cast<int32_t>(value);
+                numberType = Type::INT;
+            } else {
+                number.f = static_cast<float>(value);
+                numberType = Type::REAL;
+            }
+        }
+        cursor = end;
+        if (isNameChar(*cursor)) {
+            fail("invalid number", tokenStart);
+        }
+    }
+
+    void lexOperator(char c) {
+        char c2 = cursor[1];
+        size_t length = 1;
+        switch (c) {
+            case '(': token = TOK_LPAREN; break;
+            case ')': token = TOK_RPAREN; break;
+            case ',': token = TOK_COMMA; break;
+            case '?': token = TOK_QUESTION; break;
+            case ':': token = TOK_COLON; break;
+            case '+': token = TOK_PLUS; break;
+            case '-': token = TOK_MINUS; break;
+            case '*': token = TOK_STAR; break;
+            case '/': token = TOK_SLASH; break;
+            case '%': token = TOK_PERCENT; break;
+            case '~': token = TOK_TILDE; break;
+            case '^': token = TOK_XOR; break;
+            case '|':
+                token = c2 == '|' ? TOK_OROR : TOK_OR;
+                length = c2 == '|' ? 2 : 1;
+                break;
+            case '&':
+                token = c2 == '&' ? TOK_ANDAND : TOK_AND;
+                length = c2 == '&' ? 2 : 1;
+                break;
+            case '=':
+                token = TOK_EQ;
+                length = c2 == '=' ? 2 : 1;
+                break;
+            case '!':
+                token = c2 == '=' ? TOK_NE : TOK_NOT;
+                length = c2 == '=' ? 2 : 1;
+                break;
+            case '<':
+                if (c2 == '=') { token = TOK_LE; length = 2; }
+                else if (c2 == '>') { token = TOK_NE; length = 2; }
+                else if (c2 == '<') { token = TOK_SHL; length = 2; }
+                else { token = TOK_LT; }
+                break;
+            case '>':
+                if (c2 == '=') { token = TOK_GE; length = 2; }
+                else if (c2 == '>') { token = TOK_SHR; length = 2; }
+                else { token = TOK_GT; }
+                break;
+            default:
+                fail("unexpected character", cursor);
+                token = TOK_END;
+                return;
+        }
+        cursor += length;
+    }
+
+    // ========== Parser ==========
+
+    int addNode(Kind kind, uint8_t op, const char* at) {
+        Node node = {};
+        node.kind = kind;
+        node.op = op;
+        node.position = static_cast<uint16_t>(at - source);
+        node.args[0] = node.args[1] = node.args[2] = -1;
+        nodes.push_back(node);
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    // cond ? a : b, right associative
+    int parseChoice() {
+        if (++nesting > MAX_NESTING) {
+            fail("expression nested too deeply");
+            return -1;
+        }
+        int condition = parseBinary(1);
+        if (!error && token == TOK_QUESTION) {
+            const char* at = tokenStart;
+            next();
+            int a = parseChoice();
+            if (!error && token != TOK_COLON) {
+                fail("expected ':'");
+            }
+            next();
+            int b = parseChoice();
+            int node = addNode(Kind::CHOICE, 0, at);
+            nodes[node].args[0] = static_cast<int16_t>(condition);
+            nodes[node].args[1] = static_cast<int16_t>(a);
+            nodes[node].args[2] = static_cast<int16_t>(b);
+            condition = node;
+        }
+        nesting--;
+        return condition;
+    }
+
+    // Precedence climbing over the left associative binary operators
+    int parseBinary(uint8_t minPrecedence) {
+        int left = parseUnary();
+        while (!error && precedence(token) >= minPrecedence && precedence(token) > 0) {
+            uint8_t op = token;
+            const char* at = tokenStart;
+            next();
+            int right = parseBinary(precedence(op) + 1);
+            int node = addNode(Kind::BINARY, op, at);
+            nodes[node].args[0] = static_cast<int16_t>(left);
+            nodes[node].args[1] = static_cast<int16_t>(right);
+            left = node;
+        }
+        return left;
+    }
+
+    int parseUnary() {
+        if (token == TOK_MINUS || token == TOK_PLUS || token == TOK_NOT || token == TOK_TILDE) {
+            if (++nesting > MAX_NESTING) {
+                fail("expression nested too deeply");
+                return -1;
+            }
+            uint8_t op = token;
+            const char* at = tokenStart;
+            next();
+            int operand = parseUnary();
+            nesting--;
+            if (op == TOK_PLUS) {
+                return operand;
+            }
+            int node = addNode(Kind::UNARY, op, at);
+            nodes[node].args[0] = static_cast<int16_t>(operand);
+            return node;
+        }
+        return parsePrimary();
+    }
+
+    int parsePrimary() {
+        if (error) {
+            return -1;
+        }
+        const char* at = tokenStart;
+        switch (token) {
+            case TOK_NUMBER: {
+                int node = addNode(Kind::LITERAL, 0, at);
+                nodes[node].type = numberType;
+                nodes[node].value = number;
+                nodes[node].constant = true;
+                next();
+                return node;
+            }
+            case TOK_TRUE:
+            case TOK_FALSE: {
+                int node = addNode(Kind::LITERAL, 0, at);
+                nodes[node].type = Type::BOOL;
+                nodes[node].value.i = token == TOK_TRUE ? 1 : 0;
+                nodes[node].constant = true;
+                next();
+                return node;
+            }
+            case TOK_LPAREN: {
+                next();
+                int inner = parseChoice();
+                if (!error && token != TOK_RPAREN) {
+                    fail("expected ')'");
+                }
+                next();
+                return inner;
+            }
+            case TOK_NAME: {
+                const char* name = tokenStart;
+                size_t length = tokenLength;
+                next();
+                if (token == TOK_LPAREN) {
+                    return parseCall(name, length);
+                }
+                if (length >= MAX_NAME) {
+                    fail("variable name too long", name);
+                    return -1;
+                }
+                int node = addNode(Kind::VARIABLE, 0, at);
+                nodes[node].name = name;
+                nodes[node].nameLength = static_cast<uint16_t>(length);
+                return node;
+            }
+            default:
+                fail(token == TOK_END ? "unexpected end of the expression" : "expected an operand");
+                return -1;
+        }
+    }
+
+    int parseCall(const char* name, size_t length) {
+        uint8_t function = FUNCTION_COUNT;
+        for (uint8_t i = 0; i < FUNCTION_COUNT; i++) {
+            if (equalsIgnoreCase(name, length, FUNCTIONS[i].name)) {
+                function = i;
+            }
+        }
+        if (function == FUNCTION_COUNT) {
+            fail("unknown function", name);
+            return -1;
+        }
+        next();
+        std::vector<int> args;
+        while (!error) {
+            args.push_back(parseChoice());
+            if (token != TOK_COMMA) {
+                break;
+            }
+            next();
+        }
+        if (!error && token != TOK_RPAREN) {
+            fail("expected ')'");
+        }
+        next();
+        if (error) {
+            return -1;
+        }
+        const FunctionInfo& info = FUNCTIONS[function];
+        if (args.size() < info.minArgs || args.size() > info.maxArgs) {
+            fail("wrong number of arguments", name);
+            return -1;
+        }
+        // min and max take their arguments two at a time
+        size_t direct = info.maxArgs == VARIADIC ? 2 : args.size();
+        int node = addNode(Kind::CALL, function, name);
+        for (size_t i = 0; i < direct; i++) {
+            nodes[node].args[i] = static_cast<int16_t>(args[i]);
+        }
+        for (size_t i = direct; i < args.size(); i++) {
+            int chained = addNode(Kind::CALL, function, name);
+            nodes[chained].args[0] = static_cast<int16_t>(node);
+            nodes[chained].args[1] = static_cast<int16_t>(args[i]);
+            node = chained;
+        }
+        return node;
+    }
+
+    // ========== Type checking ==========
+
+    bool check(int index, Hint hint) {
+        Node& node = nodes[index];
+        bool ok = true;
+        switch (node.kind) {
+            case Kind::LITERAL:
+                return true;
+            case Kind::VARIABLE:
+                return bind(node, hint);
+            case Kind::UNARY:
+                ok = check(node.args[0], node.op == TOK_NOT ? Hint::CONDITION
+                                       : node.op == TOK_TILDE ? Hint::INTEGER : Hint::VALUE);
+                break;
+            case Kind::BINARY: {
+                Hint operands = Hint::VALUE;
+                if (node.op == TOK_ANDAND || node.op == TOK_OROR) {
+                    operands = Hint::CONDITION;
+                } else if (node.op == TOK_AND || node.op == TOK_OR || node.op == TOK_XOR ||
+                           node.op == TOK_SHL || node.op == TOK_SHR) {
+                    operands = Hint::INTEGER;
+                }
+                ok = check(node.args[0], operands) && check(node.args[1], operands);
+                break;
+            }
+            case Kind::CALL:
+                for (int i = 0; i < 3 && ok; i++) {
+                    if (node.args[i] >= 0) {
+                        ok = check(node.args[i], Hint::VALUE);
+                    }
+                }
+                break;
+            case Kind::CHOICE:
+                ok = check(node.args[0], Hint::CONDITION) && check(node.args[1], hint) && check(node.args[2], hint);
+                break;
+        }
+        return ok && infer(nodes[index]);
+    }
+
+    bool bind(Node& node, Hint hint) {
+        char name[MAX_NAME];
+        memcpy(name, node.name, node.nameLength);
+        name[node.nameLength] = '\0';
+        PlcValueType declareAs = hint == Hint::CONDITION ? PlcValueType::BOOL
+                               : hint == Hint::INTEGER ? PlcValueType::DINT : PlcValueType::REAL;
+        node.var = binder(context, name, declareAs);
+        if (!node.var.isValid()) {
+            return fail("cannot bind variable", source + node.position);
+        }
+        switch (node.var.type) {
+            case PlcValueType::BOOL: node.type = Type::BOOL; break;
+            case PlcValueType::REAL: node.type = Type::REAL; break;
+            case PlcValueType::STRING_TYPE: return fail("string variables are not supported", source + node.position);
+            default: node.type = Type::INT; break;
+        }
+        return true;
+    }
+
+    // Result type of an operator node from its checked operands
+    bool infer(Node& node) {
+        const Node* a = node.args[0] >= 0 ? &nodes[node.args[0]] : nullptr;
+        const Node* b = node.args[1] >= 0 ? &nodes[node.args[1]] : nullptr;
+        const Node* c = node.args[2] >= 0 ? &nodes[node.args[2]] : nullptr;
+        node.constant = (!a || a->constant) && (!b || b->constant) && (!c || c->constant);
+        const char* at = source + node.position;
+        switch (node.kind) {
+            case Kind::UNARY:
+                if (node.op == TOK_NOT) {
+                    node.type = Type::BOOL;
+                } else if (a->type == Type::REAL) {
+                    if (node.op == TOK_TILDE) {
+                        return fail("bit operators need integer operands", at);
+                    }
+                    node.type = Type::REAL;
+                } else {
+                    node.type = node.op == TOK_TILDE && a->type == Type::BOOL ? Type::BOOL : Type::INT;
+                }
+                break;
+            case Kind::BINARY:
+                switch (node.op) {
+                    case TOK_OROR: case TOK_ANDAND:
+                    case TOK_EQ: case TOK_NE: case TOK_LT: case TOK_LE: case TOK_GT: case TOK_GE:
+                        node.type = Type::BOOL;
+                        break;
+                    case TOK_AND: case TOK_OR: case TOK_XOR: case TOK_SHL: case TOK_SHR:
+                        if (a->type == Type::REAL || b->type == Type::REAL) {
+                            return fail("bit operators need integer operands", at);
+                        }
+                        node.type = node.op == TOK_SHL || node.op == TOK_SHR ? Type::INT : common(a->type, b->type);
+                        break;
+                    default:
+                        node.type = common(a->type, b->type) == Type::REAL ? Type::REAL : Type::INT;
+                        break;
+                }
+                break;
+            case Kind::CALL:
+                switch (node.op) {
+                    case FN_SQRT: node.type = Type::REAL; break;
+                    case FN_ABS: node.type = a->type == Type::REAL ? Type::REAL : Type::INT; break;
+                    case FN_LIMIT: node.type = common(common(a->type, b->type), c->type); break;
+                    default: node.type = common(a->type, b->type); break;
+                }
+                break;
+            case Kind::CHOICE:
+                node.type = common(b->type, c->type);
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    // ========== Code generation ==========
+
+    void emit(PlcExprOpcode op, PlcExprOperand operand = PlcExprOperand::STACK, uint16_t slot = 0) {
+        PlcExprInstruction instruction = {};
+        instruction.op = static_cast<uint8_t>(op);
+        instruction.operand = static_cast<uint8_t>(operand);
+        instruction.slot = slot;
+        code.push_back(instruction);
+
+        // LOAD pushes, a binary opcode pops its operand if it is on the stack
+        if (op == PlcExprOpcode::LOAD) {
+            depth++;
+        } else if (op >= PlcExprOpcode::LIMIT_I) {
+            depth -= 2;
+        } else if (op >= PlcExprOpcode::ADD_I && operand == PlcExprOperand::STACK) {
+            depth--;
+        }
+        if (depth > MAX_STACK) {
+            fail("expression too complex", source);
+        }
+    }
+
+    void emitConstant(PlcExprValue value) {
+        emit(PlcExprOpcode::LOAD, PlcExprOperand::CONST);
+        code.back().k = value;
+    }
+
+    void convert(Type from, Type to) {
+        if (from == to || (from == Type::BOOL && to == Type::INT)) {
+            return;
+        }
+        if (to == Type::REAL) {
+            emit(PlcExprOpcode::I_TO_R);
+        } else if (to == Type::BOOL) {
+            emit(from == Type::REAL ? PlcExprOpcode::R_TO_B : PlcExprOpcode::I_TO_B);
+        } else {
+            emit(PlcExprOpcode::R_TO_I);
+        }
+    }
+
+    // Code leaving the value of the node, converted to type, on the stack
+    void emitAs(int index, Type type) {
+        if (error) {
+            return;
+        }
+        const Node& node = nodes[index];
+        size_t mark = code.size();
+        size_t before = depth;
+        if (!emitShared(index)) {
+            emitNode(node);
+        }
+        if (node.kind == Kind::VARIABLE && type == Type::REAL && node.type != Type::REAL) {
+            code.back().operand = static_cast<uint8_t>(widenedOperand(node.var.type));
+        } else {
+            convert(node.type, type);
+        }
+        if (node.constant && !error && code.size() - mark > 1) {
+            // Literals only: run the code now and keep the result
+            PlcExprValue value = run(code.data() + mark, code.size() - mark, nullptr, nullptr);
+            code.resize(mark);
+            depth = before;
+            emitConstant(value);
+        }
+    }
+
+    // ========== Shared subexpressions ==========
+
+    // With a scope, an operator node is either loaded from the temporary of
+    // an equal subtree computed earlier or computed and stored in a new one
+    bool emitShared(int index) {
+        const Node& node = nodes[index];
+        if (scope == nullptr || node.constant || node.kind == Kind::LITERAL || node.kind == Kind::VARIABLE) {
+            return false;
+        }
+        const std::string& key = keyOf(index);
+        for (const PlcExprScope::Entry& entry : scope->entries) {
+            if (entry.key == key) {
+                emit(PlcExprOpcode::LOAD, PlcExprOperand::TEMP, entry.temp);
+                return true;
+            }
+        }
+        emitNode(node);
+        if (error || scope->nextTemp == 0xFFFF) {
+            return true;
+        }
+        emit(PlcExprOpcode::STORE_T, PlcExprOperand::STACK, scope->nextTemp);
+        if (scope->entries.size() >= PlcExprScope::MAX_ENTRIES) {
+            scope->entries.erase(scope->entries.begin()); // The oldest
+        }
+        PlcExprScope::Entry entry;
+        entry.key = key;
+        entry.temp = scope->nextTemp++;
+        collectSlots(index, entry.slots);
+        scope->entries.push_back(std::move(entry));
+        return true;
+    }
+
+    // Equal keys mean equal values: same operators, types, slots and literals
+    const std::string& keyOf(int index) {
+        keys.resize(nodes.size());
+        std::string& key = keys[index];
+        if (!key.empty()) {
+            return key;
+        }
+        const Node& node = nodes[index];
+        char text[32];
+        switch (node.kind) {
+            case Kind::LITERAL:
+                snprintf(text, sizeof(text), "#%u:%08x", static_cast<unsigned>(node.type), static_cast<unsigned>(node.value.i));
+                key = text;
+                break;
+            case Kind::VARIABLE:
+                snprintf(text, sizeof(text), "$%u", static_cast<unsigned>(node.var.index));
+                key = text;
+                break;
+            default:
+                snprintf(text, sizeof(text), "(%u.%u.%u", static_cast<unsigned>(node.kind), static_cast<unsigned>(node.op),
+                         static_cast<unsigned>(node.type));
+                key = text;
+                for (int i = 0; i < 3; i++) {
+                    if (node.args[i] >= 0) {
+                        key += ' ';
+                        key += keyOf(node.args[i]); // keys is not resized again
+                    }
+                }
+                key += ')';
+                break;
+        }
+        return key;
+    }
+
+    void collectSlots(int index, std::vector<uint16_t>& slots) const {
+        const Node& node = nodes[index];
+        if (node.kind == Kind::VARIABLE) {
+            slots.push_back(node.var.index);
+        }
+        for (int i = 0; i < 3; i++) {
+            if (node.args[i] >= 0) {
+                collectSlots(node.args[i], slots);
+            }
+        }
+    }
+
+    static PlcExprOperand slotOperand(PlcValueType type) {
+        switch (type) {
+            case PlcValueType::BOOL: return PlcExprOperand::BOOL;
+            case PlcValueType::BYTE: return PlcExprOperand::BYTE;
+            case PlcValueType::INT: return PlcExprOperand::INT;
+            case PlcValueType::DINT: return PlcExprOperand::DINT;
+            default: return PlcExprOperand::REAL;
+        }
+    }
+
+    static PlcExprOperand widenedOperand(PlcValueType type) {
+        switch (type) {
+            case PlcValueType::BOOL: return PlcExprOperand::BOOL_R;
+            case PlcValueType::BYTE: return PlcExprOperand::BYTE_R;
+            case PlcValueType::INT: return PlcExprOperand::INT_R;
+            default: return PlcExprOperand::DINT_R;
+        }
+    }
+
+    void emitNode(const Node& node) {
+        typedef PlcExprOpcode Op;
+        switch (node.kind) {
+            case Kind::LITERAL:
+                emitConstant(node.value);
+                break;
+            case Kind::VARIABLE:
+                emit(Op::LOAD, slotOperand(node.var.type), node.var.index);
+                break;
+            case Kind::UNARY:
+                if (node.op == TOK_NOT || (node.op == TOK_TILDE && node.type == Type::BOOL)) {
+                    emitAs(node.args[0], Type::BOOL);
+                    emit(Op::NOT_B);
+                } else {
+                    emitAs(node.args[0], node.type);
+                    bool real = node.type == Type::REAL;
+                    emit(node.op == TOK_TILDE ? Op::BNOT_I : real ? Op::NEG_R : Op::NEG_I);
+                }
+                break;
+            case Kind::BINARY:
+                emitBinary(node);
+                break;
+            case Kind::CALL:
+                emitCall(node);
+                break;
+            case Kind::CHOICE:
+                emitAs(node.args[0], Type::BOOL);
+                emitAs(node.args[1], node.type);
+                emitAs(node.args[2], node.type);
+                emit(Op::SELECT);
+                break;
+        }
+    }
+
+    // Both operands, then op. A right operand that compiled to a single
+    // LOAD becomes the operand of op instead.
+    void emitOperands(int left, int right, Type type, PlcExprOpcode op) {
+        emitAs(left, type);
+        size_t mark = code.size();
+        emitAs(right, type);
+        if (error) {
+            return;
+        }
+        if (code.size() == mark + 1 && code.back().op == static_cast<uint8_t>(PlcExprOpcode::LOAD)) {
+            PlcExprInstruction load = code.back();
+            code.pop_back();
+            depth--;
+            emit(op, static_cast<PlcExprOperand>(load.operand), load.slot);
+            code.back().k = load.k;
+        } else {
+            emit(op);
+        }
+    }
+
+    void emitBinary(const Node& node) {
+        typedef PlcExprOpcode Op;
+        Type operands = node.type;
+        if (node.op == TOK_ANDAND || node.op == TOK_OROR) {
+            operands = Type::BOOL;
+        } else if (node.type == Type::BOOL && node.op != TOK_AND && node.op != TOK_OR && node.op != TOK_XOR) {
+            // Comparison: bools compare as integers
+            operands = common(nodes[node.args[0]].type, nodes[node.args[1]].type);
+        }
+        bool real = operands == Type::REAL;
+        Op op;
+        switch (node.op) {
+            case TOK_OROR: case TOK_OR: op = Op::OR_I; break;
+            case TOK_ANDAND: case TOK_AND: op = Op::AND_I; break;
+            case TOK_XOR: op = Op::XOR_I; break;
+            case TOK_SHL: op = Op::SHL_I; break;
+            case TOK_SHR: op = Op::SHR_I; break;
+            case TOK_EQ: op = real ? Op::EQ_R : Op::EQ_I; break;
+            case TOK_NE: op = real ? Op::NE_R : Op::NE_I; break;
+            case TOK_LT: op = real ? Op::LT_R : Op::LT_I; break;
+            case TOK_LE: op = real ? Op::LE_R : Op::LE_I; break;
+            case TOK_GT: op = real ? Op::GT_R : Op::GT_I; break;
+            case TOK_GE: op = real ? Op::GE_R : Op::GE_I; break;
+            case TOK_PLUS: op = real ? Op::ADD_R : Op::ADD_I; break;
+            case TOK_MINUS: op = real ? Op::SUB_R : Op::SUB_I; break;
+            case TOK_STAR: op = real ? Op::MUL_R : Op::MUL_I; break;
+            case TOK_SLASH: op = real ? Op::DIV_R : Op::DIV_I; break;
+            default: op = real ? Op::MOD_R : Op::MOD_I; break;
+        }
+        emitOperands(node.args[0], node.args[1], operands, op);
+    }
+
+    void emitCall(const Node& node) {
+        typedef PlcExprOpcode Op;
+        bool real = node.type == Type::REAL;
+        switch (node.op) {
+            case FN_SQRT:
+                emitAs(node.args[0], Type::REAL);
+                emit(Op::SQRT_R);
+                break;
+            case FN_ABS:
+                emitAs(node.args[0], node.type);
+                emit(real ? Op::ABS_R : Op::ABS_I);
+                break;
+            case FN_LIMIT:
+                for (int i = 0; i < 3; i++) {
+                    emitAs(node.args[i], node.type);
+                }
+                emit(real ? Op::LIMIT_R : Op::LIMIT_I);
+                break;
+            case FN_MIN:
+                emitOperands(node.args[0], node.args[1], node.type, real ? Op::MIN_R : Op::MIN_I);
+                break;
+            default:
+                emitOperands(node.args[0], node.args[1], node.type, real ? Op::MAX_R : Op::MAX_I);
+                break;
+        }
+    }
+};
+
+bool PlcExpression::compile(const char* source, Binder binder, void* context, PlcArena* arena,
+                            PlcExprScope* scope, Type hint) {
+    PlcArenaVector<PlcExprInstruction>(PlcArenaAllocator<PlcExprInstruction>(arena)).swap(code);
+    error = nullptr;
+    errorPosition = 0;
+    if (source == nullptr) {
+        error = "empty expression";
+        return false;
+    }
+    Compiler compiler(source, binder, context, scope);
+    if (!compiler.compile(code, resultType, hint)) {
+        code.clear();
+        error = compiler.error;
+        errorPosition = compiler.errorPosition;
+        return false;
+    }
+    return true;
+}
+
+void PlcExprScope::invalidate(uint16_t slot) {
+    for (size_t i = entries.size(); i-- > 0;) {
+        const std::vector<uint16_t>& slots = entries[i].slots;
+        if (std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+            entries.erase(entries.begin() + i);
+        }
+    }
+}
+
+size_t PlcExprScope::finish(PlcExpression* const* expressions, size_t count) {
+    const uint16_t UNUSED = 0xFFFF;
+    std::vector<uint16_t> number(nextTemp, UNUSED);
+    for (size_t i = 0; i < count; i++) {
+        for (const PlcExprInstruction& instruction : expressions[i]->code) {
+            if (instruction.operand == static_cast<uint8_t>(PlcExprOperand::TEMP)) {
+                number[instruction.slot] = 0;
+            }
+        }
+    }
+    uint16_t used = 0;
+    for (uint16_t& n : number) {
+        if (n != UNUSED) {
+            n = used++;
+        }
+    }
+
+    sharedCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        PlcArenaVector<PlcExprInstruction>& code = expressions[i]->code;
+        code.erase(std::remove_if(code.begin(), code.end(), [&number](const PlcExprInstruction& instruction) {
+            return instruction.op == static_cast<uint8_t>(PlcExprOpcode::STORE_T) && number[instruction.slot] == UNUSED;
+        }), code.end());
+        for (PlcExprInstruction& instruction : code) {
+            if (instruction.op == static_cast<uint8_t>(PlcExprOpcode::STORE_T)) {
+                instruction.slot = number[instruction.slot];
+            } else if (instruction.operand == static_cast<uint8_t>(PlcExprOperand::TEMP)) {
+                instruction.slot = number[instruction.slot];
+                sharedCount++;
+            }
+        }
+    }
+    entries.clear();
+    nextTemp = 0;
+    return used;
+}
+
+VarHandle PlcExpression::getVariable() const {
+    if (code.size() != 1) {
+        return VarHandle();
+    }
+    switch (static_cast<PlcExprOperand>(code[0].operand)) {
+        case PlcExprOperand::BOOL: return VarHandle(code[0].slot, PlcValueType::BOOL);
+        case PlcExprOperand::BYTE: return VarHandle(code[0].slot, PlcValueType::BYTE);
+        case PlcExprOperand::INT: return VarHandle(code[0].slot, PlcValueType::INT);
+        case PlcExprOperand::DINT: return VarHandle(code[0].slot, PlcValueType::DINT);
+        case PlcExprOperand::REAL: return VarHandle(code[0].slot, PlcValueType::REAL);
+        default: return VarHandle(); // Constant, temporary or read as another type
+    }
+}
+
+PlcValueType PlcExpression::slotType(Type type) {
+    switch (type) {
+        case Type::BOOL: return PlcValueType::BOOL;
+        case Type::INT: return PlcValueType::DINT;
+        default: return PlcValueType::REAL;
+    }
+}
+
+// Integer arithmetic wraps around instead of overflowing
+static inline int32_t wrap(uint32_t value) {
+    return static_cast<int32_t>(value);
+}
+
+static inline int32_t toInt(float value) {
+    if (!(value > -2147483648.0f)) {
+        return value != value ? 0 : INT32_MIN; // NaN
+    }
+    return value >= 2147483647.0f ? INT32_MAX : static_cast<int32_t>(value);
+}
+
+PlcExprValue PlcExpression::run(const PlcExprInstruction* code, size_t count, const PlcMemory* memory, PlcExprValue* temps) {
+    PlcExprValue acc; // Top of the stack
+    acc.i = 0;
+    if (count == 0) {
+        return acc;
+    }
+
+    PlcExprValue stack[MAX_STACK]; // The values below it
+    size_t sp = 0;
+    PlcExprValue b;
+    const PlcExprInstruction* ip = code;
+    const PlcExprInstruction* end = code + count;
+
+    // Constant folding runs without a memory, on CONST operands only
+    const PlcVariable* slots = memory ? memory->slots.data() : nullptr;
+    const uint32_t* bits = memory ? memory->boolBits.data() : nullptr;
+    const uint8_t* bytes = memory ? memory->byteValues.data() : nullptr;
+    const int16_t* ints = memory ? memory->intValues.data() : nullptr;
+    const int32_t* dints = memory ? memory->dintValues.data() : nullptr;
+    const float* reals = memory ? memory->realValues.data() : nullptr;
+
+// Operand of the instruction into b; for STACK, b is the top and the
+// value below it moves up into acc
+#define BIT(offset) static_cast<int32_t>((bits[(offset) >> 5] >> ((offset) & 31)) & 1)
+#define FETCH() \
+    do { \
+        uint16_t offset_; \
+        switch (static_cast<PlcExprOperand>(ip->operand)) { \
+            case PlcExprOperand::STACK: b = acc; acc = stack[--sp]; break; \
+            case PlcExprOperand::CONST: b = ip->k; break; \
+            case PlcExprOperand::BOOL: offset_ = slots[ip->slot].offset; b.i = BIT(offset_); break; \
+            case PlcExprOperand::BYTE: b.i = bytes[slots[ip->slot].offset]; break; \
+            case PlcExprOperand::INT: b.i = ints[slots[ip->slot].offset]; break; \
+            case PlcExprOperand::DINT: b.i = dints[slots[ip->slot].offset]; break; \
+            case PlcExprOperand::REAL: b.f = reals[slots[ip->slot].offset]; break; \
+            case PlcExprOperand::BOOL_R: offset_ = slots[ip->slot].offset; b.f = static_cast<float>(BIT(offset_)); break; \
+            case PlcExprOperand::BYTE_R: b.f = bytes[slots[ip->slot].offset]; break; \
+            case PlcExprOperand::INT_R: b.f = ints[slots[ip->slot].offset]; break; \
+            case PlcExprOperand::DINT_R: b.f = static_cast<float>(dints[slots[ip->slot].offset]); break; \
+            case PlcExprOperand::TEMP: b = temps[ip->slot]; break; \
+            default: b.i = 0; break; /* Never emitted by the compiler */ \
+        } \
+    } while (0)
+#define BINARY_I(expr) { FETCH(); int32_t a = acc.i; acc.i = (expr); EXPR_NEXT(); }
+#define BINARY_R(expr) { FETCH(); float a = acc.f; acc.f = (expr); EXPR_NEXT(); }
+#define COMPARE_R(expr) { FETCH(); float a = acc.f; acc.i = (expr); EXPR_NEXT(); }
+
+#if PLC_VM_COMPUTED_GOTO
+    static const void* const dispatch[] = {
+        &&op_LOAD,
+        &&op_I_TO_R, &&op_R_TO_I, &&op_I_TO_B, &&op_R_TO_B,
+        &&op_NEG_I, &&op_NEG_R, &&op_NOT_B, &&op_BNOT_I, &&op_ABS_I, &&op_ABS_R, &&op_SQRT_R, &&op_STORE_T,
+        &&op_ADD_I, &&op_SUB_I, &&op_MUL_I, &&op_DIV_I, &&op_MOD_I,
+        &&op_ADD_R, &&op_SUB_R, &&op_MUL_R, &&op_DIV_R, &&op_MOD_R,
+        &&op_AND_I, &&op_OR_I, &&op_XOR_I, &&op_SHL_I, &&op_SHR_I,
+        &&op_EQ_I, &&op_NE_I, &&op_LT_I, &&op_LE_I, &&op_GT_I, &&op_GE_I,
+        &&op_EQ_R, &&op_NE_R, &&op_LT_R, &&op_LE_R, &&op_GT_R, &&op_GE_R,
+        &&op_MIN_I, &&op_MAX_I, &&op_MIN_R, &&op_MAX_R,
+        &&op_LIMIT_I, &&op_LIMIT_R, &&op_SELECT
+    };
+    static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == static_cast<size_t>(PlcExprOpcode::OPCODE_COUNT),
+                  "Expression dispatch table out of sync with PlcExprOpcode");
+#define EXPR_CASE(name) op_##name:
+#define EXPR_NEXT() do { if (++ip == end) goto done; goto *dispatch[ip->op]; } while (0)
+    // Code starts with a LOAD (compile() and folding both emit one first)
+    FETCH();
+    acc = b;
+    EXPR_NEXT();
+#else
+#define EXPR_CASE(name) case PlcExprOpcode::name:
+#define EXPR_NEXT() { if (++ip == end) goto done; continue; }
+    for (;;) {
+    switch (static_cast<PlcExprOpcode>(ip->op)) {
+#endif
+
+    // The first LOAD pushes the initial acc, which is never popped
+    EXPR_CASE(LOAD)
+        stack[sp++] = acc;
+        FETCH();
+        acc = b;
+        EXPR_NEXT();
+
+    EXPR_CASE(I_TO_R) acc.f = static_cast<float>(acc.i); EXPR_NEXT();
+    EXPR_CASE(R_TO_I) acc.i = toInt(acc.f); EXPR_NEXT();
+    EXPR_CASE(I_TO_B) acc.i = acc.i != 0; EXPR_NEXT();
+    EXPR_CASE(R_TO_B) acc.i = acc.f != 0.0f; EXPR_NEXT();
+
+    EXPR_CASE(NEG_I) acc.i = wrap(0u - static_cast<uint32_t>(acc.i)); EXPR_NEXT();
+    EXPR_CASE(NEG_R) acc.f = -acc.f; EXPR_NEXT();
+    EXPR_CASE(NOT_B) acc.i = !acc.i; EXPR_NEXT();
+    EXPR_CASE(BNOT_I) acc.i = ~acc.i; EXPR_NEXT();
+    EXPR_CASE(ABS_I) acc.i = acc.i < 0 ? wrap(0u - static_cast<uint32_t>(acc.i)) : acc.i; EXPR_NEXT();
+    EXPR_CASE(ABS_R) acc.f = fabsf(acc.f); EXPR_NEXT();
+    EXPR_CASE(SQRT_R) acc.f = acc.f >= 0.0f ? sqrtf(acc.f) : 0.0f; EXPR_NEXT();
+    EXPR_CASE(STORE_T) temps[ip->slot] = acc; EXPR_NEXT();
+
+    EXPR_CASE(ADD_I) BINARY_I(wrap(static_cast<uint32_t>(a) + static_cast<uint32_t>(b.i)))
+    EXPR_CASE(SUB_I) BINARY_I(wrap(static_cast<uint32_t>(a) - static_cast<uint32_t>(b.i)))
+    EXPR_CASE(MUL_I) BINARY_I(wrap(static_cast<uint32_t>(a) * static_cast<uint32_t>(b.i)))
+    EXPR_CASE(DIV_I) BINARY_I(b.i == 0 ? 0 : b.i == -1 ? wrap(0u - static_cast<uint32_t>(a)) : a / b.i)
+    EXPR_CASE(MOD_I) BINARY_I(b.i == 0 || b.i == -1 ? 0 : a % b.i)
+    EXPR_CASE(ADD_R) BINARY_R(a + b.f)
+    EXPR_CASE(SUB_R) BINARY_R(a - b.f)
+    EXPR_CASE(MUL_R) BINARY_R(a * b.f)
+    EXPR_CASE(DIV_R) BINARY_R(b.f == 0.0f ? 0.0f : a / b.f)
+    EXPR_CASE(MOD_R) BINARY_R(b.f == 0.0f ? 0.0f : fmodf(a, b.f))
+    EXPR_CASE(AND_I) BINARY_I(a & b.i)
+    EXPR_CASE(OR_I) BINARY_I(a | b.i)
+    EXPR_CASE(XOR_I) BINARY_I(a ^ b.i)
+    EXPR_CASE(SHL_I) BINARY_I(wrap(static_cast<uint32_t>(a) << (b.i & 31)))
+    EXPR_CASE(SHR_I) BINARY_I(a >> (b.i & 31))
+    EXPR_CASE(EQ_I) BINARY_I(a == b.i)
+    EXPR_CASE(NE_I) BINARY_I(a != b.i)
+    EXPR_CASE(LT_I) BINARY_I(a < b.i)
+    EXPR_CASE(LE_I) BINARY_I(a <= b.i)
+    EXPR_CASE(GT_I) BINARY_I(a > b.i)
+    EXPR_CASE(GE_I) BINARY_I(a >= b.i)
+    EXPR_CASE(EQ_R) COMPARE_R(a == b.f)
+    EXPR_CASE(NE_R) COMPARE_R(a != b.f)
+    EXPR_CASE(LT_R) COMPARE_R(a < b.f)
+    EXPR_CASE(LE_R) COMPARE_R(a <= b.f)
+    EXPR_CASE(GT_R) COMPARE_R(a > b.f)
+    EXPR_CASE(GE_R) COMPARE_R(a >= b.f)
+    EXPR_CASE(MIN_I) BINARY_I(a < b.i ? a : b.i)
+    EXPR_CASE(MAX_I) BINARY_I(a > b.i ? a : b.i)
+    EXPR_CASE(MIN_R) BINARY_R(a < b.f ? a : b.f)
+    EXPR_CASE(MAX_R) BINARY_R(a > b.f ? a : b.f)
+
+    // acc = c, the stack holds a and b
+    EXPR_CASE(LIMIT_I) {
+        sp -= 2;
+        int32_t low = stack[sp].i, in = stack[sp + 1].i;
+        acc.i = in < low ? low : in > acc.i ? acc.i : in;
+        EXPR_NEXT();
+    }
+
+    EXPR_CASE(LIMIT_R) {
+        sp -= 2;
+        float low = stack[sp].f, in = stack[sp + 1].f;
+        acc.f = in < low ? low : in > acc.f ? acc.f : in;
+        EXPR_NEXT();
+    }
+
+    EXPR_CASE(SELECT)
+        sp -= 2;
+        acc = stack[sp].i ? stack[sp + 1] : acc;
+        EXPR_NEXT();
+
+#if !PLC_VM_COMPUTED_GOTO
+    default:
+        goto done;
+    }
+    }
+#endif
+
+done:
+#undef BIT
+#undef FETCH
+#undef BINARY_I
+#undef BINARY_R
+#undef COMPARE_R
+#undef EXPR_CASE
+#undef EXPR_NEXT
+    return acc;
+}
@@ -0,0 +1,232 @@
+#ifndef PLC_EXPRESSION_H
+#define PLC_EXPRESSION_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "../PlcEngine/Engine/PlcArena.h"
+#include "../PlcEngine/Engine/PlcMemory.h"
+
+/**
+ * Opcodes of the expression stack machine.
+ *
+ * The suffix names the working type: _I int32, _R float, _B bool (kept as
+ * 0/1 in the int32 member, so bools use the _I opcodes for comparisons
+ * and bit operators and widen to int without an instruction).
+ *
+ * The top of the stack is kept in a register. LOAD pushes the operand of
+ * the instruction; binary opcodes take their right operand from it, so a
+ * constant or variable on the right does not go through the stack. Keep
+ * in sync with the dispatch table in PlcExpression::run().
+ */
+enum class PlcExprOpcode : uint8_t {
+    LOAD,
+
+    // Conversions of the top of the stack
+    I_TO_R,
+    R_TO_I,         // Truncates toward zero, saturating
+    I_TO_B,
+    R_TO_B,
+
+    NEG_I,
+    NEG_R,
+    NOT_B,
+    BNOT_I,
+    ABS_I,
+    ABS_R,
+    SQRT_R,         // 0 for negative operands, like SQRT
+    STORE_T,        // Copy the top of the stack to temporary slot (shared subexpression)
+
+    // Binary (top of the stack op operand)
+    ADD_I,
+    SUB_I,
+    MUL_I,
+    DIV_I,          // Division by zero yields 0, like DIV
+    MOD_I,
+    ADD_R,
+    SUB_R,
+    MUL_R,
+    DIV_R,
+    MOD_R,
+    AND_I,          // Bitwise, also && on 0/1 bools
+    OR_I,
+    XOR_I,
+    SHL_I,          // Shift counts are taken modulo 32
+    SHR_I,          // Arithmetic shift
+    EQ_I,
+    NE_I,
+    LT_I,
+    LE_I,
+    GT_I,
+    GE_I,
+    EQ_R,
+    NE_R,
+    LT_R,
+    LE_R,
+    GT_R,
+    GE_R,
+    MIN_I,
+    MAX_I,
+    MIN_R,
+    MAX_R,
+
+    // Ternary, on the top three values of the stack (a, b, c)
+    LIMIT_I,        // LIMIT(mn = a, in = b, mx = c)
+    LIMIT_R,
+    SELECT,         // a ? b : c
+
+    OPCODE_COUNT
+};
+
+// Where the operand of an instruction comes from. A variable operand is
+// read from the segment of its slot type; the _R kinds read an integer
+// or bool slot as a float operand.
+enum class PlcExprOperand : uint8_t {
+    STACK,          // Popped
+    CONST,          // k
+    BOOL,           // Slot, as 0/1
+    BYTE,
+    INT,
+    DINT,
+    REAL,
+    BOOL_R,
+    BYTE_R,
+    INT_R,
+    DINT_R,
+    TEMP            // Temporary slot, stored by an earlier STORE_T
+};
+
+union PlcExprValue {
+    int32_t i;
+    float f;
+};
+
+struct PlcExprInstruction {
+    uint8_t op;         // PlcExprOpcode
+    uint8_t operand;    // PlcExprOperand
+    uint16_t slot;
+    PlcExprValue k;
+};
+
+class PlcExpression;
+
+/**
+ * PlcExprScope - subexpressions shared between the expressions compiled
+ * with it, in the order they run (the statements of an ST program).
+ *
+ * A subexpression that is computed again while none of the variables it
+ * reads has been written is loaded from a temporary slot instead. The
+ * compiler of the statements keeps the scope in step with the control
+ * flow: invalidate() after an assignment, clear() where paths join or a
+ * function block runs. finish() drops the stores nobody loads and numbers
+ * the temporaries the expressions evaluate with.
+ */
+class PlcExprScope {
+private:
+    struct Entry {
+        std::string key;                // Canonical form of the subtree
+        uint16_t temp;
+        std::vector<uint16_t> slots;    // Variables it reads
+    };
+
+public:
+    static constexpr size_t MAX_ENTRIES = 64;
+
+    // The available subexpressions at a point of the code
+    typedef std::vector<Entry> State;
+
+    PlcExprScope() : nextTemp(0), sharedCount(0) {}
+
+    void invalidate(uint16_t slot);     // The variable in slot was written
+    void clear() { entries.clear(); }
+    State save() const { return entries; }
+    void restore(const State& state) { entries = state; }
+
+    // Remove the stores of temporaries no expression loads and number the
+    // others from 0. Returns the number of temporaries the expressions need.
+    size_t finish(PlcExpression* const* expressions, size_t count);
+
+    // Loads that reuse a subexpression instead of computing it again
+    size_t getSharedCount() const { return sharedCount; }
+
+private:
+    friend class PlcExpression;
+
+    State entries;
+    uint16_t nextTemp;
+    size_t sharedCount;
+};
+
+/**
+ * PlcExpression - infix formula compiled to a small stack machine.
+ *
+ * compile() parses C-style expressions with the IEC spellings as
+ * alternatives (AND OR NOT XOR MOD, = and <> for comparison):
+ *
+ *   ?:  ||  &&  |  ^  &  == !=  < <= > >=  << >>  + -  * / %  unary - ! ~
+ *
+ * plus the functions min(a, b, ...), max(a, b, ...), abs(x), sqrt(x) and
+ * limit(mn, x, mx). Operands are number literals, true/false and
+ * variable names, which are bound to PlcMemory slots through the binder.
+ *
+ * Types are checked at compile time: BYTE, INT and DINT variables are
+ * int32 operands, REAL ones float, and mixed operands are widened to
+ * float. Logic operators and conditions take bools; a number used there
+ * is true when non-zero. Subexpressions made of literals only are folded
+ * into a constant, so evaluate() only loads the variables and runs the
+ * operators, without allocating.
+ */
+class PlcExpression {
+public:
+    enum class Type : uint8_t { BOOL, INT, REAL };
+
+    // Resolves a variable name to a slot. `type` is the type to declare an
+    // undeclared variable with: BOOL when it is used as a condition, DINT
+    // as an operand of a bit operator, REAL otherwise. An invalid handle
+    // fails the compilation.
+    typedef VarHandle (*Binder)(void* context, const char* name, PlcValueType type);
+
+    static constexpr size_t MAX_STACK = 16;
+    static constexpr size_t MAX_NAME = 48;
+
+    PlcExpression() : resultType(Type::REAL), error(nullptr), errorPosition(0) {}
+
+    // Compile source. On failure getError() describes the problem found at
+    // getErrorPosition() (offset in source) and the expression is empty.
+    // The instructions are allocated from arena, if given. With a scope,
+    // subexpressions are shared with the expressions compiled before it
+    // and evaluate() needs the temporaries. hint is the type undeclared
+    // variables at the top level are declared with, as BOOL for a condition.
+    bool compile(const char* source, Binder binder, void* context, PlcArena* arena = nullptr,
+                 PlcExprScope* scope = nullptr, Type hint = Type::REAL);
+
+    PlcExprValue evaluate(const PlcMemory& memory, PlcExprValue* temps = nullptr) const {
+        return run(code.data(), code.size(), &memory, temps);
+    }
+
+    Type getType() const { return resultType; }
+    bool isEmpty() const { return code.empty(); }
+    // Folded to a single constant: evaluate() does not read the memory
+    bool isConstant() const { return code.size() == 1 && code[0].operand == static_cast<uint8_t>(PlcExprOperand::CONST); }
+    // The variable a plain variable reference loads, invalid for anything else
+    VarHandle getVariable() const;
+    size_t getInstructionCount() const { return code.size(); }
+    const char* getError() const { return error; }
+    size_t getErrorPosition() const { return errorPosition; }
+
+    // Declared type for a variable holding the result
+    static PlcValueType slotType(Type type);
+
+private:
+    class Compiler;
+    friend class PlcExprScope;
+
+    PlcArenaVector<PlcExprInstruction> code;
+    Type resultType;
+    const char* error;
+    size_t errorPosition;
+
+    static PlcExprValue run(const PlcExprInstruction* code, size_t count, const PlcMemory* memory, PlcExprValue* temps);
+};
+
+#endif // PLC_EXPRESSION_H
@@ -2,19 +2,431 @@
 #include "Preferences.h"
 #include <StreamLogger.h> // Include for EspHubLog
 #include <DeviceRegistry.h> // Include for IO point integration
+#include <algorithm>
+#include <cstring>
 #include <type_traits>
 
-void PlcMemory::clear() {}
+extern StreamLogger* EspHubLog;
 
-// Template specialization for String type to avoid invalid casts
-template<>
-bool PlcMemory::setValue<String>(const std::string& name, String val) {
+PlcMemory::PlcMemory()
+    : boolCount(0), stringPoolCapacity(0), deviceRegistry(nullptr), trackChanges(false), strictTypes(false), imageSlotCount(0), inputPosting(0), imageSequence(0),
+      postListener(nullptr), postContext(nullptr) {
+}
+
+void PlcMemory::begin() {
+    loadRetentiveMemory();
+}
+
+void PlcMemory::clear() {
+    slots.clear();
+    boolBits.clear();
+    boolCount = 0;
+    bitOwners.clear();
+    byteValues.clear();
+    intValues.clear();
+    dintValues.clear();
+    realValues.clear();
+    stringPool.clear();
+    meshLinks.clear();
+    namePool.clear();
+    nameOffsets.clear();
+    nameOrder.clear();
+    arrays.clear();
+    changedFlags.clear();
+    changedSlots.clear();
+    retentive.attach(*this); // No retentive slots left
+
+    imageSlotCount = 0;
+    imageStringIndex.clear();
+    for (InputBuffer& buffer : inputImage) {
+        buffer.words.clear();
+        buffer.strings.clear();
+        buffer.pending.clear();
+        buffer.pendingSlots.clear();
+    }
+    for (ImageBuffer& buffer : outputImage) {
+        buffer.words.clear();
+        buffer.strings.clear();
+    }
+}
+
+void PlcMemory::matchSlots(const PlcMemory& previous, std::vector<std::pair<uint16_t, uint16_t>>& pairs) const {
+    pairs.clear();
+    for (uint16_t slot : nameOrder) {
+        int match = previous.findSlot(nameAt(slot));
+        if (match >= 0 && previous.slots[match].type == slots[slot].type) {
+            pairs.emplace_back(slot, static_cast<uint16_t>(match));
+        }
+    }
+}
+
+void PlcMemory::copySlots(const PlcMemory& previous, const std::vector<std::pair<uint16_t, uint16_t>>& pairs) {
+    PlcValueUnion value;
+    for (const auto& pair : pairs) {
+        previous.loadSlot(previous.slots[pair.second], value);
+        storeSlot(slots[pair.first], value);
+    }
+    deviceRegistry = previous.deviceRegistry;
+}
+
+void PlcMemory::setChangeTracking(bool enabled) {
+    trackChanges = enabled;
+    clearChangedSlots();
+}
+
+void PlcMemory::clearChangedSlots() {
+    for (uint16_t index : changedSlots) {
+        changedFlags[index] = 0;
+    }
+    changedSlots.clear();
+}
+
+bool PlcMemory::declareVariable(const std::string& name, PlcValueType type, bool isRetentive, const String& mesh_link) {
+    if (name.empty()) {
+        return false;
+    }
+    if (hasProcessImage()) {
+        // Blocks, bytecode and the image are bound to the slots and segments
+        // as they are, and other tasks read them: a later declaration can
+        // only confirm a variable of the program
+        int slot = findSlot(name);
+        if (slot < 0) {
+            EspHubLog->printf("ERROR: '%s' is not declared by the loaded program, variables cannot be added to it\n", name.c_str());
+            return false;
+        }
+        if (slots[slot].type != type) {
+            EspHubLog->printf("ERROR: '%s' is in use by the loaded program, cannot change its type\n", name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    if (!arrays.empty() && findArray(name.c_str()).isValid()) {
+        EspHubLog->printf("ERROR: '%s' is an array, declare or use its elements ('%s[0]')\n", name.c_str(), name.c_str());
+        return false;
+    }
+    int existing = findSlot(name);
+    if (existing >= 0) {
+        // Re-declaration only updates the attributes, the value is preserved.
+        // A new type moves the variable to a zeroed value in its segment.
+        PlcVariable& var = slots[existing];
+        if (var.type != type) {
+            for (const ArrayEntry& entry : arrays) {
+                if (existing >= entry.ref.firstSlot && existing < entry.ref.firstSlot + entry.ref.length) {
+                    // Its value must stay next to the other elements
+                    EspHubLog->printf("ERROR: Array element '%s' cannot change its type\n", name.c_str());
+                    return false;
+                }
+            }
+            uint16_t offset;
+            if (!allocate(type, offset)) {
+                EspHubLog->printf("ERROR: PLC memory full, cannot declare '%s'\n", name.c_str());
+                return false;
+            }
+            if (var.type == PlcValueType::BOOL) {
+                bitOwners[var.offset] = VarHandle::INVALID_INDEX;
+            }
+            if (type == PlcValueType::BOOL) {
+                bitOwners[offset] = static_cast<uint16_t>(existing);
+            }
+            var.offset = offset;
+            var.type = type;
+        }
+        var.flags = isRetentive ? PlcVariable::FLAG_RETENTIVE : 0;
+        setMeshLink(static_cast<uint16_t>(existing), mesh_link);
+        return true;
+    }
+
+    PlcVariable var;
+    if (slots.size() >= VarHandle::INVALID_INDEX || !allocate(type, var.offset)) {
+        EspHubLog->printf("ERROR: PLC memory full, cannot declare '%s'\n", name.c_str());
+        return false;
+    }
+    var.type = type;
+    var.flags = isRetentive ? PlcVariable::FLAG_RETENTIVE : 0;
+
+    uint16_t index = static_cast<uint16_t>(slots.size());
+    if (type == PlcValueType::BOOL) {
+        bitOwners[var.offset] = index;
+    }
+    auto position = std::lower_bound(nameOrder.begin(), nameOrder.end(), name.c_str(),
+                                     [this](uint16_t slot, const char* key) { return strcmp(nameAt(slot), key) < 0; });
+    nameOrder.insert(position, index);
+    nameOffsets.push_back(static_cast<uint32_t>(namePool.size()));
+    namePool.insert(namePool.end(), name.c_str(), name.c_str() + name.size() + 1);
+    slots.push_back(var);
+    changedFlags.push_back(0);
+    setMeshLink(index, mesh_link);
+    return true;
+}
+
+bool PlcMemory::declareArray(const std::string& name, PlcValueType type, uint16_t length, bool isRetentive) {
+    if (length == 0 || length > PLC_MAX_ARRAY_LENGTH || type == PlcValueType::STRING_TYPE) {
+        EspHubLog->printf("ERROR: Cannot declare '%s' as an array of %u elements\n", name.c_str(), (unsigned)length);
+        return false;
+    }
+    if (hasProcessImage()) {
+        EspHubLog->printf("ERROR: '%s' is not declared by the loaded program, variables cannot be added to it\n", name.c_str());
+        return false;
+    }
+    if (findArray(name.c_str()).isValid() || findSlot(name) >= 0) {
+        EspHubLog->printf("ERROR: Array '%s' is already declared\n", name.c_str());
+        return false;
+    }
+    // Elements declared one after the other get consecutive slots and
+    // segment offsets, as allocate() appends to the segment
+    std::string element;
+    for (uint16_t i = 0; i < length; i++) {
+        element = name + "[" + std::to_string(i) + "]";
+        if (findSlot(element) >= 0) {
+            EspHubLog->printf("ERROR: Array element '%s' is already declared\n", element.c_str());
+            return false;
+        }
+    }
+    uint16_t first = static_cast<uint16_t>(slots.size());
+    if (type == PlcValueType::BOOL) {
+        alignBits(); // Whole words, see getArrayWord()
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        element = name + "[" + std::to_string(i) + "]";
+        if (!declareVariable(element, type, isRetentive)) {
+            return false;
+        }
+    }
+    if (type == PlcValueType::BOOL) {
+        alignBits();
+    }
+
+    ArrayEntry entry;
+    entry.name = static_cast<uint32_t>(namePool.size());
+    entry.ref = PlcArrayRef(first, length, type);
+    namePool.insert(namePool.end(), name.c_str(), name.c_str() + name.size() + 1);
+    arrays.push_back(entry);
+    return true;
+}
+
+void PlcMemory::alignBits() {
+    // The words up to boolCount exist; the next allocate() adds one
+    uint32_t aligned = (static_cast<uint32_t>(boolCount) + 31) & ~31u;
+    if (aligned < VarHandle::INVALID_INDEX) {
+        boolCount = static_cast<uint16_t>(aligned);
+        bitOwners.resize(boolCount, VarHandle::INVALID_INDEX);
+    }
+}
+
+void PlcMemory::noteBits(uint16_t word, uint32_t changed) {
+    while (changed != 0) {
+        size_t bit = (static_cast<size_t>(word) << 5) + __builtin_ctz(changed);
+        changed &= changed - 1;
+        uint16_t index = bit < bitOwners.size() ? bitOwners[bit] : VarHandle::INVALID_INDEX;
+        if (index != VarHandle::INVALID_INDEX && !changedFlags[index]) {
+            changedFlags[index] = 1;
+            changedSlots.push_back(index);
+        }
+    }
+}
+
+PlcArrayRef PlcMemory::findArray(const char* name) const {
+    if (name == nullptr) {
+        return PlcArrayRef();
+    }
+    for (const ArrayEntry& entry : arrays) {
+        if (strcmp(namePool.data() + entry.name, name) == 0) {
+            return entry.ref;
+        }
+    }
+    return PlcArrayRef();
+}
+
+bool PlcMemory::allocate(PlcValueType type, uint16_t& offset) {
+    size_t next = 0;
+    switch (type) {
+        case PlcValueType::BOOL:
+            next = boolCount;
+            if (next < VarHandle::INVALID_INDEX) {
+                if ((boolCount & 31) == 0) {
+                    boolBits.push_back(0);
+                }
+                boolCount++;
+                bitOwners.resize(boolCount, VarHandle::INVALID_INDEX);
+            }
+            break;
+        case PlcValueType::BYTE:
+            next = byteValues.size();
+            byteValues.push_back(0);
+            break;
+        case PlcValueType::INT:
+            next = intValues.size();
+            intValues.push_back(0);
+            break;
+        case PlcValueType::DINT:
+            next = dintValues.size();
+            dintValues.push_back(0);
+            break;
+        case PlcValueType::REAL:
+            next = realValues.size();
+            realValues.push_back(0.0f);
+            break;
+        case PlcValueType::STRING_TYPE:
+            if (stringPoolCapacity > 0 && stringPool.size() + PLC_STRING_SIZE > stringPoolCapacity) {
+                EspHubLog->printf("ERROR: PLC string pool full (%u bytes)\n", (unsigned)stringPoolCapacity);
+                return false;
+            }
+            next = stringPool.size() / PLC_STRING_SIZE;
+            stringPool.resize(stringPool.size() + PLC_STRING_SIZE, '\0');
+            break;
+    }
+    if (next >= VarHandle::INVALID_INDEX) {
+        return false;
+    }
+    offset = static_cast<uint16_t>(next);
+    return true;
+}
+
+bool PlcMemory::sharesMeshLink(const PlcMemory& other) const {
+    for (const MeshLink& entry : meshLinks) {
+        for (const MeshLink& otherEntry : other.meshLinks) {
+            if (entry.link == otherEntry.link) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void PlcMemory::setMeshLink(uint16_t slot, const String& link) {
+    for (auto it = meshLinks.begin(); it != meshLinks.end(); ++it) {
+        if (it->slot == slot) {
+            if (link.length() > 0) {
+                it->link = link;
+            } else {
+                meshLinks.erase(it);
+            }
+            return;
+        }
+    }
+    if (link.length() > 0) {
+        meshLinks.push_back({slot, link});
+    }
+}
+
+const String* PlcMemory::getMeshLink(VarHandle handle) const {
+    for (const MeshLink& entry : meshLinks) {
+        if (entry.slot == handle.index) {
+            return &entry.link;
+        }
+    }
+    return nullptr;
+}
+
+void PlcMemory::shrinkToFit() {
+    slots.shrink_to_fit();
+    boolBits.shrink_to_fit();
+    bitOwners.shrink_to_fit();
+    byteValues.shrink_to_fit();
+    intValues.shrink_to_fit();
+    dintValues.shrink_to_fit();
+    realValues.shrink_to_fit();
+    stringPool.shrink_to_fit();
+    meshLinks.shrink_to_fit();
+    namePool.shrink_to_fit();
+    nameOffsets.shrink_to_fit();
+    nameOrder.shrink_to_fit();
+    arrays.shrink_to_fit();
+    changedFlags.shrink_to_fit();
+}
+
+void PlcMemory::loadSlot(const PlcVariable& var, PlcValueUnion& value) const {
+    if (var.type == PlcValueType::STRING_TYPE) {
+        memcpy(value.sVal, stringAt(var.offset), PLC_STRING_SIZE);
+    } else {
+        value.ui32Val = readRaw(var);
+    }
+}
+
+void PlcMemory::storeSlot(const PlcVariable& var, const PlcValueUnion& value) {
+    if (var.type == PlcValueType::STRING_TYPE) {
+        memcpy(stringAt(var.offset), value.sVal, PLC_STRING_SIZE);
+        stringAt(var.offset)[PLC_STRING_SIZE - 1] = '\0';
+    } else {
+        writeRaw(var, value.ui32Val);
+    }
+}
+
+int PlcMemory::findSlot(const char* name) const {
+    size_t low = 0;
+    size_t high = nameOrder.size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        int order = strcmp(nameAt(nameOrder[middle]), name);
+        if (order == 0) {
+            return nameOrder[middle];
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return -1;
+}
+
+VarHandle PlcMemory::resolve(const char* name, PlcValueType declareAs) {
+    if (name == nullptr || name[0] == '\0') {
+        return VarHandle();
+    }
+
+    int slot = findSlot(name);
+    if (slot < 0) {
+        if (!declareVariable(name, declareAs)) {
+            return VarHandle();
+        }
+        slot = static_cast<int>(slots.size()) - 1;
+    }
+    return VarHandle(static_cast<uint16_t>(slot), slots[slot].type);
+}
+
+VarHandle PlcMemory::findHandle(const std::string& name) const {
+    int slot = findSlot(name);
+    if (slot < 0) {
+        return VarHandle();
+    }
+    return VarHandle(static_cast<uint16_t>(slot), slots[slot].type);
+}
+
+const char* PlcMemory::getVariableName(VarHandle handle) const {
+    if (!handle.isValid() || handle.index >= slots.size()) {
+        return nullptr;
+    }
+    return nameAt(handle.index);
+}
+
+template<typename T>
+bool PlcMemory::setValue(const std::string& name, T val) {
+    int slot = findSlot(name);
+    if (slot < 0) {
+        // Writing an unknown variable declares it with a matching type
+        if (!declareVariable(name, typeFor<T>())) {
+            return false;
+        }
+        slot = findSlot(name);
+    }
+    const PlcVariable& var = slots[slot];
+    uint32_t before = readRaw(var);
+    writeSlot<T>(var, val);
+    if (trackChanges) {
+        noteWrite(static_cast<uint16_t>(slot), var, before);
+    }
     return true;
 }
 
-template<>
-String PlcMemory::getValue<String>(const std::string& name, String defaultValue) {
-    return defaultValue;
+template<typename T>
+T PlcMemory::getValue(const std::string& name, T defaultValue) {
+    int slot = findSlot(name);
+    if (slot < 0) {
+        return defaultValue;
+    }
+    return readSlot<T>(slots[slot]);
 }
 
 // Explicit template instantiations
@@ -27,7 +439,8 @@ template bool PlcMemory::setValue<int32_t>(const std::string& name, int32_t val)
 template bool PlcMemory::setValue<uint32_t>(const std::string& name, uint32_t val);
 template bool PlcMemory::setValue<float>(const std::string& name, float val);
 template bool PlcMemory::setValue<double>(const std::string& name, double val);
-// std::string handled by template specialization above
+template bool PlcMemory::setValue<String>(const std::string& name, String val);
+template bool PlcMemory::setValue<std::string>(const std::string& name, std::string val);
 
 template bool PlcMemory::getValue<bool>(const std::string& name, bool defaultValue);
 template int8_t PlcMemory::getValue<int8_t>(const std::string& name, int8_t defaultValue);
@@ -38,7 +451,318 @@ template int32_t PlcMemory::getValue<int32_t>(const std::string& name, int32_t d
 template uint32_t PlcMemory::getValue<uint32_t>(const std::string& name, uint32_t defaultValue);
 template float PlcMemory::getValue<float>(const std::string& name, float defaultValue);
 template double PlcMemory::getValue<double>(const std::string& name, double defaultValue);
-// std::string handled by template specialization above
+template String PlcMemory::getValue<String>(const std::string& name, String defaultValue);
+template std::string PlcMemory::getValue<std::string>(const std::string& name, std::string defaultValue);
+
+// ========== Strings ==========
+
+size_t PlcMemory::printValue(VarHandle handle, char* buffer, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+    if (!handle.isValid()) {
+        buffer[0] = '\0';
+        return 0;
+    }
+    const PlcVariable& var = slots[handle.index];
+    int length;
+    switch (var.type) {
+        case PlcValueType::STRING_TYPE:
+            length = snprintf(buffer, size, "%s", stringAt(var.offset));
+            break;
+        case PlcValueType::REAL:
+            length = snprintf(buffer, size, "%.2f", static_cast<double>(realValues[var.offset])); // As String(float)
+            break;
+        default:
+            length = snprintf(buffer, size, "%ld", static_cast<long>(readSlot<int32_t>(var)));
+            break;
+    }
+    if (length < 0) {
+        buffer[0] = '\0';
+        return 0;
+    }
+    return static_cast<size_t>(length) < size ? static_cast<size_t>(length) : size - 1;
+}
+
+const char* PlcMemory::getText(VarHandle handle, char* buffer, size_t size) const {
+    const char* text = getString(handle);
+    if (text) {
+        return text;
+    }
+    printValue(handle, buffer, size);
+    return buffer;
+}
+
+bool PlcMemory::setString(VarHandle handle, const char* text, size_t length) {
+    if (!handle.isValid()) {
+        return false;
+    }
+    const PlcVariable& var = slots[handle.index];
+    uint32_t before = readRaw(var);
+    if (var.type == PlcValueType::STRING_TYPE) {
+        char* target = stringAt(var.offset);
+        if (length > PLC_STRING_SIZE - 1) {
+            length = PLC_STRING_SIZE - 1;
+        }
+        memmove(target, text, length);
+        target[length] = '\0';
+    } else {
+        char number[32];
+        if (length > sizeof(number) - 1) {
+            length = sizeof(number) - 1;
+        }
+        memcpy(number, text, length);
+        number[length] = '\0';
+        writeSlot<float>(var, static_cast<float>(atof(number)));
+    }
+    if (trackChanges) {
+        noteWrite(handle.index, var, before);
+    }
+    return true;
+}
+
+// ========== Process Image ==========
+
+void PlcMemory::buildProcessImage() {
+    shrinkToFit(); // Declarations are done, segments keep their final size
+    imageSlotCount = static_cast<uint16_t>(slots.size());
+
+    uint16_t stringCount = 0;
+    imageStringIndex.assign(imageSlotCount, VarHandle::INVALID_INDEX);
+    for (uint16_t i = 0; i < imageSlotCount; i++) {
+        if (slots[i].type == PlcValueType::STRING_TYPE) {
+            imageStringIndex[i] = stringCount++;
+        }
+    }
+
+    // Everything is allocated here, posting and publishing never allocate
+    for (InputBuffer& buffer : inputImage) {
+        buffer.words.assign(imageSlotCount, 0);
+        buffer.strings.assign(stringCount, PlcValueUnion());
+        buffer.pending.assign(imageSlotCount, 0);
+        buffer.pendingSlots.clear();
+        buffer.pendingSlots.reserve(imageSlotCount);
+    }
+    inputPosting = 0;
+    for (ImageBuffer& buffer : outputImage) {
+        buffer.words.assign(imageSlotCount, 0);
+        buffer.strings.assign(stringCount, PlcValueUnion());
+    }
+
+    publishOutputImage();
+}
+
+void PlcMemory::storeImageValue(ImageBuffer& buffer, uint16_t index, const PlcValueUnion& value) const {
+    uint16_t stringIndex = imageStringIndex[index];
+    if (stringIndex != VarHandle::INVALID_INDEX) {
+        buffer.strings[stringIndex] = value;
+    } else {
+        buffer.words[index] = value.ui32Val;
+    }
+}
+
+void PlcMemory::loadImageValue(const ImageBuffer& buffer, uint16_t index, PlcValueUnion& value) const {
+    uint16_t stringIndex = imageStringIndex[index];
+    if (stringIndex != VarHandle::INVALID_INDEX) {
+        value = buffer.strings[stringIndex];
+    } else {
+        value.ui32Val = buffer.words[index];
+    }
+}
+
+void PlcMemory::publishImageSlot(ImageBuffer& buffer, uint16_t index) const {
+    const PlcVariable& var = slots[index];
+    uint16_t stringIndex = imageStringIndex[index];
+    if (stringIndex != VarHandle::INVALID_INDEX) {
+        memcpy(buffer.strings[stringIndex].sVal, stringAt(var.offset), PLC_STRING_SIZE);
+    } else {
+        buffer.words[index] = readRaw(var);
+    }
+}
+
+void PlcMemory::applyImageSlot(const ImageBuffer& buffer, uint16_t index) {
+    const PlcVariable& var = slots[index];
+    uint16_t stringIndex = imageStringIndex[index];
+    if (stringIndex != VarHandle::INVALID_INDEX) {
+        memcpy(stringAt(var.offset), buffer.strings[stringIndex].sVal, PLC_STRING_SIZE);
+    } else {
+        writeRaw(var, buffer.words[index]);
+    }
+}
+
+void PlcMemory::applyInputImage() {
+    if (imageSlotCount == 0) {
+        return;
+    }
+
+    // Swap buffers; writes posted from now on are applied next cycle
+    InputBuffer* buffer;
+    {
+        PlcSpinLockGuard guard(inputLock);
+        buffer = &inputImage[inputPosting];
+        inputPosting ^= 1;
+    }
+
+    for (uint16_t index : buffer->pendingSlots) {
+        const PlcVariable& var = slots[index];
+        uint32_t before = readRaw(var);
+        applyImageSlot(*buffer, index);
+        if (trackChanges) {
+            noteWrite(index, var, before);
+        }
+        buffer->pending[index] = 0;
+    }
+    buffer->pendingSlots.clear();
+}
+
+bool PlcMemory::publishOutputImage() {
+    if (imageSlotCount == 0) {
+        return false;
+    }
+
+    // Write the buffer readers are not using. The odd sequence tells a
+    // reader that started on the other buffer before the previous publish
+    // that its buffer may be rewritten next.
+    uint32_t sequence = imageSequence.load(std::memory_order_relaxed);
+    ImageBuffer& buffer = outputImage[((sequence >> 1) + 1) & 1];
+    imageSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint16_t i = 0; i < imageSlotCount; i++) {
+        publishImageSlot(buffer, i);
+    }
+
+    imageSequence.store(sequence + 2, std::memory_order_release);
+
+    // The other buffer holds the previous image; only this task writes either
+    const ImageBuffer& previous = outputImage[(sequence >> 1) & 1];
+    if (buffer.words != previous.words) {
+        return true;
+    }
+    for (size_t i = 0; i < buffer.strings.size(); i++) {
+        if (memcmp(buffer.strings[i].sVal, previous.strings[i].sVal, PLC_STRING_SIZE) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PlcMemory::readOutputImage(int slot, PlcValueUnion& value) const {
+    if (slot < 0 || slot >= imageSlotCount) {
+        return false;
+    }
+    for (;;) {
+        uint32_t begin = imageSequence.load(std::memory_order_acquire);
+        loadImageValue(outputImage[(begin >> 1) & 1], static_cast<uint16_t>(slot), value);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t end = imageSequence.load(std::memory_order_relaxed);
+
+        // The buffer that was read is rewritten by the publish after the
+        // next one, which starts at sequence (begin & ~1) + 3
+        if (end - (begin & ~1u) <= 2) {
+            return true;
+        }
+    }
+}
+
+bool PlcMemory::getImageValues(const std::vector<VarHandle>& handles, std::vector<PlcValue>& values) const {
+    for (const VarHandle& handle : handles) {
+        if (!handle.isValid() || handle.index >= imageSlotCount) {
+            return false;
+        }
+    }
+    values.resize(handles.size());
+    for (size_t i = 0; i < handles.size(); i++) {
+        values[i].type = slots[handles[i].index].type;
+    }
+
+    for (;;) {
+        uint32_t begin = imageSequence.load(std::memory_order_acquire);
+        const ImageBuffer& buffer = outputImage[(begin >> 1) & 1];
+        for (size_t i = 0; i < handles.size(); i++) {
+            loadImageValue(buffer, handles[i].index, values[i].value);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t end = imageSequence.load(std::memory_order_relaxed);
+        if (end - (begin & ~1u) <= 2) {
+            return true;
+        }
+    }
+}
+
+template<typename T>
+bool PlcMemory::postValue(const std::string& name, T val) {
+    int slot = findSlot(name);
+    if (slot < 0 || slot >= imageSlotCount) {
+        return false;
+    }
+
+    // Convert outside the lock
+    PlcValueUnion value;
+    writeValue<T>(value, slots[slot].type, val);
+
+    {
+        PlcSpinLockGuard guard(inputLock);
+        InputBuffer& buffer = inputImage[inputPosting];
+        storeImageValue(buffer, static_cast<uint16_t>(slot), value);
+        if (!buffer.pending[slot]) {
+            buffer.pending[slot] = 1;
+            buffer.pendingSlots.push_back(static_cast<uint16_t>(slot));
+        }
+    }
+    if (postListener) {
+        postListener(postContext);
+    }
+    return true;
+}
+
+template<typename T>
+T PlcMemory::getImageValue(const std::string& name, T defaultValue) const {
+    int slot = findSlot(name);
+    PlcValueUnion value;
+    if (!readOutputImage(slot, value)) {
+        return defaultValue;
+    }
+    return readValue<T>(value, slots[slot].type);
+}
+
+template bool PlcMemory::postValue<bool>(const std::string& name, bool val);
+template bool PlcMemory::postValue<int8_t>(const std::string& name, int8_t val);
+template bool PlcMemory::postValue<uint8_t>(const std::string& name, uint8_t val);
+template bool PlcMemory::postValue<int16_t>(const std::string& name, int16_t val);
+template bool PlcMemory::postValue<uint16_t>(const std::string& name, uint16_t val);
+template bool PlcMemory::postValue<int32_t>(const std::string& name, int32_t val);
+template bool PlcMemory::postValue<uint32_t>(const std::string& name, uint32_t val);
+template bool PlcMemory::postValue<float>(const std::string& name, float val);
+template bool PlcMemory::postValue<double>(const std::string& name, double val);
+template bool PlcMemory::postValue<String>(const std::string& name, String val);
+template bool PlcMemory::postValue<std::string>(const std::string& name, std::string val);
+
+template bool PlcMemory::getImageValue<bool>(const std::string& name, bool defaultValue) const;
+template int8_t PlcMemory::getImageValue<int8_t>(const std::string& name, int8_t defaultValue) const;
+template uint8_t PlcMemory::getImageValue<uint8_t>(const std::string& name, uint8_t defaultValue) const;
+template int16_t PlcMemory::getImageValue<int16_t>(const std::string& name, int16_t defaultValue) const;
+template uint16_t PlcMemory::getImageValue<uint16_t>(const std::string& name, uint16_t defaultValue) const;
+template int32_t PlcMemory::getImageValue<int32_t>(const std::string& name, int32_t defaultValue) const;
+template uint32_t PlcMemory::getImageValue<uint32_t>(const std::string& name, uint32_t defaultValue) const;
+template float PlcMemory::getImageValue<float>(const std::string& name, float defaultValue) const;
+template double PlcMemory::getImageValue<double>(const std::string& name, double defaultValue) const;
+template String PlcMemory::getImageValue<String>(const std::string& name, String defaultValue) const;
+template std::string PlcMemory::getImageValue<std::string>(const std::string& name, std::string defaultValue) const;
+
+// ========== Retentive Memory ==========
+
+bool PlcMemory::saveRetentiveMemory() {
+    retentive.capture(*this);
+    return retentive.commit();
+}
+
+void PlcMemory::loadRetentiveMemory() {
+    uint16_t restored = retentive.restore(*this);
+    if (restored > 0) {
+        EspHubLog->printf("Restored %u of %u retentive variables\n", restored, (unsigned)retentive.getSlotCount());
+    }
+}
 
 // ========== IO Point Management Implementation ==========
 
@@ -67,11 +791,41 @@ bool PlcMemory::isEndpointOnline(const std::string& endpointName) {
 
 PlcValue PlcMemory::getValueAsPlcValue(const std::string& name) {
     PlcValue result;
+    int slot = findSlot(name);
+    if (slot >= 0) {
+        result.type = slots[slot].type;
+        loadSlot(slots[slot], result.value);
+    }
     return result;
 }
 
 void PlcMemory::syncIOPoints(IODirection* filterDirection) {}
 
 size_t PlcMemory::getMemoryUsage() const {
-    return 0;
-}
\ No newline at end of file
+    size_t total = slots.capacity() * sizeof(PlcVariable);
+    total += boolBits.capacity() * sizeof(uint32_t) + bitOwners.capacity() * sizeof(uint16_t);
+    total += byteValues.capacity() * sizeof(uint8_t);
+    total += intValues.capacity() * sizeof(int16_t);
+    total += dintValues.capacity() * sizeof(int32_t);
+    total += realValues.capacity() * sizeof(float);
+    total += stringPool.capacity();
+    total += meshLinks.capacity() * sizeof(MeshLink);
+    for (const MeshLink& entry : meshLinks) {
+        total += entry.link.length() + 1;
+    }
+    total += changedFlags.capacity() + changedSlots.capacity() * sizeof(uint16_t);
+
+    total += namePool.capacity() + nameOffsets.capacity() * sizeof(uint32_t) + nameOrder.capacity() * sizeof(uint16_t);
+    total += arrays.capacity() * sizeof(ArrayEntry);
+
+    total += imageStringIndex.capacity() * sizeof(uint16_t);
+    for (const InputBuffer& buffer : inputImage) {
+        total += buffer.words.capacity() * sizeof(uint32_t) + buffer.strings.capacity() * sizeof(PlcValueUnion);
+        total += buffer.pending.capacity() + buffer.pendingSlots.capacity() * sizeof(uint16_t);
+    }
+    for (const ImageBuffer& buffer : outputImage) {
+        total += buffer.words.capacity() * sizeof(uint32_t) + buffer.strings.capacity() * sizeof(PlcValueUnion);
+    }
+    total += retentive.getMemoryUsage();
+    return total;
+}
@@ -2,11 +2,33 @@
 #define PLC_MEMORY_H
 
 #include <Arduino.h>
+#include <cstring>
 #include <map>
 #include <string>
+#include <vector>
+#include <type_traits>
+#include <atomic>
+#include "../PlcEngine/Engine/PlcSpinLock.h"
+#include "../PlcEngine/Engine/PlcArena.h"
+#include "../PlcEngine/Engine/PlcRetentiveStore.h"
+
+// Bytes per STRING variable in the string pool, including the terminator
+#ifndef PLC_STRING_SIZE
+#define PLC_STRING_SIZE 64
+#endif
+
+// Capacity of a program's string pool in bytes (see PlcMemory::setStringPoolCapacity)
+#ifndef PLC_STRING_POOL_SIZE
+#define PLC_STRING_POOL_SIZE 8192
+#endif
+
+// Elements of an ARRAY variable (see PlcMemory::declareArray)
+#ifndef PLC_MAX_ARRAY_LENGTH
+#define PLC_MAX_ARRAY_LENGTH 256
+#endif
 
 // Supported data types for our PLC
-enum class PlcValueType {
+enum class PlcValueType : uint8_t {
     BOOL, BYTE, INT, DINT, REAL, STRING_TYPE // Renamed to avoid conflict with String class
 };
 
@@ -16,10 +38,10 @@ union PlcValueUnion {
     int16_t i16Val;
     uint32_t ui32Val;
     float fVal;
-    char sVal[64]; // Assuming a max string length for union
+    char sVal[PLC_STRING_SIZE];
 
-    // Constructor to initialize union members
-    PlcValueUnion() : bVal(false) {}
+    // Constructor to initialize union members (ui32Val covers every numeric member)
+    PlcValueUnion() : ui32Val(0) {}
 };
 
 // PlcValue - type-safe value container for endpoint integration
@@ -36,12 +58,82 @@ struct PlcValue {
     }
 };
 
+/**
+ * PlcVariable - slot descriptor in the PlcMemory slot table.
+ *
+ * The value itself lives in the segment of its type: BOOLs as bits of
+ * 32-bit words, BYTE, INT, DINT and REAL in arrays of their C++ type, and
+ * STRINGs in the string pool. Mesh links are kept in a side table.
+ */
 struct PlcVariable {
-    PlcValueUnion value;
-    PlcValueType valueType; // To track which member of the union is active
-    PlcValueType type; // Original PlcDataType enum
-    bool isRetentive;
-    String mesh_link; // Identifier for mesh-linked variables
+    static constexpr uint8_t FLAG_RETENTIVE = 0x01;
+
+    uint16_t offset;    // Bit, element or string index in the segment of the type
+    PlcValueType type;
+    uint8_t flags;
+
+    bool isRetentive() const { return (flags & FLAG_RETENTIVE) != 0; }
+};
+
+/**
+ * VarHandle - index of a variable in the PlcMemory slot table.
+ *
+ * Blocks resolve their variable names to handles once in configure() and
+ * use them on every scan instead of looking names up in a map. A handle
+ * stays valid until PlcMemory::clear() is called.
+ */
+struct VarHandle {
+    static constexpr uint16_t INVALID_INDEX = 0xFFFF;
+
+    uint16_t index;
+    PlcValueType type; // Declared type of the slot
+
+    VarHandle() : index(INVALID_INDEX), type(PlcValueType::BOOL) {}
+    VarHandle(uint16_t idx, PlcValueType t) : index(idx), type(t) {}
+
+    bool isValid() const { return index != INVALID_INDEX; }
+};
+
+// Handles held by a block, allocated from its program's arena
+typedef PlcArenaVector<VarHandle> PlcHandleList;
+
+/**
+ * PlcArrayRef - an ARRAY[length] OF type variable.
+ *
+ * Its elements are ordinary slots named "name[0]" to "name[length - 1]",
+ * so blocks, the web UI and the process image address single elements by
+ * name. The slots are consecutive in the slot table and their values
+ * consecutive in the segment of the type, which lets the vector blocks
+ * run over an array in one loop (PlcMemory::arrayData()).
+ */
+struct PlcArrayRef {
+    uint16_t firstSlot;
+    uint16_t length;
+    PlcValueType type;
+
+    PlcArrayRef() : firstSlot(VarHandle::INVALID_INDEX), length(0), type(PlcValueType::BOOL) {}
+    PlcArrayRef(uint16_t first, uint16_t count, PlcValueType t) : firstSlot(first), length(count), type(t) {}
+
+    bool isValid() const { return length > 0; }
+    VarHandle element(uint16_t i) const { return VarHandle(static_cast<uint16_t>(firstSlot + i), type); }
+};
+
+/**
+ * PlcBitRef - a BOOL variable as a bit of the marker words.
+ *
+ * BOOL values are stored 32 to a word (PlcMemory::loadWord()); a bit
+ * handle names the word and the bit in it, so word-wide code can combine
+ * up to 32 variables with one operation.
+ */
+struct PlcBitRef {
+    uint16_t word;
+    uint32_t mask; // The variable's bit, 0 if invalid
+
+    PlcBitRef() : word(0), mask(0) {}
+    PlcBitRef(uint16_t w, uint8_t bit) : word(w), mask(1u << bit) {}
+
+    bool isValid() const { return mask != 0; }
+    uint8_t bit() const { return static_cast<uint8_t>(__builtin_ctz(mask)); }
 };
 
 // Forward declarations
@@ -53,8 +145,27 @@ class PlcMemory {
 public:
     PlcMemory();
     void begin(); // Load retentive memory from NVS
+    // Bytes STRING variables may take in the string pool (0: no limit)
+    void setStringPoolCapacity(size_t bytes) { stringPoolCapacity = bytes; }
 
+    // Re-declaring a variable updates its attributes. Once the process image
+    // is built the program's variables are fixed: declaring one of them
+    // again with its type only confirms it, anything else is refused.
     bool declareVariable(const std::string& name, PlcValueType type, bool isRetentive = false, const String& mesh_link = "");
+    // ARRAY[length] OF type, a BOOL or numeric type. Neither the array nor
+    // one of its elements may be declared already. BOOL arrays start at a
+    // marker word and have their last word to themselves.
+    bool declareArray(const std::string& name, PlcValueType type, uint16_t length, bool isRetentive = false);
+    // Invalid if no array of that name is declared
+    PlcArrayRef findArray(const char* name) const;
+    size_t getArrayCount() const { return arrays.size(); }
+
+    // Strict typing ("strict_types"): blocks reject operands whose declared
+    // types differ instead of converting between them (see PlcTypeCheck)
+    void setStrictTypes(bool enabled) { strictTypes = enabled; }
+    bool isStrictTypes() const { return strictTypes; }
+
+    // ========== Name-based access (configuration, web, MQTT) ==========
 
     template<typename T>
     bool setValue(const std::string& name, T val);
@@ -62,9 +173,204 @@ public:
     template<typename T>
     T getValue(const std::string& name, T defaultValue = T{});
 
-    void saveRetentiveMemory();
+    // ========== Handle-based access (scan cycle) ==========
+
+    // Resolve a variable name to a handle. Undeclared variables are declared
+    // with the given type. Returns an invalid handle for a null or empty name.
+    VarHandle resolve(const char* name, PlcValueType declareAs);
+    VarHandle resolve(const std::string& name, PlcValueType declareAs) { return resolve(name.c_str(), declareAs); }
+
+    // Look up an existing variable. Returns an invalid handle if it is not declared.
+    VarHandle findHandle(const std::string& name) const;
+    // Handle of a slot index, e.g. one of PlcBlock::getOutputSlots()
+    VarHandle getHandle(uint16_t index) const { return VarHandle(index, slots[index].type); }
+    const char* getVariableName(VarHandle handle) const; // nullptr for an invalid handle
+    size_t getVariableCount() const { return slots.size(); }
+
+    const String* getMeshLink(VarHandle handle) const; // nullptr if the variable has none
+    // Both memories have a variable linked to the same mesh variable
+    bool sharesMeshLink(const PlcMemory& other) const;
+
+    template<typename T>
+    inline T getValue(VarHandle handle, T defaultValue = T{}) const {
+        if (!handle.isValid()) {
+            return defaultValue;
+        }
+        return readSlot<T>(slots[handle.index]);
+    }
+
+    template<typename T>
+    inline bool setValue(VarHandle handle, T val) {
+        if (!handle.isValid()) {
+            return false;
+        }
+        const PlcVariable& var = slots[handle.index];
+        if (trackChanges) {
+            uint32_t before = readRaw(var);
+            writeSlot<T>(var, val);
+            noteWrite(handle.index, var, before);
+        } else {
+            writeSlot<T>(var, val);
+        }
+        return true;
+    }
+
+    // Typed access for the kernels a block picks at load time (see
+    // PlcTypeCheck). The slot must be declared with the type storing T
+    // (bool BOOL, int16_t INT, int32_t DINT, float REAL); the value is then
+    // accessed without a conversion or a switch on the slot type.
+    template<typename T>
+    inline T getTyped(VarHandle handle) const {
+        return loadTyped<T>(slots[handle.index].offset);
+    }
+
+    template<typename T>
+    inline void setTyped(VarHandle handle, T val) {
+        const PlcVariable& var = slots[handle.index];
+        if (trackChanges) {
+            uint32_t before = readRaw(var);
+            storeTyped<T>(var.offset, val);
+            noteWrite(handle.index, var, before);
+        } else {
+            storeTyped<T>(var.offset, val);
+        }
+    }
+
+    // Element 0 of a numeric array in its segment, the others follow it.
+    // T must store the array's type (int16_t INT, int32_t DINT, float REAL).
+    // Writes through the pointer are not change tracked; blocks write with
+    // setTyped() per element while isChangeTrackingEnabled().
+    template<typename T>
+    inline T* arrayData(const PlcArrayRef& array) {
+        return segmentData<T>() + slots[array.firstSlot].offset;
+    }
+    template<typename T>
+    inline const T* arrayData(const PlcArrayRef& array) const {
+        return const_cast<PlcMemory*>(this)->segmentData<T>() + slots[array.firstSlot].offset;
+    }
+
+    // ========== Strings (scan cycle) ==========
+
+    // STRING values are PLC_STRING_SIZE bytes each in the string pool,
+    // which is sized when the variables are declared. These functions work
+    // on the pool in place; getValue<String>() and setValue<String>() build
+    // a String on the heap per call and are meant for configuration and web
+    // access, not for blocks.
+
+    // Text of a STRING variable, valid until the variable is written;
+    // nullptr for other types and an invalid handle
+    const char* getString(VarHandle handle) const {
+        if (!handle.isValid() || slots[handle.index].type != PlcValueType::STRING_TYPE) {
+            return nullptr;
+        }
+        return stringAt(slots[handle.index].offset);
+    }
+
+    // Text of a variable of any type, rendered like getValue<String>() into
+    // buffer (truncated to size - 1 bytes) unless it is a STRING, whose text
+    // is returned in place. "" for an invalid handle.
+    const char* getText(VarHandle handle, char* buffer, size_t size) const;
+    // Same, always copied to buffer. Returns the length of the text written.
+    size_t printValue(VarHandle handle, char* buffer, size_t size) const;
+
+    // Write length bytes of text, truncated to PLC_STRING_SIZE - 1 for a
+    // STRING; numeric variables take the number it starts with, like
+    // setValue<String>(). text may point into the variable itself.
+    bool setString(VarHandle handle, const char* text, size_t length);
+    bool setString(VarHandle handle, const char* text) { return setString(handle, text, strlen(text)); }
+
+    // ========== Marker words (BOOL storage) ==========
+
+    // Bit of a BOOL variable, invalid for other types
+    PlcBitRef getBitRef(VarHandle handle) const {
+        if (!handle.isValid() || slots[handle.index].type != PlcValueType::BOOL) {
+            return PlcBitRef();
+        }
+        uint16_t bit = slots[handle.index].offset;
+        return PlcBitRef(static_cast<uint16_t>(bit >> 5), static_cast<uint8_t>(bit & 31));
+    }
+    // First marker word of a BOOL array
+    uint16_t getArrayWord(const PlcArrayRef& array) const { return slots[array.firstSlot].offset >> 5; }
+    size_t getWordCount() const { return boolBits.size(); }
+
+    inline uint32_t loadWord(uint16_t word) const { return boolBits[word]; }
+
+    // Replace the bits of mask by those of value. While changes are tracked
+    // the variables whose bit changed are recorded, as with setValue().
+    inline void storeWord(uint16_t word, uint32_t value, uint32_t mask) {
+        uint32_t before = boolBits[word];
+        uint32_t after = (before & ~mask) | (value & mask);
+        boolBits[word] = after;
+        if (trackChanges && after != before) {
+            noteBits(word, after ^ before);
+        }
+    }
+
+    // ========== Change tracking (incremental execution) ==========
+
+    // When enabled, every write that changes a value records the slot in
+    // the changed list until clearChangedSlots() is called. String writes
+    // are always recorded.
+    void setChangeTracking(bool enabled);
+    bool isChangeTrackingEnabled() const { return trackChanges; }
+    const std::vector<uint16_t>& getChangedSlots() const { return changedSlots; }
+    void clearChangedSlots();
+
+    // ========== Process image (access from other tasks) ==========
+
+    // While a program runs, only the PLC task touches the slots. Other
+    // tasks (mesh, MQTT, web, local IO) post writes into the input image,
+    // which the PLC task applies at the start of the next cycle, and read
+    // the output image, which holds the values of the last completed cycle.
+    // Both are double-buffered, so the scan itself runs without locks.
+
+    // Size the image for the variables declared so far and publish their
+    // current values. Variables declared later are not part of the image.
+    void buildProcessImage();
+    bool hasProcessImage() const { return imageSlotCount > 0; }
+
+    // Post a write for the next cycle; the last write per variable wins.
+    // Returns false if the variable is not part of the process image.
+    template<typename T>
+    bool postValue(const std::string& name, T val);
+
+    // Called by the posting task after each posted write (PlcEngine wakes
+    // the PLC task with it in tickless mode)
+    typedef void (*PostListener)(void* context);
+    void setPostListener(PostListener listener, void* context) { postListener = listener; postContext = context; }
+
+    // Value at the end of the last completed cycle. Returns the default if
+    // the variable is not part of the process image.
+    template<typename T>
+    T getImageValue(const std::string& name, T defaultValue = T{}) const;
+
+    // Values of several variables, all from the same completed cycle.
+    // Returns false if a handle is not part of the process image.
+    bool getImageValues(const std::vector<VarHandle>& handles, std::vector<PlcValue>& values) const;
+
+    // PLC task only
+    void applyInputImage();     // Cycle start: posted writes -> slots
+    bool publishOutputImage();  // Cycle end: slots -> output image; true if a value differs from the last image
+
+    // Number of published output images
+    uint32_t getImageCycle() const { return imageSequence.load(std::memory_order_acquire) >> 1; }
+
+    // Pack the changed retentive values and write them to NVS now. Only
+    // while no task scans the program; PlcEngine packs on the PLC task and
+    // writes from the main loop instead
+    bool saveRetentiveMemory();
+    PlcRetentiveStore& getRetentive() { return retentive; }
+    const PlcRetentiveStore& getRetentive() const { return retentive; }
     void clear(); // New method
 
+    // ========== Online change ==========
+
+    // Slots declared in both memories with the same name and type, as
+    // (this, previous) pairs. Done while the previous program still runs.
+    void matchSlots(const PlcMemory& previous, std::vector<std::pair<uint16_t, uint16_t>>& pairs) const;
+    // Between two scans: copy the matched values from the previous memory
+    void copySlots(const PlcMemory& previous, const std::vector<std::pair<uint16_t, uint16_t>>& pairs);
+
     // IO Point Management - Integration with DeviceRegistry
     void setDeviceRegistry(DeviceRegistry* registry);
     bool registerIOPoint(const std::string& plcVarName, const std::string& endpointName,
@@ -77,13 +383,316 @@ public:
     void syncIOPoints(IODirection* filterDirection = nullptr); // Sync between PLC variables and endpoints (optionally filter by direction)
     PlcValue getValueAsPlcValue(const std::string& name); // Get value as PlcValue struct
 
-    // Memory usage
+    // Bytes held by the slot table, the value segments, the mesh link and
+    // name tables, change tracking, the process image and the retentive store
     size_t getMemoryUsage() const;
+    size_t getStringPoolUsed() const { return stringPool.size(); }
+
+    // Default storage type for a C++ type (used when setValue() declares a variable)
+    template<typename T>
+    static PlcValueType typeFor() {
+        if (std::is_same<T, bool>::value) return PlcValueType::BOOL;
+        if (sizeof(T) == 1) return PlcValueType::BYTE;
+        if (std::is_floating_point<T>::value) return PlcValueType::REAL;
+        if (sizeof(T) == 2) return PlcValueType::INT;
+        return PlcValueType::DINT;
+    }
 
 private:
-    std::map<std::string, PlcVariable> memoryMap;
+    friend class PlcBytecode; // Executes directly on the slot table
+    friend class PlcExpression; // Loads operands from the value segments
+    friend class PlcRetentiveStore; // Packs and restores the retentive slots
+
+    std::vector<PlcVariable> slots;               // Contiguous slot table, indexed by VarHandle
+
+    // Value segments, addressed by PlcVariable::offset
+    std::vector<uint32_t> boolBits;               // 32 BOOLs per word
+    uint16_t boolCount;
+    std::vector<uint16_t> bitOwners;              // Slot per bit, INVALID_INDEX for unused bits
+    std::vector<uint8_t> byteValues;
+    std::vector<int16_t> intValues;
+    std::vector<int32_t> dintValues;
+    std::vector<float> realValues;
+    std::vector<char> stringPool;                 // PLC_STRING_SIZE bytes per STRING variable
+    size_t stringPoolCapacity;
+
+    struct MeshLink {
+        uint16_t slot;
+        String link;
+    };
+    std::vector<MeshLink> meshLinks;              // Only variables that have one
+
+    // Name table (configuration only)
+    std::vector<char> namePool;                   // NUL-terminated names
+    std::vector<uint32_t> nameOffsets;            // Per slot, into namePool
+    std::vector<uint16_t> nameOrder;              // Slots sorted by name, for binary search
+    struct ArrayEntry {
+        uint32_t name;                            // Into namePool
+        PlcArrayRef ref;
+    };
+    std::vector<ArrayEntry> arrays;               // Configuration only, few per program
     DeviceRegistry* deviceRegistry;
+    PlcRetentiveStore retentive;
     void loadRetentiveMemory();
+
+    bool allocate(PlcValueType type, uint16_t& offset);
+    void setMeshLink(uint16_t slot, const String& link);
+    void shrinkToFit();
+
+    bool trackChanges;
+    bool strictTypes;
+    std::vector<uint8_t> changedFlags;            // Per slot, set while the slot is in changedSlots
+    std::vector<uint16_t> changedSlots;
+
+    int findSlot(const char* name) const;
+    int findSlot(const std::string& name) const { return findSlot(name.c_str()); }
+    const char* nameAt(uint16_t slot) const { return namePool.data() + nameOffsets[slot]; }
+
+    // Process image. Numeric values are stored as their 4 raw bytes; string
+    // slots additionally own an entry in the strings vector.
+    struct ImageBuffer {
+        std::vector<uint32_t> words;          // Per image slot
+        std::vector<PlcValueUnion> strings;   // Per string slot, see imageStringIndex
+    };
+    struct InputBuffer : ImageBuffer {
+        std::vector<uint8_t> pending;         // Per image slot
+        std::vector<uint16_t> pendingSlots;   // Reserved for every image slot, never grows
+    };
+
+    uint16_t imageSlotCount;
+    std::vector<uint16_t> imageStringIndex;   // Per image slot, INVALID_INDEX for numeric slots
+    InputBuffer inputImage[2];
+    uint8_t inputPosting;                     // Buffer other tasks post into, guarded by inputLock
+    PlcSpinLock inputLock;
+    ImageBuffer outputImage[2];
+    std::atomic<uint32_t> imageSequence;      // Seqlock: odd while a publish is in progress
+    PostListener postListener;
+    void* postContext;
+
+    void storeImageValue(ImageBuffer& buffer, uint16_t index, const PlcValueUnion& value) const;
+    void loadImageValue(const ImageBuffer& buffer, uint16_t index, PlcValueUnion& value) const;
+    void publishImageSlot(ImageBuffer& buffer, uint16_t index) const;
+    void applyImageSlot(const ImageBuffer& buffer, uint16_t index);
+    bool readOutputImage(int slot, PlcValueUnion& value) const;
+
+    // Record the variables of the changed bits of a marker word
+    void noteBits(uint16_t word, uint32_t changed);
+    // Start the next BOOL at a marker word
+    void alignBits();
+
+    // Comparing the raw bits before and after the write detects a change
+    // for every numeric type
+    inline void noteWrite(uint16_t index, const PlcVariable& var, uint32_t before) {
+        if (readRaw(var) == before && var.type != PlcValueType::STRING_TYPE) {
+            return;
+        }
+        if (!changedFlags[index]) {
+            changedFlags[index] = 1;
+            changedSlots.push_back(index);
+        }
+    }
+
+    template<typename T>
+    static inline T readValue(const PlcValueUnion& value, PlcValueType type) {
+        switch (type) {
+            case PlcValueType::BOOL: return static_cast<T>(value.bVal);
+            case PlcValueType::BYTE: return static_cast<T>(value.ui8Val);
+            case PlcValueType::INT: return static_cast<T>(value.i16Val);
+            case PlcValueType::DINT: return static_cast<T>(static_cast<int32_t>(value.ui32Val));
+            case PlcValueType::REAL: return static_cast<T>(value.fVal);
+            case PlcValueType::STRING_TYPE: return static_cast<T>(atof(value.sVal));
+        }
+        return T{};
+    }
+
+    template<typename T>
+    static inline void writeValue(PlcValueUnion& value, PlcValueType type, T val) {
+        switch (type) {
+            case PlcValueType::BOOL: value.bVal = (val != 0); break;
+            case PlcValueType::BYTE: value.ui8Val = static_cast<uint8_t>(val); break;
+            case PlcValueType::INT: value.i16Val = static_cast<int16_t>(val); break;
+            case PlcValueType::DINT: value.ui32Val = static_cast<uint32_t>(static_cast<int32_t>(val)); break;
+            case PlcValueType::REAL: value.fVal = static_cast<float>(val); break;
+            case PlcValueType::STRING_TYPE: snprintf(value.sVal, sizeof(value.sVal), "%g", static_cast<double>(val)); break;
+        }
+    }
+
+    // ========== Segment access ==========
+
+    inline bool getBit(uint16_t bit) const {
+        return (boolBits[bit >> 5] >> (bit & 31)) & 1;
+    }
+
+    inline void setBit(uint16_t bit, bool val) {
+        uint32_t mask = 1u << (bit & 31);
+        uint32_t& word = boolBits[bit >> 5];
+        word = val ? (word | mask) : (word & ~mask);
+    }
+
+    inline char* stringAt(uint16_t offset) { return &stringPool[static_cast<size_t>(offset) * PLC_STRING_SIZE]; }
+    inline const char* stringAt(uint16_t offset) const { return &stringPool[static_cast<size_t>(offset) * PLC_STRING_SIZE]; }
+
+    // Numeric value as the raw bits of the matching PlcValueUnion member
+    // (0 for strings)
+    inline uint32_t readRaw(const PlcVariable& var) const {
+        switch (var.type) {
+            case PlcValueType::BOOL: return getBit(var.offset);
+            case PlcValueType::BYTE: return byteValues[var.offset];
+            case PlcValueType::INT: return static_cast<uint16_t>(intValues[var.offset]);
+            case PlcValueType::DINT: return static_cast<uint32_t>(dintValues[var.offset]);
+            case PlcValueType::REAL: {
+                uint32_t bits;
+                memcpy(&bits, &realValues[var.offset], sizeof(bits));
+                return bits;
+            }
+            case PlcValueType::STRING_TYPE: break;
+        }
+        return 0;
+    }
+
+    inline void writeRaw(const PlcVariable& var, uint32_t bits) {
+        switch (var.type) {
+            case PlcValueType::BOOL: setBit(var.offset, (bits & 0xFF) != 0); break;
+            case PlcValueType::BYTE: byteValues[var.offset] = static_cast<uint8_t>(bits); break;
+            case PlcValueType::INT: intValues[var.offset] = static_cast<int16_t>(bits); break;
+            case PlcValueType::DINT: dintValues[var.offset] = static_cast<int32_t>(bits); break;
+            case PlcValueType::REAL: memcpy(&realValues[var.offset], &bits, sizeof(bits)); break;
+            case PlcValueType::STRING_TYPE: break;
+        }
+    }
+
+    // Segment element of a typed slot, see getTyped()
+    template<typename T>
+    inline T loadTyped(uint16_t offset) const;
+    template<typename T>
+    inline void storeTyped(uint16_t offset, T val);
+    // Segment storing T, see arrayData()
+    template<typename T>
+    inline T* segmentData();
+
+    // Copy a slot to or from a PlcValueUnion (process image, online change)
+    void loadSlot(const PlcVariable& var, PlcValueUnion& value) const;
+    void storeSlot(const PlcVariable& var, const PlcValueUnion& value);
+
+    template<typename T>
+    inline T readSlot(const PlcVariable& var) const {
+        switch (var.type) {
+            case PlcValueType::BOOL: return static_cast<T>(getBit(var.offset));
+            case PlcValueType::BYTE: return static_cast<T>(byteValues[var.offset]);
+            case PlcValueType::INT: return static_cast<T>(intValues[var.offset]);
+            case PlcValueType::DINT: return static_cast<T>(dintValues[var.offset]);
+            case PlcValueType::REAL: return static_cast<T>(realValues[var.offset]);
+            case PlcValueType::STRING_TYPE: return static_cast<T>(atof(stringAt(var.offset)));
+        }
+        return T{};
+    }
+
+    template<typename T>
+    inline void writeSlot(const PlcVariable& var, T val) {
+        switch (var.type) {
+            case PlcValueType::BOOL: setBit(var.offset, val != 0); break;
+            case PlcValueType::BYTE: byteValues[var.offset] = static_cast<uint8_t>(val); break;
+            case PlcValueType::INT: intValues[var.offset] = static_cast<int16_t>(val); break;
+            case PlcValueType::DINT: dintValues[var.offset] = static_cast<int32_t>(val); break;
+            case PlcValueType::REAL: realValues[var.offset] = static_cast<float>(val); break;
+            case PlcValueType::STRING_TYPE: snprintf(stringAt(var.offset), PLC_STRING_SIZE, "%g", static_cast<double>(val)); break;
+        }
+    }
 };
 
-#endif // PLC_MEMORY_H
\ No newline at end of file
+// String values are stored as NUL-terminated text in the slot
+template<>
+inline String PlcMemory::readValue<String>(const PlcValueUnion& value, PlcValueType type) {
+    if (type == PlcValueType::STRING_TYPE) {
+        return String(value.sVal);
+    }
+    if (type == PlcValueType::REAL) {
+        return String(value.fVal);
+    }
+    return String(readValue<int32_t>(value, type));
+}
+
+template<>
+inline void PlcMemory::writeValue<String>(PlcValueUnion& value, PlcValueType type, String val) {
+    if (type == PlcValueType::STRING_TYPE) {
+        strncpy(value.sVal, val.c_str(), sizeof(value.sVal) - 1);
+        value.sVal[sizeof(value.sVal) - 1] = '\0';
+    } else {
+        writeValue<float>(value, type, val.toFloat());
+    }
+}
+
+template<>
+inline std::string PlcMemory::readValue<std::string>(const PlcValueUnion& value, PlcValueType type) {
+    return std::string(readValue<String>(value, type).c_str());
+}
+
+template<>
+inline void PlcMemory::writeValue<std::string>(PlcValueUnion& value, PlcValueType type, std::string val) {
+    writeValue<String>(value, type, String(val.c_str()));
+}
+
+template<>
+inline String PlcMemory::readSlot<String>(const PlcVariable& var) const {
+    if (var.type == PlcValueType::STRING_TYPE) {
+        return String(stringAt(var.offset));
+    }
+    if (var.type == PlcValueType::REAL) {
+        return String(realValues[var.offset]);
+    }
+    return String(readSlot<int32_t>(var));
+}
+
+template<>
+inline void PlcMemory::writeSlot<String>(const PlcVariable& var, String val) {
+    if (var.type == PlcValueType::STRING_TYPE) {
+        char* target = stringAt(var.offset);
+        strncpy(target, val.c_str(), PLC_STRING_SIZE - 1);
+        target[PLC_STRING_SIZE - 1] = '\0';
+    } else {
+        writeSlot<float>(var, val.toFloat());
+    }
+}
+
+template<>
+inline std::string PlcMemory::readSlot<std::string>(const PlcVariable& var) const {
+    return std::string(readSlot<String>(var).c_str());
+}
+
+template<>
+inline void PlcMemory::writeSlot<std::string>(const PlcVariable& var, std::string val) {
+    writeSlot<String>(var, String(val.c_str()));
+}
+
+template<>
+inline PlcValueType PlcMemory::typeFor<String>() { return PlcValueType::STRING_TYPE; }
+
+template<>
+inline PlcValueType PlcMemory::typeFor<std::string>() { return PlcValueType::STRING_TYPE; }
+
+template<>
+inline bool PlcMemory::loadTyped<bool>(uint16_t offset) const { return getBit(offset); }
+template<>
+inline int16_t PlcMemory::loadTyped<int16_t>(uint16_t offset) const { return intValues[offset]; }
+template<>
+inline int32_t PlcMemory::loadTyped<int32_t>(uint16_t offset) const { return dintValues[offset]; }
+template<>
+inline float PlcMemory::loadTyped<float>(uint16_t offset) const { return realValues[offset]; }
+
+template<>
+inline void PlcMemory::storeTyped<bool>(uint16_t offset, bool val) { setBit(offset, val); }
+template<>
+inline void PlcMemory::storeTyped<int16_t>(uint16_t offset, int16_t val) { intValues[offset] = val; }
+template<>
+inline void PlcMemory::storeTyped<int32_t>(uint16_t offset, int32_t val) { dintValues[offset] = val; }
+template<>
+inline void PlcMemory::storeTyped<float>(uint16_t offset, float val) { realValues[offset] = val; }
+
+template<>
+inline int16_t* PlcMemory::segmentData<int16_t>() { return intValues.data(); }
+template<>
+inline int32_t* PlcMemory::segmentData<int32_t>() { return dintValues.data(); }
+template<>
+inline float* PlcMemory::segmentData<float>() { return realValues.data(); }
+
+#endif // PLC_MEMORY_H
@@ -0,0 +1,61 @@
+#include "../PlcEngine/Engine/PlcProfiler.h"
+
+void PlcTimingProfile::reset() {
+    lastTicks = 0;
+    maxTicks = 0;
+    totalTicks = 0;
+    samples = 0;
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        histogram[i] = 0;
+    }
+}
+
+void PlcTimingProfile::record(uint32_t ticks) {
+    lastTicks = ticks;
+    if (ticks > maxTicks) {
+        maxTicks = ticks;
+    }
+    totalTicks += ticks;
+    samples++;
+
+    int log2 = ticks ? 31 - __builtin_clz(ticks) : 0;
+    int bucket = log2 - HISTOGRAM_MIN_LOG2;
+    if (bucket < 0) {
+        bucket = 0;
+    } else if (bucket >= HISTOGRAM_BUCKETS) {
+        bucket = HISTOGRAM_BUCKETS - 1;
+    }
+    histogram[bucket]++;
+}
+
+void PlcTimingProfile::toJson(JsonObject obj) const {
+    obj["samples"] = samples;
+    obj["last_us"] = PlcProfiler::toMicros(lastTicks);
+    obj["max_us"] = PlcProfiler::toMicros(maxTicks);
+    obj["mean_us"] = PlcProfiler::toMicros(getMeanTicks());
+
+    JsonArray buckets = obj["histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        buckets.add(histogram[i]);
+    }
+}
+
+uint32_t PlcProfiler::ticksPerMicrosecond() {
+#ifdef UNIT_TEST
+    return 1000;
+#else
+    return ESP.getCpuFreqMHz();
+#endif
+}
+
+void PlcProfiler::begin(size_t blockCount) {
+    blocks.assign(blockCount, PlcTimingProfile());
+    program.reset();
+}
+
+void PlcProfiler::reset() {
+    for (PlcTimingProfile& block : blocks) {
+        block.reset();
+    }
+    program.reset();
+}
@@ -0,0 +1,77 @@
+#ifndef PLC_PROFILER_H
+#define PLC_PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#ifdef UNIT_TEST
+#include <chrono>
+#endif
+
+/**
+ * Timing statistics of one block or program, in cycle-counter ticks.
+ *
+ * The histogram is log2-spaced: bucket 0 counts samples below
+ * 2^(HISTOGRAM_MIN_LOG2 + 1) ticks, bucket k >= 1 counts samples in
+ * [2^(HISTOGRAM_MIN_LOG2 + k), 2^(HISTOGRAM_MIN_LOG2 + k + 1)) and the last
+ * bucket is open-ended.
+ */
+struct PlcTimingProfile {
+    static constexpr uint8_t HISTOGRAM_BUCKETS = 16;
+    static constexpr uint8_t HISTOGRAM_MIN_LOG2 = 6;
+
+    uint32_t lastTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+    uint32_t samples;
+    uint32_t histogram[HISTOGRAM_BUCKETS];
+
+    PlcTimingProfile() { reset(); }
+    void reset();
+    void record(uint32_t ticks);
+    uint32_t getMeanTicks() const { return samples ? static_cast<uint32_t>(totalTicks / samples) : 0; }
+    void toJson(JsonObject obj) const;
+};
+
+/**
+ * PlcProfiler - per-block and per-program scan-time profile.
+ *
+ * PlcProgram records into it only when built with -D PLC_PROFILING;
+ * otherwise the instrumentation is not compiled and costs nothing.
+ * Ticks are CPU cycles on the ESP32 and nanoseconds in native builds.
+ */
+class PlcProfiler {
+public:
+    static inline uint32_t readCounter() {
+#ifdef UNIT_TEST
+        using namespace std::chrono;
+        return static_cast<uint32_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+#else
+        return ESP.getCycleCount();
+#endif
+    }
+
+    static uint32_t ticksPerMicrosecond();
+    static float toMicros(uint32_t ticks) { return static_cast<float>(ticks) / ticksPerMicrosecond(); }
+
+    void begin(size_t blockCount); // Size for the program's blocks and reset
+    void reset();
+
+    inline void recordBlock(size_t index, uint32_t ticks) {
+        if (index < blocks.size()) {
+            blocks[index].record(ticks);
+        }
+    }
+    inline void recordProgram(uint32_t ticks) { program.record(ticks); }
+
+    size_t getBlockCount() const { return blocks.size(); }
+    const PlcTimingProfile& getBlock(size_t index) const { return blocks[index]; }
+    const PlcTimingProfile& getProgram() const { return program; }
+    size_t getMemoryUsage() const { return blocks.capacity() * sizeof(PlcTimingProfile); }
+
+private:
+    std::vector<PlcTimingProfile> blocks; // In evaluation order
+    PlcTimingProfile program;             // Whole logic execution per scan
+};
+
+#endif // PLC_PROFILER_H
@@ -1,209 +1,1023 @@
 #include "../PlcEngine/Engine/PlcProgram.h"
 #include <memory> // For std::make_unique
+#include <map>
+#include <queue>
+#include <functional> // For std::greater
+#include <algorithm>
 #include <StreamLogger.h> // For EspHubLog
 extern StreamLogger* EspHubLog; // Declare EspHubLog
 
-// Include all block headers
-#include "../Blocks/logic/BlockAND.h"
-#include "../Blocks/logic/BlockOR.h"
-#include "../Blocks/logic/BlockNOT.h"
-#include "../Blocks/logic/BlockXOR.h"
-#include "../Blocks/logic/BlockNAND.h"
-#include "../Blocks/logic/BlockNOR.h"
-#include "../Blocks/logic/BlockSR.h"
-#include "../Blocks/logic/BlockRS.h"
-#include "../Blocks/timers/BlockTON.h"
-#include "../Blocks/timers/BlockTOF.h"
-#include "../Blocks/timers/BlockTP.h"
-#include "../Blocks/counters/BlockCTU.h"
-#include "../Blocks/counters/BlockCTD.h"
-#include "../Blocks/counters/BlockCTUD.h"
-#include "../Blocks/math/BlockADD.h"
-#include "../Blocks/math/BlockSUB.h"
-#include "../Blocks/math/BlockMUL.h"
-#include "../Blocks/math/BlockDIV.h"
-#include "../Blocks/math/BlockMOD.h"
-#include "../Blocks/math/BlockABS.h"
-#include "../Blocks/math/BlockSQRT.h"
-#include "../Blocks/math/BlockINC.h"
-#include "../Blocks/math/BlockDEC.h"
-#include "../Blocks/comparison/BlockGT.h"
-#include "../Blocks/comparison/BlockEQ.h"
-#include "../Blocks/comparison/BlockNE.h"
-#include "../Blocks/comparison/BlockLT.h"
-#include "../Blocks/comparison/BlockGE.h"
-#include "../Blocks/comparison/BlockLE.h"
-#include "../Blocks/scheduler/BlockTimeCompare.h"
-#include "../Blocks/conversion/BlockBoolArrayToInt8.h"
-#include "../Blocks/conversion/BlockInt8ToInt16.h"
-#include "../Blocks/conversion/BlockInt8ToUint8.h"
-#include "../Blocks/conversion/BlockInt16ToUint16.h"
-#include "../Blocks/conversion/BlockInt32ToTime.h"
-#include "../Blocks/conversion/BlockInt16ToFloat.h"
-#include "../Blocks/conversion/BlockInt32ToDouble.h"
-#include "../Blocks/logic/BlockSequencer.h"
-#include "../Blocks/events/BlockStatusHandler.h"
+#include "../PlcEngine/Engine/PlcBlockRegistry.h"
+#include "../PlcEngine/Blocks/logic/PlcPackedBitBlock.h"
 
 
 PlcProgram::PlcProgram(const String& name, TimeManager* timeManager, MeshDeviceManager* meshDeviceManager)
-    : _name(name), currentState(PlcProgramState::STOPPED), watchdog_timeout_ms(5000), _timeManager(timeManager), _meshDeviceManager(meshDeviceManager) {
+    : _name(name), engine(PlcExecutionEngine::BYTECODE), executionMode(PlcExecutionMode::CYCLIC), lastEvaluatedBlocks(0), loadBytesPeak(0), core(PlcProgramImage::CORE_ANY), partition(0), worker(0), parked(false), currentState(PlcProgramState::STOPPED), watchdog_timeout_ms(5000), _timeManager(timeManager), _meshDeviceManager(meshDeviceManager) {
+    memory.setStringPoolCapacity(PLC_STRING_POOL_SIZE);
+}
+
+PlcProgram::~PlcProgram() {
+    releaseProgram();
+}
+
+void PlcProgram::releaseProgram() {
+    // Blocks live in the arena, so only their destructors run here; the
+    // arena containers are swapped out before the arena itself is released
+    for (PlcBlock* block : logic_blocks) {
+        block->~PlcBlock();
+    }
+    bytecode.clear();
+    timers.clear();
+    PlcArenaAllocator<uint16_t> allocator(&arena);
+    PlcArenaVector<PlcBlock*>(allocator).swap(logic_blocks);
+    PlcArenaVector<uint16_t>(allocator).swap(blockConfigIndex);
+    PlcArenaVector<const char*>(allocator).swap(blockTypes);
+    PlcArenaVector<const char*>(allocator).swap(blockIds);
+    PlcArenaVector<PlcInitAction>(allocator).swap(initActions);
+    PlcArenaVector<PlcInitAction>(allocator).swap(constantOutputs);
+    PlcArenaVector<uint16_t>(allocator).swap(readerOffsets);
+    PlcArenaVector<uint16_t>(allocator).swap(readerBlocks);
+    PlcArenaVector<uint8_t>(allocator).swap(blockPending);
+    PlcArenaVector<uint16_t>(allocator).swap(liveBlocks);
+    PlcArenaVector<PlcTaskClass>(PlcArenaAllocator<PlcTaskClass>(&arena)).swap(tasks);
+    memory.clear(); // Clear memory for this program
+    arena.release();
+}
+
+size_t PlcProgram::estimateArenaSize(const PlcProgramSource& image) const {
+    // Each block object, its handle and slot lists and its row in the block tables
+    size_t total = 0;
+    for (uint16_t i = 0; i < image.getBlockCount(); i++) {
+        const PlcBlockRegistry::Entry* blockType = PlcBlockRegistry::find(image.getBlock(i).type);
+        if (blockType) {
+            total += blockType->size + alignof(std::max_align_t);
+        }
+    }
+    total += image.getBlockCount() * (ARENA_LIST_BYTES_PER_BLOCK + ARENA_ID_BYTES_PER_BLOCK + 3 * sizeof(void*) + sizeof(uint16_t));
+    total += image.getInitCount() * sizeof(PlcInitAction);
+    if (image.getOptimize()) {
+        total += image.getBlockCount() * sizeof(PlcInitAction); // Folded outputs
+    }
+    if (image.getTaskCount() > 0) {
+        total += (image.getTaskCount() + 1) * (sizeof(PlcTaskClass) + ARENA_ID_BYTES_PER_BLOCK); // Classes and their names
+    }
+
+    if (image.getExecution() == PlcProgramImage::EXECUTION_INCREMENTAL) {
+        // Reader table and pending flags, an entry per array element
+        size_t slotCount = image.getVariableCount();
+        for (uint16_t i = 0; i < image.getVariableCount(); i++) {
+            slotCount += image.getVariable(i).arrayLength;
+        }
+        total += (slotCount + 1) * sizeof(uint16_t);
+        total += image.getBlockCount() * (ARENA_READERS_PER_BLOCK * sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint16_t));
+    }
+    return total;
 }
 
 bool PlcProgram::loadConfiguration(const char* jsonConfig) {
+    return loadConfigurationStream(PlcProgramLoader::readBuffer(jsonConfig, strlen(jsonConfig)));
+}
+
+bool PlcProgram::loadConfigurationStream(PlcProgramLoader::ReadFunction read) {
     if (currentState == PlcProgramState::RUNNING) {
         EspHubLog->printf("Cannot load new configuration for program '%s' while it is running. Please stop it first.\n", _name.c_str());
         return false;
     }
 
+    // The JSON is compiled entry by entry and never held as a whole; blocks
+    // are created from the compiled tables, which are freed afterwards
+    PlcProgramLoader loader(_name);
+    PlcImageBuilder builder(_name);
+    if (!loader.load(read, builder) || !loadSource(builder)) {
+        return false;
+    }
+    loadBytesPeak = loader.getBytesPeak();
+    return true;
+}
+
+bool PlcProgram::loadImage(const uint8_t* data, size_t size) {
+    if (currentState == PlcProgramState::RUNNING) {
+        EspHubLog->printf("Cannot load new configuration for program '%s' while it is running. Please stop it first.\n", _name.c_str());
+        return false;
+    }
+
+    PlcProgramImage image;
+    if (!image.open(data, size, _name)) {
+        return false;
+    }
+    return loadSource(image);
+}
+
+bool PlcProgram::loadSource(const PlcProgramSource& image) {
     // Clear previous configuration
-    config.clear();
-    logic_blocks.clear();
-    memory.clear(); // Clear memory for this program
+    loadBytesPeak = 0;
+    releaseProgram();
 
-    DeserializationError error = deserializeJson(config, jsonConfig);
-    if (error) {
-        EspHubLog->printf("deserializeJson() for PLC program '%s' config failed: %s\n", _name.c_str(), error.c_str());
+    // Everything the program keeps is allocated from one block sized here
+    size_t arenaSize = estimateArenaSize(image);
+    if (!arena.reserve(arenaSize)) {
+        EspHubLog->printf("ERROR: Program '%s': Cannot allocate %u bytes for the program arena\n", _name.c_str(), (unsigned)arenaSize);
         return false;
     }
 
-    // 1. Set watchdog timeout
-    watchdog_timeout_ms = config["watchdog_timeout_ms"] | 5000;
-
-    // 2. Declare all variables from the "memory" block
-    if (config.containsKey("memory")) {
-        JsonObject mem_block = config["memory"];
-        for (JsonPair kv : mem_block) {
-            const char* var_name = kv.key().c_str();
-            JsonObject var_attrs = kv.value().as<JsonObject>();
-            
-            String type_str = var_attrs["type"];
-            bool is_retentive = var_attrs["retentive"] | false;
-            String mesh_link = var_attrs["mesh_link"] | "";
-            
-            PlcValueType type;
-            if (type_str == "bool") type = PlcValueType::BOOL;
-            else if (type_str == "byte") type = PlcValueType::BYTE;
-            else if (type_str == "int") type = PlcValueType::INT;
-            else if (type_str == "dint") type = PlcValueType::DINT;
-            else if (type_str == "real") type = PlcValueType::REAL;
-            else if (type_str == "string") type = PlcValueType::STRING_TYPE;
-            else {
-                EspHubLog->printf("ERROR: Program '%s': Unknown variable type '%s' for variable '%s'\n", _name.c_str(), type_str.c_str(), var_name);
-                return false;
-            }
+    // 1. Program settings, validated when the image was compiled
+    watchdog_timeout_ms = image.getWatchdogTimeoutMs();
+    cycleTimer.configure(image.getCycleTimeMs(),
+                         image.getOverrun() == PlcProgramImage::OVERRUN_CATCH_UP ? PlcOverrunPolicy::CATCH_UP : PlcOverrunPolicy::SKIP);
+    engine = image.getEngine() == PlcProgramImage::ENGINE_BLOCKS ? PlcExecutionEngine::BLOCKS : PlcExecutionEngine::BYTECODE;
+    executionMode = image.getExecution() == PlcProgramImage::EXECUTION_INCREMENTAL ? PlcExecutionMode::INCREMENTAL : PlcExecutionMode::CYCLIC;
+    core = image.getCore();
+    partition = image.getPartition();
+    memory.setStrictTypes(image.getStrictTypes());
 
-            if (!memory.declareVariable(var_name, type, is_retentive, mesh_link)) {
-                EspHubLog->printf("ERROR: Program '%s': Failed to declare variable '%s'\n", _name.c_str(), var_name);
+    // 2. Declare all variables
+    for (uint16_t i = 0; i < image.getVariableCount(); i++) {
+        PlcProgramSource::Variable var = image.getVariable(i);
+        if (var.arrayLength > 0) {
+            if (!memory.declareArray(var.name, var.type, var.arrayLength, var.retentive)) {
+                EspHubLog->printf("ERROR: Program '%s': Failed to declare array '%s'\n", _name.c_str(), var.name);
                 return false;
             }
-            EspHubLog->printf("Program '%s': Declared variable '%s' of type %s (mesh_link: %s)\n", _name.c_str(), var_name, type_str.c_str(), mesh_link.c_str());
+            EspHubLog->printf("Program '%s': Declared variable '%s' of type array[%u] of %s\n", _name.c_str(), var.name,
+                              (unsigned)var.arrayLength, PlcProgramImage::typeName(var.type));
+            continue;
+        }
+        if (!memory.declareVariable(var.name, var.type, var.retentive, var.meshLink)) {
+            EspHubLog->printf("ERROR: Program '%s': Failed to declare variable '%s'\n", _name.c_str(), var.name);
+            return false;
         }
+        EspHubLog->printf("Program '%s': Declared variable '%s' of type %s (mesh_link: %s)\n", _name.c_str(), var.name, PlcProgramImage::typeName(var.type), var.meshLink);
     }
 
     // 3. Create and configure logic blocks
-    if (config.containsKey("logic")) {
-        JsonArray logic_cfg = config["logic"].as<JsonArray>();
-        for (JsonObject block_cfg : logic_cfg) {
-            const char* type = block_cfg["block_type"];
-            std::unique_ptr<PlcBlock> block;
-
-            if (strcmp(type, "AND") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockAND());
-            } else if (strcmp(type, "OR") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockOR());
-            } else if (strcmp(type, "NOT") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockNOT());
-            } else if (strcmp(type, "XOR") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockXOR());
-            } else if (strcmp(type, "NAND") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockNAND());
-            } else if (strcmp(type, "NOR") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockNOR());
-            } else if (strcmp(type, "SR") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockSR());
-            } else if (strcmp(type, "RS") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockRS());
-            } else if (strcmp(type, "TON") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockTON());
-            } else if (strcmp(type, "TOF") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockTOF());
-            } else if (strcmp(type, "TP") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockTP());
-            } else if (strcmp(type, "CTU") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockCTU());
-            } else if (strcmp(type, "CTD") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockCTD());
-            } else if (strcmp(type, "CTUD") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockCTUD());
-            } else if (strcmp(type, "ADD") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockADD());
-            } else if (strcmp(type, "SUB") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockSUB());
-            } else if (strcmp(type, "MUL") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockMUL());
-            } else if (strcmp(type, "DIV") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockDIV());
-            } else if (strcmp(type, "MOD") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockMOD());
-            } else if (strcmp(type, "ABS") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockABS());
-            } else if (strcmp(type, "SQRT") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockSQRT());
-            } else if (strcmp(type, "INC") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockINC());
-            } else if (strcmp(type, "DEC") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockDEC());
-            } else if (strcmp(type, "GT") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockGT());
-            } else if (strcmp(type, "EQ") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockEQ());
-            } else if (strcmp(type, "NE") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockNE());
-            } else if (strcmp(type, "LT") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockLT());
-            } else if (strcmp(type, "GE") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockGE());
-            } else if (strcmp(type, "LE") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockLE());
-            } else if (strcmp(type, "TIME_COMPARE") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockTimeCompare(_timeManager));
-            } else if (strcmp(type, "BOOL_ARRAY_TO_INT8") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockBoolArrayToInt8());
-            } else if (strcmp(type, "INT8_TO_INT16") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockInt8ToInt16());
-            } else if (strcmp(type, "INT8_TO_UINT8") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockInt8ToUint8());
-            } else if (strcmp(type, "INT16_TO_UINT16") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockInt16ToUint16());
-            } else if (strcmp(type, "INT32_TO_TIME") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockInt32ToTime());
-            } else if (strcmp(type, "INT16_TO_FLOAT") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockInt16ToFloat());
-            } else if (strcmp(type, "INT32_TO_DOUBLE") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockInt32ToDouble());
-            } else if (strcmp(type, "SEQUENCER") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockSequencer());
-            } else if (strcmp(type, "StatusHandler") == 0) {
-                block = std::unique_ptr<PlcBlock>(new BlockStatusHandler());
+    PlcBlockContext context = {_timeManager, _meshDeviceManager, &timers, &cycleContext};
+    logic_blocks.reserve(image.getBlockCount());
+    blockConfigIndex.reserve(image.getBlockCount());
+    blockTypes.reserve(image.getBlockCount());
+    blockIds.reserve(image.getBlockCount());
+    std::vector<uint8_t> blockTask; // Task class per configuration index
+    blockTask.reserve(image.getTaskCount() > 0 ? image.getBlockCount() : 0);
+    for (uint16_t i = 0; i < image.getBlockCount(); i++) {
+        PlcProgramSource::Block entry = image.getBlock(i);
+        const PlcBlockRegistry::Entry* blockType = PlcBlockRegistry::find(entry.type);
+        if (!blockType) {
+            EspHubLog->printf("ERROR: Program '%s': Unknown block type '%s'\n", _name.c_str(), entry.type);
+            return false;
+        }
+        PlcBlock* block = blockType->create(&arena, context);
+
+        // Only this block's configuration is parsed at a time
+        JsonDocument block_doc;
+        DeserializationError error = deserializeMsgPack(block_doc, reinterpret_cast<const char*>(entry.config), entry.configSize);
+        if (error || !block->configure(block_doc.as<JsonObject>(), memory)) {
+            EspHubLog->printf("ERROR: Program '%s': Failed to configure block of type '%s'\n", _name.c_str(), entry.type);
+            block->~PlcBlock();
+            return false;
+        }
+        uint8_t task = 0;
+        if (!resolveTask(image, block_doc["task"], task)) {
+            EspHubLog->printf("ERROR: Program '%s': Block %u (%s) names an unknown task\n", _name.c_str(), (unsigned)i, entry.type);
+            block->~PlcBlock();
+            return false;
+        }
+        if (image.getTaskCount() > 0) {
+            blockTask.push_back(task);
+        }
+        blockConfigIndex.push_back(static_cast<uint16_t>(logic_blocks.size()));
+        blockTypes.push_back(blockType->type);
+        const char* id = block_doc["id"];
+        if (id) {
+            size_t length = strlen(id) + 1;
+            id = static_cast<const char*>(memcpy(arena.allocate(length, 1), id, length));
+        }
+        blockIds.push_back(id);
+        logic_blocks.push_back(block);
+    }
+
+    // Init actions are resolved to slots now, variables first used here are declared
+    initActions.reserve(image.getInitCount());
+    for (uint16_t i = 0; i < image.getInitCount(); i++) {
+        PlcProgramSource::InitAction action = image.getInitAction(i);
+        PlcInitAction init;
+        init.variable = memory.resolve(action.variable, action.type);
+        init.type = action.type;
+        init.value = action.value.ui32Val;
+        if (!init.variable.isValid()) {
+            EspHubLog->printf("WARNING: Program '%s': INIT: Cannot set '%s'\n", _name.c_str(), action.variable);
+            continue;
+        }
+        initActions.push_back(init);
+    }
+
+    // 4. Evaluate blocks in data-flow order
+    sortBlocksByDataFlow();
+    optimization = PlcOptimization();
+    if (image.getOptimize()) {
+        optimizeBlocks(image);
+        packBitLogic(blockTask);
+    }
+    if (image.getTaskCount() > 0) {
+        buildTasks(image, blockTask);
+    }
+    liveBlocks.clear();
+    for (size_t i = 0; i < logic_blocks.size(); i++) {
+        if (logic_blocks[i]->isAlwaysLive()) {
+            liveBlocks.push_back(static_cast<uint16_t>(i));
+        }
+    }
+
+    if (executionMode == PlcExecutionMode::INCREMENTAL) {
+        // Only a subset of the blocks runs each scan, so the program is not
+        // compiled and blocks are evaluated directly
+        buildChangePropagation();
+    } else if (engine == PlcExecutionEngine::BYTECODE) {
+        compileBytecode();
+    }
+    memory.setChangeTracking(executionMode == PlcExecutionMode::INCREMENTAL);
+    memory.buildProcessImage(); // All variables are declared by now
+    memory.getRetentive().configure(_name.c_str(), image.getRetentiveCommitS() * 1000);
+    memory.getRetentive().attach(memory);
+#ifdef PLC_PROFILING
+    profiler.begin(logic_blocks.size());
+#endif
+
+    EspHubLog->printf("Program '%s': Arena %u of %u bytes used, %u chunk(s)\n", _name.c_str(),
+                      (unsigned)arena.getUsed(), (unsigned)arena.getCapacity(), (unsigned)arena.getChunkCount());
+    EspHubLog->printf("PLC program '%s' configuration loaded successfully.\n", _name.c_str());
+    return true;
+}
+
+void PlcProgram::compileBytecode() {
+    // Every block becomes exactly one instruction, so instruction i is
+    // logic_blocks[i] (the profiler relies on this). Each task class is a
+    // segment of its own, ended by an END.
+    bytecode.clear();
+    size_t segments = tasks.empty() ? 1 : tasks.size();
+    for (size_t t = 0; t < segments; t++) {
+        size_t first = tasks.empty() ? 0 : tasks[t].firstBlock;
+        size_t end = tasks.empty() ? logic_blocks.size() : tasks[t].endBlock;
+        if (!tasks.empty()) {
+            tasks[t].entry = static_cast<uint32_t>(bytecode.getInstructionCount());
+        }
+        for (size_t i = first; i < end; i++) {
+            if (!logic_blocks[i]->lower(bytecode)) {
+                bytecode.emitCall(logic_blocks[i]);
             }
-            // Add other block types here with else if
-
-            if (block) {
-                if (block->configure(block_cfg, memory)) {
-                    logic_blocks.push_back(std::move(block));
-                } else {
-                    EspHubLog->printf("ERROR: Program '%s': Failed to configure block of type '%s'\n", _name.c_str(), type);
-                    return false;
+        }
+        bytecode.finish();
+    }
+
+    EspHubLog->printf("Program '%s': Compiled %u blocks to bytecode (%u native, %u fallback)\n",
+                      _name.c_str(), (unsigned)logic_blocks.size(),
+                      (unsigned)bytecode.getLoweredCount(), (unsigned)bytecode.getFallbackCount());
+}
+
+void PlcProgram::sortBlocksByDataFlow() {
+    size_t count = logic_blocks.size();
+    if (count < 2) {
+        return;
+    }
+
+    // Writers of each slot
+    std::vector<std::vector<uint16_t>> writers(memory.getVariableCount());
+    for (size_t i = 0; i < count; i++) {
+        for (uint16_t slot : logic_blocks[i]->getOutputSlots()) {
+            writers[slot].push_back(static_cast<uint16_t>(i));
+        }
+    }
+
+    // Edge writer -> reader for every slot a block reads. A block reading
+    // its own output (latch, INC) keeps the previous scan value.
+    std::vector<std::vector<uint16_t>> successors(count);
+    std::vector<int> inDegree(count, 0);
+    for (size_t i = 0; i < count; i++) {
+        for (uint16_t slot : logic_blocks[i]->getInputSlots()) {
+            for (uint16_t writer : writers[slot]) {
+                if (writer != i) {
+                    successors[writer].push_back(static_cast<uint16_t>(i));
+                    inDegree[i]++;
                 }
+            }
+        }
+    }
+
+    // Kahn's algorithm; the lowest configuration index goes first so
+    // independent blocks keep their JSON order
+    std::priority_queue<uint16_t, std::vector<uint16_t>, std::greater<uint16_t>> ready;
+    std::vector<uint8_t> placed(count, 0);
+    std::vector<uint16_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        if (inDegree[i] == 0) {
+            ready.push(static_cast<uint16_t>(i));
+        }
+    }
+
+    while (order.size() < count) {
+        if (ready.empty()) {
+            // Only blocks on or behind a loop are left. Strip those without
+            // a successor in the remaining set; the rest are on a loop.
+            std::vector<uint8_t> inLoop(count, 0);
+            for (size_t i = 0; i < count; i++) {
+                inLoop[i] = !placed[i];
+            }
+            bool stripped = true;
+            while (stripped) {
+                stripped = false;
+                for (size_t i = 0; i < count; i++) {
+                    if (!inLoop[i]) {
+                        continue;
+                    }
+                    bool hasSuccessor = false;
+                    for (uint16_t next : successors[i]) {
+                        if (inLoop[next]) {
+                            hasSuccessor = true;
+                            break;
+                        }
+                    }
+                    if (!hasSuccessor) {
+                        inLoop[i] = 0;
+                        stripped = true;
+                    }
+                }
+            }
+
+            // Break the loop at its first block in configuration order
+            uint16_t breakAt = 0;
+            while (!inLoop[breakAt]) {
+                breakAt++;
+            }
+            EspHubLog->printf("WARNING: Program '%s': Algebraic loop at block #%u (%s), its feedback inputs use the previous scan value\n",
+                              _name.c_str(), (unsigned)breakAt, blockTypes[breakAt]);
+            inDegree[breakAt] = 0;
+            ready.push(breakAt);
+        }
+
+        uint16_t current = ready.top();
+        ready.pop();
+        if (placed[current]) {
+            continue;
+        }
+        placed[current] = 1;
+        order.push_back(current);
+        for (uint16_t next : successors[current]) {
+            if (!placed[next] && --inDegree[next] == 0) {
+                ready.push(next);
+            }
+        }
+    }
+
+    // Permuted in place, the arena does not take back replaced tables
+    std::vector<PlcBlock*> blocks(logic_blocks.begin(), logic_blocks.end());
+    std::vector<uint16_t> configIndex(blockConfigIndex.begin(), blockConfigIndex.end());
+    for (size_t i = 0; i < count; i++) {
+        logic_blocks[i] = blocks[order[i]];
+        blockConfigIndex[i] = configIndex[order[i]];
+    }
+}
+
+namespace {
+
+// Value of a numeric slot as the raw bits of its PlcValueUnion member
+uint32_t readBits(const PlcMemory& memory, VarHandle handle) {
+    PlcValueUnion value;
+    switch (handle.type) {
+        case PlcValueType::BOOL: value.bVal = memory.getValue<bool>(handle); break;
+        case PlcValueType::BYTE: value.ui8Val = memory.getValue<uint8_t>(handle); break;
+        case PlcValueType::INT: value.i16Val = memory.getValue<int16_t>(handle); break;
+        case PlcValueType::DINT: value.ui32Val = static_cast<uint32_t>(memory.getValue<int32_t>(handle)); break;
+        case PlcValueType::REAL: value.fVal = memory.getValue<float>(handle); break;
+        case PlcValueType::STRING_TYPE: break;
+    }
+    return value.ui32Val;
+}
+
+} // namespace
+
+void PlcProgram::optimizeBlocks(const PlcProgramSource& image) {
+    // A variable is observed when something besides the blocks may read it:
+    // the "memory" section (web, MQTT, mesh links, retentive values), the
+    // "io_points" and qualified names such as the local IO's DO.Heater.
+    // Constants are the "#" variables of the benchmark format, set by INIT.
+    size_t count = logic_blocks.size();
+    size_t slotCount = memory.getVariableCount();
+    std::vector<uint8_t> observed(slotCount, 0);
+    std::vector<uint8_t> constant(slotCount, 0);
+    for (uint16_t i = 0; i < image.getVariableCount(); i++) {
+        VarHandle handle = memory.findHandle(image.getVariable(i).name);
+        if (handle.isValid()) {
+            observed[handle.index] = 1;
+        }
+        PlcArrayRef array = memory.findArray(image.getVariable(i).name);
+        for (uint16_t e = 0; e < array.length; e++) {
+            observed[array.firstSlot + e] = 1;
+        }
+    }
+    for (uint16_t i = 0; i < image.getIoPointCount(); i++) {
+        VarHandle handle = memory.findHandle(image.getIoPoint(i));
+        if (handle.isValid()) {
+            observed[handle.index] = 1;
+        }
+    }
+    for (size_t slot = 0; slot < slotCount; slot++) {
+        const char* name = memory.getVariableName(memory.getHandle(static_cast<uint16_t>(slot)));
+        if (name[0] == '#') {
+            constant[slot] = 1;
+        } else if (strchr(name, '.') != nullptr) {
+            observed[slot] = 1;
+        }
+    }
+
+    std::vector<uint16_t> writerCount(slotCount, 0);
+    std::vector<uint16_t> readerCount(slotCount, 0);
+    std::vector<uint16_t> writer(slotCount, 0); // The last one, enough where writerCount is 1
+    for (size_t i = 0; i < count; i++) {
+        for (uint16_t slot : logic_blocks[i]->getOutputSlots()) {
+            writerCount[slot]++;
+            writer[slot] = static_cast<uint16_t>(i);
+            constant[slot] = 0;
+        }
+        for (uint16_t slot : logic_blocks[i]->getInputSlots()) {
+            readerCount[slot]++;
+        }
+    }
+    std::vector<uint8_t> removed(count, 0);
+
+    // 1. Fold blocks that read only constants into the values of their
+    // outputs. Blocks are in data-flow order, so the constants a block
+    // reads are final when it is evaluated here.
+    applyInitActions();
+    for (size_t i = 0; i < count; i++) {
+        PlcBlock* block = logic_blocks[i];
+        if (block->isAlwaysLive() || block->getTimer() || block->hasState() || block->getOutputSlots().empty()) {
+            continue;
+        }
+        bool foldable = true;
+        for (uint16_t slot : block->getInputSlots()) {
+            foldable = foldable && constant[slot];
+        }
+        for (uint16_t slot : block->getOutputSlots()) {
+            foldable = foldable && writerCount[slot] == 1 && memory.getHandle(slot).type != PlcValueType::STRING_TYPE;
+        }
+        if (!foldable) {
+            continue;
+        }
+        block->evaluate(memory);
+        for (uint16_t slot : block->getOutputSlots()) {
+            PlcInitAction value;
+            value.variable = memory.getHandle(slot);
+            value.type = value.variable.type;
+            value.value = readBits(memory, value.variable);
+            constantOutputs.push_back(value);
+            constant[slot] = 1;
+        }
+        removed[i] = 1;
+        optimization.foldedBlocks++;
+    }
+
+    // 2. Collapse conversion chains: a pass-through conversion whose input
+    // only the conversion before it writes is dropped, and that one writes
+    // its output instead
+    for (size_t i = 0; i < count; i++) {
+        PlcBlock* block = logic_blocks[i];
+        if (removed[i] || !block->isPassThrough() || block->getInputSlots().size() != 1 || block->getOutputSlots().size() != 1) {
+            continue;
+        }
+        uint16_t from = block->getInputSlots()[0];
+        uint16_t to = block->getOutputSlots()[0];
+        if (observed[from] || readerCount[from] != 1 || writerCount[from] != 1 || writerCount[to] != 1) {
+            continue;
+        }
+        uint16_t first = writer[from];
+        if (first >= i || removed[first] || !logic_blocks[first]->redirectOutput(from, memory.getHandle(to))) {
+            continue;
+        }
+        writer[to] = first;
+        writerCount[from] = 0;
+        readerCount[from] = 0;
+        removed[i] = 1;
+        optimization.collapsedBlocks++;
+    }
+
+    // 3. Remove the blocks none of whose outputs is observed or read by a
+    // block that stays, following the reads back from the observed variables
+    std::vector<std::vector<uint16_t>> writers(slotCount);
+    for (size_t i = 0; i < count; i++) {
+        if (!removed[i]) {
+            for (uint16_t slot : logic_blocks[i]->getOutputSlots()) {
+                writers[slot].push_back(static_cast<uint16_t>(i));
+            }
+        }
+    }
+    std::vector<uint8_t> needed(observed);
+    std::vector<uint8_t> live(count, 0);
+    std::vector<uint16_t> pending;
+    for (size_t slot = 0; slot < slotCount; slot++) {
+        if (needed[slot]) {
+            pending.insert(pending.end(), writers[slot].begin(), writers[slot].end());
+        }
+    }
+    while (!pending.empty()) {
+        uint16_t index = pending.back();
+        pending.pop_back();
+        if (live[index]) {
+            continue;
+        }
+        live[index] = 1;
+        for (uint16_t slot : logic_blocks[index]->getInputSlots()) {
+            if (!needed[slot]) {
+                needed[slot] = 1;
+                pending.insert(pending.end(), writers[slot].begin(), writers[slot].end());
+            }
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!removed[i] && !live[i]) {
+            removed[i] = 1;
+            optimization.deadBlocks++;
+        }
+    }
+
+    // Folded outputs nobody needs are not set either
+    size_t keptValues = 0;
+    for (const PlcInitAction& value : constantOutputs) {
+        if (needed[value.variable.index]) {
+            constantOutputs[keptValues++] = value;
+        }
+    }
+    constantOutputs.resize(keptValues);
+
+    // Removed blocks are destroyed in place, the arena does not take them back
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (removed[i]) {
+            logic_blocks[i]->~PlcBlock();
+            continue;
+        }
+        logic_blocks[kept] = logic_blocks[i];
+        blockConfigIndex[kept] = blockConfigIndex[i];
+        kept++;
+    }
+    logic_blocks.resize(kept);
+    blockConfigIndex.resize(kept);
+
+    EspHubLog->printf("Program '%s': Optimizer removed %u of %u blocks (%u folded, %u collapsed, %u unobserved)\n",
+                      _name.c_str(), (unsigned)optimization.getRemovedBlocks(), (unsigned)count,
+                      (unsigned)optimization.foldedBlocks, (unsigned)optimization.collapsedBlocks, (unsigned)optimization.deadBlocks);
+}
+
+void PlcProgram::packBitLogic(const std::vector<uint8_t>& blockTask) {
+    // Scalar logic blocks computing the same operation on bits at the same
+    // distances in the same marker words (a_n AND b_n -> q_n for variables
+    // declared one after the other, elements of BOOL arrays) become one
+    // PlcPackedBitBlock at the position of the first of them. A later block
+    // joins only if moving it there changes no value: the blocks it passes
+    // do not write its inputs nor read or write its output, and it does not
+    // read an output of the group.
+    struct Candidate {
+        PlcWordOp op;
+        PlcBitRef a;
+        PlcBitRef b;
+        PlcBitRef out;
+        int8_t shiftB;
+        int8_t shiftOut;
+        uint8_t task;
+    };
+    size_t count = logic_blocks.size();
+    std::vector<Candidate> candidates(count);
+    std::vector<uint8_t> packable(count, 0);
+    for (size_t i = 0; i < count; i++) {
+        PlcBitOp bitOp;
+        if (!logic_blocks[i]->describeBitOp(bitOp)) {
+            continue;
+        }
+        Candidate& c = candidates[i];
+        c.op = bitOp.op;
+        c.a = memory.getBitRef(bitOp.in1);
+        c.b = bitOp.op == PlcWordOp::NOT ? c.a : memory.getBitRef(bitOp.in2);
+        c.out = memory.getBitRef(bitOp.out);
+        c.shiftB = static_cast<int8_t>(c.b.bit() - c.a.bit());
+        c.shiftOut = static_cast<int8_t>(c.out.bit() - c.a.bit());
+        c.task = blockTask.empty() ? 0 : blockTask[blockConfigIndex[i]];
+        packable[i] = c.a.isValid() && c.b.isValid() && c.out.isValid() &&
+                      bitOp.out.index != bitOp.in1.index && bitOp.out.index != bitOp.in2.index;
+    }
+    auto sameWordOp = [](const Candidate& x, const Candidate& y) {
+        return x.op == y.op && x.task == y.task && x.a.word == y.a.word && x.b.word == y.b.word &&
+               x.out.word == y.out.word && x.shiftB == y.shiftB && x.shiftOut == y.shiftOut;
+    };
+
+    size_t slotCount = memory.getVariableCount();
+    std::vector<uint8_t> read(slotCount, 0);     // By the blocks passed
+    std::vector<uint8_t> written(slotCount, 0);
+    std::vector<uint8_t> groupIn(slotCount, 0);  // By the group
+    std::vector<uint8_t> groupOut(slotCount, 0);
+    std::vector<uint16_t> touched;
+    std::vector<uint16_t> members;
+    std::vector<PlcBlock*> packed(count, nullptr); // At the position of the first member
+    std::vector<uint8_t> taken(count, 0);
+    for (size_t p = 0; p < count; p++) {
+        if (!packable[p] || taken[p]) {
+            continue;
+        }
+        members.assign(1, static_cast<uint16_t>(p));
+        auto mark = [&touched](std::vector<uint8_t>& flags, const PlcBlock::SlotList& list) {
+            for (uint16_t slot : list) {
+                flags[slot] = 1;
+                touched.push_back(slot);
+            }
+        };
+        mark(groupIn, logic_blocks[p]->getInputSlots());
+        mark(groupOut, logic_blocks[p]->getOutputSlots());
+        for (size_t q = p + 1; q < count; q++) {
+            if (taken[q]) {
+                continue; // Moved before p by an earlier group
+            }
+            const PlcBlock::SlotList& in = logic_blocks[q]->getInputSlots();
+            const PlcBlock::SlotList& out = logic_blocks[q]->getOutputSlots();
+            bool joins = packable[q] && sameWordOp(candidates[p], candidates[q]);
+            for (uint16_t slot : in) {
+                joins = joins && !written[slot] && !groupOut[slot];
+            }
+            for (uint16_t slot : out) {
+                joins = joins && !read[slot] && !written[slot] && !groupIn[slot] && !groupOut[slot];
+            }
+            if (joins) {
+                members.push_back(static_cast<uint16_t>(q));
+                mark(groupIn, in);
+                mark(groupOut, out);
             } else {
-                EspHubLog->printf("ERROR: Program '%s': Unknown block type '%s'\n", _name.c_str(), type);
-                return false;
+                mark(read, in);
+                mark(written, out);
             }
         }
+        for (uint16_t slot : touched) {
+            read[slot] = written[slot] = groupIn[slot] = groupOut[slot] = 0;
+        }
+        touched.clear();
+        if (members.size() < 2) {
+            continue;
+        }
+
+        const Candidate& c = candidates[p];
+        PlcPackedBitBlock* block = arena.create<PlcPackedBitBlock>(c.op, c.a.word, c.b.word, c.out.word, c.shiftB, c.shiftOut);
+        block->setArena(&arena);
+        for (uint16_t m : members) {
+            block->add(*logic_blocks[m], candidates[m].a.bit());
+            taken[m] = 1;
+        }
+        packed[p] = block;
+        optimization.packedBlocks += members.size();
+        optimization.wordOps++;
+    }
+    if (optimization.wordOps == 0) {
+        return;
     }
 
-    EspHubLog->printf("PLC program '%s' configuration loaded successfully.\n", _name.c_str());
-    return true;
+    // Members are destroyed in place like removed blocks; the word operation
+    // keeps the configuration index of its first member
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (taken[i] && !packed[i]) {
+            logic_blocks[i]->~PlcBlock();
+            continue;
+        }
+        if (packed[i]) {
+            logic_blocks[i]->~PlcBlock();
+            logic_blocks[i] = packed[i];
+        }
+        logic_blocks[kept] = logic_blocks[i];
+        blockConfigIndex[kept] = blockConfigIndex[i];
+        kept++;
+    }
+    logic_blocks.resize(kept);
+    blockConfigIndex.resize(kept);
+
+    EspHubLog->printf("Program '%s': Optimizer packed %u logic blocks into %u word operations\n",
+                      _name.c_str(), (unsigned)optimization.packedBlocks, (unsigned)optimization.wordOps);
+}
+
+bool PlcProgram::resolveTask(const PlcProgramSource& image, JsonVariantConst task, uint8_t& index) const {
+    // Class 0 holds the blocks without "task", class i + 1 the i-th "tasks" entry
+    index = 0;
+    if (task.isNull()) {
+        return true;
+    }
+    const char* name = task.as<const char*>();
+    for (uint8_t i = 0; name && i < image.getTaskCount(); i++) {
+        if (strcmp(image.getTask(i).name, name) == 0) {
+            index = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PlcProgram::buildTasks(const PlcProgramSource& image, const std::vector<uint8_t>& blockTask) {
+    size_t classCount = image.getTaskCount() + 1;
+    std::vector<uint16_t> classBlocks(classCount, 0);
+    for (size_t i = 0; i < logic_blocks.size(); i++) {
+        classBlocks[blockTask[blockConfigIndex[i]]]++;
+    }
+
+    // Classes by period, so the faster ones run first when several are due
+    auto periodOf = [&image](size_t c) { return c == 0 ? image.getCycleTimeMs() : image.getTask(static_cast<uint8_t>(c - 1)).cycleTimeMs; };
+    std::vector<uint8_t> classOrder;
+    for (size_t c = 0; c < classCount; c++) {
+        if (classBlocks[c] > 0) {
+            classOrder.push_back(static_cast<uint8_t>(c));
+        }
+    }
+    std::stable_sort(classOrder.begin(), classOrder.end(), [&periodOf](uint8_t a, uint8_t b) { return periodOf(a) < periodOf(b); });
+
+    // Blocks grouped by class, in data-flow order within each class. A
+    // class reads the outputs of the others as they were last written.
+    std::vector<PlcBlock*> blocks(logic_blocks.begin(), logic_blocks.end());
+    std::vector<uint16_t> configIndex(blockConfigIndex.begin(), blockConfigIndex.end());
+    PlcOverrunPolicy policy = cycleTimer.getOverrunPolicy();
+    uint32_t baseMs = 0;
+    size_t placed = 0;
+    tasks.reserve(classOrder.size());
+    for (uint8_t c : classOrder) {
+        tasks.emplace_back();
+        PlcTaskClass& task = tasks.back();
+        uint32_t cycleTimeMs = periodOf(c);
+        task.name = "default";
+        task.highPriority = false;
+        if (c > 0) {
+            PlcProgramSource::Task entry = image.getTask(static_cast<uint8_t>(c - 1));
+            size_t length = strlen(entry.name) + 1;
+            task.name = static_cast<const char*>(memcpy(arena.allocate(length, 1), entry.name, length));
+            task.highPriority = entry.highPriority;
+        }
+        task.timer.configure(cycleTimeMs, policy);
+        task.firstBlock = static_cast<uint16_t>(placed);
+        for (size_t i = 0; i < blocks.size(); i++) {
+            if (blockTask[configIndex[i]] == c) {
+                logic_blocks[placed] = blocks[i];
+                blockConfigIndex[placed] = configIndex[i];
+                placed++;
+            }
+        }
+        task.endBlock = static_cast<uint16_t>(placed);
+        task.entry = 0;
+
+        // Every class deadline falls on a scan of the program
+        uint32_t a = baseMs, b = cycleTimeMs;
+        while (b != 0) {
+            uint32_t r = a % b;
+            a = b;
+            b = r;
+        }
+        baseMs = a;
+    }
+
+    if (tasks.empty()) {
+        return;
+    }
+    cycleTimer.configure(baseMs, policy);
+    EspHubLog->printf("Program '%s': %u task classes, scanned every %u ms\n", _name.c_str(), (unsigned)tasks.size(), (unsigned)baseMs);
+    for (const PlcTaskClass& task : tasks) {
+        EspHubLog->printf("Program '%s': Task '%s' every %u ms%s, %u blocks\n", _name.c_str(), task.name,
+                          (unsigned)task.timer.getCycleTimeMs(), task.highPriority ? " (high priority)" : "",
+                          (unsigned)(task.endBlock - task.firstBlock));
+    }
+}
+
+bool PlcProgram::hasHighPriorityTask() const {
+    for (const PlcTaskClass& task : tasks) {
+        if (task.highPriority) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PlcProgram::startCycles(uint32_t nowUs) {
+    cycleTimer.start(nowUs);
+    for (PlcTaskClass& task : tasks) {
+        task.timer.start(nowUs);
+    }
+}
+
+void PlcProgram::resumeCycles(uint32_t nowUs) {
+    cycleTimer.resume(nowUs);
+    for (PlcTaskClass& task : tasks) {
+        task.timer.resume(nowUs);
+    }
+}
+
+void PlcTaskClass::toJson(JsonObject obj) const {
+    obj["name"] = name;
+    obj["cycle_time_ms"] = timer.getCycleTimeMs();
+    obj["priority"] = highPriority ? "high" : "normal";
+    obj["blocks"] = endBlock - firstBlock;
+    timer.getStats().toJson(obj);
+}
+
+const char* PlcProgram::getBlockType(size_t index) const {
+    return blockTypes[blockConfigIndex[index]];
+}
+
+const char* PlcProgram::getBlockId(size_t index) const {
+    return blockIds[blockConfigIndex[index]];
+}
+
+void PlcOptimization::toJson(JsonObject obj) const {
+    obj["removed_blocks"] = getRemovedBlocks();
+    obj["folded_blocks"] = foldedBlocks;
+    obj["collapsed_blocks"] = collapsedBlocks;
+    obj["dead_blocks"] = deadBlocks;
+    obj["packed_blocks"] = packedBlocks;
+    obj["word_ops"] = wordOps;
+}
+
+void PlcOnlineChange::toJson(JsonObject obj) const {
+    obj["carried_variables"] = carriedVariables;
+    obj["migrated_blocks"] = migratedBlocks;
+    obj["new_blocks"] = newBlocks;
+    obj["dropped_blocks"] = droppedBlocks;
+    obj["swap_latency_us"] = swapLatencyUs;
+}
+
+namespace {
+
+// Block identity across program versions: the configured id, otherwise the
+// type and the position among the blocks of that type
+std::string blockKey(const char* id, const char* type, std::map<const char*, uint16_t>& ordinals) {
+    if (id) {
+        return std::string("id:") + id;
+    }
+    return std::string(type) + "#" + std::to_string(ordinals[type]++);
+}
+
+} // namespace
+
+void PlcProgram::prepareTakeOver(const PlcProgram& previous) {
+    onlineChange = PlcOnlineChange();
+    memory.matchSlots(previous.memory, takeOverSlots);
+    onlineChange.carriedVariables = static_cast<uint16_t>(takeOverSlots.size());
+
+    // Previous blocks by key, in configuration order so ordinals are stable.
+    // Blocks removed by the optimizer keep their ordinal but have no match.
+    size_t previousCount = previous.logic_blocks.size();
+    std::vector<const PlcBlock*> previousByConfig(previous.blockTypes.size(), nullptr);
+    for (size_t i = 0; i < previousCount; i++) {
+        previousByConfig[previous.blockConfigIndex[i]] = previous.logic_blocks[i];
+    }
+    std::map<std::string, uint16_t> previousKeys;
+    std::map<const char*, uint16_t> ordinals; // Registry type names, compared by pointer
+    for (size_t i = 0; i < previousByConfig.size(); i++) {
+        std::string key = blockKey(previous.blockIds[i], previous.blockTypes[i], ordinals);
+        if (previousByConfig[i]) {
+            previousKeys[key] = static_cast<uint16_t>(i);
+        }
+    }
+
+    std::vector<PlcBlock*> byConfig(blockTypes.size(), nullptr);
+    for (size_t i = 0; i < logic_blocks.size(); i++) {
+        byConfig[blockConfigIndex[i]] = logic_blocks[i];
+    }
+    ordinals.clear();
+    takeOverBlocks.clear();
+    for (size_t i = 0; i < byConfig.size(); i++) {
+        auto match = previousKeys.find(blockKey(blockIds[i], blockTypes[i], ordinals));
+        if (byConfig[i] && match != previousKeys.end() && previous.blockTypes[match->second] == blockTypes[i]) {
+            takeOverBlocks.emplace_back(byConfig[i], previousByConfig[match->second]);
+        }
+    }
+    onlineChange.migratedBlocks = static_cast<uint16_t>(takeOverBlocks.size());
+    onlineChange.newBlocks = static_cast<uint16_t>(logic_blocks.size() - takeOverBlocks.size());
+    onlineChange.droppedBlocks = static_cast<uint16_t>(previousCount - takeOverBlocks.size());
+}
+
+void PlcProgram::takeOver(PlcProgram& previous) {
+    // Writes posted to the previous version since its last scan are carried too
+    previous.memory.applyInputImage();
+    if (previous.currentState != PlcProgramState::STOPPED) {
+        applyInitActions(); // Variables new in this version; carried values overwrite the rest
+    }
+    memory.copySlots(previous.memory, takeOverSlots);
+    applyValues(constantOutputs); // Folded from this version's constants
+    timers.syncTo(previous.timers); // Running timers keep their deadlines
+    cycleContext = previous.cycleContext; // And the scan count and time base
+    for (auto& pair : takeOverBlocks) {
+        pair.first->migrateState(*pair.second);
+    }
+    std::vector<std::pair<uint16_t, uint16_t>>().swap(takeOverSlots);
+    std::vector<std::pair<PlcBlock*, const PlcBlock*>>().swap(takeOverBlocks);
+
+    cycleTimer.continueFrom(previous.cycleTimer);
+    for (PlcTaskClass& task : tasks) {
+        // A class of the previous version with the same name keeps its deadline
+        const PlcCycleTimer* from = &previous.cycleTimer;
+        for (const PlcTaskClass& old : previous.tasks) {
+            if (strcmp(old.name, task.name) == 0) {
+                from = &old.timer;
+            }
+        }
+        task.timer.continueFrom(*from);
+    }
+    if (executionMode == PlcExecutionMode::INCREMENTAL) {
+        memory.clearChangedSlots();
+        blockPending.assign(logic_blocks.size(), 1);
+    }
+    memory.publishOutputImage();
+    currentState = previous.currentState;
+}
+
+void PlcProgram::buildChangePropagation() {
+    size_t slotCount = memory.getVariableCount();
+
+    readerOffsets.assign(slotCount + 1, 0);
+    for (auto& block : logic_blocks) {
+        for (uint16_t slot : block->getInputSlots()) {
+            readerOffsets[slot + 1]++;
+        }
+    }
+    for (size_t i = 0; i < slotCount; i++) {
+        readerOffsets[i + 1] += readerOffsets[i];
+    }
+
+    readerBlocks.assign(readerOffsets[slotCount], 0);
+    std::vector<uint16_t> fill(readerOffsets.begin(), readerOffsets.end() - 1);
+    for (size_t i = 0; i < logic_blocks.size(); i++) {
+        for (uint16_t slot : logic_blocks[i]->getInputSlots()) {
+            readerBlocks[fill[slot]++] = static_cast<uint16_t>(i);
+        }
+        if (PlcTimer* timer = logic_blocks[i]->getTimer()) {
+            timer->setBlock(static_cast<uint16_t>(i));
+        }
+    }
+    timers.setExpiryHandler(wakeTimerBlock, this);
+
+    // The first scan evaluates everything
+    blockPending.assign(logic_blocks.size(), 1);
+
+    EspHubLog->printf("Program '%s': Incremental execution, %u of %u blocks always live\n",
+                      _name.c_str(), (unsigned)liveBlocks.size(), (unsigned)logic_blocks.size());
+}
+
+void PlcProgram::propagateChanges() {
+    const std::vector<uint16_t>& changed = memory.getChangedSlots();
+    if (changed.empty()) {
+        return;
+    }
+    size_t slotCount = readerOffsets.empty() ? 0 : readerOffsets.size() - 1;
+    for (uint16_t slot : changed) {
+        if (slot >= slotCount) {
+            continue; // Declared after the program was loaded, no block reads it
+        }
+        for (uint16_t i = readerOffsets[slot]; i < readerOffsets[slot + 1]; i++) {
+            blockPending[readerBlocks[i]] = 1;
+        }
+    }
+    memory.clearChangedSlots();
+}
+
+void PlcProgram::wakeTimerBlock(void* context, PlcTimer& timer) {
+    PlcProgram* program = static_cast<PlcProgram*>(context);
+    if (timer.getBlock() < program->blockPending.size()) {
+        program->blockPending[timer.getBlock()] = 1;
+    }
+}
+
+bool PlcProgram::needsScan() const {
+    for (uint16_t index : liveBlocks) {
+        if (logic_blocks[index]->needsScan()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t PlcProgram::evaluateIncremental(size_t first, size_t end) {
+    // Variables written outside the scan (web, MQTT, IO sync)
+    propagateChanges();
+    for (uint16_t index : liveBlocks) {
+        blockPending[index] = 1;
+    }
+
+    // Blocks are in data-flow order, so a change reaches its readers in the
+    // same scan. Readers placed earlier (loops, self feedback) run next scan,
+    // readers in another task class when that class is due.
+    size_t evaluated = 0;
+    for (size_t i = first; i < end; i++) {
+        if (!blockPending[i]) {
+            continue;
+        }
+        blockPending[i] = 0;
+#ifdef PLC_PROFILING
+        uint32_t start = PlcProfiler::readCounter();
+        logic_blocks[i]->evaluate(memory);
+        profiler.recordBlock(i, PlcProfiler::readCounter() - start);
+#else
+        logic_blocks[i]->evaluate(memory);
+#endif
+        evaluated++;
+        propagateChanges();
+    }
+    return evaluated;
 }
 
 void PlcProgram::run() {
@@ -213,7 +1027,14 @@ void PlcProgram::run() {
     }
     
     executeInitBlock();
+    memory.begin(); // Retentive values saved before override the INIT values
+    applyValues(constantOutputs);
+    memory.publishOutputImage(); // Readers see the initial values before the first scan
+    if (executionMode == PlcExecutionMode::INCREMENTAL) {
+        blockPending.assign(logic_blocks.size(), 1);
+    }
 
+    parked = false;
     currentState = PlcProgramState::RUNNING;
     EspHubLog->printf("PLC program '%s' started.\n", _name.c_str());
 }
@@ -240,31 +1061,105 @@ void PlcProgram::evaluate() {
     if (currentState != PlcProgramState::RUNNING) {
         return;
     }
-    for (auto& block : logic_blocks) {
-        block->evaluate(memory);
+#ifdef PLC_PROFILING
+    uint32_t scanStart = PlcProfiler::readCounter();
+#endif
+    if (tasks.empty()) {
+        lastEvaluatedBlocks = evaluateBlocks(0, logic_blocks.size(), 0);
+    } else {
+        size_t evaluated = 0;
+        for (const PlcTaskClass& task : tasks) {
+            evaluated += evaluateBlocks(task.firstBlock, task.endBlock, task.entry);
+        }
+        lastEvaluatedBlocks = evaluated;
+    }
+#ifdef PLC_PROFILING
+    profiler.recordProgram(PlcProfiler::readCounter() - scanStart);
+#endif
+}
+
+void PlcProgram::evaluateTask(size_t index) {
+    if (currentState != PlcProgramState::RUNNING) {
+        return;
+    }
+#ifdef PLC_PROFILING
+    uint32_t scanStart = PlcProfiler::readCounter();
+#endif
+    const PlcTaskClass& task = tasks[index];
+    lastEvaluatedBlocks = evaluateBlocks(task.firstBlock, task.endBlock, task.entry);
+#ifdef PLC_PROFILING
+    profiler.recordProgram(PlcProfiler::readCounter() - scanStart);
+#endif
+}
+
+size_t PlcProgram::evaluateBlocks(size_t first, size_t end, uint32_t entry) {
+    if (executionMode == PlcExecutionMode::INCREMENTAL) {
+        return evaluateIncremental(first, end);
+    }
+    if (engine == PlcExecutionEngine::BYTECODE) {
+#ifdef PLC_PROFILING
+        bytecode.execute(memory, &profiler, entry);
+#else
+        bytecode.execute(memory, entry);
+#endif
+        return end - first;
+    }
+    for (size_t i = first; i < end; i++) {
+#ifdef PLC_PROFILING
+        uint32_t start = PlcProfiler::readCounter();
+        logic_blocks[i]->evaluate(memory);
+        profiler.recordBlock(i, PlcProfiler::readCounter() - start);
+#else
+        logic_blocks[i]->evaluate(memory);
+#endif
+    }
+    return end - first;
+}
+
+#ifdef PLC_PROFILING
+void PlcProgram::getProfile(JsonObject out) const {
+    out["program"] = _name;
+    out["engine"] = executionMode == PlcExecutionMode::INCREMENTAL ? "incremental"
+                  : engine == PlcExecutionEngine::BYTECODE ? "bytecode" : "blocks";
+    out["ticks_per_us"] = PlcProfiler::ticksPerMicrosecond();
+    out["histogram_min_log2"] = PlcTimingProfile::HISTOGRAM_MIN_LOG2;
+    profiler.getProgram().toJson(out["total"].to<JsonObject>());
+
+    JsonArray blocks = out["blocks"].to<JsonArray>();
+    for (size_t i = 0; i < profiler.getBlockCount(); i++) {
+        JsonObject entry = blocks.add<JsonObject>();
+        entry["index"] = blockConfigIndex[i];
+        entry["type"] = getBlockType(i);
+        profiler.getBlock(i).toJson(entry);
     }
 }
+#endif
 
 void PlcProgram::executeInitBlock() {
-    if (config.containsKey("init")) {
-        EspHubLog->printf("Program '%s': Executing INIT block...\n", _name.c_str());
-        JsonArray init_block = config["init"].as<JsonArray>();
-        for (JsonObject action : init_block) {
-            const char* action_type = action["action"];
-            if (strcmp(action_type, "set_value") == 0) {
-                const char* var_name = action["variable"];
-                
-                if (action["value"].is<bool>()) {
-                    memory.setValue<bool>(var_name, action["value"].as<bool>());
-                } else if (action["value"].is<float>()) {
-                    memory.setValue<float>(var_name, action["value"].as<float>());
-                } else if (action["value"].is<int>()) {
-                    memory.setValue<int16_t>(var_name, action["value"].as<int>());
-                }
-                // Add other types as needed
-                
-                EspHubLog->printf("Program '%s': INIT: Set %s\n", _name.c_str(), var_name);
-            }
+    if (initActions.empty()) {
+        return;
+    }
+    EspHubLog->printf("Program '%s': Executing INIT block...\n", _name.c_str());
+    applyInitActions();
+    for (const PlcInitAction& action : initActions) {
+        EspHubLog->printf("Program '%s': INIT: Set %s\n", _name.c_str(), memory.getVariableName(action.variable));
+    }
+}
+
+void PlcProgram::applyValues(const PlcArenaVector<PlcInitAction>& actions) {
+    for (const PlcInitAction& action : actions) {
+        PlcValueUnion value;
+        value.ui32Val = action.value;
+        if (action.type == PlcValueType::BOOL) {
+            memory.setValue<bool>(action.variable, value.bVal);
+        } else if (action.type == PlcValueType::REAL) {
+            memory.setValue<float>(action.variable, value.fVal);
+        } else if (action.type == PlcValueType::INT) {
+            memory.setValue<int16_t>(action.variable, value.i16Val);
+        } else if (action.type == PlcValueType::BYTE) {
+            memory.setValue<uint8_t>(action.variable, value.ui8Val);
+        } else if (action.type == PlcValueType::DINT) {
+            memory.setValue<int32_t>(action.variable, static_cast<int32_t>(value.ui32Val));
         }
     }
 }
@@ -279,11 +1174,15 @@ size_t PlcProgram::getEstimatedMemoryUsage() const {
     // Memory for the program name
     total += _name.length();
 
-    // Memory for blocks (estimate ~200 bytes per block)
-    total += logic_blocks.size() * 200;
+    // Blocks, their handle lists, the block tables and the variable name index
+    total += arena.getCapacity();
+
+    // Memory for compiled bytecode
+    total += bytecode.getMemoryUsage();
 
-    // Memory for JSON config
-    total += config.memoryUsage();
+#ifdef PLC_PROFILING
+    total += profiler.getMemoryUsage();
+#endif
 
     // Memory for PlcMemory variables
     total += memory.getMemoryUsage();
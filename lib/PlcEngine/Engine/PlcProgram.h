@@ -7,8 +7,15 @@
 #include <memory>
 #include "../PlcEngine/Engine/PlcMemory.h"
 #include "../Blocks/PlcBlock.h"
+#include "../PlcEngine/Engine/PlcBytecode.h"
+#include "../PlcEngine/Engine/PlcCycleTimer.h"
+#include "../PlcEngine/Engine/PlcProgramImage.h"
+#include "../PlcEngine/Engine/PlcProgramLoader.h"
+#include "../PlcEngine/Engine/PlcArena.h"
+#include "../PlcEngine/Engine/PlcTimerWheel.h"
+#include "../PlcEngine/Engine/PlcCycleContext.h"
 #include "../../Core/TimeManager.h" // For scheduler blocks
-#include "../../Protocols/Mesh/MeshDeviceManager.h" // For sending commands to mesh devices
+class MeshDeviceManager; // Forward declaration (used for sending commands to mesh devices)
 
 enum class PlcProgramState {
     STOPPED,
@@ -16,34 +23,224 @@ enum class PlcProgramState {
     PAUSED
 };
 
+enum class PlcExecutionEngine {
+    BLOCKS,     // Virtual evaluate() per block
+    BYTECODE    // Compiled bytecode, falls back to evaluate() for blocks without lower()
+};
+
+enum class PlcExecutionMode {
+    CYCLIC,     // Evaluate every block on every scan
+    INCREMENTAL // Evaluate only blocks downstream of changed variables (and always-live blocks)
+};
+
+// Result of an online change, see PlcProgram::prepareTakeOver()
+struct PlcOnlineChange {
+    uint16_t carriedVariables;  // Same name and type in both versions, value kept
+    uint16_t migratedBlocks;    // Matched to a block of the previous version, state kept
+    uint16_t newBlocks;         // No match, start from their initial state
+    uint16_t droppedBlocks;     // Blocks of the previous version without a match
+    uint32_t swapLatencyUs;     // Time spent between two scans on the swap
+
+    PlcOnlineChange() : carriedVariables(0), migratedBlocks(0), newBlocks(0), droppedBlocks(0), swapLatencyUs(0) {}
+    void toJson(JsonObject obj) const;
+};
+
+// Blocks removed by the load-time optimizer ("optimize": true), see
+// PlcProgram::optimizeBlocks() and PlcProgram::packBitLogic()
+struct PlcOptimization {
+    uint16_t foldedBlocks;      // Constant inputs only, outputs set once when the program starts
+    uint16_t collapsedBlocks;   // Conversions merged into the conversion feeding them
+    uint16_t deadBlocks;        // No output observed
+    uint16_t packedBlocks;      // Scalar logic blocks now evaluated by a word operation
+    uint16_t wordOps;           // The word operations evaluating them
+
+    PlcOptimization() : foldedBlocks(0), collapsedBlocks(0), deadBlocks(0), packedBlocks(0), wordOps(0) {}
+    uint16_t getRemovedBlocks() const { return foldedBlocks + collapsedBlocks + deadBlocks + packedBlocks - wordOps; }
+    void toJson(JsonObject obj) const;
+};
+
+// Task class of a multi-rate program ("tasks"). The blocks of a class are
+// evaluated together at its own period; see PlcProgram::getTaskCount().
+struct PlcTaskClass {
+    const char* name;       // "tasks" key, "default" for the blocks without "task"
+    PlcCycleTimer timer;    // Period, deadline and statistics of the class
+    bool highPriority;      // "priority": "high"
+    uint16_t firstBlock;    // Blocks [firstBlock, endBlock) in evaluation order
+    uint16_t endBlock;
+    uint32_t entry;         // First instruction of the class in the bytecode
+
+    void toJson(JsonObject obj) const;
+};
+
 class PlcProgram {
 public:
     PlcProgram(const String& name, TimeManager* timeManager, MeshDeviceManager* meshDeviceManager);
-    bool loadConfiguration(const char* jsonConfig);
+    ~PlcProgram();
+    PlcProgram(const PlcProgram&) = delete;
+    PlcProgram& operator=(const PlcProgram&) = delete;
+    bool loadConfiguration(const char* jsonConfig); // Compiles to a program image and loads it
+    bool loadConfigurationStream(PlcProgramLoader::ReadFunction read); // Same, reading the JSON in chunks
+    bool loadImage(const uint8_t* data, size_t size); // See PlcProgramImage; not referenced after loading
     void run();
     void pause();
     void stop();
     PlcProgramState getState() const { return currentState; }
     const String& getName() const { return _name; }
 
-    void evaluate(); // Called by PlcEngine
+    void evaluate(); // Called by PlcEngine; evaluates every task class
+    // Deliver the timer expiries due at the start of a cycle, from the
+    // cycle's clock reading (PlcClock microseconds). Called by PlcEngine;
+    // returns true if a timer expired.
+    bool advanceTimers(uint32_t nowUs) { return timers.advanceMicros(nowUs) > 0; }
+    const PlcTimerWheel& getTimers() const { return timers; }
+    // Time and count of the current scan, started by PlcEngine with the
+    // same clock reading as advanceTimers()
+    PlcCycleContext& getCycleContext() { return cycleContext; }
+
+    // Tickless mode: PlcEngine parks the program after a scan that changed
+    // nothing while no block needs the next one (see PlcBlock::needsScan()),
+    // and scans it again on an input, a timer expiry or a wake-up
+    bool needsScan() const;
+    bool isParked() const { return parked; }
+    void setParked(bool value) { parked = value; }
     PlcMemory& getMemory() { return memory; } // Expose PlcMemory for external access
+    PlcExecutionEngine getExecutionEngine() const { return engine; }
+    PlcExecutionMode getExecutionMode() const { return executionMode; }
+    const PlcBytecode& getBytecode() const { return bytecode; }
+    size_t getLastEvaluatedBlockCount() const { return lastEvaluatedBlocks; }
+    PlcCycleTimer& getCycleTimer() { return cycleTimer; } // Deadline and cycle statistics, driven by PlcEngine
+
+    // Multi-rate programs: blocks name a task class of "tasks" in "task",
+    // the others are in the "default" class at cycle_time_ms. The program
+    // is scanned at the greatest common divisor of the class periods, and
+    // PlcEngine evaluates the classes that are due with evaluateTask().
+    // Classes without blocks are dropped. Programs without "tasks" have no
+    // task classes and are evaluated as a whole at cycle_time_ms.
+    size_t getTaskCount() const { return tasks.size(); }
+    PlcTaskClass& getTask(size_t index) { return tasks[index]; }
+    const PlcTaskClass& getTask(size_t index) const { return tasks[index]; }
+    void evaluateTask(size_t index);
+    bool hasHighPriorityTask() const;
+    // Start, or after being parked resume, the program and task class timers
+    void startCycles(uint32_t nowUs);
+    void resumeCycles(uint32_t nowUs);
+    size_t getLoadBytesPeak() const { return loadBytesPeak; } // Peak heap of the last JSON load (0 for images)
+
+    // Placement on the engine's workers: "core" and "partition" of the
+    // program, and the worker PlcEngine assigned to it
+    uint8_t getCore() const { return core; }            // PlcProgramImage::CORE_ANY if not pinned
+    uint8_t getPartition() const { return partition; }  // 0: automatic
+    uint8_t getWorker() const { return worker; }
+    void setWorker(uint8_t index) { worker = index; }
+
+    // Blocks in evaluation order; getBlockConfigIndex() maps them back to
+    // their position in the "logic" array of the configuration. Blocks the
+    // optimizer removed have no index.
+    size_t getBlockCount() const { return logic_blocks.size(); }
+    uint16_t getBlockConfigIndex(size_t index) const { return blockConfigIndex[index]; }
+    const char* getBlockType(size_t index) const;
+    const char* getBlockId(size_t index) const; // "id" of the block configuration, nullptr if it has none
+    const PlcOptimization& getOptimization() const { return optimization; }
+
+    // Online change. prepareTakeOver() runs on a freshly loaded program while
+    // the previous version keeps scanning: variables are matched by name and
+    // type, blocks by id (or by type and position among the blocks of that
+    // type when they have no id). takeOver() runs between two scans and
+    // copies the matched values and block state, so the program continues
+    // where the previous version stopped.
+    void prepareTakeOver(const PlcProgram& previous);
+    void takeOver(PlcProgram& previous);
+    const PlcOnlineChange& getOnlineChange() const { return onlineChange; }
+
+#ifdef PLC_PROFILING
+    const PlcProfiler& getProfiler() const { return profiler; }
+    void resetProfile() { profiler.reset(); }
+    void getProfile(JsonObject out) const;
+#endif
 
     // Memory management
+    const PlcArena& getArena() const { return arena; } // Blocks, handle lists, block tables and the name index
     size_t getEstimatedMemoryUsage() const;
     bool validateMemoryAvailable(size_t requiredBytes) const;
 
 private:
     String _name;
+    PlcArena arena; // Declared first, so it is released last
     PlcMemory memory;
-    std::vector<std::unique_ptr<PlcBlock>> logic_blocks;
-    StaticJsonDocument<4096> config; // Max 4KB for PLC config
+    PlcTimerWheel timers;   // Armed by the timer and sequencer blocks
+    PlcCycleContext cycleContext; // Read by the blocks through PlcBlock::cycle
+    PlcArenaVector<PlcBlock*> logic_blocks; // Constructed in the arena
+    PlcArenaVector<uint16_t> blockConfigIndex;
+    PlcBytecode bytecode;
+    PlcExecutionEngine engine;
+    PlcExecutionMode executionMode;
+    size_t lastEvaluatedBlocks;
+    size_t loadBytesPeak;
+    PlcCycleTimer cycleTimer;
+    uint8_t core;
+    uint8_t partition;
+    uint8_t worker;
+    bool parked;
+#ifdef PLC_PROFILING
+    PlcProfiler profiler;
+#endif
+
+    // Incremental execution: blocks reading each slot (CSR layout, indexed
+    // by slot) and pending flag per block. The always-live blocks are
+    // listed in every mode, tickless mode asks them needsScan().
+    PlcArenaVector<uint16_t> readerOffsets;
+    PlcArenaVector<uint16_t> readerBlocks;
+    PlcArenaVector<uint8_t> blockPending;
+    PlcArenaVector<uint16_t> liveBlocks;
+    PlcArenaVector<PlcTaskClass> tasks;
+
+    // Block type (registry name) per configuration index and INIT actions resolved to slots
+    struct PlcInitAction {
+        VarHandle variable;
+        PlcValueType type;  // BOOL, BYTE, INT, DINT or REAL
+        uint32_t value;     // Raw PlcValueUnion bits
+    };
+    PlcArenaVector<const char*> blockTypes;
+    PlcArenaVector<const char*> blockIds;   // Copied into the arena
+    PlcArenaVector<PlcInitAction> initActions;
+    // Outputs of the folded blocks, set after the INIT actions and the
+    // retentive values, and again after an online change
+    PlcArenaVector<PlcInitAction> constantOutputs;
+    PlcOptimization optimization;
+
+    // Matches found by prepareTakeOver(), freed by takeOver()
+    std::vector<std::pair<uint16_t, uint16_t>> takeOverSlots;
+    std::vector<std::pair<PlcBlock*, const PlcBlock*>> takeOverBlocks;
+    PlcOnlineChange onlineChange;
+
     PlcProgramState currentState;
     uint32_t watchdog_timeout_ms;
     TimeManager* _timeManager;
     MeshDeviceManager* _meshDeviceManager;
 
     void executeInitBlock();
+    void applyInitActions() { applyValues(initActions); }
+    void applyValues(const PlcArenaVector<PlcInitAction>& actions);
+    // Arena estimate per block beyond the block itself: handle and slot
+    // lists, and the input readers of incremental programs
+    static constexpr size_t ARENA_LIST_BYTES_PER_BLOCK = 64;
+    static constexpr size_t ARENA_READERS_PER_BLOCK = 4;
+    static constexpr size_t ARENA_ID_BYTES_PER_BLOCK = 16;
+
+    bool loadSource(const PlcProgramSource& image);
+    void releaseProgram();
+    size_t estimateArenaSize(const PlcProgramSource& image) const;
+    void compileBytecode();
+    void sortBlocksByDataFlow();
+    void optimizeBlocks(const PlcProgramSource& image);
+    void packBitLogic(const std::vector<uint8_t>& blockTask);
+    bool resolveTask(const PlcProgramSource& image, JsonVariantConst task, uint8_t& index) const;
+    void buildTasks(const PlcProgramSource& image, const std::vector<uint8_t>& blockTask);
+    size_t evaluateBlocks(size_t first, size_t end, uint32_t entry);
+    void buildChangePropagation();
+    void propagateChanges();
+    size_t evaluateIncremental(size_t first, size_t end);
+    static void wakeTimerBlock(void* context, PlcTimer& timer);
 };
 
 #endif // PLC_PROGRAM_H
\ No newline at end of file
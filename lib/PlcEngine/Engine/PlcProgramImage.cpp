@@ -0,0 +1,857 @@
+#include "../PlcEngine/Engine/PlcProgramImage.h"
+#include "../PlcEngine/Engine/PlcCycleTimer.h"
+#include "../PlcEngine/Engine/PlcProgramLoader.h"
+#include "../PlcEngine/Engine/PlcStructuredText.h"
+#include <StreamLogger.h>
+#include <algorithm>
+#ifndef UNIT_TEST
+#include <esp_partition.h>
+#endif
+
+extern StreamLogger* EspHubLog;
+
+namespace {
+
+const uint8_t MAGIC[4] = {'P', 'L', 'C', 'I'};
+
+inline uint16_t read16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t read32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void put16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(v & 0xFF);
+    out.push_back(v >> 8);
+}
+
+inline void put32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((v >> (8 * i)) & 0xFF);
+    }
+}
+
+inline void patch32(std::vector<uint8_t>& out, size_t at, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out[at + i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+// JSON type names, indexed by PlcValueType
+const char* const TYPE_NAMES[] = {"bool", "byte", "int", "dint", "real", "string"};
+
+bool parseValueType(const String& name, PlcValueType& type) {
+    for (uint8_t i = 0; i <= static_cast<uint8_t>(PlcValueType::STRING_TYPE); i++) {
+        if (name == TYPE_NAMES[i]) {
+            type = static_cast<PlcValueType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// "array[16] of real", in any case and spacing. Returns false if the name
+// is not an array type; length is 0 for an invalid length or element type.
+bool parseArrayType(const String& name, PlcValueType& type, uint16_t& length) {
+    String lower = name;
+    lower.toLowerCase();
+    unsigned count = 0;
+    char element[8] = {0};
+    int end = 0;
+    if (sscanf(lower.c_str(), " array [ %u ] of %7s %n", &count, element, &end) != 2) {
+        return false;
+    }
+    length = 0;
+    if (static_cast<size_t>(end) == lower.length() && count > 0 && count <= PLC_MAX_ARRAY_LENGTH &&
+        parseValueType(element, type) && type != PlcValueType::BYTE && type != PlcValueType::STRING_TYPE) {
+        length = static_cast<uint16_t>(count);
+    }
+    return true;
+}
+
+} // namespace
+
+uint32_t PlcProgramImage::crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+const char* PlcProgramImage::typeName(PlcValueType type) {
+    uint8_t index = static_cast<uint8_t>(type);
+    return index <= static_cast<uint8_t>(PlcValueType::STRING_TYPE) ? TYPE_NAMES[index] : "?";
+}
+
+// ========== Compiler ==========
+
+uint32_t PlcImageBuilder::StringTable::hash(const char* s) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (; *s; s++) {
+        h = (h ^ static_cast<uint8_t>(*s)) * 16777619u;
+    }
+    return h;
+}
+
+void PlcImageBuilder::StringTable::grow() {
+    // Rebuild the index at twice the size, keeping it at most half full
+    std::vector<uint16_t> old;
+    old.swap(index);
+    index.assign(old.empty() ? 16 : old.size() * 2, 0);
+    size_t mask = index.size() - 1;
+    for (uint16_t offset : old) {
+        if (offset != 0) {
+            size_t slot = hash(data.data() + offset) & mask;
+            while (index[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            index[slot] = offset;
+        }
+    }
+}
+
+bool PlcImageBuilder::StringTable::find(const char* s, uint16_t& offset) const {
+    if (s == nullptr || s[0] == '\0') {
+        offset = 0;
+        return true;
+    }
+    if (index.empty()) {
+        return false;
+    }
+    size_t mask = index.size() - 1;
+    for (size_t slot = hash(s) & mask; index[slot] != 0; slot = (slot + 1) & mask) {
+        if (strcmp(data.data() + index[slot], s) == 0) {
+            offset = index[slot];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PlcImageBuilder::StringTable::add(const char* s, uint16_t& offset) {
+    if (find(s, offset)) {
+        return true;
+    }
+    size_t length = strlen(s);
+    if (data.size() + length + 1 > 0xFFFF) {
+        return false;
+    }
+    if ((count + 1) * 2 > index.size()) {
+        grow();
+    }
+    offset = static_cast<uint16_t>(data.size());
+    data.insert(data.end(), s, s + length + 1);
+    size_t mask = index.size() - 1;
+    size_t slot = hash(s) & mask;
+    while (index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    index[slot] = offset;
+    count++;
+    return true;
+}
+
+void PlcImageBuilder::StringTable::release() {
+    std::vector<char>(1, '\0').swap(data);
+    std::vector<uint16_t>().swap(index);
+    count = 0;
+}
+
+bool PlcProgramImage::compile(const char* jsonConfig, const String& programName, std::vector<uint8_t>& image) {
+    PlcProgramLoader loader(programName);
+    return loader.load(jsonConfig, strlen(jsonConfig), image);
+}
+
+PlcImageBuilder::PlcImageBuilder(const String& programName)
+    : _name(programName), cycleTimeMs(PlcCycleTimer::DEFAULT_CYCLE_TIME_MS), watchdogTimeoutMs(5000),
+      engine(PlcProgramImage::ENGINE_BYTECODE), execution(PlcProgramImage::EXECUTION_CYCLIC), overrun(PlcProgramImage::OVERRUN_SKIP),
+      retentiveCommitS(0), core(PlcProgramImage::CORE_ANY), partition(0), optimize(false), strictTypes(false), structuredText(false), maxIterations(0), configSize(0), variableCount(0), blockCount(0), initCount(0), ioPointCount(0), peakMemoryUsage(0) {
+}
+
+bool PlcImageBuilder::setSetting(const char* key, JsonVariantConst value) {
+    const char* name = _name.c_str();
+
+    if (strcmp(key, "watchdog_timeout_ms") == 0) {
+        watchdogTimeoutMs = value | 5000;
+    } else if (strcmp(key, "cycle_time_ms") == 0) {
+        // Cycle time and overrun policy: "skip" (default) or "catch_up"
+        uint32_t cycle_time_ms = value | PlcCycleTimer::DEFAULT_CYCLE_TIME_MS;
+        if (cycle_time_ms == 0 || cycle_time_ms > PlcProgramImage::MAX_CYCLE_TIME_MS) {
+            EspHubLog->printf("ERROR: Program '%s': cycle_time_ms must be between 1 and %u, got %u\n", name,
+                              (unsigned)PlcProgramImage::MAX_CYCLE_TIME_MS, cycle_time_ms);
+            return false;
+        }
+        cycleTimeMs = cycle_time_ms;
+    } else if (strcmp(key, "retentive_commit_s") == 0) {
+        // How often changed retentive variables are written to flash
+        uint32_t commit_s = value | 0;
+        if (commit_s > 65535) {
+            EspHubLog->printf("ERROR: Program '%s': retentive_commit_s must be at most 65535, got %u\n", name, commit_s);
+            return false;
+        }
+        retentiveCommitS = static_cast<uint16_t>(commit_s);
+    } else if (strcmp(key, "core") == 0) {
+        // CPU core of the worker that scans the program, "any" by default
+        if (value.is<const char*>() && strcmp(value.as<const char*>(), "any") == 0) {
+            core = PlcProgramImage::CORE_ANY;
+        } else if (value.is<int>() && value.as<int>() >= 0 && value.as<int>() <= PlcProgramImage::MAX_CORE) {
+            core = static_cast<uint8_t>(value.as<int>());
+        } else {
+            EspHubLog->printf("ERROR: Program '%s': core must be \"any\" or between 0 and %u\n", name, PlcProgramImage::MAX_CORE);
+            return false;
+        }
+    } else if (strcmp(key, "partition") == 0) {
+        // Programs in the same partition are scanned by the same worker
+        int partition_number = value | 0;
+        if (partition_number < 0 || partition_number > PlcProgramImage::MAX_PARTITION) {
+            EspHubLog->printf("ERROR: Program '%s': partition must be between 0 and %u, got %d\n", name, PlcProgramImage::MAX_PARTITION, partition_number);
+            return false;
+        }
+        partition = static_cast<uint8_t>(partition_number);
+    } else if (strcmp(key, "overrun") == 0) {
+        const char* overrun_str = value | "skip";
+        if (strcmp(overrun_str, "skip") == 0) {
+            overrun = PlcProgramImage::OVERRUN_SKIP;
+        } else if (strcmp(overrun_str, "catch_up") == 0) {
+            overrun = PlcProgramImage::OVERRUN_CATCH_UP;
+        } else {
+            EspHubLog->printf("ERROR: Program '%s': Unknown overrun policy '%s'\n", name, overrun_str);
+            return false;
+        }
+    } else if (strcmp(key, "engine") == 0) {
+        // Execution engine: "bytecode" (default) or "blocks"
+        const char* engine_str = value | "bytecode";
+        if (strcmp(engine_str, "blocks") == 0) {
+            engine = PlcProgramImage::ENGINE_BLOCKS;
+        } else if (strcmp(engine_str, "bytecode") == 0) {
+            engine = PlcProgramImage::ENGINE_BYTECODE;
+        } else {
+            EspHubLog->printf("ERROR: Program '%s': Unknown engine '%s'\n", name, engine_str);
+            return false;
+        }
+    } else if (strcmp(key, "execution") == 0) {
+        // Execution mode: "cyclic" (default) or "incremental"
+        const char* execution_str = value | "cyclic";
+        if (strcmp(execution_str, "cyclic") == 0) {
+            execution = PlcProgramImage::EXECUTION_CYCLIC;
+        } else if (strcmp(execution_str, "incremental") == 0) {
+            execution = PlcProgramImage::EXECUTION_INCREMENTAL;
+        } else {
+            EspHubLog->printf("ERROR: Program '%s': Unknown execution mode '%s'\n", name, execution_str);
+            return false;
+        }
+    } else if (strcmp(key, "optimize") == 0) {
+        // Fold constants, collapse conversion chains and remove unobserved blocks at load
+        optimize = value | false;
+    } else if (strcmp(key, "strict_types") == 0) {
+        // Reject blocks mixing operand types instead of converting at run time
+        strictTypes = value | false;
+    } else if (strcmp(key, "language") == 0) {
+        // Program language: "json" (default, the "logic" blocks) or "st"
+        const char* language_str = value | "json";
+        if (strcmp(language_str, "json") == 0 || strcmp(language_str, "st") == 0) {
+            structuredText = strcmp(language_str, "st") == 0;
+        } else {
+            EspHubLog->printf("ERROR: Program '%s': Unknown language '%s'\n", name, language_str);
+            return false;
+        }
+    } else if (strcmp(key, "source") == 0) {
+        if (!value.is<const char*>()) {
+            EspHubLog->printf("ERROR: Program '%s': source must be a string or an array of lines\n", name);
+            return false;
+        }
+        return appendSource(value.as<const char*>());
+    } else if (strcmp(key, "max_iterations") == 0) {
+        // Iteration cap of each ST loop per scan
+        maxIterations = value | 0;
+    }
+    // Other keys (name, applications, ...) are not part of the program
+    return true;
+}
+
+bool PlcImageBuilder::addString(const char* s, uint16_t& offset) {
+    if (!strings.add(s, offset)) {
+        EspHubLog->printf("ERROR: Program '%s': String table full\n", _name.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PlcImageBuilder::addVariable(const char* varName, PlcValueType type, bool retentive, const char* meshLink, uint16_t arrayLength) {
+    uint16_t nameOffset, meshOffset;
+    if (!addString(varName, nameOffset) || !addString(meshLink, meshOffset)) {
+        return false;
+    }
+    put16(variables, nameOffset);
+    put16(variables, meshOffset);
+    variables.push_back(static_cast<uint8_t>(type));
+    variables.push_back(retentive ? PlcProgramImage::FLAG_RETENTIVE : 0);
+    put16(variables, arrayLength);
+    variableCount++;
+    return true;
+}
+
+bool PlcImageBuilder::addVariable(const char* varName, JsonObjectConst attrs) {
+    String type_str = attrs["type"];
+    PlcValueType type;
+    uint16_t length = 0;
+    if (parseArrayType(type_str, type, length)) {
+        if (length == 0) {
+            EspHubLog->printf("ERROR: Program '%s': Array '%s' must have 1 to %u elements of bool, int, dint or real\n",
+                              _name.c_str(), varName, (unsigned)PLC_MAX_ARRAY_LENGTH);
+            return false;
+        }
+        if (strlen(attrs["mesh_link"] | "") > 0) {
+            EspHubLog->printf("ERROR: Program '%s': Array '%s' cannot have a mesh_link\n", _name.c_str(), varName);
+            return false;
+        }
+        return addVariable(varName, type, attrs["retentive"] | false, "", length);
+    }
+    if (!parseValueType(type_str, type)) {
+        EspHubLog->printf("ERROR: Program '%s': Unknown variable type '%s' for variable '%s'\n", _name.c_str(), type_str.c_str(), varName);
+        return false;
+    }
+    return addVariable(varName, type, attrs["retentive"] | false, attrs["mesh_link"] | "");
+}
+
+bool PlcImageBuilder::addBlock(JsonObject block) {
+    const char* name = _name.c_str();
+    const char* type = block["block_type"];
+    if (type == nullptr && block["type"].is<const char*>()) {
+        return addBenchmarkBlock(block);
+    }
+    if (type == nullptr) {
+        EspHubLog->printf("ERROR: Program '%s': Block %u has no block_type\n", name, blockCount);
+        return false;
+    }
+    uint16_t typeOffset;
+    if (!addString(type, typeOffset)) {
+        return false;
+    }
+    block.remove("block_type"); // Kept in the block table
+
+    // Each block's object is kept as MessagePack for configure()
+    size_t size = measureMsgPack(block);
+    if (size > 0xFFFF) {
+        EspHubLog->printf("ERROR: Program '%s': Configuration of block %u is too large\n", name, blockCount);
+        return false;
+    }
+    serializeMsgPack(block, reinterpret_cast<char*>(allocateConfig(size)), size);
+
+    put16(blocks, typeOffset);
+    put16(blocks, static_cast<uint16_t>(size));
+    put32(blocks, configSize);
+    configSize += size;
+    blockCount++;
+    return true;
+}
+
+uint8_t* PlcImageBuilder::allocateConfig(size_t size) {
+    // Start a new page when the config does not fit the current one
+    if (configPages.empty() || configPages.back().capacity() - configPages.back().size() < size) {
+        configPages.emplace_back();
+        configPages.back().reserve(size > CONFIG_PAGE_SIZE ? size : CONFIG_PAGE_SIZE);
+        configPageStart.push_back(configSize);
+    }
+    std::vector<uint8_t>& page = configPages.back();
+    size_t at = page.size();
+    page.resize(at + size); // Within the reserved capacity
+    return page.data() + at;
+}
+
+bool PlcImageBuilder::addBenchmarkBlock(JsonObjectConst block) {
+    // plc_benchmark_gen.py format: {"id", "type", "inputs": {"IN1": {"type":
+    // "var" | "const", "value": ...}}, "outputs": {"OUT": "name"}}. Pin names
+    // are lower-cased and constants become variables set by an init action.
+    JsonDocument converted;
+    converted["block_type"] = block["type"];
+    if (block["id"].is<const char*>()) {
+        converted["id"] = block["id"]; // Matches blocks across an online change
+    }
+    if (block["task"].is<const char*>()) {
+        converted["task"] = block["task"];
+    }
+    const char* sections[] = {"inputs", "outputs"};
+    for (const char* section : sections) {
+        JsonObjectConst pins = block[section];
+        JsonObject out = converted[section].to<JsonObject>();
+        for (JsonPairConst pin : pins) {
+            String pinName = pin.key().c_str();
+            pinName.toLowerCase();
+            JsonVariantConst ref = pin.value();
+            if (ref.is<JsonObjectConst>()) {
+                const char* refType = ref["type"] | "";
+                if (strcmp(refType, "const") == 0) {
+                    String constName;
+                    if (!addConstant(ref["value"], constName)) {
+                        return false;
+                    }
+                    out[pinName] = constName;
+                } else {
+                    out[pinName] = ref["value"];
+                }
+            } else {
+                out[pinName] = ref;
+            }
+        }
+    }
+    return addBlock(converted.as<JsonObject>());
+}
+
+bool PlcImageBuilder::addConstant(JsonVariantConst value, String& constName) {
+    // One variable per distinct value, named after it ("#1", "#2.5", "#true")
+    char text[32];
+    serializeJson(value, text, sizeof(text));
+    constName = String("#") + text;
+    uint16_t existing;
+    if (strings.find(constName.c_str(), existing)) {
+        return true; // Already declared
+    }
+
+    PlcValueUnion bits;
+    bits.ui32Val = 0;
+    PlcValueType type;
+    if (value.is<bool>()) {
+        type = PlcValueType::BOOL;
+        bits.bVal = value.as<bool>();
+    } else if (value.is<float>()) {
+        type = PlcValueType::REAL;
+        bits.fVal = value.as<float>();
+    } else {
+        EspHubLog->printf("ERROR: Program '%s': Unsupported constant %s\n", _name.c_str(), text);
+        return false;
+    }
+    return addVariable(constName.c_str(), type, false, "") && addInit(constName.c_str(), type, bits);
+}
+
+bool PlcImageBuilder::addInit(const char* varName, PlcValueType type, PlcValueUnion value) {
+    uint16_t nameOffset;
+    if (!addString(varName, nameOffset)) {
+        return false;
+    }
+    put16(inits, nameOffset);
+    inits.push_back(static_cast<uint8_t>(type));
+    inits.push_back(0);
+    put32(inits, value.ui32Val);
+    initCount++;
+    return true;
+}
+
+bool PlcImageBuilder::addInitAction(JsonObjectConst action) {
+    // Only set_value with a bool or numeric value is supported
+    const char* action_type = action["action"] | "";
+    const char* var_name = action["variable"];
+    if (strcmp(action_type, "set_value") != 0 || var_name == nullptr) {
+        return true;
+    }
+
+    PlcValueUnion value;
+    value.ui32Val = 0; // Unused bytes stay zero, so images are reproducible
+    PlcValueType valueType;
+    if (action["value"].is<bool>()) {
+        valueType = PlcValueType::BOOL;
+        value.bVal = action["value"].as<bool>();
+    } else if (action["value"].is<float>()) {
+        valueType = PlcValueType::REAL;
+        value.fVal = action["value"].as<float>();
+    } else if (action["value"].is<int>()) {
+        valueType = PlcValueType::INT;
+        value.i16Val = action["value"].as<int>();
+    } else {
+        return true;
+    }
+    return addInit(var_name, valueType, value);
+}
+
+bool PlcImageBuilder::addIoPoint(JsonObjectConst point) {
+    // Only the variable is part of the program, the endpoint is bound by DeviceRegistry
+    const char* var_name = point["plc_var"];
+    if (var_name == nullptr) {
+        return true;
+    }
+    uint16_t nameOffset;
+    if (!addString(var_name, nameOffset)) {
+        return false;
+    }
+    put16(ioPoints, nameOffset);
+    ioPoints.insert(ioPoints.end(), PlcProgramImage::ENTRY_SIZE - 2, 0);
+    ioPointCount++;
+    return true;
+}
+
+bool PlcImageBuilder::addTask(const char* taskName, JsonObjectConst attrs) {
+    // Period and priority of a task class; its blocks are resolved when the program is loaded
+    const char* name = _name.c_str();
+    uint32_t cycle_time_ms = attrs["cycle_time_ms"] | 0;
+    if (cycle_time_ms == 0 || cycle_time_ms > PlcProgramImage::MAX_CYCLE_TIME_MS) {
+        EspHubLog->printf("ERROR: Program '%s': cycle_time_ms of task '%s' must be between 1 and %u\n", name, taskName,
+                          (unsigned)PlcProgramImage::MAX_CYCLE_TIME_MS);
+        return false;
+    }
+    const char* priority_str = attrs["priority"] | "normal";
+    if (strcmp(priority_str, "normal") != 0 && strcmp(priority_str, "high") != 0) {
+        EspHubLog->printf("ERROR: Program '%s': Unknown priority '%s' of task '%s'\n", name, priority_str, taskName);
+        return false;
+    }
+    if (strcmp(taskName, "default") == 0) {
+        EspHubLog->printf("ERROR: Program '%s': Task name 'default' is used for the blocks without a task\n", name);
+        return false;
+    }
+    if (getTaskCount() == PlcProgramImage::MAX_TASKS) {
+        EspHubLog->printf("ERROR: Program '%s': More than %u tasks\n", name, (unsigned)PlcProgramImage::MAX_TASKS);
+        return false;
+    }
+    for (uint8_t i = 0; i < getTaskCount(); i++) {
+        if (strcmp(getTask(i).name, taskName) == 0) {
+            EspHubLog->printf("ERROR: Program '%s': Task '%s' is declared twice\n", name, taskName);
+            return false;
+        }
+    }
+    uint16_t nameOffset;
+    if (!addString(taskName, nameOffset)) {
+        return false;
+    }
+    put16(tasks, nameOffset);
+    tasks.push_back(strcmp(priority_str, "high") == 0 ? PlcProgramImage::TASK_HIGH_PRIORITY : 0);
+    tasks.push_back(0);
+    put32(tasks, cycle_time_ms);
+    return true;
+}
+
+size_t PlcImageBuilder::getMemoryUsage() const {
+    size_t pages = configPages.capacity() * sizeof(std::vector<uint8_t>) + configPageStart.capacity() * sizeof(uint32_t);
+    for (const std::vector<uint8_t>& page : configPages) {
+        pages += page.capacity();
+    }
+    return variables.capacity() + blocks.capacity() + inits.capacity() + ioPoints.capacity() + tasks.capacity() + pages + strings.getMemoryUsage() + source.capacity();
+}
+
+bool PlcImageBuilder::appendSource(const char* text) {
+    size_t length = strlen(text);
+    if (source.size() + length + 1 > PlcStructuredText::MAX_SOURCE) {
+        EspHubLog->printf("ERROR: Program '%s': source is longer than %u bytes\n", _name.c_str(),
+                          (unsigned)PlcStructuredText::MAX_SOURCE);
+        return false;
+    }
+    source.append(text, length);
+    source += '\n';
+    return true;
+}
+
+bool PlcImageBuilder::addSourceBlock() {
+    const char* name = _name.c_str();
+    if (!structuredText) {
+        if (!source.empty()) {
+            EspHubLog->printf("ERROR: Program '%s': source needs \"language\": \"st\"\n", name);
+            return false;
+        }
+        return true;
+    }
+    if (source.empty()) {
+        EspHubLog->printf("ERROR: Program '%s': ST program without source\n", name);
+        return false;
+    }
+    JsonDocument doc;
+    doc["block_type"] = "ST";
+    doc["source"] = source.c_str();
+    if (maxIterations > 0) {
+        doc["max_iterations"] = maxIterations;
+    }
+    bool ok = addBlock(doc.as<JsonObject>());
+    std::string().swap(source);
+    return ok;
+}
+
+bool PlcImageBuilder::checkLimits() const {
+    if (variableCount > 0xFFFF || blockCount > 0xFFFF || initCount > 0xFFFF || ioPointCount > 0xFFFF) {
+        EspHubLog->printf("ERROR: Program '%s': Too many variables, blocks, init actions or IO points\n", _name.c_str());
+        return false;
+    }
+    return true;
+}
+
+PlcProgramSource::Variable PlcImageBuilder::getVariable(uint16_t index) const {
+    const uint8_t* p = variables.data() + index * PlcProgramImage::ENTRY_SIZE;
+    Variable var;
+    var.name = strings.get(read16(p));
+    var.meshLink = strings.get(read16(p + 2));
+    var.type = static_cast<PlcValueType>(p[4]);
+    var.retentive = (p[5] & PlcProgramImage::FLAG_RETENTIVE) != 0;
+    var.arrayLength = read16(p + 6);
+    return var;
+}
+
+PlcProgramSource::Block PlcImageBuilder::getBlock(uint16_t index) const {
+    const uint8_t* p = blocks.data() + index * PlcProgramImage::ENTRY_SIZE;
+    uint32_t offset = read32(p + 4);
+    size_t page = std::upper_bound(configPageStart.begin(), configPageStart.end(), offset) - configPageStart.begin() - 1;
+    Block block;
+    block.type = strings.get(read16(p));
+    block.configSize = read16(p + 2);
+    block.config = configPages[page].data() + (offset - configPageStart[page]);
+    return block;
+}
+
+PlcProgramSource::InitAction PlcImageBuilder::getInitAction(uint16_t index) const {
+    const uint8_t* p = inits.data() + index * PlcProgramImage::ENTRY_SIZE;
+    InitAction action;
+    action.variable = strings.get(read16(p));
+    action.type = static_cast<PlcValueType>(p[2]);
+    action.value.ui32Val = read32(p + 4);
+    return action;
+}
+
+const char* PlcImageBuilder::getIoPoint(uint16_t index) const {
+    return strings.get(read16(ioPoints.data() + index * PlcProgramImage::ENTRY_SIZE));
+}
+
+PlcProgramSource::Task PlcImageBuilder::getTask(uint8_t index) const {
+    const uint8_t* p = tasks.data() + index * PlcProgramImage::ENTRY_SIZE;
+    Task task;
+    task.name = strings.get(read16(p));
+    task.highPriority = (p[2] & PlcProgramImage::TASK_HIGH_PRIORITY) != 0;
+    task.cycleTimeMs = read32(p + 4);
+    return task;
+}
+
+bool PlcImageBuilder::finish(std::vector<uint8_t>& image) {
+    if (!checkLimits()) {
+        return false;
+    }
+
+    // Assemble: header, tables, strings, block configs
+    const std::vector<char>& stringData = strings.getData();
+    uint32_t stringsOffset = PlcProgramImage::HEADER_SIZE + variables.size() + blocks.size() + inits.size() + ioPoints.size() + tasks.size();
+    uint32_t configOffset = stringsOffset + stringData.size();
+    uint32_t imageSize = configOffset + configSize;
+
+    image.clear();
+    image.reserve(imageSize);
+    peakMemoryUsage = getMemoryUsage() + image.capacity();
+
+    image.insert(image.end(), MAGIC, MAGIC + 4);
+    put16(image, PlcProgramImage::VERSION);
+    put16(image, PlcProgramImage::HEADER_SIZE);
+    put32(image, imageSize);
+    put32(image, 0); // CRC, patched below
+    put32(image, cycleTimeMs);
+    put32(image, watchdogTimeoutMs);
+    image.push_back(engine);
+    image.push_back(execution);
+    image.push_back(overrun);
+    image.push_back(static_cast<uint8_t>((core == PlcProgramImage::CORE_ANY ? 0 : core + 1) | (partition << 4)));
+    put16(image, static_cast<uint16_t>(variableCount));
+    put16(image, static_cast<uint16_t>(blockCount));
+    put16(image, static_cast<uint16_t>(initCount));
+    put16(image, retentiveCommitS);
+    put32(image, stringsOffset);
+    put32(image, stringData.size());
+    put32(image, configOffset);
+    put32(image, configSize);
+    image.push_back((optimize ? PlcProgramImage::FLAG_OPTIMIZE : 0) | (strictTypes ? PlcProgramImage::FLAG_STRICT_TYPES : 0));
+    image.push_back(getTaskCount());
+    put16(image, static_cast<uint16_t>(ioPointCount));
+
+    // Sections are released as they are copied
+    image.insert(image.end(), variables.begin(), variables.end());
+    std::vector<uint8_t>().swap(variables);
+    image.insert(image.end(), blocks.begin(), blocks.end());
+    std::vector<uint8_t>().swap(blocks);
+    image.insert(image.end(), inits.begin(), inits.end());
+    std::vector<uint8_t>().swap(inits);
+    image.insert(image.end(), ioPoints.begin(), ioPoints.end());
+    std::vector<uint8_t>().swap(ioPoints);
+    image.insert(image.end(), tasks.begin(), tasks.end());
+    std::vector<uint8_t>().swap(tasks);
+    image.insert(image.end(), stringData.begin(), stringData.end());
+    strings.release();
+    for (const std::vector<uint8_t>& page : configPages) {
+        image.insert(image.end(), page.begin(), page.end());
+    }
+    std::vector<std::vector<uint8_t>>().swap(configPages);
+    std::vector<uint32_t>().swap(configPageStart);
+    variableCount = blockCount = initCount = ioPointCount = configSize = 0;
+
+    patch32(image, 12, PlcProgramImage::crc32(image.data() + PlcProgramImage::HEADER_SIZE, imageSize - PlcProgramImage::HEADER_SIZE));
+    return true;
+}
+
+// ========== Reader ==========
+
+PlcProgramImage::PlcProgramImage()
+    : _data(nullptr), cycleTimeMs(0), watchdogTimeoutMs(0), engine(0), execution(0), overrun(0), retentiveCommitS(0),
+      core(CORE_ANY), partition(0), flags(0), taskCount(0), variableCount(0), blockCount(0), initCount(0), ioPointCount(0), variableTableOffset(0), stringsOffset(0), stringsSize(0), configOffset(0) {
+}
+
+bool PlcProgramImage::open(const uint8_t* data, size_t size, const String& programName) {
+    const char* name = programName.c_str();
+    _data = nullptr;
+
+    if (data == nullptr || size < MIN_HEADER_SIZE || memcmp(data, MAGIC, 4) != 0) {
+        EspHubLog->printf("ERROR: Program '%s': Not a PLC program image\n", name);
+        return false;
+    }
+    uint16_t version = read16(data + 4);
+    if (version != VERSION) {
+        EspHubLog->printf("ERROR: Program '%s': Unsupported program image version %u (expected %u)\n", name, version, VERSION);
+        return false;
+    }
+
+    // A larger header is accepted, newer fields are ignored
+    uint16_t headerSize = read16(data + 6);
+    uint32_t imageSize = read32(data + 8);
+    if (headerSize < MIN_HEADER_SIZE || imageSize > size || imageSize < headerSize) {
+        EspHubLog->printf("ERROR: Program '%s': Truncated program image\n", name);
+        return false;
+    }
+    if (crc32(data + headerSize, imageSize - headerSize) != read32(data + 12)) {
+        EspHubLog->printf("ERROR: Program '%s': Program image checksum mismatch\n", name);
+        return false;
+    }
+
+    cycleTimeMs = read32(data + 16);
+    watchdogTimeoutMs = read32(data + 20);
+    engine = data[24];
+    execution = data[25];
+    overrun = data[26];
+    core = (data[27] & 0x0F) ? (data[27] & 0x0F) - 1 : CORE_ANY;
+    partition = data[27] >> 4;
+    variableCount = read16(data + 28);
+    blockCount = read16(data + 30);
+    initCount = read16(data + 32);
+    retentiveCommitS = read16(data + 34);
+    stringsOffset = read32(data + 36);
+    stringsSize = read32(data + 40);
+    configOffset = read32(data + 44);
+    uint32_t configSize = read32(data + 48);
+    flags = headerSize >= HEADER_SIZE ? data[52] : 0;
+    taskCount = headerSize >= HEADER_SIZE ? data[53] : 0;
+    ioPointCount = headerSize >= HEADER_SIZE ? read16(data + 54) : 0;
+
+    uint32_t tablesEnd = headerSize + (static_cast<uint32_t>(variableCount) + blockCount + initCount + ioPointCount + taskCount) * ENTRY_SIZE;
+    if (tablesEnd > stringsOffset || stringsSize == 0 || stringsOffset + stringsSize > configOffset ||
+        configOffset + configSize > imageSize || data[stringsOffset + stringsSize - 1] != '\0') {
+        EspHubLog->printf("ERROR: Program '%s': Corrupt program image layout\n", name);
+        return false;
+    }
+
+    // Check every reference once, so the accessors need no checks
+    const uint8_t* p = data + headerSize;
+    for (uint16_t i = 0; i < variableCount; i++, p += ENTRY_SIZE) {
+        if (read16(p) >= stringsSize || read16(p + 2) >= stringsSize || p[4] > static_cast<uint8_t>(PlcValueType::STRING_TYPE)) {
+            EspHubLog->printf("ERROR: Program '%s': Corrupt variable %u in program image\n", name, i);
+            return false;
+        }
+    }
+    for (uint16_t i = 0; i < blockCount; i++, p += ENTRY_SIZE) {
+        if (read16(p) >= stringsSize || read32(p + 4) + read16(p + 2) > configSize) {
+            EspHubLog->printf("ERROR: Program '%s': Corrupt block %u in program image\n", name, i);
+            return false;
+        }
+    }
+    for (uint16_t i = 0; i < initCount; i++, p += ENTRY_SIZE) {
+        if (read16(p) >= stringsSize || p[2] > static_cast<uint8_t>(PlcValueType::STRING_TYPE)) {
+            EspHubLog->printf("ERROR: Program '%s': Corrupt init action %u in program image\n", name, i);
+            return false;
+        }
+    }
+    for (uint16_t i = 0; i < ioPointCount; i++, p += ENTRY_SIZE) {
+        if (read16(p) >= stringsSize) {
+            EspHubLog->printf("ERROR: Program '%s': Corrupt IO point %u in program image\n", name, i);
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < taskCount; i++, p += ENTRY_SIZE) {
+        uint32_t cycle_time_ms = read32(p + 4);
+        if (read16(p) >= stringsSize || cycle_time_ms == 0 || cycle_time_ms > MAX_CYCLE_TIME_MS) {
+            EspHubLog->printf("ERROR: Program '%s': Corrupt task %u in program image\n", name, i);
+            return false;
+        }
+    }
+
+    _data = data;
+    variableTableOffset = headerSize;
+    return true;
+}
+
+PlcProgramImage::Variable PlcProgramImage::getVariable(uint16_t index) const {
+    const uint8_t* p = entry(variableTableOffset, index);
+    Variable var;
+    var.name = string(read16(p));
+    var.meshLink = string(read16(p + 2));
+    var.type = static_cast<PlcValueType>(p[4]);
+    var.retentive = (p[5] & FLAG_RETENTIVE) != 0;
+    var.arrayLength = read16(p + 6);
+    return var;
+}
+
+PlcProgramImage::Block PlcProgramImage::getBlock(uint16_t index) const {
+    const uint8_t* p = entry(variableTableOffset + variableCount * ENTRY_SIZE, index);
+    Block block;
+    block.type = string(read16(p));
+    block.configSize = read16(p + 2);
+    block.config = _data + configOffset + read32(p + 4);
+    return block;
+}
+
+PlcProgramImage::InitAction PlcProgramImage::getInitAction(uint16_t index) const {
+    const uint8_t* p = entry(variableTableOffset + (variableCount + blockCount) * ENTRY_SIZE, index);
+    InitAction action;
+    action.variable = string(read16(p));
+    action.type = static_cast<PlcValueType>(p[2]);
+    action.value.ui32Val = read32(p + 4);
+    return action;
+}
+
+const char* PlcProgramImage::getIoPoint(uint16_t index) const {
+    return string(read16(entry(variableTableOffset + (variableCount + blockCount + initCount) * ENTRY_SIZE, index)));
+}
+
+PlcProgramImage::Task PlcProgramImage::getTask(uint8_t index) const {
+    const uint8_t* p = entry(variableTableOffset + (variableCount + blockCount + initCount + ioPointCount) * ENTRY_SIZE, index);
+    Task task;
+    task.name = string(read16(p));
+    task.highPriority = (p[2] & TASK_HIGH_PRIORITY) != 0;
+    task.cycleTimeMs = read32(p + 4);
+    return task;
+}
+
+// ========== Flash partition ==========
+
+#ifndef UNIT_TEST
+PlcImagePartition::PlcImagePartition() : _data(nullptr), _size(0), _handle(0) {
+}
+
+bool PlcImagePartition::map(const char* label) {
+    unmap();
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == nullptr) {
+        EspHubLog->printf("ERROR: Flash partition '%s' not found\n", label);
+        return false;
+    }
+    const void* ptr = nullptr;
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &ptr, &_handle) != ESP_OK) {
+        EspHubLog->printf("ERROR: Failed to map flash partition '%s'\n", label);
+        return false;
+    }
+    _data = static_cast<const uint8_t*>(ptr);
+    _size = partition->size;
+    return true;
+}
+
+void PlcImagePartition::unmap() {
+    if (_data != nullptr) {
+        spi_flash_munmap(_handle);
+        _data = nullptr;
+        _size = 0;
+    }
+}
+#endif
@@ -0,0 +1,363 @@
+#ifndef PLC_PROGRAM_IMAGE_H
+#define PLC_PROGRAM_IMAGE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <string>
+#include <vector>
+#include "../PlcEngine/Engine/PlcMemory.h"
+
+#ifndef UNIT_TEST
+#include <esp_spi_flash.h>
+#endif
+
+/**
+ * PlcProgramSource - the parts of a program PlcProgram loads from: settings,
+ * variable layout, blocks and init actions. Implemented by a binary image
+ * and by the builder that compiles one from JSON.
+ */
+class PlcProgramSource {
+public:
+    struct Variable {
+        const char* name;
+        const char* meshLink;
+        PlcValueType type;
+        bool retentive;
+        uint16_t arrayLength;  // Elements of an ARRAY variable, 0 for a single value
+    };
+
+    struct Block {
+        const char* type;
+        const uint8_t* config; // MessagePack
+        size_t configSize;
+    };
+
+    struct InitAction {
+        const char* variable;
+        PlcValueType type;     // BOOL, REAL or INT
+        PlcValueUnion value;
+    };
+
+    // Task class ("tasks" entry); blocks name it in their "task" member
+    struct Task {
+        const char* name;
+        uint32_t cycleTimeMs;
+        bool highPriority;     // "priority": "high"
+    };
+
+    virtual ~PlcProgramSource() {}
+
+    // Setting codes as in PlcProgramImage (ENGINE_*, EXECUTION_*, OVERRUN_*)
+    virtual uint32_t getCycleTimeMs() const = 0;
+    virtual uint32_t getWatchdogTimeoutMs() const = 0;
+    virtual uint8_t getEngine() const = 0;
+    virtual uint8_t getExecution() const = 0;
+    virtual uint8_t getOverrun() const = 0;
+    virtual uint16_t getRetentiveCommitS() const = 0; // 0: PlcRetentiveStore default
+    virtual uint8_t getCore() const = 0;              // CORE_ANY: placed by PlcEngine
+    virtual uint8_t getPartition() const = 0;         // 0: automatic
+    virtual bool getOptimize() const = 0;             // Run the load-time optimizer (PlcProgram)
+    virtual bool getStrictTypes() const = 0;          // Reject mixed operand types (PlcTypeCheck)
+
+    virtual uint16_t getVariableCount() const = 0;
+    virtual uint16_t getBlockCount() const = 0;
+    virtual uint16_t getInitCount() const = 0;
+    virtual uint16_t getIoPointCount() const = 0;
+    virtual uint8_t getTaskCount() const = 0;
+    virtual Variable getVariable(uint16_t index) const = 0;
+    virtual Block getBlock(uint16_t index) const = 0;
+    virtual InitAction getInitAction(uint16_t index) const = 0;
+    virtual const char* getIoPoint(uint16_t index) const = 0; // Variable ("plc_var") of an "io_points" entry
+    virtual Task getTask(uint8_t index) const = 0;
+};
+
+/**
+ * PlcProgramImage - versioned binary form of a PLC program.
+ *
+ * The image is produced from the JSON configuration by PlcProgramLoader
+ * (compile() or a stream) on the hub, or by test/tools/plc_image_compiler.py
+ * on a host, and is loaded by PlcProgram::loadImage() without keeping any
+ * JSON resident.
+ *
+ * Layout (little-endian, offsets from the start of the image):
+ *
+ *   Header (HEADER_SIZE bytes)
+ *     0  char[4]  magic "PLCI"
+ *     4  u16      version
+ *     6  u16      header size
+ *     8  u32      image size
+ *    12  u32      CRC-32 of bytes [header size, image size)
+ *    16  u32      cycle_time_ms
+ *    20  u32      watchdog_timeout_ms
+ *    24  u8       engine     (ENGINE_*)
+ *    25  u8       execution  (EXECUTION_*)
+ *    26  u8       overrun    (OVERRUN_*)
+ *    27  u8       placement: bits 0-3 core + 1 (0: any core),
+ *                 bits 4-7 partition (0: automatic)
+ *    28  u16      variable count
+ *    30  u16      block count
+ *    32  u16      init action count
+ *    34  u16      retentive_commit_s (0: default)
+ *    36  u32      string table offset
+ *    40  u32      string table size
+ *    44  u32      block config offset
+ *    48  u32      block config size
+ *    52  u8       flags (FLAG_OPTIMIZE, FLAG_STRICT_TYPES)
+ *    53  u8       task count
+ *    54  u16      IO point count
+ *
+ *   Images with the 52 byte header of earlier releases are accepted; they
+ *   have no flags, no tasks and no IO points.
+ *
+ *   Variable table, 8 bytes per entry, directly after the header
+ *     u16 name, u16 mesh_link (string table offsets), u8 PlcValueType,
+ *     u8 flags (FLAG_RETENTIVE), u16 array length (0: not an array)
+ *
+ *   Block table, 8 bytes per entry, in configuration order
+ *     u16 block_type (string table offset), u16 config size,
+ *     u32 config offset (relative to the block config section)
+ *
+ *   Init table, 8 bytes per entry, in configuration order
+ *     u16 variable (string table offset), u8 PlcValueType of the value,
+ *     u8 reserved, u32 value (raw bits of the bool/real/int16 value)
+ *
+ *   IO point table, 8 bytes per entry
+ *     u16 variable (string table offset), u8[6] reserved
+ *
+ *   Task table, 8 bytes per entry
+ *     u16 name (string table offset), u8 flags (TASK_HIGH_PRIORITY),
+ *     u8 reserved, u32 cycle_time_ms
+ *
+ *   String table: NUL-terminated strings, offset 0 is the empty string
+ *
+ *   Block configs: the JSON object of each block without its block_type
+ *   (inputs, outputs and constants) as MessagePack, parsed once while the
+ *   block is configured
+ */
+class PlcProgramImage : public PlcProgramSource {
+public:
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint16_t HEADER_SIZE = 56;
+    static constexpr uint16_t MIN_HEADER_SIZE = 52; // Without flags, tasks and IO points
+    static constexpr uint16_t ENTRY_SIZE = 8;
+
+    static constexpr uint8_t ENGINE_BYTECODE = 0;
+    static constexpr uint8_t ENGINE_BLOCKS = 1;
+    static constexpr uint8_t EXECUTION_CYCLIC = 0;
+    static constexpr uint8_t EXECUTION_INCREMENTAL = 1;
+    static constexpr uint8_t OVERRUN_SKIP = 0;
+    static constexpr uint8_t OVERRUN_CATCH_UP = 1;
+    static constexpr uint8_t FLAG_RETENTIVE = 0x01;  // Variable flags
+    static constexpr uint8_t FLAG_OPTIMIZE = 0x01;   // Header flags
+    static constexpr uint8_t FLAG_STRICT_TYPES = 0x02;
+    static constexpr uint8_t TASK_HIGH_PRIORITY = 0x01; // Task flags
+    static constexpr uint8_t MAX_TASKS = 8;
+    static constexpr uint32_t MAX_CYCLE_TIME_MS = 60000;
+    static constexpr uint8_t CORE_ANY = 0xFF;
+    static constexpr uint8_t MAX_CORE = 14;
+    static constexpr uint8_t MAX_PARTITION = 15;
+
+    // Compile a JSON program configuration (see PlcProgramLoader). Errors are
+    // logged with the program name; returns false if it is invalid.
+    static bool compile(const char* jsonConfig, const String& programName, std::vector<uint8_t>& image);
+
+    PlcProgramImage();
+
+    // Validate the image and use it in place. The data must stay valid
+    // while the image is read.
+    bool open(const uint8_t* data, size_t size, const String& programName);
+
+    uint32_t getCycleTimeMs() const override { return cycleTimeMs; }
+    uint32_t getWatchdogTimeoutMs() const override { return watchdogTimeoutMs; }
+    uint8_t getEngine() const override { return engine; }
+    uint8_t getExecution() const override { return execution; }
+    uint8_t getOverrun() const override { return overrun; }
+    uint16_t getRetentiveCommitS() const override { return retentiveCommitS; }
+    uint8_t getCore() const override { return core; }
+    uint8_t getPartition() const override { return partition; }
+    bool getOptimize() const override { return (flags & FLAG_OPTIMIZE) != 0; }
+    bool getStrictTypes() const override { return (flags & FLAG_STRICT_TYPES) != 0; }
+
+    uint16_t getVariableCount() const override { return variableCount; }
+    uint16_t getBlockCount() const override { return blockCount; }
+    uint16_t getInitCount() const override { return initCount; }
+    uint16_t getIoPointCount() const override { return ioPointCount; }
+    uint8_t getTaskCount() const override { return taskCount; }
+    Variable getVariable(uint16_t index) const override;
+    Block getBlock(uint16_t index) const override;
+    InitAction getInitAction(uint16_t index) const override;
+    const char* getIoPoint(uint16_t index) const override;
+    Task getTask(uint8_t index) const override;
+
+    static uint32_t crc32(const uint8_t* data, size_t size);
+    static const char* typeName(PlcValueType type); // JSON name, e.g. "real"
+
+private:
+    const uint8_t* _data;
+    uint32_t cycleTimeMs;
+    uint32_t watchdogTimeoutMs;
+    uint8_t engine;
+    uint8_t execution;
+    uint8_t overrun;
+    uint16_t retentiveCommitS;
+    uint8_t core;
+    uint8_t partition;
+    uint8_t flags;
+    uint8_t taskCount;
+    uint16_t variableCount;
+    uint16_t blockCount;
+    uint16_t initCount;
+    uint16_t ioPointCount;
+    uint32_t variableTableOffset;   // Tables follow the header back to back
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t configOffset;
+
+    const uint8_t* entry(uint32_t tableOffset, uint16_t index) const { return _data + tableOffset + index * ENTRY_SIZE; }
+    const char* string(uint16_t offset) const { return reinterpret_cast<const char*>(_data + stringsOffset + offset); }
+};
+
+/**
+ * PlcImageBuilder - compiles a program one entry at a time, so the JSON it
+ * comes from never has to be parsed as a whole. Sections can be added in
+ * any order; the settings keep their defaults unless set. The builder can
+ * be loaded directly or written out as an image with finish().
+ */
+class PlcImageBuilder : public PlcProgramSource {
+public:
+    static constexpr size_t CONFIG_PAGE_SIZE = 1024;
+
+    explicit PlcImageBuilder(const String& programName);
+
+    // Top-level settings (cycle_time_ms, engine, ...); other keys are ignored
+    bool setSetting(const char* key, JsonVariantConst value);
+    bool addVariable(const char* varName, JsonObjectConst attrs);   // "memory" entry
+    bool addBlock(JsonObject block);                                // "logic" entry, modified
+    bool addInitAction(JsonObjectConst action);                     // "init" entry
+    bool addIoPoint(JsonObjectConst point);                         // "io_points" entry
+    bool addTask(const char* taskName, JsonObjectConst attrs);      // "tasks" entry
+
+    // Structured Text source ("source" setting, or one call per line of
+    // an array). addSourceBlock() compiles it into the ST block of a
+    // "language": "st" program once all members have been read.
+    bool appendSource(const char* text);
+    bool addSourceBlock();
+
+    // Entry counts fit the image format
+    bool checkLimits() const;
+
+    // Write the image; the builder is empty afterwards
+    bool finish(std::vector<uint8_t>& image);
+
+    size_t getMemoryUsage() const;
+    size_t getPeakMemoryUsage() const { return peakMemoryUsage; } // Set by finish()
+
+    uint32_t getCycleTimeMs() const override { return cycleTimeMs; }
+    uint32_t getWatchdogTimeoutMs() const override { return watchdogTimeoutMs; }
+    uint8_t getEngine() const override { return engine; }
+    uint8_t getExecution() const override { return execution; }
+    uint8_t getOverrun() const override { return overrun; }
+    uint16_t getRetentiveCommitS() const override { return retentiveCommitS; }
+    uint8_t getCore() const override { return core; }
+    uint8_t getPartition() const override { return partition; }
+    bool getOptimize() const override { return optimize; }
+    bool getStrictTypes() const override { return strictTypes; }
+
+    uint16_t getVariableCount() const override { return static_cast<uint16_t>(variableCount); }
+    uint16_t getBlockCount() const override { return static_cast<uint16_t>(blockCount); }
+    uint16_t getInitCount() const override { return static_cast<uint16_t>(initCount); }
+    uint16_t getIoPointCount() const override { return static_cast<uint16_t>(ioPointCount); }
+    uint8_t getTaskCount() const override { return static_cast<uint8_t>(tasks.size() / PlcProgramImage::ENTRY_SIZE); }
+    Variable getVariable(uint16_t index) const override;
+    Block getBlock(uint16_t index) const override;
+    InitAction getInitAction(uint16_t index) const override;
+    const char* getIoPoint(uint16_t index) const override;
+    Task getTask(uint8_t index) const override;
+
+private:
+    // Deduplicated string table, offset 0 is the empty string. The index is
+    // an open-addressing hash of offsets, so no string is stored twice.
+    class StringTable {
+    public:
+        StringTable() : data(1, '\0'), count(0) {}
+        bool add(const char* s, uint16_t& offset);
+        bool find(const char* s, uint16_t& offset) const;
+        const std::vector<char>& getData() const { return data; }
+        const char* get(uint16_t offset) const { return data.data() + offset; }
+        size_t getMemoryUsage() const { return data.capacity() + index.capacity() * sizeof(uint16_t); }
+        void release();
+
+    private:
+        std::vector<char> data;
+        std::vector<uint16_t> index;
+        size_t count;
+
+        static uint32_t hash(const char* s);
+        void grow();
+    };
+
+    String _name;
+    uint32_t cycleTimeMs;
+    uint32_t watchdogTimeoutMs;
+    uint8_t engine;
+    uint8_t execution;
+    uint8_t overrun;
+    uint16_t retentiveCommitS;
+    uint8_t core;
+    uint8_t partition;
+    bool optimize;
+    bool strictTypes;
+    bool structuredText;        // "language": "st"
+    uint32_t maxIterations;     // Loop cap of the ST program, 0 for the default
+    std::string source;
+    StringTable strings;
+    std::vector<uint8_t> variables;
+    std::vector<uint8_t> blocks;
+    std::vector<uint8_t> inits;
+    std::vector<uint8_t> ioPoints;
+    std::vector<uint8_t> tasks;
+    // Block configs in pages, so the section never needs one large buffer;
+    // a config never spans two pages
+    std::vector<std::vector<uint8_t>> configPages;
+    std::vector<uint32_t> configPageStart;
+    uint32_t configSize;
+    uint32_t variableCount;
+    uint32_t blockCount;
+    uint32_t initCount;
+    uint32_t ioPointCount;
+    size_t peakMemoryUsage;
+
+    bool addString(const char* s, uint16_t& offset);
+    bool addVariable(const char* varName, PlcValueType type, bool retentive, const char* meshLink, uint16_t arrayLength = 0);
+    bool addInit(const char* varName, PlcValueType type, PlcValueUnion value);
+    bool addBenchmarkBlock(JsonObjectConst block);
+    bool addConstant(JsonVariantConst value, String& constName);
+    uint8_t* allocateConfig(size_t size);
+};
+
+#ifndef UNIT_TEST
+/**
+ * PlcImagePartition - program image memory-mapped from a flash data
+ * partition, so it is loaded without copying it to RAM.
+ */
+class PlcImagePartition {
+public:
+    PlcImagePartition();
+    ~PlcImagePartition() { unmap(); }
+
+    bool map(const char* label);
+    void unmap();
+    const uint8_t* getData() const { return _data; }
+    size_t getSize() const { return _size; }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    spi_flash_mmap_handle_t _handle;
+
+    PlcImagePartition(const PlcImagePartition&) = delete;
+    PlcImagePartition& operator=(const PlcImagePartition&) = delete;
+};
+#endif
+
+#endif // PLC_PROGRAM_IMAGE_H
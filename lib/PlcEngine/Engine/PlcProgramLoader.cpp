@@ -0,0 +1,368 @@
+#include "../PlcEngine/Engine/PlcProgramLoader.h"
+#include <StreamLogger.h>
+
+extern StreamLogger* EspHubLog;
+
+namespace {
+
+// Keeps the size of each allocation in front of it
+union AllocationHeader {
+    size_t size;
+    void* pointer;
+    double number;
+};
+
+} // namespace
+
+// ========== Allocator ==========
+
+void* PlcProgramLoader::CountingAllocator::allocate(size_t size) {
+    AllocationHeader* header = static_cast<AllocationHeader*>(malloc(sizeof(AllocationHeader) + size));
+    if (header == nullptr) {
+        return nullptr;
+    }
+    header->size = size;
+    current += size;
+    if (current > peak) {
+        peak = current;
+    }
+    return header + 1;
+}
+
+void PlcProgramLoader::CountingAllocator::deallocate(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    AllocationHeader* header = static_cast<AllocationHeader*>(ptr) - 1;
+    current -= header->size;
+    free(header);
+}
+
+void* PlcProgramLoader::CountingAllocator::reallocate(void* ptr, size_t newSize) {
+    if (ptr == nullptr) {
+        return allocate(newSize);
+    }
+    AllocationHeader* header = static_cast<AllocationHeader*>(ptr) - 1;
+    size_t oldSize = header->size;
+    header = static_cast<AllocationHeader*>(realloc(header, sizeof(AllocationHeader) + newSize));
+    if (header == nullptr) {
+        return nullptr;
+    }
+    header->size = newSize;
+    current = current - oldSize + newSize;
+    if (current > peak) {
+        peak = current;
+    }
+    return header + 1;
+}
+
+// ========== Loader ==========
+
+PlcProgramLoader::PlcProgramLoader(const String& programName)
+    : _name(programName), chunkPos(0), chunkLen(0), bytesRead(0), endOfInput(false), bytesPeak(0), jsonBytesPeak(0) {
+}
+
+PlcProgramLoader::ReadFunction PlcProgramLoader::readBuffer(const char* data, size_t length) {
+    size_t offset = 0;
+    return [data, length, offset](uint8_t* buffer, size_t size) mutable {
+        size_t count = length - offset < size ? length - offset : size;
+        memcpy(buffer, data + offset, count);
+        offset += count;
+        return count;
+    };
+}
+
+bool PlcProgramLoader::load(ReadFunction read, PlcImageBuilder& builder) {
+    _read = read;
+    chunkPos = 0;
+    chunkLen = 0;
+    bytesRead = 0;
+    endOfInput = false;
+    bytesPeak = 0;
+    jsonBytesPeak = 0;
+    allocator.peak = allocator.current;
+    element.clear();
+
+    bool ok = parseObject(builder, 0);
+    if (ok) {
+        skipWhitespace();
+        ok = peek() < 0 || fail("Unexpected data after the program");
+    }
+    std::vector<char>().swap(element);
+    _read = nullptr;
+    if (!ok || !builder.addSourceBlock() || !builder.checkLimits()) {
+        return false;
+    }
+
+    EspHubLog->printf("Program '%s': Read %u bytes of JSON: %u variables, %u blocks (bytes_peak %u)\n",
+                      _name.c_str(), (unsigned)bytesRead, (unsigned)builder.getVariableCount(),
+                      (unsigned)builder.getBlockCount(), (unsigned)bytesPeak);
+    return true;
+}
+
+bool PlcProgramLoader::load(ReadFunction read, std::vector<uint8_t>& image) {
+    image.clear();
+    PlcImageBuilder builder(_name);
+    if (!load(read, builder)) {
+        return false;
+    }
+    if (!builder.finish(image)) {
+        image.clear();
+        return false;
+    }
+    // The image and the builder exist side by side while it is written
+    if (builder.getPeakMemoryUsage() > bytesPeak) {
+        bytesPeak = builder.getPeakMemoryUsage();
+    }
+    EspHubLog->printf("Program '%s': Compiled to a %u byte image (bytes_peak %u)\n",
+                      _name.c_str(), (unsigned)image.size(), (unsigned)bytesPeak);
+    return true;
+}
+
+int PlcProgramLoader::peek() {
+    if (chunkPos == chunkLen) {
+        if (endOfInput) {
+            return -1;
+        }
+        chunkPos = 0;
+        chunkLen = _read(chunk, CHUNK_SIZE);
+        bytesRead += chunkLen;
+        if (chunkLen == 0) {
+            endOfInput = true;
+            return -1;
+        }
+    }
+    return chunk[chunkPos];
+}
+
+int PlcProgramLoader::next() {
+    int c = peek();
+    if (c >= 0) {
+        chunkPos++;
+    }
+    return c;
+}
+
+void PlcProgramLoader::skipWhitespace() {
+    int c = peek();
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        next();
+        c = peek();
+    }
+}
+
+bool PlcProgramLoader::fail(const char* what) {
+    EspHubLog->printf("ERROR: Program '%s': Invalid program JSON near byte %u: %s\n",
+                      _name.c_str(), (unsigned)(bytesRead - (chunkLen - chunkPos)), what);
+    return false;
+}
+
+bool PlcProgramLoader::expect(char c) {
+    skipWhitespace();
+    if (next() != c) {
+        char what[] = "Expected ' '";
+        what[10] = c;
+        return fail(what);
+    }
+    return true;
+}
+
+bool PlcProgramLoader::readKey(String& key) {
+    key = "";
+    if (!expect('"')) {
+        return false;
+    }
+    for (int c = next(); c != '"'; c = next()) {
+        if (c == '\\') {
+            c = next();
+        }
+        if (c < 0 || key.length() >= MAX_ELEMENT_SIZE) {
+            return fail("Unterminated key");
+        }
+        key += static_cast<char>(c);
+    }
+    return expect(':');
+}
+
+bool PlcProgramLoader::readElement(bool keep) {
+    // Reads one JSON value (object, array, string or scalar); its text is
+    // kept in element unless the value is skipped
+    element.clear();
+    skipWhitespace();
+    int first = peek();
+    bool scalar = first != '{' && first != '[' && first != '"';
+    size_t length = 0;
+    int depth = 0;
+    bool inString = false;
+    while (true) {
+        int c = peek();
+        if (scalar && (c < 0 || c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\r' || c == '\n')) {
+            break; // End of a number or literal
+        }
+        if (c < 0) {
+            return fail("Unexpected end of input");
+        }
+        next();
+        if (keep) {
+            if (element.size() >= MAX_ELEMENT_SIZE) {
+                return fail("Entry too large");
+            }
+            element.push_back(static_cast<char>(c));
+        }
+        length++;
+        if (scalar) {
+            continue;
+        }
+        if (inString) {
+            if (c == '\\') {
+                int escaped = next();
+                if (escaped < 0) {
+                    return fail("Unexpected end of input");
+                }
+                if (keep) {
+                    element.push_back(static_cast<char>(escaped));
+                }
+            } else if (c == '"') {
+                inString = false;
+                if (depth == 0) {
+                    break;
+                }
+            }
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            break;
+        }
+    }
+    return length > 0 || fail("Expected a value");
+}
+
+bool PlcProgramLoader::parseElement(JsonDocument& doc) {
+    DeserializationError error = deserializeJson(doc, element.data(), element.size());
+    if (allocator.peak > jsonBytesPeak) {
+        jsonBytesPeak = allocator.peak;
+    }
+    if (error) {
+        return fail(error.c_str());
+    }
+    return true;
+}
+
+void PlcProgramLoader::notePeak(const PlcImageBuilder& builder) {
+    size_t used = CHUNK_SIZE + element.capacity() + allocator.current + builder.getMemoryUsage();
+    if (used > bytesPeak) {
+        bytesPeak = used;
+    }
+}
+
+bool PlcProgramLoader::forEachEntry(char open, const std::function<bool(const String& key)>& entry) {
+    // The opening bracket has been read; key is empty for array entries
+    char close = open == '{' ? '}' : ']';
+    skipWhitespace();
+    if (peek() == close) {
+        next();
+        return true;
+    }
+    String key;
+    while (true) {
+        if (open == '{' && !readKey(key)) {
+            return false;
+        }
+        if (!entry(key)) {
+            return false;
+        }
+        skipWhitespace();
+        int c = next();
+        if (c == close) {
+            return true;
+        }
+        if (c != ',') {
+            return fail("Expected ',' or closing bracket");
+        }
+    }
+}
+
+bool PlcProgramLoader::parseObject(PlcImageBuilder& builder, int depth) {
+    if (!expect('{')) {
+        return false;
+    }
+    return forEachEntry('{', [this, &builder, depth](const String& key) {
+        return parseMember(builder, key, depth);
+    });
+}
+
+bool PlcProgramLoader::parseMember(PlcImageBuilder& builder, const String& key, int depth) {
+    if (key == "memory" || key == "tasks") {
+        if (!expect('{')) {
+            return false;
+        }
+        bool isTask = key == "tasks";
+        return forEachEntry('{', [this, &builder, isTask](const String& entryName) {
+            JsonDocument doc(&allocator);
+            if (!readElement(true) || !parseElement(doc)) {
+                return false;
+            }
+            bool ok = isTask ? builder.addTask(entryName.c_str(), doc.as<JsonObjectConst>())
+                             : builder.addVariable(entryName.c_str(), doc.as<JsonObjectConst>());
+            notePeak(builder);
+            return ok;
+        });
+    }
+    if (key == "logic" || key == "blocks" || key == "init" || key == "io_points") {
+        if (!expect('[')) {
+            return false;
+        }
+        bool isInit = key == "init";
+        bool isIoPoint = key == "io_points";
+        return forEachEntry('[', [this, &builder, isInit, isIoPoint](const String&) {
+            JsonDocument doc(&allocator);
+            if (!readElement(true) || !parseElement(doc)) {
+                return false;
+            }
+            if (!doc.is<JsonObject>()) {
+                return fail("Expected an object");
+            }
+            bool ok = isInit      ? builder.addInitAction(doc.as<JsonObjectConst>())
+                    : isIoPoint ? builder.addIoPoint(doc.as<JsonObjectConst>())
+                                : builder.addBlock(doc.as<JsonObject>());
+            notePeak(builder);
+            return ok;
+        });
+    }
+    if (key == "source") {
+        // ST source as an array of lines, so no line has to fit MAX_ELEMENT_SIZE with the others
+        skipWhitespace();
+        if (peek() == '[') {
+            next();
+            return forEachEntry('[', [this, &builder](const String&) {
+                JsonDocument doc(&allocator);
+                if (!readElement(true) || !parseElement(doc)) {
+                    return false;
+                }
+                if (!doc.is<const char*>()) {
+                    return fail("Expected a line of source");
+                }
+                bool ok = builder.appendSource(doc.as<const char*>());
+                notePeak(builder);
+                return ok;
+            });
+        }
+    }
+    if (key == "program" && depth == 0) {
+        skipWhitespace();
+        return parseObject(builder, depth + 1);
+    }
+
+    // Settings are scalars; other objects and arrays (applications, ...) are skipped
+    skipWhitespace();
+    if (peek() == '{' || peek() == '[') {
+        return readElement(false);
+    }
+    JsonDocument doc(&allocator);
+    if (!readElement(true) || !parseElement(doc)) {
+        return false;
+    }
+    return builder.setSetting(key.c_str(), doc.as<JsonVariantConst>());
+}
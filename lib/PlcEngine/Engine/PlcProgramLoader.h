@@ -0,0 +1,87 @@
+#ifndef PLC_PROGRAM_LOADER_H
+#define PLC_PROGRAM_LOADER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include <vector>
+#include "../PlcEngine/Engine/PlcProgramImage.h"
+
+/**
+ * PlcProgramLoader - streaming JSON to program image compiler.
+ *
+ * The JSON is read in CHUNK_SIZE pieces (from LittleFS, an MQTT payload or
+ * any other source) and only one "memory" entry, "logic" block or "init"
+ * action is parsed at a time, so the peak heap depends on the largest
+ * element and the image being built, not on the size of the program.
+ *
+ * Besides the hub format it accepts the output of
+ * test/tools/plc_benchmark_gen.py: settings and blocks inside a "program"
+ * object, "blocks" instead of "logic" and blocks in the form
+ * {"type": "ADD", "inputs": {"IN1": {"type": "const", "value": 1}}, ...}.
+ */
+class PlcProgramLoader {
+public:
+    // Fill the buffer with up to size bytes, return 0 at the end of the input
+    typedef std::function<size_t(uint8_t* buffer, size_t size)> ReadFunction;
+
+    static constexpr size_t CHUNK_SIZE = 256;
+    static constexpr size_t MAX_ELEMENT_SIZE = 4096;   // Largest single entry, as JSON text
+
+    explicit PlcProgramLoader(const String& programName);
+
+    // Compile into builder, which can be loaded as it is
+    bool load(ReadFunction read, PlcImageBuilder& builder);
+    // Compile to a program image
+    bool load(ReadFunction read, std::vector<uint8_t>& image);
+    bool load(const char* json, size_t length, std::vector<uint8_t>& image) { return load(readBuffer(json, length), image); }
+
+    // Reads a buffer that stays valid while loading (e.g. an MQTT payload)
+    static ReadFunction readBuffer(const char* data, size_t length);
+
+    size_t getBytesRead() const { return bytesRead; }
+    // Peak heap used by the loader: chunk, element text, parsed element and
+    // the compiled tables (and the image, when one is written)
+    size_t getBytesPeak() const { return bytesPeak; }
+    // Peak heap of a single parsed element
+    size_t getJsonBytesPeak() const { return jsonBytesPeak; }
+
+private:
+    // Counts the heap used by the element documents
+    class CountingAllocator : public ArduinoJson::Allocator {
+    public:
+        CountingAllocator() : current(0), peak(0) {}
+        void* allocate(size_t size) override;
+        void deallocate(void* ptr) override;
+        void* reallocate(void* ptr, size_t newSize) override;
+        size_t current;
+        size_t peak;
+    };
+
+    String _name;
+    ReadFunction _read;
+    uint8_t chunk[CHUNK_SIZE];
+    size_t chunkPos;
+    size_t chunkLen;
+    size_t bytesRead;
+    bool endOfInput;
+    std::vector<char> element;
+    CountingAllocator allocator;
+    size_t bytesPeak;
+    size_t jsonBytesPeak;
+
+    int peek();
+    int next();
+    void skipWhitespace();
+    bool expect(char c);
+    bool readKey(String& key);
+    bool readElement(bool keep);
+    bool parseElement(JsonDocument& doc);
+    bool parseObject(PlcImageBuilder& builder, int depth);
+    bool parseMember(PlcImageBuilder& builder, const String& key, int depth);
+    bool forEachEntry(char open, const std::function<bool(const String& key)>& entry);
+    void notePeak(const PlcImageBuilder& builder);
+    bool fail(const char* what);
+};
+
+#endif // PLC_PROGRAM_LOADER_H
@@ -0,0 +1,341 @@
+#include "../PlcEngine/Engine/PlcRetentiveStore.h"
+#include "../PlcEngine/Engine/PlcMemory.h"
+#include "../PlcEngine/Engine/PlcProgramImage.h" // For crc32
+#include <Preferences.h>
+#include <StreamLogger.h>
+
+extern StreamLogger* EspHubLog;
+
+namespace {
+
+const uint8_t MAGIC[4] = {'P', 'R', 'T', '1'};
+const size_t STRING_VALUE_SIZE = PLC_STRING_SIZE;
+
+uint32_t hashName(const char* name) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    while (*name) {
+        hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619u;
+    }
+    return hash;
+}
+
+void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+void put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+uint16_t read16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+uint32_t read32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // namespace
+
+void PlcRetentiveStats::reset() {
+    valueChanges = 0;
+    commits = 0;
+    committedSlots = 0;
+    bytesWritten = 0;
+    failedCommits = 0;
+    lastCommitUs = 0;
+}
+
+PlcRetentiveStore::PlcRetentiveStore()
+    : commitIntervalUs(DEFAULT_COMMIT_INTERVAL_MS * 1000), dirtyCount(0), lastPackUs(0), attachUs(0), tracking(false),
+      pendingSlots(0), commitPending(false), pagesScanned(false), latestPage(-1), latestSequence(0) {
+    keys[0][0] = keys[1][0] = '\0';
+}
+
+void PlcRetentiveStore::configure(const char* programName, uint32_t commitIntervalMs) {
+    // NVS keys are limited to 15 characters
+    uint32_t hash = hashName(programName);
+    snprintf(keys[0], sizeof(keys[0]), "%08x.a", (unsigned)hash);
+    snprintf(keys[1], sizeof(keys[1]), "%08x.b", (unsigned)hash);
+    commitIntervalUs = (commitIntervalMs ? commitIntervalMs : DEFAULT_COMMIT_INTERVAL_MS) * 1000;
+    pagesScanned = false;
+}
+
+void PlcRetentiveStore::attach(const PlcMemory& memory) {
+    retentiveSlots.clear();
+    size_t shadowSize = 0;
+    size_t blobSize = HEADER_SIZE;
+    for (uint16_t index = 0; index < memory.slots.size(); index++) {
+        const PlcVariable& var = memory.slots[index];
+        if (!var.isRetentive()) {
+            continue;
+        }
+        size_t valueSize = var.type == PlcValueType::STRING_TYPE ? STRING_VALUE_SIZE : sizeof(uint32_t);
+        retentiveSlots.push_back({index, var.type, hashName(memory.nameAt(index)), static_cast<uint16_t>(shadowSize)});
+        shadowSize += valueSize;
+        blobSize += 5 + valueSize; // A string's length byte replaces its terminator
+    }
+    dirty.assign(retentiveSlots.size(), 0);
+    dirtyCount = 0;
+    shadow.assign(shadowSize, 0);
+    for (const Slot& slot : retentiveSlots) {
+        const PlcVariable& var = memory.slots[slot.index];
+        if (slot.type == PlcValueType::STRING_TYPE) {
+            memcpy(shadow.data() + slot.shadowOffset, memory.stringAt(var.offset), STRING_VALUE_SIZE);
+        } else {
+            uint32_t bits = memory.readRaw(var);
+            memcpy(shadow.data() + slot.shadowOffset, &bits, sizeof(bits));
+        }
+    }
+
+    // Packing never allocates on the PLC task
+    PlcSpinLockGuard guard(lock);
+    packBuffer.clear();
+    packBuffer.reserve(blobSize);
+    commitBuffer.clear();
+    commitBuffer.reserve(blobSize);
+    writeBuffer.reserve(blobSize);
+    pendingSlots = 0;
+    commitPending.store(false, std::memory_order_release);
+    tracking = false;
+    stats.reset();
+}
+
+void PlcRetentiveStore::collect(const PlcMemory& memory) {
+    for (size_t i = 0; i < retentiveSlots.size(); i++) {
+        const Slot& slot = retentiveSlots[i];
+        const PlcVariable& var = memory.slots[slot.index];
+        uint8_t* seen = shadow.data() + slot.shadowOffset;
+        uint32_t bits;
+        const void* value = &bits;
+        size_t size = sizeof(bits);
+        if (slot.type == PlcValueType::STRING_TYPE) {
+            value = memory.stringAt(var.offset);
+            size = strnlen(memory.stringAt(var.offset), STRING_VALUE_SIZE - 1) + 1;
+        } else {
+            bits = memory.readRaw(var);
+        }
+        if (memcmp(seen, value, size) == 0) {
+            continue;
+        }
+        memcpy(seen, value, size);
+        stats.valueChanges++;
+        if (!dirty[i]) {
+            dirty[i] = 1;
+            dirtyCount++;
+        }
+    }
+}
+
+void PlcRetentiveStore::track(const PlcMemory& memory, uint32_t nowUs) {
+    if (retentiveSlots.empty()) {
+        return;
+    }
+    if (!tracking) {
+        tracking = true;
+        attachUs = lastPackUs = nowUs;
+    }
+    collect(memory);
+    if (dirtyCount > 0 && nowUs - lastPackUs >= commitIntervalUs) {
+        pack();
+        lastPackUs = nowUs;
+    }
+}
+
+bool PlcRetentiveStore::capture(const PlcMemory& memory) {
+    collect(memory);
+    if (dirtyCount > 0) {
+        pack();
+    }
+    return hasPendingCommit();
+}
+
+void PlcRetentiveStore::pack() {
+    packBuffer.resize(HEADER_SIZE);
+    for (const Slot& slot : retentiveSlots) {
+        uint8_t entry[5];
+        put32(entry, slot.nameHash);
+        entry[4] = static_cast<uint8_t>(slot.type);
+        packBuffer.insert(packBuffer.end(), entry, entry + 5);
+        const uint8_t* value = shadow.data() + slot.shadowOffset;
+        if (slot.type == PlcValueType::STRING_TYPE) {
+            uint8_t length = static_cast<uint8_t>(strnlen(reinterpret_cast<const char*>(value), STRING_VALUE_SIZE - 1));
+            packBuffer.push_back(length);
+            packBuffer.insert(packBuffer.end(), value, value + length);
+        } else {
+            packBuffer.insert(packBuffer.end(), value, value + sizeof(uint32_t));
+        }
+    }
+    memcpy(packBuffer.data(), MAGIC, 4);
+    put32(packBuffer.data() + 4, 0); // Sequence, set by commit()
+    put16(packBuffer.data() + 8, static_cast<uint16_t>(packBuffer.size() - HEADER_SIZE));
+    put16(packBuffer.data() + 10, static_cast<uint16_t>(retentiveSlots.size()));
+    put32(packBuffer.data() + 12, PlcProgramImage::crc32(packBuffer.data() + HEADER_SIZE, packBuffer.size() - HEADER_SIZE));
+    std::fill(dirty.begin(), dirty.end(), 0);
+
+    PlcSpinLockGuard guard(lock);
+    packBuffer.swap(commitBuffer); // An older blob not written yet is replaced
+    pendingSlots += dirtyCount;
+    dirtyCount = 0;
+    commitPending.store(true, std::memory_order_release);
+}
+
+bool PlcRetentiveStore::commit() {
+    uint16_t slots;
+    {
+        PlcSpinLockGuard guard(lock);
+        if (!commitPending.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        commitBuffer.swap(writeBuffer);
+        slots = pendingSlots;
+        pendingSlots = 0;
+        commitPending.store(false, std::memory_order_release);
+    }
+    if (!pagesScanned) {
+        scanPages();
+    }
+
+    // Overwrite the older page; the newest stays valid until this write is complete
+    uint8_t page = latestPage == 0 ? 1 : 0;
+    uint32_t sequence = latestSequence + 1;
+    put32(writeBuffer.data() + 4, sequence);
+
+    uint32_t start = micros();
+    Preferences preferences;
+    bool ok = preferences.begin(NVS_NAMESPACE, false) &&
+              preferences.putBytes(keys[page], writeBuffer.data(), writeBuffer.size()) == writeBuffer.size();
+    preferences.end();
+    stats.lastCommitUs = micros() - start;
+
+    if (!ok) {
+        stats.failedCommits++;
+        EspHubLog->printf("ERROR: Failed to write retentive values (%u bytes) to NVS key '%s'\n", (unsigned)writeBuffer.size(), keys[page]);
+        // Keep the blob for the next commit() unless a newer one was packed meanwhile
+        PlcSpinLockGuard guard(lock);
+        if (!commitPending.load(std::memory_order_relaxed)) {
+            writeBuffer.swap(commitBuffer);
+            commitPending.store(true, std::memory_order_release);
+        }
+        pendingSlots += slots;
+        return false;
+    }
+    latestPage = page;
+    latestSequence = sequence;
+    stats.commits++;
+    stats.committedSlots += slots;
+    stats.bytesWritten += writeBuffer.size();
+    return true;
+}
+
+bool PlcRetentiveStore::readPage(uint8_t page, std::vector<uint8_t>& blob, uint32_t& sequence) {
+    Preferences preferences;
+    if (!preferences.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+    size_t length = preferences.getBytesLength(keys[page]);
+    blob.resize(length);
+    bool read = length >= HEADER_SIZE && preferences.getBytes(keys[page], blob.data(), length) == length;
+    preferences.end();
+    if (!read || memcmp(blob.data(), MAGIC, 4) != 0 || read16(blob.data() + 8) != length - HEADER_SIZE ||
+        PlcProgramImage::crc32(blob.data() + HEADER_SIZE, length - HEADER_SIZE) != read32(blob.data() + 12)) {
+        return false;
+    }
+    sequence = read32(blob.data() + 4);
+    return true;
+}
+
+void PlcRetentiveStore::scanPages() {
+    std::vector<uint8_t> blob;
+    latestPage = -1;
+    latestSequence = 0;
+    for (uint8_t page = 0; page < 2; page++) {
+        uint32_t sequence;
+        if (readPage(page, blob, sequence) && (latestPage < 0 || static_cast<int32_t>(sequence - latestSequence) > 0)) {
+            latestPage = page;
+            latestSequence = sequence;
+        }
+    }
+    pagesScanned = true;
+}
+
+uint16_t PlcRetentiveStore::restore(PlcMemory& memory) {
+    scanPages();
+    std::vector<uint8_t> blob;
+    uint32_t sequence;
+    if (latestPage < 0 || !readPage(latestPage, blob, sequence)) {
+        return 0;
+    }
+
+    uint16_t restored = 0;
+    size_t at = HEADER_SIZE;
+    for (uint16_t n = read16(blob.data() + 10); n > 0 && at + 5 <= blob.size(); n--) {
+        uint32_t nameHash = read32(blob.data() + at);
+        PlcValueType type = static_cast<PlcValueType>(blob[at + 4]);
+        at += 5;
+        size_t valueSize = sizeof(uint32_t);
+        const uint8_t* value = blob.data() + at;
+        if (type == PlcValueType::STRING_TYPE) {
+            if (at >= blob.size()) {
+                break;
+            }
+            valueSize = 1 + blob[at];
+            value++;
+        }
+        if (at + valueSize > blob.size()) {
+            break;
+        }
+        at += valueSize;
+
+        for (const Slot& slot : retentiveSlots) {
+            if (slot.nameHash != nameHash || slot.type != type) {
+                continue;
+            }
+            const PlcVariable& var = memory.slots[slot.index];
+            uint8_t* seen = shadow.data() + slot.shadowOffset;
+            if (type == PlcValueType::STRING_TYPE) {
+                char* target = memory.stringAt(var.offset);
+                memcpy(target, value, valueSize - 1);
+                target[valueSize - 1] = '\0';
+                memcpy(seen, target, STRING_VALUE_SIZE);
+            } else {
+                uint32_t bits;
+                memcpy(&bits, value, sizeof(bits));
+                memory.writeRaw(var, bits);
+                bits = memory.readRaw(var); // As stored, e.g. a BOOL as 0 or 1
+                memcpy(seen, &bits, sizeof(bits));
+            }
+            restored++;
+            break;
+        }
+    }
+    return restored;
+}
+
+size_t PlcRetentiveStore::getMemoryUsage() const {
+    return retentiveSlots.capacity() * sizeof(Slot) + dirty.capacity() + shadow.capacity()
+         + packBuffer.capacity() + commitBuffer.capacity() + writeBuffer.capacity();
+}
+
+void PlcRetentiveStore::getStatsJson(JsonObject out, uint32_t nowUs) const {
+    out["retentive_variables"] = retentiveSlots.size();
+    out["commit_interval_ms"] = getCommitIntervalMs();
+    out["value_changes"] = stats.valueChanges;
+    out["commits"] = stats.commits;
+    out["committed_slots"] = stats.committedSlots;
+    out["bytes_written"] = stats.bytesWritten;
+    out["failed_commits"] = stats.failedCommits;
+    out["last_commit_us"] = stats.lastCommitUs;
+    out["pending"] = hasPendingCommit();
+
+    // Flash wear: writes and bytes per hour since tracking started
+    uint32_t elapsedUs = tracking ? nowUs - attachUs : 0;
+    if (elapsedUs > 0) {
+        double hours = elapsedUs / 3600e6;
+        out["commits_per_hour"] = stats.commits / hours;
+        out["bytes_per_hour"] = stats.bytesWritten / hours;
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef PLC_RETENTIVE_STORE_H
+#define PLC_RETENTIVE_STORE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <vector>
+#include "../PlcEngine/Engine/PlcSpinLock.h"
+
+class PlcMemory;
+enum class PlcValueType : uint8_t;
+
+/**
+ * Flash write statistics of one program's retentive store.
+ */
+struct PlcRetentiveStats {
+    uint32_t valueChanges;      // Retentive values changed, seen at the end of each scan
+    uint32_t commits;           // Blobs written to flash
+    uint32_t committedSlots;    // Changed slots covered by these commits (a slot changing
+                                // several times within one interval counts once)
+    uint32_t bytesWritten;
+    uint32_t failedCommits;
+    uint32_t lastCommitUs;      // Duration of the last flash write
+
+    PlcRetentiveStats() { reset(); }
+    void reset();
+};
+
+/**
+ * PlcRetentiveStore - persistence of a program's retentive variables.
+ *
+ * The PLC task calls track() at the end of every scan. It compares the
+ * retentive slots with the last values it saw and marks the changed ones
+ * dirty; at most once per commit interval the values are packed into one
+ * blob, in a buffer reserved when the program is loaded. commit() writes
+ * the packed blob to NVS from another task, so the scan never waits for
+ * flash.
+ *
+ * Two NVS keys are written alternately, each blob carrying a sequence
+ * number and a CRC-32. A write torn by a power cut leaves the other key
+ * intact, and restore() uses the newest blob that checks out.
+ *
+ * Blob: u32 magic "PRT1", u32 sequence, u16 payload size, u16 entry count,
+ * u32 CRC-32 of the payload; then per retentive variable u32 FNV-1a hash
+ * of the name, u8 PlcValueType, and the value (4 raw bytes, or for strings
+ * u8 length and the characters). Values are matched by name and type, so
+ * a changed program keeps the values of the variables it still has.
+ */
+class PlcRetentiveStore {
+public:
+    static constexpr uint32_t DEFAULT_COMMIT_INTERVAL_MS = 5000;
+    static constexpr const char* NVS_NAMESPACE = "plc_retain";
+    static constexpr size_t HEADER_SIZE = 16;
+
+    PlcRetentiveStore();
+
+    // Keys are derived from the program name
+    void configure(const char* programName, uint32_t commitIntervalMs);
+    uint32_t getCommitIntervalMs() const { return commitIntervalUs / 1000; }
+
+    // Collect the retentive slots once all variables are declared; their
+    // current values count as saved
+    void attach(const PlcMemory& memory);
+    size_t getSlotCount() const { return retentiveSlots.size(); }
+
+    // Load the newest valid blob into the retentive slots. Returns the
+    // number of values restored.
+    uint16_t restore(PlcMemory& memory);
+
+    // PLC task, end of scan
+    void track(const PlcMemory& memory, uint32_t nowUs);
+    // Pack the changed values now, regardless of the interval
+    bool capture(const PlcMemory& memory);
+
+    // Write the packed blob, if any. Any task but the PLC task. A failed
+    // write keeps the blob pending, so the next call retries it.
+    bool commit();
+    bool hasPendingCommit() const { return commitPending.load(std::memory_order_acquire); }
+
+    const PlcRetentiveStats& getStats() const { return stats; }
+    size_t getMemoryUsage() const;
+    void getStatsJson(JsonObject out, uint32_t nowUs) const; // Includes write rates per hour
+
+private:
+    struct Slot {
+        uint16_t index;
+        PlcValueType type;
+        uint32_t nameHash;
+        uint16_t shadowOffset;  // Last seen value in shadow
+    };
+
+    char keys[2][16];                   // NVS keys of the two pages
+    uint32_t commitIntervalUs;
+    std::vector<Slot> retentiveSlots;
+    std::vector<uint8_t> dirty;         // Per retentive slot
+    uint16_t dirtyCount;
+    std::vector<uint8_t> shadow;        // Last seen values, 4 bytes per number, 64 per string
+    uint32_t lastPackUs;
+    uint32_t attachUs;
+    bool tracking;
+
+    std::vector<uint8_t> packBuffer;    // PLC task
+    std::vector<uint8_t> commitBuffer;  // Handed over, guarded by lock
+    std::vector<uint8_t> writeBuffer;   // Committing task
+    uint16_t pendingSlots;
+    std::atomic<bool> commitPending;
+    PlcSpinLock lock;
+
+    bool pagesScanned;
+    int8_t latestPage;                  // -1 if neither page is valid
+    uint32_t latestSequence;
+
+    PlcRetentiveStats stats;
+
+    void collect(const PlcMemory& memory);
+    void pack();
+    bool readPage(uint8_t page, std::vector<uint8_t>& blob, uint32_t& sequence);
+    void scanPages();
+};
+
+#endif // PLC_RETENTIVE_STORE_H
@@ -0,0 +1,46 @@
+#ifndef PLC_SPIN_LOCK_H
+#define PLC_SPIN_LOCK_H
+
+#include <Arduino.h>
+#ifdef UNIT_TEST
+#include <mutex>
+#endif
+
+/**
+ * PlcSpinLock - short critical section shared between tasks on both cores.
+ *
+ * A FreeRTOS spinlock on the ESP32 (interrupts are disabled while it is
+ * held, so keep the protected code to a few copies and never allocate),
+ * a std::mutex in native builds.
+ */
+class PlcSpinLock {
+public:
+#ifdef UNIT_TEST
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+#else
+    PlcSpinLock() : mux(portMUX_INITIALIZER_UNLOCKED) {}
+    void lock() { portENTER_CRITICAL(&mux); }
+    void unlock() { portEXIT_CRITICAL(&mux); }
+#endif
+
+private:
+#ifdef UNIT_TEST
+    std::mutex mutex;
+#else
+    portMUX_TYPE mux;
+#endif
+};
+
+class PlcSpinLockGuard {
+public:
+    explicit PlcSpinLockGuard(PlcSpinLock& lock) : _lock(lock) { _lock.lock(); }
+    ~PlcSpinLockGuard() { _lock.unlock(); }
+
+private:
+    PlcSpinLock& _lock;
+    PlcSpinLockGuard(const PlcSpinLockGuard&) = delete;
+    PlcSpinLockGuard& operator=(const PlcSpinLockGuard&) = delete;
+};
+
+#endif // PLC_SPIN_LOCK_H
@@ -0,0 +1,1612 @@
+#include "../PlcEngine/Engine/PlcStructuredText.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+typedef PlcExpression::Type Type;
+
+struct ElementaryType {
+    const char* name;
+    PlcValueType type;
+};
+
+// Declared types and typed literal prefixes (INT#5), matched regardless of case
+const ElementaryType ELEMENTARY_TYPES[] = {
+    {"bool", PlcValueType::BOOL}, {"byte", PlcValueType::BYTE}, {"usint", PlcValueType::BYTE},
+    {"int", PlcValueType::INT}, {"uint", PlcValueType::DINT}, {"word", PlcValueType::DINT},
+    {"dint", PlcValueType::DINT}, {"udint", PlcValueType::DINT}, {"dword", PlcValueType::DINT},
+    {"time", PlcValueType::DINT}, {"real", PlcValueType::REAL}, {"lreal", PlcValueType::REAL},
+    {"string", PlcValueType::STRING_TYPE}
+};
+
+// Block types that can be instantiated, and the input that is a constant
+// of the block rather than a variable
+struct FunctionBlockType {
+    const char* type;
+    const char* presetPin;
+};
+
+const FunctionBlockType FUNCTION_BLOCKS[] = {
+    {"TON", "pt"}, {"TOF", "pt"}, {"TP", "pt"},
+    {"CTU", nullptr}, {"CTD", nullptr}, {"CTUD", nullptr}, {"SR", nullptr}, {"RS", nullptr}
+};
+
+// Words that cannot start a statement or name a variable
+const char* const RESERVED[] = {
+    "if", "then", "elsif", "else", "end_if", "case", "of", "end_case", "for", "to", "by", "do", "end_for",
+    "while", "end_while", "repeat", "until", "end_repeat", "exit", "return", "var", "end_var",
+    "program", "end_program", nullptr
+};
+
+const char* const NO_STOPS[] = {nullptr};
+const char* const THEN_STOPS[] = {"then", nullptr};
+const char* const OF_STOPS[] = {"of", nullptr};
+const char* const TO_STOPS[] = {"to", nullptr};
+const char* const FOR_END_STOPS[] = {"by", "do", nullptr};
+const char* const DO_STOPS[] = {"do", nullptr};
+const char* const UNTIL_STOPS[] = {"end_repeat", nullptr};
+const char* const IF_BODY_STOPS[] = {"elsif", "else", "end_if", nullptr};
+const char* const CASE_BODY_STOPS[] = {"else", "end_case", nullptr};
+const char* const FOR_BODY_STOPS[] = {"end_for", nullptr};
+const char* const WHILE_BODY_STOPS[] = {"end_while", nullptr};
+const char* const REPEAT_BODY_STOPS[] = {"until", nullptr};
+const char* const PROGRAM_STOPS[] = {"end_program", nullptr};
+
+bool equalsIgnoreCase(const std::string& text, const char* word) {
+    size_t i = 0;
+    for (; i < text.size(); i++) {
+        if (word[i] == '\0' || tolower(static_cast<unsigned char>(text[i])) != tolower(static_cast<unsigned char>(word[i]))) {
+            return false;
+        }
+    }
+    return word[i] == '\0';
+}
+
+bool isNameStart(char c) {
+    return isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isWordChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+std::string lower(const std::string& text) {
+    std::string result = text;
+    for (char& c : result) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+const ElementaryType* findElementaryType(const std::string& name) {
+    for (const ElementaryType& type : ELEMENTARY_TYPES) {
+        if (equalsIgnoreCase(name, type.name)) {
+            return &type;
+        }
+    }
+    return nullptr;
+}
+
+// Variable type of a pin from the block catalog
+PlcValueType pinType(const char* type) {
+    if (strcmp(type, "bool") == 0) return PlcValueType::BOOL;
+    if (strcmp(type, "int") == 0) return PlcValueType::INT;
+    if (strcmp(type, "real") == 0) return PlcValueType::REAL;
+    return PlcValueType::DINT;
+}
+
+Type hintFor(PlcValueType type) {
+    switch (type) {
+        case PlcValueType::BOOL: return Type::BOOL;
+        case PlcValueType::REAL: return Type::REAL;
+        default: return Type::INT;
+    }
+}
+
+} // namespace
+
+/**
+ * Single pass over the source: statements are parsed and emitted
+ * directly, expressions are cut out of the source, rewritten to the
+ * PlcExpression syntax and compiled with the program's scope.
+ */
+class PlcStructuredText::Compiler {
+public:
+    Compiler(PlcStructuredText& program, const char* source, PlcMemory& memory, Binder read, Binder write,
+             void* context, const PlcBlockContext& blockContext, PlcArena* arena)
+        : errorLine(0), program(program), source(source), cursor(source), memory(memory), read(read),
+          write(write), context(context), blockContext(blockContext), arena(arena) {}
+
+    std::string error;
+    unsigned errorLine;
+
+    bool compile() {
+        skipSpace();
+        bool wrapped = acceptWord("program");
+        if (wrapped) {
+            std::string name;
+            const char* at;
+            if (!readName(name, at)) {
+                return fail("expected the program name");
+            }
+        }
+        while (atVarSection()) {
+            if (!parseVarSection()) {
+                return false;
+            }
+        }
+        if (!parseStatements(PROGRAM_STOPS, false)) {
+            return false;
+        }
+        if (wrapped && !expectWord("end_program")) {
+            return false;
+        }
+        acceptSymbol(";");
+        skipSpace();
+        if (*cursor != '\0') {
+            return fail("unexpected text after the program");
+        }
+
+        size_t end = emit(PlcStOpcode::END);
+        patch(returns, end);
+        return error.empty() && bindPins() && configureInstances() && finish();
+    }
+
+private:
+    // Arguments passed to a pin in the calls of an instance
+    struct PinArguments {
+        const char* pin;            // From the catalog
+        bool output;
+        bool same;                  // The same variable or constant in every call
+        std::string variable;       // Name of that variable, empty for a constant
+        std::vector<size_t> assigns; // ASSIGN of each call
+    };
+
+    struct InstanceUse {
+        std::vector<const char*> outputs;   // Pins read by the program, from the catalog
+        std::vector<const char*> named;     // Pins used by name outside of the calls
+        std::vector<size_t> calls;
+        std::vector<PinArguments> arguments;
+        std::vector<std::pair<const char*, std::string>> bound; // Pin, variable
+        const char* presetPin;
+        bool hasPreset;
+        int32_t preset;
+    };
+
+    struct Loop {
+        std::vector<size_t> exits;  // Jumps to the end of the loop
+    };
+
+    // Code position to drop what was compiled after it (dead branches)
+    struct Mark {
+        size_t code;
+        size_t expressions;
+        size_t returns;
+        std::vector<size_t> exits;
+        PlcExprScope::State scope;
+    };
+
+    // IF and CASE
+    struct Branches {
+        std::vector<size_t> ends;   // Jumps past the last branch
+        bool taken = false;         // A branch without condition was compiled, the rest is dead
+        bool joined = false;        // Paths meet after the statement
+    };
+
+    struct Branch {
+        Mark mark;
+        bool dead;
+        long jump;                  // JUMP_IF_NOT to the next branch, -1 if none
+        PlcExprScope::State next;   // Subexpressions available in the next branch
+    };
+
+    PlcStructuredText& program;
+    const char* source;
+    const char* cursor;
+    PlcMemory& memory;
+    Binder read;
+    Binder write;
+    void* context;
+    PlcBlockContext blockContext;
+    PlcArena* arena;
+
+    std::vector<PlcStInstruction> code;
+    std::vector<InstanceUse> uses;
+    std::vector<Loop> loops;
+    std::vector<size_t> returns;
+    PlcExprScope scope;
+
+    bool fail(const std::string& message, const char* at = nullptr) {
+        if (error.empty()) {
+            error = message;
+            errorLine = 1;
+            for (const char* p = source; p < (at ? at : cursor) && *p; p++) {
+                errorLine += *p == '\n';
+            }
+        }
+        return false;
+    }
+
+    // ========== Lexer ==========
+
+    // Whitespace and (* *), /* */ and // comments
+    void skipSpace() {
+        while (true) {
+            while (isspace(static_cast<unsigned char>(*cursor))) {
+                cursor++;
+            }
+            const char* end = skipComment(cursor);
+            if (end == cursor) {
+                return;
+            }
+            cursor = end;
+        }
+    }
+
+    // End of the comment at p, p if there is none
+    const char* skipComment(const char* p) {
+        if (p[0] == '/' && p[1] == '/') {
+            while (*p && *p != '\n') {
+                p++;
+            }
+            return p;
+        }
+        if ((p[0] == '(' || p[0] == '/') && p[1] == '*') {
+            char close = p[0] == '(' ? ')' : '/';
+            const char* start = p;
+            for (p += 2; *p; p++) {
+                if (p[0] == '*' && p[1] == close) {
+                    return p + 2;
+                }
+            }
+            fail("unterminated comment", start);
+            return p;
+        }
+        return p;
+    }
+
+    bool atWord(const char* word) {
+        skipSpace();
+        size_t length = strlen(word);
+        for (size_t i = 0; i < length; i++) {
+            if (tolower(static_cast<unsigned char>(cursor[i])) != word[i]) {
+                return false;
+            }
+        }
+        return !isWordChar(cursor[length]);
+    }
+
+    bool atAnyWord(const char* const* words) {
+        for (; *words; words++) {
+            if (atWord(*words)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool acceptWord(const char* word) {
+        if (!atWord(word)) {
+            return false;
+        }
+        cursor += strlen(word);
+        return true;
+    }
+
+    bool expectWord(const char* word) {
+        if (acceptWord(word)) {
+            return true;
+        }
+        std::string upper(word);
+        for (char& c : upper) {
+            c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        }
+        return fail("expected " + upper);
+    }
+
+    bool acceptSymbol(const char* symbol) {
+        skipSpace();
+        size_t length = strlen(symbol);
+        if (strncmp(cursor, symbol, length) != 0) {
+            return false;
+        }
+        cursor += length;
+        return true;
+    }
+
+    bool expectSymbol(const char* symbol) {
+        return acceptSymbol(symbol) || fail(std::string("expected '") + symbol + "'");
+    }
+
+    // Name, with '.' for members and dotted variable names
+    bool readName(std::string& name, const char*& at) {
+        skipSpace();
+        at = cursor;
+        if (!isNameStart(*cursor)) {
+            return false;
+        }
+        while (isWordChar(*cursor) || (*cursor == '.' && isNameStart(cursor[1]))) {
+            cursor++;
+        }
+        name.assign(at, cursor - at);
+        return true;
+    }
+
+    static bool isReserved(const std::string& name) {
+        for (const char* const* word = RESERVED; *word; word++) {
+            if (equalsIgnoreCase(name, *word)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // ========== Expressions ==========
+
+    // Cut an expression out of the source, up to a ';', or a ':=', a stop
+    // word or, in call arguments, a ',' or ')' at depth 0, and rewrite the ST
+    // literals and member names
+    bool scanExpression(std::string& text, const char*& at, const char* const* stops, bool inCall) {
+        skipSpace();
+        at = cursor;
+        text.clear();
+        int depth = 0;
+        while (error.empty()) {
+            char c = *cursor;
+            const char* end = skipComment(cursor);
+            if (end != cursor) {
+                cursor = end;
+                text += ' ';
+                continue;
+            }
+            if (c == '\0' || c == ';' || (depth == 0 && ((c == ':' && cursor[1] == '=') ||
+                                                          (inCall && (c == ',' || c == ')'))))) {
+                break;
+            }
+            if (c == '(') {
+                depth++;
+            } else if (c == ')') {
+                if (depth == 0) {
+                    return fail("unbalanced ')'");
+                }
+                depth--;
+            } else if (c == '\'' || c == '"') {
+                return fail("string literals are not supported");
+            }
+            if (isNameStart(c)) {
+                const char* wordStart = cursor;
+                std::string word;
+                const char* wordAt;
+                readName(word, wordAt);
+                if (depth == 0 && word.find('.') == std::string::npos && atStop(word, stops)) {
+                    cursor = wordStart;
+                    break;
+                }
+                if (*cursor == '#') {
+                    if (!rewriteLiteral(word, text)) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (const char* op = bitOperator(word)) {
+                    text += op;
+                    continue;
+                }
+                std::string name;
+                if (!memberName(word, wordAt, name)) {
+                    return false;
+                }
+                text += name;
+                continue;
+            }
+            if (isdigit(static_cast<unsigned char>(c))) {
+                if (!rewriteNumber(text)) {
+                    return false;
+                }
+                continue;
+            }
+            text += c;
+            cursor++;
+        }
+        while (!text.empty() && text.back() == ' ') {
+            text.pop_back();
+        }
+        if (error.empty() && text.find_first_not_of(' ') == std::string::npos) {
+            return fail("expected an expression");
+        }
+        return error.empty();
+    }
+
+    static bool atStop(const std::string& word, const char* const* stops) {
+        for (; *stops; stops++) {
+            if (equalsIgnoreCase(word, *stops)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // AND, OR and XOR work bit by bit on integers in ST. The bit operators
+    // of PlcExpression do, and give the same result on bools, with the
+    // precedence of ST (comparison, AND, XOR, OR).
+    static const char* bitOperator(const std::string& word) {
+        if (equalsIgnoreCase(word, "and")) return " & ";
+        if (equalsIgnoreCase(word, "or")) return " | ";
+        if (equalsIgnoreCase(word, "xor")) return " ^ ";
+        return nullptr;
+    }
+
+    // Digits with '_' separators; 16#FF and 2#1010 become hex literals
+    bool rewriteNumber(std::string& text) {
+        const char* start = cursor;
+        std::string digits;
+        while (isdigit(static_cast<unsigned char>(*cursor)) || *cursor == '_') {
+            if (*cursor != '_') {
+                digits += *cursor;
+            }
+            cursor++;
+        }
+        if (*cursor == '#') {
+            cursor++;
+            uint32_t value;
+            if (!readBaseDigits(atoi(digits.c_str()), value, start)) {
+                return false;
+            }
+            char hex[16];
+            snprintf(hex, sizeof(hex), "0x%lX", static_cast<unsigned long>(value));
+            text += hex;
+            return true;
+        }
+        // Fraction and exponent are copied as they are
+        while (isalnum(static_cast<unsigned char>(*cursor)) || *cursor == '_' ||
+               (*cursor == '.' && isdigit(static_cast<unsigned char>(cursor[1]))) ||
+               ((*cursor == '+' || *cursor == '-') && (cursor[-1] == 'e' || cursor[-1] == 'E'))) {
+            if (*cursor != '_') {
+                digits += *cursor;
+            }
+            cursor++;
+        }
+        text += digits;
+        return true;
+    }
+
+    bool readBaseDigits(int base, uint32_t& value, const char* at) {
+        if (base != 2 && base != 8 && base != 16) {
+            return fail("invalid number", at);
+        }
+        uint64_t result = 0;
+        size_t count = 0;
+        for (; isalnum(static_cast<unsigned char>(*cursor)) || *cursor == '_'; cursor++) {
+            if (*cursor == '_') {
+                continue;
+            }
+            int digit = isdigit(static_cast<unsigned char>(*cursor)) ? *cursor - '0'
+                      : tolower(static_cast<unsigned char>(*cursor)) - 'a' + 10;
+            if (digit >= base) {
+                return fail("invalid number", at);
+            }
+            result = result * base + digit;
+            if (result > 0xFFFFFFFFull) {
+                return fail("invalid number", at);
+            }
+            count++;
+        }
+        value = static_cast<uint32_t>(result);
+        return count > 0 || fail("invalid number", at);
+    }
+
+    // prefix# literal: T#1m30s in milliseconds, a typed literal without its type
+    bool rewriteLiteral(const std::string& prefix, std::string& text) {
+        const char* at = cursor - prefix.size();
+        cursor++; // '#'
+        if (equalsIgnoreCase(prefix, "t") || equalsIgnoreCase(prefix, "time")) {
+            int32_t ms;
+            if (!readDuration(ms, at)) {
+                return false;
+            }
+            text += std::to_string(ms);
+            return true;
+        }
+        if (findElementaryType(prefix) == nullptr) {
+            return fail("unknown literal prefix '" + prefix + "#'", at);
+        }
+        return true; // The value follows
+    }
+
+    bool readDuration(int32_t& ms, const char* at) {
+        bool negative = *cursor == '-';
+        if (negative) {
+            cursor++;
+        }
+        double total = 0;
+        size_t parts = 0;
+        while (isdigit(static_cast<unsigned char>(*cursor))) {
+            char* end;
+            double value = strtod(cursor, &end);
+            cursor = end;
+            static const struct { const char* unit; double ms; } UNITS[] = {
+                {"ms", 1}, {"d", 86400000}, {"h", 3600000}, {"m", 60000}, {"s", 1000}
+            };
+            bool found = false;
+            for (const auto& unit : UNITS) {
+                size_t length = strlen(unit.unit);
+                if (strncasecmp(cursor, unit.unit, length) == 0 &&
+                    !(length == 1 && unit.unit[0] == 'm' && tolower(static_cast<unsigned char>(cursor[1])) == 's')) {
+                    total += value * unit.ms;
+                    cursor += length;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                return fail("invalid time literal", at);
+            }
+            parts++;
+            if (*cursor == '_') {
+                cursor++;
+            }
+        }
+        if (parts == 0 || total > INT32_MAX) {
+            return fail("invalid time literal", at);
+        }
+        ms = static_cast<int32_t>(lround(negative ? -total : total));
+        return true;
+    }
+
+    // Variable name of a name in the source: members of a function block
+    // instance are the lower-case pin names
+    bool memberName(const std::string& word, const char* at, std::string& name, bool inCall = false) {
+        size_t dot = word.find('.');
+        long instance = findInstance(word.substr(0, dot));
+        if (instance < 0) {
+            name = word;
+            return true;
+        }
+        if (dot == std::string::npos) {
+            if (*cursor == '(' || (skipSpace(), *cursor == '(')) {
+                return fail("function block '" + word + "' can only be called as a statement", at);
+            }
+            return fail("function block '" + word + "' is not a variable", at);
+        }
+        std::string pin = lower(word.substr(dot + 1));
+        const PlcBlockDescriptor* descriptor = program.instances[instance].type->descriptor;
+        const PlcPinInfo* info = findPin(descriptor->inputs, pin);
+        bool output = false;
+        if (info == nullptr) {
+            info = findPin(descriptor->outputs, pin);
+            output = true;
+        }
+        if (info == nullptr) {
+            return fail("'" + program.instances[instance].name + "' has no pin '" + pin + "'", at);
+        }
+        InstanceUse& use = uses[instance];
+        if (use.presetPin && pin == use.presetPin) {
+            return fail("'" + pin + "' of '" + program.instances[instance].name + "' is a constant", at);
+        }
+        name = program.instances[instance].name + "." + pin;
+        memory.resolve(name.c_str(), pinType(info->type)); // Declared with the pin type
+        if (output && std::find(use.outputs.begin(), use.outputs.end(), info->name) == use.outputs.end()) {
+            use.outputs.push_back(info->name);
+        }
+        if (!inCall && std::find(use.named.begin(), use.named.end(), info->name) == use.named.end()) {
+            use.named.push_back(info->name);
+        }
+        return true;
+    }
+
+    static const PlcPinInfo* findPin(const PlcPinInfo* pins, const std::string& name) {
+        for (; pins && pins->name; pins++) {
+            if (name == pins->name) {
+                return pins;
+            }
+        }
+        return nullptr;
+    }
+
+    long findInstance(const std::string& name) const {
+        for (size_t i = 0; i < program.instances.size(); i++) {
+            if (program.instances[i].name == name) {
+                return static_cast<long>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Compile an expression; returns its index or -1
+    long compileExpression(const std::string& text, const char* at, Type hint) {
+        if (program.expressions.size() >= 0xFFFF) {
+            fail("program too large", at);
+            return -1;
+        }
+        PlcExpression expression;
+        if (!expression.compile(text.c_str(), read, context, arena, &scope, hint)) {
+            fail(std::string(expression.getError()) + " in '" + text + "'", at);
+            return -1;
+        }
+        program.expressions.push_back(std::move(expression));
+        return static_cast<long>(program.expressions.size()) - 1;
+    }
+
+    // A condition folded to a constant, its value in value
+    bool constantCondition(long index, bool& value) {
+        const PlcExpression& expression = program.expressions[index];
+        if (!expression.isConstant()) {
+            return false;
+        }
+        PlcExprValue result = expression.evaluate(memory);
+        value = expression.getType() == Type::REAL ? result.f != 0.0f : result.i != 0;
+        return true;
+    }
+
+    void dropLastExpression() {
+        program.expressions.pop_back();
+    }
+
+    // ========== Code ==========
+
+    size_t emit(PlcStOpcode op, size_t a = 0, size_t b = 0, VarHandle var = VarHandle(), Type type = Type::BOOL) {
+        if (code.size() >= 0xFFFF) {
+            fail("program too large");
+            return 0;
+        }
+        PlcStInstruction instruction;
+        instruction.op = static_cast<uint8_t>(op);
+        instruction.type = static_cast<uint8_t>(type);
+        instruction.a = static_cast<uint16_t>(a);
+        instruction.b = static_cast<uint16_t>(b);
+        instruction.var = var;
+        code.push_back(instruction);
+        return code.size() - 1;
+    }
+
+    void patch(const std::vector<size_t>& jumps, size_t target) {
+        for (size_t jump : jumps) {
+            code[jump].b = static_cast<uint16_t>(target);
+        }
+    }
+
+    // name := text
+    bool assign(const std::string& name, const std::string& text, const char* at) {
+        VarHandle existing = memory.findHandle(name);
+        if (existing.isValid() && existing.type == PlcValueType::STRING_TYPE) {
+            return fail("cannot assign to string variable '" + name + "'", at);
+        }
+        long expression = compileExpression(text, at, existing.isValid() ? hintFor(existing.type) : Type::REAL);
+        if (expression < 0) {
+            return false;
+        }
+        Type type = program.expressions[expression].getType();
+        VarHandle var = write(context, name.c_str(), existing.isValid() ? existing.type : PlcExpression::slotType(type));
+        if (!var.isValid()) {
+            return fail("cannot bind variable '" + name + "'", at);
+        }
+        emit(PlcStOpcode::ASSIGN, expression, 0, var, type);
+        scope.invalidate(var.index);
+        return true;
+    }
+
+    Mark mark() {
+        Mark m;
+        m.code = code.size();
+        m.expressions = program.expressions.size();
+        m.returns = returns.size();
+        for (const Loop& loop : loops) {
+            m.exits.push_back(loop.exits.size());
+        }
+        m.scope = scope.save();
+        return m;
+    }
+
+    // Drop the code compiled since m
+    void drop(const Mark& m) {
+        code.resize(m.code);
+        for (InstanceUse& use : uses) {
+            dropAfter(use.calls, m.code);
+            for (PinArguments& arguments : use.arguments) {
+                dropAfter(arguments.assigns, m.code);
+            }
+        }
+        program.expressions.erase(program.expressions.begin() + m.expressions, program.expressions.end());
+        returns.resize(m.returns);
+        for (size_t i = 0; i < m.exits.size() && i < loops.size(); i++) {
+            loops[i].exits.resize(m.exits[i]);
+        }
+        scope.restore(m.scope);
+    }
+
+    static void dropAfter(std::vector<size_t>& positions, size_t end) {
+        while (!positions.empty() && positions.back() >= end) {
+            positions.pop_back();
+        }
+    }
+
+    // condition: expression index, -1 for ELSE
+    void beginBranch(Branches& branches, Branch& branch, long condition) {
+        branch.dead = branches.taken;
+        branch.jump = -1;
+        bool value = true;
+        if (condition >= 0 && constantCondition(condition, value)) {
+            dropLastExpression();
+            condition = -1;
+        }
+        if (!value) {
+            branch.dead = true;
+        } else if (!branch.dead && condition >= 0) {
+            Type type = program.expressions[condition].getType();
+            branch.jump = static_cast<long>(emit(PlcStOpcode::JUMP_IF_NOT, condition, 0, VarHandle(), type));
+            branch.next = scope.save();
+        }
+        if (!branch.dead && branch.jump < 0) {
+            branches.taken = true;
+        }
+    }
+
+    void endBranch(Branches& branches, Branch& branch, bool last) {
+        if (branch.dead) {
+            drop(branch.mark);
+            program.droppedBranches++;
+            return;
+        }
+        if (branch.jump >= 0) {
+            if (!last) {
+                branches.ends.push_back(emit(PlcStOpcode::JUMP));
+            }
+            code[branch.jump].b = static_cast<uint16_t>(code.size());
+            scope.restore(branch.next);
+            branches.joined = true;
+        }
+    }
+
+    void endBranches(Branches& branches) {
+        patch(branches.ends, code.size());
+        if (branches.joined) {
+            scope.clear();
+        }
+    }
+
+    // Loop head: a jump target
+    size_t label() {
+        scope.clear();
+        return code.size();
+    }
+
+    size_t newLoop() {
+        program.loopCounts.push_back(0);
+        return program.loopCounts.size() - 1;
+    }
+
+    // ========== Declarations ==========
+
+    bool atVarSection() {
+        return atWord("var") || atWord("var_input") || atWord("var_output") || atWord("var_in_out") ||
+               atWord("var_temp") || atWord("var_global") || atWord("var_external");
+    }
+
+    // VAR[_INPUT, _OUTPUT, ...] [RETAIN | CONSTANT] name, ... : TYPE [:= value]; ... END_VAR
+    bool parseVarSection() {
+        std::string section;
+        const char* at;
+        readName(section, at);
+        bool retain = acceptWord("retain");
+        acceptWord("non_retain");
+        acceptWord("constant");
+        while (!acceptWord("end_var")) {
+            std::vector<std::string> names;
+            std::vector<const char*> positions;
+            do {
+                std::string name;
+                if (!readName(name, at) || isReserved(name)) {
+                    return fail(*cursor ? "expected a variable name" : "expected END_VAR", at);
+                }
+                names.push_back(name);
+                positions.push_back(at);
+            } while (acceptSymbol(","));
+            if (!expectSymbol(":")) {
+                return false;
+            }
+            std::string typeName;
+            if (!readName(typeName, at)) {
+                return fail("expected a type");
+            }
+            const ElementaryType* elementary = findElementaryType(typeName);
+            for (size_t i = 0; i < names.size(); i++) {
+                bool ok = elementary ? declareVariable(names[i], elementary->type, retain, positions[i])
+                                     : declareInstance(names[i], typeName, positions[i]);
+                if (!ok) {
+                    return false;
+                }
+            }
+            if (acceptSymbol(":=")) {
+                if (!elementary || elementary->type == PlcValueType::STRING_TYPE) {
+                    return fail("only numbers and bools have initial values");
+                }
+                std::string text;
+                if (!scanExpression(text, at, NO_STOPS, false) || !initialize(names, text, at)) {
+                    return false;
+                }
+            }
+            if (!expectSymbol(";")) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool declareVariable(const std::string& name, PlcValueType type, bool retain, const char* at) {
+        VarHandle existing = memory.findHandle(name);
+        if (existing.isValid()) {
+            if (existing.type != type) {
+                return fail("'" + name + "' conflicts with its declaration in the program memory", at);
+            }
+            return true;
+        }
+        if (findInstance(name) >= 0 || !memory.declareVariable(name, type, retain)) {
+            return fail("cannot declare '" + name + "'", at);
+        }
+        return true;
+    }
+
+    // Initial values are set once, when the program is loaded
+    bool initialize(const std::vector<std::string>& names, const std::string& text, const char* at) {
+        VarHandle var = memory.findHandle(names[0]);
+        long index = compileExpression(text, at, hintFor(var.type));
+        if (index < 0) {
+            return false;
+        }
+        PlcExpression& expression = program.expressions[index];
+        if (!expression.isConstant()) {
+            return fail("initial value of '" + names[0] + "' must be a constant", at);
+        }
+        PlcExprValue value = expression.evaluate(memory);
+        for (const std::string& name : names) {
+            store(memory, memory.findHandle(name), expression.getType(), value);
+        }
+        dropLastExpression();
+        return true;
+    }
+
+    bool declareInstance(const std::string& name, const std::string& typeName, const char* at) {
+        const FunctionBlockType* fb = nullptr;
+        for (const FunctionBlockType& type : FUNCTION_BLOCKS) {
+            if (equalsIgnoreCase(typeName, type.type)) {
+                fb = &type;
+            }
+        }
+        if (fb == nullptr) {
+            return fail("unknown type '" + typeName + "'", at);
+        }
+        if (findInstance(name) >= 0 || memory.findHandle(name).isValid() || name.find('.') != std::string::npos) {
+            return fail("'" + name + "' is already declared", at);
+        }
+        const PlcBlockRegistry::Entry* entry = PlcBlockRegistry::find(fb->type);
+        if (entry == nullptr) {
+            return fail("unknown type '" + typeName + "'", at);
+        }
+        Instance instance;
+        instance.name = name;
+        instance.type = entry;
+        instance.block = entry->create(arena, blockContext);
+        instance.inArena = arena != nullptr;
+        program.instances.push_back(instance);
+
+        InstanceUse use;
+        use.presetPin = fb->presetPin;
+        use.hasPreset = false;
+        use.preset = 0;
+        uses.push_back(use);
+        return true;
+    }
+
+    // A pin passed the same variable or constant in every call needs no
+    // copy per call: it is bound to the variable, as in a JSON program, and
+    // a constant is stored once. Outputs are only bound to variables
+    // nothing else writes, as counters and latches keep their state there.
+    bool bindPins() {
+        std::vector<bool> removed(code.size(), false);
+        for (InstanceUse& use : uses) {
+            for (const PinArguments& arguments : use.arguments) {
+                if (!arguments.same || arguments.assigns.size() != use.calls.size() ||
+                    std::find(use.named.begin(), use.named.end(), arguments.pin) != use.named.end()) {
+                    continue;
+                }
+                const PlcStInstruction& first = code[arguments.assigns[0]];
+                const PlcExpression& value = program.expressions[first.a];
+                if (arguments.variable.empty()) {
+                    store(memory, first.var, static_cast<Type>(first.type), value.evaluate(memory));
+                } else if (value.getVariable().type != first.var.type ||
+                           (arguments.output && writtenElsewhere(first.var, arguments.assigns))) {
+                    continue;
+                } else {
+                    use.bound.emplace_back(arguments.pin, arguments.variable);
+                }
+                for (size_t assign : arguments.assigns) {
+                    removed[assign] = true;
+                }
+                program.boundPins++;
+            }
+        }
+
+        // Compact the code, moving the jumps along
+        std::vector<uint16_t> position(code.size() + 1);
+        size_t kept = 0;
+        for (size_t i = 0; i < code.size(); i++) {
+            position[i] = static_cast<uint16_t>(kept);
+            kept += !removed[i];
+        }
+        position[code.size()] = static_cast<uint16_t>(kept);
+        for (size_t i = 0; i < code.size(); i++) {
+            if (removed[i]) {
+                continue;
+            }
+            PlcStInstruction instruction = code[i];
+            PlcStOpcode op = static_cast<PlcStOpcode>(instruction.op);
+            if (op == PlcStOpcode::JUMP || op == PlcStOpcode::JUMP_IF_NOT || op == PlcStOpcode::LOOP_CHECK) {
+                instruction.b = position[instruction.b];
+            }
+            code[position[i]] = instruction;
+        }
+        code.resize(kept);
+        return true;
+    }
+
+    bool writtenElsewhere(VarHandle var, const std::vector<size_t>& assigns) const {
+        for (size_t i = 0; i < code.size(); i++) {
+            if (code[i].op == static_cast<uint8_t>(PlcStOpcode::ASSIGN) && code[i].var.index == var.index &&
+                std::find(assigns.begin(), assigns.end(), i) == assigns.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static const char* boundVariable(const InstanceUse& use, const char* pin) {
+        for (const auto& binding : use.bound) {
+            if (binding.first == pin) {
+                return binding.second.c_str();
+            }
+        }
+        return nullptr;
+    }
+
+    // Bind the pins used by the program and configure each instance
+    bool configureInstances() {
+        for (size_t i = 0; i < program.instances.size(); i++) {
+            Instance& instance = program.instances[i];
+            const InstanceUse& use = uses[i];
+            JsonDocument config;
+            JsonObject inputs = config["inputs"].to<JsonObject>();
+            JsonObject outputs = config["outputs"].to<JsonObject>();
+            // Inputs not assigned by the program stay FALSE/0. Counters and
+            // latches keep their state in their outputs, so all are bound;
+            // ET only when read, as it makes a timer run every scan.
+            for (const PlcPinInfo* pin = instance.type->descriptor->inputs; pin->name; pin++) {
+                if (use.presetPin == nullptr || strcmp(pin->name, use.presetPin) != 0) {
+                    const char* variable = boundVariable(use, pin->name);
+                    inputs[pin->name] = variable ? String(variable) : String((instance.name + "." + pin->name).c_str());
+                }
+            }
+            for (const PlcPinInfo* pin = instance.type->descriptor->outputs; pin->name; pin++) {
+                bool used = std::find(use.outputs.begin(), use.outputs.end(), pin->name) != use.outputs.end();
+                if (used || strcmp(pin->name, "et") != 0) {
+                    const char* variable = boundVariable(use, pin->name);
+                    outputs[pin->name] = variable ? String(variable) : String((instance.name + "." + pin->name).c_str());
+                }
+            }
+            if (use.presetPin) {
+                inputs[use.presetPin] = use.preset;
+            }
+            if (!instance.block->configure(config.as<JsonObject>(), memory)) {
+                return fail("cannot configure function block '" + instance.name + "'", source);
+            }
+        }
+        return true;
+    }
+
+    bool finish() {
+        std::vector<PlcExpression*> expressions;
+        for (PlcExpression& expression : program.expressions) {
+            expressions.push_back(&expression);
+        }
+        size_t temps = scope.finish(expressions.data(), expressions.size());
+        PlcExprValue zero;
+        zero.i = 0;
+        program.temps.assign(temps, zero);
+        program.sharedCount = scope.getSharedCount();
+        program.code.assign(code.begin(), code.end());
+        return true;
+    }
+
+    // ========== Statements ==========
+
+    // Statements up to one of the stop words or the end of the source; in a
+    // CASE, also up to the next label
+    bool parseStatements(const char* const* stops, bool caseLabels) {
+        while (error.empty()) {
+            skipSpace();
+            if (*cursor == '\0' || atAnyWord(stops)) {
+                return true;
+            }
+            if (caseLabels && (isdigit(static_cast<unsigned char>(*cursor)) || *cursor == '-')) {
+                return true;
+            }
+            if (!parseStatement()) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseStatement() {
+        if (acceptSymbol(";")) {
+            return true;
+        }
+        if (acceptWord("if")) {
+            return parseIf();
+        }
+        if (acceptWord("case")) {
+            return parseCase();
+        }
+        if (acceptWord("for")) {
+            return parseFor();
+        }
+        if (acceptWord("while")) {
+            return parseWhile();
+        }
+        if (acceptWord("repeat")) {
+            return parseRepeat();
+        }
+        const char* at = cursor;
+        if (acceptWord("exit")) {
+            if (loops.empty()) {
+                return fail("EXIT outside of a loop", at);
+            }
+            loops.back().exits.push_back(emit(PlcStOpcode::JUMP));
+            return expectSymbol(";");
+        }
+        if (acceptWord("return")) {
+            returns.push_back(emit(PlcStOpcode::JUMP));
+            return expectSymbol(";");
+        }
+
+        std::string name;
+        if (!readName(name, at)) {
+            return fail("expected a statement");
+        }
+        if (isReserved(name)) {
+            return fail("unexpected '" + name + "'", at);
+        }
+        skipSpace();
+        long instance = findInstance(name);
+        if (instance >= 0 && *cursor == '(') {
+            cursor++;
+            return parseCall(static_cast<size_t>(instance), at);
+        }
+        std::string target;
+        if (!memberName(name, at, target) || !expectSymbol(":=")) {
+            return false;
+        }
+        std::string text;
+        const char* textAt;
+        return scanExpression(text, textAt, NO_STOPS, false) && assign(target, text, at) && expectSymbol(";");
+    }
+
+    // inst(pin := value, ..., output => variable, ...);
+    bool parseCall(size_t instance, const char* at) {
+        InstanceUse& use = uses[instance];
+        const std::string& instanceName = program.instances[instance].name;
+        std::vector<std::pair<std::string, std::string>> results; // Variable, pin
+        skipSpace();
+        while (*cursor != ')') {
+            std::string pin;
+            const char* pinAt;
+            if (!readName(pin, pinAt)) {
+                return fail("expected a pin name");
+            }
+            pin = lower(pin);
+            if (acceptSymbol(":=")) {
+                std::string text;
+                const char* textAt;
+                if (!scanExpression(text, textAt, NO_STOPS, true)) {
+                    return false;
+                }
+                if (use.presetPin && pin == use.presetPin) {
+                    if (!setPreset(instance, text, textAt)) {
+                        return false;
+                    }
+                } else {
+                    std::string member;
+                    if (!memberName(instanceName + "." + pin, pinAt, member, true) || !assign(member, text, textAt)) {
+                        return false;
+                    }
+                    const PlcExpression& argument = program.expressions[code.back().a];
+                    if (argument.getVariable().isValid()) {
+                        addArgument(instance, pin, false, text);
+                    } else {
+                        addArgument(instance, pin, false, argument.isConstant() ? "" : "(");
+                    }
+                }
+            } else if (acceptSymbol("=>")) {
+                std::string variable;
+                const char* variableAt;
+                std::string member;
+                if (!readName(variable, variableAt)) {
+                    return fail("expected a variable name");
+                }
+                if (!memberName(instanceName + "." + pin, pinAt, member, true)) {
+                    return false;
+                }
+                results.emplace_back(variable, pin);
+            } else {
+                return fail("expected ':=' or '=>'");
+            }
+            if (!acceptSymbol(",")) {
+                skipSpace();
+                if (*cursor != ')') {
+                    return fail("expected ',' or ')'");
+                }
+            }
+        }
+        cursor++;
+        if (!expectSymbol(";")) {
+            return false;
+        }
+        use.calls.push_back(emit(PlcStOpcode::CALL, instance));
+        scope.clear(); // The outputs changed
+        for (const auto& result : results) {
+            std::string target;
+            std::string member = instanceName + "." + result.second;
+            if (!memberName(result.first, at, target)) {
+                return false;
+            }
+            if (!memory.findHandle(target).isValid()) {
+                write(context, target.c_str(), memory.findHandle(member).type); // Same type as the pin
+            }
+            if (!assign(target, member, at)) {
+                return false;
+            }
+            addArgument(instance, result.second, true, target);
+        }
+        return true;
+    }
+
+    // Record the argument of the ASSIGN just emitted for a pin. variable is
+    // the variable passed, "" for a constant and "(" for anything else.
+    void addArgument(size_t instance, const std::string& pin, bool output, const std::string& variable) {
+        InstanceUse& use = uses[instance];
+        const PlcBlockDescriptor* descriptor = program.instances[instance].type->descriptor;
+        const PlcPinInfo* info = findPin(output ? descriptor->outputs : descriptor->inputs, pin);
+        PinArguments* arguments = nullptr;
+        for (PinArguments& candidate : use.arguments) {
+            if (candidate.pin == info->name) {
+                arguments = &candidate;
+            }
+        }
+        if (arguments == nullptr) {
+            use.arguments.emplace_back();
+            arguments = &use.arguments.back();
+            arguments->pin = info->name;
+            arguments->output = output;
+            arguments->same = true;
+            arguments->variable = variable;
+        }
+        if (variable != arguments->variable || variable == "(" ||
+            (variable.empty() && !arguments->assigns.empty() && !sameConstant(arguments->assigns[0], code.size() - 1))) {
+            arguments->same = false;
+        }
+        arguments->assigns.push_back(code.size() - 1);
+    }
+
+    bool sameConstant(size_t first, size_t second) {
+        PlcExprValue a = program.expressions[code[first].a].evaluate(memory);
+        PlcExprValue b = program.expressions[code[second].a].evaluate(memory);
+        return code[first].type == code[second].type && a.i == b.i;
+    }
+
+    bool setPreset(size_t instance, const std::string& text, const char* at) {
+        InstanceUse& use = uses[instance];
+        long index = compileExpression(text, at, Type::INT);
+        if (index < 0) {
+            return false;
+        }
+        const PlcExpression& expression = program.expressions[index];
+        if (!expression.isConstant()) {
+            return fail("'" + std::string(use.presetPin) + "' of '" + program.instances[instance].name + "' must be a constant", at);
+        }
+        PlcExprValue value = expression.evaluate(memory);
+        int32_t preset = expression.getType() == Type::REAL ? static_cast<int32_t>(value.f) : value.i;
+        dropLastExpression();
+        if (use.hasPreset && preset != use.preset) {
+            return fail("'" + std::string(use.presetPin) + "' of '" + program.instances[instance].name + "' must be the same in every call", at);
+        }
+        use.hasPreset = true;
+        use.preset = preset;
+        return true;
+    }
+
+    bool parseCondition(const char* const* stops, const char* keyword, long& index) {
+        std::string text;
+        const char* at;
+        if (!scanExpression(text, at, stops, false) || !expectWord(keyword)) {
+            return false;
+        }
+        index = compileExpression(text, at, Type::BOOL);
+        return index >= 0;
+    }
+
+    // IF c THEN ... {ELSIF c THEN ...} [ELSE ...] END_IF
+    bool parseIf() {
+        Branches branches;
+        long condition;
+        bool isElse = false;
+        while (true) {
+            Branch branch;
+            branch.mark = mark();
+            if (!isElse && !parseCondition(THEN_STOPS, "then", condition)) {
+                return false;
+            }
+            beginBranch(branches, branch, isElse ? -1 : condition);
+            if (!parseStatements(IF_BODY_STOPS, false)) {
+                return false;
+            }
+            bool more = !isElse && (atWord("elsif") || atWord("else"));
+            endBranch(branches, branch, !more);
+            if (!more) {
+                break;
+            }
+            isElse = !acceptWord("elsif");
+            if (isElse) {
+                acceptWord("else");
+            }
+        }
+        if (!expectWord("end_if")) {
+            return false;
+        }
+        endBranches(branches);
+        return true;
+    }
+
+    // CASE selector OF 1: ... 2, 5..7: ... [ELSE ...] END_CASE. Each label
+    // list is a condition on the selector, which is computed once when it
+    // is not a plain variable (shared subexpression).
+    bool parseCase() {
+        std::string selector;
+        const char* at;
+        if (!scanExpression(selector, at, OF_STOPS, false) || !expectWord("of")) {
+            return false;
+        }
+        Branches branches;
+        while (error.empty()) {
+            skipSpace();
+            if (atWord("end_case") || *cursor == '\0') {
+                break;
+            }
+            Branch branch;
+            branch.mark = mark();
+            long condition = -1;
+            bool isElse = acceptWord("else");
+            if (!isElse) {
+                std::string text;
+                const char* labelAt = cursor;
+                if (!parseLabels(selector, text)) {
+                    return false;
+                }
+                condition = compileExpression(text, labelAt, Type::BOOL);
+                if (condition < 0) {
+                    return false;
+                }
+            }
+            beginBranch(branches, branch, condition);
+            if (!parseStatements(isElse ? CASE_BODY_STOPS + 1 : CASE_BODY_STOPS, !isElse)) {
+                return false;
+            }
+            skipSpace();
+            endBranch(branches, branch, isElse || atWord("end_case"));
+            if (isElse) {
+                break;
+            }
+        }
+        if (!expectWord("end_case")) {
+            return false;
+        }
+        endBranches(branches);
+        return true;
+    }
+
+    // 1, 3..5: as (sel) = 1 || ((sel) >= 3 && (sel) <= 5)
+    bool parseLabels(const std::string& selector, std::string& condition) {
+        do {
+            int32_t low, high;
+            if (!readLabel(low)) {
+                return false;
+            }
+            high = low;
+            if (acceptSymbol("..") && !readLabel(high)) {
+                return false;
+            }
+            if (!condition.empty()) {
+                condition += " || ";
+            }
+            if (low == high) {
+                condition += "(" + selector + ") = " + std::to_string(low);
+            } else {
+                condition += "((" + selector + ") >= " + std::to_string(low) + " && (" + selector + ") <= " + std::to_string(high) + ")";
+            }
+        } while (acceptSymbol(","));
+        return expectSymbol(":");
+    }
+
+    bool readLabel(int32_t& value) {
+        skipSpace();
+        const char* at = cursor;
+        bool negative = acceptSymbol("-");
+        skipSpace();
+        if (!isdigit(static_cast<unsigned char>(*cursor))) {
+            return fail("expected a CASE label", at);
+        }
+        std::string text;
+        if (!rewriteNumber(text)) {
+            return false;
+        }
+        char* end;
+        long long parsed = strtoll(text.c_str(), &end, 0);
+        if (*end != '\0' || parsed > INT32_MAX) {
+            return fail("CASE labels must be integers", at);
+        }
+        value = static_cast<int32_t>(negative ? -parsed : parsed);
+        return true;
+    }
+
+    // FOR i := a TO b [BY step] DO ... END_FOR. The end value is evaluated
+    // before each iteration, the step must be a constant.
+    bool parseFor() {
+        std::string name, start, end, step = "1";
+        const char* at;
+        const char* textAt;
+        if (!readName(name, at) || isReserved(name)) {
+            return fail("expected the FOR variable");
+        }
+        std::string variable;
+        if (!memberName(name, at, variable) || !expectSymbol(":=") ||
+            !scanExpression(start, textAt, TO_STOPS, false) || !expectWord("to") ||
+            !scanExpression(end, textAt, FOR_END_STOPS, false)) {
+            return false;
+        }
+        const char* stepAt = cursor;
+        if (acceptWord("by") && !scanExpression(step, stepAt, DO_STOPS, false)) {
+            return false;
+        }
+        if (!expectWord("do")) {
+            return false;
+        }
+        long index = compileExpression(step, stepAt, Type::INT);
+        if (index < 0) {
+            return false;
+        }
+        const PlcExpression& stepExpression = program.expressions[index];
+        int32_t increment = stepExpression.evaluate(memory).i;
+        if (!stepExpression.isConstant() || stepExpression.getType() != Type::INT || increment == 0) {
+            return fail("FOR step must be a non-zero integer constant", stepAt);
+        }
+        dropLastExpression();
+
+        VarHandle existing = memory.findHandle(variable);
+        if (!existing.isValid()) {
+            memory.resolve(variable.c_str(), PlcValueType::DINT);
+        } else if (existing.type == PlcValueType::BOOL || existing.type == PlcValueType::REAL ||
+                   existing.type == PlcValueType::STRING_TYPE) {
+            return fail("FOR variable must be an integer", at);
+        }
+        if (!assign(variable, start, at)) {
+            return false;
+        }
+        size_t loop = newLoop();
+        emit(PlcStOpcode::LOOP_START, loop);
+        size_t head = label();
+        std::string test = variable + (increment > 0 ? " <= (" : " >= (") + end + ")";
+        long condition = compileExpression(test, at, Type::BOOL);
+        if (condition < 0) {
+            return false;
+        }
+        loops.emplace_back();
+        loops.back().exits.push_back(emit(PlcStOpcode::JUMP_IF_NOT, condition, 0, VarHandle(), Type::BOOL));
+        loops.back().exits.push_back(emit(PlcStOpcode::LOOP_CHECK, loop));
+        if (!parseStatements(FOR_BODY_STOPS, false) || !expectWord("end_for") ||
+            !assign(variable, variable + " + " + std::to_string(increment), at)) {
+            return false;
+        }
+        return closeLoop(head);
+    }
+
+    // WHILE c DO ... END_WHILE
+    bool parseWhile() {
+        Mark start = mark();
+        std::string text;
+        const char* at;
+        if (!scanExpression(text, at, DO_STOPS, false) || !expectWord("do")) {
+            return false;
+        }
+        size_t loop = newLoop();
+        emit(PlcStOpcode::LOOP_START, loop);
+        size_t head = label();
+        long condition = compileExpression(text, at, Type::BOOL);
+        if (condition < 0) {
+            return false;
+        }
+        bool value = true;
+        bool constant = constantCondition(condition, value);
+        loops.emplace_back();
+        if (constant) {
+            dropLastExpression();
+        } else {
+            Type type = program.expressions[condition].getType();
+            loops.back().exits.push_back(emit(PlcStOpcode::JUMP_IF_NOT, condition, 0, VarHandle(), type));
+        }
+        loops.back().exits.push_back(emit(PlcStOpcode::LOOP_CHECK, loop));
+        if (!parseStatements(WHILE_BODY_STOPS, false) || !expectWord("end_while") || !closeLoop(head)) {
+            return false;
+        }
+        if (!value) {
+            drop(start); // WHILE FALSE
+            program.droppedBranches++;
+        }
+        return true;
+    }
+
+    // REPEAT ... UNTIL c END_REPEAT
+    bool parseRepeat() {
+        size_t loop = newLoop();
+        emit(PlcStOpcode::LOOP_START, loop);
+        size_t head = label();
+        loops.emplace_back();
+        loops.back().exits.push_back(emit(PlcStOpcode::LOOP_CHECK, loop));
+        long condition;
+        if (!parseStatements(REPEAT_BODY_STOPS, false) || !expectWord("until") ||
+            !parseCondition(UNTIL_STOPS, "end_repeat", condition)) {
+            return false;
+        }
+        bool value;
+        if (constantCondition(condition, value)) {
+            dropLastExpression();
+            if (!value) {
+                emit(PlcStOpcode::JUMP, 0, head);
+            }
+        } else {
+            Type type = program.expressions[condition].getType();
+            emit(PlcStOpcode::JUMP_IF_NOT, condition, head, VarHandle(), type);
+        }
+        patch(loops.back().exits, code.size());
+        loops.pop_back();
+        label();
+        return true;
+    }
+
+    // Jump back to head, the exits land after the loop
+    bool closeLoop(size_t head) {
+        emit(PlcStOpcode::JUMP, 0, head);
+        patch(loops.back().exits, code.size());
+        loops.pop_back();
+        label();
+        return error.empty();
+    }
+};
+
+// ========== PlcStructuredText ==========
+
+PlcStructuredText::PlcStructuredText()
+    : maxIterations(DEFAULT_MAX_ITERATIONS), loopLimitCount(0), sharedCount(0), droppedBranches(0), boundPins(0), errorLine(0) {
+}
+
+PlcStructuredText::~PlcStructuredText() {
+    release();
+}
+
+void PlcStructuredText::release() {
+    for (Instance& instance : instances) {
+        if (instance.inArena) {
+            instance.block->~PlcBlock();
+        } else {
+            delete instance.block;
+        }
+    }
+    instances.clear();
+    code.clear();
+    expressions.clear();
+    temps.clear();
+    loopCounts.clear();
+    sharedCount = 0;
+    droppedBranches = 0;
+    boundPins = 0;
+    loopLimitCount = 0;
+}
+
+bool PlcStructuredText::compile(const char* source, PlcMemory& memory, Binder read, Binder write, void* context,
+                                const PlcBlockContext& blockContext, PlcArena* arena, uint32_t iterations) {
+    release();
+    PlcArenaVector<PlcStInstruction>(PlcArenaAllocator<PlcStInstruction>(arena)).swap(code);
+    PlcArenaVector<PlcExprValue>(PlcArenaAllocator<PlcExprValue>(arena)).swap(temps);
+    maxIterations = iterations > 0 ? iterations : DEFAULT_MAX_ITERATIONS;
+    error.clear();
+    errorLine = 0;
+    if (source == nullptr || strlen(source) > MAX_SOURCE) {
+        error = source ? "program too long" : "no source";
+        return false;
+    }
+
+    Compiler compiler(*this, source, memory, read, write, context, blockContext, arena);
+    if (!compiler.compile()) {
+        error = compiler.error;
+        errorLine = compiler.errorLine;
+        release();
+        return false;
+    }
+    return true;
+}
+
+void PlcStructuredText::store(PlcMemory& memory, VarHandle var, PlcExpression::Type type, PlcExprValue value) {
+    switch (type) {
+        case PlcExpression::Type::BOOL: memory.setValue<bool>(var, value.i != 0); break;
+        case PlcExpression::Type::INT: memory.setValue<int32_t>(var, value.i); break;
+        case PlcExpression::Type::REAL: memory.setValue<float>(var, value.f); break;
+    }
+}
+
+void PlcStructuredText::execute(PlcMemory& memory) {
+    const PlcStInstruction* base = code.data();
+    const PlcStInstruction* ip = base;
+    PlcExprValue* t = temps.data();
+    if (ip == nullptr) {
+        return; // Not compiled
+    }
+    while (true) {
+        switch (static_cast<PlcStOpcode>(ip->op)) {
+            case PlcStOpcode::ASSIGN:
+                store(memory, ip->var, static_cast<PlcExpression::Type>(ip->type), expressions[ip->a].evaluate(memory, t));
+                ip++;
+                break;
+            case PlcStOpcode::JUMP:
+                ip = base + ip->b;
+                break;
+            case PlcStOpcode::JUMP_IF_NOT: {
+                PlcExprValue value = expressions[ip->a].evaluate(memory, t);
+                bool truth = static_cast<PlcExpression::Type>(ip->type) == PlcExpression::Type::REAL ? value.f != 0.0f : value.i != 0;
+                ip = truth ? ip + 1 : base + ip->b;
+                break;
+            }
+            case PlcStOpcode::CALL:
+                instances[ip->a].block->evaluate(memory);
+                ip++;
+                break;
+            case PlcStOpcode::LOOP_START:
+                loopCounts[ip->a] = 0;
+                ip++;
+                break;
+            case PlcStOpcode::LOOP_CHECK:
+                if (++loopCounts[ip->a] > maxIterations) {
+                    loopLimitCount++;
+                    ip = base + ip->b;
+                } else {
+                    ip++;
+                }
+                break;
+            case PlcStOpcode::END:
+                return;
+        }
+    }
+}
+
+void PlcStructuredText::migrateState(const PlcStructuredText& previous) {
+    for (Instance& instance : instances) {
+        for (const Instance& old : previous.instances) {
+            if (old.name == instance.name && old.type == instance.type) {
+                instance.block->migrateState(*old.block);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef PLC_STRUCTURED_TEXT_H
+#define PLC_STRUCTURED_TEXT_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "../PlcEngine/Engine/PlcExpression.h"
+#include "../PlcEngine/Engine/PlcBlockRegistry.h"
+
+/**
+ * Statements of a compiled ST program. Expressions run on the
+ * PlcExpression stack machine; the statements move values into variables
+ * and between the expressions.
+ */
+enum class PlcStOpcode : uint8_t {
+    ASSIGN,         // var = expression a
+    JUMP,           // to b
+    JUMP_IF_NOT,    // to b unless expression a is true
+    CALL,           // evaluate function block instance a
+    LOOP_START,     // reset the iteration count of loop a
+    LOOP_CHECK,     // count an iteration of loop a, leave it (to b) past the limit
+    END
+};
+
+struct PlcStInstruction {
+    uint8_t op;         // PlcStOpcode
+    uint8_t type;       // PlcExpression::Type of expression a
+    uint16_t a;
+    uint16_t b;
+    VarHandle var;
+};
+
+/**
+ * PlcStructuredText - IEC 61131-3 Structured Text subset.
+ *
+ *   PROGRAM main                        (optional)
+ *   VAR
+ *       count : DINT := 0;
+ *       delay : TON;
+ *   END_VAR
+ *   delay(IN := start, PT := T#500ms);
+ *   IF delay.Q AND count < limit THEN
+ *       count := count + 1;
+ *   ELSIF reset THEN
+ *       count := 0;
+ *   END_IF;
+ *   END_PROGRAM
+ *
+ * Statements: assignments, IF/ELSIF/ELSE, CASE with integer labels and
+ * ranges, FOR, WHILE, REPEAT, EXIT, RETURN and calls of function block
+ * instances. Expressions use the PlcExpression syntax, which includes the
+ * ST operators (NOT MOD, = and <>); AND, OR and XOR are bitwise on
+ * integers as in IEC, and T#1s500ms, 16#FF and typed literals (INT#5) are
+ * converted first. Keywords are case-insensitive, variable names are not,
+ * like the names in the "memory" section.
+ *
+ * Variables are those of the program memory. VAR declarations declare the
+ * ones that do not exist yet and set initial values; undeclared names are
+ * declared from their use, as in an EXPR block. A function block instance
+ * is a block of the registry (TON, TOF, TP, CTU, CTD, CTUD, SR, RS) whose
+ * pins are the variables "<instance>.<pin>": a call assigns its inputs and
+ * evaluates the block, and inst.Q reads an output. Time presets (PT) are
+ * block constants, so they must be literals, the same in every call.
+ *
+ * Every loop counts its iterations and is left after maxIterations, so a
+ * program cannot hang the scan; getLoopLimitCount() tells how often.
+ *
+ * The compiler optimizes as it goes: constant subexpressions are folded,
+ * branches with a constant condition are dropped, and subexpressions that
+ * are computed again on the same path without a change of their
+ * variables are loaded from temporaries (PlcExprScope). A pin that gets the
+ * same variable in every call is bound to it like in a JSON program, and
+ * the same constant is stored once, so neither is copied on each call.
+ */
+class PlcStructuredText {
+public:
+    typedef PlcExpression::Binder Binder;
+
+    static constexpr uint32_t DEFAULT_MAX_ITERATIONS = 1000;
+    static constexpr size_t MAX_SOURCE = 65535;
+
+    PlcStructuredText();
+    ~PlcStructuredText();
+
+    // Compile source. Variables read by the program are bound through read,
+    // variables it writes through write (both with context). Function block
+    // instances are created with blockContext, in arena if given.
+    bool compile(const char* source, PlcMemory& memory, Binder read, Binder write, void* context,
+                 const PlcBlockContext& blockContext, PlcArena* arena = nullptr,
+                 uint32_t maxIterations = DEFAULT_MAX_ITERATIONS);
+
+    void execute(PlcMemory& memory);
+
+    // Take over the state of the function block instances with the same
+    // name and type in the previous version of the program (online change)
+    void migrateState(const PlcStructuredText& previous);
+
+    const char* getError() const { return error.c_str(); }
+    unsigned getErrorLine() const { return errorLine; }
+
+    size_t getInstructionCount() const { return code.size(); }
+    size_t getExpressionCount() const { return expressions.size(); }
+    size_t getSharedCount() const { return sharedCount; }           // Subexpressions reused
+    size_t getDroppedBranchCount() const { return droppedBranches; } // Constant conditions
+    size_t getBoundPinCount() const { return boundPins; }           // Arguments without a copy per call
+    uint32_t getLoopLimitCount() const { return loopLimitCount; }
+
+    size_t getInstanceCount() const { return instances.size(); }
+    PlcBlock* getInstance(size_t index) const { return instances[index].block; }
+    const char* getInstanceName(size_t index) const { return instances[index].name.c_str(); }
+
+private:
+    class Compiler;
+
+    struct Instance {
+        std::string name;
+        const PlcBlockRegistry::Entry* type;
+        PlcBlock* block;
+        bool inArena;
+    };
+
+    PlcArenaVector<PlcStInstruction> code;
+    std::vector<PlcExpression> expressions;
+    PlcArenaVector<PlcExprValue> temps;
+    std::vector<uint32_t> loopCounts;
+    std::vector<Instance> instances;
+    uint32_t maxIterations;
+    uint32_t loopLimitCount;
+    size_t sharedCount;
+    size_t droppedBranches;
+    size_t boundPins;
+    std::string error;
+    unsigned errorLine;
+
+    void release();
+    static void store(PlcMemory& memory, VarHandle var, PlcExpression::Type type, PlcExprValue value);
+};
+
+#endif // PLC_STRUCTURED_TEXT_H
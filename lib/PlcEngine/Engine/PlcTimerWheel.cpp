@@ -0,0 +1,241 @@
+#include "../PlcEngine/Engine/PlcTimerWheel.h"
+#include <algorithm>
+
+PlcTimerWheel::PlcTimerWheel()
+    : nowMs(0), lastUs(0), remainderUs(0), started(false), _handler(nullptr), _context(nullptr) {
+    clear();
+}
+
+void PlcTimerWheel::clear() {
+    for (uint8_t level = 0; level < LEVELS; level++) {
+        for (uint8_t slot = 0; slot < SLOTS; slot++) {
+            slots[level][slot] = nullptr;
+        }
+        occupied[level] = 0;
+    }
+    overflow = nullptr;
+    armed = 0;
+}
+
+void PlcTimerWheel::arm(PlcTimer& timer, uint32_t delayMs) {
+    armAt(timer, nowMs, nowMs + delayMs);
+}
+
+void PlcTimerWheel::armAt(PlcTimer& timer, uint32_t start, uint32_t deadline) {
+    if (timer.state == PlcTimer::ARMED) {
+        unlink(timer);
+    }
+    timer.start = start;
+    timer.deadline = deadline;
+    if (static_cast<int32_t>(nowMs - deadline) >= 0) {
+        timer.state = PlcTimer::EXPIRED;
+        return;
+    }
+    timer.state = PlcTimer::ARMED;
+    insert(timer);
+    armed++;
+}
+
+void PlcTimerWheel::disarm(PlcTimer& timer) {
+    if (timer.state == PlcTimer::ARMED) {
+        unlink(timer);
+    }
+    timer.state = PlcTimer::IDLE;
+}
+
+void PlcTimerWheel::migrate(PlcTimer& timer, const PlcTimer& previous) {
+    if (previous.state == PlcTimer::IDLE) {
+        disarm(timer);
+    } else if (previous.state == PlcTimer::EXPIRED) {
+        disarm(timer);
+        timer.start = previous.start;
+        timer.deadline = previous.deadline;
+        timer.state = PlcTimer::EXPIRED;
+    } else {
+        armAt(timer, previous.start, previous.deadline);
+    }
+}
+
+uint32_t PlcTimerWheel::elapsed(const PlcTimer& timer) const {
+    switch (timer.state) {
+        case PlcTimer::ARMED:
+            return nowMs - timer.start;
+        case PlcTimer::EXPIRED:
+            return timer.deadline - timer.start;
+        default:
+            return 0;
+    }
+}
+
+void PlcTimerWheel::insert(PlcTimer& timer) {
+    // Level of the highest slot digit in which the deadline differs from now
+    uint32_t diff = timer.deadline ^ nowMs;
+    uint8_t level = 0;
+    while (level < LEVELS && (diff >> (SLOT_BITS * (level + 1))) != 0) {
+        level++;
+    }
+    PlcTimer** head;
+    if (level == LEVELS) {
+        head = &overflow;
+    } else {
+        uint8_t slot = (timer.deadline >> (SLOT_BITS * level)) & (SLOTS - 1);
+        head = &slots[level][slot];
+        occupied[level] |= 1u << slot;
+    }
+    timer.next = *head;
+    if (timer.next) {
+        timer.next->link = &timer.next;
+    }
+    *head = &timer;
+    timer.link = head;
+}
+
+void PlcTimerWheel::unlink(PlcTimer& timer) {
+    *timer.link = timer.next;
+    if (timer.next) {
+        timer.next->link = timer.link;
+    } else if (timer.link >= &slots[0][0] && timer.link < &slots[0][0] + LEVELS * SLOTS) {
+        // Last timer of a slot
+        size_t index = timer.link - &slots[0][0];
+        if (!slots[index / SLOTS][index % SLOTS]) {
+            occupied[index / SLOTS] &= ~(1u << (index % SLOTS));
+        }
+    }
+    timer.next = nullptr;
+    timer.link = nullptr;
+    armed--;
+}
+
+size_t PlcTimerWheel::expire(PlcTimer& timer) {
+    timer.next = nullptr;
+    timer.link = nullptr;
+    timer.state = PlcTimer::EXPIRED;
+    armed--;
+    if (_handler) {
+        _handler(_context, timer);
+    }
+    return 1;
+}
+
+size_t PlcTimerWheel::cascade(PlcTimer* list) {
+    size_t expired = 0;
+    while (list) {
+        PlcTimer* timer = list;
+        list = list->next;
+        if (timer->deadline == nowMs) {
+            expired += expire(*timer);
+        } else {
+            insert(*timer); // A lower level, now that the higher digits match
+        }
+    }
+    return expired;
+}
+
+size_t PlcTimerWheel::advance(uint32_t targetMs) {
+    size_t expired = 0;
+    while (static_cast<int32_t>(targetMs - nowMs) > 0) {
+        if (armed == 0) {
+            nowMs = targetMs;
+            break;
+        }
+
+        // Nothing happens before the next slot of the lowest occupied level
+        uint8_t lowest = 0;
+        while (lowest < LEVELS && occupied[lowest] == 0) {
+            lowest++;
+        }
+        uint32_t span = 1u << (SLOT_BITS * lowest);
+        uint32_t next = (nowMs & ~(span - 1)) + span;
+        if (static_cast<int32_t>(next - targetMs) > 0) {
+            nowMs = targetMs;
+            break;
+        }
+        nowMs = next;
+
+        // Timers of the slots coming up move down, highest level first
+        for (uint8_t level = LEVELS; level >= 1; level--) {
+            if (nowMs & ((1u << (SLOT_BITS * level)) - 1)) {
+                continue;
+            }
+            PlcTimer* list;
+            if (level == LEVELS) {
+                list = overflow;
+                overflow = nullptr;
+            } else {
+                uint8_t slot = (nowMs >> (SLOT_BITS * level)) & (SLOTS - 1);
+                list = slots[level][slot];
+                slots[level][slot] = nullptr;
+                occupied[level] &= ~(1u << slot);
+            }
+            expired += cascade(list);
+        }
+
+        uint8_t slot = nowMs & (SLOTS - 1);
+        PlcTimer* list = slots[0][slot];
+        slots[0][slot] = nullptr;
+        occupied[0] &= ~(1u << slot);
+        while (list) {
+            PlcTimer* timer = list;
+            list = list->next;
+            expired += expire(*timer);
+        }
+    }
+    return expired;
+}
+
+size_t PlcTimerWheel::advanceMicros(uint32_t nowUs) {
+    if (!started) {
+        started = true;
+        lastUs = nowUs;
+        return 0;
+    }
+    remainderUs += nowUs - lastUs;
+    lastUs = nowUs;
+    uint32_t ms = remainderUs / 1000;
+    remainderUs -= ms * 1000;
+    return advance(nowMs + ms);
+}
+
+bool PlcTimerWheel::nextExpiry(uint32_t& delayMs) const {
+    if (armed == 0) {
+        return false;
+    }
+    uint8_t level = 0;
+    while (level < LEVELS && occupied[level] == 0) {
+        level++;
+    }
+
+    // Slots of a level are all ahead of the current digit, and its timers
+    // share the higher digits with now, so the lowest set bit is the
+    // earliest slot. Its timers (or the overflow list) are not sorted.
+    const PlcTimer* list = overflow;
+    if (level < LEVELS) {
+        uint8_t slot = 0;
+        while (!(occupied[level] & (1u << slot))) {
+            slot++;
+        }
+        list = slots[level][slot];
+    }
+    delayMs = UINT32_MAX;
+    for (; list; list = list->next) {
+        delayMs = std::min<uint32_t>(delayMs, list->deadline - nowMs);
+    }
+    return true;
+}
+
+bool PlcTimerWheel::nextExpiryMicros(uint32_t& deadlineUs) const {
+    uint32_t delayMs;
+    if (!nextExpiry(delayMs)) {
+        return false;
+    }
+    uint64_t untilUs = static_cast<uint64_t>(delayMs) * 1000 - remainderUs;
+    deadlineUs = lastUs + static_cast<uint32_t>(std::min<uint64_t>(untilUs, MAX_EXPIRY_US));
+    return true;
+}
+
+void PlcTimerWheel::syncTo(const PlcTimerWheel& other) {
+    nowMs = other.nowMs;
+    lastUs = other.lastUs;
+    remainderUs = other.remainderUs;
+    started = other.started;
+}
@@ -0,0 +1,118 @@
+#ifndef PLC_TIMER_WHEEL_H
+#define PLC_TIMER_WHEEL_H
+
+#include <Arduino.h>
+
+/**
+ * PlcTimer - a timer of a block (TON, TOF, TP, sequencer step timeout),
+ * embedded in the block and armed in the program's PlcTimerWheel.
+ */
+class PlcTimer {
+public:
+    PlcTimer() : next(nullptr), link(nullptr), start(0), deadline(0), block(NO_BLOCK), state(IDLE) {}
+
+    bool isIdle() const { return state == IDLE; }
+    bool isRunning() const { return state == ARMED; }
+    bool hasExpired() const { return state == EXPIRED; } // Until disarmed or armed again
+
+    // Block woken by the expiry in incremental execution, set by PlcProgram
+    static constexpr uint16_t NO_BLOCK = 0xFFFF;
+    uint16_t getBlock() const { return block; }
+    void setBlock(uint16_t index) { block = index; }
+
+private:
+    friend class PlcTimerWheel;
+    enum : uint8_t { IDLE, ARMED, EXPIRED };
+
+    PlcTimer* next;
+    PlcTimer** link;    // Slot head or previous timer's next pointing here, nullptr unless armed
+    uint32_t start;     // Wheel time (ms) it was armed at
+    uint32_t deadline;
+    uint16_t block;
+    uint8_t state;
+};
+
+/**
+ * PlcTimerWheel - timer service of a PLC program.
+ *
+ * A hierarchical timing wheel with a 1 ms tick: LEVELS levels of SLOTS
+ * slots, level k holding the timers due within the next SLOTS^(k+1) ms,
+ * plus an overflow list for the rest (over ~65 s with the defaults).
+ * Arming and disarming is O(1); advance() moves a timer down a level
+ * when its slot comes up and expires it in level 0, skipping the ticks
+ * in which no slot can come up. Idle timers cost nothing.
+ *
+ * PlcEngine advances the wheel once per cycle from the cycle's clock
+ * reading, before the program is scanned, so blocks see expiries as
+ * events at the start of the cycle and read the time through now()
+ * instead of the clock. Times wrap around after ~49 days; delays must be
+ * below 2^31 ms.
+ */
+class PlcTimerWheel {
+public:
+    static constexpr uint8_t SLOT_BITS = 4;
+    static constexpr uint8_t SLOTS = 1 << SLOT_BITS;
+    static constexpr uint8_t LEVELS = 4;
+
+    // Called for each expired timer during advance()
+    typedef void (*ExpiryHandler)(void* context, PlcTimer& timer);
+
+    PlcTimerWheel();
+    PlcTimerWheel(const PlcTimerWheel&) = delete;
+    PlcTimerWheel& operator=(const PlcTimerWheel&) = delete;
+
+    void setExpiryHandler(ExpiryHandler handler, void* context) { _handler = handler; _context = context; }
+
+    uint32_t now() const { return nowMs; } // Time of the current cycle, ms
+
+    // Start timer (again) to expire delayMs from now; a delay of 0 expires it right away
+    void arm(PlcTimer& timer, uint32_t delayMs);
+    // Start timer with the start and deadline of a timer of another wheel
+    // on the same time base (online change)
+    void armAt(PlcTimer& timer, uint32_t start, uint32_t deadline);
+    void disarm(PlcTimer& timer); // Back to idle, running or expired
+    void migrate(PlcTimer& timer, const PlcTimer& previous); // Same state as previous
+
+    // Milliseconds since the timer was armed, its delay once expired, 0 when idle
+    uint32_t elapsed(const PlcTimer& timer) const;
+
+    // Move the time forward to nowMs (absolute), expiring the timers due.
+    // Returns the number of timers expired.
+    size_t advance(uint32_t nowMs);
+    // Same, from a PlcClock reading in microseconds; the first call only
+    // sets the time base
+    size_t advanceMicros(uint32_t nowUs);
+
+    // Milliseconds from now to the earliest deadline, false if no timer is
+    // armed. The earliest slot of the lowest occupied level holds it.
+    bool nextExpiry(uint32_t& delayMs) const;
+    // PlcClock reading (us) from which advanceMicros() expires that timer,
+    // at most MAX_EXPIRY_US ahead of the last reading
+    static constexpr uint32_t MAX_EXPIRY_US = 0x40000000;
+    bool nextExpiryMicros(uint32_t& deadlineUs) const;
+    // Continue on the time base of another wheel (online change)
+    void syncTo(const PlcTimerWheel& other);
+
+    // Forget all timers without touching them (their blocks are destroyed)
+    void clear();
+    size_t getArmedCount() const { return armed; }
+
+private:
+    PlcTimer* slots[LEVELS][SLOTS];
+    PlcTimer* overflow;
+    uint16_t occupied[LEVELS];  // Bit per non-empty slot
+    uint32_t nowMs;
+    uint32_t lastUs;
+    uint32_t remainderUs;
+    bool started;
+    size_t armed;
+    ExpiryHandler _handler;
+    void* _context;
+
+    void insert(PlcTimer& timer);
+    void unlink(PlcTimer& timer);
+    size_t expire(PlcTimer& timer);
+    size_t cascade(PlcTimer* list);
+};
+
+#endif // PLC_TIMER_WHEEL_H
@@ -0,0 +1,85 @@
+#include "../PlcEngine/Engine/PlcTypeCheck.h"
+#include "../PlcEngine/Engine/PlcProgramImage.h"
+#include <StreamLogger.h>
+
+extern StreamLogger* EspHubLog;
+
+namespace {
+
+// Constants of the benchmark format are REAL variables named after their value
+bool isConstant(const char* name) {
+    return name[0] == '#';
+}
+
+} // namespace
+
+bool PlcTypeCheck::resolveInputs(const PlcMemory& memory, const char* blockType, JsonVariantConst inputs, PlcValueType& type) {
+    type = PlcValueType::REAL; // Nothing declared yet: the REAL the blocks always used
+    const char* first = nullptr;
+    bool mixed = false;
+    auto visit = [&](JsonVariantConst value) {
+        const char* name = value.as<const char*>();
+        if (name == nullptr || name[0] == '\0' || isConstant(name)) {
+            return true;
+        }
+        VarHandle handle = memory.findHandle(name);
+        if (!handle.isValid()) {
+            return true; // Declared by the block, see declarationType()
+        }
+        if (!isNumber(handle.type)) {
+            if (memory.isStrictTypes()) {
+                EspHubLog->printf("ERROR: %s: input '%s' is %s, expected a number\n",
+                                  blockType, name, PlcProgramImage::typeName(handle.type));
+                return false;
+            }
+            mixed = true;
+        } else if (first == nullptr) {
+            first = name;
+            type = handle.type;
+        } else if (handle.type != type) {
+            if (memory.isStrictTypes()) {
+                EspHubLog->printf("ERROR: %s: inputs mix %s ('%s') and %s ('%s')\n", blockType,
+                                  PlcProgramImage::typeName(type), first, PlcProgramImage::typeName(handle.type), name);
+                return false;
+            }
+            mixed = true;
+        }
+        return true;
+    };
+
+    if (inputs.is<JsonArrayConst>()) {
+        for (JsonVariantConst v : inputs.as<JsonArrayConst>()) {
+            if (!visit(v)) {
+                return false;
+            }
+        }
+    } else if (inputs.is<JsonObjectConst>()) {
+        for (JsonPairConst kv : inputs.as<JsonObjectConst>()) {
+            if (!visit(kv.value())) {
+                return false;
+            }
+        }
+    }
+    if (mixed) {
+        type = PlcValueType::REAL; // Converted at run time
+    }
+    return true;
+}
+
+bool PlcTypeCheck::checkOutput(const PlcMemory& memory, const char* blockType, VarHandle output, PlcValueType type) {
+    if (!output.isValid() || output.type == type || !memory.isStrictTypes()) {
+        return true;
+    }
+    EspHubLog->printf("ERROR: %s: output '%s' is %s, expected %s\n", blockType, memory.getVariableName(output),
+                      PlcProgramImage::typeName(output.type), PlcProgramImage::typeName(type));
+    return false;
+}
+
+bool PlcTypeCheck::isUniform(const PlcHandleList& handles, PlcValueType type) {
+    for (const VarHandle& handle : handles) {
+        if (!handle.isValid() || handle.type != type) {
+            return false;
+        }
+    }
+    return !handles.empty();
+}
@@ -0,0 +1,54 @@
+#ifndef PLC_TYPE_CHECK_H
+#define PLC_TYPE_CHECK_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../PlcEngine/Engine/PlcMemory.h"
+
+/**
+ * PlcTypeCheck - operand types of the numeric blocks, resolved at load.
+ *
+ * A block's working type is the type its input variables are declared with
+ * (in "memory" or by an earlier block). Constants ("#" variables of the
+ * benchmark format) are REAL whatever the other operands are and take no
+ * part in the inference. When the output and every input share INT, DINT
+ * or REAL the block picks a kernel for that type (isUniform) and the
+ * bytecode a slot-typed opcode, neither converting any value.
+ *
+ * Operands of different types are converted at run time, through REAL, and
+ * variables a block uses before they are declared are REAL, as they always
+ * were. A program with "strict_types" rejects mixed operands and inputs
+ * that are not numbers instead, and declares new variables with the
+ * working type, so a chain of INT blocks stays INT.
+ */
+class PlcTypeCheck {
+public:
+    // Working type of the input variable names in `inputs` (an array or an
+    // object of pins). false, with the error logged, if strict typing is on
+    // and they do not share one numeric type.
+    static bool resolveInputs(const PlcMemory& memory, const char* blockType, JsonVariantConst inputs, PlcValueType& type);
+
+    // Type to declare the block's not yet declared operands with
+    static PlcValueType declarationType(const PlcMemory& memory, PlcValueType type) {
+        return memory.isStrictTypes() ? type : PlcValueType::REAL;
+    }
+
+    // Check a bound output against the type the block writes
+    static bool checkOutput(const PlcMemory& memory, const char* blockType, VarHandle output, PlcValueType type);
+
+    // True if every handle is bound to a slot of the given type
+    static bool isUniform(const PlcHandleList& handles, PlcValueType type);
+    static bool isUniform(VarHandle a, VarHandle b, PlcValueType type) {
+        return a.isValid() && b.isValid() && a.type == type && b.type == type;
+    }
+
+    // INT, DINT and REAL have typed kernels; BYTE is a number converted through REAL
+    static bool hasTypedKernel(PlcValueType type) {
+        return type == PlcValueType::INT || type == PlcValueType::DINT || type == PlcValueType::REAL;
+    }
+    static bool isNumber(PlcValueType type) {
+        return type == PlcValueType::BYTE || hasTypedKernel(type);
+    }
+};
+
+#endif // PLC_TYPE_CHECK_H
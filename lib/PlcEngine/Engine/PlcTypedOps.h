@@ -0,0 +1,131 @@
+#ifndef PLC_TYPED_OPS_H
+#define PLC_TYPED_OPS_H
+
+#include <Arduino.h>
+#include "../PlcEngine/Engine/PlcBytecode.h"
+
+/**
+ * Operations of the typed arithmetic and comparison kernels.
+ *
+ * Shared by the blocks (PlcArithBlock, PlcCompareBlock) and the slot-typed
+ * opcodes of the bytecode VM, so both engines compute the same values. The
+ * working type is the declared type of the operands: int16_t for INT,
+ * int32_t for DINT and float for REAL. Integer results wrap around within
+ * the type; division truncates toward zero, and a zero divisor yields 0
+ * and ends the chain, like the REAL blocks always did.
+ *
+ * step() folds the next n-ary operand into the result and returns false
+ * when the remaining operands are to be ignored.
+ */
+struct PlcOpAdd {
+    static constexpr const char* NAME = "ADD";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::ADD_R;
+
+    template<typename T>
+    static inline bool step(T& acc, T b) {
+        acc = static_cast<T>(static_cast<int64_t>(acc) + b);
+        return true;
+    }
+    static inline bool step(float& acc, float b) {
+        acc += b;
+        return true;
+    }
+};
+
+struct PlcOpSub {
+    static constexpr const char* NAME = "SUB";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::SUB_R;
+
+    template<typename T>
+    static inline bool step(T& acc, T b) {
+        acc = static_cast<T>(static_cast<int64_t>(acc) - b);
+        return true;
+    }
+    static inline bool step(float& acc, float b) {
+        acc -= b;
+        return true;
+    }
+};
+
+struct PlcOpMul {
+    static constexpr const char* NAME = "MUL";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::MUL_R;
+
+    template<typename T>
+    static inline bool step(T& acc, T b) {
+        acc = static_cast<T>(static_cast<int64_t>(acc) * b);
+        return true;
+    }
+    static inline bool step(float& acc, float b) {
+        acc *= b;
+        return true;
+    }
+};
+
+struct PlcOpDiv {
+    static constexpr const char* NAME = "DIV";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::DIV_R;
+
+    // Divided in 64 bits, so the DINT minimum divided by -1 wraps instead of trapping
+    template<typename T>
+    static inline bool step(T& acc, T b) {
+        if (b == 0) {
+            acc = 0;
+            return false;
+        }
+        acc = static_cast<T>(static_cast<int64_t>(acc) / b);
+        return true;
+    }
+    static inline bool step(float& acc, float b) {
+        if (b == 0.0f) {
+            acc = 0.0f;
+            return false;
+        }
+        acc /= b;
+        return true;
+    }
+};
+
+struct PlcOpGt {
+    static constexpr const char* NAME = "GT";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::GT_R;
+    template<typename T>
+    static inline bool test(T a, T b) { return a > b; }
+};
+
+struct PlcOpGe {
+    static constexpr const char* NAME = "GE";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::GE_R;
+    template<typename T>
+    static inline bool test(T a, T b) { return a >= b; }
+};
+
+struct PlcOpLt {
+    static constexpr const char* NAME = "LT";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::LT_R;
+    template<typename T>
+    static inline bool test(T a, T b) { return a < b; }
+};
+
+struct PlcOpLe {
+    static constexpr const char* NAME = "LE";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::LE_R;
+    template<typename T>
+    static inline bool test(T a, T b) { return a <= b; }
+};
+
+struct PlcOpEq {
+    static constexpr const char* NAME = "EQ";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::EQ_R;
+    template<typename T>
+    static inline bool test(T a, T b) { return a == b; }
+};
+
+struct PlcOpNe {
+    static constexpr const char* NAME = "NE";
+    static constexpr PlcOpcode OPCODE = PlcOpcode::NE_R;
+    template<typename T>
+    static inline bool test(T a, T b) { return a != b; }
+};
+
+#endif // PLC_TYPED_OPS_H
@@ -0,0 +1,40 @@
+#ifndef PLC_WORD_LOGIC_H
+#define PLC_WORD_LOGIC_H
+
+#include "../PlcEngine/Engine/PlcMemory.h"
+
+/**
+ * PlcWordLogic - boolean operations on 32 BOOL variables at once.
+ *
+ * BOOL values are bits of the marker words (PlcMemory::loadWord()), so one
+ * operation on two words combines 32 pairs of variables. The array blocks
+ * (ARRAY_AND, ...) apply them to whole BOOL arrays, and the optimizer packs
+ * scalar AND, OR, XOR, NAND, NOR and NOT blocks whose variables sit at the
+ * same distances in their words into one word operation (PlcPackedBitBlock).
+ */
+enum class PlcWordOp : uint8_t {
+    AND, OR, XOR, NAND, NOR, NOT
+};
+
+inline uint32_t applyWordOp(PlcWordOp op, uint32_t a, uint32_t b) {
+    switch (op) {
+        case PlcWordOp::AND: return a & b;
+        case PlcWordOp::OR: return a | b;
+        case PlcWordOp::XOR: return a ^ b;
+        case PlcWordOp::NAND: return ~(a & b);
+        case PlcWordOp::NOR: return ~(a | b);
+        case PlcWordOp::NOT: return ~a;
+    }
+    return 0;
+}
+
+// A scalar logic block as a bit operation, out = in1 op in2 (in2 invalid
+// for NOT); see PlcBlock::describeBitOp()
+struct PlcBitOp {
+    PlcWordOp op;
+    VarHandle in1;
+    VarHandle in2;
+    VarHandle out;
+};
+
+#endif // PLC_WORD_LOGIC_H
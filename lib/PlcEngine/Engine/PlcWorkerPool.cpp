@@ -0,0 +1,156 @@
+#include "../PlcEngine/Engine/PlcWorkerPool.h"
+#include <StreamLogger.h>
+
+extern StreamLogger* EspHubLog;
+
+PlcWorkerPool::PlcWorkerPool()
+    : workerCount(1), priority(1), _job(nullptr), _context(nullptr)
+#ifdef UNIT_TEST
+    , generation(0), pending(0), stopping(false)
+#else
+    , coordinator(NULL)
+#endif
+{
+#ifndef UNIT_TEST
+    for (Worker& worker : workers) {
+        worker.task = NULL;
+    }
+#endif
+}
+
+uint8_t PlcWorkerPool::coreOf(uint8_t index) {
+#ifdef UNIT_TEST
+    return index;
+#else
+    return index % portNUM_PROCESSORS;
+#endif
+}
+
+bool PlcWorkerPool::start(uint8_t count, Job job, void* context) {
+    stop();
+    if (count < 1) {
+        count = 1;
+    } else if (count > MAX_WORKERS) {
+        count = MAX_WORKERS;
+    }
+    _job = job;
+    _context = context;
+
+#ifdef UNIT_TEST
+    for (uint8_t i = 1; i < count; i++) {
+        threads[i] = std::thread(&PlcWorkerPool::workerLoop, this, i, generation); // Cycles from the next one on
+    }
+    workerCount = count;
+#else
+    for (uint8_t i = 1; i < count; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "plcWorker%u", (unsigned)i);
+        workers[i].pool = this;
+        workers[i].index = i;
+        if (xTaskCreatePinnedToCore(workerTask, name, 10000, &workers[i], priority, &workers[i].task, coreOf(i)) != pdPASS) {
+            EspHubLog->printf("ERROR: Cannot create PLC worker %u\n", (unsigned)i);
+            workers[i].task = NULL;
+            workerCount = i;
+            stop();
+            return false;
+        }
+    }
+    workerCount = count;
+#endif
+    return true;
+}
+
+void PlcWorkerPool::stop() {
+#ifdef UNIT_TEST
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (uint8_t i = 1; i < workerCount; i++) {
+        if (threads[i].joinable()) {
+            threads[i].join();
+        }
+    }
+    stopping = false;
+#else
+    // A worker in the middle of a cycle is deleted like the engine task
+    // itself; the engine task then waits for it until it is deleted too
+    for (uint8_t i = 1; i < workerCount; i++) {
+        if (workers[i].task != NULL) {
+            vTaskDelete(workers[i].task);
+            workers[i].task = NULL;
+        }
+    }
+#endif
+    workerCount = 1;
+}
+
+void PlcWorkerPool::setPriority(uint8_t value) {
+    priority = value;
+#ifndef UNIT_TEST
+    for (uint8_t i = 1; i < workerCount; i++) {
+        if (workers[i].task != NULL) {
+            vTaskPrioritySet(workers[i].task, priority);
+        }
+    }
+#endif
+}
+
+void PlcWorkerPool::runCycle() {
+    if (workerCount == 1) {
+        _job(_context, 0);
+        return;
+    }
+
+#ifdef UNIT_TEST
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = workerCount - 1;
+        generation++;
+    }
+    wake.notify_all();
+    _job(_context, 0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+#else
+    coordinator = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 1; i < workerCount; i++) {
+        xTaskNotifyGive(workers[i].task);
+    }
+    _job(_context, 0);
+    for (uint8_t i = 1; i < workerCount; i++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY); // One notification per finished worker
+    }
+#endif
+}
+
+#ifdef UNIT_TEST
+void PlcWorkerPool::workerLoop(uint8_t index, uint32_t seen) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        _job(_context, index);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
+#else
+void PlcWorkerPool::workerTask(void* parameter) {
+    Worker* worker = static_cast<Worker*>(parameter);
+    PlcWorkerPool* pool = worker->pool;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        pool->_job(pool->_context, worker->index);
+        xTaskNotifyGive(pool->coordinator);
+    }
+}
+#endif
@@ -0,0 +1,84 @@
+#ifndef PLC_WORKER_POOL_H
+#define PLC_WORKER_POOL_H
+
+#include <Arduino.h>
+#ifdef UNIT_TEST
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+// Workers scanning PLC programs in parallel: one per core on the target,
+// one (no parallel scans) in native builds unless a test asks for more
+#ifndef PLC_WORKER_COUNT
+#ifdef UNIT_TEST
+#define PLC_WORKER_COUNT 1
+#else
+#define PLC_WORKER_COUNT portNUM_PROCESSORS
+#endif
+#endif
+
+/**
+ * PlcWorkerPool - runs one PLC cycle on several workers at once.
+ *
+ * Worker 0 is the task calling runCycle() (the PLC engine task). Worker
+ * i > 0 is a FreeRTOS task pinned to core i on the ESP32, a std::thread in
+ * native builds. runCycle() starts the job on every worker and returns
+ * once all of them have finished it, so two cycles never overlap and
+ * nothing runs between cycles but the caller.
+ */
+class PlcWorkerPool {
+public:
+    typedef void (*Job)(void* context, uint8_t worker);
+    static constexpr uint8_t MAX_WORKERS = 4;
+
+    PlcWorkerPool();
+    ~PlcWorkerPool() { stop(); }
+    PlcWorkerPool(const PlcWorkerPool&) = delete;
+    PlcWorkerPool& operator=(const PlcWorkerPool&) = delete;
+
+    // Create workers 1..workerCount-1. Returns false if a worker could not
+    // be created; the pool is stopped then.
+    bool start(uint8_t workerCount, Job job, void* context);
+    void stop();
+    uint8_t getWorkerCount() const { return workerCount; } // 1 while stopped
+
+    // Run job on every worker, worker 0 on the calling task, and wait for all
+    void runCycle();
+
+    // FreeRTOS priority of workers 1..n-1, now and when they are started
+    void setPriority(uint8_t value);
+
+    // Core worker `index` runs on
+    static uint8_t coreOf(uint8_t index);
+
+private:
+    uint8_t workerCount;
+    uint8_t priority;
+    Job _job;
+    void* _context;
+
+#ifdef UNIT_TEST
+    std::thread threads[MAX_WORKERS];
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint32_t generation;    // Cycles started
+    uint8_t pending;        // Workers still running the current cycle
+    bool stopping;
+
+    void workerLoop(uint8_t index, uint32_t seen);
+#else
+    struct Worker {
+        PlcWorkerPool* pool;
+        uint8_t index;
+        TaskHandle_t task;
+    };
+    Worker workers[MAX_WORKERS];
+    TaskHandle_t coordinator;   // Task in runCycle(), notified by each finished worker
+
+    static void workerTask(void* parameter);
+#endif
+};
+
+#endif // PLC_WORKER_POOL_H
@@ -2,6 +2,7 @@
 #include <LittleFS.h>
 #include "../Core/StreamLogger.h"
 #include "../Devices/DeviceRegistry.h"
+#include "../PlcEngine/Engine/PlcBlockRegistry.h"
 #include <map>
 
 // Define LITTLEFS as an alias for LittleFS if not already defined
@@ -14,7 +15,7 @@ extern StreamLogger* EspHubLog;
 WebManager* WebManager::instance = nullptr;
 
 WebManager::WebManager(PlcEngine* plcEngine, MeshDeviceManager* meshDeviceManager, ZigbeeManager* zigbeeManager)
-    : server(80), ws("/ws"), _plcEngine(plcEngine), _meshDeviceManager(meshDeviceManager), _zigbeeManager(zigbeeManager), _moduleManager(nullptr) {
+    : server(80), ws("/ws"), _plcEngine(plcEngine), _meshDeviceManager(meshDeviceManager), _zigbeeManager(zigbeeManager), _moduleManager(nullptr), _lastProfilePush(0) {
     instance = this;
 }
 
@@ -71,6 +72,39 @@ void WebManager::begin() {
         }
     });
 
+    // GET /api/plc/blocks - Catalog of the available block types
+    server.on("/api/plc/blocks", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send(200, "application/json", PlcBlockRegistry::getCatalogJson());
+    });
+
+    // GET /api/plc/workers - Programs and busy time of each PLC worker
+    server.on("/api/plc/workers", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument doc;
+        _plcEngine->getWorkersJson(doc.to<JsonObject>());
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // GET /api/plc/power - Wake-ups per second and idle share of the PLC task
+    server.on("/api/plc/power", HTTP_GET, [this](AsyncWebServerRequest *request){
+        JsonDocument doc;
+        _plcEngine->getPowerJson(doc.to<JsonObject>());
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // GET /api/plc/:program/profile - Per-block scan-time profile
+    server.on("^\\/api\\/plc\\/([a-zA-Z0-9_]+)\\/profile$", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handleGetPlcProfile(request);
+    });
+
+    // GET /api/plc/:program/retentive - Retentive variables and flash write rates
+    server.on("^\\/api\\/plc\\/([a-zA-Z0-9_]+)\\/retentive$", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handleGetPlcRetentive(request);
+    });
+
     // New route for mesh device registration
     server.on("/mesh_register", HTTP_GET, [](AsyncWebServerRequest *request){
         request->send(LITTLEFS, "/mesh_register.html", "text/html");
@@ -103,6 +137,13 @@ void WebManager::begin() {
     EspHubLog->println("Web server started.");
 }
 
+void WebManager::loop() {
+    if (millis() - _lastProfilePush >= PROFILE_PUSH_INTERVAL_MS) {
+        _lastProfilePush = millis();
+        pushPlcProfiles();
+    }
+}
+
 void WebManager::log(const String& message) {
     ws.textAll(message);
 }
@@ -138,6 +179,27 @@ void WebManager::onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
                 String response_str;
                 serializeJson(response, response_str);
                 client->text(response_str);
+            } else if (strcmp(request_type, "plc_cycle_stats") == 0) {
+                JsonDocument response;
+                response["type"] = "plc_cycle_stats";
+                JsonObject programs = response["programs"].to<JsonObject>();
+                for (const String& name : instance->_plcEngine->getProgramNames()) {
+                    PlcProgram* program = instance->_plcEngine->getProgram(name);
+                    JsonObject entry = programs[name].to<JsonObject>();
+                    entry["cycle_time_ms"] = program->getCycleTimer().getCycleTimeMs();
+                    program->getCycleTimer().getStats().toJson(entry);
+                    if (program->getTaskCount() > 0) {
+                        JsonArray tasks = entry["tasks"].to<JsonArray>();
+                        for (size_t i = 0; i < program->getTaskCount(); i++) {
+                            program->getTask(i).toJson(tasks.add<JsonObject>());
+                        }
+                    }
+                }
+                String response_str;
+                serializeJson(response, response_str);
+                client->text(response_str);
+            } else if (strcmp(request_type, "plc_profile") == 0) {
+                instance->pushPlcProfiles();
             } else if (strcmp(request_type, "plc_variables") == 0) {
                 StaticJsonDocument<1024> response; // Adjust size as needed
                 response["type"] = "plc_variables";
@@ -508,4 +570,69 @@ void WebManager::handleGetModuleStats(AsyncWebServerRequest *request) {
     String response;
     serializeJson(doc, response);
     request->send(200, "application/json", response);
-}
\ No newline at end of file
+}
+
+// ============================================================================
+// PLC Profiler API
+// ============================================================================
+
+void WebManager::handleGetPlcProfile(AsyncWebServerRequest *request) {
+#ifdef PLC_PROFILING
+    // Extract program name from URL
+    String path = request->url();
+    int lastSlash = path.lastIndexOf('/');
+    int secondLastSlash = path.lastIndexOf('/', lastSlash - 1);
+    String programName = path.substring(secondLastSlash + 1, lastSlash);
+
+    PlcProgram* program = _plcEngine->getProgram(programName);
+    if (!program) {
+        request->send(404, "application/json", "{\"error\":\"Program not found\"}");
+        return;
+    }
+
+    JsonDocument doc;
+    program->getProfile(doc.to<JsonObject>());
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+#else
+    request->send(501, "application/json", "{\"error\":\"Firmware built without PLC_PROFILING\"}");
+#endif
+}
+
+void WebManager::handleGetPlcRetentive(AsyncWebServerRequest *request) {
+    // Extract program name from URL
+    String path = request->url();
+    int lastSlash = path.lastIndexOf('/');
+    int secondLastSlash = path.lastIndexOf('/', lastSlash - 1);
+    String programName = path.substring(secondLastSlash + 1, lastSlash);
+
+    PlcProgram* program = _plcEngine->getProgram(programName);
+    if (!program) {
+        request->send(404, "application/json", "{\"error\":\"Program not found\"}");
+        return;
+    }
+
+    JsonDocument doc;
+    program->getMemory().getRetentive().getStatsJson(doc.to<JsonObject>(), micros());
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void WebManager::pushPlcProfiles() {
+#ifdef PLC_PROFILING
+    for (const String& name : _plcEngine->getProgramNames()) {
+        PlcProgram* program = _plcEngine->getProgram(name);
+        if (!program || program->getState() != PlcProgramState::RUNNING) {
+            continue;
+        }
+        JsonDocument doc;
+        doc["type"] = "plc_profile";
+        program->getProfile(doc["profile"].to<JsonObject>());
+        String frame;
+        serializeJson(doc, frame);
+        ws.textAll(frame);
+    }
+#endif
+}
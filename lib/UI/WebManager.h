@@ -79,6 +79,7 @@ public:
     void setZigbeeManager(ZigbeeManager* manager) { _zigbeeManager = manager; }
     void setModuleManager(ModuleManager* manager) { _moduleManager = manager; }
     void begin();
+    void loop(); // Periodic WebSocket frames
     void log(const String& message);
 
     static WebManager* instance;
@@ -89,6 +90,9 @@ private:
     MeshDeviceManager* _meshDeviceManager;
     ZigbeeManager* _zigbeeManager;
     ModuleManager* _moduleManager;
+    unsigned long _lastProfilePush;
+
+    static const unsigned long PROFILE_PUSH_INTERVAL_MS = 1000;
 
     static void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
     void handleZigbeeRequest(const String& requestType, const JsonObject& data, AsyncWebSocketClient* client);
@@ -100,6 +104,11 @@ private:
     void handleEnableModule(AsyncWebServerRequest *request);
     void handleDisableModule(AsyncWebServerRequest *request);
     void handleGetModuleStats(AsyncWebServerRequest *request);
+
+    // PLC profiler API handlers
+    void handleGetPlcProfile(AsyncWebServerRequest *request);
+    void pushPlcProfiles();
+    void handleGetPlcRetentive(AsyncWebServerRequest *request);
 };
 
 #endif // UNIT_TEST
@@ -53,11 +53,17 @@ std::vector<Endpoint*> DeviceRegistry::getEndpointsByDevice(const String& device
 }
 
 void DeviceRegistry::updateEndpointStatus(const String& fullName, bool isOnline) {
+    auto it = endpoints.find(fullName);
+    if (it != endpoints.end() && it->second.isOnline != isOnline) {
+        it->second.isOnline = isOnline;
+        triggerStatusCallbacks(fullName, isOnline);
+    }
 }
 
 void DeviceRegistry::updateEndpointValue(const String& fullName, const PlcValue& value) {
     if (endpoints.find(fullName) != endpoints.end()) {
         endpoints[fullName].currentValue = value;
+        triggerValueCallbacks(fullName, value);
     }
 }
 
@@ -107,15 +113,23 @@ void DeviceRegistry::syncFromPLC() {
 }
 
 void DeviceRegistry::onStatusChange(StatusCallback callback) {
+    statusCallbacks.push_back(callback);
 }
 
 void DeviceRegistry::onValueChange(ValueCallback callback) {
+    valueCallbacks.push_back(callback);
 }
 
 void DeviceRegistry::triggerStatusCallbacks(const String& fullName, bool isOnline) {
+    for (auto& callback : statusCallbacks) {
+        callback(fullName, isOnline);
+    }
 }
 
 void DeviceRegistry::triggerValueCallbacks(const String& fullName, const PlcValue& value) {
+    for (auto& callback : valueCallbacks) {
+        callback(fullName, value);
+    }
 }
 
 String DeviceRegistry::protocolToString(ProtocolType protocol) {
@@ -138,4 +152,6 @@ void DeviceRegistry::clear() {
     endpoints.clear();
     devices.clear();
     ioPoints.clear();
+    statusCallbacks.clear();
+    valueCallbacks.clear();
 }
@@ -2,32 +2,138 @@
 #define PREFERENCES_H
 
 #include <Arduino.h>
+#include <cstring>
 #include <map>
 #include <string>
+#include <vector>
 
+/**
+ * @brief In-memory NVS for native tests
+ *
+ * Values persist across Preferences instances (like flash across reboots)
+ * until Preferences::resetFlash(). Every put is counted, so tests can
+ * measure how often and how much a component writes. The next write can
+ * be torn to simulate a power cut in the middle of it, and writes can be
+ * made to fail like on a full or worn-out NVS partition.
+ */
 class Preferences {
 public:
-    bool begin(const char* name, bool readOnly = false) { return true; }
+    struct FlashStats {
+        uint32_t writes = 0;        // put* calls that reached flash
+        uint32_t bytesWritten = 0;
+        std::map<std::string, uint32_t> writesPerKey; // "namespace/key"
+    };
+
+    static std::map<std::string, std::vector<uint8_t>>& flash() {
+        static std::map<std::string, std::vector<uint8_t>> storage;
+        return storage;
+    }
+    static FlashStats& stats() {
+        static FlashStats flashStats;
+        return flashStats;
+    }
+    // The next put stores only the first `bytes` bytes
+    static int& tearNextWrite() {
+        static int bytes = -1;
+        return bytes;
+    }
+    // The next `count` puts fail and store nothing
+    static int& failNextWrites() {
+        static int count = 0;
+        return count;
+    }
+    static void resetFlash() {
+        flash().clear();
+        stats() = FlashStats();
+        tearNextWrite() = -1;
+        failNextWrites() = 0;
+    }
+
+    bool begin(const char* name, bool readOnly = false) {
+        _namespace = name;
+        _readOnly = readOnly;
+        return true;
+    }
     void end() {}
-    void clear() {}
+    void clear() {
+        std::string prefix = _namespace + "/";
+        for (auto it = flash().begin(); it != flash().end();) {
+            it = it->first.compare(0, prefix.size(), prefix) == 0 ? flash().erase(it) : std::next(it);
+        }
+    }
+    bool isKey(const char* key) { return flash().count(path(key)) > 0; }
+    bool remove(const char* key) { return flash().erase(path(key)) > 0; }
+
+    size_t putBytes(const char* key, const void* value, size_t len) {
+        if (_readOnly) {
+            return 0;
+        }
+        if (failNextWrites() > 0) {
+            failNextWrites()--;
+            return 0;
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(value);
+        std::vector<uint8_t>& stored = flash()[path(key)];
+        int& tear = tearNextWrite();
+        if (tear >= 0 && static_cast<size_t>(tear) < len) {
+            // Power cut: the new data is only partly there
+            stored.assign(bytes, bytes + tear);
+            stored.resize(len, 0xFF);
+            tear = -1;
+        } else {
+            stored.assign(bytes, bytes + len);
+        }
+        FlashStats& s = stats();
+        s.writes++;
+        s.bytesWritten += len;
+        s.writesPerKey[path(key)]++;
+        return len;
+    }
+    size_t getBytesLength(const char* key) {
+        auto it = flash().find(path(key));
+        return it == flash().end() ? 0 : it->second.size();
+    }
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        auto it = flash().find(path(key));
+        if (it == flash().end() || it->second.size() > maxLen) {
+            return 0;
+        }
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    bool getBool(const char* key, bool defaultValue = false) { return get<bool>(key, defaultValue); }
+    void putBool(const char* key, bool value) { putBytes(key, &value, sizeof(value)); }
+
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return get<uint8_t>(key, defaultValue); }
+    void putUChar(const char* key, uint8_t value) { putBytes(key, &value, sizeof(value)); }
+
+    int16_t getShort(const char* key, int16_t defaultValue = 0) { return get<int16_t>(key, defaultValue); }
+    void putShort(const char* key, int16_t value) { putBytes(key, &value, sizeof(value)); }
 
-    bool getBool(const char* key, bool defaultValue = false) { return defaultValue; }
-    void putBool(const char* key, bool value) {}
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get<uint32_t>(key, defaultValue); }
+    void putUInt(const char* key, uint32_t value) { putBytes(key, &value, sizeof(value)); }
 
-    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return defaultValue; }
-    void putUChar(const char* key, uint8_t value) {}
+    float getFloat(const char* key, float defaultValue = 0.0f) { return get<float>(key, defaultValue); }
+    void putFloat(const char* key, float value) { putBytes(key, &value, sizeof(value)); }
 
-    int16_t getShort(const char* key, int16_t defaultValue = 0) { return defaultValue; }
-    void putShort(const char* key, int16_t value) {}
+    String getString(const char* key, const String defaultValue = String()) {
+        auto it = flash().find(path(key));
+        return it == flash().end() ? defaultValue : String(std::string(it->second.begin(), it->second.end()).c_str());
+    }
+    size_t putString(const char* key, const String value) { return putBytes(key, value.c_str(), value.length()); }
 
-    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return defaultValue; }
-    void putUInt(const char* key, uint32_t value) {}
+private:
+    std::string _namespace;
+    bool _readOnly = false;
 
-    float getFloat(const char* key, float defaultValue = 0.0f) { return defaultValue; }
-    void putFloat(const char* key, float value) {}
+    std::string path(const char* key) const { return _namespace + "/" + key; }
 
-    String getString(const char* key, const String defaultValue = String()) { return defaultValue; }
-    size_t putString(const char* key, const String value) { return value.length(); }
+    template<typename T>
+    T get(const char* key, T defaultValue) {
+        T value;
+        return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+    }
 };
 
 #endif
@@ -0,0 +1,24 @@
+#ifndef BENCH_TIMER_H
+#define BENCH_TIMER_H
+
+#include <Arduino.h>
+#ifdef UNIT_TEST
+#include <chrono>
+#endif
+
+/**
+ * @brief Wall-clock microseconds for the benchmark tests
+ *
+ * steady_clock on the host, micros() on the target. Timings on a shared
+ * host vary from run to run: print them rather than compare them.
+ */
+static inline unsigned long benchMicros() {
+#ifdef UNIT_TEST
+    using namespace std::chrono;
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#else
+    return micros();
+#endif
+}
+
+#endif // BENCH_TIMER_H
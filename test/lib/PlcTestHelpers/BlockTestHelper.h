@@ -4,6 +4,7 @@
 #include <unity.h>
 #include "Engine/PlcMemory.h"
 #include "Blocks/PlcBlock.h"
+#include "ManualPlcClock.h"
 #include <ArduinoJson.h>
 #include <map>
 #include <string>
@@ -12,11 +13,22 @@
  * @brief Helper class for testing PLC blocks
  * 
  * Simplifies setting inputs, running blocks, and verifying outputs.
+ * Timer blocks arm their timers in the helper's timer wheel, which
+ * runBlock() moves to the given time first. The scan's cycle context is
+ * started at the same time from the helper's ManualPlcClock (getClock()).
+ *
+ * When built with PLC_TEST_BYTECODE_ENGINE (env:native_bytecode), blocks are
+ * compiled and executed through the bytecode VM instead of evaluate(), so
+ * the same test suites cover both execution engines.
  */
 class BlockTestHelper {
 private:
     PlcMemory* memory;
     std::map<String, PlcBlock*> blocks;
+    std::map<String, PlcBytecode> compiled;
+    PlcTimerWheel timers;
+    ManualPlcClock clock;
+    PlcCycleContext cycle;
 
 public:
     BlockTestHelper(PlcMemory* mem) : memory(mem) {}
@@ -33,15 +45,31 @@ public:
      * @brief Register a block for testing
      */
     void registerBlock(const String& name, PlcBlock* block) {
+        block->setTimers(&timers);
+        block->setCycleContext(&cycle);
         blocks[name] = block;
     }
 
+    /**
+     * @brief Clock of the scans, e.g. to set the local time of day
+     */
+    ManualPlcClock& getClock() {
+        return clock;
+    }
+
     /**
      * @brief Configure a block with JSON
      */
     void configureBlock(const String& name, JsonDocument& doc) {
         if (blocks.find(name) != blocks.end()) {
             blocks[name]->configure(doc.as<JsonObject>(), *memory);
+
+            PlcBytecode& code = compiled[name];
+            code.clear();
+            if (!blocks[name]->lower(code)) {
+                code.emitCall(blocks[name]);
+            }
+            code.finish();
         }
     }
 
@@ -68,10 +96,18 @@ public:
 
     /**
      * @brief Execute a specific block
+     * @param currentMillis Time of the scan; expires the timers due by then
      */
     void runBlock(const String& name, unsigned long currentMillis = 0) {
+        timers.advance(currentMillis);
+        clock.setTime(static_cast<uint32_t>(currentMillis * 1000));
+        cycle.begin(clock, clock.nowMicros());
         if (blocks.find(name) != blocks.end()) {
+#ifdef PLC_TEST_BYTECODE_ENGINE
+            compiled[name].execute(*memory);
+#else
             blocks[name]->evaluate(*memory);
+#endif
         }
     }
 
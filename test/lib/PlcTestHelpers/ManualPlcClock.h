@@ -0,0 +1,92 @@
+#ifndef MANUAL_PLC_CLOCK_H
+#define MANUAL_PLC_CLOCK_H
+
+#include <Arduino.h>
+#include "Engine/PlcClock.h"
+
+/**
+ * @brief Manually driven PlcClock for deterministic scheduler tests
+ *
+ * sleepUntil() jumps straight to the deadline, so a scheduler loop can be
+ * simulated for minutes of PLC time in microseconds of test time.
+ * waitUntil() returns without moving the time if wake() was called.
+ * The local time of day is unknown until setLocalTime(); it then advances
+ * with the clock, in UTC so results do not depend on the host's zone.
+ */
+class ManualPlcClock : public PlcClock {
+private:
+    uint32_t nowUs = 0;
+    bool wakePending = false;
+    bool localTimeSet = false;
+    time_t localEpoch = 0;      // Local time at localBaseUs
+    uint32_t localBaseUs = 0;
+    uint32_t localTimeReads = 0;
+
+public:
+    uint32_t nowMicros() override {
+        return nowUs;
+    }
+
+    void sleepUntil(uint32_t deadlineUs) override {
+        if (!reached(nowUs, deadlineUs)) {
+            nowUs = deadlineUs;
+        }
+    }
+
+    bool waitUntil(uint32_t deadlineUs) override {
+        if (wakePending) {
+            wakePending = false;
+            return true;
+        }
+        sleepUntil(deadlineUs);
+        return false;
+    }
+
+    void wake() override {
+        wakePending = true;
+    }
+
+    bool localTime(struct tm& out) override {
+        localTimeReads++;
+        if (!localTimeSet) {
+            return false;
+        }
+        time_t seconds = localEpoch + static_cast<time_t>((nowUs - localBaseUs) / 1000000);
+        return gmtime_r(&seconds, &out) != nullptr;
+    }
+
+    /**
+     * @brief Number of localTime() calls, to check it is read once per scan
+     */
+    uint32_t getLocalTimeReads() const {
+        return localTimeReads;
+    }
+
+    /**
+     * @brief Set the local time of day, as NTP synchronisation would
+     * @param epoch Seconds since 1970 at the current clock time
+     */
+    void setLocalTime(time_t epoch) {
+        localTimeSet = true;
+        localEpoch = epoch;
+        localBaseUs = nowUs;
+    }
+
+    /**
+     * @brief Advance time, e.g. to simulate scan execution time
+     * @param us Microseconds to advance
+     */
+    void advance(uint32_t us) {
+        nowUs += us;
+    }
+
+    /**
+     * @brief Set specific time
+     * @param us Absolute time in microseconds
+     */
+    void setTime(uint32_t us) {
+        nowUs = us;
+    }
+};
+
+#endif // MANUAL_PLC_CLOCK_H
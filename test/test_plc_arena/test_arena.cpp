@@ -0,0 +1,207 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "Engine/PlcArena.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+/**
+ * @brief Program arena tests
+ *
+ * A loaded program keeps a fixed number of heap allocations however many
+ * blocks it has, and loading and unloading programs 10,000 times returns
+ * the heap to where it started.
+ */
+
+// Heap allocations made through operator new
+static long liveAllocations = 0;
+static long totalAllocations = 0;
+
+void* operator new(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        abort();
+    }
+    liveAllocations++;
+    totalAllocations++;
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    void* p = malloc(size ? size : 1);
+    if (p) {
+        liveAllocations++;
+        totalAllocations++;
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        liveAllocations--;
+        free(p);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+// A chain of ADD and GT blocks over short variable names
+static std::string makeChain(int blockCount, const char* engine, const char* execution) {
+    std::string json = "{\"memory\": {\"v0\": {\"type\": \"real\"}, \"one\": {\"type\": \"real\"}";
+    char buf[160];
+    for (int i = 1; i <= blockCount; i++) {
+        snprintf(buf, sizeof(buf), ", \"v%d\": {\"type\": \"%s\"}", i, i % 2 ? "real" : "bool");
+        json += buf;
+    }
+    json += "}, \"logic\": [";
+    for (int i = 1; i <= blockCount; i++) {
+        if (i % 2) {
+            snprintf(buf, sizeof(buf), "%s{\"block_type\": \"ADD\", \"inputs\": [\"v%d\", \"one\"], \"outputs\": {\"out\": \"v%d\"}}",
+                     i > 1 ? ", " : "", i > 1 ? i - 2 : 0, i);
+        } else {
+            snprintf(buf, sizeof(buf), ", {\"block_type\": \"GT\", \"inputs\": [\"v%d\", \"one\"], \"outputs\": {\"out\": \"v%d\"}}",
+                     i - 1, i);
+        }
+        json += buf;
+    }
+    snprintf(buf, sizeof(buf), "], \"init\": [{\"action\": \"set_value\", \"variable\": \"one\", \"value\": 1.0}], "
+                               "\"engine\": \"%s\", \"execution\": \"%s\"}", engine, execution);
+    return json + buf;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_arena_aligns_and_overflows() {
+    PlcArena arena;
+    TEST_ASSERT_TRUE(arena.reserve(64));
+    TEST_ASSERT_EQUAL(64, arena.getCapacity());
+
+    arena.allocate(1, 1);
+    void* aligned = arena.allocate(8, 8);
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(aligned) % 8);
+    TEST_ASSERT_EQUAL(1, arena.getChunkCount());
+    TEST_ASSERT_EQUAL(0, arena.getOverflow());
+
+    // Does not fit: a chunk is added
+    void* large = arena.allocate(2000, 4);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_EQUAL(2, arena.getChunkCount());
+    TEST_ASSERT_TRUE(arena.getOverflow() >= 2000);
+    TEST_ASSERT_TRUE(arena.getUsed() >= 2009);
+
+    long live = liveAllocations;
+    arena.release();
+    TEST_ASSERT_EQUAL(live - 2, liveAllocations);
+    TEST_ASSERT_EQUAL(0, arena.getCapacity());
+    TEST_ASSERT_EQUAL(0, arena.getUsed());
+    TEST_ASSERT_EQUAL(0, arena.getChunkCount());
+}
+
+void test_allocator_without_arena_uses_heap() {
+    long live = liveAllocations;
+    {
+        PlcArenaVector<int> values;
+        values.push_back(1);
+        values.push_back(2);
+        TEST_ASSERT_EQUAL(live + 1, liveAllocations);
+    }
+    TEST_ASSERT_EQUAL(live, liveAllocations);
+
+    PlcArena arena;
+    arena.reserve(256);
+    live = liveAllocations;
+    PlcArenaVector<int> values{PlcArenaAllocator<int>(&arena)};
+    for (int i = 0; i < 16; i++) {
+        values.push_back(i);
+    }
+    TEST_ASSERT_EQUAL(live, liveAllocations);
+    TEST_ASSERT_EQUAL(15, values[15]);
+}
+
+// Allocations a loaded program keeps
+static long retainedAllocations(PlcProgram& program, const std::string& json) {
+    long live = liveAllocations;
+    TEST_ASSERT_TRUE(program.loadConfiguration(json.c_str()));
+    return liveAllocations - live;
+}
+
+void test_retained_allocations_do_not_grow_with_blocks() {
+    const char* engines[][2] = {{"bytecode", "cyclic"}, {"blocks", "cyclic"}, {"blocks", "incremental"}};
+    for (auto& engine : engines) {
+        PlcProgram small("small", nullptr, nullptr);
+        PlcProgram large("large", nullptr, nullptr);
+        long smallCount = retainedAllocations(small, makeChain(10, engine[0], engine[1]));
+        long largeCount = retainedAllocations(large, makeChain(300, engine[0], engine[1]));
+        printf("%s/%s: %ld allocations for 10 blocks, %ld for 300, arena %u of %u bytes\n", engine[0], engine[1],
+               smallCount, largeCount, (unsigned)large.getArena().getUsed(), (unsigned)large.getArena().getCapacity());
+        TEST_ASSERT_EQUAL(smallCount, largeCount);
+        TEST_ASSERT_EQUAL(0, small.getArena().getOverflow());
+        TEST_ASSERT_EQUAL(0, large.getArena().getOverflow());
+        TEST_ASSERT_EQUAL(1, large.getArena().getChunkCount());
+        TEST_ASSERT_TRUE(large.getEstimatedMemoryUsage() >= large.getArena().getCapacity());
+    }
+}
+
+void test_soak_load_unload() {
+    std::string programs[] = {
+        makeChain(5, "bytecode", "cyclic"),
+        makeChain(40, "blocks", "cyclic"),
+        makeChain(20, "blocks", "incremental"),
+        "{\"logic\": [{\"block_type\": \"ADD\", \"inputs\": [\"a\", \"b\"], \"outputs\": {\"out\": \"s\"}}, {\"block_type\": \"NOPE\"}]}",
+    };
+    long baseline = liveAllocations;
+    long firstRound = 0;
+    {
+        PlcProgram reused("reused", nullptr, nullptr);
+        for (int i = 0; i < 10000; i++) {
+            const std::string& json = programs[i % 4];
+            {
+                PlcProgram program("soak", nullptr, nullptr);
+                bool loaded = program.loadConfiguration(json.c_str());
+                TEST_ASSERT_EQUAL(i % 4 != 3, loaded);
+                if (loaded) {
+                    program.run();
+                    program.evaluate();
+                }
+            }
+            // Reloading the same program object releases the previous one;
+            // only buffers PlcMemory keeps for the next load remain
+            reused.loadConfiguration(json.c_str());
+            if (i == 3) {
+                firstRound = liveAllocations;
+            }
+        }
+        TEST_ASSERT_EQUAL(firstRound, liveAllocations);
+    }
+    printf("soak: %ld allocations in total, %ld live after unloading\n", totalAllocations, liveAllocations - baseline);
+    TEST_ASSERT_EQUAL(baseline, liveAllocations);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_arena_aligns_and_overflows);
+    RUN_TEST(test_allocator_without_arena_uses_heap);
+    RUN_TEST(test_retained_allocations_do_not_grow_with_blocks);
+    RUN_TEST(test_soak_load_unload);
+    UNITY_END();
+    return 0;
+}
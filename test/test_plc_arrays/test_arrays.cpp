@@ -0,0 +1,318 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "Engine/PlcProgramImage.h"
+#include "../lib/PlcTestHelpers/BenchTimer.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief ARRAY variables and vector block tests
+ *
+ * "array[N] of int" declares N consecutive slots "name[0]".."name[N-1]"
+ * whose values are contiguous in memory. The vector blocks (ARRAY_SUM,
+ * ARRAY_MIN, ARRAY_SCALE, ...) loop over them; they are checked in both
+ * engines and timed against the scalar block chain they replace.
+ */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::string withEngine(const char* config, const char* engineName) {
+    std::string json = config;
+    json.insert(json.find('{') + 1, std::string("\"engine\": \"") + engineName + "\", ");
+    return json;
+}
+
+static const char* ENGINES[] = {"bytecode", "blocks"};
+
+static void setElements(PlcMemory& memory, const char* name, const std::vector<float>& values) {
+    for (size_t i = 0; i < values.size(); i++) {
+        memory.setValue<float>(std::string(name) + "[" + std::to_string(i) + "]", values[i]);
+    }
+}
+
+void test_array_elements_are_contiguous() {
+    PlcMemory memory;
+    TEST_ASSERT_TRUE(memory.declareVariable("before", PlcValueType::INT));
+    TEST_ASSERT_TRUE(memory.declareArray("levels", PlcValueType::INT, 8, true));
+    TEST_ASSERT_TRUE(memory.declareVariable("after", PlcValueType::INT));
+
+    PlcArrayRef levels = memory.findArray("levels");
+    TEST_ASSERT_TRUE(levels.isValid());
+    TEST_ASSERT_EQUAL_UINT16(8, levels.length);
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::INT), static_cast<int>(levels.type));
+    TEST_ASSERT_FALSE(memory.findArray("before").isValid());
+    TEST_ASSERT_EQUAL(1u, memory.getArrayCount());
+
+    // Elements are ordinary variables, their values follow each other
+    for (uint16_t i = 0; i < 8; i++) {
+        std::string element = "levels[" + std::to_string(i) + "]";
+        TEST_ASSERT_EQUAL_UINT16(levels.element(i).index, memory.findHandle(element).index);
+        memory.setValue<int16_t>(element, static_cast<int16_t>(i * 10));
+    }
+    const int16_t* values = memory.arrayData<int16_t>(levels);
+    for (uint16_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_INT16(i * 10, values[i]);
+    }
+
+    // Neither the array name nor an element can be declared again as a scalar
+    TEST_ASSERT_FALSE(memory.declareVariable("levels", PlcValueType::INT));
+    TEST_ASSERT_FALSE(memory.declareVariable("levels[3]", PlcValueType::REAL));
+    TEST_ASSERT_TRUE(memory.declareVariable("levels[3]", PlcValueType::INT)); // Same type: attributes only
+    TEST_ASSERT_FALSE(memory.declareArray("levels", PlcValueType::INT, 8));
+    TEST_ASSERT_FALSE(memory.declareArray("after", PlcValueType::INT, 2));
+    TEST_ASSERT_FALSE(memory.declareArray("empty", PlcValueType::REAL, 0));
+    TEST_ASSERT_FALSE(memory.declareArray("huge", PlcValueType::REAL, PLC_MAX_ARRAY_LENGTH + 1));
+    TEST_ASSERT_FALSE(memory.declareArray("names", PlcValueType::STRING_TYPE, 4));
+}
+
+static const char* AGGREGATE_PROGRAM = R"({
+    "memory": {
+        "temps": {"type": "array[6] of real"},
+        "weights": {"type": "array[6] of real"},
+        "counts": {"type": "ARRAY [4] OF INT"},
+        "alarm_level": {"type": "real"}
+    },
+    "logic": [
+        {"block_type": "ARRAY_SUM", "inputs": {"in": "temps"}, "outputs": {"out": "temp_sum"}},
+        {"block_type": "ARRAY_AVG", "inputs": {"in": "temps"}, "outputs": {"out": "temp_avg"}},
+        {"block_type": "ARRAY_MIN", "inputs": {"in": "temps"}, "outputs": {"out": "coldest", "index": "coldest_zone"}},
+        {"block_type": "ARRAY_MAX", "inputs": {"in": "temps"}, "outputs": {"out": "hottest", "index": "hottest_zone"}},
+        {"block_type": "ARRAY_COUNT_GT", "inputs": {"in": "temps", "threshold": "alarm_level"}, "outputs": {"out": "zones_hot"}},
+        {"block_type": "ARRAY_DOT", "inputs": {"in1": "temps", "in2": "weights"}, "outputs": {"out": "weighted"}},
+        {"block_type": "ARRAY_SUM", "inputs": {"in": "counts"}, "outputs": {"out": "count_sum"}},
+        {"block_type": "ARRAY_MAX", "inputs": {"in": "counts"}, "outputs": {"out": "count_max", "index": "count_max_at"}},
+        {"block_type": "ARRAY_COUNT_GT", "inputs": {"in": "counts", "threshold": "alarm_level"}, "outputs": {"out": "counts_high"}}
+    ]
+})";
+
+void test_aggregate_blocks() {
+    for (const char* engineName : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withEngine(AGGREGATE_PROGRAM, engineName).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+
+        setElements(memory, "temps", {21.5f, 19.0f, 25.0f, 18.5f, 25.0f, 20.0f});
+        setElements(memory, "weights", {1.0f, 0.0f, 2.0f, 0.0f, 0.0f, 0.5f});
+        setElements(memory, "counts", {-3, 7, 7, 30000});
+        memory.setValue<float>("alarm_level", 20.5f);
+        program.evaluate();
+
+        TEST_ASSERT_EQUAL_FLOAT(129.0f, memory.getValue<float>("temp_sum"));
+        TEST_ASSERT_EQUAL_FLOAT(21.5f, memory.getValue<float>("temp_avg"));
+        TEST_ASSERT_EQUAL_FLOAT(18.5f, memory.getValue<float>("coldest"));
+        TEST_ASSERT_EQUAL_INT16(3, memory.getValue<int16_t>("coldest_zone"));
+        TEST_ASSERT_EQUAL_FLOAT(25.0f, memory.getValue<float>("hottest"));
+        TEST_ASSERT_EQUAL_INT16(2, memory.getValue<int16_t>("hottest_zone")); // The first of two
+        TEST_ASSERT_EQUAL_INT16(3, memory.getValue<int16_t>("zones_hot"));
+        TEST_ASSERT_EQUAL_FLOAT(81.5f, memory.getValue<float>("weighted"));
+        // INT sums do not overflow on the way; the undeclared output is REAL
+        TEST_ASSERT_EQUAL_FLOAT(30011.0f, memory.getValue<float>("count_sum"));
+        TEST_ASSERT_EQUAL_FLOAT(30000.0f, memory.getValue<float>("count_max"));
+        TEST_ASSERT_EQUAL_INT16(3, memory.getValue<int16_t>("count_max_at"));
+        TEST_ASSERT_EQUAL_INT16(1, memory.getValue<int16_t>("counts_high")); // 20.5 compares as 20 for INT
+    }
+}
+
+void test_elementwise_blocks() {
+    for (const char* engineName : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withEngine(R"({
+            "memory": {
+                "raw": {"type": "array[4] of int"}, "bias": {"type": "array[4] of int"},
+                "sum": {"type": "array[4] of int"}, "product": {"type": "array[4] of int"},
+                "scaled": {"type": "array[4] of int"}, "celsius": {"type": "array[4] of real"},
+                "gain": {"type": "real"}, "zero": {"type": "real"}
+            },
+            "logic": [
+                {"block_type": "ARRAY_ADD", "inputs": {"in1": "raw", "in2": "bias"}, "outputs": {"out": "sum"}},
+                {"block_type": "ARRAY_MUL", "inputs": {"in1": "raw", "in2": "bias"}, "outputs": {"out": "product"}},
+                {"block_type": "ARRAY_SCALE", "inputs": {"in": "raw", "factor": "gain", "offset": "zero"}, "outputs": {"out": "scaled"}},
+                {"block_type": "ARRAY_SCALE", "inputs": {"in": "celsius", "factor": "gain"}, "outputs": {"out": "celsius"}}
+            ]
+        })", engineName).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+
+        setElements(memory, "raw", {100, -20, 30000, 7});
+        setElements(memory, "bias", {1, 2, 10000, -3});
+        setElements(memory, "celsius", {1.0f, 2.0f, 3.0f, 4.0f});
+        memory.setValue<float>("gain", 0.5f);
+        memory.setValue<float>("zero", -1.0f);
+        program.evaluate();
+
+        const int16_t sum[] = {101, -18, -25536, 4}; // Wraps like ADD on INT
+        const int16_t product[] = {100, -40, static_cast<int16_t>(300000000), -21};
+        const int16_t scaled[] = {49, -11, 14999, 2}; // 2.5 stored as 2
+        for (int i = 0; i < 4; i++) {
+            std::string index = "[" + std::to_string(i) + "]";
+            TEST_ASSERT_EQUAL_INT16(sum[i], memory.getValue<int16_t>("sum" + index));
+            TEST_ASSERT_EQUAL_INT16(product[i], memory.getValue<int16_t>("product" + index));
+            TEST_ASSERT_EQUAL_INT16(scaled[i], memory.getValue<int16_t>("scaled" + index));
+            TEST_ASSERT_EQUAL_FLOAT((i + 1) * 0.5f, memory.getValue<float>("celsius" + index)); // In place
+        }
+    }
+}
+
+void test_incremental_execution_sees_array_changes() {
+    PlcProgram program("main", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(R"({
+        "execution": "incremental",
+        "memory": {
+            "raw": {"type": "array[4] of real"}, "scaled": {"type": "array[4] of real"},
+            "gain": {"type": "real"}, "total": {"type": "real"}
+        },
+        "logic": [
+            {"block_type": "ARRAY_SUM", "inputs": {"in": "scaled"}, "outputs": {"out": "total"}},
+            {"block_type": "ARRAY_SCALE", "inputs": {"in": "raw", "factor": "gain"}, "outputs": {"out": "scaled"}}
+        ]
+    })"));
+    program.run();
+    PlcMemory& memory = program.getMemory();
+    memory.setValue<float>("gain", 2.0f);
+    setElements(memory, "raw", {1.0f, 2.0f, 3.0f, 4.0f});
+    program.evaluate();
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, memory.getValue<float>("total"));
+
+    // One element written: SCALE runs for it and SUM for SCALE's output
+    memory.setValue<float>("raw[2]", 13.0f);
+    program.evaluate();
+    TEST_ASSERT_EQUAL_FLOAT(26.0f, memory.getValue<float>("scaled[2]"));
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, memory.getValue<float>("total"));
+}
+
+void test_array_errors() {
+    PlcProgram program("main", nullptr, nullptr);
+    // Not an array
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "memory": {"level": {"type": "real"}},
+        "logic": [{"block_type": "ARRAY_SUM", "inputs": {"in": "level"}, "outputs": {"out": "total"}}]
+    })"));
+    // Arrays of different lengths
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "memory": {"a": {"type": "array[4] of real"}, "b": {"type": "array[5] of real"}},
+        "logic": [{"block_type": "ARRAY_DOT", "inputs": {"in1": "a", "in2": "b"}, "outputs": {"out": "d"}}]
+    })"));
+    // Element types differ
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "memory": {"a": {"type": "array[4] of real"}, "b": {"type": "array[4] of int"}},
+        "logic": [{"block_type": "ARRAY_ADD", "inputs": {"in1": "a", "in2": "a"}, "outputs": {"out": "b"}}]
+    })"));
+    // BOOL arrays are storage only
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "memory": {"flags": {"type": "array[8] of bool"}},
+        "logic": [{"block_type": "ARRAY_SUM", "inputs": {"in": "flags"}, "outputs": {"out": "total"}}]
+    })"));
+    // Declarations
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({"memory": {"a": {"type": "array[0] of real"}}, "logic": []})"));
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({"memory": {"a": {"type": "array[300] of real"}}, "logic": []})"));
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({"memory": {"a": {"type": "array[4] of string"}}, "logic": []})"));
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({"memory": {"a": {"type": "array[4] of real", "mesh_link": "x"}}, "logic": []})"));
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({"memory": {"a": {"type": "array[4] real"}}, "logic": []})"));
+
+    // A BOOL array whose elements the scalar blocks use
+    TEST_ASSERT_TRUE(program.loadConfiguration(R"({
+        "memory": {"flags": {"type": "array[8] of bool"}},
+        "logic": [{"block_type": "AND", "inputs": ["flags[0]", "flags[7]"], "outputs": {"out": "both"}}]
+    })"));
+    program.run();
+    program.getMemory().setValue<bool>("flags[0]", true);
+    program.getMemory().setValue<bool>("flags[7]", true);
+    program.evaluate();
+    TEST_ASSERT_TRUE(program.getMemory().getValue<bool>("both"));
+}
+
+void test_image_keeps_array_lengths() {
+    std::vector<uint8_t> data;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(R"({
+        "memory": {"temps": {"type": "Array[16] of REAL", "retentive": true}, "level": {"type": "int"}},
+        "logic": []
+    })", "main", data));
+    PlcProgramImage image;
+    TEST_ASSERT_TRUE(image.open(data.data(), data.size(), "main"));
+    TEST_ASSERT_EQUAL_UINT16(2, image.getVariableCount());
+    PlcProgramSource::Variable temps = image.getVariable(0);
+    TEST_ASSERT_EQUAL_STRING("temps", temps.name);
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::REAL), static_cast<int>(temps.type));
+    TEST_ASSERT_EQUAL_UINT16(16, temps.arrayLength);
+    TEST_ASSERT_TRUE(temps.retentive);
+    TEST_ASSERT_EQUAL_UINT16(0, image.getVariable(1).arrayLength);
+
+    PlcProgram program("main", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadImage(data.data(), data.size()));
+    TEST_ASSERT_EQUAL_UINT16(16, program.getMemory().findArray("temps").length);
+    TEST_ASSERT_EQUAL(16u, program.getMemory().getRetentive().getSlotCount());
+}
+
+// `sensors` REAL inputs summed by ARRAY_SUM, or by the chain of binary ADD
+// blocks and intermediate variables a program needs without arrays
+static std::string makeSumJson(int sensors, bool array, const char* engineName) {
+    std::string json = "{\"engine\": \"";
+    json += engineName;
+    json += "\", \"memory\": {\"total\": {\"type\": \"real\"}, ";
+    if (array) {
+        json += "\"t\": {\"type\": \"array[" + std::to_string(sensors) + "] of real\"}}, \"logic\": [";
+        json += "{\"block_type\": \"ARRAY_SUM\", \"inputs\": {\"in\": \"t\"}, \"outputs\": {\"out\": \"total\"}}";
+    } else {
+        for (int i = 0; i < sensors; i++) {
+            json += "\"t[" + std::to_string(i) + "]\": {\"type\": \"real\"}";
+            json += i + 1 < sensors ? ", " : "}, \"logic\": [";
+        }
+        for (int i = 1; i < sensors; i++) {
+            std::string left = i == 1 ? "t[0]" : "s" + std::to_string(i - 1);
+            std::string out = i + 1 == sensors ? "total" : "s" + std::to_string(i);
+            json += "{\"block_type\": \"ADD\", \"inputs\": [\"" + left + "\", \"t[" + std::to_string(i) + "]\"], ";
+            json += "\"outputs\": {\"out\": \"" + out + "\"}}";
+            json += i + 1 < sensors ? ", " : "";
+        }
+    }
+    json += "]}";
+    return json;
+}
+
+void test_benchmark_array_sum_vs_add_chain() {
+    const int cycles = 20000;
+    for (int sensors : {16, 64}) {
+        for (const char* engineName : ENGINES) {
+            unsigned long elapsed[2];
+            float totals[2];
+            size_t blocks[2];
+            for (int array = 0; array < 2; array++) {
+                PlcProgram program("sum", nullptr, nullptr);
+                TEST_ASSERT_TRUE(program.loadConfiguration(makeSumJson(sensors, array, engineName).c_str()));
+                blocks[array] = program.getBlockCount();
+                PlcMemory& memory = program.getMemory();
+                std::vector<VarHandle> inputs;
+                for (int i = 0; i < sensors; i++) {
+                    inputs.push_back(memory.findHandle("t[" + std::to_string(i) + "]"));
+                }
+                program.run();
+                unsigned long start = benchMicros();
+                for (int c = 0; c < cycles; c++) {
+                    memory.setValue<float>(inputs[c % sensors], static_cast<float>(c % 50));
+                    program.evaluate();
+                }
+                elapsed[array] = benchMicros() - start;
+                totals[array] = memory.getValue<float>("total");
+            }
+            TEST_ASSERT_EQUAL_FLOAT(totals[0], totals[1]);
+            TEST_ASSERT_EQUAL(sensors - 1, blocks[0]);
+            TEST_ASSERT_EQUAL(1, blocks[1]);
+            printf("%-8s %d sensors x %d cycles: %d ADD blocks %lu us, ARRAY_SUM %lu us\n",
+                   engineName, sensors, cycles, sensors - 1, elapsed[0], elapsed[1]);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_array_elements_are_contiguous);
+    RUN_TEST(test_aggregate_blocks);
+    RUN_TEST(test_elementwise_blocks);
+    RUN_TEST(test_incremental_execution_sees_array_changes);
+    RUN_TEST(test_array_errors);
+    RUN_TEST(test_image_keeps_array_lengths);
+    RUN_TEST(test_benchmark_array_sum_vs_add_chain);
+    return UNITY_END();
+}
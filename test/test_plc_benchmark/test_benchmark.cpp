@@ -0,0 +1,147 @@
+#include <unity.h>
+#include "Engine/PlcMemory.h"
+#include "Engine/PlcBytecode.h"
+#include "Blocks/math/BlockADD.h"
+#include "../lib/PlcTestHelpers/BenchTimer.h"
+#include <vector>
+#include <string>
+#include <cstdio>
+
+/**
+ * @brief Scan-cycle benchmark
+ *
+ * Runs a chain of ADD blocks and compares the handle-based evaluation
+ * with the previous per-cycle name lookup approach and with the bytecode
+ * VM. Results are printed as cycles per second.
+ */
+
+static const int CHAIN_LENGTH = 200;
+static const int CYCLES = 500;
+
+PlcMemory* memory = nullptr;
+std::vector<BlockADD*> blocks;
+
+static std::string resName(int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "res_%d", i);
+    return std::string(buf);
+}
+
+void setUp(void) {
+    memory = new PlcMemory();
+
+    for (int i = 0; i < CHAIN_LENGTH; i++) {
+        JsonDocument doc;
+        JsonArray inputs = doc["inputs"].to<JsonArray>();
+        inputs.add(i == 0 ? std::string("in_start") : resName(i - 1));
+        inputs.add("const_1");
+        doc["outputs"]["out"] = resName(i);
+
+        BlockADD* block = new BlockADD();
+        block->configure(doc.as<JsonObject>(), *memory);
+        blocks.push_back(block);
+    }
+
+    memory->setValue<float>("in_start", 0.0f);
+    memory->setValue<float>("const_1", 1.0f);
+}
+
+void tearDown(void) {
+    for (BlockADD* block : blocks) {
+        delete block;
+    }
+    blocks.clear();
+    delete memory;
+}
+
+static void printRate(const char* label, unsigned long elapsedUs) {
+    double cyclesPerSec = elapsedUs > 0 ? (CYCLES * 1000000.0) / elapsedUs : 0.0;
+    printf("%-14s %d blocks x %d cycles: %lu us (%.0f cycles/s)\n",
+           label, CHAIN_LENGTH, CYCLES, elapsedUs, cyclesPerSec);
+}
+
+void test_handle_chain_is_faster_than_name_lookup() {
+    // Reference: resolve every variable by name on every cycle
+    std::vector<std::string> inNames, outNames;
+    for (int i = 0; i < CHAIN_LENGTH; i++) {
+        inNames.push_back(i == 0 ? std::string("in_start") : resName(i - 1));
+        outNames.push_back(resName(i));
+    }
+
+    unsigned long start = benchMicros();
+    for (int c = 0; c < CYCLES; c++) {
+        for (int i = 0; i < CHAIN_LENGTH; i++) {
+            float sum = memory->getValue<float>(inNames[i], 0.0f) + memory->getValue<float>("const_1", 0.0f);
+            memory->setValue<float>(outNames[i], sum);
+        }
+    }
+    unsigned long nameUs = benchMicros() - start;
+    float nameResult = memory->getValue<float>(resName(CHAIN_LENGTH - 1), 0.0f);
+
+    // Blocks with slot handles resolved at configure time
+    start = benchMicros();
+    for (int c = 0; c < CYCLES; c++) {
+        for (BlockADD* block : blocks) {
+            block->evaluate(*memory);
+        }
+    }
+    unsigned long handleUs = benchMicros() - start;
+    float handleResult = memory->getValue<float>(resName(CHAIN_LENGTH - 1), 0.0f);
+
+    printRate("name lookup", nameUs);
+    printRate("slot handles", handleUs);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, (float)CHAIN_LENGTH, nameResult);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, (float)CHAIN_LENGTH, handleResult);
+    TEST_ASSERT_TRUE(handleUs < nameUs);
+}
+
+void test_bytecode_chain_is_faster_than_blocks() {
+    PlcBytecode code;
+    for (BlockADD* block : blocks) {
+        TEST_ASSERT_TRUE(block->lower(code));
+    }
+    code.finish();
+
+    unsigned long start = benchMicros();
+    for (int c = 0; c < CYCLES; c++) {
+        for (BlockADD* block : blocks) {
+            block->evaluate(*memory);
+        }
+    }
+    unsigned long blockUs = benchMicros() - start;
+
+    memory->setValue<float>(resName(CHAIN_LENGTH - 1), 0.0f);
+
+    start = benchMicros();
+    for (int c = 0; c < CYCLES; c++) {
+        code.execute(*memory);
+    }
+    unsigned long vmUs = benchMicros() - start;
+
+    printRate("blocks", blockUs);
+    printRate("bytecode VM", vmUs);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, (float)CHAIN_LENGTH, memory->getValue<float>(resName(CHAIN_LENGTH - 1), 0.0f));
+    TEST_ASSERT_TRUE(vmUs <= blockUs);
+}
+
+void test_resolve_returns_stable_handles() {
+    VarHandle a = memory->findHandle("const_1");
+    VarHandle b = memory->resolve("const_1", PlcValueType::BOOL);
+
+    TEST_ASSERT_TRUE(a.isValid());
+    TEST_ASSERT_EQUAL(a.index, b.index);
+    TEST_ASSERT_TRUE(b.type == PlcValueType::REAL); // Existing declaration wins
+    TEST_ASSERT_FALSE(memory->findHandle("missing").isValid());
+    TEST_ASSERT_FALSE(memory->resolve("", PlcValueType::BOOL).isValid());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_handle_chain_is_faster_than_name_lookup);
+    RUN_TEST(test_bytecode_chain_is_faster_than_blocks);
+    RUN_TEST(test_resolve_returns_stable_handles);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,376 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "../lib/PlcTestHelpers/BenchTimer.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Marker word tests
+ *
+ * BOOL variables are bits of 32-bit marker words. The BOOL array blocks
+ * (ARRAY_AND, ARRAY_R_TRIG, ...) work a word at a time, BOOL_ARRAY_TO_INT8
+ * reads consecutive bits at once, and the optimizer packs scalar logic
+ * blocks on bits at the same distances into one word operation. Results
+ * must match the scalar blocks in every engine.
+ */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::string withSettings(const char* config, const char* settings) {
+    std::string json = config;
+    json.insert(json.find('{') + 1, std::string(settings) + ", ");
+    return json;
+}
+
+static const char* ENGINES[] = {"\"engine\": \"bytecode\"", "\"engine\": \"blocks\"", "\"execution\": \"incremental\""};
+
+static std::string element(const char* name, int i) {
+    return std::string(name) + "[" + std::to_string(i) + "]";
+}
+
+void test_bit_refs_and_word_writes() {
+    PlcMemory memory;
+    TEST_ASSERT_TRUE(memory.declareVariable("a", PlcValueType::BOOL));
+    TEST_ASSERT_TRUE(memory.declareVariable("level", PlcValueType::INT));
+    TEST_ASSERT_TRUE(memory.declareVariable("b", PlcValueType::BOOL));
+    TEST_ASSERT_FALSE(memory.getBitRef(memory.findHandle("level")).isValid());
+
+    PlcBitRef a = memory.getBitRef(memory.findHandle("a"));
+    PlcBitRef b = memory.getBitRef(memory.findHandle("b"));
+    TEST_ASSERT_TRUE(a.isValid());
+    TEST_ASSERT_EQUAL_UINT16(a.word, b.word);
+    TEST_ASSERT_EQUAL_UINT8(a.bit() + 1, b.bit()); // BOOLs are allocated bit after bit
+
+    memory.setValue<bool>("b", true);
+    TEST_ASSERT_EQUAL_UINT32(b.mask, memory.loadWord(b.word));
+
+    // A masked store changes only the bits of the mask, and records the
+    // variables of the bits it changed
+    memory.setChangeTracking(true);
+    memory.clearChangedSlots();
+    memory.storeWord(a.word, ~0u, a.mask);
+    TEST_ASSERT_TRUE(memory.getValue<bool>("a"));
+    TEST_ASSERT_EQUAL_UINT32(a.mask | b.mask, memory.loadWord(a.word));
+    TEST_ASSERT_EQUAL(1u, memory.getChangedSlots().size());
+    TEST_ASSERT_EQUAL_UINT16(memory.findHandle("a").index, memory.getChangedSlots()[0]);
+
+    memory.clearChangedSlots();
+    memory.storeWord(a.word, a.mask | b.mask, a.mask | b.mask); // Unchanged
+    TEST_ASSERT_EQUAL(0u, memory.getChangedSlots().size());
+}
+
+void test_bool_arrays_start_at_a_word() {
+    PlcMemory memory;
+    TEST_ASSERT_TRUE(memory.declareVariable("before", PlcValueType::BOOL));
+    TEST_ASSERT_TRUE(memory.declareArray("flags", PlcValueType::BOOL, 40));
+    TEST_ASSERT_TRUE(memory.declareVariable("after", PlcValueType::BOOL));
+
+    PlcArrayRef flags = memory.findArray("flags");
+    uint16_t first = memory.getArrayWord(flags);
+    for (int i = 0; i < 40; i++) {
+        PlcBitRef bit = memory.getBitRef(flags.element(i));
+        TEST_ASSERT_EQUAL_UINT16(first + i / 32, bit.word);
+        TEST_ASSERT_EQUAL_UINT8(i % 32, bit.bit());
+    }
+    // The last word of the array is its own
+    TEST_ASSERT_EQUAL_UINT16(first + 2, memory.getBitRef(memory.findHandle("after")).word);
+    TEST_ASSERT_TRUE(memory.getBitRef(memory.findHandle("before")).word < first);
+    TEST_ASSERT_EQUAL(first + 3u, memory.getWordCount());
+}
+
+static const char* WORD_PROGRAM = R"({
+    "memory": {
+        "a": {"type": "array[40] of bool"}, "b": {"type": "array[40] of bool"},
+        "and": {"type": "array[40] of bool"}, "or": {"type": "array[40] of bool"},
+        "xor": {"type": "array[40] of bool"}, "not": {"type": "array[40] of bool"},
+        "guard": {"type": "bool"}
+    },
+    "logic": [
+        {"block_type": "ARRAY_AND", "inputs": {"in1": "a", "in2": "b"}, "outputs": {"out": "and"}},
+        {"block_type": "ARRAY_OR", "inputs": {"in1": "a", "in2": "b"}, "outputs": {"out": "or"}},
+        {"block_type": "ARRAY_XOR", "inputs": {"in1": "a", "in2": "b"}, "outputs": {"out": "xor"}},
+        {"block_type": "ARRAY_NOT", "inputs": {"in": "a"}, "outputs": {"out": "not"}}
+    ]
+})";
+
+void test_array_word_blocks() {
+    for (const char* settings : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withSettings(WORD_PROGRAM, settings).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+        for (int i = 0; i < 40; i++) {
+            memory.setValue<bool>(element("a", i), i % 3 == 0);
+            memory.setValue<bool>(element("b", i), i % 2 == 0);
+        }
+        program.evaluate();
+        for (int i = 0; i < 40; i++) {
+            bool a = i % 3 == 0, b = i % 2 == 0;
+            TEST_ASSERT_EQUAL_MESSAGE(a && b, memory.getValue<bool>(element("and", i)), settings);
+            TEST_ASSERT_EQUAL_MESSAGE(a || b, memory.getValue<bool>(element("or", i)), settings);
+            TEST_ASSERT_EQUAL_MESSAGE(a != b, memory.getValue<bool>(element("xor", i)), settings);
+            TEST_ASSERT_EQUAL_MESSAGE(!a, memory.getValue<bool>(element("not", i)), settings);
+        }
+        // NOT sets no bit past the end of its array
+        TEST_ASSERT_FALSE(memory.getValue<bool>("guard"));
+
+        memory.setValue<bool>("a[39]", false);
+        program.evaluate();
+        TEST_ASSERT_TRUE(memory.getValue<bool>("not[39]"));
+        TEST_ASSERT_FALSE(memory.getValue<bool>("or[39]"));
+    }
+}
+
+void test_array_edge_blocks() {
+    for (const char* settings : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withSettings(R"({
+            "memory": {
+                "doors": {"type": "array[36] of bool"},
+                "opened": {"type": "array[36] of bool"}, "closed": {"type": "array[36] of bool"}
+            },
+            "logic": [
+                {"block_type": "ARRAY_R_TRIG", "inputs": {"in": "doors"}, "outputs": {"q": "opened"}},
+                {"block_type": "ARRAY_F_TRIG", "inputs": {"in": "doors"}, "outputs": {"q": "closed"}}
+            ]
+        })", settings).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+        program.evaluate();
+
+        memory.setValue<bool>("doors[3]", true);
+        memory.setValue<bool>("doors[35]", true);
+        program.evaluate();
+        TEST_ASSERT_TRUE_MESSAGE(memory.getValue<bool>("opened[3]"), settings);
+        TEST_ASSERT_TRUE(memory.getValue<bool>("opened[35]"));
+        TEST_ASSERT_FALSE(memory.getValue<bool>("opened[4]"));
+        TEST_ASSERT_FALSE(memory.getValue<bool>("closed[3]"));
+
+        // One scan only, with no input change
+        program.evaluate();
+        TEST_ASSERT_FALSE_MESSAGE(memory.getValue<bool>("opened[3]"), settings);
+        TEST_ASSERT_FALSE(memory.getValue<bool>("opened[35]"));
+
+        memory.setValue<bool>("doors[35]", false);
+        program.evaluate();
+        TEST_ASSERT_TRUE(memory.getValue<bool>("closed[35]"));
+        TEST_ASSERT_FALSE(memory.getValue<bool>("closed[3]"));
+        program.evaluate();
+        TEST_ASSERT_FALSE(memory.getValue<bool>("closed[35]"));
+    }
+}
+
+void test_bool_array_to_int8_reads_bits_at_once() {
+    for (const char* settings : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        // "bits" straddles two marker words, "mixed" is not a run of bits
+        std::string memoryJson, bits;
+        for (int i = 0; i < 28; i++) {
+            memoryJson += "\"p" + std::to_string(i) + "\": {\"type\": \"bool\"}, ";
+        }
+        for (int i = 0; i < 8; i++) {
+            memoryJson += "\"b" + std::to_string(i) + "\": {\"type\": \"bool\"}, ";
+            bits += std::string(i ? ", " : "") + "\"b" + std::to_string(i) + "\"";
+        }
+        std::string json = "{" + std::string(settings) + ", \"memory\": {" + memoryJson +
+            "\"flags\": {\"type\": \"array[12] of bool\"}}, \"logic\": ["
+            "{\"block_type\": \"BOOL_ARRAY_TO_INT8\", \"inputs\": {\"in\": \"flags\"}, \"outputs\": {\"out\": \"from_array\"}}, "
+            "{\"block_type\": \"BOOL_ARRAY_TO_INT8\", \"inputs\": [" + bits + "], \"outputs\": {\"out\": \"from_bits\"}}, "
+            "{\"block_type\": \"BOOL_ARRAY_TO_INT8\", \"inputs\": [\"b7\", \"flags[0]\", \"b0\"], \"outputs\": {\"out\": \"mixed\"}}]}";
+        TEST_ASSERT_TRUE(program.loadConfiguration(json.c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+        TEST_ASSERT_EQUAL_UINT8(28, memory.getBitRef(memory.findHandle("b0")).bit());
+        TEST_ASSERT_EQUAL_UINT8(0, memory.getBitRef(memory.findHandle("b4")).bit());
+
+        for (int i = 0; i < 12; i++) {
+            memory.setValue<bool>(element("flags", i), i % 3 != 1);
+        }
+        for (int i = 0; i < 8; i++) {
+            memory.setValue<bool>("b" + std::to_string(i), i == 0 || i == 5 || i == 7);
+        }
+        program.evaluate();
+        TEST_ASSERT_EQUAL_INT_MESSAGE(static_cast<int8_t>(0x6D), memory.getValue<int8_t>("from_array"), settings);
+        TEST_ASSERT_EQUAL_INT8(static_cast<int8_t>(0xA1), memory.getValue<int8_t>("from_bits"));
+        TEST_ASSERT_EQUAL_INT8(0x07, memory.getValue<int8_t>("mixed"));
+
+        memory.setValue<bool>("b4", true);
+        memory.setValue<bool>("flags[6]", false);
+        memory.setValue<bool>("flags[8]", false); // Not one of the 8 bits
+        program.evaluate();
+        TEST_ASSERT_EQUAL_INT8(0x2D, memory.getValue<int8_t>("from_array"));
+        TEST_ASSERT_EQUAL_INT8(static_cast<int8_t>(0xB1), memory.getValue<int8_t>("from_bits"));
+    }
+
+    PlcProgram program("main", nullptr, nullptr);
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "memory": {"levels": {"type": "array[4] of int"}},
+        "logic": [{"block_type": "BOOL_ARRAY_TO_INT8", "inputs": {"in": "levels"}, "outputs": {"out": "x"}}]
+    })"));
+}
+
+// `count` scalar AND (or `op`) blocks q[i] = a[i] op b[i] over BOOL arrays,
+// as a program written without the array blocks would have them
+static std::string makeScalarJson(int count, const char* op, const char* settings, bool optimize) {
+    std::string n = std::to_string(count);
+    std::string json = "{" + std::string(settings) + ", \"optimize\": " + (optimize ? "true" : "false") +
+        ", \"memory\": {\"a\": {\"type\": \"array[" + n + "] of bool\"}, \"b\": {\"type\": \"array[" + n +
+        "] of bool\"}, \"q\": {\"type\": \"array[" + n + "] of bool\"}}, \"logic\": [";
+    for (int i = 0; i < count; i++) {
+        json += std::string(i ? ", " : "") + "{\"block_type\": \"" + op + "\", \"inputs\": [\"" + element("a", i) +
+            "\", \"" + element("b", i) + "\"], \"outputs\": {\"out\": \"" + element("q", i) + "\"}}";
+    }
+    return json + "]}";
+}
+
+static void expectSameResults(PlcProgram& plain, PlcProgram& packed, const std::vector<std::string>& inputs,
+                              const std::vector<std::string>& outputs, const char* message) {
+    plain.run();
+    packed.run();
+    srand(7);
+    for (int scan = 0; scan < 40; scan++) {
+        for (const std::string& name : inputs) {
+            if (rand() % 4 == 0) {
+                bool value = rand() % 2 == 0;
+                plain.getMemory().setValue<bool>(name, value);
+                packed.getMemory().setValue<bool>(name, value);
+            }
+        }
+        plain.evaluate();
+        packed.evaluate();
+        for (const std::string& name : outputs) {
+            TEST_ASSERT_EQUAL_MESSAGE(plain.getMemory().getValue<bool>(name), packed.getMemory().getValue<bool>(name), message);
+        }
+    }
+}
+
+void test_scalar_logic_is_packed() {
+    const char* ops[] = {"AND", "OR", "XOR", "NAND", "NOR"};
+    for (const char* settings : ENGINES) {
+        for (const char* op : ops) {
+            PlcProgram plain("plain", nullptr, nullptr);
+            PlcProgram packed("packed", nullptr, nullptr);
+            TEST_ASSERT_TRUE(plain.loadConfiguration(makeScalarJson(40, op, settings, false).c_str()));
+            TEST_ASSERT_TRUE(packed.loadConfiguration(makeScalarJson(40, op, settings, true).c_str()));
+            // 32 blocks on the first words of the arrays, 8 on the second
+            TEST_ASSERT_EQUAL(40, packed.getOptimization().packedBlocks);
+            TEST_ASSERT_EQUAL(2, packed.getOptimization().wordOps);
+            TEST_ASSERT_EQUAL(38, packed.getOptimization().getRemovedBlocks());
+            TEST_ASSERT_EQUAL(2, packed.getBlockCount());
+
+            std::vector<std::string> inputs, outputs;
+            for (int i = 0; i < 40; i++) {
+                inputs.push_back(element("a", i));
+                inputs.push_back(element("b", i));
+                outputs.push_back(element("q", i));
+            }
+            expectSameResults(plain, packed, inputs, outputs, op);
+        }
+    }
+}
+
+// Scalars declared one after the other: x[i], y[i] and z[i] are bits at
+// the same distances in one word
+static const char* SHIFTED_LOGIC = R"({
+    "memory": {
+        "x0": {"type": "bool"}, "x1": {"type": "bool"}, "x2": {"type": "bool"}, "x3": {"type": "bool"},
+        "y0": {"type": "bool"}, "y1": {"type": "bool"}, "y2": {"type": "bool"}, "y3": {"type": "bool"},
+        "z0": {"type": "bool"}, "z1": {"type": "bool"}, "z2": {"type": "bool"}, "z3": {"type": "bool"},
+        "n0": {"type": "bool"}, "n1": {"type": "bool"}, "n2": {"type": "bool"}, "n3": {"type": "bool"}
+    },
+    "logic": [
+        {"block_type": "OR", "inputs": ["x0", "y0"], "outputs": {"out": "z0"}},
+        {"block_type": "NOT", "inputs": {"in": "z0"}, "outputs": {"out": "n0"}},
+        {"block_type": "OR", "inputs": ["x1", "y1"], "outputs": {"out": "z1"}},
+        {"block_type": "NOT", "inputs": {"in": "z1"}, "outputs": {"out": "n1"}},
+        {"block_type": "OR", "inputs": ["x2", "y2"], "outputs": {"out": "z2"}},
+        {"block_type": "NOT", "inputs": {"in": "z2"}, "outputs": {"out": "n2"}},
+        {"block_type": "OR", "inputs": ["x3", "y3"], "outputs": {"out": "z3"}},
+        {"block_type": "NOT", "inputs": {"in": "z3"}, "outputs": {"out": "n3"}}
+    ]
+})";
+
+// The second AND reads what the NOT in between writes, so it cannot be
+// moved up to the first one
+static const char* DEPENDENT_LOGIC = R"({
+    "memory": {
+        "a": {"type": "array[4] of bool"}, "b": {"type": "array[4] of bool"}, "q": {"type": "array[4] of bool"}
+    },
+    "logic": [
+        {"block_type": "AND", "inputs": ["a[0]", "b[0]"], "outputs": {"out": "q[0]"}},
+        {"block_type": "NOT", "inputs": {"in": "q[0]"}, "outputs": {"out": "a[1]"}},
+        {"block_type": "AND", "inputs": ["a[1]", "b[1]"], "outputs": {"out": "q[1]"}},
+        {"block_type": "AND", "inputs": ["a[2]", "b[2]"], "outputs": {"out": "q[2]"}},
+        {"block_type": "AND", "inputs": ["a[3]", "q[1]"], "outputs": {"out": "q[3]"}}
+    ]
+})";
+
+void test_packing_keeps_data_flow() {
+    for (const char* settings : ENGINES) {
+        PlcProgram plain("plain", nullptr, nullptr);
+        PlcProgram packed("packed", nullptr, nullptr);
+        TEST_ASSERT_TRUE(plain.loadConfiguration(withSettings(SHIFTED_LOGIC, settings).c_str()));
+        TEST_ASSERT_TRUE(packed.loadConfiguration(withSettings(SHIFTED_LOGIC, (std::string(settings) + ", \"optimize\": true").c_str()).c_str()));
+        TEST_ASSERT_EQUAL(8, packed.getOptimization().packedBlocks);
+        TEST_ASSERT_EQUAL(2, packed.getOptimization().wordOps); // The ORs, then the NOTs
+        std::vector<std::string> inputs = {"x0", "x1", "x2", "x3", "y0", "y1", "y2", "y3"};
+        std::vector<std::string> outputs = {"z0", "z1", "z2", "z3", "n0", "n1", "n2", "n3"};
+        expectSameResults(plain, packed, inputs, outputs, settings);
+
+        PlcProgram plainDependent("plain", nullptr, nullptr);
+        PlcProgram packedDependent("packed", nullptr, nullptr);
+        TEST_ASSERT_TRUE(plainDependent.loadConfiguration(withSettings(DEPENDENT_LOGIC, settings).c_str()));
+        TEST_ASSERT_TRUE(packedDependent.loadConfiguration(withSettings(DEPENDENT_LOGIC, (std::string(settings) + ", \"optimize\": true").c_str()).c_str()));
+        // a[0] AND b[0] with a[2] AND b[2]; q[1] feeds q[3], whose operands
+        // are at other distances anyway
+        TEST_ASSERT_EQUAL(2, packedDependent.getOptimization().packedBlocks);
+        TEST_ASSERT_EQUAL(1, packedDependent.getOptimization().wordOps);
+        expectSameResults(plainDependent, packedDependent, {"a[0]", "a[2]", "a[3]", "b[0]", "b[1]", "b[2]"},
+                          {"q[0]", "q[1]", "q[2]", "q[3]", "a[1]"}, settings);
+    }
+}
+
+void test_benchmark_packed_logic() {
+    const int cycles = 20000;
+    const int count = 64;
+    for (const char* settings : ENGINES) {
+        unsigned long elapsed[2];
+        for (int optimize = 0; optimize < 2; optimize++) {
+            PlcProgram program("bits", nullptr, nullptr);
+            TEST_ASSERT_TRUE(program.loadConfiguration(makeScalarJson(count, "AND", settings, optimize).c_str()));
+            PlcMemory& memory = program.getMemory();
+            std::vector<VarHandle> inputs;
+            for (int i = 0; i < count; i++) {
+                inputs.push_back(memory.findHandle(element("a", i)));
+                memory.setValue<bool>(element("b", i), true);
+            }
+            program.run();
+            unsigned long start = benchMicros();
+            for (int c = 0; c < cycles; c++) {
+                memory.setValue<bool>(inputs[c % count], (c / count) % 2 == 0);
+                program.evaluate();
+            }
+            elapsed[optimize] = benchMicros() - start;
+            TEST_ASSERT_EQUAL(memory.getValue<bool>("a[63]"), memory.getValue<bool>("q[63]"));
+            TEST_ASSERT_EQUAL(optimize ? count : 0, program.getOptimization().packedBlocks);
+            TEST_ASSERT_EQUAL(optimize ? 2 : 0, program.getOptimization().wordOps);
+        }
+        printf("%-28s %d x %d cycles: %d AND blocks %lu us, packed into 2 word ops %lu us\n",
+               settings, count, cycles, count, elapsed[0], elapsed[1]);
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bit_refs_and_word_writes);
+    RUN_TEST(test_bool_arrays_start_at_a_word);
+    RUN_TEST(test_array_word_blocks);
+    RUN_TEST(test_array_edge_blocks);
+    RUN_TEST(test_bool_array_to_int8_reads_bits_at_once);
+    RUN_TEST(test_scalar_logic_is_packed);
+    RUN_TEST(test_packing_keeps_data_flow);
+    RUN_TEST(test_benchmark_packed_logic);
+    return UNITY_END();
+}
@@ -0,0 +1,87 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "Engine/PlcBlockRegistry.h"
+#include <cstring>
+
+/**
+ * @brief Block registry tests
+ *
+ * Every registered type is found by name and creates its block, unknown
+ * names are rejected, and the catalog lists each type once.
+ */
+
+static const PlcBlockContext CONTEXT = {nullptr, nullptr};
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_every_type_is_found_and_created() {
+    TEST_ASSERT_TRUE(PlcBlockRegistry::size() >= 43);
+    for (size_t i = 0; i < PlcBlockRegistry::size(); i++) {
+        const PlcBlockRegistry::Entry& entry = PlcBlockRegistry::at(i);
+        if (i > 0) {
+            TEST_ASSERT_TRUE(strcmp(PlcBlockRegistry::at(i - 1).type, entry.type) < 0);
+        }
+        TEST_ASSERT_EQUAL_PTR(&entry, PlcBlockRegistry::find(entry.type));
+        std::unique_ptr<PlcBlock> block = PlcBlockRegistry::create(entry.type, CONTEXT);
+        TEST_ASSERT_NOT_NULL(block.get());
+        TEST_ASSERT_NOT_NULL(entry.descriptor->description);
+    }
+}
+
+void test_unknown_types_are_rejected() {
+    TEST_ASSERT_NULL(PlcBlockRegistry::find("add"));
+    TEST_ASSERT_NULL(PlcBlockRegistry::find("ADDX"));
+    TEST_ASSERT_NULL(PlcBlockRegistry::find(""));
+    TEST_ASSERT_NULL(PlcBlockRegistry::find(nullptr));
+    TEST_ASSERT_NULL(PlcBlockRegistry::create("NOPE", CONTEXT).get());
+
+    PlcProgram program("registry", nullptr, nullptr);
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({"logic": [{"block_type": "NOPE"}]})"));
+}
+
+void test_catalog_lists_every_type() {
+    const String& catalog = PlcBlockRegistry::getCatalogJson();
+    TEST_ASSERT_EQUAL_PTR(&catalog, &PlcBlockRegistry::getCatalogJson()); // Built once
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, catalog.c_str()));
+    JsonArray blocks = doc.as<JsonArray>();
+    TEST_ASSERT_EQUAL(PlcBlockRegistry::size(), blocks.size());
+
+    JsonObject add = blocks[1];
+    TEST_ASSERT_EQUAL_STRING("ADD", add["type"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("math", add["category"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("float", add["inputs"]["in1"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("float", add["outputs"]["out"].as<const char*>());
+}
+
+void test_program_uses_registry_names() {
+    // String blocks are now reachable from programs
+    PlcProgram program("registry", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(R"({
+        "memory": {"a": {"type": "string"}, "b": {"type": "string"}, "ab": {"type": "string"}},
+        "logic": [{"block_type": "STRING_CONCAT", "inputs": ["a", "b"], "outputs": {"out": "ab"}}]
+    })"));
+    TEST_ASSERT_EQUAL_STRING("STRING_CONCAT", program.getBlockType(0));
+    TEST_ASSERT_EQUAL_PTR(PlcBlockRegistry::find("STRING_CONCAT")->type, program.getBlockType(0));
+
+    program.getMemory().setValue<String>("a", "foo");
+    program.getMemory().setValue<String>("b", "bar");
+    program.run();
+    program.evaluate();
+    TEST_ASSERT_EQUAL_STRING("foobar", program.getMemory().getValue<String>("ab", "").c_str());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_type_is_found_and_created);
+    RUN_TEST(test_unknown_types_are_rejected);
+    RUN_TEST(test_catalog_lists_every_type);
+    RUN_TEST(test_program_uses_registry_names);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,359 @@
+#include <unity.h>
+#include "Engine/PlcMemory.h"
+#include "Engine/PlcBytecode.h"
+#include "Blocks/logic/BlockAND.h"
+#include "Blocks/logic/BlockOR.h"
+#include "Blocks/logic/BlockXOR.h"
+#include "Blocks/logic/BlockNAND.h"
+#include "Blocks/logic/BlockNOR.h"
+#include "Blocks/logic/BlockNOT.h"
+#include "Blocks/logic/BlockSR.h"
+#include "Blocks/logic/BlockRS.h"
+#include "Blocks/math/BlockADD.h"
+#include "Blocks/math/BlockSUB.h"
+#include "Blocks/math/BlockMUL.h"
+#include "Blocks/math/BlockDIV.h"
+#include "Blocks/math/BlockMOD.h"
+#include "Blocks/math/BlockABS.h"
+#include "Blocks/math/BlockSQRT.h"
+#include "Blocks/math/BlockINC.h"
+#include "Blocks/math/BlockDEC.h"
+#include "Blocks/math/BlockEXPR.h"
+#include "Blocks/comparison/BlockGT.h"
+#include "Blocks/comparison/BlockGE.h"
+#include "Blocks/comparison/BlockLT.h"
+#include "Blocks/comparison/BlockLE.h"
+#include "Blocks/comparison/BlockEQ.h"
+#include "Blocks/comparison/BlockNE.h"
+#include "Blocks/conversion/BlockBoolArrayToInt8.h"
+#include "Blocks/conversion/BlockInt8ToInt16.h"
+#include "Blocks/conversion/BlockInt8ToUint8.h"
+#include "Blocks/conversion/BlockInt16ToUint16.h"
+#include "Blocks/conversion/BlockInt16ToFloat.h"
+#include "Blocks/conversion/BlockInt32ToDouble.h"
+#include "Blocks/counters/BlockCTU.h"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <utility>
+
+/**
+ * @brief Bytecode VM equivalence tests
+ *
+ * Every lowered block is run in lockstep through PlcBlock::evaluate() and
+ * through the bytecode VM on two separate memories with identical
+ * pseudo-random inputs. All outputs must match bit for bit.
+ */
+
+typedef PlcBlock* (*BlockFactory)();
+
+struct BlockCase {
+    const char* name;
+    BlockFactory create;
+    const char* config;
+    std::vector<const char*> inputs;
+    std::vector<const char*> outputs;
+};
+
+template<typename T> PlcBlock* make() { return new T(); }
+
+static const int STEPS = 400;
+static uint32_t rngState = 1;
+
+static uint32_t nextRandom() {
+    rngState = rngState * 1103515245u + 12345u;
+    return (rngState >> 8) & 0xFFFFFF;
+}
+
+void setUp(void) {
+    rngState = 12345;
+}
+
+void tearDown(void) {}
+
+static void randomizeInput(PlcMemory& a, PlcMemory& b, const char* name) {
+    VarHandle h = a.findHandle(name);
+    TEST_ASSERT_TRUE_MESSAGE(h.isValid(), name);
+
+    switch (h.type) {
+        case PlcValueType::BOOL: {
+            bool v = (nextRandom() & 1) != 0;
+            a.setValue<bool>(name, v);
+            b.setValue<bool>(name, v);
+            break;
+        }
+        case PlcValueType::REAL: {
+            // Include zeros and negative values to cover division/sqrt edge cases
+            float v = (nextRandom() % 8 == 0) ? 0.0f : ((int)(nextRandom() % 4001) - 2000) / 10.0f;
+            a.setValue<float>(name, v);
+            b.setValue<float>(name, v);
+            break;
+        }
+        default: {
+            int32_t v = (int32_t)(nextRandom() % 70001) - 35000;
+            if (nextRandom() % 8 == 0) v = 0;
+            a.setValue<int32_t>(name, v);
+            b.setValue<int32_t>(name, v);
+            break;
+        }
+    }
+}
+
+static void assertSameValue(PlcMemory& a, PlcMemory& b, const char* name, const char* block, int step) {
+    PlcValue va = a.getValueAsPlcValue(name);
+    PlcValue vb = b.getValueAsPlcValue(name);
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%s: output '%s' differs at step %d", block, name, step);
+
+    TEST_ASSERT_TRUE_MESSAGE(va.type == vb.type, msg);
+    switch (va.type) {
+        case PlcValueType::BOOL: TEST_ASSERT_EQUAL_MESSAGE(va.value.bVal, vb.value.bVal, msg); break;
+        case PlcValueType::BYTE: TEST_ASSERT_EQUAL_UINT8_MESSAGE(va.value.ui8Val, vb.value.ui8Val, msg); break;
+        case PlcValueType::INT: TEST_ASSERT_EQUAL_INT16_MESSAGE(va.value.i16Val, vb.value.i16Val, msg); break;
+        case PlcValueType::DINT: TEST_ASSERT_EQUAL_UINT32_MESSAGE(va.value.ui32Val, vb.value.ui32Val, msg); break;
+        case PlcValueType::REAL: TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&va.value.fVal, &vb.value.fVal, sizeof(float), msg); break;
+        case PlcValueType::STRING_TYPE: TEST_ASSERT_EQUAL_STRING_MESSAGE(va.value.sVal, vb.value.sVal, msg); break;
+    }
+}
+
+// `declared` variables are declared with their type before the block is configured
+static void runLockstep(const BlockCase& c, bool expectLowered,
+                        const std::vector<std::pair<const char*, PlcValueType>>& declared = {}) {
+    PlcMemory classicMemory;
+    PlcMemory vmMemory;
+    for (const auto& var : declared) {
+        classicMemory.declareVariable(var.first, var.second);
+        vmMemory.declareVariable(var.first, var.second);
+    }
+
+    JsonDocument docA;
+    JsonDocument docB;
+    TEST_ASSERT_FALSE(deserializeJson(docA, c.config));
+    TEST_ASSERT_FALSE(deserializeJson(docB, c.config));
+
+    PlcBlock* classic = c.create();
+    PlcBlock* lowered = c.create();
+    classic->configure(docA.as<JsonObject>(), classicMemory);
+    lowered->configure(docB.as<JsonObject>(), vmMemory);
+
+    PlcBytecode code;
+    bool wasLowered = lowered->lower(code);
+    TEST_ASSERT_EQUAL_MESSAGE(expectLowered, wasLowered, c.name);
+    if (!wasLowered) {
+        code.emitCall(lowered);
+    }
+    code.finish();
+
+    for (int step = 0; step < STEPS; step++) {
+        // Keep inputs for every other step so latches and INC/DEC accumulate
+        if (step % 2 == 0) {
+            for (const char* in : c.inputs) {
+                randomizeInput(classicMemory, vmMemory, in);
+            }
+        }
+
+        classic->evaluate(classicMemory);
+        code.execute(vmMemory);
+
+        for (const char* out : c.outputs) {
+            assertSameValue(classicMemory, vmMemory, out, c.name, step);
+        }
+    }
+
+    delete classic;
+    delete lowered;
+}
+
+static const char* BOOL3_OBJ = "{\"inputs\":{\"in1\":\"a\",\"in2\":\"b\",\"in3\":\"c\"},\"outputs\":{\"out\":\"q\"}}";
+static const char* REAL3_ARR = "{\"inputs\":[\"a\",\"b\",\"c\"],\"outputs\":{\"out\":\"q\"}}";
+static const char* BINARY = "{\"inputs\":{\"in1\":\"a\",\"in2\":\"b\"},\"outputs\":{\"out\":\"q\"}}";
+static const char* UNARY = "{\"inputs\":{\"in\":\"a\"},\"outputs\":{\"out\":\"q\"}}";
+static const char* IN_OUT = "{\"inputs\":{\"in_out\":\"a\"}}";
+static const char* LATCH = "{\"inputs\":{\"set\":\"s\",\"reset\":\"r\"},\"outputs\":{\"out\":\"q\"}}";
+
+void test_logic_blocks_match() {
+    std::vector<BlockCase> cases = {
+        { "AND", make<BlockAND>, BOOL3_OBJ, { "a", "b", "c" }, { "q" } },
+        { "OR", make<BlockOR>, BOOL3_OBJ, { "a", "b", "c" }, { "q" } },
+        { "XOR", make<BlockXOR>, BOOL3_OBJ, { "a", "b", "c" }, { "q" } },
+        { "NAND", make<BlockNAND>, BOOL3_OBJ, { "a", "b", "c" }, { "q" } },
+        { "NOR", make<BlockNOR>, BOOL3_OBJ, { "a", "b", "c" }, { "q" } },
+        { "NOT", make<BlockNOT>, UNARY, { "a" }, { "q" } },
+        { "SR", make<BlockSR>, LATCH, { "s", "r" }, { "q" } },
+        { "RS", make<BlockRS>, LATCH, { "s", "r" }, { "q" } },
+    };
+    for (const BlockCase& c : cases) {
+        runLockstep(c, true);
+    }
+}
+
+void test_math_blocks_match() {
+    std::vector<BlockCase> cases = {
+        { "ADD", make<BlockADD>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "SUB", make<BlockSUB>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "MUL", make<BlockMUL>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "DIV", make<BlockDIV>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "MOD", make<BlockMOD>, BINARY, { "a", "b" }, { "q" } },
+        { "ABS", make<BlockABS>, UNARY, { "a" }, { "q" } },
+        { "SQRT", make<BlockSQRT>, UNARY, { "a" }, { "q" } },
+        { "INC", make<BlockINC>, IN_OUT, { "a" }, { "a" } },
+        { "DEC", make<BlockDEC>, IN_OUT, { "a" }, { "a" } },
+        { "EXPR", make<BlockEXPR>, "{\"expression\":\"max(a, b) * 1.5 - sqrt(abs(c)) / 2\",\"outputs\":{\"out\":\"q\"}}",
+          { "a", "b", "c" }, { "q" } },
+        { "EXPR", make<BlockEXPR>, "{\"expression\":\"a > b && !(c < 0) || a == 0 ? 1 : -1\",\"outputs\":{\"out\":\"q\"}}",
+          { "a", "b", "c" }, { "q" } },
+    };
+    for (const BlockCase& c : cases) {
+        runLockstep(c, true);
+    }
+}
+
+void test_comparison_blocks_match() {
+    std::vector<BlockCase> cases = {
+        { "GT", make<BlockGT>, BINARY, { "a", "b" }, { "q" } },
+        { "GE", make<BlockGE>, BINARY, { "a", "b" }, { "q" } },
+        { "LT", make<BlockLT>, BINARY, { "a", "b" }, { "q" } },
+        { "LE", make<BlockLE>, BINARY, { "a", "b" }, { "q" } },
+        { "EQ", make<BlockEQ>, BINARY, { "a", "b" }, { "q" } },
+        { "NE", make<BlockNE>, BINARY, { "a", "b" }, { "q" } },
+    };
+    for (const BlockCase& c : cases) {
+        runLockstep(c, true);
+    }
+}
+
+void test_typed_blocks_match() {
+    // Operands declared INT or DINT run the typed kernels and the _II/_DD
+    // opcodes, which wrap around; mixed operands convert through REAL
+    std::vector<BlockCase> cases = {
+        { "ADD", make<BlockADD>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "SUB", make<BlockSUB>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "MUL", make<BlockMUL>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "DIV", make<BlockDIV>, REAL3_ARR, { "a", "b", "c" }, { "q" } },
+        { "GT", make<BlockGT>, BINARY, { "a", "b" }, { "q" } },
+        { "GE", make<BlockGE>, BINARY, { "a", "b" }, { "q" } },
+        { "LT", make<BlockLT>, BINARY, { "a", "b" }, { "q" } },
+        { "LE", make<BlockLE>, BINARY, { "a", "b" }, { "q" } },
+        { "EQ", make<BlockEQ>, BINARY, { "a", "b" }, { "q" } },
+        { "NE", make<BlockNE>, BINARY, { "a", "b" }, { "q" } },
+    };
+    for (PlcValueType type : { PlcValueType::INT, PlcValueType::DINT }) {
+        for (const BlockCase& c : cases) {
+            PlcValueType out = c.inputs.size() == 2 ? PlcValueType::BOOL : type;
+            runLockstep(c, true, { { "a", type }, { "b", type }, { "c", type }, { "q", out } });
+        }
+    }
+    for (const BlockCase& c : cases) {
+        runLockstep(c, true, { { "a", PlcValueType::INT }, { "b", PlcValueType::REAL }, { "c", PlcValueType::DINT } });
+    }
+}
+
+void test_conversion_blocks_match() {
+    std::vector<BlockCase> cases = {
+        { "BOOL_ARRAY_TO_INT8", make<BlockBoolArrayToInt8>,
+          "{\"inputs\":[\"b0\",\"b1\",\"b2\",\"b3\",\"b4\",\"b5\",\"b6\",\"b7\"],\"outputs\":{\"out\":\"q\"}}",
+          { "b0", "b1", "b2", "b3", "b4", "b5", "b6", "b7" }, { "q" } },
+        { "INT8_TO_INT16", make<BlockInt8ToInt16>, UNARY, { "a" }, { "q" } },
+        { "INT8_TO_UINT8", make<BlockInt8ToUint8>, UNARY, { "a" }, { "q" } },
+        { "INT16_TO_UINT16", make<BlockInt16ToUint16>, UNARY, { "a" }, { "q" } },
+        { "INT16_TO_FLOAT", make<BlockInt16ToFloat>, UNARY, { "a" }, { "q" } },
+        { "INT32_TO_DOUBLE", make<BlockInt32ToDouble>, UNARY, { "a" }, { "q" } },
+    };
+    for (const BlockCase& c : cases) {
+        runLockstep(c, true);
+    }
+}
+
+void test_fallback_block_matches() {
+    // Counters keep edge state in the block and run through CALL_BLOCK
+    BlockCase c = { "CTU", make<BlockCTU>,
+        "{\"inputs\":{\"cu\":\"cu\",\"reset\":\"r\",\"pv\":\"pv\"},\"outputs\":{\"q\":\"q\",\"cv\":\"cv\"}}",
+        { "cu", "r" }, { "q", "cv" } };
+    runLockstep(c, false);
+}
+
+void test_unconfigured_block_is_not_lowered() {
+    PlcMemory memory;
+    BlockADD block;
+    PlcBytecode code;
+
+    TEST_ASSERT_FALSE(block.lower(code));
+    TEST_ASSERT_EQUAL(0, code.getLoweredCount());
+}
+
+void test_mixed_program_matches() {
+    // ADD -> GT -> AND chain with a fallback counter in the middle
+    const char* configs[] = {
+        "{\"inputs\":[\"x\",\"y\"],\"outputs\":{\"out\":\"sum\"}}",
+        "{\"inputs\":{\"in1\":\"sum\",\"in2\":\"limit\"},\"outputs\":{\"out\":\"over\"}}",
+        "{\"inputs\":{\"cu\":\"over\",\"reset\":\"clr\",\"pv\":\"pv\"},\"outputs\":{\"q\":\"done\",\"cv\":\"count\"}}",
+        "{\"inputs\":{\"in1\":\"over\",\"in2\":\"done\"},\"outputs\":{\"out\":\"alarm\"}}",
+    };
+    BlockFactory factories[] = { make<BlockADD>, make<BlockGT>, make<BlockCTU>, make<BlockAND> };
+    const int COUNT = 4;
+
+    PlcMemory classicMemory;
+    PlcMemory vmMemory;
+    std::vector<PlcBlock*> classic;
+    std::vector<PlcBlock*> lowered;
+    PlcBytecode code;
+
+    for (int i = 0; i < COUNT; i++) {
+        JsonDocument docA;
+        JsonDocument docB;
+        deserializeJson(docA, configs[i]);
+        deserializeJson(docB, configs[i]);
+        classic.push_back(factories[i]());
+        lowered.push_back(factories[i]());
+        classic.back()->configure(docA.as<JsonObject>(), classicMemory);
+        lowered.back()->configure(docB.as<JsonObject>(), vmMemory);
+        if (!lowered.back()->lower(code)) {
+            code.emitCall(lowered.back());
+        }
+    }
+    code.finish();
+
+    TEST_ASSERT_EQUAL(3, code.getLoweredCount());
+    TEST_ASSERT_EQUAL(1, code.getFallbackCount());
+
+    classicMemory.setValue<float>("limit", 50.0f);
+    vmMemory.setValue<float>("limit", 50.0f);
+    classicMemory.setValue<int16_t>("pv", 5);
+    vmMemory.setValue<int16_t>("pv", 5);
+
+    const char* outputs[] = { "sum", "over", "done", "count", "alarm" };
+    for (int step = 0; step < STEPS; step++) {
+        randomizeInput(classicMemory, vmMemory, "x");
+        randomizeInput(classicMemory, vmMemory, "y");
+        randomizeInput(classicMemory, vmMemory, "clr");
+
+        for (PlcBlock* block : classic) {
+            block->evaluate(classicMemory);
+        }
+        code.execute(vmMemory);
+
+        for (const char* out : outputs) {
+            assertSameValue(classicMemory, vmMemory, out, "mixed", step);
+        }
+    }
+
+    for (int i = 0; i < COUNT; i++) {
+        delete classic[i];
+        delete lowered[i];
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_logic_blocks_match);
+    RUN_TEST(test_math_blocks_match);
+    RUN_TEST(test_comparison_blocks_match);
+    RUN_TEST(test_typed_blocks_match);
+    RUN_TEST(test_conversion_blocks_match);
+    RUN_TEST(test_fallback_block_matches);
+    RUN_TEST(test_unconfigured_block_is_not_lowered);
+    RUN_TEST(test_mixed_program_matches);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "../../lib/Devices/DeviceRegistry.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+
+/**
+ * @brief Cycle context tests
+ *
+ * Every scan starts the program's PlcCycleContext from one clock reading:
+ * the scan time, the time since the previous scan, the scan count and the
+ * local time of day, read from the clock at most once per scan. Tests set
+ * both times through ManualPlcClock.
+ */
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+// 2026-01-01 11:59:58 UTC
+static const time_t BEFORE_NOON = 1767268798;
+
+void setUp(void) {
+    clock_ = new ManualPlcClock();
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+}
+
+void tearDown(void) {
+    delete engine;
+    delete clock_;
+}
+
+// Run the PLC task until `ms` of virtual time have passed
+static void runFor(uint32_t ms) {
+    uint32_t end = clock_->nowMicros() + ms * 1000;
+    while (!PlcClock::reached(clock_->nowMicros(), end)) {
+        uint32_t next = engine->runDueCycles();
+        engine->waitUntil(PlcClock::reached(next, end) ? end : next);
+    }
+}
+
+static PlcProgram* program() {
+    return engine->getProgram("main");
+}
+
+static bool value(const char* name) {
+    return program()->getMemory().getValue<bool>(name);
+}
+
+static const char* NOON_PROGRAM = R"({
+    "logic": [
+        {"block_type": "TIME_COMPARE", "time": {"hour": 12, "minute": 0, "second": 0}, "outputs": {"out": "noon"}},
+        {"block_type": "TIME_COMPARE", "time": {"hour": 12, "minute": 0, "second": 1}, "outputs": {"out": "after_noon"}}
+    ],
+    "cycle_time_ms": 100
+})";
+
+void test_context_counts_scans_and_their_spacing() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "memory": {"n": {"type": "int"}},
+        "logic": [{"block_type": "INC", "inputs": {"in_out": "n"}}],
+        "cycle_time_ms": 10
+    })"));
+    const PlcCycleContext& context = program()->getCycleContext();
+    TEST_ASSERT_EQUAL_UINT32(0, context.getCycle());
+
+    engine->runProgram("main");
+    runFor(1);
+    TEST_ASSERT_EQUAL_UINT32(1, context.getCycle());
+    TEST_ASSERT_EQUAL_UINT32(0, context.getDeltaUs()); // No previous scan
+
+    runFor(99);
+    TEST_ASSERT_EQUAL_UINT32(10, context.getCycle());
+    TEST_ASSERT_EQUAL_UINT32(10000, context.getDeltaUs());
+    TEST_ASSERT_EQUAL_UINT32(90000, context.getNowUs());
+    TEST_ASSERT_EQUAL_UINT32(90, context.getNowMs());
+}
+
+void test_time_compare_follows_the_local_time_of_the_scan() {
+    clock_->setLocalTime(BEFORE_NOON);
+    TEST_ASSERT_TRUE(engine->loadProgram("main", NOON_PROGRAM));
+    engine->runProgram("main");
+
+    runFor(1500); // Last scan at 11:59:59.4
+    TEST_ASSERT_FALSE(value("noon"));
+    runFor(1000); // 12:00:00.4
+    TEST_ASSERT_TRUE(value("noon"));
+    TEST_ASSERT_FALSE(value("after_noon"));
+    runFor(1000); // 12:00:01.4
+    TEST_ASSERT_FALSE(value("noon"));
+    TEST_ASSERT_TRUE(value("after_noon"));
+}
+
+void test_time_compare_is_false_until_the_time_is_set() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", NOON_PROGRAM));
+    engine->runProgram("main");
+    runFor(1000);
+    TEST_ASSERT_FALSE(value("noon"));
+
+    clock_->setLocalTime(BEFORE_NOON + 2);
+    runFor(100);
+    TEST_ASSERT_TRUE(value("noon"));
+}
+
+void test_local_time_is_read_once_per_scan() {
+    clock_->setLocalTime(BEFORE_NOON);
+    TEST_ASSERT_TRUE(engine->loadProgram("main", NOON_PROGRAM));
+    engine->runProgram("main");
+
+    // Two blocks read the time of day, the clock is asked once per scan
+    runFor(1000);
+    TEST_ASSERT_EQUAL_UINT32(10, program()->getCycleContext().getCycle());
+    TEST_ASSERT_EQUAL_UINT32(10, clock_->getLocalTimeReads());
+}
+
+void test_programs_without_local_time_never_read_it() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "logic": [{"block_type": "TON", "inputs": {"in": "start", "pt": 50}, "outputs": {"q": "done"}}],
+        "cycle_time_ms": 10
+    })"));
+    engine->runProgram("main");
+    program()->getMemory().postValue<bool>("start", true);
+    runFor(100);
+    TEST_ASSERT_TRUE(value("done"));
+    TEST_ASSERT_EQUAL_UINT32(0, clock_->getLocalTimeReads());
+}
+
+void test_online_change_continues_the_scan_count() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", NOON_PROGRAM));
+    engine->runProgram("main");
+    runFor(1000);
+    TEST_ASSERT_EQUAL_UINT32(10, program()->getCycleContext().getCycle());
+
+    TEST_ASSERT_TRUE(engine->onlineChange("main", NOON_PROGRAM));
+    runFor(100);
+    TEST_ASSERT_FALSE(engine->isOnlineChangePending());
+    TEST_ASSERT_EQUAL_UINT32(11, program()->getCycleContext().getCycle());
+    TEST_ASSERT_EQUAL_UINT32(100000, program()->getCycleContext().getDeltaUs());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_context_counts_scans_and_their_spacing);
+    RUN_TEST(test_time_compare_follows_the_local_time_of_the_scan);
+    RUN_TEST(test_time_compare_is_false_until_the_time_is_set);
+    RUN_TEST(test_local_time_is_read_once_per_scan);
+    RUN_TEST(test_programs_without_local_time_never_read_it);
+    RUN_TEST(test_online_change_continues_the_scan_count);
+    return UNITY_END();
+}
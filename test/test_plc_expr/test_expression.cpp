@@ -0,0 +1,308 @@
+#include <unity.h>
+#include "Engine/PlcMemory.h"
+#include "Engine/PlcExpression.h"
+#include "Engine/PlcProgram.h"
+#include "../lib/PlcTestHelpers/BenchTimer.h"
+#include <cstdio>
+#include <string>
+
+/**
+ * @brief Expression block tests
+ *
+ * PlcExpression parses infix formulas with C precedence, checks their
+ * types and compiles them to a stack program bound to PlcMemory slots.
+ * An EXPR block gives the same results as the chain of blocks it
+ * replaces, with a fraction of the blocks, variables and JSON.
+ */
+
+static PlcMemory* memory = nullptr;
+static PlcExpression* expression = nullptr;
+
+static VarHandle resolve(void* context, const char* name, PlcValueType type) {
+    return static_cast<PlcMemory*>(context)->resolve(name, type);
+}
+
+static bool compile(const char* source) {
+    return expression->compile(source, resolve, memory);
+}
+
+void setUp(void) {
+    memory = new PlcMemory();
+    expression = new PlcExpression();
+}
+
+void tearDown(void) {
+    delete expression;
+    delete memory;
+}
+
+struct Case {
+    const char* source;
+    PlcExpression::Type type;
+    float value;
+};
+
+void test_precedence_and_literal_types() {
+    typedef PlcExpression::Type Type;
+    const Case cases[] = {
+        {"1 + 2 * 3", Type::INT, 7},
+        {"(1 + 2) * 3", Type::INT, 9},
+        {"10 - 4 - 3", Type::INT, 3},
+        {"7 / 2", Type::INT, 3},
+        {"7 / 2.0", Type::REAL, 3.5f},
+        {"-7 % 3", Type::INT, -1},
+        {"7 mod 3", Type::INT, 1},
+        {"2 * -3", Type::INT, -6},
+        {"1 << 4 | 3 & 1", Type::INT, 17},
+        {"0x0F ^ 0xFF", Type::INT, 0xF0},
+        {"~0", Type::INT, -1},
+        {"1 + 2 > 2 && 3 < 2 || true", Type::BOOL, 1},
+        {"not (1 = 1) or 2 <> 2", Type::BOOL, 0},
+        {"!0 == true", Type::BOOL, 1},
+        {"true & false | true", Type::BOOL, 1},
+        {"1 ? 2 : 3.5", Type::REAL, 2},
+        {"false ? 1 : true ? 2 : 3", Type::INT, 2},
+        {".5e1 + 1", Type::REAL, 6},
+        {"5 / 0", Type::INT, 0},
+        {"5.0 / 0", Type::REAL, 0},
+    };
+    for (const Case& c : cases) {
+        TEST_ASSERT_TRUE_MESSAGE(compile(c.source), c.source);
+        TEST_ASSERT_EQUAL_MESSAGE(static_cast<int>(c.type), static_cast<int>(expression->getType()), c.source);
+        // Literals only: folded into a single constant
+        TEST_ASSERT_EQUAL_MESSAGE(1, expression->getInstructionCount(), c.source);
+        PlcExprValue result = expression->evaluate(*memory);
+        float value = c.type == Type::REAL ? result.f : static_cast<float>(result.i);
+        TEST_ASSERT_EQUAL_FLOAT_MESSAGE(c.value, value, c.source);
+    }
+}
+
+void test_variables_are_bound_to_slots() {
+    memory->declareVariable("a", PlcValueType::INT);
+    memory->declareVariable("sp", PlcValueType::REAL);
+    TEST_ASSERT_TRUE(compile("(a*1.8 + 32) > sp && enable"));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcExpression::Type::BOOL), static_cast<int>(expression->getType()));
+
+    // Undeclared names are declared from their use
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::BOOL), static_cast<int>(memory->findHandle("enable").type));
+    TEST_ASSERT_TRUE(compile("(flags & 4) != 0 ? level * 2 : -1"));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::DINT), static_cast<int>(memory->findHandle("flags").type));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::REAL), static_cast<int>(memory->findHandle("level").type));
+
+    TEST_ASSERT_TRUE(compile("(a*1.8 + 32) > sp && enable"));
+    memory->setValue<int16_t>("a", 25);       // 77 F
+    memory->setValue<float>("sp", 76.5f);
+    memory->setValue<bool>("enable", true);
+    TEST_ASSERT_EQUAL_INT32(1, expression->evaluate(*memory).i);
+    memory->setValue<float>("sp", 77.5f);
+    TEST_ASSERT_EQUAL_INT32(0, expression->evaluate(*memory).i);
+    memory->setValue<float>("sp", 70.0f);
+    memory->setValue<bool>("enable", false);
+    TEST_ASSERT_EQUAL_INT32(0, expression->evaluate(*memory).i);
+
+    // Integer variables stay integers, a real operand widens the operation
+    memory->declareVariable("count", PlcValueType::DINT);
+    memory->setValue<int32_t>("count", 7);
+    TEST_ASSERT_TRUE(compile("count / 2 + count % 2"));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcExpression::Type::INT), static_cast<int>(expression->getType()));
+    TEST_ASSERT_EQUAL_INT32(4, expression->evaluate(*memory).i);
+    TEST_ASSERT_TRUE(compile("count / 2 + 2 * 0.25")); // count / 2 is still an integer division
+    TEST_ASSERT_EQUAL_FLOAT(3.5f, expression->evaluate(*memory).f);
+    TEST_ASSERT_TRUE(compile("count >> 1 << 3"));
+    TEST_ASSERT_EQUAL_INT32(24, expression->evaluate(*memory).i);
+}
+
+void test_functions() {
+    memory->setValue<float>("x", -12.5f);
+    memory->declareVariable("n", PlcValueType::DINT);
+    memory->setValue<int32_t>("n", -4);
+    const Case cases[] = {
+        {"min(3, x, 1)", PlcExpression::Type::REAL, -12.5f},
+        {"max(n, 2, -1, 7, 0)", PlcExpression::Type::INT, 7},
+        {"abs(x)", PlcExpression::Type::REAL, 12.5f},
+        {"ABS(n)", PlcExpression::Type::INT, 4},
+        {"sqrt(16)", PlcExpression::Type::REAL, 4},
+        {"sqrt(x)", PlcExpression::Type::REAL, 0}, // Like SQRT for negative inputs
+        {"limit(0, x, 10)", PlcExpression::Type::REAL, 0},
+        {"limit(-10, n * 5, 10)", PlcExpression::Type::INT, -10},
+        {"limit(-10, n, 10)", PlcExpression::Type::INT, -4},
+        {"n < 0 ? -n : n", PlcExpression::Type::INT, 4},
+    };
+    for (const Case& c : cases) {
+        TEST_ASSERT_TRUE_MESSAGE(compile(c.source), c.source);
+        TEST_ASSERT_EQUAL_MESSAGE(static_cast<int>(c.type), static_cast<int>(expression->getType()), c.source);
+        PlcExprValue result = expression->evaluate(*memory);
+        float value = c.type == PlcExpression::Type::REAL ? result.f : static_cast<float>(result.i);
+        TEST_ASSERT_EQUAL_FLOAT_MESSAGE(c.value, value, c.source);
+    }
+}
+
+void test_errors_report_their_position() {
+    memory->declareVariable("text", PlcValueType::STRING_TYPE);
+    struct ErrorCase {
+        const char* source;
+        size_t position;
+    };
+    const ErrorCase cases[] = {
+        {"", 0},
+        {"1 +", 3},
+        {"(a + b", 6},
+        {"a b", 2},
+        {"a $ b", 2},
+        {"foo(1)", 0},
+        {"min(1)", 0},
+        {"limit(1, 2)", 0},
+        {"c ? 1", 5},
+        {"x * 1.5 & 2", 8},
+        {"text + 1", 0},
+        {"12ab", 0},
+    };
+    for (const ErrorCase& c : cases) {
+        TEST_ASSERT_FALSE_MESSAGE(compile(c.source), c.source);
+        TEST_ASSERT_NOT_NULL(expression->getError());
+        TEST_ASSERT_EQUAL_MESSAGE(c.position, expression->getErrorPosition(), c.source);
+        TEST_ASSERT_TRUE(expression->isEmpty());
+    }
+
+    // Nesting is bounded, so a hostile expression cannot exhaust the stack
+    std::string deep(200, '(');
+    deep += "1";
+    deep += std::string(200, ')');
+    TEST_ASSERT_FALSE(compile(deep.c_str()));
+    std::string wide = "a";
+    for (int i = 0; i < 20; i++) {
+        wide = "a + (" + wide + ")";
+    }
+    TEST_ASSERT_FALSE(compile(wide.c_str()));
+    TEST_ASSERT_EQUAL_STRING("expression too complex", expression->getError());
+}
+
+static const char* CHAIN_PROGRAM = R"({
+    "memory": {"a": {"type": "int"}, "sp": {"type": "real"}, "enable": {"type": "bool"}},
+    "logic": [
+        {"block_type": "MUL", "inputs": ["a", "k_scale"], "outputs": {"out": "t1"}},
+        {"block_type": "ADD", "inputs": ["t1", "k_offset"], "outputs": {"out": "t2"}},
+        {"block_type": "GT", "inputs": {"in1": "t2", "in2": "sp"}, "outputs": {"out": "t3"}},
+        {"block_type": "AND", "inputs": ["t3", "enable"], "outputs": {"out": "alarm"}}
+    ],
+    "init": [
+        {"action": "set_value", "variable": "k_scale", "value": 1.8},
+        {"action": "set_value", "variable": "k_offset", "value": 32}
+    ]
+})";
+
+static const char* EXPR_PROGRAM = R"({
+    "memory": {"a": {"type": "int"}, "sp": {"type": "real"}, "enable": {"type": "bool"}},
+    "logic": [
+        {"block_type": "EXPR", "expression": "(a*1.8 + 32) > sp && enable", "outputs": {"out": "alarm"}}
+    ]
+})";
+
+static uint32_t rngState = 1;
+
+static uint32_t nextRandom() {
+    rngState = rngState * 1664525u + 1013904223u;
+    return rngState >> 8;
+}
+
+void test_block_matches_the_block_chain() {
+    PlcProgram chain("chain", nullptr, nullptr);
+    PlcProgram expr("expr", nullptr, nullptr);
+    TEST_ASSERT_TRUE(chain.loadConfiguration(CHAIN_PROGRAM));
+    TEST_ASSERT_TRUE(expr.loadConfiguration(EXPR_PROGRAM));
+    TEST_ASSERT_EQUAL(1, expr.getBlockCount());
+    TEST_ASSERT_EQUAL_STRING("EXPR", expr.getBlockType(0));
+    TEST_ASSERT_EQUAL(1, expr.getBytecode().getLoweredCount());
+    TEST_ASSERT_TRUE(expr.getMemory().getVariableCount() < chain.getMemory().getVariableCount());
+    chain.run();
+    expr.run();
+
+    for (int i = 0; i < 500; i++) {
+        int16_t a = static_cast<int16_t>(nextRandom() % 80) - 20;
+        float sp = static_cast<float>(nextRandom() % 2000) / 10.0f - 20.0f;
+        bool enable = nextRandom() % 4 != 0;
+        for (PlcProgram* program : {&chain, &expr}) {
+            program->getMemory().setValue<int16_t>("a", a);
+            program->getMemory().setValue<float>("sp", sp);
+            program->getMemory().setValue<bool>("enable", enable);
+            program->evaluate();
+        }
+        TEST_ASSERT_EQUAL(chain.getMemory().getValue<bool>("alarm"), expr.getMemory().getValue<bool>("alarm"));
+    }
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::BOOL),
+                      static_cast<int>(expr.getMemory().findHandle("alarm").type));
+
+    // A formula that does not compile fails the load
+    PlcProgram bad("bad", nullptr, nullptr);
+    TEST_ASSERT_FALSE(bad.loadConfiguration(R"({
+        "logic": [{"block_type": "EXPR", "expression": "a * (b + ", "outputs": {"out": "c"}}]
+    })"));
+}
+
+// The same formula as one EXPR block and as a chain of blocks, repeated
+static std::string makeRepeatedJson(int copies, bool useExpr, const char* engine) {
+    std::string json = "{\"engine\": \"";
+    json += engine;
+    json += "\", \"logic\": [";
+    char buffer[512];
+    for (int i = 0; i < copies; i++) {
+        if (useExpr) {
+            snprintf(buffer, sizeof(buffer),
+                     "%s{\"block_type\": \"EXPR\", \"expression\": \"(a%d*1.8 + 32) > sp && enable\", "
+                     "\"outputs\": {\"out\": \"alarm%d\"}}", i ? "," : "", i, i);
+        } else {
+            snprintf(buffer, sizeof(buffer),
+                     "%s{\"block_type\": \"MUL\", \"inputs\": [\"a%d\", \"k_scale\"], \"outputs\": {\"out\": \"t1_%d\"}},"
+                     "{\"block_type\": \"ADD\", \"inputs\": [\"t1_%d\", \"k_offset\"], \"outputs\": {\"out\": \"t2_%d\"}},"
+                     "{\"block_type\": \"GT\", \"inputs\": {\"in1\": \"t2_%d\", \"in2\": \"sp\"}, \"outputs\": {\"out\": \"t3_%d\"}},"
+                     "{\"block_type\": \"AND\", \"inputs\": [\"t3_%d\", \"enable\"], \"outputs\": {\"out\": \"alarm%d\"}}",
+                     i ? "," : "", i, i, i, i, i, i, i, i);
+        }
+        json += buffer;
+    }
+    json += "], \"init\": [{\"action\": \"set_value\", \"variable\": \"k_scale\", \"value\": 1.8},"
+            "{\"action\": \"set_value\", \"variable\": \"k_offset\", \"value\": 32},"
+            "{\"action\": \"set_value\", \"variable\": \"enable\", \"value\": true}]}";
+    return json;
+}
+
+void test_benchmark_expression_against_block_chain() {
+    const int copies = 50;
+    const int cycles = 2000;
+    for (const char* engine : {"blocks", "bytecode"}) {
+        unsigned long elapsed[2];
+        size_t configBytes[2];
+        for (int useExpr = 0; useExpr < 2; useExpr++) {
+            std::string json = makeRepeatedJson(copies, useExpr == 1, engine);
+            configBytes[useExpr] = json.size();
+            PlcProgram program("bench", nullptr, nullptr);
+            TEST_ASSERT_TRUE(program.loadConfiguration(json.c_str()));
+            TEST_ASSERT_EQUAL(useExpr ? copies : copies * 4, program.getBlockCount());
+            program.run();
+            unsigned long start = benchMicros();
+            for (int i = 0; i < cycles; i++) {
+                program.getMemory().setValue<float>("sp", static_cast<float>(i % 100));
+                program.evaluate();
+            }
+            elapsed[useExpr] = benchMicros() - start;
+            program.getMemory().setValue<float>("sp", 31.0f);
+            program.evaluate();
+            TEST_ASSERT_TRUE(program.getMemory().getValue<bool>("alarm0"));
+        }
+        printf("%-8s %d formulas x %d cycles: block chain %lu us (%u bytes of JSON), EXPR %lu us (%u bytes)\n",
+               engine, copies, cycles, elapsed[0], (unsigned)configBytes[0], elapsed[1], (unsigned)configBytes[1]);
+        TEST_ASSERT_TRUE(configBytes[1] * 2 < configBytes[0]);
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_precedence_and_literal_types);
+    RUN_TEST(test_variables_are_bound_to_slots);
+    RUN_TEST(test_functions);
+    RUN_TEST(test_errors_report_their_position);
+    RUN_TEST(test_block_matches_the_block_chain);
+    RUN_TEST(test_benchmark_expression_against_block_chain);
+    UNITY_END();
+    return 0;
+}
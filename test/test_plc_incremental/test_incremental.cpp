@@ -0,0 +1,242 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include <cstdint>
+
+/**
+ * @brief Data-flow ordering and incremental execution tests
+ *
+ * Programs are loaded from JSON the same way PlcEngine does. Incremental
+ * programs are compared with the same program in cyclic mode.
+ */
+
+// Blocks are listed against the data flow on purpose:
+// sum = a + b, high = sum > limit, alarm = high AND enable, count += alarm edges
+static const char* PROCESS_LOGIC = R"JSON(
+    "memory": {
+        "a": {"type": "real"},
+        "b": {"type": "real"},
+        "limit": {"type": "real"},
+        "enable": {"type": "bool"},
+        "sum": {"type": "real"},
+        "high": {"type": "bool"},
+        "alarm": {"type": "bool"},
+        "count": {"type": "int"},
+        "preset": {"type": "int"},
+        "other_in": {"type": "bool"},
+        "other_out": {"type": "bool"}
+    },
+    "logic": [
+        {"block_type": "CTU", "inputs": {"cu": "alarm", "reset": "reset", "pv": "preset"}, "outputs": {"q": "count_done", "cv": "count"}},
+        {"block_type": "AND", "inputs": ["high", "enable"], "outputs": {"out": "alarm"}},
+        {"block_type": "GT", "inputs": {"in1": "sum", "in2": "limit"}, "outputs": {"out": "high"}},
+        {"block_type": "ADD", "inputs": ["a", "b"], "outputs": {"out": "sum"}},
+        {"block_type": "NOT", "inputs": {"in": "other_in"}, "outputs": {"out": "other_out"}}
+    ],
+    "init": [
+        {"action": "set_value", "variable": "preset", "value": 1000}
+    ]
+)JSON";
+
+static String makeConfig(const char* execution, const char* engine) {
+    String json = "{\"execution\": \"";
+    json += execution;
+    json += "\", \"engine\": \"";
+    json += engine;
+    json += "\", ";
+    json += PROCESS_LOGIC;
+    json += "}";
+    return json;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_blocks_run_in_data_flow_order() {
+    PlcProgram program("order", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(makeConfig("cyclic", "blocks").c_str()));
+    program.run();
+
+    PlcMemory& mem = program.getMemory();
+    mem.setValue<float>("a", 7.0f);
+    mem.setValue<float>("b", 5.0f);
+    mem.setValue<float>("limit", 10.0f);
+    mem.setValue<bool>("enable", true);
+
+    // A single scan reaches the end of the chain despite the JSON order
+    program.evaluate();
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 12.0f, mem.getValue<float>("sum", 0.0f));
+    TEST_ASSERT_TRUE(mem.getValue<bool>("high", false));
+    TEST_ASSERT_TRUE(mem.getValue<bool>("alarm", false));
+    TEST_ASSERT_EQUAL(1, mem.getValue<int16_t>("count", 0));
+}
+
+void test_algebraic_loop_is_accepted() {
+    const char* json = R"JSON({
+        "engine": "blocks",
+        "logic": [
+            {"block_type": "AND", "inputs": ["x", "y"], "outputs": {"out": "z"}},
+            {"block_type": "OR", "inputs": ["z", "start"], "outputs": {"out": "y"}},
+            {"block_type": "NOT", "inputs": {"in": "y"}, "outputs": {"out": "not_y"}}
+        ]
+    })JSON";
+
+    PlcProgram program("loop", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(json));
+    program.run();
+
+    PlcMemory& mem = program.getMemory();
+    mem.setValue<bool>("x", true);
+    mem.setValue<bool>("start", true);
+
+    // AND is first in configuration order and is where the loop is broken,
+    // so it sees y from the previous scan
+    program.evaluate();
+    TEST_ASSERT_FALSE(mem.getValue<bool>("z", true));
+    TEST_ASSERT_TRUE(mem.getValue<bool>("y", false));
+    TEST_ASSERT_FALSE(mem.getValue<bool>("not_y", true));
+
+    program.evaluate();
+    TEST_ASSERT_TRUE(mem.getValue<bool>("z", false));
+}
+
+void test_incremental_skips_idle_blocks() {
+    PlcProgram program("idle", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(makeConfig("incremental", "bytecode").c_str()));
+    TEST_ASSERT_TRUE(program.getExecutionMode() == PlcExecutionMode::INCREMENTAL);
+    program.run();
+
+    PlcMemory& mem = program.getMemory();
+    mem.setValue<float>("limit", 10.0f);
+    mem.setValue<bool>("enable", true);
+
+    program.evaluate();
+    TEST_ASSERT_EQUAL(5, program.getLastEvaluatedBlockCount()); // First scan runs everything
+
+    program.evaluate();
+    TEST_ASSERT_EQUAL(0, program.getLastEvaluatedBlockCount());
+
+    // Writing the same value is not a change
+    mem.setValue<float>("limit", 10.0f);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(0, program.getLastEvaluatedBlockCount());
+
+    // ADD changes sum, GT output stays false, so AND and CTU are skipped
+    mem.setValue<float>("a", 3.0f);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(2, program.getLastEvaluatedBlockCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 3.0f, mem.getValue<float>("sum", 0.0f));
+
+    // Crossing the limit propagates to the end of the chain in one scan
+    mem.setValue<float>("b", 8.0f);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(4, program.getLastEvaluatedBlockCount());
+    TEST_ASSERT_TRUE(mem.getValue<bool>("alarm", false));
+    TEST_ASSERT_EQUAL(1, mem.getValue<int16_t>("count", 0));
+
+    // Unrelated input only wakes its own block
+    mem.setValue<bool>("other_in", true);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(1, program.getLastEvaluatedBlockCount());
+    TEST_ASSERT_FALSE(mem.getValue<bool>("other_out", true));
+}
+
+void test_timers_wake_on_expiry() {
+    const char* json = R"JSON({
+        "execution": "incremental",
+        "logic": [
+            {"block_type": "TON", "inputs": {"in": "start", "pt": 1000}, "outputs": {"q": "done"}},
+            {"block_type": "NOT", "inputs": {"in": "done"}, "outputs": {"out": "waiting"}}
+        ]
+    })JSON";
+
+    PlcProgram program("live", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(json));
+    program.run();
+    PlcMemory& mem = program.getMemory();
+
+    program.advanceTimers(0);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(2, program.getLastEvaluatedBlockCount());
+
+    // The input starts the timer; while it runs, nothing is evaluated
+    mem.setValue<bool>("start", true);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(1, program.getLastEvaluatedBlockCount());
+    program.advanceTimers(500000);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(0, program.getLastEvaluatedBlockCount());
+
+    // The expiry wakes the timer at the start of the scan, its output the NOT
+    program.advanceTimers(1000000);
+    program.evaluate();
+    TEST_ASSERT_EQUAL(2, program.getLastEvaluatedBlockCount());
+    TEST_ASSERT_TRUE(mem.getValue<bool>("done", false));
+    TEST_ASSERT_FALSE(mem.getValue<bool>("waiting", true));
+}
+
+void test_incremental_matches_cyclic() {
+    PlcProgram cyclic("cyclic", nullptr, nullptr);
+    PlcProgram incremental("incremental", nullptr, nullptr);
+    TEST_ASSERT_TRUE(cyclic.loadConfiguration(makeConfig("cyclic", "blocks").c_str()));
+    TEST_ASSERT_TRUE(incremental.loadConfiguration(makeConfig("incremental", "blocks").c_str()));
+    cyclic.run();
+    incremental.run();
+
+    const char* outputs[] = {"sum", "high", "alarm", "count", "other_out"};
+    uint32_t seed = 12345;
+    size_t evaluatedTotal = 0;
+
+    for (int step = 0; step < 300; step++) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t r = seed >> 8;
+
+        // Mostly idle: change one input every few scans
+        if ((r & 0x3) == 0) {
+            float a = (float)((r >> 2) % 10);
+            float b = (float)((r >> 6) % 10);
+            bool enable = (r >> 10) & 1;
+            bool other = (r >> 11) & 1;
+            PlcProgram* programs[] = {&cyclic, &incremental};
+            for (PlcProgram* p : programs) {
+                p->getMemory().setValue<float>("a", a);
+                p->getMemory().setValue<float>("b", b);
+                p->getMemory().setValue<float>("limit", 9.0f);
+                p->getMemory().setValue<bool>("enable", enable);
+                p->getMemory().setValue<bool>("other_in", other);
+            }
+        }
+
+        cyclic.evaluate();
+        incremental.evaluate();
+        evaluatedTotal += incremental.getLastEvaluatedBlockCount();
+
+        for (const char* name : outputs) {
+            float expected = cyclic.getMemory().getValue<float>(name, 0.0f);
+            float actual = incremental.getMemory().getValue<float>(name, 0.0f);
+            TEST_ASSERT_EQUAL_FLOAT_MESSAGE(expected, actual, name);
+        }
+    }
+
+    // The idle scans must have been skipped
+    TEST_ASSERT_TRUE(evaluatedTotal < 300 * 5 / 2);
+}
+
+void test_unknown_execution_mode_is_rejected() {
+    PlcProgram program("bad", nullptr, nullptr);
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"JSON({"execution": "sometimes", "logic": []})JSON"));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_blocks_run_in_data_flow_order);
+    RUN_TEST(test_algebraic_loop_is_accepted);
+    RUN_TEST(test_incremental_skips_idle_blocks);
+    RUN_TEST(test_timers_wake_on_expiry);
+    RUN_TEST(test_incremental_matches_cyclic);
+    RUN_TEST(test_unknown_execution_mode_is_rejected);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Multi-core scheduling tests
+ *
+ * Programs are spread over the engine's workers, std::threads on the host.
+ * Programs that share a mesh variable or a partition stay on one worker,
+ * "core" pins a program, and every worker finishes a cycle before the
+ * next one starts, so the results are the same as with a single worker.
+ */
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+// "acc" counts the cycles; `load` more ADD blocks give the program weight
+static std::string makeProgram(int load, const char* settings = "", const char* meshLink = nullptr) {
+    std::string json = "{\"memory\": {\"acc\": {\"type\": \"real\"}, \"one\": {\"type\": \"real\"}";
+    char buf[160];
+    if (meshLink) {
+        snprintf(buf, sizeof(buf), ", \"shared\": {\"type\": \"real\", \"mesh_link\": \"%s\"}", meshLink);
+        json += buf;
+    }
+    json += "}, \"logic\": [{\"block_type\": \"ADD\", \"inputs\": [\"acc\", \"one\"], \"outputs\": {\"out\": \"acc\"}}";
+    for (int i = 1; i <= load; i++) {
+        snprintf(buf, sizeof(buf), ", {\"block_type\": \"ADD\", \"inputs\": [\"w%d\", \"one\"], \"outputs\": {\"out\": \"w%d\"}}",
+                 i - 1, i);
+        json += buf;
+    }
+    json += "], \"init\": [{\"action\": \"set_value\", \"variable\": \"one\", \"value\": 1.0}], \"cycle_time_ms\": 10";
+    json += settings;
+    return json + "}";
+}
+
+static void createEngine(uint8_t workers) {
+    delete engine;
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+    engine->setWorkerCount(workers);
+}
+
+void setUp(void) {
+    clock_ = new ManualPlcClock();
+    createEngine(2);
+}
+
+void tearDown(void) {
+    delete engine;
+    delete clock_;
+    engine = nullptr;
+}
+
+static void load(const char* name, const std::string& json) {
+    TEST_ASSERT_TRUE(engine->loadProgram(name, json.c_str()));
+}
+
+static void runAll() {
+    for (const String& name : engine->getProgramNames()) {
+        engine->runProgram(name);
+    }
+}
+
+// One pass of the PLC task
+static void step() {
+    clock_->sleepUntil(engine->runDueCycles());
+}
+
+static uint8_t workerOf(const char* name) {
+    return engine->getProgram(name)->getWorker();
+}
+
+static float acc(const char* name) {
+    return engine->getProgram(name)->getMemory().getValue<float>("acc");
+}
+
+void test_programs_sharing_a_mesh_variable_share_a_worker() {
+    load("a", makeProgram(20, "", "node7.temp"));
+    load("b", makeProgram(20, "", "node7.temp"));
+    load("c", makeProgram(20));
+    load("d", makeProgram(20));
+    runAll();
+    step();
+
+    TEST_ASSERT_EQUAL(2, engine->getWorkerCount());
+    TEST_ASSERT_EQUAL(workerOf("a"), workerOf("b"));
+    TEST_ASSERT_TRUE(workerOf("a") != workerOf("c")); // Same load as a and b together
+    TEST_ASSERT_EQUAL(workerOf("c"), workerOf("d"));
+
+    JsonDocument doc;
+    engine->getWorkersJson(doc.to<JsonObject>());
+    TEST_ASSERT_TRUE(doc["parallel"].as<bool>());
+    TEST_ASSERT_EQUAL(2, doc["worker"].size());
+    TEST_ASSERT_EQUAL(2, doc["worker"][0]["programs"].size());
+    TEST_ASSERT_EQUAL(1, doc["worker"][1]["cycles"].as<int>());
+}
+
+void test_core_and_partition_settings() {
+    load("p1", makeProgram(5, ", \"partition\": 3"));
+    load("p2", makeProgram(50, ", \"partition\": 3"));
+    load("pinned", makeProgram(100, ", \"core\": 1"));
+    load("first", makeProgram(100, ", \"core\": 0"));
+    runAll();
+    step();
+
+    TEST_ASSERT_EQUAL(1, workerOf("pinned"));
+    TEST_ASSERT_EQUAL(0, workerOf("first"));
+    TEST_ASSERT_EQUAL(workerOf("p1"), workerOf("p2"));
+    TEST_ASSERT_EQUAL(PlcProgramImage::CORE_ANY, engine->getProgram("p1")->getCore());
+    TEST_ASSERT_EQUAL(3, engine->getProgram("p1")->getPartition());
+
+    // Out of range settings are rejected
+    TEST_ASSERT_FALSE(engine->loadProgram("bad_core", makeProgram(1, ", \"core\": 15").c_str()));
+    TEST_ASSERT_FALSE(engine->loadProgram("bad_partition", makeProgram(1, ", \"partition\": 16").c_str()));
+
+    // A single worker scans everything, pinned or not
+    createEngine(1);
+    load("pinned", makeProgram(1, ", \"core\": 1"));
+    load("other", makeProgram(1));
+    runAll();
+    step();
+    TEST_ASSERT_EQUAL(0, workerOf("pinned"));
+    TEST_ASSERT_EQUAL(1, acc("pinned"));
+    TEST_ASSERT_EQUAL(1, acc("other"));
+}
+
+void test_placement_is_part_of_the_image() {
+    std::vector<uint8_t> image;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(makeProgram(1, ", \"core\": 1, \"partition\": 5").c_str(), "img", image));
+    TEST_ASSERT_EQUAL(0x52, image[27]);
+    TEST_ASSERT_TRUE(engine->loadProgramImage("img", image.data(), image.size()));
+    TEST_ASSERT_EQUAL(1, engine->getProgram("img")->getCore());
+    TEST_ASSERT_EQUAL(5, engine->getProgram("img")->getPartition());
+
+    // Images without placement (the byte was reserved) run anywhere
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(makeProgram(1).c_str(), "plain", image));
+    TEST_ASSERT_EQUAL(0, image[27]);
+    TEST_ASSERT_TRUE(engine->loadProgramImage("plain", image.data(), image.size()));
+    TEST_ASSERT_EQUAL(PlcProgramImage::CORE_ANY, engine->getProgram("plain")->getCore());
+    TEST_ASSERT_EQUAL(0, engine->getProgram("plain")->getPartition());
+}
+
+void test_parallel_cycles_match_a_single_worker() {
+    const char* names[] = {"a", "b", "c", "d", "e"};
+    float results[2][5];
+    uint32_t cycles[2][5];
+    for (int run = 0; run < 2; run++) {
+        clock_->setTime(0);
+        createEngine(run == 0 ? 1 : 2);
+        for (int i = 0; i < 5; i++) {
+            load(names[i], makeProgram(10 * (i + 1), "", i < 2 ? "node1.level" : nullptr));
+        }
+        runAll();
+        for (int i = 0; i < 500; i++) {
+            step();
+        }
+        for (int i = 0; i < 5; i++) {
+            results[run][i] = acc(names[i]);
+            cycles[run][i] = engine->getProgram(names[i])->getCycleTimer().getStats().cycles;
+        }
+    }
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(results[0][i], results[1][i]);
+        TEST_ASSERT_EQUAL_UINT32(cycles[0][i], cycles[1][i]);
+        TEST_ASSERT_EQUAL_FLOAT(500.0f, results[1][i]);
+    }
+}
+
+void test_online_change_between_parallel_cycles() {
+    load("a", makeProgram(30));
+    load("b", makeProgram(30));
+    runAll();
+    for (int i = 0; i < 10; i++) {
+        step();
+    }
+    TEST_ASSERT_TRUE(workerOf("a") != workerOf("b"));
+
+    // New versions linked to one mesh variable: once both are, they share a worker
+    TEST_ASSERT_TRUE(engine->onlineChange("b", makeProgram(30, "", "node2.flow").c_str()));
+    step();
+    TEST_ASSERT_FALSE(engine->isOnlineChangePending());
+    TEST_ASSERT_EQUAL(11, acc("b")); // Value carried over and scanned once more
+    engine->onlineChange("a", makeProgram(30, "", "node2.flow").c_str());
+    step();
+    TEST_ASSERT_EQUAL(workerOf("a"), workerOf("b"));
+    TEST_ASSERT_EQUAL(12, acc("a"));
+    TEST_ASSERT_EQUAL(12, acc("b"));
+
+    // Stopping every program stops the workers
+    engine->stopProgram("a");
+    engine->stopProgram("b");
+    TEST_ASSERT_EQUAL(1, engine->getWorkerCount());
+}
+
+// Wall time of `cycles` passes of the PLC task over four independent programs
+static double benchmark(uint8_t workers, int blocks, int cycles) {
+    clock_->setTime(0);
+    createEngine(workers);
+    const char* names[] = {"a", "b", "c", "d"};
+    for (const char* name : names) {
+        load(name, makeProgram(blocks));
+    }
+    runAll();
+    step(); // Workers assigned
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < cycles; i++) {
+        step();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The programs are split evenly and every worker scanned its share each cycle
+    for (const char* name : names) {
+        TEST_ASSERT_EQUAL(cycles + 1, acc(name));
+    }
+    JsonDocument doc;
+    engine->getWorkersJson(doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL(workers, doc["worker"].size());
+    TEST_ASSERT_EQUAL(workers > 1, doc["parallel"].as<bool>());
+    for (uint8_t w = 0; w < workers; w++) {
+        TEST_ASSERT_EQUAL(4 / workers, doc["worker"][w]["programs"].size());
+        TEST_ASSERT_EQUAL(cycles + 1, doc["worker"][w]["cycles"].as<int>());
+    }
+    return seconds;
+}
+
+void test_scaling_benchmark() {
+    const int blocks = 2000;
+    const int cycles = 500;
+    double single = benchmark(1, blocks, cycles);
+    double dual = benchmark(2, blocks, cycles);
+    // Wall time depends on the host's load and core count, so it is only printed
+    printf("4 programs x %d blocks, %d cycles: 1 worker %.1f ms, 2 workers %.1f ms (%.2fx), %u hardware threads\n",
+           blocks + 1, cycles, single * 1000, dual * 1000, single / dual, std::thread::hardware_concurrency());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_programs_sharing_a_mesh_variable_share_a_worker);
+    RUN_TEST(test_core_and_partition_settings);
+    RUN_TEST(test_placement_is_part_of_the_image);
+    RUN_TEST(test_parallel_cycles_match_a_single_worker);
+    RUN_TEST(test_online_change_between_parallel_cycles);
+    RUN_TEST(test_scaling_benchmark);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+#include <string>
+
+/**
+ * @brief Online change tests
+ *
+ * A new version of a running program is loaded next to it and swapped in
+ * at the next cycle boundary. Variables keep their values and blocks with
+ * the same id keep their state (counter edge, latch, sequencer step).
+ */
+
+static const char* VERSION_1 = R"({
+    "memory": {
+        "pulse": {"type": "bool"}, "reset": {"type": "bool"}, "pv": {"type": "int"}, "cv": {"type": "int"},
+        "set": {"type": "bool"}, "latched": {"type": "bool"},
+        "go": {"type": "bool"}, "back": {"type": "bool"}, "stepval": {"type": "int"}
+    },
+    "logic": [
+        {"id": "count", "block_type": "CTU", "inputs": {"cu": "pulse", "reset": "reset", "pv": "pv"}, "outputs": {"q": "done", "cv": "cv"}},
+        {"id": "latch", "block_type": "SR", "inputs": {"set": "set", "reset": "reset"}, "outputs": {"out": "latched"}},
+        {"id": "seq", "block_type": "SEQUENCER", "steps": [
+            {"actions": [{"action": "set_value", "variable": "stepval", "value": 1}], "transition_condition": "go"},
+            {"actions": [{"action": "set_value", "variable": "stepval", "value": 2}], "transition_condition": "back"}
+        ]}
+    ],
+    "cycle_time_ms": 10
+})";
+
+// Blocks reordered, the latch removed, an ADD and a variable with an init value added
+static const char* VERSION_2 = R"({
+    "memory": {
+        "pulse": {"type": "bool"}, "reset": {"type": "bool"}, "pv": {"type": "int"}, "cv": {"type": "int"},
+        "go": {"type": "bool"}, "back": {"type": "bool"}, "stepval": {"type": "int"},
+        "gain": {"type": "real"}, "scaled": {"type": "real"}
+    },
+    "logic": [
+        {"id": "seq", "block_type": "SEQUENCER", "steps": [
+            {"actions": [{"action": "set_value", "variable": "stepval", "value": 1}], "transition_condition": "go"},
+            {"actions": [{"action": "set_value", "variable": "stepval", "value": 2}], "transition_condition": "back"}
+        ]},
+        {"id": "scale", "block_type": "ADD", "inputs": ["gain", "gain"], "outputs": {"out": "scaled"}},
+        {"id": "count", "block_type": "CTU", "inputs": {"cu": "pulse", "reset": "reset", "pv": "pv"}, "outputs": {"q": "done", "cv": "cv"}}
+    ],
+    "init": [{"action": "set_value", "variable": "gain", "value": 2.5}],
+    "cycle_time_ms": 10
+})";
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+void setUp(void) {
+    clock_ = new ManualPlcClock();
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+}
+
+void tearDown(void) {
+    delete engine;
+    delete clock_;
+}
+
+static PlcMemory& memory() {
+    return engine->getProgram("main")->getMemory();
+}
+
+// One pass of the PLC task
+static void step() {
+    clock_->sleepUntil(engine->runDueCycles());
+}
+
+static void startVersion1() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", VERSION_1));
+    memory().setValue<int16_t>("pv", 10);
+    engine->runProgram("main");
+
+    // Counter at 1 with CU held, latch set, sequencer in its second step
+    memory().setValue<bool>("pulse", true);
+    memory().setValue<bool>("set", true);
+    memory().setValue<bool>("go", true);
+    step();
+    memory().setValue<bool>("set", false);
+    memory().setValue<bool>("go", false);
+    step();
+    TEST_ASSERT_EQUAL_INT16(1, memory().getValue<int16_t>("cv"));
+    TEST_ASSERT_TRUE(memory().getValue<bool>("latched"));
+    TEST_ASSERT_EQUAL_INT16(2, memory().getValue<int16_t>("stepval"));
+}
+
+void test_values_and_block_state_carry_over() {
+    startVersion1();
+    PlcProgram* previous = engine->getProgram("main");
+
+    TEST_ASSERT_TRUE(engine->onlineChange("main", VERSION_2));
+    TEST_ASSERT_TRUE(engine->isOnlineChangePending());
+    TEST_ASSERT_EQUAL_PTR(previous, engine->getProgram("main")); // Swapped at the cycle boundary, not before
+
+    step();
+    TEST_ASSERT_FALSE(engine->isOnlineChangePending());
+    PlcProgram* current = engine->getProgram("main");
+    TEST_ASSERT_TRUE(current != previous);
+    TEST_ASSERT_EQUAL(PlcProgramState::RUNNING, current->getState());
+    TEST_ASSERT_EQUAL_STRING("count", current->getBlockId(current->getBlockCount() - 1));
+
+    // CU is still held: no new edge, so the count stays at 1
+    TEST_ASSERT_EQUAL_INT16(1, memory().getValue<int16_t>("cv"));
+    TEST_ASSERT_EQUAL_INT16(10, memory().getValue<int16_t>("pv"));
+    // The sequencer continues in its second step
+    TEST_ASSERT_EQUAL_INT16(2, memory().getValue<int16_t>("stepval"));
+    // New variables start from their init value
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, memory().getValue<float>("scaled"));
+
+    const PlcOnlineChange& change = engine->getLastOnlineChange();
+    TEST_ASSERT_EQUAL(8, change.carriedVariables); // Including "done", declared by the CTU
+    TEST_ASSERT_EQUAL(2, change.migratedBlocks);
+    TEST_ASSERT_EQUAL(1, change.newBlocks);
+    TEST_ASSERT_EQUAL(1, change.droppedBlocks);
+
+    // A new edge counts on from the carried value
+    memory().setValue<bool>("pulse", false);
+    step();
+    memory().setValue<bool>("pulse", true);
+    step();
+    TEST_ASSERT_EQUAL_INT16(2, memory().getValue<int16_t>("cv"));
+}
+
+void test_blocks_without_id_match_by_type_and_position() {
+    const char* v1 = R"({"logic": [
+        {"block_type": "CTU", "inputs": {"cu": "a", "pv": "pv"}, "outputs": {"cv": "ca"}},
+        {"block_type": "CTU", "inputs": {"cu": "b", "pv": "pv"}, "outputs": {"cv": "cb"}}
+    ]})";
+    const char* v2 = R"({"logic": [
+        {"block_type": "NOT", "inputs": {"in": "a"}, "outputs": {"out": "na"}},
+        {"block_type": "CTU", "inputs": {"cu": "a", "pv": "pv"}, "outputs": {"cv": "ca"}},
+        {"block_type": "CTU", "inputs": {"cu": "b", "pv": "pv"}, "outputs": {"cv": "cb"}}
+    ]})";
+    TEST_ASSERT_TRUE(engine->loadProgram("main", v1));
+    memory().setValue<int16_t>("pv", 10);
+    memory().setValue<bool>("a", true);
+    engine->runProgram("main");
+    step();
+    TEST_ASSERT_EQUAL_INT16(1, memory().getValue<int16_t>("ca"));
+
+    TEST_ASSERT_TRUE(engine->onlineChange("main", v2));
+    step();
+    TEST_ASSERT_EQUAL(2, engine->getLastOnlineChange().migratedBlocks);
+    TEST_ASSERT_EQUAL(1, engine->getLastOnlineChange().newBlocks);
+    TEST_ASSERT_EQUAL_INT16(1, memory().getValue<int16_t>("ca")); // First CTU kept its edge memory
+    TEST_ASSERT_EQUAL_INT16(0, memory().getValue<int16_t>("cb"));
+}
+
+void test_failed_change_keeps_the_running_version() {
+    startVersion1();
+    PlcProgram* previous = engine->getProgram("main");
+
+    TEST_ASSERT_FALSE(engine->onlineChange("main", R"({"logic": [{"block_type": "NOPE"}]})"));
+    TEST_ASSERT_FALSE(engine->onlineChange("other", VERSION_2));
+    TEST_ASSERT_FALSE(engine->isOnlineChangePending());
+    step();
+    TEST_ASSERT_EQUAL_PTR(previous, engine->getProgram("main"));
+    TEST_ASSERT_EQUAL_INT16(1, memory().getValue<int16_t>("cv"));
+
+    // One change at a time
+    TEST_ASSERT_TRUE(engine->onlineChange("main", VERSION_2));
+    TEST_ASSERT_FALSE(engine->onlineChange("main", VERSION_1));
+    step();
+    TEST_ASSERT_TRUE(engine->onlineChange("main", VERSION_1));
+    step();
+    TEST_ASSERT_EQUAL(2, engine->getLastOnlineChange().migratedBlocks);
+    TEST_ASSERT_EQUAL(1, engine->getLastOnlineChange().newBlocks); // The latch is back
+}
+
+void test_stopped_engine_swaps_immediately() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", VERSION_1));
+    memory().setValue<int16_t>("cv", 4);
+    TEST_ASSERT_TRUE(engine->onlineChange("main", VERSION_2));
+    TEST_ASSERT_FALSE(engine->isOnlineChangePending());
+    TEST_ASSERT_EQUAL(PlcProgramState::STOPPED, engine->getProgram("main")->getState());
+    TEST_ASSERT_EQUAL_INT16(4, memory().getValue<int16_t>("cv"));
+}
+
+void test_swap_fits_in_one_cycle() {
+    // 400 blocks with ids, on the real clock
+    std::string json = "{\"logic\": [";
+    char buf[160];
+    for (int i = 0; i < 400; i++) {
+        snprintf(buf, sizeof(buf), "%s{\"id\": \"b%d\", \"block_type\": \"CTU\", \"inputs\": {\"cu\": \"in%d\", \"pv\": \"pv\"}, \"outputs\": {\"cv\": \"cv%d\"}}",
+                 i ? ", " : "", i, i, i);
+        json += buf;
+    }
+    json += "], \"cycle_time_ms\": 10}";
+
+    engine->setClock(nullptr);
+    TEST_ASSERT_TRUE(engine->loadProgram("main", json.c_str()));
+    engine->runProgram("main");
+    engine->runDueCycles();
+    TEST_ASSERT_TRUE(engine->onlineChange("main", json.c_str()));
+    engine->runDueCycles();
+
+    const PlcOnlineChange& change = engine->getLastOnlineChange();
+    printf("Swap of 400 blocks, %u variables: %u us\n", change.carriedVariables, (unsigned)change.swapLatencyUs);
+    TEST_ASSERT_EQUAL(400, change.migratedBlocks);
+    TEST_ASSERT_EQUAL(801, change.carriedVariables);
+    TEST_ASSERT_TRUE(change.swapLatencyUs < 10000);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_values_and_block_state_carry_over);
+    RUN_TEST(test_blocks_without_id_match_by_type_and_position);
+    RUN_TEST(test_failed_change_keeps_the_running_version);
+    RUN_TEST(test_stopped_engine_swaps_immediately);
+    RUN_TEST(test_swap_fits_in_one_cycle);
+    UNITY_END();
+    return 0;
+}
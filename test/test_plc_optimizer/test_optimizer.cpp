@@ -0,0 +1,277 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include <string>
+
+/**
+ * @brief Load-time optimizer tests ("optimize": true)
+ *
+ * Programs are loaded from JSON with and without the optimizer and must
+ * give the same values in the variables that are observed: the "memory"
+ * section, the "io_points" and qualified names such as DO.Lamp.
+ */
+
+// a -> NOT -> mid -> NOT -> out is observed. scratch and the loop between
+// loop_a and loop_b are read by nobody; lamp and DO.Lamp are IO points.
+static const char* DEAD_LOGIC = R"JSON(
+    "memory": {
+        "a": {"type": "bool"},
+        "out": {"type": "bool"}
+    },
+    "io_points": [
+        {"plc_var": "lamp", "endpoint": "hall.light.state.bool", "direction": "output"}
+    ],
+    "logic": [
+        {"block_type": "NOT", "inputs": {"in": "a"}, "outputs": {"out": "mid"}},
+        {"block_type": "NOT", "inputs": {"in": "mid"}, "outputs": {"out": "out"}},
+        {"block_type": "AND", "inputs": ["a", "mid"], "outputs": {"out": "scratch"}},
+        {"block_type": "OR", "inputs": ["scratch", "a"], "outputs": {"out": "scratch2"}},
+        {"block_type": "AND", "inputs": ["a", "loop_b"], "outputs": {"out": "loop_a"}},
+        {"block_type": "OR", "inputs": ["loop_a", "a"], "outputs": {"out": "loop_b"}},
+        {"block_type": "NOT", "inputs": {"in": "a"}, "outputs": {"out": "lamp"}},
+        {"block_type": "NOT", "inputs": {"in": "mid"}, "outputs": {"out": "DO.Lamp"}}
+    ]
+)JSON";
+
+static std::string makeConfig(const char* logic, bool optimize, const char* engine = "bytecode") {
+    std::string json = "{\"engine\": \"";
+    json += engine;
+    json += "\", \"optimize\": ";
+    json += optimize ? "true" : "false";
+    json += ", ";
+    json += logic;
+    json += "}";
+    return json;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_unobserved_blocks_are_removed() {
+    PlcProgram plain("plain", nullptr, nullptr);
+    PlcProgram optimized("optimized", nullptr, nullptr);
+    TEST_ASSERT_TRUE(plain.loadConfiguration(makeConfig(DEAD_LOGIC, false).c_str()));
+    TEST_ASSERT_TRUE(optimized.loadConfiguration(makeConfig(DEAD_LOGIC, true).c_str()));
+
+    TEST_ASSERT_EQUAL(0, plain.getOptimization().getRemovedBlocks());
+    TEST_ASSERT_EQUAL(8, plain.getBlockCount());
+    TEST_ASSERT_EQUAL(4, optimized.getOptimization().deadBlocks);
+    TEST_ASSERT_EQUAL(4, optimized.getOptimization().getRemovedBlocks());
+    TEST_ASSERT_EQUAL(4, optimized.getBlockCount());
+    TEST_ASSERT_EQUAL(plain.getBytecode().getInstructionCount() - 4, optimized.getBytecode().getInstructionCount());
+
+    // The blocks left keep their configuration index
+    for (size_t i = 0; i < optimized.getBlockCount(); i++) {
+        uint16_t index = optimized.getBlockConfigIndex(i);
+        TEST_ASSERT_TRUE(index < 2 || index > 5);
+    }
+
+    plain.run();
+    optimized.run();
+    for (int scan = 0; scan < 4; scan++) {
+        bool a = scan % 2 == 0;
+        plain.getMemory().setValue<bool>("a", a);
+        optimized.getMemory().setValue<bool>("a", a);
+        plain.evaluate();
+        optimized.evaluate();
+        const char* observed[] = {"out", "lamp", "DO.Lamp"};
+        for (const char* name : observed) {
+            TEST_ASSERT_EQUAL_MESSAGE(plain.getMemory().getValue<bool>(name), optimized.getMemory().getValue<bool>(name), name);
+        }
+        TEST_ASSERT_EQUAL(a, optimized.getMemory().getValue<bool>("out"));
+        TEST_ASSERT_FALSE(optimized.getMemory().getValue<bool>("scratch2"));
+    }
+}
+
+// Benchmark format: "#" constants only set by INIT. The ADD chain folds to
+// total = 3; the CTU keeps its edge memory and stays.
+static const char* CONSTANT_LOGIC = R"JSON(
+    "memory": {
+        "total": {"type": "real"},
+        "x": {"type": "real"},
+        "shifted": {"type": "real"},
+        "count": {"type": "int"}
+    },
+    "blocks": [
+        {"type": "ADD", "inputs": {"IN1": {"type": "const", "value": 0}, "IN2": {"type": "const", "value": 1}}, "outputs": {"OUT": "r0"}},
+        {"type": "ADD", "inputs": {"IN1": {"type": "var", "value": "r0"}, "IN2": {"type": "const", "value": 1}}, "outputs": {"OUT": "r1"}},
+        {"type": "ADD", "inputs": {"IN1": {"type": "var", "value": "r1"}, "IN2": {"type": "const", "value": 1}}, "outputs": {"OUT": "total"}},
+        {"type": "ADD", "inputs": {"IN1": {"type": "var", "value": "x"}, "IN2": {"type": "var", "value": "r1"}}, "outputs": {"OUT": "shifted"}},
+        {"type": "CTU", "inputs": {"CU": {"type": "const", "value": true}, "PV": {"type": "const", "value": 5}}, "outputs": {"CV": "count"}}
+    ]
+)JSON";
+
+void test_constant_blocks_are_folded() {
+    PlcProgram plain("plain", nullptr, nullptr);
+    PlcProgram optimized("optimized", nullptr, nullptr);
+    TEST_ASSERT_TRUE(plain.loadConfiguration(makeConfig(CONSTANT_LOGIC, false).c_str()));
+    TEST_ASSERT_TRUE(optimized.loadConfiguration(makeConfig(CONSTANT_LOGIC, true).c_str()));
+
+    TEST_ASSERT_EQUAL(3, optimized.getOptimization().foldedBlocks);
+    TEST_ASSERT_EQUAL(0, optimized.getOptimization().deadBlocks);
+    TEST_ASSERT_EQUAL(2, optimized.getBlockCount());
+
+    // Folded values are there before the first scan
+    optimized.run();
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, optimized.getMemory().getValue<float>("total"));
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, optimized.getMemory().getValue<float>("r1"));
+
+    plain.run();
+    for (int scan = 0; scan < 3; scan++) {
+        plain.getMemory().setValue<float>("x", scan * 10.0f);
+        optimized.getMemory().setValue<float>("x", scan * 10.0f);
+        plain.evaluate();
+        optimized.evaluate();
+        TEST_ASSERT_EQUAL_FLOAT(plain.getMemory().getValue<float>("total"), optimized.getMemory().getValue<float>("total"));
+        TEST_ASSERT_EQUAL_FLOAT(plain.getMemory().getValue<float>("shifted"), optimized.getMemory().getValue<float>("shifted"));
+        TEST_ASSERT_EQUAL(plain.getMemory().getValue<int16_t>("count"), optimized.getMemory().getValue<int16_t>("count"));
+    }
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, optimized.getMemory().getValue<float>("shifted"));
+    TEST_ASSERT_EQUAL(1, optimized.getMemory().getValue<int16_t>("count"));
+}
+
+void test_generated_chain_without_observers_is_removed() {
+    // plc_benchmark_gen.py --optimize: nothing reads res_*, the whole chain goes
+    std::string json = "{\"program\": {\"optimize\": true, \"blocks\": [";
+    for (int i = 0; i < 50; i++) {
+        json += i ? ", " : "";
+        json += "{\"id\": \"block_" + std::to_string(i) + "\", \"type\": \"ADD\", \"inputs\": {\"IN1\": ";
+        json += i ? "{\"type\": \"var\", \"value\": \"res_" + std::to_string(i - 1) + "\"}" : std::string("{\"type\": \"const\", \"value\": 0}");
+        json += ", \"IN2\": {\"type\": \"const\", \"value\": 1}}, \"outputs\": {\"OUT\": \"res_" + std::to_string(i) + "\"}}";
+    }
+    json += "]}}";
+
+    PlcProgram program("bench", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(json.c_str()));
+    TEST_ASSERT_EQUAL(50, program.getOptimization().foldedBlocks);
+    TEST_ASSERT_EQUAL(50, program.getOptimization().getRemovedBlocks());
+    TEST_ASSERT_EQUAL(0, program.getBlockCount());
+    program.run();
+    program.evaluate();
+}
+
+// raw (int8 in a byte) -> INT8_TO_INT16 -> wide -> INT16_TO_FLOAT -> temp
+// collapses into one block. u16 -> INT16_TO_FLOAT does not: the uint16
+// written into a REAL would not be the int16 the INT slot holds.
+static const char* CONVERSION_LOGIC = R"JSON(
+    "memory": {
+        "raw": {"type": "byte"},
+        "temp": {"type": "real"},
+        "code": {"type": "int"},
+        "code_real": {"type": "real"},
+        "seen": {"type": "int"},
+        "seen_real": {"type": "real"}
+    },
+    "logic": [
+        {"block_type": "INT8_TO_INT16", "inputs": {"in": "raw"}, "outputs": {"out": "wide"}},
+        {"block_type": "INT16_TO_FLOAT", "inputs": {"in": "wide"}, "outputs": {"out": "temp"}},
+        {"block_type": "INT16_TO_UINT16", "inputs": {"in": "code"}, "outputs": {"out": "u16"}},
+        {"block_type": "INT16_TO_FLOAT", "inputs": {"in": "u16"}, "outputs": {"out": "code_real"}},
+        {"block_type": "INT16_TO_UINT16", "inputs": {"in": "code"}, "outputs": {"out": "seen"}},
+        {"block_type": "INT16_TO_FLOAT", "inputs": {"in": "seen"}, "outputs": {"out": "seen_real"}}
+    ]
+)JSON";
+
+void test_conversion_chains_collapse() {
+    const char* engines[] = {"bytecode", "blocks"};
+    for (const char* engine : engines) {
+        PlcProgram plain("plain", nullptr, nullptr);
+        PlcProgram optimized("optimized", nullptr, nullptr);
+        TEST_ASSERT_TRUE(plain.loadConfiguration(makeConfig(CONVERSION_LOGIC, false, engine).c_str()));
+        TEST_ASSERT_TRUE(optimized.loadConfiguration(makeConfig(CONVERSION_LOGIC, true, engine).c_str()));
+        TEST_ASSERT_EQUAL_MESSAGE(1, optimized.getOptimization().collapsedBlocks, engine); // seen is observed
+        TEST_ASSERT_EQUAL(5, optimized.getBlockCount());
+
+        plain.run();
+        optimized.run();
+        const uint8_t raws[] = {0, 56, 127, 128, 200, 255};
+        const int16_t codes[] = {0, 1, -1, 32767, -32768, 1234};
+        for (size_t i = 0; i < sizeof(raws); i++) {
+            plain.getMemory().setValue<uint8_t>("raw", raws[i]);
+            optimized.getMemory().setValue<uint8_t>("raw", raws[i]);
+            plain.getMemory().setValue<int16_t>("code", codes[i]);
+            optimized.getMemory().setValue<int16_t>("code", codes[i]);
+            plain.evaluate();
+            optimized.evaluate();
+            const char* observed[] = {"temp", "code_real", "seen_real"};
+            for (const char* name : observed) {
+                TEST_ASSERT_EQUAL_FLOAT_MESSAGE(plain.getMemory().getValue<float>(name), optimized.getMemory().getValue<float>(name), name);
+            }
+            TEST_ASSERT_EQUAL_FLOAT(static_cast<float>(static_cast<int8_t>(raws[i])), optimized.getMemory().getValue<float>("temp"));
+        }
+    }
+}
+
+void test_images_keep_the_setting_and_io_points() {
+    std::vector<uint8_t> image;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(makeConfig(DEAD_LOGIC, true).c_str(), "image", image));
+    PlcProgramImage opened;
+    TEST_ASSERT_TRUE(opened.open(image.data(), image.size(), "image"));
+    TEST_ASSERT_TRUE(opened.getOptimize());
+    TEST_ASSERT_EQUAL(1, opened.getIoPointCount());
+    TEST_ASSERT_EQUAL_STRING("lamp", opened.getIoPoint(0));
+
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadImage(image.data(), image.size()));
+    TEST_ASSERT_EQUAL(4, program.getOptimization().deadBlocks);
+
+    // An image with the 52 byte header of earlier releases: no flags, no IO
+    // points, so the optimizer stays off
+    std::vector<uint8_t> plain;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(makeConfig(CONVERSION_LOGIC, false).c_str(), "image", plain));
+    uint32_t shift = PlcProgramImage::HEADER_SIZE - PlcProgramImage::MIN_HEADER_SIZE;
+    std::vector<uint8_t> old(plain.begin(), plain.begin() + PlcProgramImage::MIN_HEADER_SIZE);
+    old.insert(old.end(), plain.begin() + PlcProgramImage::HEADER_SIZE, plain.end());
+    auto shiftOffset = [&old, shift](size_t at) {
+        uint32_t v = old[at] | (old[at + 1] << 8) | (old[at + 2] << 16) | (static_cast<uint32_t>(old[at + 3]) << 24);
+        v -= shift;
+        for (int i = 0; i < 4; i++) {
+            old[at + i] = (v >> (8 * i)) & 0xFF;
+        }
+    };
+    old[6] = PlcProgramImage::MIN_HEADER_SIZE;
+    shiftOffset(8);  // Image size
+    shiftOffset(36); // String table
+    shiftOffset(44); // Block configs
+
+    PlcProgram legacy("legacy", nullptr, nullptr);
+    TEST_ASSERT_TRUE(legacy.loadImage(old.data(), old.size()));
+    TEST_ASSERT_EQUAL(0, legacy.getOptimization().getRemovedBlocks());
+    TEST_ASSERT_EQUAL(6, legacy.getBlockCount());
+    legacy.run();
+    legacy.getMemory().setValue<uint8_t>("raw", 200);
+    legacy.evaluate();
+    TEST_ASSERT_EQUAL_FLOAT(-56.0f, legacy.getMemory().getValue<float>("temp"));
+}
+
+void test_online_change_matches_the_remaining_blocks() {
+    PlcProgram previous("main", nullptr, nullptr);
+    PlcProgram next("main", nullptr, nullptr);
+    TEST_ASSERT_TRUE(previous.loadConfiguration(makeConfig(DEAD_LOGIC, true).c_str()));
+    TEST_ASSERT_TRUE(next.loadConfiguration(makeConfig(DEAD_LOGIC, false).c_str()));
+    previous.run();
+    previous.getMemory().setValue<bool>("a", true);
+    previous.evaluate();
+
+    next.prepareTakeOver(previous);
+    TEST_ASSERT_EQUAL(4, next.getOnlineChange().migratedBlocks);
+    TEST_ASSERT_EQUAL(4, next.getOnlineChange().newBlocks);
+    TEST_ASSERT_EQUAL(0, next.getOnlineChange().droppedBlocks);
+    next.takeOver(previous);
+    next.evaluate();
+    TEST_ASSERT_TRUE(next.getMemory().getValue<bool>("out"));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unobserved_blocks_are_removed);
+    RUN_TEST(test_constant_blocks_are_folded);
+    RUN_TEST(test_generated_chain_without_observers_is_removed);
+    RUN_TEST(test_conversion_chains_collapse);
+    RUN_TEST(test_images_keep_the_setting_and_io_points);
+    RUN_TEST(test_online_change_matches_the_remaining_blocks);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Process image tests
+ *
+ * Writes posted from other tasks take effect at the start of the next
+ * cycle and readers only see the values of completed cycles. A cycle is
+ * driven the way PlcEngine::scanProgram() does it.
+ */
+
+static const char* MIRROR_LOGIC = R"JSON({
+    "engine": "blocks",
+    "memory": {
+        "x": {"type": "real"},
+        "zero": {"type": "real"},
+        "a": {"type": "real"},
+        "b": {"type": "real"},
+        "enable": {"type": "bool"},
+        "running": {"type": "bool"},
+        "label": {"type": "string"}
+    },
+    "logic": [
+        {"block_type": "ADD", "inputs": ["x", "zero"], "outputs": {"out": "a"}},
+        {"block_type": "AND", "inputs": ["enable", "enable"], "outputs": {"out": "running"}},
+        {"block_type": "ADD", "inputs": ["a", "zero"], "outputs": {"out": "b"}}
+    ]
+})JSON";
+
+static void scan(PlcProgram& program) {
+    program.getMemory().applyInputImage();
+    program.evaluate();
+    program.getMemory().publishOutputImage();
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_posted_write_applies_at_cycle_start() {
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(MIRROR_LOGIC));
+    program.run();
+    PlcMemory& mem = program.getMemory();
+    TEST_ASSERT_TRUE(mem.hasProcessImage());
+
+    TEST_ASSERT_TRUE(mem.postValue<float>("x", 4.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, mem.getValue<float>("x", -1.0f)); // Not applied yet
+
+    // Last write before the cycle wins
+    TEST_ASSERT_TRUE(mem.postValue<float>("x", 5.0f));
+    scan(program);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.0f, mem.getValue<float>("x", 0.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.0f, mem.getImageValue<float>("b", 0.0f));
+
+    // Variables declared after the image was built are not accepted
+    mem.declareVariable("late", PlcValueType::BOOL);
+    TEST_ASSERT_FALSE(mem.postValue<bool>("late", true));
+    TEST_ASSERT_FALSE(mem.postValue<bool>("unknown", true));
+}
+
+void test_output_image_holds_last_completed_cycle() {
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(MIRROR_LOGIC));
+    program.run();
+    PlcMemory& mem = program.getMemory();
+
+    mem.postValue<float>("x", 1.0f);
+    mem.postValue<bool>("enable", true);
+    scan(program);
+    uint32_t cycle = mem.getImageCycle();
+
+    // Mid-scan values are not visible to readers
+    mem.postValue<float>("x", 2.0f);
+    mem.applyInputImage();
+    program.evaluate();
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.0f, mem.getValue<float>("b", 0.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, mem.getImageValue<float>("b", 0.0f));
+    TEST_ASSERT_TRUE(mem.getImageValue<bool>("running", false));
+
+    mem.publishOutputImage();
+    TEST_ASSERT_EQUAL_UINT32(cycle + 1, mem.getImageCycle());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.0f, mem.getImageValue<float>("b", 0.0f));
+}
+
+void test_string_values_pass_through_the_image() {
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(MIRROR_LOGIC));
+    program.run();
+    PlcMemory& mem = program.getMemory();
+
+    TEST_ASSERT_TRUE(mem.postValue<String>("label", String("pump 1")));
+    TEST_ASSERT_EQUAL_STRING("", mem.getImageValue<String>("label", String("?")).c_str());
+    scan(program);
+    TEST_ASSERT_EQUAL_STRING("pump 1", mem.getImageValue<String>("label", String("?")).c_str());
+    TEST_ASSERT_EQUAL_STRING("pump 1", mem.getImageValue<std::string>("label").c_str());
+}
+
+void test_incremental_mode_sees_posted_writes() {
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(R"JSON({
+        "execution": "incremental",
+        "logic": [
+            {"block_type": "NOT", "inputs": {"in": "in"}, "outputs": {"out": "out"}}
+        ]
+    })JSON"));
+    program.run();
+    PlcMemory& mem = program.getMemory();
+
+    scan(program);
+    scan(program);
+    TEST_ASSERT_EQUAL(0, program.getLastEvaluatedBlockCount());
+
+    mem.postValue<bool>("in", true);
+    scan(program);
+    TEST_ASSERT_EQUAL(1, program.getLastEvaluatedBlockCount());
+    TEST_ASSERT_FALSE(mem.getImageValue<bool>("out", true));
+}
+
+void test_concurrent_readers_see_consistent_cycles() {
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(MIRROR_LOGIC));
+    program.run();
+    PlcMemory& mem = program.getMemory();
+
+    std::vector<VarHandle> handles = {mem.findHandle("a"), mem.findHandle("b")};
+    std::atomic<bool> done(false);
+    std::atomic<int> mismatches(0);
+    std::atomic<int> reads(0);
+
+    std::thread writer([&]() {
+        float value = 0.0f;
+        while (!done.load()) {
+            mem.postValue<float>("x", value);
+            value += 1.0f;
+        }
+    });
+    std::thread reader([&]() {
+        std::vector<PlcValue> values;
+        while (!done.load()) {
+            if (!mem.getImageValues(handles, values) || values[0].value.fVal != values[1].value.fVal) {
+                mismatches++;
+            }
+            reads++;
+        }
+    });
+
+    // Keep scanning until the other threads have overlapped with many cycles
+    uint32_t firstCycle = mem.getImageCycle();
+    int cycles = 0;
+    while (cycles < 20000 || reads.load() < 20000) {
+        scan(program);
+        cycles++;
+    }
+    done = true;
+    writer.join();
+    reader.join();
+
+    TEST_ASSERT_EQUAL(0, mismatches.load());
+    TEST_ASSERT_EQUAL_UINT32(firstCycle + cycles, mem.getImageCycle());
+}
+
+void test_late_declarations_are_refused_while_scanning() {
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(MIRROR_LOGIC));
+    program.run();
+    PlcMemory& mem = program.getMemory();
+    size_t used = mem.getMemoryUsage();
+
+    // Another task declares while the program scans: its variables are
+    // fixed, so nothing the scan reads may move
+    std::atomic<bool> done(false);
+    std::atomic<int> accepted(0);
+    std::atomic<int> refused(0);
+    std::thread declarer([&]() {
+        for (int i = 0; i < 4000; i++) {
+            (mem.declareVariable("x", PlcValueType::REAL) ? accepted : refused)++; // One of the program's
+            if (i % 100 == 0) {
+                std::string name = "late" + std::to_string(i);
+                (mem.declareVariable(name, PlcValueType::REAL) ? accepted : refused)++;
+                (mem.resolve(name.c_str(), PlcValueType::BOOL).isValid() ? accepted : refused)++;
+            }
+        }
+        done = true;
+    });
+    int cycle = 0;
+    while (!done.load() || cycle < 2000) {
+        mem.postValue<float>("x", static_cast<float>(cycle));
+        scan(program);
+        cycle++;
+    }
+    declarer.join();
+
+    TEST_ASSERT_EQUAL_FLOAT(static_cast<float>(cycle - 1), mem.getImageValue<float>("b"));
+    TEST_ASSERT_EQUAL(4000, accepted.load());
+    TEST_ASSERT_EQUAL(80, refused.load());
+    TEST_ASSERT_FALSE(mem.findHandle("late0").isValid());
+    TEST_ASSERT_FALSE(mem.declareVariable("x", PlcValueType::INT));
+    TEST_ASSERT_FALSE(mem.declareArray("late", PlcValueType::INT, 4));
+    TEST_ASSERT_FALSE(mem.postValue<float>("late0", 1.0f));
+    TEST_ASSERT_EQUAL(used, mem.getMemoryUsage());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_posted_write_applies_at_cycle_start);
+    RUN_TEST(test_output_image_holds_last_completed_cycle);
+    RUN_TEST(test_string_values_pass_through_the_image);
+    RUN_TEST(test_incremental_mode_sees_posted_writes);
+    RUN_TEST(test_concurrent_readers_see_consistent_cycles);
+    RUN_TEST(test_late_declarations_are_refused_while_scanning);
+    UNITY_END();
+    return 0;
+}
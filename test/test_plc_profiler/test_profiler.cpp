@@ -0,0 +1,179 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "Engine/PlcProfiler.h"
+#include <cstdint>
+
+/**
+ * @brief Scan-time profiler tests
+ *
+ * The timing statistics are tested in every build. The program profile and
+ * the performance budgets need -D PLC_PROFILING (pio test -e native_profiling).
+ * Ticks are nanoseconds in native builds.
+ */
+
+// Budget per block and scan on the host; generous so CI machines under
+// load do not fail, but far above what a runaway evaluation would cost
+static const float BLOCK_BUDGET_US = 50.0f;
+static const int BENCH_BLOCKS = 50;
+static const int BENCH_SCANS = 200;
+
+static String makeChainConfig(const char* engine, const char* execution) {
+    String json = "{\"engine\": \"";
+    json += engine;
+    json += "\", \"execution\": \"";
+    json += execution;
+    json += "\", \"logic\": [";
+    for (int i = 0; i < BENCH_BLOCKS; i++) {
+        if (i > 0) json += ",";
+        json += "{\"block_type\": \"ADD\", \"inputs\": [\"v" + String(i) + "\", \"step\"], \"outputs\": {\"out\": \"v" + String(i + 1) + "\"}}";
+    }
+    json += "]}";
+    return json;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_profile_min_max_mean() {
+    PlcTimingProfile profile;
+    TEST_ASSERT_EQUAL_UINT32(0, profile.getMeanTicks());
+
+    profile.record(100);
+    profile.record(300);
+    profile.record(200);
+
+    TEST_ASSERT_EQUAL_UINT32(3, profile.samples);
+    TEST_ASSERT_EQUAL_UINT32(200, profile.lastTicks);
+    TEST_ASSERT_EQUAL_UINT32(300, profile.maxTicks);
+    TEST_ASSERT_EQUAL_UINT32(200, profile.getMeanTicks());
+
+    profile.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, profile.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, profile.maxTicks);
+}
+
+void test_profile_histogram_is_log2() {
+    const uint32_t base = 1u << PlcTimingProfile::HISTOGRAM_MIN_LOG2;
+    PlcTimingProfile profile;
+
+    profile.record(0);            // Below the first bucket limit
+    profile.record(base * 2 - 1);
+    profile.record(base * 2);     // Bucket 1: [2^(min+1), 2^(min+2))
+    profile.record(base * 4 - 1);
+    profile.record(base * 4);     // Bucket 2
+    profile.record(UINT32_MAX);   // Open-ended last bucket
+
+    TEST_ASSERT_EQUAL_UINT32(2, profile.histogram[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, profile.histogram[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, profile.histogram[2]);
+    TEST_ASSERT_EQUAL_UINT32(1, profile.histogram[PlcTimingProfile::HISTOGRAM_BUCKETS - 1]);
+}
+
+#ifdef PLC_PROFILING
+
+static void checkBudget(const char* engine, const char* execution) {
+    PlcProgram program("bench", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(makeChainConfig(engine, execution).c_str()));
+    program.run();
+
+    const PlcProfiler& profiler = program.getProfiler();
+    TEST_ASSERT_EQUAL(BENCH_BLOCKS, profiler.getBlockCount());
+
+    for (int scan = 0; scan < BENCH_SCANS; scan++) {
+        program.getMemory().setValue<float>("step", (float)(scan % 3)); // Keeps incremental mode busy
+        program.evaluate();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(BENCH_SCANS, profiler.getProgram().samples);
+
+    float totalMeanUs = 0.0f;
+    for (size_t i = 0; i < profiler.getBlockCount(); i++) {
+        const PlcTimingProfile& block = profiler.getBlock(i);
+        TEST_ASSERT_TRUE(block.samples > 0);
+        float meanUs = PlcProfiler::toMicros(block.getMeanTicks());
+        TEST_ASSERT_TRUE_MESSAGE(meanUs < BLOCK_BUDGET_US, engine);
+        totalMeanUs += meanUs;
+    }
+
+    // Per-block times cannot exceed the program time they are part of
+    TEST_ASSERT_TRUE(totalMeanUs <= PlcProfiler::toMicros(profiler.getProgram().getMeanTicks()) * 1.05f + 1.0f);
+    TEST_ASSERT_TRUE(PlcProfiler::toMicros(profiler.getProgram().getMeanTicks()) < BLOCK_BUDGET_US * BENCH_BLOCKS);
+}
+
+void test_budget_blocks_engine() {
+    checkBudget("blocks", "cyclic");
+}
+
+void test_budget_bytecode_engine() {
+    checkBudget("bytecode", "cyclic");
+}
+
+void test_budget_incremental() {
+    checkBudget("blocks", "incremental");
+}
+
+void test_profile_json() {
+    PlcProgram program("json", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(R"JSON({
+        "logic": [
+            {"block_type": "NOT", "inputs": {"in": "b"}, "outputs": {"out": "c"}},
+            {"block_type": "AND", "inputs": ["a", "x"], "outputs": {"out": "b"}}
+        ]
+    })JSON"));
+    program.run();
+    program.evaluate();
+    program.evaluate();
+
+    JsonDocument doc;
+    program.getProfile(doc.to<JsonObject>());
+
+    TEST_ASSERT_EQUAL_STRING("json", doc["program"] | "");
+    TEST_ASSERT_EQUAL(2, doc["total"]["samples"] | 0);
+    TEST_ASSERT_EQUAL(PlcTimingProfile::HISTOGRAM_BUCKETS, doc["total"]["histogram"].size());
+
+    // Blocks are reported in evaluation order with their configuration index
+    JsonArray blocks = doc["blocks"];
+    TEST_ASSERT_EQUAL(2, blocks.size());
+    TEST_ASSERT_EQUAL(1, blocks[0]["index"] | -1);
+    TEST_ASSERT_EQUAL_STRING("AND", blocks[0]["type"] | "");
+    TEST_ASSERT_EQUAL(0, blocks[1]["index"] | -1);
+    TEST_ASSERT_EQUAL_STRING("NOT", blocks[1]["type"] | "");
+
+    program.resetProfile();
+    TEST_ASSERT_EQUAL_UINT32(0, program.getProfiler().getProgram().samples);
+}
+
+#else
+
+void test_budget_blocks_engine() {
+    TEST_IGNORE_MESSAGE("Build with -D PLC_PROFILING (pio test -e native_profiling)");
+}
+
+void test_budget_bytecode_engine() {
+    TEST_IGNORE_MESSAGE("Build with -D PLC_PROFILING (pio test -e native_profiling)");
+}
+
+void test_budget_incremental() {
+    TEST_IGNORE_MESSAGE("Build with -D PLC_PROFILING (pio test -e native_profiling)");
+}
+
+void test_profile_json() {
+    TEST_IGNORE_MESSAGE("Build with -D PLC_PROFILING (pio test -e native_profiling)");
+}
+
+#endif
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_min_max_mean);
+    RUN_TEST(test_profile_histogram_is_log2);
+    RUN_TEST(test_budget_blocks_engine);
+    RUN_TEST(test_budget_bytecode_engine);
+    RUN_TEST(test_budget_incremental);
+    RUN_TEST(test_profile_json);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "Engine/PlcProgramImage.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Program image tests
+ *
+ * A JSON configuration compiles to a binary image that loads to the same
+ * program, and damaged or foreign images are rejected before anything is
+ * declared.
+ */
+
+static const char* IMAGE_LOGIC = R"JSON({
+    "engine": "blocks",
+    "cycle_time_ms": 20,
+    "watchdog_timeout_ms": 1500,
+    "overrun": "catch_up",
+    "memory": {
+        "a": {"type": "real"},
+        "b": {"type": "real"},
+        "sum": {"type": "real", "retentive": true},
+        "start": {"type": "bool", "mesh_link": "node1.button"},
+        "running": {"type": "bool"}
+    },
+    "init": [
+        {"action": "set_value", "variable": "b", "value": 2.5},
+        {"action": "set_value", "variable": "start", "value": true},
+        {"action": "log", "message": "ignored"}
+    ],
+    "logic": [
+        {"block_type": "GT", "inputs": ["sum", "b"], "outputs": {"out": "running"}},
+        {"block_type": "ADD", "inputs": ["a", "b"], "outputs": {"out": "sum"}}
+    ]
+})JSON";
+
+static std::vector<uint8_t> compileImage(const char* json) {
+    std::vector<uint8_t> image;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(json, "image", image));
+    return image;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_compile_and_open_roundtrip() {
+    std::vector<uint8_t> data = compileImage(IMAGE_LOGIC);
+    PlcProgramImage image;
+    TEST_ASSERT_TRUE(image.open(data.data(), data.size(), "image"));
+
+    TEST_ASSERT_EQUAL_UINT32(20, image.getCycleTimeMs());
+    TEST_ASSERT_EQUAL_UINT32(1500, image.getWatchdogTimeoutMs());
+    TEST_ASSERT_EQUAL_UINT8(PlcProgramImage::ENGINE_BLOCKS, image.getEngine());
+    TEST_ASSERT_EQUAL_UINT8(PlcProgramImage::EXECUTION_CYCLIC, image.getExecution());
+    TEST_ASSERT_EQUAL_UINT8(PlcProgramImage::OVERRUN_CATCH_UP, image.getOverrun());
+
+    TEST_ASSERT_EQUAL(5, image.getVariableCount());
+    PlcProgramImage::Variable sum = image.getVariable(2);
+    TEST_ASSERT_EQUAL_STRING("sum", sum.name);
+    TEST_ASSERT_TRUE(sum.type == PlcValueType::REAL);
+    TEST_ASSERT_TRUE(sum.retentive);
+    PlcProgramImage::Variable start = image.getVariable(3);
+    TEST_ASSERT_EQUAL_STRING("node1.button", start.meshLink);
+    TEST_ASSERT_FALSE(start.retentive);
+
+    TEST_ASSERT_EQUAL(2, image.getBlockCount());
+    TEST_ASSERT_EQUAL_STRING("GT", image.getBlock(0).type);
+    TEST_ASSERT_EQUAL_STRING("ADD", image.getBlock(1).type);
+    TEST_ASSERT_TRUE(image.getBlock(1).configSize > 0);
+
+    // Only set_value actions are kept
+    TEST_ASSERT_EQUAL(2, image.getInitCount());
+    PlcProgramImage::InitAction init = image.getInitAction(1);
+    TEST_ASSERT_EQUAL_STRING("start", init.variable);
+    TEST_ASSERT_TRUE(init.type == PlcValueType::BOOL);
+    TEST_ASSERT_TRUE(init.value.bVal);
+
+    // Compiling is deterministic
+    TEST_ASSERT_TRUE(data == compileImage(IMAGE_LOGIC));
+}
+
+void test_image_program_matches_json_program() {
+    std::vector<uint8_t> data = compileImage(IMAGE_LOGIC);
+    PlcProgram fromJson("json", nullptr, nullptr);
+    PlcProgram fromImage("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(fromJson.loadConfiguration(IMAGE_LOGIC));
+    TEST_ASSERT_TRUE(fromImage.loadImage(data.data(), data.size()));
+
+    TEST_ASSERT_TRUE(fromImage.getExecutionEngine() == PlcExecutionEngine::BLOCKS);
+    TEST_ASSERT_EQUAL_UINT32(20, fromImage.getCycleTimer().getCycleTimeMs());
+    TEST_ASSERT_EQUAL(fromJson.getBlockCount(), fromImage.getBlockCount());
+    for (size_t i = 0; i < fromImage.getBlockCount(); i++) {
+        TEST_ASSERT_EQUAL(fromJson.getBlockConfigIndex(i), fromImage.getBlockConfigIndex(i));
+        TEST_ASSERT_EQUAL_STRING(fromJson.getBlockType(i), fromImage.getBlockType(i));
+    }
+
+    fromJson.run();
+    fromImage.run();
+    for (int scan = 0; scan < 4; scan++) {
+        fromJson.getMemory().setValue<float>("a", scan * 1.5f);
+        fromImage.getMemory().setValue<float>("a", scan * 1.5f);
+        fromJson.evaluate();
+        fromImage.evaluate();
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, fromJson.getMemory().getValue<float>("sum", -1.0f), fromImage.getMemory().getValue<float>("sum", -2.0f));
+        TEST_ASSERT_EQUAL(fromJson.getMemory().getValue<bool>("running", false), fromImage.getMemory().getValue<bool>("running", true));
+    }
+}
+
+void test_init_actions_applied_on_run() {
+    std::vector<uint8_t> data = compileImage(IMAGE_LOGIC);
+    PlcProgram program("image", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadImage(data.data(), data.size()));
+    data.assign(data.size(), 0); // The image is not referenced after loading
+
+    program.run();
+    PlcMemory& mem = program.getMemory();
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.5f, mem.getValue<float>("b", 0.0f));
+    TEST_ASSERT_TRUE(mem.getValue<bool>("start", false));
+    TEST_ASSERT_EQUAL_STRING("ADD", program.getBlockType(1));
+}
+
+void test_damaged_images_rejected() {
+    std::vector<uint8_t> good = compileImage(IMAGE_LOGIC);
+    PlcProgram program("image", nullptr, nullptr);
+
+    std::vector<uint8_t> data = good;
+    data[0] = 'X';
+    TEST_ASSERT_FALSE(program.loadImage(data.data(), data.size()));
+
+    data = good;
+    data[4] = PlcProgramImage::VERSION + 1;
+    TEST_ASSERT_FALSE(program.loadImage(data.data(), data.size()));
+
+    data = good;
+    data[data.size() - 1] ^= 0x01;
+    TEST_ASSERT_FALSE(program.loadImage(data.data(), data.size()));
+
+    TEST_ASSERT_FALSE(program.loadImage(good.data(), good.size() - 1));
+    TEST_ASSERT_FALSE(program.loadImage(good.data(), PlcProgramImage::HEADER_SIZE - 1));
+    TEST_ASSERT_FALSE(program.loadImage(nullptr, 0));
+    TEST_ASSERT_EQUAL(0, program.getMemory().getVariableCount());
+
+    // Trailing bytes (e.g. the rest of a flash partition) are ignored
+    data = good;
+    data.resize(good.size() + 256, 0xFF);
+    TEST_ASSERT_TRUE(program.loadImage(data.data(), data.size()));
+}
+
+void test_invalid_configuration_not_compiled() {
+    std::vector<uint8_t> image;
+    TEST_ASSERT_FALSE(PlcProgramImage::compile("{", "bad", image));
+    TEST_ASSERT_FALSE(PlcProgramImage::compile(R"({"engine": "turbo"})", "bad", image));
+    TEST_ASSERT_FALSE(PlcProgramImage::compile(R"({"memory": {"x": {"type": "float"}}})", "bad", image));
+    TEST_ASSERT_FALSE(PlcProgramImage::compile(R"({"logic": [{"inputs": ["a"]}]})", "bad", image));
+    TEST_ASSERT_TRUE(image.empty());
+
+    // Unknown block types are caught when the image is loaded
+    PlcProgram program("bad", nullptr, nullptr);
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({"logic": [{"block_type": "NOPE"}]})"));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compile_and_open_roundtrip);
+    RUN_TEST(test_image_program_matches_json_program);
+    RUN_TEST(test_init_actions_applied_on_run);
+    RUN_TEST(test_damaged_images_rejected);
+    RUN_TEST(test_invalid_configuration_not_compiled);
+    UNITY_END();
+    return 0;
+}
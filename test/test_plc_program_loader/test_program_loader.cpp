@@ -0,0 +1,162 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "Engine/PlcProgramLoader.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Streaming program loader tests
+ *
+ * Programs are read in chunks of any size and compile to the same image
+ * as a whole buffer. Large programs in the plc_benchmark_gen.py format
+ * load with a peak heap that does not grow with the size of one block.
+ */
+
+static const char* SMALL_LOGIC = R"JSON({
+    "memory": {
+        "a": {"type": "real"},
+        "label": {"type": "string"}
+    },
+    "logic": [
+        {"block_type": "ADD", "inputs": ["a", "b"], "outputs": {"out": "sum"}},
+        {"block_type": "GT", "inputs": ["sum", "a"], "outputs": {"out": "up"}}
+    ],
+    "applications": [{"type": "thermostat", "settings": {"nested": [1, 2, {"x": "]}"}]}}],
+    "init": [{"action": "set_value", "variable": "b", "value": 1.5}],
+    "cycle_time_ms": 25,
+    "engine": "blocks"
+})JSON";
+
+// Same structure as the output of test/tools/plc_benchmark_gen.py
+static std::string makeBenchmarkJson(int blockCount) {
+    std::string json = "{\"program\": {\"name\": \"Benchmark_Program\", \"cycle_time_ms\": 100, \"blocks\": [";
+    char buf[256];
+    for (int i = 0; i < blockCount; i++) {
+        if (i == 0) {
+            snprintf(buf, sizeof(buf),
+                     "{\"id\": \"block_0\", \"type\": \"ADD\", \"inputs\": {\"IN1\": {\"type\": \"const\", \"value\": 0}, "
+                     "\"IN2\": {\"type\": \"const\", \"value\": 1}}, \"outputs\": {\"OUT\": \"res_0\"}}");
+        } else {
+            snprintf(buf, sizeof(buf),
+                     ",\n  {\"id\": \"block_%d\", \"type\": \"ADD\", \"inputs\": {\"IN1\": {\"type\": \"var\", \"value\": \"res_%d\"}, "
+                     "\"IN2\": {\"type\": \"const\", \"value\": 1}}, \"outputs\": {\"OUT\": \"res_%d\"}}", i, i - 1, i);
+        }
+        json += buf;
+    }
+    json += "]}}";
+    return json;
+}
+
+// Reads the buffer in pieces of at most chunkSize bytes
+static PlcProgramLoader::ReadFunction readInChunks(const std::string& json, size_t chunkSize) {
+    size_t offset = 0;
+    return [json, chunkSize, offset](uint8_t* buffer, size_t size) mutable {
+        size_t count = std::min(std::min(size, chunkSize), json.size() - offset);
+        memcpy(buffer, json.data() + offset, count);
+        offset += count;
+        return count;
+    };
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_chunk_size_does_not_change_image() {
+    std::vector<uint8_t> whole;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(SMALL_LOGIC, "loader", whole));
+
+    const size_t chunkSizes[] = {1, 7, 64};
+    for (size_t chunkSize : chunkSizes) {
+        PlcProgramLoader loader("loader");
+        std::vector<uint8_t> image;
+        TEST_ASSERT_TRUE(loader.load(readInChunks(SMALL_LOGIC, chunkSize), image));
+        TEST_ASSERT_TRUE(image == whole);
+        TEST_ASSERT_EQUAL(strlen(SMALL_LOGIC), loader.getBytesRead());
+    }
+
+    // Settings after the logic and skipped sections are handled
+    PlcProgramImage image;
+    TEST_ASSERT_TRUE(image.open(whole.data(), whole.size(), "loader"));
+    TEST_ASSERT_EQUAL_UINT32(25, image.getCycleTimeMs());
+    TEST_ASSERT_EQUAL_UINT8(PlcProgramImage::ENGINE_BLOCKS, image.getEngine());
+    TEST_ASSERT_EQUAL(2, image.getBlockCount());
+    TEST_ASSERT_EQUAL(1, image.getInitCount());
+}
+
+void test_benchmark_generator_format_loads() {
+    const int blockCount = 1000;
+    std::string json = makeBenchmarkJson(blockCount);
+    TEST_ASSERT_TRUE(json.size() > 4096 * 10);
+
+    PlcProgram program("bench", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfigurationStream(readInChunks(json, PlcProgramLoader::CHUNK_SIZE)));
+    TEST_ASSERT_EQUAL(blockCount, program.getBlockCount());
+    TEST_ASSERT_EQUAL_UINT32(100, program.getCycleTimer().getCycleTimeMs());
+    // Blocks are created from the compiled tables, not from the JSON
+    TEST_ASSERT_TRUE(program.getLoadBytesPeak() > 0);
+    TEST_ASSERT_TRUE(program.getLoadBytesPeak() < json.size() / 2);
+    printf("Loaded %d blocks from %u bytes of JSON, bytes_peak %u\n",
+           blockCount, (unsigned)json.size(), (unsigned)program.getLoadBytesPeak());
+
+    // Constants are variables set by the init actions; data-flow order
+    // evaluates the whole chain in one scan
+    program.run();
+    program.evaluate();
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, program.getMemory().getValue<float>("#1", 0.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (float)blockCount, program.getMemory().getValue<float>("res_999", 0.0f));
+}
+
+void test_peak_heap_is_bounded_by_the_image() {
+    std::string small = makeBenchmarkJson(10);
+    std::string large = makeBenchmarkJson(1000);
+
+    PlcProgramLoader smallLoader("small");
+    PlcProgramLoader largeLoader("large");
+    std::vector<uint8_t> smallImage, largeImage;
+    TEST_ASSERT_TRUE(smallLoader.load(small.c_str(), small.size(), smallImage));
+    TEST_ASSERT_TRUE(largeLoader.load(large.c_str(), large.size(), largeImage));
+
+    // Only one block is parsed at a time
+    TEST_ASSERT_TRUE(largeLoader.getJsonBytesPeak() > 0);
+    TEST_ASSERT_TRUE(largeLoader.getJsonBytesPeak() < smallLoader.getJsonBytesPeak() * 2);
+
+    // The rest is the image and its tables, well below the JSON itself
+    TEST_ASSERT_TRUE(largeLoader.getBytesPeak() < largeImage.size() * 3 + PlcProgramLoader::MAX_ELEMENT_SIZE);
+    TEST_ASSERT_TRUE(largeLoader.getBytesPeak() < large.size());
+}
+
+void test_malformed_input_rejected() {
+    std::vector<uint8_t> image;
+    PlcProgramLoader loader("bad");
+
+    TEST_ASSERT_FALSE(loader.load(readInChunks("", 16), image));
+    TEST_ASSERT_FALSE(loader.load(readInChunks("[]", 16), image));
+    TEST_ASSERT_FALSE(loader.load(readInChunks(R"({"logic": [{"block_type": "ADD"})", 16), image));
+    TEST_ASSERT_FALSE(loader.load(readInChunks(R"({"logic": {"block_type": "ADD"}})", 16), image));
+    TEST_ASSERT_FALSE(loader.load(readInChunks(R"({"logic": [1]})", 16), image));
+    TEST_ASSERT_FALSE(loader.load(readInChunks(R"({"cycle_time_ms": 0})", 16), image));
+    TEST_ASSERT_FALSE(loader.load(readInChunks(R"({} trailing)", 16), image));
+    TEST_ASSERT_TRUE(image.empty());
+
+    // A single entry larger than the element buffer
+    std::string huge = R"({"logic": [{"block_type": "ADD", "note": ")" +
+                       std::string(PlcProgramLoader::MAX_ELEMENT_SIZE, 'x') + R"("}]})";
+    TEST_ASSERT_FALSE(loader.load(huge.c_str(), huge.size(), image));
+
+    TEST_ASSERT_TRUE(loader.load(readInChunks(" {} ", 16), image));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_chunk_size_does_not_change_image);
+    RUN_TEST(test_benchmark_generator_format_loads);
+    RUN_TEST(test_peak_heap_is_bounded_by_the_image);
+    RUN_TEST(test_malformed_input_rejected);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,282 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+#include <Preferences.h>
+#include <string>
+
+/**
+ * @brief Retentive memory tests
+ *
+ * Retentive variables are tracked at the end of each scan, packed at most
+ * once per commit interval and written to two alternating NVS keys. The
+ * native Preferences mock keeps its contents across engine instances, so
+ * deleting the engine and loading the program again simulates a reboot.
+ */
+
+static const char* PROGRAM = R"({
+    "memory": {
+        "pulse": {"type": "bool"}, "pv": {"type": "int"},
+        "count": {"type": "int", "retentive": true},
+        "gain": {"type": "real", "retentive": true},
+        "label": {"type": "string", "retentive": true},
+        "scratch": {"type": "int"}
+    },
+    "logic": [
+        {"block_type": "CTU", "inputs": {"cu": "pulse", "pv": "pv"}, "outputs": {"cv": "count"}}
+    ],
+    "init": [{"action": "set_value", "variable": "pv", "value": 1000}, {"action": "set_value", "variable": "scratch", "value": 7}],
+    "cycle_time_ms": 10,
+    "retentive_commit_s": 1
+})";
+
+// "gain" changed type, "count" kept, "offset" added
+static const char* PROGRAM_V2 = R"({
+    "memory": {
+        "pulse": {"type": "bool"}, "pv": {"type": "int"},
+        "count": {"type": "int", "retentive": true},
+        "gain": {"type": "int", "retentive": true},
+        "offset": {"type": "real", "retentive": true}
+    },
+    "logic": [
+        {"block_type": "CTU", "inputs": {"cu": "pulse", "pv": "pv"}, "outputs": {"cv": "count"}}
+    ],
+    "init": [{"action": "set_value", "variable": "pv", "value": 1000}],
+    "cycle_time_ms": 10,
+    "retentive_commit_s": 1
+})";
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+static void boot() {
+    clock_ = new ManualPlcClock();
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+}
+
+static void shutdown() {
+    delete engine;
+    delete clock_;
+    engine = nullptr;
+    clock_ = nullptr;
+}
+
+void setUp(void) {
+    Preferences::resetFlash();
+    boot();
+}
+
+void tearDown(void) {
+    shutdown();
+}
+
+static void reboot() {
+    shutdown();
+    boot();
+}
+
+static PlcMemory& memory() {
+    return engine->getProgram("main")->getMemory();
+}
+
+static PlcRetentiveStore& retentive() {
+    return memory().getRetentive();
+}
+
+// One pass of the PLC task, then the main loop
+static void step() {
+    clock_->sleepUntil(engine->runDueCycles());
+    engine->commitRetentive();
+}
+
+static void runFor(uint32_t ms) {
+    uint32_t end = clock_->nowMicros() + ms * 1000;
+    while (static_cast<int32_t>(clock_->nowMicros() - end) < 0) {
+        step();
+    }
+}
+
+static void start(const char* program = PROGRAM) {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", program));
+    engine->runProgram("main");
+}
+
+static void pulse(int times) {
+    for (int i = 0; i < times; i++) {
+        memory().postValue<bool>("pulse", true);
+        step();
+        memory().postValue<bool>("pulse", false);
+        step();
+    }
+}
+
+void test_values_survive_a_reboot() {
+    start();
+    pulse(3);
+    memory().postValue<float>("gain", 1.5f);
+    memory().postValue<std::string>("label", "tank 2");
+    memory().postValue<int16_t>("scratch", 99);
+    runFor(1100);
+    TEST_ASSERT_EQUAL(1, retentive().getStats().commits);
+
+    reboot();
+    start();
+    TEST_ASSERT_EQUAL_INT16(3, memory().getValue<int16_t>("count"));
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, memory().getValue<float>("gain"));
+    TEST_ASSERT_EQUAL_STRING("tank 2", memory().getValue<std::string>("label").c_str());
+    TEST_ASSERT_EQUAL_INT16(7, memory().getValue<int16_t>("scratch")); // Not retentive: INIT value
+    TEST_ASSERT_EQUAL_INT16(3, memory().getImageValue<int16_t>("count")); // Published before the first scan
+
+    // Counting continues from the restored value
+    pulse(1);
+    TEST_ASSERT_EQUAL_INT16(4, memory().getValue<int16_t>("count"));
+}
+
+void test_stop_writes_pending_values() {
+    start();
+    pulse(2);
+    TEST_ASSERT_EQUAL(0, Preferences::stats().writes); // Within the first interval
+    engine->stopProgram("main");
+    TEST_ASSERT_EQUAL(0, Preferences::stats().writes); // Packed, written by the main loop
+    engine->commitRetentive();
+    TEST_ASSERT_EQUAL(1, Preferences::stats().writes);
+
+    reboot();
+    start();
+    TEST_ASSERT_EQUAL_INT16(2, memory().getValue<int16_t>("count"));
+}
+
+void test_changes_within_an_interval_are_one_write() {
+    start();
+    // 100 counts in 2 s with a 1 s commit interval
+    for (int i = 0; i < 50; i++) {
+        pulse(1);
+        clock_->advance(18000);
+    }
+    runFor(1000);
+
+    const PlcRetentiveStats& stats = retentive().getStats();
+    TEST_ASSERT_EQUAL_INT16(50, memory().getValue<int16_t>("count"));
+    TEST_ASSERT_EQUAL(50, stats.valueChanges);
+    TEST_ASSERT_EQUAL(2, stats.commits);
+    TEST_ASSERT_EQUAL(2, stats.committedSlots);
+    TEST_ASSERT_EQUAL(2, Preferences::stats().writes);
+    TEST_ASSERT_EQUAL(stats.bytesWritten, Preferences::stats().bytesWritten);
+}
+
+void test_no_write_without_changes() {
+    start();
+    runFor(10000);
+    TEST_ASSERT_EQUAL(0, retentive().getStats().valueChanges);
+    TEST_ASSERT_EQUAL(0, Preferences::stats().writes);
+
+    // Writing the same value again is not a change
+    memory().postValue<float>("gain", 0.0f);
+    runFor(2000);
+    TEST_ASSERT_EQUAL(0, Preferences::stats().writes);
+}
+
+void test_pages_alternate_and_a_torn_write_keeps_the_previous_values() {
+    start();
+    pulse(1);
+    runFor(1100);
+    pulse(1);
+    runFor(1100);
+    TEST_ASSERT_EQUAL(2, Preferences::stats().writes);
+    TEST_ASSERT_EQUAL(2, Preferences::stats().writesPerKey.size()); // One write to each page
+
+    // Power cut in the middle of the third write
+    pulse(1);
+    Preferences::tearNextWrite() = 20;
+    runFor(1100);
+    TEST_ASSERT_EQUAL(3, Preferences::stats().writes);
+
+    reboot();
+    start();
+    TEST_ASSERT_EQUAL_INT16(2, memory().getValue<int16_t>("count")); // The last complete write
+
+    // The torn page is the one overwritten next
+    pulse(1);
+    engine->stopProgram("main");
+    engine->commitRetentive();
+    reboot();
+    start();
+    TEST_ASSERT_EQUAL_INT16(3, memory().getValue<int16_t>("count"));
+}
+
+void test_changed_program_keeps_matching_values() {
+    start();
+    pulse(5);
+    memory().postValue<float>("gain", 2.5f);
+    step();
+    engine->stopProgram("main");
+    engine->commitRetentive();
+
+    reboot();
+    start(PROGRAM_V2);
+    TEST_ASSERT_EQUAL_INT16(5, memory().getValue<int16_t>("count"));
+    TEST_ASSERT_EQUAL_INT16(0, memory().getValue<int16_t>("gain"));   // Other type: not restored
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, memory().getValue<float>("offset")); // New
+}
+
+void test_write_rate_metrics() {
+    start();
+    memory().postValue<int16_t>("pv", 30000);
+    // A value changing every other scan for one minute
+    for (int i = 0; i < 3000; i++) {
+        pulse(1);
+    }
+
+    JsonDocument doc;
+    retentive().getStatsJson(doc.to<JsonObject>(), clock_->nowMicros());
+    printf("Retentive store after 60 s: %u commits, %u bytes written, %.0f commits/h, %.0f bytes/h\n",
+           (unsigned)(doc["commits"] | 0), (unsigned)(doc["bytes_written"] | 0),
+           doc["commits_per_hour"].as<float>(), doc["bytes_per_hour"].as<float>());
+    TEST_ASSERT_EQUAL(3, doc["retentive_variables"].as<int>());
+    TEST_ASSERT_EQUAL(1000, doc["commit_interval_ms"].as<int>());
+    TEST_ASSERT_EQUAL(3000, doc["value_changes"].as<int>());
+    TEST_ASSERT_TRUE(doc["commits"].as<int>() >= 58 && doc["commits"].as<int>() <= 60);
+    TEST_ASSERT_FLOAT_WITHIN(120.0f, 3540.0f, doc["commits_per_hour"].as<float>());
+    TEST_ASSERT_EQUAL(0, doc["failed_commits"].as<int>());
+}
+
+void test_failed_write_is_retried() {
+    start();
+    pulse(2);
+    Preferences::failNextWrites() = 3;
+    runFor(1100); // Packed once, written by the fourth commit
+    TEST_ASSERT_EQUAL(3, retentive().getStats().failedCommits);
+    TEST_ASSERT_EQUAL(1, retentive().getStats().commits);
+    TEST_ASSERT_EQUAL(1, retentive().getStats().committedSlots); // "count", not once per attempt
+    TEST_ASSERT_EQUAL(1, Preferences::stats().writes);
+
+    // A blob packed while the flash keeps failing replaces the one waiting
+    pulse(1);
+    Preferences::failNextWrites() = 1000;
+    runFor(1100);
+    pulse(1);
+    runFor(1100);
+    TEST_ASSERT_TRUE(retentive().hasPendingCommit());
+    Preferences::failNextWrites() = 0;
+    engine->commitRetentive();
+    TEST_ASSERT_FALSE(retentive().hasPendingCommit());
+    TEST_ASSERT_EQUAL(2, Preferences::stats().writes);
+
+    reboot();
+    start();
+    TEST_ASSERT_EQUAL_INT16(4, memory().getValue<int16_t>("count"));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_values_survive_a_reboot);
+    RUN_TEST(test_stop_writes_pending_values);
+    RUN_TEST(test_changes_within_an_interval_are_one_write);
+    RUN_TEST(test_no_write_without_changes);
+    RUN_TEST(test_pages_alternate_and_a_torn_write_keeps_the_previous_values);
+    RUN_TEST(test_changed_program_keeps_matching_values);
+    RUN_TEST(test_write_rate_metrics);
+    RUN_TEST(test_failed_write_is_retried);
+    UNITY_END();
+    return 0;
+}
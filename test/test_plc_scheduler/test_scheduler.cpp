@@ -0,0 +1,179 @@
+#include <unity.h>
+#include "Engine/PlcCycleTimer.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+
+/**
+ * @brief Deadline scheduling tests
+ *
+ * Drives PlcCycleTimer the way PlcEngine::runDueCycles() does, with a
+ * manual clock so execution time and overruns are exact.
+ */
+
+ManualPlcClock* clock_ = nullptr;
+
+void setUp(void) {
+    clock_ = new ManualPlcClock();
+}
+
+void tearDown(void) {
+    delete clock_;
+}
+
+// One scan: wait for the deadline, run for execUs
+static void runCycle(PlcCycleTimer& timer, uint32_t execUs) {
+    clock_->sleepUntil(timer.getNextDeadline());
+    TEST_ASSERT_TRUE(timer.isDue(clock_->nowMicros()));
+    timer.beginCycle(clock_->nowMicros());
+    clock_->advance(execUs);
+    timer.endCycle(clock_->nowMicros());
+}
+
+void test_period_does_not_drift_with_execution_time() {
+    PlcCycleTimer timer;
+    timer.configure(10, PlcOverrunPolicy::SKIP);
+    timer.start(clock_->nowMicros());
+
+    for (int i = 0; i < 100; i++) {
+        runCycle(timer, 1000 + (i % 7) * 1000); // 1..7 ms
+    }
+
+    // 100 cycles started at 0, 10 ms, ..., 990 ms
+    TEST_ASSERT_EQUAL_UINT32(1000000, timer.getNextDeadline());
+    TEST_ASSERT_EQUAL_UINT32(100, timer.getStats().cycles);
+    TEST_ASSERT_EQUAL_UINT32(0, timer.getStats().overruns);
+    TEST_ASSERT_EQUAL_UINT32(1000, timer.getStats().minExecUs);
+    TEST_ASSERT_EQUAL_UINT32(7000, timer.getStats().maxExecUs);
+    TEST_ASSERT_EQUAL_UINT32(0, timer.getStats().maxJitterUs);
+}
+
+void test_skip_policy_drops_missed_deadlines() {
+    PlcCycleTimer timer;
+    timer.configure(10, PlcOverrunPolicy::SKIP);
+    timer.start(0);
+
+    runCycle(timer, 25000); // Ends at 25 ms: deadlines 10 and 20 ms are missed
+
+    TEST_ASSERT_EQUAL_UINT32(1, timer.getStats().overruns);
+    TEST_ASSERT_EQUAL_UINT32(2, timer.getStats().skippedCycles);
+    TEST_ASSERT_EQUAL_UINT32(30000, timer.getNextDeadline());
+    TEST_ASSERT_FALSE(timer.isDue(clock_->nowMicros()));
+
+    runCycle(timer, 1000);
+    TEST_ASSERT_EQUAL_UINT32(40000, timer.getNextDeadline());
+}
+
+void test_catch_up_policy_runs_missed_cycles() {
+    PlcCycleTimer timer;
+    timer.configure(10, PlcOverrunPolicy::CATCH_UP);
+    timer.start(0);
+
+    runCycle(timer, 25000);
+    TEST_ASSERT_EQUAL_UINT32(10000, timer.getNextDeadline());
+    TEST_ASSERT_TRUE(timer.isDue(clock_->nowMicros()));
+
+    // Short cycles run back to back until the schedule is met again
+    runCycle(timer, 1000);  // 25 -> 26 ms, next 20 ms
+    runCycle(timer, 1000);  // 26 -> 27 ms, next 30 ms
+    TEST_ASSERT_EQUAL_UINT32(30000, timer.getNextDeadline());
+    TEST_ASSERT_EQUAL_UINT32(0, timer.getStats().skippedCycles);
+    TEST_ASSERT_EQUAL_UINT32(3, timer.getStats().cycles);
+
+    // Late starts are reported as jitter
+    TEST_ASSERT_EQUAL_UINT32(15000, timer.getStats().maxJitterUs);
+}
+
+void test_catch_up_is_bounded() {
+    PlcCycleTimer timer;
+    timer.configure(10, PlcOverrunPolicy::CATCH_UP);
+    timer.start(0);
+
+    // Every scan takes 15 ms, so the program can never catch up
+    for (int i = 0; i <= PlcCycleTimer::MAX_CATCH_UP_CYCLES; i++) {
+        runCycle(timer, 15000);
+    }
+
+    TEST_ASSERT_TRUE(timer.getStats().skippedCycles > 0);
+    TEST_ASSERT_FALSE(timer.isDue(clock_->nowMicros()));
+}
+
+void test_jitter_histogram() {
+    PlcCycleTimer timer;
+    timer.configure(10, PlcOverrunPolicy::SKIP);
+    timer.start(0);
+
+    const uint32_t lateUs[] = {0, 50, 150, 300, 700, 1500, 3000, 7000, 20000};
+    for (uint32_t late : lateUs) {
+        clock_->sleepUntil(timer.getNextDeadline());
+        clock_->advance(late);
+        timer.beginCycle(clock_->nowMicros());
+        clock_->advance(100);
+        timer.endCycle(clock_->nowMicros());
+    }
+
+    const PlcCycleStats& stats = timer.getStats();
+    TEST_ASSERT_EQUAL_UINT32(2, stats.jitterHistogram[0]); // <= 100 us
+    for (uint8_t i = 1; i < PlcCycleStats::JITTER_BUCKETS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1, stats.jitterHistogram[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20000, stats.maxJitterUs);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.getAvgExecUs());
+}
+
+void test_two_programs_keep_their_own_period() {
+    PlcCycleTimer fast, slow;
+    fast.configure(10, PlcOverrunPolicy::SKIP);
+    slow.configure(50, PlcOverrunPolicy::SKIP);
+    fast.start(0);
+    slow.start(0);
+
+    // Scheduler loop: run due timers, sleep until the earliest deadline
+    PlcCycleTimer* timers[] = {&fast, &slow};
+    while (clock_->nowMicros() < 1000000) {
+        for (PlcCycleTimer* timer : timers) {
+            if (timer->isDue(clock_->nowMicros())) {
+                timer->beginCycle(clock_->nowMicros());
+                clock_->advance(500);
+                timer->endCycle(clock_->nowMicros());
+            }
+        }
+        uint32_t next = fast.getNextDeadline();
+        if (static_cast<int32_t>(slow.getNextDeadline() - next) < 0) {
+            next = slow.getNextDeadline();
+        }
+        clock_->sleepUntil(next);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(100, fast.getStats().cycles);
+    TEST_ASSERT_EQUAL_UINT32(20, slow.getStats().cycles);
+    TEST_ASSERT_EQUAL_UINT32(0, fast.getStats().overruns + slow.getStats().overruns);
+    // The slow program waits for the fast one when both are due
+    TEST_ASSERT_EQUAL_UINT32(500, slow.getStats().maxJitterUs);
+}
+
+void test_deadlines_survive_clock_wrap() {
+    PlcCycleTimer timer;
+    timer.configure(10, PlcOverrunPolicy::SKIP);
+    clock_->setTime(0xFFFFFFFFu - 15000);
+    timer.start(clock_->nowMicros());
+
+    for (int i = 0; i < 5; i++) {
+        runCycle(timer, 2000);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(5, timer.getStats().cycles);
+    TEST_ASSERT_EQUAL_UINT32(0, timer.getStats().overruns);
+    TEST_ASSERT_EQUAL_UINT32(2000, timer.getStats().maxExecUs);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_period_does_not_drift_with_execution_time);
+    RUN_TEST(test_skip_policy_drops_missed_deadlines);
+    RUN_TEST(test_catch_up_policy_runs_missed_cycles);
+    RUN_TEST(test_catch_up_is_bounded);
+    RUN_TEST(test_jitter_histogram);
+    RUN_TEST(test_two_programs_keep_their_own_period);
+    RUN_TEST(test_deadlines_survive_clock_wrap);
+    UNITY_END();
+    return 0;
+}
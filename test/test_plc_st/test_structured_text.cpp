@@ -0,0 +1,571 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "Engine/PlcStructuredText.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+#include "../lib/PlcTestHelpers/BenchTimer.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/**
+ * @brief Structured Text tests
+ *
+ * PlcStructuredText compiles an IEC 61131-3 ST subset (IF, CASE, FOR,
+ * WHILE, REPEAT, function block calls) to statements over the expression
+ * machine. A "language": "st" program loads through PlcEngine::loadProgram
+ * like a JSON one and gives the same results as the equivalent blocks.
+ */
+
+static PlcMemory* memory = nullptr;
+static PlcTimerWheel* wheel = nullptr;
+static PlcStructuredText* program = nullptr;
+
+static VarHandle resolve(void* context, const char* name, PlcValueType type) {
+    return static_cast<PlcMemory*>(context)->resolve(name, type);
+}
+
+static bool compile(const char* source, uint32_t maxIterations = PlcStructuredText::DEFAULT_MAX_ITERATIONS) {
+    PlcBlockContext context = {nullptr, nullptr, wheel};
+    return program->compile(source, *memory, resolve, resolve, memory, context, nullptr, maxIterations);
+}
+
+void setUp(void) {
+    memory = new PlcMemory();
+    wheel = new PlcTimerWheel();
+    program = new PlcStructuredText();
+}
+
+void tearDown(void) {
+    delete program;
+    delete wheel;
+    delete memory;
+}
+
+// JSON string literal of an ST source
+static std::string quote(const char* source) {
+    std::string json = "\"";
+    for (const char* p = source; *p; p++) {
+        if (*p == '\n') {
+            json += "\\n";
+        } else {
+            if (*p == '"' || *p == '\\') {
+                json += '\\';
+            }
+            json += *p;
+        }
+    }
+    return json + "\"";
+}
+
+void test_assignments_and_if() {
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        PROGRAM main
+        VAR
+            x : DINT := 5;
+            y : REAL;
+            flag : BOOL;
+        END_VAR
+        (* Branches in order, the first true one runs *)
+        IF x > 3 AND NOT flag THEN
+            y := x * 1.5;
+        ELSIF x = 0 THEN
+            y := -1;
+        ELSE
+            y := 0;
+        END_IF;
+        bits := 16#F0 OR 2#1010;
+        delay := T#1m30s + TIME#250ms;
+        END_PROGRAM
+    )"), program->getError());
+    TEST_ASSERT_EQUAL_INT32(5, memory->getValue<int32_t>("x"));
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_FLOAT(7.5f, memory->getValue<float>("y"));
+    TEST_ASSERT_EQUAL_INT32(0xFA, memory->getValue<int32_t>("bits"));
+    TEST_ASSERT_EQUAL_INT32(90250, memory->getValue<int32_t>("delay"));
+
+    memory->setValue<int32_t>("x", 0);
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, memory->getValue<float>("y"));
+    memory->setValue<int32_t>("x", 2);
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, memory->getValue<float>("y"));
+    memory->setValue<int32_t>("x", 5);
+    memory->setValue<bool>("flag", true);
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, memory->getValue<float>("y"));
+
+    // Undeclared targets take the type of their value
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::DINT), static_cast<int>(memory->findHandle("bits").type));
+}
+
+void test_case() {
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        CASE mode OF
+            0: out := 10;
+            1, 2: out := 20;
+            3..5, 9: out := 30;
+            -1: out := -5;
+        ELSE
+            out := 99;
+        END_CASE;
+    )"), program->getError());
+    const int32_t modes[] = {0, 1, 2, 3, 5, 9, -1, 6, -2};
+    const int32_t expected[] = {10, 20, 20, 30, 30, 30, -5, 99, 99};
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        memory->setValue<int32_t>("mode", modes[i]);
+        program->execute(*memory);
+        TEST_ASSERT_EQUAL_INT32(expected[i], memory->getValue<int32_t>("out"));
+    }
+}
+
+void test_loops() {
+    memory->declareVariable("n", PlcValueType::INT);
+    memory->setValue<int16_t>("n", 10);
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        sum := 0;
+        FOR i := 1 TO n DO
+            sum := sum + i;
+        END_FOR;
+        k := 0;
+        WHILE k < 10 DO
+            k := k + 3;
+        END_WHILE;
+        r := 1;
+        REPEAT
+            r := r * 2;
+        UNTIL r >= 100
+        END_REPEAT;
+        cnt := 0;
+        FOR j := 10 TO 0 BY -2 DO
+            cnt := cnt + 1;
+            IF j = 4 THEN
+                EXIT;
+            END_IF;
+        END_FOR;
+    )"), program->getError());
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_INT32(55, memory->getValue<int32_t>("sum"));
+    TEST_ASSERT_EQUAL_INT32(12, memory->getValue<int32_t>("k"));
+    TEST_ASSERT_EQUAL_INT32(128, memory->getValue<int32_t>("r"));
+    TEST_ASSERT_EQUAL_INT32(4, memory->getValue<int32_t>("cnt"));
+    TEST_ASSERT_EQUAL_INT32(4, memory->getValue<int32_t>("j"));
+    TEST_ASSERT_EQUAL_UINT32(0, program->getLoopLimitCount());
+
+    // The end value is read on every iteration
+    memory->setValue<int16_t>("n", 3);
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_INT32(6, memory->getValue<int32_t>("sum"));
+}
+
+void test_loops_are_capped() {
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        c := 0;
+        WHILE TRUE DO
+            c := c + 1;
+        END_WHILE;
+        d := 0;
+        REPEAT
+            d := d + 1;
+        UNTIL FALSE
+        END_REPEAT;
+        done := TRUE;
+    )", 50), program->getError());
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_INT32(50, memory->getValue<int32_t>("c"));
+    TEST_ASSERT_EQUAL_INT32(50, memory->getValue<int32_t>("d"));
+    TEST_ASSERT_TRUE(memory->getValue<bool>("done"));
+    TEST_ASSERT_EQUAL_UINT32(2, program->getLoopLimitCount());
+
+    // The count starts over on every scan
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_INT32(50, memory->getValue<int32_t>("c"));
+    TEST_ASSERT_EQUAL_UINT32(4, program->getLoopLimitCount());
+}
+
+void test_optimizer() {
+    // Shared subexpressions: x + y is computed once, until x changes
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        a := (x + y) * 2.0;
+        b := (x + y) * 3.0;
+        x := x + 1.0;
+        c := (x + y) * 4.0;
+    )"), program->getError());
+    TEST_ASSERT_EQUAL(1, program->getSharedCount());
+    memory->setValue<float>("x", 1.0f);
+    memory->setValue<float>("y", 2.0f);
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, memory->getValue<float>("a"));
+    TEST_ASSERT_EQUAL_FLOAT(9.0f, memory->getValue<float>("b"));
+    TEST_ASSERT_EQUAL_FLOAT(16.0f, memory->getValue<float>("c"));
+
+    // The selector of a CASE is computed once for all labels
+    memory->declareVariable("level", PlcValueType::DINT);
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        CASE level / 10 OF
+            0: band := 0;
+            1..3: band := 1;
+            4, 5: band := 2;
+        END_CASE;
+    )"), program->getError());
+    TEST_ASSERT_TRUE(program->getSharedCount() >= 2);
+    memory->setValue<int32_t>("level", 47);
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_INT32(2, memory->getValue<int32_t>("band"));
+
+    // Constant conditions: the dead branches are not compiled
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        VAR debug : BOOL; END_VAR
+        IF 1 > 2 THEN
+            z := 1;
+        ELSIF 2 * 3 = 6 THEN
+            z := 2 + 2 * 20;
+        ELSE
+            z := 3;
+        END_IF;
+        WHILE FALSE DO
+            z := 4;
+        END_WHILE;
+    )"), program->getError());
+    TEST_ASSERT_EQUAL(3, program->getDroppedBranchCount());
+    TEST_ASSERT_EQUAL(2, program->getInstructionCount()); // z := 42, END
+    TEST_ASSERT_EQUAL(1, program->getExpressionCount());
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_INT32(42, memory->getValue<int32_t>("z"));
+}
+
+void test_function_blocks() {
+    TEST_ASSERT_TRUE_MESSAGE(compile(R"(
+        VAR
+            delay : TON;
+            counter : CTU;
+            latch : SR;
+        END_VAR
+        delay(IN := start, PT := T#500ms);
+        counter(CU := pulse, RESET := clear, PV := 3, CV => count);
+        latch(SET := counter.Q, RESET := clear);
+        done := delay.Q;
+        alarm := latch.OUT;
+    )"), program->getError());
+    TEST_ASSERT_EQUAL(3, program->getInstanceCount());
+    TEST_ASSERT_EQUAL_STRING("counter", program->getInstanceName(1));
+    // Variables and constants passed the same way in every call are bound
+    // to the pins: three calls, two assignments and END are left
+    TEST_ASSERT_EQUAL(7, program->getBoundPinCount());
+    TEST_ASSERT_EQUAL(6, program->getInstructionCount());
+
+    wheel->advance(0);
+    memory->setValue<bool>("start", true);
+    program->execute(*memory);
+    wheel->advance(499);
+    program->execute(*memory);
+    TEST_ASSERT_FALSE(memory->getValue<bool>("done"));
+    wheel->advance(500);
+    program->execute(*memory);
+    TEST_ASSERT_TRUE(memory->getValue<bool>("done"));
+
+    for (int i = 0; i < 4; i++) {
+        memory->setValue<bool>("pulse", true);
+        program->execute(*memory);
+        memory->setValue<bool>("pulse", false);
+        program->execute(*memory);
+    }
+    TEST_ASSERT_EQUAL_INT32(3, memory->getValue<int32_t>("count"));
+    TEST_ASSERT_TRUE(memory->getValue<bool>("alarm"));
+    memory->setValue<bool>("clear", true);
+    program->execute(*memory);
+    TEST_ASSERT_EQUAL_INT32(0, memory->getValue<int32_t>("count"));
+    TEST_ASSERT_FALSE(memory->getValue<bool>("alarm"));
+
+    // Presets are constants of the block
+    TEST_ASSERT_FALSE(compile("VAR t : TON; END_VAR\nt(IN := a, PT := p);"));
+    TEST_ASSERT_FALSE(compile("VAR t : TON; END_VAR\nt(IN := a, PT := 100);\nt(IN := b, PT := 200);"));
+}
+
+void test_errors_report_their_line() {
+    memory->declareVariable("level", PlcValueType::REAL);
+    struct ErrorCase {
+        const char* source;
+        unsigned line;
+    };
+    const ErrorCase cases[] = {
+        {"x := 1;\ny := ;\n", 2},
+        {"x := 1;\ny := (2 + 3;\n", 2},
+        {"IF x THEN\n  y := 1;\n", 3},
+        {"x := 'text';", 1},
+        {"VAR a : FOO; END_VAR", 1},
+        {"VAR level : BOOL; END_VAR", 1},
+        {"\n\nEXIT;", 3},
+        {"FOR r := 1 TO 5 BY 0 DO\nEND_FOR;", 1},
+        {"VAR t : TON; END_VAR\nx := t;", 2},
+        {"VAR t : TON; END_VAR\nx := t.missing;", 2},
+        {"CASE x OF\n  1.5: y := 1;\nEND_CASE;", 2},
+        {"x := 1;\n(* open comment", 2},
+        {"x := 1 y := 2;", 1},
+    };
+    for (const ErrorCase& c : cases) {
+        TEST_ASSERT_FALSE_MESSAGE(compile(c.source), c.source);
+        TEST_ASSERT_TRUE_MESSAGE(strlen(program->getError()) > 0, c.source);
+        TEST_ASSERT_EQUAL_MESSAGE(c.line, program->getErrorLine(), c.source);
+        TEST_ASSERT_EQUAL(0, program->getInstructionCount());
+    }
+
+    // The program settings are checked when it is loaded
+    PlcProgram loaded("st", nullptr, nullptr);
+    TEST_ASSERT_FALSE(loaded.loadConfiguration(R"({"language": "st"})"));
+    TEST_ASSERT_FALSE(loaded.loadConfiguration(R"({"source": "x := 1;"})"));
+    TEST_ASSERT_FALSE(loaded.loadConfiguration(R"({"language": "cobol", "source": "x := 1;"})"));
+    TEST_ASSERT_FALSE(loaded.loadConfiguration(R"({"language": "st", "source": "x := ;"})"));
+}
+
+// ========== Through the engine ==========
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+static void startEngine() {
+    clock_ = new ManualPlcClock();
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+}
+
+static void stopEngine() {
+    delete engine;
+    delete clock_;
+    engine = nullptr;
+    clock_ = nullptr;
+}
+
+static void runFor(uint32_t ms) {
+    uint32_t end = clock_->nowMicros() + ms * 1000;
+    while (!PlcClock::reached(clock_->nowMicros(), end)) {
+        uint32_t next = engine->runDueCycles();
+        engine->waitUntil(PlcClock::reached(next, end) ? end : next);
+    }
+}
+
+void test_loaded_as_a_program() {
+    // Execution modes and tickless operation see the ST block like any other
+    const char* modes[] = {"cyclic", "incremental", "tickless"};
+    int32_t results[3][3];
+    for (int m = 0; m < 3; m++) {
+        startEngine();
+        engine->setTickless(m == 2);
+        std::string json = "{\"language\": \"st\", \"cycle_time_ms\": 10, \"execution\": \"";
+        json += m == 1 ? "incremental" : "cyclic";
+        json += "\", \"source\": [";
+        json += quote("VAR delay : TON; starts : CTU; END_VAR") + ",";
+        json += quote("delay(IN := start, PT := T#300ms, Q => on);") + ",";
+        json += quote("starts(CU := on, PV := 100, CV => count);") + ",";
+        json += quote("IF on THEN ticks := ticks + 1; END_IF;") + "]}";
+        TEST_ASSERT_TRUE_MESSAGE(engine->loadProgram("main", json.c_str()), modes[m]);
+        PlcProgram* main = engine->getProgram("main");
+        TEST_ASSERT_EQUAL(1, main->getBlockCount());
+        TEST_ASSERT_EQUAL_STRING("ST", main->getBlockType(0));
+        engine->runProgram("main");
+
+        const uint32_t toggles[] = {100, 700, 1000, 1250, 1400, 2000};
+        bool start = false;
+        for (uint32_t at : toggles) {
+            runFor(at - clock_->nowMicros() / 1000);
+            start = !start;
+            main->getMemory().postValue<bool>("start", start);
+        }
+        runFor(500);
+        results[m][0] = main->getMemory().getValue<int32_t>("count");
+        results[m][1] = main->getMemory().getValue<bool>("on");
+        results[m][2] = main->getMemory().getValue<int32_t>("ticks");
+        stopEngine();
+    }
+    TEST_ASSERT_EQUAL_INT32(2, results[0][0]); // The 250 ms pulse does not outlast the delay
+    TEST_ASSERT_TRUE(results[0][2] > 0);
+    for (int m = 1; m < 2; m++) {
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(results[0][0], results[m][0], modes[m]);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(results[0][1], results[m][1], modes[m]);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(results[0][2], results[m][2], modes[m]);
+    }
+    TEST_ASSERT_EQUAL_INT32(results[0][0], results[2][0]);
+    TEST_ASSERT_EQUAL_INT32(results[0][1], results[2][1]);
+}
+
+// A heater: scaled temperature, hysteresis latch, start counter and run timer
+static const char* HEATER_MEMORY = R"("memory": {"raw": {"type": "int"}, "setpoint": {"type": "real"},
+    "hyst": {"type": "real"}, "limit": {"type": "int"}, "clear": {"type": "bool"}},
+    "init": [{"action": "set_value", "variable": "hyst", "value": 2.5},
+             {"action": "set_value", "variable": "limit", "value": 5}],
+    "cycle_time_ms": 10)";
+
+static const char* HEATER_BLOCKS = R"("logic": [
+    {"block_type": "MUL", "inputs": ["raw", "k_scale"], "outputs": {"out": "scaled"}},
+    {"block_type": "ADD", "inputs": ["scaled", "k_offset"], "outputs": {"out": "temp"}},
+    {"block_type": "SUB", "inputs": {"in1": "setpoint", "in2": "temp"}, "outputs": {"out": "error"}},
+    {"block_type": "ADD", "inputs": ["setpoint", "hyst"], "outputs": {"out": "upper"}},
+    {"block_type": "LT", "inputs": {"in1": "temp", "in2": "setpoint"}, "outputs": {"out": "cold"}},
+    {"block_type": "GT", "inputs": {"in1": "temp", "in2": "upper"}, "outputs": {"out": "hot"}},
+    {"block_type": "SR", "inputs": {"set": "cold", "reset": "hot"}, "outputs": {"out": "heater"}},
+    {"block_type": "CTU", "inputs": {"cu": "heater", "reset": "clear", "pv": "limit"}, "outputs": {"q": "worn", "cv": "starts"}},
+    {"block_type": "TON", "inputs": {"in": "heater", "pt": 500}, "outputs": {"q": "long_run"}}
+])";
+
+static const char* HEATER_INIT = R"(, {"action": "set_value", "variable": "k_scale", "value": 0.1},
+    {"action": "set_value", "variable": "k_offset", "value": -5})";
+
+static const char* HEATER_ST = R"(VAR latch : SR; ctr : CTU; run : TON; END_VAR
+temp := raw * 0.1 + -5.0;
+error := setpoint - temp;
+latch(SET := temp < setpoint, RESET := temp > setpoint + hyst, OUT => heater);
+ctr(CU := heater, RESET := clear, PV := limit, Q => worn, CV => starts);
+run(IN := heater, PT := T#500ms, Q => long_run);
+)";
+
+static std::string heaterJson(bool st, const char* engineName = "bytecode") {
+    std::string json = "{\"engine\": \"";
+    json += engineName;
+    json += "\", ";
+    std::string memorySection = HEATER_MEMORY;
+    if (!st) {
+        // The blocks need the scale constants
+        size_t initEnd = memorySection.find("}],");
+        memorySection.insert(initEnd + 1, HEATER_INIT);
+        json += memorySection + ", " + HEATER_BLOCKS;
+    } else {
+        json += memorySection + ", \"language\": \"st\", \"source\": " + quote(HEATER_ST);
+    }
+    return json + "}";
+}
+
+static uint32_t rngState = 1;
+
+static uint32_t nextRandom() {
+    rngState = rngState * 1664525u + 1013904223u;
+    return rngState >> 8;
+}
+
+void test_matches_the_json_blocks() {
+    startEngine();
+    TEST_ASSERT_TRUE(engine->loadProgram("blocks", heaterJson(false).c_str()));
+    TEST_ASSERT_TRUE(engine->loadProgram("st", heaterJson(true).c_str()));
+    engine->runProgram("blocks");
+    engine->runProgram("st");
+    PlcMemory& blocks = engine->getProgram("blocks")->getMemory();
+    PlcMemory& st = engine->getProgram("st")->getMemory();
+
+    bool sawHeater = false, sawLongRun = false, sawWorn = false;
+    for (int i = 0; i < 300; i++) {
+        int16_t raw = static_cast<int16_t>(nextRandom() % 400);
+        float setpoint = static_cast<float>(nextRandom() % 20) + 10.0f;
+        bool clear = nextRandom() % 40 == 0;
+        for (PlcMemory* m : {&blocks, &st}) {
+            m->postValue<int16_t>("raw", raw);
+            m->postValue<float>("setpoint", setpoint);
+            m->postValue<bool>("clear", clear);
+        }
+        runFor(10 + nextRandom() % 300);
+        TEST_ASSERT_EQUAL_FLOAT(blocks.getValue<float>("temp"), st.getValue<float>("temp"));
+        TEST_ASSERT_EQUAL_FLOAT(blocks.getValue<float>("error"), st.getValue<float>("error"));
+        TEST_ASSERT_EQUAL(blocks.getValue<bool>("heater"), st.getValue<bool>("heater"));
+        TEST_ASSERT_EQUAL(blocks.getValue<bool>("worn"), st.getValue<bool>("worn"));
+        TEST_ASSERT_EQUAL(blocks.getValue<bool>("long_run"), st.getValue<bool>("long_run"));
+        TEST_ASSERT_EQUAL_INT32(blocks.getValue<int32_t>("starts"), st.getValue<int32_t>("starts"));
+        sawHeater |= st.getValue<bool>("heater");
+        sawLongRun |= st.getValue<bool>("long_run");
+        sawWorn |= st.getValue<bool>("worn");
+    }
+    TEST_ASSERT_TRUE(sawHeater && sawLongRun && sawWorn);
+    stopEngine();
+}
+
+// The heater logic without its timer, repeated for `copies` zones
+static std::string makeZonesJson(int copies, bool st, const char* engineName) {
+    std::string json = "{\"engine\": \"";
+    json += engineName;
+    char buffer[1024];
+    if (st) {
+        // Declarations come first
+        json += "\", \"language\": \"st\", \"source\": [\"VAR\"";
+        for (int i = 0; i < copies; i++) {
+            snprintf(buffer, sizeof(buffer), ",\"latch%d : SR; ctr%d : CTU;\"", i, i);
+            json += buffer;
+        }
+        json += ",\"END_VAR\"";
+    } else {
+        json += "\", \"logic\": [";
+    }
+    for (int i = 0; i < copies; i++) {
+        if (st) {
+            snprintf(buffer, sizeof(buffer),
+                     ",\"temp%d := raw%d * 0.1 + -5.0; error%d := setpoint - temp%d;\","
+                     "\"latch%d(SET := temp%d < setpoint, RESET := temp%d > setpoint + hyst, OUT => heater%d);\","
+                     "\"ctr%d(CU := heater%d, PV := 1000, CV => starts%d);\"",
+                     i, i, i, i, i, i, i, i, i, i, i);
+        } else {
+            snprintf(buffer, sizeof(buffer),
+                     "%s{\"block_type\": \"MUL\", \"inputs\": [\"raw%d\", \"k_scale\"], \"outputs\": {\"out\": \"scaled%d\"}},"
+                     "{\"block_type\": \"ADD\", \"inputs\": [\"scaled%d\", \"k_offset\"], \"outputs\": {\"out\": \"temp%d\"}},"
+                     "{\"block_type\": \"SUB\", \"inputs\": {\"in1\": \"setpoint\", \"in2\": \"temp%d\"}, \"outputs\": {\"out\": \"error%d\"}},"
+                     "{\"block_type\": \"ADD\", \"inputs\": [\"setpoint\", \"hyst\"], \"outputs\": {\"out\": \"upper%d\"}},"
+                     "{\"block_type\": \"LT\", \"inputs\": {\"in1\": \"temp%d\", \"in2\": \"setpoint\"}, \"outputs\": {\"out\": \"cold%d\"}},"
+                     "{\"block_type\": \"GT\", \"inputs\": {\"in1\": \"temp%d\", \"in2\": \"upper%d\"}, \"outputs\": {\"out\": \"hot%d\"}},"
+                     "{\"block_type\": \"SR\", \"inputs\": {\"set\": \"cold%d\", \"reset\": \"hot%d\"}, \"outputs\": {\"out\": \"heater%d\"}},"
+                     "{\"block_type\": \"CTU\", \"inputs\": {\"cu\": \"heater%d\", \"pv\": \"limit\"}, \"outputs\": {\"cv\": \"starts%d\"}}",
+                     i ? "," : "", i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i);
+        }
+        json += buffer;
+    }
+    json += "], \"init\": [{\"action\": \"set_value\", \"variable\": \"hyst\", \"value\": 2.5}";
+    if (!st) {
+        json += ", {\"action\": \"set_value\", \"variable\": \"k_scale\", \"value\": 0.1},"
+                "{\"action\": \"set_value\", \"variable\": \"k_offset\", \"value\": -5},"
+                "{\"action\": \"set_value\", \"variable\": \"limit\", \"value\": 1000}";
+    }
+    return json + "]}";
+}
+
+void test_benchmark_st_against_json_blocks() {
+    const int copies = 20;
+    const int cycles = 2000;
+    for (const char* engineName : {"blocks", "bytecode"}) {
+        unsigned long elapsed[2];
+        size_t configBytes[2];
+        int32_t starts[2];
+        for (int st = 0; st < 2; st++) {
+            std::string json = makeZonesJson(copies, st == 1, engineName);
+            configBytes[st] = json.size();
+            PlcProgram zones("bench", nullptr, nullptr);
+            TEST_ASSERT_TRUE(zones.loadConfiguration(json.c_str()));
+            TEST_ASSERT_EQUAL(st ? 1 : copies * 8, zones.getBlockCount());
+            zones.getMemory().setValue<float>("setpoint", 20.0f);
+            zones.run();
+            unsigned long start = benchMicros();
+            for (int i = 0; i < cycles; i++) {
+                zones.getMemory().setValue<int16_t>("raw0", static_cast<int16_t>(i % 400));
+                zones.evaluate();
+            }
+            elapsed[st] = benchMicros() - start;
+            starts[st] = zones.getMemory().getValue<int32_t>("starts0");
+        }
+        TEST_ASSERT_EQUAL_INT32(cycles / 400, starts[0]); // One heating period per ramp of raw0
+        TEST_ASSERT_EQUAL_INT32(starts[0], starts[1]);
+        // The arithmetic runs on the expression machine in both engines, so
+        // ST is close to the blocks engine and behind lowered bytecode; the
+        // gain is the size of the program and the control flow
+        printf("%-8s %d zones x %d cycles: JSON blocks %lu us (%u bytes of JSON), ST %lu us (%u bytes)\n",
+               engineName, copies, cycles, elapsed[0], (unsigned)configBytes[0], elapsed[1], (unsigned)configBytes[1]);
+        TEST_ASSERT_TRUE(configBytes[1] * 3 < configBytes[0]);
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_assignments_and_if);
+    RUN_TEST(test_case);
+    RUN_TEST(test_loops);
+    RUN_TEST(test_loops_are_capped);
+    RUN_TEST(test_optimizer);
+    RUN_TEST(test_function_blocks);
+    RUN_TEST(test_errors_report_their_line);
+    RUN_TEST(test_loaded_as_a_program);
+    RUN_TEST(test_matches_the_json_blocks);
+    RUN_TEST(test_benchmark_st_against_json_blocks);
+    UNITY_END();
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include <cstdlib>
+#include <new>
+#include <string>
+
+/**
+ * @brief String pool tests
+ *
+ * STRING values live in the fixed-size slots of the string pool. The string
+ * blocks work on them in place through PlcMemory::getText()/setString(), so
+ * a scan of a string-heavy program allocates nothing on the heap. The
+ * allocation counter below checks that: on glibc hosts it interposes
+ * malloc, calloc and realloc, which Arduino String and operator new both
+ * end up in; elsewhere it replaces operator new only.
+ */
+
+static bool countAllocations = false;
+static unsigned long allocations = 0;
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size) {
+    allocations += countAllocations ? 1 : 0;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    allocations += countAllocations ? 1 : 0;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+    allocations += countAllocations ? 1 : 0;
+    return __libc_realloc(p, size);
+}
+}
+#else
+void* operator new(size_t size) {
+    allocations += countAllocations ? 1 : 0;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::string withSettings(const char* config, const char* settings) {
+    std::string json = config;
+    json.insert(json.find('{') + 1, std::string(settings) + ", ");
+    return json;
+}
+
+// In place, unlike getValue<String>()
+static const char* text(const PlcMemory& memory, const char* name) {
+    const char* value = memory.getString(memory.findHandle(name));
+    return value ? value : "(not a string)";
+}
+
+static const char* ENGINES[] = {"\"engine\": \"bytecode\"", "\"engine\": \"blocks\"", "\"execution\": \"incremental\""};
+
+void test_string_access_in_place() {
+    PlcMemory memory;
+    TEST_ASSERT_TRUE(memory.declareVariable("name", PlcValueType::STRING_TYPE));
+    TEST_ASSERT_TRUE(memory.declareVariable("level", PlcValueType::INT));
+    TEST_ASSERT_TRUE(memory.declareVariable("ratio", PlcValueType::REAL));
+    VarHandle name = memory.findHandle("name");
+    VarHandle level = memory.findHandle("level");
+    VarHandle ratio = memory.findHandle("ratio");
+
+    TEST_ASSERT_TRUE(memory.setString(name, "pump 1"));
+    TEST_ASSERT_EQUAL_STRING("pump 1", memory.getString(name));
+    TEST_ASSERT_NULL(memory.getString(level));
+    TEST_ASSERT_EQUAL_STRING("pump 1", memory.getValue<String>(name).c_str());
+
+    // Numbers are rendered like getValue<String>()
+    char buffer[PLC_STRING_SIZE];
+    memory.setValue<int16_t>(level, -42);
+    memory.setValue<float>(ratio, 1.5f);
+    TEST_ASSERT_EQUAL_STRING("-42", memory.getText(level, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(4u, memory.printValue(ratio, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_STRING(memory.getValue<String>(ratio).c_str(), buffer);
+    TEST_ASSERT_EQUAL(2u, memory.printValue(name, buffer, 3)); // Truncated
+    TEST_ASSERT_EQUAL_STRING("pu", buffer);
+    TEST_ASSERT_EQUAL_STRING("", memory.getText(VarHandle(), buffer, sizeof(buffer)));
+
+    // Writes are truncated to the slot; the source may be the slot itself
+    std::string longText(PLC_STRING_SIZE + 10, 'x');
+    memory.setString(name, longText.c_str());
+    TEST_ASSERT_EQUAL(PLC_STRING_SIZE - 1, strlen(memory.getString(name)));
+    memory.setString(name, "abcdef");
+    memory.setString(name, memory.getString(name) + 2, 3);
+    TEST_ASSERT_EQUAL_STRING("cde", memory.getString(name));
+
+    // Numeric variables take the number the text starts with
+    memory.setString(level, "123 rpm", 7);
+    TEST_ASSERT_EQUAL_INT16(123, memory.getValue<int16_t>(level));
+
+    memory.setChangeTracking(true);
+    memory.clearChangedSlots();
+    memory.setString(level, "123", 3); // Unchanged number
+    TEST_ASSERT_EQUAL(0u, memory.getChangedSlots().size());
+    memory.setString(name, "pump 2");
+    TEST_ASSERT_EQUAL(1u, memory.getChangedSlots().size());
+}
+
+static const char* STRING_PROGRAM = R"({
+    "memory": {
+        "prefix": {"type": "string"}, "unit": {"type": "string"}, "format": {"type": "string"},
+        "label": {"type": "string"}, "line": {"type": "string"}, "tag": {"type": "string"},
+        "needle": {"type": "string"},
+        "count": {"type": "int"}, "total": {"type": "dint"}, "temp": {"type": "real"}, "on": {"type": "bool"}
+    },
+    "logic": [
+        {"block_type": "STRING_CONCAT", "inputs": ["prefix", "count", "unit"], "outputs": {"out": "label"}},
+        {"block_type": "STRING_FORMAT", "inputs": {"format_string": "format", "vars": ["prefix", "count", "temp", "total", "on", "total"]}, "outputs": {"out": "line"}},
+        {"block_type": "STRING_FIND", "inputs": {"string": "line", "substring": "needle"}, "outputs": {"index": "found"}},
+        {"block_type": "STRING_COPY", "inputs": {"source": "label", "start_index": 2, "length": 4}, "outputs": {"destination": "tag"}}
+    ]
+})";
+
+void test_string_blocks() {
+    for (const char* settings : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withSettings(STRING_PROGRAM, settings).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+        memory.setValue<String>("prefix", String("P-"));
+        memory.setValue<String>("unit", String(" pcs"));
+        memory.setValue<String>("format", String("%s|%03d|%6.1f|%x|%d|%-5u|100%%"));
+        memory.setValue<String>("needle", String("12.3"));
+        memory.setValue<int16_t>("count", 7);
+        memory.setValue<int32_t>("total", 255);
+        memory.setValue<float>("temp", 12.34f);
+        memory.setValue<bool>("on", true);
+        program.evaluate();
+
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("P-7 pcs", text(memory, "label"), settings);
+        TEST_ASSERT_EQUAL_STRING("P-|007|  12.3|ff|1|255  |100%", text(memory, "line"));
+        TEST_ASSERT_EQUAL_INT16(9, memory.getValue<int16_t>("found"));
+        TEST_ASSERT_EQUAL_STRING("7 pc", text(memory, "tag"));
+
+        // Missing values format as 0 or "", the result is cut at the slot size
+        memory.setValue<String>("format", String("%d/%d/%d/%d/%d/%d/%d|%s"));
+        memory.setValue<String>("needle", String("absent"));
+        memory.setValue<String>("prefix", String(std::string(PLC_STRING_SIZE, 'p').c_str()));
+        program.evaluate();
+        TEST_ASSERT_EQUAL_STRING("0/7/12/255/1/255/0|", text(memory, "line"));
+        TEST_ASSERT_EQUAL_INT16(-1, memory.getValue<int16_t>("found"));
+        TEST_ASSERT_EQUAL(PLC_STRING_SIZE - 1, strlen(text(memory, "label")));
+        TEST_ASSERT_EQUAL_STRING("pppp", text(memory, "tag"));
+    }
+}
+
+void test_string_copy_bounds() {
+    PlcProgram program("main", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(R"({
+        "memory": {"text": {"type": "string"}, "word": {"type": "string"}},
+        "logic": [
+            {"block_type": "STRING_COPY", "inputs": {"source": "text", "start_index": 3}, "outputs": {"destination": "tail"}},
+            {"block_type": "STRING_COPY", "inputs": {"source": "text", "start_index": 9, "length": 2}, "outputs": {"destination": "past"}},
+            {"block_type": "STRING_COPY", "inputs": {"source": "word", "start_index": 1, "length": 2}, "outputs": {"destination": "word"}}
+        ]
+    })"));
+    program.run();
+    PlcMemory& memory = program.getMemory();
+    memory.setValue<String>("text", String("abcdef"));
+    memory.setValue<String>("word", String("abcdef"));
+    program.evaluate();
+    TEST_ASSERT_EQUAL_STRING("def", text(memory, "tail"));
+    TEST_ASSERT_EQUAL_STRING("", text(memory, "past"));
+    TEST_ASSERT_EQUAL_STRING("bc", text(memory, "word")); // In place
+}
+
+void test_string_scans_do_not_allocate() {
+    for (const char* settings : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withSettings(STRING_PROGRAM, settings).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+        memory.setValue<String>("prefix", String("Tank "));
+        memory.setValue<String>("unit", String(" l"));
+        memory.setValue<String>("format", String("%s%d: %.2f C, total %ld (%s)"));
+        memory.setValue<String>("needle", String("total"));
+        VarHandle count = memory.findHandle("count");
+        VarHandle temp = memory.findHandle("temp");
+        VarHandle prefix = memory.findHandle("prefix");
+        for (int scan = 0; scan < 10; scan++) {
+            program.evaluate(); // Warm up
+        }
+
+        const char* prefixes[] = {"Tank ", "Silo ", "Pump "};
+        allocations = 0;
+        countAllocations = true;
+        for (int scan = 0; scan < 500; scan++) {
+            memory.setValue<int16_t>(count, static_cast<int16_t>(scan));
+            memory.setValue<float>(temp, scan * 0.25f);
+            memory.setString(prefix, prefixes[scan % 3]);
+            program.evaluate();
+        }
+        countAllocations = false;
+
+        printf("%-28s 500 scans: %lu heap allocations\n", settings, allocations);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocations, settings);
+        TEST_ASSERT_EQUAL_STRING("Silo 499 l", text(memory, "label"));
+        TEST_ASSERT_EQUAL_STRING("Silo 499: 124.75 C, total 0 (0)", text(memory, "line"));
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_string_access_in_place);
+    RUN_TEST(test_string_blocks);
+    RUN_TEST(test_string_copy_bounds);
+    RUN_TEST(test_string_scans_do_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,246 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "Engine/PlcProgramImage.h"
+#include "../../lib/Devices/DeviceRegistry.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+#include <vector>
+
+/**
+ * @brief Task class tests
+ *
+ * A program with "tasks" evaluates each class of blocks at its own period:
+ * a fast loop every millisecond next to logic that only needs a second.
+ * The program is scanned at the greatest common divisor of the periods and
+ * every class keeps its own cycle statistics.
+ */
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+void setUp(void) {
+    clock_ = new ManualPlcClock();
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+}
+
+void tearDown(void) {
+    delete engine;
+    delete clock_;
+}
+
+// Run the PLC task until `ms` of virtual time have passed
+static void runFor(uint32_t ms) {
+    uint32_t end = clock_->nowMicros() + ms * 1000;
+    while (!PlcClock::reached(clock_->nowMicros(), end)) {
+        uint32_t next = engine->runDueCycles();
+        engine->waitUntil(PlcClock::reached(next, end) ? end : next);
+    }
+}
+
+static PlcProgram* program() {
+    return engine->getProgram("main");
+}
+
+static int16_t count(const char* name) {
+    return program()->getMemory().getValue<int16_t>(name);
+}
+
+// One counter per class, and a snapshot of the fast counter taken by the slow class
+static String rateProgram(const char* engineName, const char* execution) {
+    String config = R"({
+        "memory": {
+            "fast_count": {"type": "int"},
+            "normal_count": {"type": "int"},
+            "slow_count": {"type": "int"},
+            "zero": {"type": "real"},
+            "snapshot": {"type": "real"}
+        },
+        "tasks": {
+            "slow": {"cycle_time_ms": 1000},
+            "fast": {"cycle_time_ms": 1, "priority": "high"}
+        },
+        "logic": [
+            {"block_type": "INC", "task": "slow", "inputs": {"in_out": "slow_count"}},
+            {"block_type": "ADD", "task": "slow", "inputs": ["fast_count", "zero"], "outputs": {"out": "snapshot"}},
+            {"block_type": "INC", "inputs": {"in_out": "normal_count"}},
+            {"block_type": "INC", "task": "fast", "inputs": {"in_out": "fast_count"}}
+        ],
+        "cycle_time_ms": 10,
+        "engine": ")";
+    config += engineName;
+    config += R"(", "execution": ")";
+    config += execution;
+    config += R"("})";
+    return config;
+}
+
+static void assertRates() {
+    // Deadlines at 0..999 ms: 1000 fast, 100 normal and 1 slow cycle
+    runFor(1000);
+    TEST_ASSERT_EQUAL_INT16(1000, count("fast_count"));
+    TEST_ASSERT_EQUAL_INT16(100, count("normal_count"));
+    TEST_ASSERT_EQUAL_INT16(1, count("slow_count"));
+
+    // The fast class runs first: at 1000 ms the slow class sees its 1001st count
+    runFor(1);
+    TEST_ASSERT_EQUAL_INT16(2, count("slow_count"));
+    TEST_ASSERT_EQUAL_FLOAT(1001.0f, program()->getMemory().getValue<float>("snapshot"));
+}
+
+void test_classes_run_at_their_own_period() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", rateProgram("bytecode", "cyclic").c_str()));
+    engine->runProgram("main");
+    assertRates();
+}
+
+void test_blocks_engine_runs_the_same_classes() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", rateProgram("blocks", "cyclic").c_str()));
+    engine->runProgram("main");
+    assertRates();
+}
+
+void test_incremental_execution_runs_the_same_classes() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", rateProgram("bytecode", "incremental").c_str()));
+    engine->runProgram("main");
+    assertRates();
+}
+
+void test_classes_are_ordered_by_period_and_keep_their_own_statistics() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", rateProgram("bytecode", "cyclic").c_str()));
+    TEST_ASSERT_EQUAL(3, program()->getTaskCount());
+    TEST_ASSERT_EQUAL_STRING("fast", program()->getTask(0).name);
+    TEST_ASSERT_EQUAL_STRING("default", program()->getTask(1).name);
+    TEST_ASSERT_EQUAL_STRING("slow", program()->getTask(2).name);
+    TEST_ASSERT_EQUAL_UINT32(1, program()->getCycleTimer().getCycleTimeMs()); // gcd(1, 10, 1000)
+
+    engine->runProgram("main");
+    runFor(1000);
+    TEST_ASSERT_EQUAL_UINT32(1000, program()->getTask(0).timer.getStats().cycles);
+    TEST_ASSERT_EQUAL_UINT32(100, program()->getTask(1).timer.getStats().cycles);
+    TEST_ASSERT_EQUAL_UINT32(1, program()->getTask(2).timer.getStats().cycles);
+    TEST_ASSERT_EQUAL_UINT32(1000, program()->getCycleTimer().getStats().cycles);
+
+    JsonDocument doc;
+    program()->getTask(2).toJson(doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL_STRING("slow", doc["name"]);
+    TEST_ASSERT_EQUAL_UINT32(1000, doc["cycle_time_ms"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_STRING("normal", doc["priority"]);
+    TEST_ASSERT_EQUAL_UINT32(2, doc["blocks"].as<uint32_t>());
+}
+
+void test_high_priority_class_raises_the_plc_task() {
+    TEST_ASSERT_FALSE(engine->isHighPriority());
+    TEST_ASSERT_TRUE(engine->loadProgram("main", rateProgram("bytecode", "cyclic").c_str()));
+    engine->runProgram("main");
+    runFor(1);
+    TEST_ASSERT_TRUE(program()->hasHighPriorityTask());
+    TEST_ASSERT_TRUE(engine->isHighPriority());
+
+    engine->stopProgram("main");
+    runFor(1);
+    TEST_ASSERT_FALSE(engine->isHighPriority());
+}
+
+void test_empty_classes_are_dropped_and_a_single_class_uses_its_period() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "memory": {"n": {"type": "int"}},
+        "tasks": {"fast": {"cycle_time_ms": 5}, "unused": {"cycle_time_ms": 3}},
+        "logic": [{"block_type": "INC", "task": "fast", "inputs": {"in_out": "n"}}],
+        "cycle_time_ms": 10
+    })"));
+    TEST_ASSERT_EQUAL(1, program()->getTaskCount());
+    TEST_ASSERT_EQUAL_UINT32(5, program()->getCycleTimer().getCycleTimeMs());
+
+    // Without the scheduler, evaluate() runs every class once
+    program()->run();
+    program()->evaluate();
+    TEST_ASSERT_EQUAL_INT16(1, count("n"));
+}
+
+void test_programs_without_tasks_have_no_classes() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "memory": {"n": {"type": "int"}},
+        "logic": [{"block_type": "INC", "inputs": {"in_out": "n"}}],
+        "cycle_time_ms": 10
+    })"));
+    TEST_ASSERT_EQUAL(0, program()->getTaskCount());
+    TEST_ASSERT_FALSE(program()->hasHighPriorityTask());
+    engine->runProgram("main");
+    runFor(100);
+    TEST_ASSERT_EQUAL_INT16(10, count("n"));
+}
+
+void test_invalid_tasks_fail_to_load() {
+    // Unknown task
+    TEST_ASSERT_FALSE(engine->loadProgram("main", R"({
+        "memory": {"n": {"type": "int"}},
+        "tasks": {"fast": {"cycle_time_ms": 1}},
+        "logic": [{"block_type": "INC", "task": "fats", "inputs": {"in_out": "n"}}]
+    })"));
+    // "default" names the blocks without a task
+    TEST_ASSERT_FALSE(engine->loadProgram("main", R"({
+        "tasks": {"default": {"cycle_time_ms": 1}},
+        "logic": []
+    })"));
+    // Period out of range, unknown priority
+    TEST_ASSERT_FALSE(engine->loadProgram("main", R"({"tasks": {"fast": {"cycle_time_ms": 0}}, "logic": []})"));
+    TEST_ASSERT_FALSE(engine->loadProgram("main", R"({"tasks": {"fast": {"cycle_time_ms": 100000}}, "logic": []})"));
+    TEST_ASSERT_FALSE(engine->loadProgram("main", R"({"tasks": {"fast": {"cycle_time_ms": 1, "priority": "urgent"}}, "logic": []})"));
+    // Too many
+    TEST_ASSERT_FALSE(engine->loadProgram("main", R"({"tasks": {
+        "t1": {"cycle_time_ms": 1}, "t2": {"cycle_time_ms": 2}, "t3": {"cycle_time_ms": 3},
+        "t4": {"cycle_time_ms": 4}, "t5": {"cycle_time_ms": 5}, "t6": {"cycle_time_ms": 6},
+        "t7": {"cycle_time_ms": 7}, "t8": {"cycle_time_ms": 8}, "t9": {"cycle_time_ms": 9}
+    }, "logic": []})"));
+    TEST_ASSERT_NULL(engine->getProgram("main"));
+}
+
+void test_image_keeps_the_tasks() {
+    std::vector<uint8_t> data;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(rateProgram("bytecode", "cyclic").c_str(), "main", data));
+
+    PlcProgramImage image;
+    TEST_ASSERT_TRUE(image.open(data.data(), data.size(), "main"));
+    TEST_ASSERT_EQUAL_UINT8(2, image.getTaskCount());
+    PlcProgramSource::Task slow = image.getTask(0);
+    TEST_ASSERT_EQUAL_STRING("slow", slow.name);
+    TEST_ASSERT_EQUAL_UINT32(1000, slow.cycleTimeMs);
+    TEST_ASSERT_FALSE(slow.highPriority);
+    PlcProgramSource::Task fast = image.getTask(1);
+    TEST_ASSERT_EQUAL_STRING("fast", fast.name);
+    TEST_ASSERT_EQUAL_UINT32(1, fast.cycleTimeMs);
+    TEST_ASSERT_TRUE(fast.highPriority);
+
+    TEST_ASSERT_TRUE(engine->loadProgramImage("main", data.data(), data.size()));
+    TEST_ASSERT_EQUAL(3, program()->getTaskCount());
+    engine->runProgram("main");
+    assertRates();
+}
+
+void test_online_change_keeps_the_class_deadlines() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", rateProgram("bytecode", "cyclic").c_str()));
+    engine->runProgram("main");
+    runFor(500);
+
+    TEST_ASSERT_TRUE(engine->onlineChange("main", rateProgram("bytecode", "cyclic").c_str()));
+    runFor(500);
+    TEST_ASSERT_FALSE(engine->isOnlineChangePending());
+    TEST_ASSERT_EQUAL_INT16(1000, count("fast_count"));
+    TEST_ASSERT_EQUAL_INT16(100, count("normal_count"));
+    TEST_ASSERT_EQUAL_INT16(1, count("slow_count")); // Not due again before 1000 ms
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_classes_run_at_their_own_period);
+    RUN_TEST(test_blocks_engine_runs_the_same_classes);
+    RUN_TEST(test_incremental_execution_runs_the_same_classes);
+    RUN_TEST(test_classes_are_ordered_by_period_and_keep_their_own_statistics);
+    RUN_TEST(test_high_priority_class_raises_the_plc_task);
+    RUN_TEST(test_empty_classes_are_dropped_and_a_single_class_uses_its_period);
+    RUN_TEST(test_programs_without_tasks_have_no_classes);
+    RUN_TEST(test_invalid_tasks_fail_to_load);
+    RUN_TEST(test_image_keeps_the_tasks);
+    RUN_TEST(test_online_change_keeps_the_class_deadlines);
+    return UNITY_END();
+}
@@ -0,0 +1,282 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "../../lib/Devices/DeviceRegistry.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+#include <cstdio>
+
+/**
+ * @brief Tickless mode tests
+ *
+ * A program that has settled is parked and the PLC task sleeps until the
+ * next timer expiry, or until a posted input or a device change wakes it.
+ * Results are the same as with cyclic polling, with far fewer wake-ups.
+ */
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+void setUp(void) {
+    clock_ = new ManualPlcClock();
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+}
+
+void tearDown(void) {
+    delete engine;
+    delete clock_;
+}
+
+// One pass of the PLC task
+static void step() {
+    engine->waitUntil(engine->runDueCycles());
+}
+
+// Run the PLC task until `ms` of virtual time have passed. The last
+// sleep ends there, as if the test posted from another task.
+static void runFor(uint32_t ms) {
+    uint32_t end = clock_->nowMicros() + ms * 1000;
+    while (!PlcClock::reached(clock_->nowMicros(), end)) {
+        uint32_t next = engine->runDueCycles();
+        engine->waitUntil(PlcClock::reached(next, end) ? end : next);
+    }
+}
+
+static PlcMemory& memory() {
+    return engine->getProgram("main")->getMemory();
+}
+
+static uint32_t wakeups() {
+    JsonDocument doc;
+    engine->getPowerJson(doc.to<JsonObject>());
+    return doc["wakeups"].as<uint32_t>();
+}
+
+static const char* DELAY_PROGRAM = R"({
+    "logic": [
+        {"block_type": "TON", "inputs": {"in": "start", "pt": 500}, "outputs": {"q": "on"}},
+        {"block_type": "NOT", "inputs": ["on"], "outputs": {"out": "off"}}
+    ],
+    "cycle_time_ms": 10
+})";
+
+void test_settled_program_sleeps_until_the_timer_expires() {
+    engine->setTickless(true);
+    TEST_ASSERT_TRUE(engine->loadProgram("main", DELAY_PROGRAM));
+    engine->runProgram("main");
+    runFor(100);
+    TEST_ASSERT_TRUE(engine->getProgram("main")->isParked());
+
+    // Ten seconds without inputs: a single wake-up at most
+    uint32_t before = wakeups();
+    runFor(10000);
+    TEST_ASSERT_TRUE(wakeups() - before <= 1);
+
+    // The input wakes the task, the next wake-up is the TON deadline
+    uint32_t posted = clock_->nowMicros();
+    memory().postValue<bool>("start", true);
+    step();
+    TEST_ASSERT_EQUAL_UINT32(posted, clock_->nowMicros()); // Scanned right away
+    before = wakeups();
+    uint32_t scanned = 0;
+    while (!memory().getValue<bool>("on")) {
+        scanned = clock_->nowMicros();
+        step();
+    }
+    TEST_ASSERT_EQUAL_UINT32(posted + 500000, scanned);
+    TEST_ASSERT_TRUE(wakeups() - before <= 3);
+    step();
+    TEST_ASSERT_FALSE(memory().getValue<bool>("off"));
+    TEST_ASSERT_EQUAL_UINT32(0, engine->getProgram("main")->getCycleTimer().getStats().maxJitterUs);
+}
+
+void test_same_results_as_cyclic_polling() {
+    const char* json = R"({
+        "logic": [
+            {"block_type": "TON", "inputs": {"in": "start", "pt": 300}, "outputs": {"q": "on", "et": "et"}},
+            {"block_type": "TOF", "inputs": {"in": "start", "pt": 200}, "outputs": {"q": "hold"}},
+            {"block_type": "CTU", "inputs": {"cu": "on", "pv": "limit"}, "outputs": {"cv": "count"}},
+            {"id": "seq", "block_type": "SEQUENCER", "steps": [
+                {"actions": [{"action": "set_value", "variable": "step", "value": 1}], "transition_condition": "on", "timeout_ms": 0},
+                {"actions": [{"action": "set_value", "variable": "step", "value": 2}], "transition_condition": "never", "timeout_ms": 150}
+            ]}
+        ],
+        "init": [{"action": "set_value", "variable": "limit", "value": 100}],
+        "cycle_time_ms": 10
+    })";
+    int32_t results[2][4];
+    uint32_t passes[2];
+    for (int run = 0; run < 2; run++) {
+        clock_->setTime(0);
+        delete engine;
+        engine = new PlcEngine(nullptr, nullptr);
+        engine->setClock(clock_);
+        engine->setTickless(run == 1);
+        TEST_ASSERT_TRUE(engine->loadProgram("main", json));
+        engine->runProgram("main");
+
+        // Input pulses at fixed times, posted between passes
+        const uint32_t toggles[] = {100, 700, 1000, 1900, 2000, 2150};
+        bool start = false;
+        for (uint32_t at : toggles) {
+            runFor(at - clock_->nowMicros() / 1000);
+            start = !start;
+            memory().postValue<bool>("start", start);
+        }
+        runFor(3000 - clock_->nowMicros() / 1000);
+        results[run][0] = memory().getValue<int16_t>("count");
+        results[run][1] = memory().getValue<int16_t>("step");
+        results[run][2] = memory().getValue<bool>("hold");
+        results[run][3] = memory().getValue<int32_t>("et");
+        passes[run] = wakeups();
+    }
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT32(results[0][i], results[1][i]);
+    }
+    TEST_ASSERT_EQUAL_INT32(2, results[1][0]);
+    TEST_ASSERT_EQUAL_INT32(1, results[1][1]);
+    printf("3 s of a timer program: %u wake-ups polling, %u tickless\n", (unsigned)passes[0], (unsigned)passes[1]);
+    TEST_ASSERT_TRUE(passes[1] * 2 < passes[0]); // ET keeps it scanning while the TON runs
+}
+
+void test_busy_programs_keep_their_cycle() {
+    engine->setTickless(true);
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "memory": {"acc": {"type": "real"}, "one": {"type": "real"}},
+        "logic": [{"block_type": "ADD", "inputs": ["acc", "one"], "outputs": {"out": "acc"}}],
+        "init": [{"action": "set_value", "variable": "one", "value": 1.0}],
+        "cycle_time_ms": 10
+    })"));
+    engine->runProgram("main");
+    runFor(1000);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, memory().getValue<float>("acc"));
+    TEST_ASSERT_FALSE(engine->getProgram("main")->isParked());
+
+    // ET counts on every cycle while the timer runs, then the program parks
+    TEST_ASSERT_TRUE(engine->loadProgram("timer", R"({
+        "logic": [{"block_type": "TON", "inputs": {"in": "start", "pt": 200}, "outputs": {"q": "q", "et": "et"}}],
+        "init": [{"action": "set_value", "variable": "start", "value": true}],
+        "cycle_time_ms": 10
+    })"));
+    engine->stopProgram("main");
+    engine->runProgram("timer");
+    PlcProgram* timer = engine->getProgram("timer");
+    runFor(100);
+    TEST_ASSERT_FALSE(timer->isParked());
+    TEST_ASSERT_EQUAL_INT32(90, timer->getMemory().getValue<int32_t>("et"));
+    runFor(200);
+    TEST_ASSERT_TRUE(timer->getMemory().getValue<bool>("q"));
+    TEST_ASSERT_TRUE(timer->isParked());
+}
+
+void test_device_changes_and_wake_end_the_sleep() {
+    engine->setTickless(true);
+    engine->begin(); // Registers with DeviceRegistry
+    TEST_ASSERT_TRUE(engine->loadProgram("main", DELAY_PROGRAM));
+    engine->runProgram("main");
+    runFor(100);
+
+    Endpoint endpoint;
+    endpoint.fullName = "garage.mesh.node1.door.bool";
+    DeviceRegistry& registry = DeviceRegistry::getInstance();
+    registry.registerEndpoint(endpoint);
+    PlcValue value(PlcValueType::BOOL);
+    value.value.bVal = true;
+
+    JsonDocument doc;
+    engine->getPowerJson(doc.to<JsonObject>());
+    uint32_t events = doc["event_wakeups"];
+    uint32_t now = clock_->nowMicros();
+    registry.updateEndpointValue(endpoint.fullName, value);
+    step(); // Scanned right away, then parked again without sleeping
+    engine->wake();
+    step();
+    TEST_ASSERT_EQUAL_UINT32(now, clock_->nowMicros());
+
+    engine->getPowerJson(doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL_UINT32(events + 2, doc["event_wakeups"].as<uint32_t>());
+    TEST_ASSERT_TRUE(doc["tickless"].as<bool>());
+    TEST_ASSERT_TRUE(doc["idle_share"].as<float>() > 0.99f);
+    registry.clear();
+
+    // Turning tickless mode off resumes cyclic scans
+    engine->setTickless(false);
+    step();
+    TEST_ASSERT_FALSE(engine->getProgram("main")->isParked());
+}
+
+void test_time_compare_sees_its_second_near_a_boundary() {
+    engine->setTickless(true);
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "logic": [{"block_type": "TIME_COMPARE", "time": {"hour": 12, "minute": 0, "second": 5}, "outputs": {"out": "match"}}],
+        "cycle_time_ms": 10
+    })"));
+    engine->runProgram("main");
+    runFor(5);
+    clock_->setLocalTime(1767268800); // 2026-01-01 12:00:00 UTC: the seconds start 5 ms after whole clock seconds
+
+    // Each wake-up comes 3 ms after the expiry, so the block, armed at
+    // 12:00:00.998 for five seconds, runs next at 12:00:06.001
+    const PlcCycleContext& context = engine->getProgram("main")->getCycleContext();
+    uint32_t cycle = context.getCycle();
+    uint32_t before = wakeups();
+    uint32_t matches = 0;
+    uint32_t end = clock_->nowMicros() + 8000000;
+    while (!PlcClock::reached(clock_->nowMicros(), end)) {
+        uint32_t next = engine->runDueCycles();
+        if (context.getCycle() != cycle) {
+            cycle = context.getCycle();
+            struct tm scanTime;
+            TEST_ASSERT_TRUE(context.getLocalTime(scanTime));
+            bool match = memory().getValue<bool>("match");
+            TEST_ASSERT_EQUAL(scanTime.tm_sec == 5, match);
+            matches += match ? 1 : 0;
+        }
+        engine->waitUntil(next);
+        clock_->advance(3000);
+    }
+    TEST_ASSERT_TRUE(matches > 0);
+    TEST_ASSERT_FALSE(memory().getValue<bool>("match"));
+    printf("TIME_COMPARE over 8 s: %u wake-ups\n", (unsigned)(wakeups() - before));
+    TEST_ASSERT_TRUE(wakeups() - before < 30);
+}
+
+void test_next_expiry_of_the_timer_wheel() {
+    PlcTimerWheel wheel;
+    uint32_t delay;
+    TEST_ASSERT_FALSE(wheel.nextExpiry(delay));
+    wheel.advance(1000);
+    PlcTimer timers[4];
+    const uint32_t delays[] = {70000, 300, 5000, 17};
+    for (int i = 0; i < 4; i++) {
+        wheel.arm(timers[i], delays[i]);
+    }
+    const uint32_t expected[] = {17, 300, 5000, 70000};
+    for (uint32_t next : expected) {
+        TEST_ASSERT_TRUE(wheel.nextExpiry(delay));
+        TEST_ASSERT_EQUAL_UINT32(next - (wheel.now() - 1000), delay);
+        TEST_ASSERT_EQUAL(1, wheel.advance(wheel.now() + delay));
+    }
+    TEST_ASSERT_FALSE(wheel.nextExpiry(delay));
+
+    // In clock microseconds, from the last reading and the sub-millisecond rest
+    wheel.advanceMicros(5000000);
+    wheel.advanceMicros(5000400);
+    wheel.arm(timers[0], 10);
+    uint32_t deadline;
+    TEST_ASSERT_TRUE(wheel.nextExpiryMicros(deadline));
+    TEST_ASSERT_EQUAL_UINT32(5010000, deadline);
+    TEST_ASSERT_EQUAL(0, wheel.advanceMicros(deadline - 1));
+    TEST_ASSERT_EQUAL(1, wheel.advanceMicros(deadline));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_settled_program_sleeps_until_the_timer_expires);
+    RUN_TEST(test_same_results_as_cyclic_polling);
+    RUN_TEST(test_busy_programs_keep_their_cycle);
+    RUN_TEST(test_device_changes_and_wake_end_the_sleep);
+    RUN_TEST(test_time_compare_sees_its_second_near_a_boundary);
+    RUN_TEST(test_next_expiry_of_the_timer_wheel);
+    UNITY_END();
+    return 0;
+}
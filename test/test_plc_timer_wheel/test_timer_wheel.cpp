@@ -0,0 +1,243 @@
+#include <unity.h>
+#include "Engine/PlcEngine.h"
+#include "Engine/PlcTimerWheel.h"
+#include "../lib/PlcTestHelpers/ManualPlcClock.h"
+#include <cstdlib>
+#include <vector>
+
+/**
+ * @brief Timer wheel tests
+ *
+ * Timers expire on the first advance() that reaches their deadline, on
+ * every level of the wheel and across the 32-bit wrap-around. In a
+ * program, the engine advances the wheel once per cycle on virtual time,
+ * so TON, TOF, TP and sequencer timeouts are exact and deterministic.
+ */
+
+struct Expiry {
+    PlcTimerWheel* wheel;
+    std::vector<uint32_t> times; // Wheel time each timer expired at, by block index
+};
+
+static void recordExpiry(void* context, PlcTimer& timer) {
+    Expiry* expiry = static_cast<Expiry*>(context);
+    expiry->times[timer.getBlock()] = expiry->wheel->now();
+}
+
+static ManualPlcClock* clock_ = nullptr;
+static PlcEngine* engine = nullptr;
+
+void setUp(void) {
+    clock_ = new ManualPlcClock();
+    engine = new PlcEngine(nullptr, nullptr);
+    engine->setClock(clock_);
+}
+
+void tearDown(void) {
+    delete engine;
+    delete clock_;
+}
+
+// One pass of the PLC task
+static void step() {
+    clock_->sleepUntil(engine->runDueCycles());
+}
+
+// Run the PLC task until `ms` of virtual time have passed
+static void runFor(uint32_t ms) {
+    uint32_t end = clock_->nowMicros() + ms * 1000;
+    while (!PlcClock::reached(clock_->nowMicros(), end)) {
+        step();
+    }
+}
+
+static PlcMemory& memory() {
+    return engine->getProgram("main")->getMemory();
+}
+
+void test_timers_expire_at_their_deadline_on_every_level() {
+    const uint32_t delays[] = {1, 2, 15, 16, 17, 255, 256, 4095, 4096, 65535, 65536, 70000, 1000000, 50000000};
+    const size_t count = sizeof(delays) / sizeof(delays[0]);
+    for (uint32_t start : {0u, 12345u, 0xFFFFFFF0u}) { // The last one wraps around
+        PlcTimerWheel wheel;
+        Expiry expiry = {&wheel, std::vector<uint32_t>(count, 0)};
+        wheel.setExpiryHandler(recordExpiry, &expiry);
+        wheel.advance(start / 2); // Less than 2^31 ms at a time
+        wheel.advance(start);
+        std::vector<PlcTimer> timers(count);
+        for (size_t i = 0; i < count; i++) {
+            timers[i].setBlock(static_cast<uint16_t>(i));
+            wheel.arm(timers[i], delays[i]);
+        }
+        TEST_ASSERT_EQUAL(count, wheel.getArmedCount());
+
+        // Unevenly sized steps, never past the next deadline
+        for (size_t i = 0; i < count; i++) {
+            wheel.advance(start + delays[i] - 1);
+            TEST_ASSERT_TRUE(timers[i].isRunning());
+            TEST_ASSERT_EQUAL_UINT32(delays[i] - 1, wheel.elapsed(timers[i]));
+            wheel.advance(start + delays[i]);
+            TEST_ASSERT_TRUE(timers[i].hasExpired());
+            TEST_ASSERT_EQUAL_UINT32(start + delays[i], expiry.times[i]);
+            TEST_ASSERT_EQUAL_UINT32(delays[i], wheel.elapsed(timers[i]));
+        }
+        TEST_ASSERT_EQUAL(0, wheel.getArmedCount());
+    }
+}
+
+void test_random_timers_match_a_plain_list() {
+    PlcTimerWheel wheel;
+    const size_t count = 500;
+    Expiry expiry = {&wheel, std::vector<uint32_t>(count, 0)};
+    wheel.setExpiryHandler(recordExpiry, &expiry);
+    std::vector<PlcTimer> timers(count);
+    std::vector<uint32_t> deadlines(count);
+    std::vector<bool> running(count, false);
+    for (size_t i = 0; i < count; i++) {
+        timers[i].setBlock(static_cast<uint16_t>(i));
+    }
+
+    srand(7);
+    uint32_t now = 0;
+    for (int round = 0; round < 5000; round++) {
+        // Arm, re-arm or disarm a few timers, then move on
+        for (int j = 0; j < 3; j++) {
+            size_t i = rand() % count;
+            if (rand() % 4 == 0) {
+                wheel.disarm(timers[i]);
+                running[i] = false;
+            } else {
+                uint32_t delay = 1 + (rand() % 3 == 0 ? rand() % 200000 : rand() % 300);
+                wheel.arm(timers[i], delay);
+                deadlines[i] = now + delay;
+                running[i] = true;
+            }
+        }
+        now += rand() % 100;
+        wheel.advance(now);
+
+        size_t armed = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!running[i]) {
+                continue;
+            }
+            if (PlcClock::reached(now, deadlines[i])) {
+                TEST_ASSERT_TRUE(timers[i].hasExpired());
+                TEST_ASSERT_EQUAL_UINT32(deadlines[i], expiry.times[i]);
+                running[i] = false;
+            } else {
+                TEST_ASSERT_TRUE(timers[i].isRunning());
+                armed++;
+            }
+        }
+        TEST_ASSERT_EQUAL(armed, wheel.getArmedCount());
+    }
+}
+
+void test_idle_timer_blocks_are_not_evaluated() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "execution": "incremental",
+        "logic": [
+            {"block_type": "TON", "inputs": {"in": "start", "pt": 250}, "outputs": {"q": "on"}},
+            {"block_type": "TOF", "inputs": {"in": "start", "pt": 100}, "outputs": {"q": "off_delayed"}},
+            {"block_type": "TP", "inputs": {"in": "start", "pt": 50}, "outputs": {"q": "pulse"}}
+        ],
+        "cycle_time_ms": 10
+    })"));
+    engine->runProgram("main");
+    PlcProgram* program = engine->getProgram("main");
+    step();
+    runFor(1000);
+    TEST_ASSERT_EQUAL(0, program->getLastEvaluatedBlockCount());
+
+    // Rising edge: TON and TP start, TOF follows the input
+    memory().postValue<bool>("start", true);
+    step();
+    TEST_ASSERT_EQUAL(3, program->getLastEvaluatedBlockCount());
+    TEST_ASSERT_TRUE(memory().getValue<bool>("pulse"));
+    TEST_ASSERT_TRUE(memory().getValue<bool>("off_delayed"));
+    runFor(40);
+    TEST_ASSERT_EQUAL(0, program->getLastEvaluatedBlockCount());
+    TEST_ASSERT_TRUE(memory().getValue<bool>("pulse"));
+    runFor(10);
+    TEST_ASSERT_FALSE(memory().getValue<bool>("pulse")); // 50 ms
+    TEST_ASSERT_FALSE(memory().getValue<bool>("on"));
+    runFor(190);
+    TEST_ASSERT_FALSE(memory().getValue<bool>("on"));
+    runFor(10);
+    TEST_ASSERT_TRUE(memory().getValue<bool>("on")); // 250 ms
+
+    // Falling edge: TOF holds its output for 100 ms
+    memory().postValue<bool>("start", false);
+    step();
+    TEST_ASSERT_FALSE(memory().getValue<bool>("on"));
+    TEST_ASSERT_TRUE(memory().getValue<bool>("off_delayed"));
+    runFor(90);
+    TEST_ASSERT_TRUE(memory().getValue<bool>("off_delayed"));
+    runFor(10);
+    TEST_ASSERT_FALSE(memory().getValue<bool>("off_delayed"));
+    TEST_ASSERT_EQUAL(0, program->getTimers().getArmedCount());
+}
+
+void test_elapsed_time_is_read_once_per_cycle() {
+    TEST_ASSERT_TRUE(engine->loadProgram("main", R"({
+        "logic": [{"block_type": "TON", "inputs": {"in": "start", "pt": 1000}, "outputs": {"q": "q", "et": "et"}}],
+        "init": [{"action": "set_value", "variable": "start", "value": true}],
+        "cycle_time_ms": 10
+    })"));
+    engine->runProgram("main");
+    runFor(500);
+    step(); // Scans at 500 ms; ET is the time at the start of the cycle
+    TEST_ASSERT_EQUAL_INT32(500, memory().getValue<int32_t>("et"));
+    TEST_ASSERT_FALSE(memory().getValue<bool>("q"));
+    runFor(600);
+    TEST_ASSERT_TRUE(memory().getValue<bool>("q"));
+    TEST_ASSERT_EQUAL_INT32(1000, memory().getValue<int32_t>("et"));
+}
+
+void test_sequencer_timeout_and_online_change() {
+    const char* json = R"({
+        "logic": [
+            {"id": "seq", "block_type": "SEQUENCER", "steps": [
+                {"actions": [{"action": "set_value", "variable": "step", "value": 1}], "transition_condition": "never", "timeout_ms": 300},
+                {"actions": [{"action": "set_value", "variable": "step", "value": 2}], "transition_condition": "never", "timeout_ms": 200}
+            ]},
+            {"id": "delay", "block_type": "TON", "inputs": {"in": "start", "pt": 500}, "outputs": {"q": "q"}}
+        ],
+        "init": [{"action": "set_value", "variable": "start", "value": true}],
+        "cycle_time_ms": 10
+    })";
+    TEST_ASSERT_TRUE(engine->loadProgram("main", json));
+    engine->runProgram("main");
+    step();
+    runFor(290);
+    TEST_ASSERT_EQUAL_INT16(1, memory().getValue<int16_t>("step"));
+    runFor(10); // The step changes at 300 ms, its actions run on the next scan
+    step();
+    TEST_ASSERT_EQUAL_INT16(2, memory().getValue<int16_t>("step"));
+
+    // The new version continues both timers where the old one was
+    TEST_ASSERT_TRUE(engine->onlineChange("main", json));
+    step();
+    TEST_ASSERT_FALSE(engine->isOnlineChangePending());
+    TEST_ASSERT_EQUAL(2, engine->getProgram("main")->getTimers().getArmedCount());
+    runFor(170);
+    TEST_ASSERT_FALSE(memory().getValue<bool>("q"));
+    runFor(10);
+    TEST_ASSERT_TRUE(memory().getValue<bool>("q")); // 500 ms
+    step(); // The second step started at 310 ms and times out at 510 ms
+    TEST_ASSERT_EQUAL_INT16(2, memory().getValue<int16_t>("step"));
+    step();
+    TEST_ASSERT_EQUAL_INT16(1, memory().getValue<int16_t>("step"));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_timers_expire_at_their_deadline_on_every_level);
+    RUN_TEST(test_random_timers_match_a_plain_list);
+    RUN_TEST(test_idle_timer_blocks_are_not_evaluated);
+    RUN_TEST(test_elapsed_time_is_read_once_per_cycle);
+    RUN_TEST(test_sequencer_timeout_and_online_change);
+    UNITY_END();
+    return 0;
+}
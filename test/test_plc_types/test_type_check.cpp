@@ -0,0 +1,193 @@
+#include <unity.h>
+#include "Engine/PlcProgram.h"
+#include "Engine/PlcProgramImage.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Operand type tests
+ *
+ * Arithmetic and comparison blocks resolve their operand types at load.
+ * Operands declared INT, DINT or REAL compute in that type in both engines
+ * (integers wrap, DINT keeps all 32 bits); mixed operands are converted
+ * through REAL unless the program asks for "strict_types", which rejects
+ * them with an error instead.
+ */
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::string withEngine(const char* config, const char* engineName) {
+    std::string json = config;
+    json.insert(json.find('{') + 1, std::string("\"engine\": \"") + engineName + "\", ");
+    return json;
+}
+
+static const char* ENGINES[] = {"bytecode", "blocks"};
+
+static const char* INT_PROGRAM = R"({
+    "memory": {
+        "a": {"type": "int"}, "b": {"type": "int"},
+        "sum": {"type": "int"}, "quotient": {"type": "int"}, "greater": {"type": "bool"}
+    },
+    "logic": [
+        {"block_type": "ADD", "inputs": ["a", "b"], "outputs": {"out": "sum"}},
+        {"block_type": "DIV", "inputs": ["a", "b"], "outputs": {"out": "quotient"}},
+        {"block_type": "GT", "inputs": {"in1": "a", "in2": "b"}, "outputs": {"out": "greater"}}
+    ]
+})";
+
+static void evaluateInts(PlcProgram& program, int16_t a, int16_t b) {
+    program.getMemory().setValue<int16_t>("a", a);
+    program.getMemory().setValue<int16_t>("b", b);
+    program.evaluate();
+}
+
+void test_int_operands_compute_in_int() {
+    for (const char* engineName : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withEngine(INT_PROGRAM, engineName).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+
+        evaluateInts(program, -7, 2);
+        TEST_ASSERT_EQUAL_INT16(-5, memory.getValue<int16_t>("sum"));
+        TEST_ASSERT_EQUAL_INT16(-3, memory.getValue<int16_t>("quotient")); // Truncated toward zero
+        TEST_ASSERT_FALSE(memory.getValue<bool>("greater"));
+
+        evaluateInts(program, 30000, 10000);
+        TEST_ASSERT_EQUAL_INT16(-25536, memory.getValue<int16_t>("sum")); // Wraps around
+        TEST_ASSERT_TRUE(memory.getValue<bool>("greater"));
+
+        evaluateInts(program, 5, 0);
+        TEST_ASSERT_EQUAL_INT16(0, memory.getValue<int16_t>("quotient"));
+    }
+}
+
+void test_dint_operands_keep_every_bit() {
+    // 2^24 + 1 is not a float: through REAL the sum would be 16777216
+    for (const char* engineName : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withEngine(R"({
+            "memory": {
+                "a": {"type": "dint"}, "b": {"type": "dint"}, "sum": {"type": "dint"},
+                "product": {"type": "dint"}, "equal": {"type": "bool"}
+            },
+            "logic": [
+                {"block_type": "ADD", "inputs": ["a", "b"], "outputs": {"out": "sum"}},
+                {"block_type": "MUL", "inputs": ["a", "b"], "outputs": {"out": "product"}},
+                {"block_type": "EQ", "inputs": {"in1": "sum", "in2": "a"}, "outputs": {"out": "equal"}}
+            ]
+        })", engineName).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+
+        memory.setValue<int32_t>("a", 16777217);
+        memory.setValue<int32_t>("b", 1);
+        program.evaluate();
+        TEST_ASSERT_EQUAL_INT32(16777218, memory.getValue<int32_t>("sum"));
+        TEST_ASSERT_EQUAL_INT32(16777217, memory.getValue<int32_t>("product"));
+        TEST_ASSERT_FALSE(memory.getValue<bool>("equal"));
+    }
+}
+
+void test_mixed_operands_are_converted() {
+    for (const char* engineName : ENGINES) {
+        PlcProgram program("main", nullptr, nullptr);
+        TEST_ASSERT_TRUE(program.loadConfiguration(withEngine(R"({
+            "memory": {"count": {"type": "int"}, "gain": {"type": "real"}, "level": {"type": "int"}},
+            "logic": [
+                {"block_type": "MUL", "inputs": ["count", "gain"], "outputs": {"out": "scaled"}},
+                {"block_type": "ADD", "inputs": ["count", "gain"], "outputs": {"out": "level"}}
+            ]
+        })", engineName).c_str()));
+        program.run();
+        PlcMemory& memory = program.getMemory();
+
+        memory.setValue<int16_t>("count", 3);
+        memory.setValue<float>("gain", 0.5f);
+        program.evaluate();
+        TEST_ASSERT_EQUAL_FLOAT(1.5f, memory.getValue<float>("scaled"));
+        TEST_ASSERT_EQUAL_INT16(3, memory.getValue<int16_t>("level")); // 3.5 stored in an INT
+    }
+}
+
+void test_new_variables_are_real_unless_strict() {
+    const char* chain = R"({
+        "memory": {"a": {"type": "int"}, "b": {"type": "int"}},
+        "logic": [
+            {"block_type": "ADD", "inputs": ["a", "b"], "outputs": {"out": "total"}},
+            {"block_type": "SUB", "inputs": ["total", "offset"], "outputs": {"out": "net"}}
+        ]
+    })";
+    PlcProgram program("main", nullptr, nullptr);
+    TEST_ASSERT_TRUE(program.loadConfiguration(chain));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::REAL), static_cast<int>(program.getMemory().findHandle("total").type));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::REAL), static_cast<int>(program.getMemory().findHandle("net").type));
+
+    // Strict programs declare them with the working type, so the chain stays INT
+    std::string strict = chain;
+    strict.insert(strict.find('{') + 1, "\"strict_types\": true, ");
+    TEST_ASSERT_TRUE(program.loadConfiguration(strict.c_str()));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::INT), static_cast<int>(program.getMemory().findHandle("total").type));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::INT), static_cast<int>(program.getMemory().findHandle("offset").type));
+    TEST_ASSERT_EQUAL(static_cast<int>(PlcValueType::INT), static_cast<int>(program.getMemory().findHandle("net").type));
+}
+
+void test_strict_types_reject_mismatched_operands() {
+    PlcProgram program("main", nullptr, nullptr);
+    // INT and REAL inputs
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "strict_types": true,
+        "memory": {"count": {"type": "int"}, "gain": {"type": "real"}},
+        "logic": [{"block_type": "MUL", "inputs": ["count", "gain"], "outputs": {"out": "scaled"}}]
+    })"));
+    // A BOOL input
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "strict_types": true,
+        "memory": {"count": {"type": "int"}, "enable": {"type": "bool"}},
+        "logic": [{"block_type": "ADD", "inputs": ["count", "enable"], "outputs": {"out": "total"}}]
+    })"));
+    // An output of another type
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "strict_types": true,
+        "memory": {"a": {"type": "dint"}, "b": {"type": "dint"}, "total": {"type": "int"}},
+        "logic": [{"block_type": "ADD", "inputs": ["a", "b"], "outputs": {"out": "total"}}]
+    })"));
+    TEST_ASSERT_FALSE(program.loadConfiguration(R"({
+        "strict_types": true,
+        "memory": {"a": {"type": "real"}, "b": {"type": "real"}, "over": {"type": "int"}},
+        "logic": [{"block_type": "GT", "inputs": {"in1": "a", "in2": "b"}, "outputs": {"out": "over"}}]
+    })"));
+
+    // The same programs load without it
+    TEST_ASSERT_TRUE(program.loadConfiguration(R"({
+        "memory": {"count": {"type": "int"}, "gain": {"type": "real"}},
+        "logic": [{"block_type": "MUL", "inputs": ["count", "gain"], "outputs": {"out": "scaled"}}]
+    })"));
+}
+
+void test_image_keeps_strict_types() {
+    const char* config = R"({"strict_types": true, "optimize": true, "logic": []})";
+    std::vector<uint8_t> data;
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(config, "main", data));
+    PlcProgramImage image;
+    TEST_ASSERT_TRUE(image.open(data.data(), data.size(), "main"));
+    TEST_ASSERT_TRUE(image.getStrictTypes());
+    TEST_ASSERT_TRUE(image.getOptimize());
+
+    TEST_ASSERT_TRUE(PlcProgramImage::compile(R"({"logic": []})", "main", data));
+    TEST_ASSERT_TRUE(image.open(data.data(), data.size(), "main"));
+    TEST_ASSERT_FALSE(image.getStrictTypes());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_int_operands_compute_in_int);
+    RUN_TEST(test_dint_operands_keep_every_bit);
+    RUN_TEST(test_mixed_operands_are_converted);
+    RUN_TEST(test_new_variables_are_real_unless_strict);
+    RUN_TEST(test_strict_types_reject_mismatched_operands);
+    RUN_TEST(test_image_keeps_strict_types);
+    return UNITY_END();
+}
@@ -0,0 +1,228 @@
+#include <unity.h>
+#include "Engine/PlcMemory.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+/**
+ * @brief Variable segment tests
+ *
+ * Variables are stored by type: BOOLs as bits, numbers in arrays of their
+ * C++ type and strings in a bounded pool. Values convert exactly as they
+ * did in the 64-byte union slots, and getMemoryUsage() matches the heap
+ * bytes PlcMemory really holds.
+ */
+
+// Live heap bytes allocated through operator new; each block carries its size
+static long liveBytes = 0;
+
+static void* allocate(size_t size) {
+    size_t* p = static_cast<size_t*>(malloc(sizeof(max_align_t) + size));
+    if (!p) {
+        return nullptr;
+    }
+    *p = size;
+    liveBytes += size;
+    return reinterpret_cast<char*>(p) + sizeof(max_align_t);
+}
+
+void* operator new(size_t size) {
+    void* p = allocate(size);
+    if (!p) {
+        abort();
+    }
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        size_t* block = reinterpret_cast<size_t*>(static_cast<char*>(p) - sizeof(max_align_t));
+        liveBytes -= *block;
+        free(block);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_values_convert_like_before() {
+    PlcMemory memory;
+    memory.declareVariable("b", PlcValueType::BOOL);
+    memory.declareVariable("u8", PlcValueType::BYTE);
+    memory.declareVariable("i", PlcValueType::INT);
+    memory.declareVariable("d", PlcValueType::DINT);
+    memory.declareVariable("r", PlcValueType::REAL);
+    memory.declareVariable("s", PlcValueType::STRING_TYPE);
+
+    memory.setValue<float>("b", 0.5f);
+    memory.setValue<int>("u8", 300);
+    memory.setValue<float>("i", -3.7f);
+    memory.setValue<int32_t>("d", -100000);
+    memory.setValue<int16_t>("r", 42);
+    memory.setValue<float>("s", 2.5f);
+
+    TEST_ASSERT_TRUE(memory.getValue<bool>("b"));
+    TEST_ASSERT_EQUAL_UINT8(44, memory.getValue<uint8_t>("u8"));
+    TEST_ASSERT_EQUAL_INT16(-3, memory.getValue<int16_t>("i"));
+    TEST_ASSERT_EQUAL_INT32(-100000, memory.getValue<int32_t>("d"));
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, memory.getValue<float>("r"));
+    TEST_ASSERT_EQUAL_STRING("2.5", memory.getValue<std::string>("s").c_str());
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, memory.getValue<float>("s"));
+    TEST_ASSERT_EQUAL_STRING("-100000", memory.getValue<std::string>("d").c_str());
+
+    // Strings are truncated to the pool entry
+    std::string longText(100, 'x');
+    memory.setValue<std::string>("s", longText);
+    TEST_ASSERT_EQUAL(PLC_STRING_SIZE - 1, memory.getValue<std::string>("s").size());
+
+    // A new type moves the variable to a zeroed entry of the other segment
+    memory.declareVariable("i", PlcValueType::REAL);
+    TEST_ASSERT_EQUAL(PlcValueType::REAL, memory.findHandle("i").type);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, memory.getValue<float>("i"));
+}
+
+void test_bools_are_bits() {
+    PlcMemory memory;
+    for (int i = 0; i < 100; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "x%d", i);
+        VarHandle handle = memory.resolve(name, PlcValueType::BOOL);
+        memory.setValue<bool>(handle, i % 3 == 0);
+    }
+    for (int i = 0; i < 100; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "x%d", i);
+        TEST_ASSERT_EQUAL(i % 3 == 0, memory.getValue<bool>(memory.findHandle(name)));
+    }
+
+    // Clearing one bit leaves its neighbours alone
+    memory.setValue<bool>("x33", false);
+    TEST_ASSERT_TRUE(memory.getValue<bool>("x30"));
+    TEST_ASSERT_FALSE(memory.getValue<bool>("x33"));
+    TEST_ASSERT_TRUE(memory.getValue<bool>("x36"));
+}
+
+void test_string_pool_is_bounded() {
+    PlcMemory memory;
+    memory.setStringPoolCapacity(4 * PLC_STRING_SIZE);
+    TEST_ASSERT_TRUE(memory.declareVariable("s0", PlcValueType::STRING_TYPE));
+    TEST_ASSERT_TRUE(memory.declareVariable("s1", PlcValueType::STRING_TYPE));
+    TEST_ASSERT_TRUE(memory.declareVariable("s2", PlcValueType::STRING_TYPE));
+    TEST_ASSERT_TRUE(memory.declareVariable("s3", PlcValueType::STRING_TYPE));
+    TEST_ASSERT_FALSE(memory.declareVariable("s4", PlcValueType::STRING_TYPE));
+    TEST_ASSERT_TRUE(memory.declareVariable("n", PlcValueType::INT)); // Other segments are not affected
+    TEST_ASSERT_EQUAL(4 * PLC_STRING_SIZE, memory.getStringPoolUsed());
+
+    memory.setValue<std::string>("s3", "last");
+    TEST_ASSERT_EQUAL_STRING("last", memory.getValue<std::string>("s3").c_str());
+    TEST_ASSERT_EQUAL_STRING("", memory.getValue<std::string>("s2").c_str());
+}
+
+void test_mesh_links_are_a_side_table() {
+    PlcMemory memory;
+    memory.declareVariable("local", PlcValueType::REAL);
+    memory.declareVariable("remote", PlcValueType::REAL, false, "node7.temp");
+    TEST_ASSERT_NULL(memory.getMeshLink(memory.findHandle("local")));
+    TEST_ASSERT_EQUAL_STRING("node7.temp", memory.getMeshLink(memory.findHandle("remote"))->c_str());
+
+    memory.declareVariable("remote", PlcValueType::REAL);
+    TEST_ASSERT_NULL(memory.getMeshLink(memory.findHandle("remote")));
+}
+
+void test_process_image_and_change_tracking_use_the_segments() {
+    PlcMemory memory;
+    memory.declareVariable("flag", PlcValueType::BOOL);
+    memory.declareVariable("level", PlcValueType::INT);
+    memory.declareVariable("name", PlcValueType::STRING_TYPE);
+    memory.buildProcessImage();
+    memory.setChangeTracking(true);
+
+    memory.postValue<bool>("flag", true);
+    memory.postValue<int16_t>("level", -5);
+    memory.postValue<std::string>("name", "pump");
+    memory.applyInputImage();
+    TEST_ASSERT_TRUE(memory.getValue<bool>("flag"));
+    TEST_ASSERT_EQUAL_INT16(-5, memory.getValue<int16_t>("level"));
+    TEST_ASSERT_EQUAL_STRING("pump", memory.getValue<std::string>("name").c_str());
+    TEST_ASSERT_EQUAL(3, memory.getChangedSlots().size());
+
+    memory.clearChangedSlots();
+    memory.setValue<int16_t>("level", -5); // Same value: no change
+    memory.setValue<bool>(memory.findHandle("flag"), false);
+    TEST_ASSERT_EQUAL(1, memory.getChangedSlots().size());
+
+    memory.publishOutputImage();
+    TEST_ASSERT_FALSE(memory.getImageValue<bool>("flag", true));
+    TEST_ASSERT_EQUAL_INT16(-5, memory.getImageValue<int16_t>("level"));
+    TEST_ASSERT_EQUAL_STRING("pump", memory.getImageValue<std::string>("name").c_str());
+
+    // Blocks are bound by now: the variables are fixed, declaring one with
+    // its own type only confirms it
+    size_t used = memory.getMemoryUsage();
+    TEST_ASSERT_FALSE(memory.declareVariable("level", PlcValueType::REAL));
+    TEST_ASSERT_FALSE(memory.declareVariable("flag", PlcValueType::INT));
+    TEST_ASSERT_EQUAL(PlcValueType::INT, memory.findHandle("level").type);
+    TEST_ASSERT_EQUAL_INT16(-5, memory.getValue<int16_t>("level"));
+    TEST_ASSERT_EQUAL(used, memory.getMemoryUsage());
+    TEST_ASSERT_TRUE(memory.declareVariable("level", PlcValueType::INT, true));
+    TEST_ASSERT_FALSE(memory.declareVariable("added", PlcValueType::INT));
+    TEST_ASSERT_EQUAL(used, memory.getMemoryUsage());
+}
+
+void test_memory_usage_is_exact() {
+    // 2000 variables, mostly BOOL and INT like a typical program
+    long before = liveBytes;
+    PlcMemory* memory = new PlcMemory();
+    for (int i = 0; i < 2000; i++) {
+        char name[40];
+        PlcValueType type = i % 4 == 0 ? PlcValueType::INT
+                          : i % 50 == 1 ? PlcValueType::REAL
+                          : i % 100 == 2 ? PlcValueType::STRING_TYPE
+                          : PlcValueType::BOOL;
+        // Some names are too long for the small string buffer
+        snprintf(name, sizeof(name), i % 10 ? "v%d" : "a_rather_long_variable_name_%d", i);
+        TEST_ASSERT_TRUE(memory->declareVariable(name, type, i % 7 == 0));
+    }
+    memory->buildProcessImage();
+
+    size_t held = liveBytes - before - sizeof(PlcMemory);
+    printf("2000 variables: %u bytes (%u per variable)\n", (unsigned)held, (unsigned)(held / 2000));
+    TEST_ASSERT_EQUAL(held, memory->getMemoryUsage());
+    TEST_ASSERT_TRUE(held / 2000 < 64); // Was over 200 bytes per variable with 64-byte union slots
+
+    delete memory;
+    TEST_ASSERT_EQUAL(before, liveBytes);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_values_convert_like_before);
+    RUN_TEST(test_bools_are_bits);
+    RUN_TEST(test_string_pool_is_bounded);
+    RUN_TEST(test_mesh_links_are_a_side_table);
+    RUN_TEST(test_process_image_and_change_tracking_use_the_segments);
+    RUN_TEST(test_memory_usage_is_exact);
+    UNITY_END();
+    return 0;
+}
@@ -2,7 +2,7 @@ import json
 import argparse
 import random
 
-def generate_benchmark_config(num_blocks, output_file):
+def generate_benchmark_config(num_blocks, output_file, optimize=False):
     """
     Generates a PLC configuration with a specified number of blocks.
     Creates a long chain of ADD blocks to simulate heavy logic.
@@ -10,10 +10,13 @@ def generate_benchmark_config(num_blocks, output_file):
     config = {
         "program": {
             "name": "Benchmark_Program",
-            "cycle_time": 100,
+            "cycle_time_ms": 100,
             "blocks": []
         }
     }
+    if optimize:
+        # The chain only reads constants, so the hub folds it away
+        config["program"]["optimize"] = True
 
     # Create a chain of ADD blocks
     # Result = 0 + 1 + 1 + 1 ...
@@ -53,6 +56,7 @@ if __name__ == "__main__":
     parser = argparse.ArgumentParser(description="Generate PLC Benchmark Configuration")
     parser.add_argument("--blocks", type=int, default=100, help="Number of blocks to generate")
     parser.add_argument("--output", type=str, default="benchmark_config.json", help="Output JSON file")
+    parser.add_argument("--optimize", action="store_true", help="Let the hub optimize the program when loading it")
     
     args = parser.parse_args()
-    generate_benchmark_config(args.blocks, args.output)
+    generate_benchmark_config(args.blocks, args.output, args.optimize)
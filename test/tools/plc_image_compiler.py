@@ -0,0 +1,232 @@
+import json
+import argparse
+import re
+import struct
+import zlib
+
+# Binary program image, see lib/PlcEngine/Engine/PlcProgramImage.h
+MAGIC = b"PLCI"
+VERSION = 1
+HEADER_SIZE = 56
+
+VALUE_TYPES = ["bool", "byte", "int", "dint", "real", "string"]
+ARRAY_TYPE = re.compile(r"^\s*array\s*\[\s*(\d+)\s*\]\s*of\s+(\w+)\s*$", re.IGNORECASE)
+ARRAY_ELEMENT_TYPES = ("bool", "int", "dint", "real")
+MAX_ARRAY_LENGTH = 256
+TYPE_BOOL = 0
+TYPE_REAL = 4
+FLAG_RETENTIVE = 0x01
+FLAG_OPTIMIZE = 0x01
+FLAG_STRICT_TYPES = 0x02
+TASK_HIGH_PRIORITY = 0x01
+MAX_TASKS = 8
+MAX_CYCLE_TIME_MS = 60000
+
+ENGINES = {"bytecode": 0, "blocks": 1}
+EXECUTIONS = {"cyclic": 0, "incremental": 1}
+OVERRUNS = {"skip": 0, "catch_up": 1}
+LANGUAGES = ("json", "st")
+MAX_SOURCE = 65535
+
+
+def msgpack(value):
+    """
+    Minimal MessagePack encoder for JSON values, as read by ArduinoJson's
+    deserializeMsgPack().
+    """
+    if value is None:
+        return b"\xc0"
+    if value is True:
+        return b"\xc3"
+    if value is False:
+        return b"\xc2"
+    if isinstance(value, int):
+        if 0 <= value < 0x80:
+            return struct.pack("B", value)
+        if -32 <= value < 0:
+            return struct.pack("b", value)
+        for fmt, code, lo, hi in (("B", 0xcc, 0, 0xFF), ("H", 0xcd, 0, 0xFFFF), ("I", 0xce, 0, 0xFFFFFFFF),
+                                  ("b", 0xd0, -0x80, 0x7F), ("h", 0xd1, -0x8000, 0x7FFF), ("i", 0xd2, -0x80000000, 0x7FFFFFFF)):
+            if lo <= value <= hi:
+                return bytes([code]) + struct.pack(">" + fmt, value)
+        return b"\xd3" + struct.pack(">q", value)
+    if isinstance(value, float):
+        if struct.unpack(">f", struct.pack(">f", value))[0] == value:
+            return b"\xca" + struct.pack(">f", value)
+        return b"\xcb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        data = value.encode("utf-8")
+        if len(data) < 32:
+            header = bytes([0xa0 | len(data)])
+        elif len(data) <= 0xFF:
+            header = b"\xd9" + struct.pack("B", len(data))
+        else:
+            header = b"\xda" + struct.pack(">H", len(data))
+        return header + data
+    if isinstance(value, list):
+        header = bytes([0x90 | len(value)]) if len(value) < 16 else b"\xdc" + struct.pack(">H", len(value))
+        return header + b"".join(msgpack(item) for item in value)
+    if isinstance(value, dict):
+        header = bytes([0x80 | len(value)]) if len(value) < 16 else b"\xde" + struct.pack(">H", len(value))
+        return header + b"".join(msgpack(k) + msgpack(v) for k, v in value.items())
+    raise ValueError(f"Cannot encode {value!r}")
+
+
+class StringTable:
+    def __init__(self):
+        self.data = bytearray(b"\0")
+        self.offsets = {}
+
+    def add(self, s):
+        if not s:
+            return 0
+        if s not in self.offsets:
+            self.offsets[s] = len(self.data)
+            self.data += s.encode("utf-8") + b"\0"
+            if len(self.data) > 0xFFFF:
+                raise ValueError("String table full")
+        return self.offsets[s]
+
+
+def compile_image(config):
+    """
+    Builds the same image as PlcProgramImage::compile() on the hub.
+    """
+    cycle_time_ms = config.get("cycle_time_ms", 10)
+    if not 1 <= cycle_time_ms <= MAX_CYCLE_TIME_MS:
+        raise ValueError(f"cycle_time_ms must be between 1 and {MAX_CYCLE_TIME_MS}, got {cycle_time_ms}")
+    try:
+        engine = ENGINES[config.get("engine", "bytecode")]
+        execution = EXECUTIONS[config.get("execution", "cyclic")]
+        overrun = OVERRUNS[config.get("overrun", "skip")]
+    except KeyError as e:
+        raise ValueError(f"Unknown setting {e}")
+    retentive_commit_s = config.get("retentive_commit_s", 0)
+    if not 0 <= retentive_commit_s <= 65535:
+        raise ValueError(f"retentive_commit_s must be at most 65535, got {retentive_commit_s}")
+    core = config.get("core", "any")
+    if core != "any" and not (isinstance(core, int) and 0 <= core <= 14):
+        raise ValueError(f"core must be \"any\" or between 0 and 14, got {core}")
+    partition = config.get("partition", 0)
+    if not 0 <= partition <= 15:
+        raise ValueError(f"partition must be between 0 and 15, got {partition}")
+    placement = (0 if core == "any" else core + 1) | (partition << 4)
+    header_flags = FLAG_OPTIMIZE if config.get("optimize", False) else 0
+    if config.get("strict_types", False):
+        header_flags |= FLAG_STRICT_TYPES
+
+    strings = StringTable()
+    variables = bytearray()
+    for name, attrs in config.get("memory", {}).items():
+        value_type, length = attrs.get("type"), 0
+        array = ARRAY_TYPE.match(value_type or "")
+        if array:
+            value_type, length = array.group(2).lower(), int(array.group(1))
+            if value_type not in ARRAY_ELEMENT_TYPES or not 1 <= length <= MAX_ARRAY_LENGTH:
+                raise ValueError(f"Array '{name}' must have 1 to {MAX_ARRAY_LENGTH} elements of bool, int, dint or real")
+            if attrs.get("mesh_link"):
+                raise ValueError(f"Array '{name}' cannot have a mesh_link")
+        if value_type not in VALUE_TYPES:
+            raise ValueError(f"Unknown variable type '{attrs.get('type')}' for variable '{name}'")
+        flags = FLAG_RETENTIVE if attrs.get("retentive", False) else 0
+        variables += struct.pack("<HHBBH", strings.add(name), strings.add(attrs.get("mesh_link", "")),
+                                 VALUE_TYPES.index(value_type), flags, length)
+
+    blocks = bytearray()
+    configs = bytearray()
+    for index, block in enumerate(config.get("logic", [])):
+        if "block_type" not in block:
+            raise ValueError(f"Block {index} has no block_type")
+        packed = msgpack({k: v for k, v in block.items() if k != "block_type"})
+        if len(packed) > 0xFFFF:
+            raise ValueError(f"Configuration of block {index} is too large")
+        blocks += struct.pack("<HHI", strings.add(block["block_type"]), len(packed), len(configs))
+        configs += packed
+
+    # Like ArduinoJson's is<float>(), every number is a REAL init value
+    inits = bytearray()
+    for action in config.get("init", []):
+        value = action.get("value")
+        if action.get("action") != "set_value" or "variable" not in action:
+            continue
+        if isinstance(value, bool):
+            value_type, bits = TYPE_BOOL, int(value)
+        elif isinstance(value, (int, float)):
+            value_type, bits = TYPE_REAL, struct.unpack("<I", struct.pack("<f", value))[0]
+        else:
+            continue
+        inits += struct.pack("<HBBI", strings.add(action["variable"]), value_type, 0, bits)
+
+    # Only the variable of an IO point is part of the program
+    io_points = bytearray()
+    for point in config.get("io_points", []):
+        if isinstance(point.get("plc_var"), str):
+            io_points += struct.pack("<H6x", strings.add(point["plc_var"]))
+
+    # Task classes; blocks refer to them by name in their "task" member
+    tasks = bytearray()
+    for name, attrs in config.get("tasks", {}).items():
+        task_cycle_ms = attrs.get("cycle_time_ms", 0)
+        if not 1 <= task_cycle_ms <= MAX_CYCLE_TIME_MS:
+            raise ValueError(f"cycle_time_ms of task '{name}' must be between 1 and {MAX_CYCLE_TIME_MS}")
+        priority = attrs.get("priority", "normal")
+        if priority not in ("normal", "high"):
+            raise ValueError(f"Unknown priority '{priority}' of task '{name}'")
+        if name == "default":
+            raise ValueError("Task name 'default' is used for the blocks without a task")
+        if len(tasks) // 8 == MAX_TASKS:
+            raise ValueError(f"More than {MAX_TASKS} tasks")
+        tasks += struct.pack("<HBxI", strings.add(name), TASK_HIGH_PRIORITY if priority == "high" else 0, task_cycle_ms)
+
+    # An ST program is one more block, added once the whole program was read
+    language = config.get("language", "json")
+    if language not in LANGUAGES:
+        raise ValueError(f"Unknown language '{language}'")
+    source = config.get("source")
+    if isinstance(source, list):
+        source = "".join(line + "\n" for line in source)
+    elif source is not None:
+        source += "\n"
+    if language == "json" and source:
+        raise ValueError("source needs \"language\": \"st\"")
+    if language == "st":
+        if not source:
+            raise ValueError("ST program without source")
+        if len(source) > MAX_SOURCE:
+            raise ValueError(f"source is longer than {MAX_SOURCE} bytes")
+        st_config = {"source": source}
+        if config.get("max_iterations", 0) > 0:
+            st_config["max_iterations"] = config["max_iterations"]
+        packed = msgpack(st_config)
+        if len(packed) > 0xFFFF:
+            raise ValueError(f"Configuration of block {len(blocks) // 8} is too large")
+        blocks += struct.pack("<HHI", strings.add("ST"), len(packed), len(configs))
+        configs += packed
+
+    strings_offset = HEADER_SIZE + len(variables) + len(blocks) + len(inits) + len(io_points) + len(tasks)
+    config_offset = strings_offset + len(strings.data)
+    image_size = config_offset + len(configs)
+    body = bytes(variables + blocks + inits + io_points + tasks + strings.data + configs)
+
+    header = MAGIC + struct.pack("<HHII", VERSION, HEADER_SIZE, image_size, zlib.crc32(body) & 0xFFFFFFFF)
+    header += struct.pack("<IIBBBBHHHHIIIIBBH", cycle_time_ms, config.get("watchdog_timeout_ms", 5000),
+                          engine, execution, overrun, placement,
+                          len(variables) // 8, len(blocks) // 8, len(inits) // 8, retentive_commit_s,
+                          strings_offset, len(strings.data), config_offset, len(configs),
+                          header_flags, len(tasks) // 8, len(io_points) // 8)
+    assert len(header) == HEADER_SIZE
+    return header + body
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Compile a PLC program JSON into a binary program image (.plci)")
+    parser.add_argument("input", help="PLC program JSON")
+    parser.add_argument("output", help="Program image to write")
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        image = compile_image(json.load(f))
+    with open(args.output, "wb") as f:
+        f.write(image)
+
+    print(f"Wrote {len(image)} byte program image to {args.output}")